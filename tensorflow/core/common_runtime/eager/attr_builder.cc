@@ -258,6 +258,8 @@ const NodeDef& AttrBuilder::BuildNodeDef() {
 void AttrBuilder::CopyAttributes(const AttrBuilder& other) {
   encoded_attrs_.insert(other.encoded_attrs_.begin(),
                         other.encoded_attrs_.end());
+  cached_attrs_key_ = std::nullopt;
+  cached_cache_key_ = std::nullopt;
 }
 
 Status AttrTypeByName(const AttrTypeMap& m, const string& attr_name,
@@ -299,20 +301,27 @@ inline tensorflow::Fprint128 CacheKeyHelper(StringPiece s, uint64 b) {
 tensorflow::Fprint128 AttrBuilder::CacheKey(const StringPiece device) {
   if (!cached_cache_key_ || device != device_for_cached_cache_key_) {
     cached_cache_key_ = BuildCacheKeyForDevice(device);
-    device_for_cached_cache_key_ = string(device);
+    // Reuses the buffer of the previous device name.
+    device_for_cached_cache_key_.assign(device.data(), device.size());
   }
 
   return *cached_cache_key_;
 }
 
 tensorflow::Fprint128 AttrBuilder::BuildCacheKeyForDevice(
-    const StringPiece device) const {
+    const StringPiece device) {
+  if (!cached_attrs_key_) {
+    tensorflow::Fprint128 attrs = {0, 0};
+    for (const auto& p : encoded_attrs_) {
+      CombineUnordered(
+          CacheKeyHelper(p.first, tensorflow::Fingerprint128(p.second)),
+          &attrs);
+    }
+    cached_attrs_key_ = attrs;
+  }
   tensorflow::Fprint128 f = tensorflow::Fingerprint128(op_name());
   f = tsl::FingerprintCat128(f, tensorflow::Fingerprint128(device));
-  for (const auto& p : encoded_attrs_) {
-    CombineUnordered(
-        CacheKeyHelper(p.first, tensorflow::Fingerprint128(p.second)), &f);
-  }
+  CombineUnordered(*cached_attrs_key_, &f);
   return f;
 }
 
@@ -107,6 +107,7 @@ class AttrBuilder : public AbstractOpAttrs {
     num_inputs_ = 0;
     encoded_attrs_.clear();
     node_def_finalized_ = false;
+    cached_attrs_key_ = std::nullopt;
     cached_cache_key_ = std::nullopt;
     device_for_cached_cache_key_.clear();
   }
@@ -122,6 +123,7 @@ class AttrBuilder : public AbstractOpAttrs {
     SetAttrValue(value, &attr_tmp_);
     AddAttrIfNotPresent(attr_name, attr_tmp_);
     node_def_finalized_ = false;
+    cached_attrs_key_ = std::nullopt;
     cached_cache_key_ = std::nullopt;
     return *this;
   }
@@ -130,6 +132,7 @@ class AttrBuilder : public AbstractOpAttrs {
 
   AttrBuilder& Set(StringPiece attr_name, const AttrValue& value) {
     AddAttrIfNotPresent(attr_name, value);
+    cached_attrs_key_ = std::nullopt;
     cached_cache_key_ = std::nullopt;
     return *this;
   }
@@ -183,7 +186,7 @@ class AttrBuilder : public AbstractOpAttrs {
       absl::InlinedVector<DataType, 4>* type_list) const override;
 
  private:
-  tensorflow::Fprint128 BuildCacheKeyForDevice(StringPiece device) const;
+  tensorflow::Fprint128 BuildCacheKeyForDevice(StringPiece device);
 
   template <class T>
   void SetInAttrValueMap(AttrValueMap* m, const string& attr_name,
@@ -205,6 +208,9 @@ class AttrBuilder : public AbstractOpAttrs {
   bool node_def_initialized_;
   bool node_def_finalized_;
 
+  // The fingerprint of the attributes, which does not depend on the device, so
+  // that placing the op only hashes the device name again.
+  std::optional<tensorflow::Fprint128> cached_attrs_key_;
   std::optional<tensorflow::Fprint128> cached_cache_key_;
   string device_for_cached_cache_key_;
 };
@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/context.h"
 
 #include <algorithm>
+#include <atomic>
 #include <functional>
 #include <memory>
 #include <thread>
@@ -472,15 +473,15 @@ void EagerContext::ClearCachesAndDefaultExecutor() {
     // during this time as well.
     mutex_lock ml(cache_mu_);
     default_executor_.WaitForAllPendingNodes().IgnoreError();
-    kernel_cache_.clear();
+    for (DispatchCacheShard& shard : dispatch_cache_) {
+      mutex_lock l(shard.mu);
+      shard.kernels.clear();
+      shard.devices.clear();
+    }
     for (auto& entry : registered_functions_) {
       entry.second->cached_kernel_keys->clear();
     }
   }
-  {
-    mutex_lock dl(device_cache_mu_);
-    device_cache_.clear();
-  }
   {
     mutex_lock ml(metadata_mu_);
     step_container_ = std::make_unique<ScopedStepContainer>(
@@ -575,6 +576,8 @@ void EagerContext::CloseRemoteContexts(
 #endif  // !IS_MOBILE_PLATFORM
 
 void EagerContext::WaitForAndCloseRemoteContexts() {
+  // The errors are reported by poisoning the handles.
+  FlushLazyTraces().IgnoreError();
   ClearCachesAndThreadExecutors();
 
 #if !defined(IS_MOBILE_PLATFORM)
@@ -615,6 +618,8 @@ void EagerContext::WaitForAndCloseRemoteContexts() {
 }
 
 EagerContext::~EagerContext() {
+  // Running the recorded ops would run functions on a context being destroyed.
+  DiscardLazyTraces();
   // TODO(iga): Add a separate API method to shutdown EagerContext so that we
   // don't send RPCs and block in destructor.
   WaitForAndCloseRemoteContexts();
@@ -740,6 +745,118 @@ void EagerContext::SetRunEagerOpAsFunction(bool enable) {
   run_eager_op_as_function_ = enable;
 }
 
+core::RefCountPtr<LazyTensorProducer> EagerContext::GetLazyTrace() {
+  tf_shared_lock l(lazy_trace_mu_);
+  auto iter = lazy_traces_.find(std::this_thread::get_id());
+  if (iter == lazy_traces_.end()) return nullptr;
+  iter->second->Ref();
+  return core::RefCountPtr<LazyTensorProducer>(iter->second.get());
+}
+
+void EagerContext::SetLazyTrace(LazyTensorProducer* trace) {
+  trace->Ref();
+  core::RefCountPtr<LazyTensorProducer> previous(trace);
+  mutex_lock l(lazy_trace_mu_);
+  lazy_traces_[std::this_thread::get_id()].swap(previous);
+}
+
+void EagerContext::RemoveLazyTrace(std::thread::id thread,
+                                   const LazyTensorProducer* trace) {
+  core::RefCountPtr<LazyTensorProducer> removed;
+  mutex_lock l(lazy_trace_mu_);
+  auto iter = lazy_traces_.find(thread);
+  if (iter != lazy_traces_.end() && iter->second.get() == trace) {
+    // Released after the lock, as it may be the last reference.
+    removed = std::move(iter->second);
+    lazy_traces_.erase(iter);
+  }
+}
+
+Status EagerContext::FlushLazyTraces() {
+  std::unordered_map<std::thread::id, core::RefCountPtr<LazyTensorProducer>>
+      traces;
+  {
+    mutex_lock l(lazy_trace_mu_);
+    traces.swap(lazy_traces_);
+  }
+  StatusGroup sg;
+  for (auto& entry : traces) {
+    sg.Update(entry.second->Flush());
+  }
+  return sg.as_summary_status();
+}
+
+void EagerContext::DiscardLazyTraces() {
+  std::unordered_map<std::thread::id, core::RefCountPtr<LazyTensorProducer>>
+      traces;
+  {
+    mutex_lock l(lazy_trace_mu_);
+    traces.swap(lazy_traces_);
+  }
+  for (auto& entry : traces) {
+    entry.second->Discard(
+        errors::Cancelled("The context of the lazy ops was destroyed"));
+  }
+}
+
+uint64 EagerContext::NewLazyTraceContextId() {
+  static std::atomic<uint64> next_id{0};
+  return next_id.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool EagerContext::RefLazyTraceFunction(const string& name) {
+  mutex_lock l(lazy_trace_functions_mu_);
+  auto iter = lazy_trace_functions_.find(name);
+  if (iter == lazy_trace_functions_.end()) return false;
+  ++iter->second.refs;
+  lazy_trace_lru_.splice(lazy_trace_lru_.end(), lazy_trace_lru_,
+                         iter->second.lru);
+  return true;
+}
+
+Status EagerContext::AddLazyTraceFunction(const FunctionDef& fdef) {
+  const string& name = fdef.signature().name();
+  mutex_lock l(lazy_trace_functions_mu_);
+  auto iter = lazy_trace_functions_.find(name);
+  if (iter == lazy_trace_functions_.end()) {
+    // Added once, so that a single RemoveFunction removes it.
+    TF_RETURN_IF_ERROR(AddFunctionDef(fdef));
+    iter = lazy_trace_functions_.emplace(name, LazyTraceFunction()).first;
+    iter->second.lru = lazy_trace_lru_.insert(lazy_trace_lru_.end(), name);
+  } else {
+    lazy_trace_lru_.splice(lazy_trace_lru_.end(), lazy_trace_lru_,
+                           iter->second.lru);
+  }
+  ++iter->second.refs;
+  EvictLazyTraceFunctions();
+  return absl::OkStatus();
+}
+
+void EagerContext::UnrefLazyTraceFunction(const string& name) {
+  mutex_lock l(lazy_trace_functions_mu_);
+  auto iter = lazy_trace_functions_.find(name);
+  DCHECK(iter != lazy_trace_functions_.end());
+  if (iter == lazy_trace_functions_.end()) return;
+  --iter->second.refs;
+  EvictLazyTraceFunctions();
+}
+
+void EagerContext::EvictLazyTraceFunctions() {
+  auto lru = lazy_trace_lru_.begin();
+  while (lazy_trace_functions_.size() > kMaxLazyTraceFunctions &&
+         lru != lazy_trace_lru_.end()) {
+    auto iter = lazy_trace_functions_.find(*lru);
+    if (iter->second.refs > 0) {
+      ++lru;
+      continue;
+    }
+    Status s = RemoveFunction(*lru);
+    if (!s.ok()) LOG(WARNING) << "Failed to remove " << *lru << ": " << s;
+    lazy_trace_functions_.erase(iter);
+    lru = lazy_trace_lru_.erase(lru);
+  }
+}
+
 bool EagerContext::JitCompileRewrite() const {
   VLOG(3) << "JitCompileRewrite: " << jit_compile_rewrite_;
   return jit_compile_rewrite_;
@@ -1101,15 +1218,17 @@ EagerContext::GetCacheStats() {
   CacheStats stats;
   {
     mutex_lock l(cache_mu_);
-    stats.kernel_cache_size = kernel_cache_.size();
     for (const auto& iter : registered_functions_) {
       stats.func_kernel_cache_entries[iter.first] =
           iter.second->cached_kernel_keys->size();
     }
   }
-  {
-    mutex_lock dl(device_cache_mu_);
-    stats.device_cache_size = device_cache_.size();
+  stats.kernel_cache_size = 0;
+  stats.device_cache_size = 0;
+  for (DispatchCacheShard& shard : dispatch_cache_) {
+    tf_shared_lock l(shard.mu);
+    stats.kernel_cache_size += shard.kernels.size();
+    stats.device_cache_size += shard.devices.size();
   }
   {
     stats.local_rendezvous_cache_active_size =
@@ -1132,7 +1251,9 @@ Status EagerContext::RemoveFunction(const string& func) {
     is_last_ref = registered_function->RefCountIsOne();
     if (is_last_ref) {
       for (auto& key : *registered_function->cached_kernel_keys) {
-        kernel_cache_.erase(key);
+        DispatchCacheShard& shard = DispatchCacheShardFor(key);
+        mutex_lock sl(shard.mu);
+        shard.kernels.erase(key);
       }
       registered_functions_.erase(func);
     }
@@ -1162,6 +1283,7 @@ Status EagerContext::RemoveFunction(const string& func) {
 Status EagerContext::SyncExecutors() {
   VLOG(6) << "Calling SyncExecutors";
   StatusGroup sg;
+  sg.Update(FlushLazyTraces());
   // Synchronize on context default executor
   sg.Update(default_executor_.WaitForAllPendingNodes());
   default_executor_.ClearError();
@@ -1215,9 +1337,10 @@ Status EagerContext::SyncExecutors() {
 
 core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
     Fprint128 cache_key) {
-  tf_shared_lock l(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter == kernel_cache_.end()) {
+  DispatchCacheShard& shard = DispatchCacheShardFor(cache_key);
+  tf_shared_lock l(shard.mu);
+  auto iter = shard.kernels.find(cache_key);
+  if (iter == shard.kernels.end()) {
     return nullptr;
   }
   core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
@@ -1226,24 +1349,29 @@ core::RefCountPtr<KernelAndDevice> EagerContext::GetCachedKernel(
 }
 
 Device* EagerContext::GetCachedDevice(Fprint128 device_cache_key) {
-  tf_shared_lock l(device_cache_mu_);
-  auto iter = device_cache_.find(device_cache_key);
-  if (iter == device_cache_.end()) return nullptr;
+  DispatchCacheShard& shard = DispatchCacheShardFor(device_cache_key);
+  tf_shared_lock l(shard.mu);
+  auto iter = shard.devices.find(device_cache_key);
+  if (iter == shard.devices.end()) return nullptr;
   return iter->second;
 }
 
 core::RefCountPtr<KernelAndDevice> EagerContext::AddKernelToCache(
     Fprint128 cache_key, core::RefCountPtr<KernelAndDevice> kernel) {
   mutex_lock ml(cache_mu_);
-  auto iter = kernel_cache_.find(cache_key);
-  if (iter != kernel_cache_.end()) {
-    core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
+  {
+    DispatchCacheShard& shard = DispatchCacheShardFor(cache_key);
+    mutex_lock l(shard.mu);
+    auto iter = shard.kernels.find(cache_key);
+    if (iter != shard.kernels.end()) {
+      core::RefCountPtr<KernelAndDevice> new_ref(iter->second.get());
+      new_ref->Ref();
+      return new_ref;
+    }
+    core::RefCountPtr<KernelAndDevice> new_ref(kernel.get());
     new_ref->Ref();
-    return new_ref;
+    shard.kernels[cache_key] = std::move(new_ref);
   }
-  core::RefCountPtr<KernelAndDevice> new_ref(kernel.get());
-  new_ref->Ref();
-  kernel_cache_[cache_key] = std::move(new_ref);
   auto* registered_function =
       gtl::FindPtrOrNull(registered_functions_, kernel->name());
 
@@ -1258,8 +1386,9 @@ core::RefCountPtr<KernelAndDevice> EagerContext::AddKernelToCache(
 
 void EagerContext::AddDeviceToCache(Fprint128 device_cache_key,
                                     Device* device) {
-  mutex_lock l(device_cache_mu_);
-  device_cache_[device_cache_key] = device;
+  DispatchCacheShard& shard = DispatchCacheShardFor(device_cache_key);
+  mutex_lock l(shard.mu);
+  shard.devices[device_cache_key] = device;
 }
 
 bool EagerContext::ShouldStoreGraphs() { return should_store_graphs_.load(); }
@@ -16,10 +16,12 @@ limitations under the License.
 #define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_CONTEXT_H_
 
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
+#include <list>
 #include <memory>
 #include <string>
 #include <unordered_map>
@@ -155,6 +157,38 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
 
   void SetJitCompileRewrite(bool enable) override;
 
+  // Lazy eager execution, off by default. When it is on, each thread records
+  // the stateless ops it runs synchronously on a CPU instead of running them,
+  // and runs them together as one function once one of their outputs is read.
+  // The ops run as functions by RunEagerOpAsFunction are not recorded.
+  bool LazyEagerExecution() const { return lazy_eager_execution_; }
+  void SetLazyEagerExecution(bool enable) { lazy_eager_execution_ = enable; }
+
+  // Returns the ops recorded by the calling thread, or null.
+  core::RefCountPtr<LazyTensorProducer> GetLazyTrace();
+  // Records the next ops of the calling thread in `trace`.
+  void SetLazyTrace(LazyTensorProducer* trace);
+  // Forgets `trace` if `thread` still records its ops in it.
+  void RemoveLazyTrace(std::thread::id thread, const LazyTensorProducer* trace);
+  // Runs the ops recorded by all the threads, and forgets their traces.
+  Status FlushLazyTraces();
+  // Identifies the context in the traces kept by its threads, which may
+  // outlive it. Unlike the address of the context, it is never reused.
+  uint64 LazyTraceContextId() const { return lazy_trace_context_id_; }
+
+  // The number of functions run by lazy traces kept once no trace runs them.
+  static constexpr int kMaxLazyTraceFunctions = 64;
+  // Takes a reference on the function `name` run by a lazy trace. Returns
+  // false if the function is missing.
+  bool RefLazyTraceFunction(const string& name);
+  // Adds `fdef`, run by a lazy trace, unless it exists, and takes a reference
+  // on it.
+  Status AddLazyTraceFunction(const FunctionDef& fdef);
+  // Releases a reference taken on the function `name` of a lazy trace. The
+  // least recently used functions without references are removed past
+  // kMaxLazyTraceFunctions.
+  void UnrefLazyTraceFunction(const string& name);
+
   void ListDevices(std::vector<DeviceAttributes>* device_attributes) override;
 
   Status AddDevices(std::vector<std::unique_ptr<Device>> devices) override;
@@ -766,23 +800,35 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   std::function<void(std::function<void()>)> runner_;
 
   mutex cache_mu_;
-  mutex device_cache_mu_;
   mutex remove_function_notifiers_mu_;
   struct RegisteredFunction : public core::RefCounted {
     ~RegisteredFunction() override = default;
 
     std::unique_ptr<std::vector<Fprint128>> cached_kernel_keys;
   };
-  std::unordered_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
-                     Fprint128Hasher>
-      kernel_cache_ TF_GUARDED_BY(cache_mu_);
+  // The kernels and devices cached for eager ops, which every op dispatch
+  // reads and only misses write. They are split in shards by key, each on its
+  // own cache line, so that threads dispatching different ops do not contend
+  // on a lock. Kernels are added and removed with cache_mu_ held first, which
+  // keeps the keys recorded in registered_functions_ in sync.
+  static constexpr int kNumDispatchCacheShards = 16;
+  struct alignas(64) DispatchCacheShard {
+    mutex mu;
+    absl::flat_hash_map<Fprint128, core::RefCountPtr<KernelAndDevice>,
+                        Fprint128Hasher>
+        kernels TF_GUARDED_BY(mu);
+    absl::flat_hash_map<Fprint128, Device*, Fprint128Hasher> devices
+        TF_GUARDED_BY(mu);
+  };
+  DispatchCacheShard& DispatchCacheShardFor(const Fprint128& key) {
+    return dispatch_cache_[key.low64 % kNumDispatchCacheShards];
+  }
+  std::array<DispatchCacheShard, kNumDispatchCacheShards> dispatch_cache_;
   std::unordered_map<string, RegisteredFunction*> registered_functions_
       TF_GUARDED_BY(cache_mu_);
 
   std::unordered_map<string, std::unique_ptr<FunctionLibraryDefinition>>
       component_function_libraries_ TF_GUARDED_BY(cache_mu_);
-  absl::flat_hash_map<Fprint128, Device*, Fprint128Hasher> device_cache_
-      TF_GUARDED_BY(device_cache_mu_);
   std::unordered_map<std::string, std::vector<std::function<void()>>>
       remove_function_notifiers_ TF_GUARDED_BY(remove_function_notifiers_mu_);
 
@@ -899,6 +945,27 @@ class EagerContext : public ImmediateExecutionContext, public core::RefCounted {
   std::function<void()> resource_deallocator_ = nullptr;
   bool run_eager_op_as_function_;
   bool jit_compile_rewrite_;
+  bool lazy_eager_execution_ = false;
+  mutex lazy_trace_mu_;
+  std::unordered_map<std::thread::id, core::RefCountPtr<LazyTensorProducer>>
+      lazy_traces_ TF_GUARDED_BY(lazy_trace_mu_);
+  // Poisons the outputs of the ops recorded by all the threads, without
+  // running them, and forgets their traces.
+  void DiscardLazyTraces();
+  static uint64 NewLazyTraceContextId();
+  const uint64 lazy_trace_context_id_ = NewLazyTraceContextId();
+  struct LazyTraceFunction {
+    // The number of traces running the function.
+    int refs = 0;
+    std::list<string>::iterator lru;
+  };
+  void EvictLazyTraceFunctions()
+      TF_EXCLUSIVE_LOCKS_REQUIRED(lazy_trace_functions_mu_);
+  mutex lazy_trace_functions_mu_;
+  // The functions of the lazy traces, least recently used first.
+  std::list<string> lazy_trace_lru_ TF_GUARDED_BY(lazy_trace_functions_mu_);
+  absl::flat_hash_map<string, LazyTraceFunction> lazy_trace_functions_
+      TF_GUARDED_BY(lazy_trace_functions_mu_);
 
   // Controls the behavior of
   // `EagerContext::RegisterFunction(AbstractFunction*)` in distributed
@@ -105,6 +105,18 @@ class AsyncRemoteExecuteNode : public AsyncEagerNode {
   virtual Status SyncExecutors() = 0;
 };
 
+// Produces the tensors of empty local handles when they are first waited for,
+// instead of having them computed by an EagerNode. Lazy eager execution (see
+// EagerContext::SetLazyEagerExecution) uses it to record ops until one of
+// their outputs is read.
+class LazyTensorProducer : public core::RefCounted {
+ public:
+  // Sets or poisons all the handles it produces. Returns the first error.
+  virtual Status Flush() = 0;
+  // Poisons all the handles it produces with `status`, without computing them.
+  virtual void Discard(const Status& status) = 0;
+};
+
 // A class for handling async execution (see TFE_ContextSetAsync).
 // Note that this class is thread-safe.
 // TODO(agarwal): TFE_OpAddInput may currently block if it tries to access the
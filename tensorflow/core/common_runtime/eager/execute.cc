@@ -31,6 +31,7 @@ limitations under the License.
 // clang-format off
 // Required for IS_MOBILE_PLATFORM
 #include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/strings/str_replace.h"
 #include "tensorflow/core/common_runtime/arg_ret_placement.h"
@@ -67,6 +68,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/eager/copy_to_device_node.h"
 #include "tensorflow/core/common_runtime/eager/execute_node.h"
 #include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/common_runtime/eager/lazy_trace.h"
 #include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/function.h"
@@ -1139,7 +1141,47 @@ absl::StatusOr<Fprint128> GetKernelCacheKey(
   return cache_key;
 }
 
-// Extracts function input info for `op` with `kernel_def`.
+// Host memory flags of the inputs of the ops run as functions, keyed by the
+// cache key of their attributes and device, which determine their kernel.
+// Finding them builds the NodeDef of the op and looks up its kernel, which
+// costs more than the rest of the dispatch of a cached kernel.
+class HostMemoryInputsCache {
+ public:
+  static HostMemoryInputsCache* Global() {
+    static HostMemoryInputsCache* const cache = new HostMemoryInputsCache;
+    return cache;
+  }
+
+  // Returns the flags of `key`, or nullptr. The flags are shared so that they
+  // outlive the entry if the cache starts over while the op runs.
+  std::shared_ptr<const std::vector<bool>> Lookup(const Fprint128& key) {
+    tf_shared_lock l(mu_);
+    auto it = flags_.find(key);
+    return it == flags_.end() ? nullptr : it->second;
+  }
+
+  void Insert(const Fprint128& key,
+              std::shared_ptr<const std::vector<bool>> flags) {
+    mutex_lock l(mu_);
+    // There is an entry per distinct op, attributes and device, of a bit per
+    // input, so kMaxEntries is only reached by programs generating attributes,
+    // e.g. shapes, without end. Like the caches of grappler, this one starts
+    // over then rather than tracking recency.
+    if (flags_.size() >= kMaxEntries) flags_.clear();
+    flags_.emplace(key, std::move(flags));
+  }
+
+ private:
+  static constexpr int kMaxEntries = 16384;
+
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::shared_ptr<const std::vector<bool>>,
+                      Fprint128Hasher>
+      flags_ TF_GUARDED_BY(mu_);
+};
+
+// Extracts function input info for `op`, given the `host_memory_inputs`
+// flags of its kernel, or nullptr for functions.
 // The following are extracted:
 //   `input_device_ptrs` - The input devices of `op`.
 //   `composite_devices` - Maps from a CompositeDevice name to a list of
@@ -1147,7 +1189,7 @@ absl::StatusOr<Fprint128> GetKernelCacheKey(
 //   `input_resource_variable_dtypes_shape` - A map from input index
 //     to dtype and shapes for resource inputs.
 Status ExtractFunctionInputInfo(
-    EagerOperation* op, const KernelDef* kernel_def,
+    EagerOperation* op, const std::vector<bool>* host_memory_inputs,
     std::vector<Device*>& input_device_ptrs,
     absl::flat_hash_map<string, const std::vector<string>*>& composite_devices,
     std::unordered_map<int, DtypeAndPartialTensorShape>&
@@ -1158,18 +1200,14 @@ Status ExtractFunctionInputInfo(
   input_device_ptrs.reserve(op->Inputs().size());
   const absl::InlinedVector<TensorHandle*, 4>* inputs;
   TF_RETURN_IF_ERROR(op->TensorHandleInputs(&inputs));
-  Device* op_device = nullptr;
-  const NodeDef* node_def = nullptr;
-  if (!op->is_function()) {
-    op_device = std::get<Device*>(op->Device());
-    node_def = &op->MutableAttrs()->BuildNodeDef();
-  }
   for (int i = 0, end = inputs->size(); i < end; ++i) {
     TensorHandle* input = (*inputs)[i];
 
     Device* input_device;
-    bool is_host_memory_arg =
-        IsHostMemoryArg(*op, node_def, op_device, kernel_def, i);
+    const bool is_host_memory_arg =
+        host_memory_inputs != nullptr &&
+        i < static_cast<int>(host_memory_inputs->size()) &&
+        (*host_memory_inputs)[i];
     TF_RETURN_IF_ERROR(
         GetDeviceForInput(*op, ctx, is_host_memory_arg, input, &input_device));
     VLOG(1) << op->Name() << ":input:" << i << " " << input_device->name();
@@ -1303,30 +1341,40 @@ Status GetOrCreateKernelAndDevice(
   absl::flat_hash_map<string, const std::vector<string>*> composite_devices;
   std::unordered_map<int, DtypeAndPartialTensorShape>
       input_resource_variable_dtypes_and_shapes;
-  const KernelDef* kernel_def = nullptr;
-  if (!op->is_function()) {
-    const NodeDef& node_def = op->MutableAttrs()->BuildNodeDef();
-    auto get_kernel_def = [](const EagerOperation& op, const NodeDef& node_def,
-                             const Device* op_device) -> const KernelDef* {
+  const Fprint128 attrs_cache_key =
+      op->MutableAttrs()->CacheKey(op->DeviceName());
+  // The kernel of an op run as a function places its host memory inputs. The
+  // kernel is only looked up, from the NodeDef, for the first op with the same
+  // attributes and device.
+  std::shared_ptr<const std::vector<bool>> host_memory_inputs;
+  if (!op->is_function() && ctx.RunEagerOpAsFunction()) {
+    host_memory_inputs =
+        HostMemoryInputsCache::Global()->Lookup(attrs_cache_key);
+    if (host_memory_inputs == nullptr) {
+      const NodeDef& node_def = op->MutableAttrs()->BuildNodeDef();
       const KernelDef* kernel_def = nullptr;
-      Status s = FindKernelDef(DeviceType(op_device->device_type()), node_def,
+      Status s = FindKernelDef(DeviceType(device->device_type()), node_def,
                                &kernel_def,
                                /*kernel_class_name=*/nullptr);
-      if (!s.ok()) return nullptr;
-      return kernel_def;
-    };
-    kernel_def = get_kernel_def(*op, node_def, device);
+      if (!s.ok()) kernel_def = nullptr;
+      auto flags = std::make_shared<std::vector<bool>>(op->Inputs().size());
+      for (int i = 0, end = op->Inputs().size(); i < end; ++i) {
+        (*flags)[i] = IsHostMemoryArg(*op, &node_def, device, kernel_def, i);
+      }
+      host_memory_inputs = flags;
+      HostMemoryInputsCache::Global()->Insert(attrs_cache_key,
+                                              std::move(flags));
+    }
   }
   if (op->is_function() || ctx.RunEagerOpAsFunction()) {
     TF_RETURN_IF_ERROR(ExtractFunctionInputInfo(
-        op, kernel_def, input_device_ptrs, composite_devices,
+        op, host_memory_inputs.get(), input_device_ptrs, composite_devices,
         input_resource_variable_dtypes_and_shapes));
   }
 
   TF_ASSIGN_OR_RETURN(
       Fprint128 cache_key,
-      GetKernelCacheKey(*op, op->MutableAttrs()->CacheKey(op->DeviceName()),
-                        input_device_ptrs,
+      GetKernelCacheKey(*op, attrs_cache_key, input_device_ptrs,
                         input_resource_variable_dtypes_and_shapes,
                         reuse_rendezvous_for_functions));
   core::RefCountPtr<KernelAndDevice> kernel = ctx.GetCachedKernel(cache_key);
@@ -1632,6 +1680,16 @@ Status AddOrExecuteNode(core::RefCountPtr<KernelAndDevice> kernel,
         op_id, /* is_component_function= */ false, /* step_id= */ std::nullopt};
 #endif  // !IS_MOBILE_PLATFORM
   }
+  if (ctx.LazyEagerExecution()) {
+    // The op is run later with the other ops recorded by the thread, or now
+    // after them.
+    bool recorded = false;
+    TF_RETURN_IF_ERROR(RecordOrFlushLazyOp(op, *kernel, retvals, &recorded));
+    if (recorded) {
+      op->Clear();
+      return absl::OkStatus();
+    }
+  }
   if (executor.Async()) {
     const DataTypeVector& output_dtypes = kernel->output_dtypes();
     for (int i = 0, end = num_outputs; i < end; ++i) {
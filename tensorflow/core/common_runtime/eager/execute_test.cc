@@ -18,11 +18,16 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/strings/match.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
 #include "tensorflow/core/framework/full_type.pb.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/lib/monitoring/cell_reader.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/threadpool.h"
 
 namespace tensorflow {
 namespace {
@@ -428,5 +433,315 @@ TEST(ExecuteTest, MultipleNestedCompiledFunction) {
   ctx->Unref();
 }
 
+// Runs `Mul(x, x)` for a scalar `x` with `op`, as the Python bindings do.
+Status ExecuteMul(EagerOperation* op, ImmediateExecutionTensorHandle* x) {
+  TF_RETURN_IF_ERROR(op->Reset(/*op=*/"Mul", /*raw_device_name=*/nullptr));
+  TF_RETURN_IF_ERROR(op->AddInput(x));
+  TF_RETURN_IF_ERROR(op->AddInput(x));
+  TensorHandle* retval = nullptr;
+  int num_retvals = 1;
+  Status s = EagerExecute(op, &retval, &num_retvals);
+  if (retval != nullptr) retval->Unref();
+  op->Clear();
+  return s;
+}
+
+TEST(ExecuteTest, ConcurrentOpsShareCachedKernels) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+
+  Tensor float_tensor = test::AsScalar<float>(3.0f);
+  auto float_input = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(float_tensor,
+                                         ctx->HostCPUName().c_str()));
+  Tensor int_tensor = test::AsScalar<int64_t>(3);
+  auto int_input = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(int_tensor,
+                                         ctx->HostCPUName().c_str()));
+  {
+    thread::ThreadPool pool(Env::Default(), "dispatch", 8);
+    for (int i = 0; i < 8; ++i) {
+      pool.Schedule([&, i]() {
+        auto op = std::make_unique<EagerOperation>(ctx);
+        for (int j = 0; j < 100; ++j) {
+          TF_EXPECT_OK(ExecuteMul(
+              op.get(), i % 2 == 0 ? float_input.get() : int_input.get()));
+        }
+      });
+    }
+  }
+  // One kernel and one device per dtype of Mul.
+  const auto stats = ctx->GetCacheStats();
+  EXPECT_EQ(stats.kernel_cache_size, 2);
+  EXPECT_EQ(stats.device_cache_size, 2);
+
+  ctx->ClearCachesAndDefaultExecutor();
+  EXPECT_EQ(ctx->GetCacheStats().kernel_cache_size, 0);
+  EXPECT_EQ(ctx->GetCacheStats().device_cache_size, 0);
+  ctx->Unref();
+}
+
+// Runs `num_ops` ops alternating Mul and AddV2, each reading the output of the
+// previous one and `x`, and sets `output` to the output of the last one.
+Status ExecuteChain(EagerContext* ctx, TensorHandle* x, int num_ops,
+                    TensorHandle** output) {
+  auto op = std::make_unique<EagerOperation>(ctx);
+  x->Ref();
+  TensorHandle* y = x;
+  for (int i = 0; i < num_ops; ++i) {
+    TF_RETURN_IF_ERROR(op->Reset(/*op=*/i % 2 == 0 ? "Mul" : "AddV2",
+                                 /*raw_device_name=*/nullptr));
+    TF_RETURN_IF_ERROR(op->AddInput(y));
+    TF_RETURN_IF_ERROR(op->AddInput(x));
+    TensorHandle* next = nullptr;
+    int num_retvals = 1;
+    Status s = EagerExecute(op.get(), &next, &num_retvals);
+    op->Clear();
+    y->Unref();
+    TF_RETURN_IF_ERROR(s);
+    y = next;
+  }
+  *output = y;
+  return absl::OkStatus();
+}
+
+std::vector<string> LazyTraceFunctions(EagerContext* ctx) {
+  std::vector<string> names;
+  for (const string& name : ctx->ListFunctionNames()) {
+    if (absl::StartsWith(name, "__lazy_trace_")) names.push_back(name);
+  }
+  return names;
+}
+
+TEST(ExecuteTest, LazyOpsRunAsCachedFunction) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  ctx->SetLazyEagerExecution(true);
+
+  Tensor x_tensor = test::AsTensor<float>({0.5f, 1.0f, 1.5f, -2.0f});
+  core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+      Tensor(x_tensor), ctx->HostCPU(), ctx->HostCPU(), ctx));
+  Tensor expected(DT_FLOAT, x_tensor.shape());
+  for (int i = 0; i < x_tensor.NumElements(); ++i) {
+    const float x_value = x_tensor.flat<float>()(i);
+    float y_value = x_value;
+    for (int j = 0; j < 4; ++j) y_value = y_value * x_value + x_value;
+    expected.flat<float>()(i) = y_value;
+  }
+
+  // The second run reuses the function of the first.
+  for (int run = 0; run < 2; ++run) {
+    TensorHandle* y = nullptr;
+    TF_ASSERT_OK(ExecuteChain(ctx, x.get(), /*num_ops=*/8, &y));
+    const Tensor* y_tensor = nullptr;
+    TF_ASSERT_OK(y->Tensor(&y_tensor));
+    test::ExpectClose(expected, *y_tensor);
+    y->Unref();
+  }
+  const std::vector<string> functions = LazyTraceFunctions(ctx);
+  ASSERT_EQ(functions.size(), 1);
+  // The function reads `x` once, and returns only the last output.
+  const FunctionDef* fdef = ctx->FindFunctionDef(functions[0]);
+  ASSERT_NE(fdef, nullptr);
+  EXPECT_EQ(fdef->signature().input_arg_size(), 1);
+  EXPECT_EQ(fdef->signature().output_arg_size(), 1);
+  EXPECT_EQ(fdef->node_def_size(), 8);
+
+  ctx->Unref();
+}
+
+TEST(ExecuteTest, LazyOpsRunWhenTraceIsFull) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  ctx->SetLazyEagerExecution(true);
+
+  core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+      test::AsScalar<float>(1.0f), ctx->HostCPU(), ctx->HostCPU(), ctx));
+  TensorHandle* y = nullptr;
+  TF_ASSERT_OK(ExecuteChain(ctx, x.get(), /*num_ops=*/300, &y));
+  // The first 256 ops have run, and the others run on SyncExecutors.
+  EXPECT_EQ(LazyTraceFunctions(ctx).size(), 1);
+  TF_ASSERT_OK(ctx->SyncExecutors());
+  EXPECT_EQ(LazyTraceFunctions(ctx).size(), 2);
+  const Tensor* y_tensor = nullptr;
+  TF_ASSERT_OK(y->Tensor(&y_tensor));
+  test::ExpectTensorEqual<float>(*y_tensor, test::AsScalar<float>(151.0f));
+  y->Unref();
+
+  ctx->Unref();
+}
+
+TEST(ExecuteTest, LazyTraceFunctionsAreEvicted) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  ctx->SetLazyEagerExecution(true);
+
+  core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+      test::AsScalar<float>(1.0f), ctx->HostCPU(), ctx->HostCPU(), ctx));
+  // Every chain length runs its own function.
+  const int num_chains = EagerContext::kMaxLazyTraceFunctions + 8;
+  for (int num_ops = 1; num_ops <= num_chains; ++num_ops) {
+    TensorHandle* y = nullptr;
+    TF_ASSERT_OK(ExecuteChain(ctx, x.get(), num_ops, &y));
+    const Tensor* y_tensor = nullptr;
+    TF_ASSERT_OK(y->Tensor(&y_tensor));
+    test::ExpectTensorEqual<float>(
+        *y_tensor, test::AsScalar<float>(1.0f + num_ops / 2));
+    y->Unref();
+  }
+  EXPECT_EQ(LazyTraceFunctions(ctx).size(),
+            EagerContext::kMaxLazyTraceFunctions);
+
+  ctx->Unref();
+}
+
+TEST(ExecuteTest, LazyOpsRunWhenThreadExits) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  ctx->SetLazyEagerExecution(true);
+
+  core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+      test::AsScalar<float>(1.0f), ctx->HostCPU(), ctx->HostCPU(), ctx));
+  TensorHandle* y = nullptr;
+  {
+    std::unique_ptr<Thread> thread(
+        Env::Default()->StartThread(ThreadOptions(), "record", [&]() {
+          TF_EXPECT_OK(ExecuteChain(ctx, x.get(), /*num_ops=*/4, &y));
+        }));
+  }
+  // The ops have run before `y` is read.
+  EXPECT_EQ(LazyTraceFunctions(ctx).size(), 1);
+  ASSERT_NE(y, nullptr);
+  const Tensor* y_tensor = nullptr;
+  TF_ASSERT_OK(y->Tensor(&y_tensor));
+  test::ExpectTensorEqual<float>(*y_tensor, test::AsScalar<float>(3.0f));
+  y->Unref();
+
+  ctx->Unref();
+}
+
+TEST(ExecuteTest, LazyOpsAreDiscardedWithTheContext) {
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      &device_mgr, false, nullptr, nullptr);
+  ctx->SetLazyEagerExecution(true);
+
+  TensorHandle* y = nullptr;
+  {
+    core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+        test::AsScalar<float>(1.0f), ctx->HostCPU(), ctx->HostCPU(), ctx));
+    TF_ASSERT_OK(ExecuteChain(ctx, x.get(), /*num_ops=*/4, &y));
+  }
+  // The ops recorded when the context is destroyed do not run.
+  ctx->Unref();
+  ASSERT_NE(y, nullptr);
+  const Tensor* y_tensor = nullptr;
+  const Status status = y->Tensor(&y_tensor);
+  EXPECT_TRUE(errors::IsCancelled(status)) << "Actual status: " << status;
+  y->Unref();
+}
+
+EagerContext* NewDispatchBenchmarkContext(bool run_eager_op_as_function) {
+  auto* device_mgr = new StaticDeviceMgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto* ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT, false,
+      device_mgr, false, nullptr, nullptr);
+  ctx->SetRunEagerOpAsFunction(run_eager_op_as_function);
+  return ctx;
+}
+
+EagerContext* DispatchBenchmarkContext(bool run_eager_op_as_function) {
+  static EagerContext* ctx = NewDispatchBenchmarkContext(false);
+  static EagerContext* op_as_function_ctx = NewDispatchBenchmarkContext(true);
+  return run_eager_op_as_function ? op_as_function_ctx : ctx;
+}
+
+// Dispatches small ops with a cached kernel from each benchmark thread, all
+// sharing a context. The argument is the run_eager_op_as_function setting.
+void BM_EagerOpDispatch(::testing::benchmark::State& state) {
+  EagerContext* ctx = DispatchBenchmarkContext(state.range(0) != 0);
+  Tensor tensor = test::AsScalar<float>(1.0f);
+  auto input = core::RefCountPtr<ImmediateExecutionTensorHandle>(
+      ctx->CreateLocalHandleFromTFTensor(tensor, ctx->HostCPUName().c_str()));
+  auto op = std::make_unique<EagerOperation>(ctx);
+  // Warms up the caches.
+  TF_CHECK_OK(ExecuteMul(op.get(), input.get()));
+  for (auto s : state) {
+    TF_CHECK_OK(ExecuteMul(op.get(), input.get()));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_EagerOpDispatch)
+    ->UseRealTime()
+    ->Arg(0)
+    ->Arg(1)
+    ->Threads(1)
+    ->Threads(2)
+    ->Threads(4)
+    ->Threads(8)
+    ->Threads(16)
+    ->Threads(32);
+
+// Runs chains of small ops, reading the output of each, with synchronous,
+// asynchronous or lazy eager execution.
+void BM_EagerOpChain(::testing::benchmark::State& state) {
+  enum Mode { kSync = 0, kAsync = 1, kLazy = 2 };
+  const Mode mode = static_cast<Mode>(state.range(0));
+  const int num_ops = state.range(1);
+  StaticDeviceMgr device_mgr(
+      DeviceFactory::NewDevice("CPU", {}, "/job:localhost/replica:0/task:0"));
+  auto ctx = new EagerContext(
+      SessionOptions(),
+      tensorflow::ContextDevicePlacementPolicy::DEVICE_PLACEMENT_SILENT,
+      /*async=*/mode == kAsync, &device_mgr, false, nullptr, nullptr);
+  ctx->SetRunEagerOpAsFunction(false);
+  ctx->SetLazyEagerExecution(mode == kLazy);
+  core::RefCountPtr<TensorHandle> x(TensorHandle::CreateLocalHandle(
+      test::AsTensor<float>(std::vector<float>(16, 1.0f)), ctx->HostCPU(),
+      ctx->HostCPU(), ctx));
+  for (auto s : state) {
+    TensorHandle* y = nullptr;
+    TF_CHECK_OK(ExecuteChain(ctx, x.get(), num_ops, &y));
+    const Tensor* y_tensor = nullptr;
+    TF_CHECK_OK(y->Tensor(&y_tensor));
+    y->Unref();
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * num_ops);
+  ctx->Unref();
+}
+BENCHMARK(BM_EagerOpChain)
+    ->ArgPair(0, 8)
+    ->ArgPair(1, 8)
+    ->ArgPair(2, 8)
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 64)
+    ->ArgPair(2, 64)
+    ->UseRealTime();
+
 }  // namespace
 }  // namespace tensorflow
@@ -0,0 +1,340 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/common_runtime/eager/lazy_trace.h"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/fixed_array.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/common_runtime/eager/execute.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/graph_to_functiondef.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
+#include "tensorflow/core/platform/casts.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+
+namespace {
+
+bool IsRecordedType(DataType dtype) {
+  return dtype != DT_RESOURCE && dtype != DT_VARIANT && !IsRefType(dtype);
+}
+
+// The last trace of the thread in each context, run when the thread exits.
+// A destroyed context has discarded its traces, so running them again does not
+// use it. The traces are keyed by the id of their context rather than its
+// address, which a new context may reuse.
+class ThreadLazyTraces {
+ public:
+  ~ThreadLazyTraces() {
+    for (auto& entry : traces_) {
+      // The errors are reported by poisoning the handles.
+      entry.second->Flush().IgnoreError();
+    }
+  }
+
+  void Set(const EagerContext& ctx, LazyTrace* trace) {
+    trace->Ref();
+    traces_[ctx.LazyTraceContextId()] = core::RefCountPtr<LazyTrace>(trace);
+  }
+
+ private:
+  absl::flat_hash_map<uint64, core::RefCountPtr<LazyTrace>> traces_;
+};
+
+thread_local ThreadLazyTraces thread_lazy_traces;
+
+}  // namespace
+
+LazyTrace::~LazyTrace() {
+  // The trace is only released unrun if it recorded nothing.
+  for (RecordedOp& op : ops_) {
+    for (TensorHandle* output : op.outputs) output->Unref();
+  }
+  for (TensorHandle* arg : args_) arg->Unref();
+}
+
+bool LazyTrace::CanRecord(EagerOperation& op, const KernelAndDevice& kernel) {
+  if (op.is_function() || op.eager_func_params().has_value() ||
+      op.GetCancellationManager() != nullptr || op.Executor().Async()) {
+    return false;
+  }
+  const OpDef* op_def = op.OpDef();
+  if (op_def == nullptr || op_def->is_stateful()) return false;
+
+  EagerContext& ctx = op.EagerContext();
+  VariantDevice op_device = op.Device();
+  Device* const* device = std::get_if<Device*>(&op_device);
+  if (device == nullptr || *device != ctx.HostCPU()) return false;
+  for (DataType dtype : kernel.output_dtypes()) {
+    if (!IsRecordedType(dtype)) return false;
+  }
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  if (!op.TensorHandleInputs(&inputs).ok()) return false;
+  for (const TensorHandle* input : *inputs) {
+    if (input->Type() != TensorHandle::LOCAL ||
+        input->DeviceOrHostCPU(ctx) != ctx.HostCPU() ||
+        !IsRecordedType(input->dtype)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool LazyTrace::Record(EagerOperation* op, const KernelAndDevice& kernel,
+                       TensorHandle** retvals) {
+  const absl::InlinedVector<TensorHandle*, 4>* inputs;
+  if (!op->TensorHandleInputs(&inputs).ok()) return false;
+  Device* device = ctx_.HostCPU();
+
+  // The other inputs are waited for without the lock, as waiting for the
+  // output of another trace runs it.
+  absl::InlinedVector<TensorHandle*, 4> args;
+  {
+    mutex_lock l(mu_);
+    if (flushed_ || ops_.size() >= kMaxOps) return false;
+    for (TensorHandle* input : *inputs) {
+      if (!sources_.contains(input)) args.push_back(input);
+    }
+  }
+  for (TensorHandle* arg : args) {
+    const Tensor* tensor = nullptr;
+    if (!arg->Tensor(&tensor).ok()) return false;
+  }
+
+  mutex_lock l(mu_);
+  // Another thread may have run the trace in the meantime.
+  if (flushed_ || ops_.size() >= kMaxOps) return false;
+
+  RecordedOp recorded;
+  recorded.node_def = op->MutableAttrs()->BuildNodeDef();
+  recorded.node_def.clear_input();
+  recorded.node_def.set_name(absl::StrCat(op->Name(), "_", ops_.size()));
+  recorded.node_def.set_device(device->name());
+  recorded.key = op->MutableAttrs()->CacheKey(device->name());
+  for (TensorHandle* input : *inputs) {
+    auto source = sources_.find(input);
+    if (source == sources_.end()) {
+      source = sources_.emplace(input, Source(-1, args_.size())).first;
+      input->Ref();
+      args_.push_back(input);
+    }
+    recorded.inputs.push_back(source->second);
+  }
+  const DataTypeVector& output_dtypes = kernel.output_dtypes();
+  for (int i = 0; i < output_dtypes.size(); ++i) {
+    TensorHandle* output = TensorHandle::CreateEmptyLocalHandle(
+        /*d=*/device, /*op_device=*/device, /*resource_device=*/nullptr,
+        output_dtypes[i], &ctx_);
+    output->SetLazyProducer(this);
+    // One reference for the trace, one for the caller.
+    output->Ref();
+    recorded.outputs.push_back(output);
+    sources_.emplace(output, Source(ops_.size(), i));
+    retvals[i] = output;
+  }
+  ops_.push_back(std::move(recorded));
+  return true;
+}
+
+bool LazyTrace::Take(std::vector<RecordedOp>* ops,
+                     std::vector<TensorHandle*>* args) {
+  mutex_lock l(mu_);
+  // Another thread running or discarding the trace makes the outputs ready.
+  if (flushed_) return false;
+  flushed_ = true;
+  ops->swap(ops_);
+  args->swap(args_);
+  sources_.clear();
+  return true;
+}
+
+Status LazyTrace::Flush() {
+  std::vector<RecordedOp> ops;
+  std::vector<TensorHandle*> args;
+  if (!Take(&ops, &args)) return absl::OkStatus();
+  ctx_.RemoveLazyTrace(thread_, this);
+
+  Status s = Run(ops, args);
+  // The outputs left empty are not referenced anymore.
+  for (RecordedOp& op : ops) {
+    for (TensorHandle* output : op.outputs) output->Unref();
+  }
+  for (TensorHandle* arg : args) arg->Unref();
+  return s;
+}
+
+void LazyTrace::Discard(const Status& status) {
+  std::vector<RecordedOp> ops;
+  std::vector<TensorHandle*> args;
+  if (!Take(&ops, &args)) return;
+  for (RecordedOp& op : ops) {
+    for (TensorHandle* output : op.outputs) {
+      output->Poison(status, output->device());
+      output->Unref();
+    }
+  }
+  for (TensorHandle* arg : args) arg->Unref();
+}
+
+Status LazyTrace::Run(const std::vector<RecordedOp>& ops,
+                      const std::vector<TensorHandle*>& args) {
+  std::vector<Source> result_sources;
+  std::vector<TensorHandle*> results;
+  for (int i = 0; i < ops.size(); ++i) {
+    for (int j = 0; j < ops[i].outputs.size(); ++j) {
+      if (!ops[i].outputs[j]->RefCountIsOne()) {
+        result_sources.emplace_back(i, j);
+        results.push_back(ops[i].outputs[j]);
+      }
+    }
+  }
+  // The ops are stateless, so there is nothing to run if nothing can read the
+  // results.
+  if (results.empty()) return absl::OkStatus();
+
+  absl::FixedArray<TensorHandle*> retvals(results.size(), nullptr);
+  Status s = Call(ops, args, result_sources, absl::MakeSpan(retvals));
+  for (int i = 0; i < results.size(); ++i) {
+    Status result = s;
+    const Tensor* tensor = nullptr;
+    if (result.ok()) result = retvals[i]->Tensor(&tensor);
+    if (result.ok()) {
+      result = results[i]->SetTensor(Tensor(*tensor), results[i]->device());
+    } else {
+      results[i]->Poison(result, results[i]->device());
+    }
+    s.Update(result);
+    if (retvals[i] != nullptr) retvals[i]->Unref();
+  }
+  return s;
+}
+
+Status LazyTrace::Call(const std::vector<RecordedOp>& ops,
+                       const std::vector<TensorHandle*>& args,
+                       const std::vector<Source>& result_sources,
+                       absl::Span<TensorHandle*> retvals) {
+  Fprint128 key = Fingerprint128("LazyTrace");
+  for (const TensorHandle* arg : args) {
+    key = FingerprintCat128(key, arg->dtype);
+  }
+  for (const RecordedOp& op : ops) {
+    key = FingerprintCat128(key, op.key);
+    for (const Source& input : op.inputs) {
+      key = FingerprintCat128(key, input.first);
+      key = FingerprintCat128(key, input.second);
+    }
+  }
+  for (const Source& result : result_sources) {
+    key = FingerprintCat128(key, result.first);
+    key = FingerprintCat128(key, result.second);
+  }
+  const string name =
+      absl::StrCat("__lazy_trace_", absl::Hex(key.high64, absl::kZeroPad16),
+                   absl::Hex(key.low64, absl::kZeroPad16));
+
+  // The reference keeps the context from removing the function until it has
+  // run.
+  if (!ctx_.RefLazyTraceFunction(name)) {
+    VLOG(1) << "Creating " << name << " for " << ops.size() << " ops";
+    Graph graph(OpRegistry::Global());
+    std::vector<Node*> arg_nodes;
+    for (int i = 0; i < args.size(); ++i) {
+      NodeDef arg;
+      arg.set_name(absl::StrCat("arg_", i));
+      arg.set_op(FunctionLibraryDefinition::kArgOp);
+      AddNodeAttr("T", args[i]->dtype, &arg);
+      AddNodeAttr("index", i, &arg);
+      TF_ASSIGN_OR_RETURN(Node * node, graph.AddNode(std::move(arg)));
+      arg_nodes.push_back(node);
+    }
+    std::vector<Node*> op_nodes;
+    for (const RecordedOp& op : ops) {
+      TF_ASSIGN_OR_RETURN(Node * node, graph.AddNode(op.node_def));
+      for (int i = 0; i < op.inputs.size(); ++i) {
+        const Source& input = op.inputs[i];
+        if (input.first < 0) {
+          graph.AddEdge(arg_nodes[input.second], 0, node, i);
+        } else {
+          graph.AddEdge(op_nodes[input.first], input.second, node, i);
+        }
+      }
+      op_nodes.push_back(node);
+    }
+    for (int i = 0; i < result_sources.size(); ++i) {
+      Node* src = op_nodes[result_sources[i].first];
+      const int output = result_sources[i].second;
+      NodeDef result;
+      result.set_name(absl::StrCat("result_", i));
+      result.set_op(FunctionLibraryDefinition::kRetOp);
+      AddNodeAttr("T", src->output_type(output), &result);
+      AddNodeAttr("index", i, &result);
+      TF_ASSIGN_OR_RETURN(Node * node, graph.AddNode(std::move(result)));
+      graph.AddEdge(src, output, node, 0);
+    }
+    FunctionDef fdef;
+    TF_RETURN_IF_ERROR(GraphToFunctionDef(graph, name, &fdef));
+    TF_RETURN_IF_ERROR(ctx_.AddLazyTraceFunction(fdef));
+  }
+  auto unref_function =
+      gtl::MakeCleanup([this, &name] { ctx_.UnrefLazyTraceFunction(name); });
+
+  EagerOperation call(&ctx_);
+  TF_RETURN_IF_ERROR(call.Reset(name.c_str(), /*raw_device_name=*/nullptr));
+  for (TensorHandle* arg : args) {
+    TF_RETURN_IF_ERROR(call.AddInput(arg));
+  }
+  int num_retvals = retvals.size();
+  TF_RETURN_IF_ERROR(EagerExecute(&call, retvals.data(), &num_retvals));
+  if (num_retvals != static_cast<int>(retvals.size())) {
+    return errors::Internal(name, " returned ", num_retvals,
+                            " results instead of ", retvals.size());
+  }
+  return absl::OkStatus();
+}
+
+Status RecordOrFlushLazyOp(EagerOperation* op, const KernelAndDevice& kernel,
+                           TensorHandle** retvals, bool* recorded) {
+  EagerContext& ctx = op->EagerContext();
+  *recorded = false;
+  core::RefCountPtr<LazyTensorProducer> current = ctx.GetLazyTrace();
+  LazyTrace* trace = down_cast<LazyTrace*>(current.get());
+  if (!LazyTrace::CanRecord(*op, kernel)) {
+    return trace == nullptr ? absl::OkStatus() : trace->Flush();
+  }
+  if (trace != nullptr) {
+    if (trace->Record(op, kernel, retvals)) {
+      *recorded = true;
+      return absl::OkStatus();
+    }
+    TF_RETURN_IF_ERROR(trace->Flush());
+  }
+  core::RefCountPtr<LazyTrace> next(new LazyTrace(&ctx));
+  ctx.SetLazyTrace(next.get());
+  thread_lazy_traces.Set(ctx, next.get());
+  *recorded = next->Record(op, kernel, retvals);
+  return absl::OkStatus();
+}
+
+}  // namespace tensorflow
@@ -0,0 +1,122 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_LAZY_TRACE_H_
+#define TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_LAZY_TRACE_H_
+
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
+#include "tensorflow/core/common_runtime/eager/eager_operation.h"
+#include "tensorflow/core/common_runtime/eager/kernel_and_device.h"
+#include "tensorflow/core/common_runtime/eager/tensor_handle.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+
+// The ops recorded by a thread in lazy eager execution, and not run yet.
+//
+// The outputs of the recorded ops are empty handles. The ops are run together
+// as one function, which returns the outputs still referenced outside the
+// trace, when one of the outputs is waited for, when the thread runs an op
+// that cannot be recorded, or when the trace is full. The function is named
+// after a fingerprint of the ops, so that a loop running the same ops reuses
+// the function, and the kernel, optimized by Grappler on the first run. The
+// context keeps the most recently used of these functions. The ops recorded by
+// a thread also run when it exits, unless the context has been destroyed, which
+// poisons their outputs instead.
+class LazyTrace : public LazyTensorProducer {
+ public:
+  // The number of ops recorded before the trace is run.
+  static constexpr int kMaxOps = 256;
+
+  explicit LazyTrace(EagerContext* ctx)
+      : ctx_(*ctx), thread_(std::this_thread::get_id()) {}
+  ~LazyTrace() override;
+
+  // Returns whether `op`, placed and with its kernel created, can be recorded:
+  // a stateless primitive op run synchronously on the host CPU, on local
+  // tensors other than resources and variants.
+  static bool CanRecord(EagerOperation& op, const KernelAndDevice& kernel);
+
+  // Records `op` and sets `retvals` to its outputs. Waits for the inputs of
+  // `op` that are not outputs of this trace, and returns false without
+  // recording it if one of them is poisoned, or if the trace has been run or
+  // is full.
+  bool Record(EagerOperation* op, const KernelAndDevice& kernel,
+              TensorHandle** retvals);
+
+  Status Flush() override;
+  void Discard(const Status& status) override;
+
+ private:
+  // An input of a recorded op: the output of a recorded op, or an argument of
+  // the trace when the op index is -1.
+  using Source = std::pair<int, int>;
+
+  struct RecordedOp {
+    NodeDef node_def;
+    // The fingerprint of the op, its attributes and its device.
+    Fprint128 key;
+    absl::InlinedVector<Source, 4> inputs;
+    // The handles of the outputs, referenced by the trace.
+    absl::InlinedVector<TensorHandle*, 2> outputs;
+  };
+
+  // Moves the recorded ops and their arguments out of the trace, unless it has
+  // been run or discarded. Returns false if it has.
+  bool Take(std::vector<RecordedOp>* ops, std::vector<TensorHandle*>* args);
+  // Runs `ops` on `args`, and sets the outputs referenced outside the trace,
+  // or poisons them on failure.
+  Status Run(const std::vector<RecordedOp>& ops,
+             const std::vector<TensorHandle*>& args);
+  // Calls the function of `ops` on `args`, which returns the `result_sources`
+  // in `retvals`.
+  Status Call(const std::vector<RecordedOp>& ops,
+              const std::vector<TensorHandle*>& args,
+              const std::vector<Source>& result_sources,
+              absl::Span<TensorHandle*> retvals);
+
+  EagerContext& ctx_;
+  // The thread recording its ops in the trace.
+  const std::thread::id thread_;
+
+  mutex mu_;
+  bool flushed_ TF_GUARDED_BY(mu_) = false;
+  std::vector<RecordedOp> ops_ TF_GUARDED_BY(mu_);
+  // The handles read by the recorded ops but not produced by them.
+  std::vector<TensorHandle*> args_ TF_GUARDED_BY(mu_);
+  absl::flat_hash_map<const TensorHandle*, Source> sources_
+      TF_GUARDED_BY(mu_);
+};
+
+// Records `op` in the lazy trace of the calling thread if it can be, setting
+// `*recorded` and `retvals`. Otherwise runs the ops recorded by the thread, so
+// that `op` runs after them.
+Status RecordOrFlushLazyOp(EagerOperation* op, const KernelAndDevice& kernel,
+                           TensorHandle** retvals, bool* recorded);
+
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_COMMON_RUNTIME_EAGER_LAZY_TRACE_H_
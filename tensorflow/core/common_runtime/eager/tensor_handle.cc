@@ -1008,6 +1008,11 @@ Status TensorHandle::SetTensor(tensorflow::Tensor&& t, const Device* d) {
   return absl::OkStatus();
 }
 
+void TensorHandle::SetLazyProducer(LazyTensorProducer* producer) {
+  DCHECK(Type() == LOCAL) << "SetLazyProducer is only called on local handles.";
+  std::get<LocalTensorHandleData>(data_).SetProducer(producer);
+}
+
 void TensorHandle::Poison(Status status, const Device* d) {
   DVLOG(3) << "Poison on TensorHandle: " << this << " device: " << d;
 
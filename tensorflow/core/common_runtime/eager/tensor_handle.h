@@ -228,6 +228,10 @@ class TensorHandle : public ImmediateExecutionTensorHandle {
   // handles to make them ready.
   Status SetTensor(tensorflow::Tensor&& tensor, const Device* d);
 
+  // Has `producer` make this empty local handle ready the first time it is
+  // waited for, instead of an EagerNode.
+  void SetLazyProducer(LazyTensorProducer* producer);
+
   // Poisons either this handle or a local mirror with error `status`.
   // Poisoning means that the handle will become ready and methods trying
   // to access the actual tensor or shape will return this error `status`.
@@ -104,13 +104,44 @@ string LocalTensorHandleData::DebugString() const {
   }
 }
 
+LocalTensorHandleData::BlockingControl::~BlockingControl() {
+  if (producer_ != nullptr) producer_->Unref();
+}
+
 void LocalTensorHandleData::BlockingControl::SetReady() {
+  LazyTensorProducer* producer;
+  {
+    mutex_lock l(mu_);
+    is_ready_ = true;
+    producer = std::exchange(producer_, nullptr);
+  }
+  if (producer != nullptr) producer->Unref();
+}
+
+void LocalTensorHandleData::BlockingControl::SetProducer(
+    LazyTensorProducer* producer) {
+  producer->Ref();
   mutex_lock l(mu_);
-  is_ready_ = true;
+  DCHECK(!is_ready_ && producer_ == nullptr);
+  producer_ = producer;
 }
 
 Status LocalTensorHandleData::BlockingControl::WaitReady(
     const char* caller) const {
+  LazyTensorProducer* producer = nullptr;
+  {
+    tf_shared_lock l(mu_);
+    if (!is_ready_ && producer_ != nullptr) {
+      producer = producer_;
+      producer->Ref();
+    }
+  }
+  if (producer != nullptr) {
+    // The errors are reported by poisoning the handles.
+    producer->Flush().IgnoreError();
+    producer->Unref();
+  }
+
   tf_shared_lock l(mu_);
   if (!is_ready_) {
     tsl::profiler::TraceMe activity(
@@ -125,13 +156,18 @@ Status LocalTensorHandleData::BlockingControl::WaitReady(
 }
 
 void LocalTensorHandleData::BlockingControl::Poison(Status status) {
-  mutex_lock l(mu_);
-  if (is_ready_) {
-    LOG(ERROR) << "Poison can only be called on non-ready handle: " << this;
-    return;
+  LazyTensorProducer* producer;
+  {
+    mutex_lock l(mu_);
+    if (is_ready_) {
+      LOG(ERROR) << "Poison can only be called on non-ready handle: " << this;
+      return;
+    }
+    is_poisoned_ = status;
+    is_ready_ = true;
+    producer = std::exchange(producer_, nullptr);
   }
-  is_poisoned_ = status;
-  is_ready_ = true;
+  if (producer != nullptr) producer->Unref();
 }
 
 }  // namespace tensorflow
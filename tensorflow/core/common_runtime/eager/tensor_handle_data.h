@@ -20,6 +20,7 @@ limitations under the License.
 
 #include "absl/types/variant.h"
 #include "tensorflow/core/common_runtime/eager/context.h"
+#include "tensorflow/core/common_runtime/eager/eager_executor.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/lib/core/status.h"
 
@@ -60,6 +61,11 @@ class LocalTensorHandleData {
 
   Status SetTensor(tensorflow::Tensor&& t);
 
+  // Has `producer` set the tensor of this empty handle when it is waited for.
+  void SetProducer(LazyTensorProducer* producer) {
+    std::get<BlockingControl>(ctrl_).SetProducer(producer);
+  }
+
   string DebugString() const;
 
  private:
@@ -87,11 +93,13 @@ class LocalTensorHandleData {
 
   class BlockingControl {
    public:
+    ~BlockingControl();
     bool IsReady() const {
       tf_shared_lock l(mu_);
       return is_ready_;
     }
     void SetReady();
+    void SetProducer(LazyTensorProducer* producer);
     Status WaitReady(const char* caller) const;
     void Poison(Status status);
     Status IsPoisoned() const {
@@ -103,6 +111,8 @@ class LocalTensorHandleData {
     mutable mutex mu_;
     bool is_ready_ TF_GUARDED_BY(mu_);
     Status is_poisoned_ TF_GUARDED_BY(mu_);
+    // Flushed by the first wait, and released once the handle is ready.
+    LazyTensorProducer* producer_ TF_GUARDED_BY(mu_) = nullptr;
   };
 
   std::variant<NonBlockingControl, BlockingControl> ctrl_;
@@ -18,6 +18,7 @@ limitations under the License.
 #include <algorithm>
 #include <atomic>
 #include <memory>
+#include <queue>
 #include <utility>
 #include <vector>
 
@@ -230,6 +231,43 @@ class ExecutorImpl : public Executor {
   void operator=(const ExecutorImpl&) = delete;
 };
 
+// `PrioritizedPropagatorState` replaces the `TaggedNodeReadyQueue` of
+// `PropagatorStateType` with a priority queue on `NodeItem::priority`, so that
+// the inline ready nodes on the longest paths to the end of the graph run
+// first. Nodes with the same priority run in node id order.
+//
+// This codepath is enabled for graphs annotated with
+// `kCriticalPathPriorityAttrName`, e.g. by the "critical_path_priority"
+// Grappler optimizer.
+template <class PropagatorStateType>
+class PrioritizedPropagatorState : public PropagatorStateType {
+  using PropagatorStateType::PropagatorStateType;
+
+ public:
+  using TaggedNode = typename PropagatorStateType::TaggedNode;
+
+  class TaggedNodeReadyQueue {
+   public:
+    TaggedNodeReadyQueue() : readyp_(compare) {}
+    void push_back(const TaggedNode& node) { readyp_.push(node); }
+    TaggedNode front() const { return readyp_.top(); }
+    void pop_front() { readyp_.pop(); }
+    bool empty() const { return readyp_.empty(); }
+    int size() const { return readyp_.size(); }
+
+   private:
+    static bool compare(TaggedNode const& lhs, TaggedNode const& rhs) {
+      if (lhs.node_item->priority != rhs.node_item->priority) {
+        return lhs.node_item->priority < rhs.node_item->priority;
+      }
+      return lhs.node_item->node_id > rhs.node_item->node_id;
+    }
+
+    std::priority_queue<TaggedNode, std::vector<TaggedNode>, decltype(&compare)>
+        readyp_;
+  };
+};
+
 // The state associated with one invocation of ExecutorImpl::Run.
 //
 // ExecutorState dispatches nodes when they become ready, and delegates to an
@@ -1277,6 +1315,15 @@ void ExecutorState<PropagatorStateType>::ScheduleReady(
       tsl::profiler::GetTFTraceMeLevel(/*is_expensive=*/false));
   DCHECK(!ready->empty());
 
+  if (immutable_state_.has_priorities()) {
+    // Dispatch the nodes on the longest paths to the end of the graph first.
+    std::stable_sort(ready->begin(), ready->end(),
+                     [](const TaggedNode& lhs, const TaggedNode& rhs) {
+                       return lhs.node_item->priority >
+                              rhs.node_item->priority;
+                     });
+  }
+
   int64_t scheduled_nsec = 0;
   if (stats_collector_) {
     scheduled_nsec = nodestats::NowInNsec();
@@ -1516,6 +1563,16 @@ void ExecutorImpl::RunAsyncInternal(const Args& args, DoneCallback done) {
     (new ExecutorState<OrderedPropagatorState>(args, immutable_state_,
                                                &kernel_stats_))
         ->RunAsync(std::move(done));
+  } else if (immutable_state_.has_priorities()) {
+    if (immutable_state_.requires_control_flow_support()) {
+      (new ExecutorState<PrioritizedPropagatorState<PropagatorState>>(
+           args, immutable_state_, &kernel_stats_))
+          ->RunAsync(std::move(done));
+    } else {
+      (new ExecutorState<PrioritizedPropagatorState<SimplePropagatorState>>(
+           args, immutable_state_, &kernel_stats_))
+          ->RunAsync(std::move(done));
+    }
   } else if (immutable_state_.requires_control_flow_support()) {
     (new ExecutorState<PropagatorState>(args, immutable_state_, &kernel_stats_))
         ->RunAsync(std::move(done));
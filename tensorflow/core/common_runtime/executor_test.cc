@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/common_runtime/step_stats_collector.h"
 #include "tensorflow/core/framework/attr_value.pb.h"
 #include "tensorflow/core/framework/local_rendezvous.h"
+#include "tensorflow/core/framework/node_def_util.h"
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/rendezvous.h"
 #include "tensorflow/core/framework/step_stats.pb.h"
@@ -265,6 +266,28 @@ TEST_F(ExecutorTest, RandomTree) {
   EXPECT_EQ(4096.0, V(out));
 }
 
+TEST_F(ExecutorTest, RandomTreeWithPriorities) {
+  auto g = std::make_unique<Graph>(OpRegistry::Global());
+  BuildTree(4096, g.get());
+  // Run the nodes in an arbitrary order of priorities.
+  random::PhiloxRandom philox(testing::RandomSeed(), 17);
+  random::SimplePhilox rnd(&philox);
+  for (Node* n : g->op_nodes()) {
+    n->AddAttr(kCriticalPathPriorityAttrName,
+               static_cast<int64_t>(1 + rnd.Uniform(100)));
+  }
+  Create(std::move(g));
+  Rendezvous::Args args;
+  TF_ASSERT_OK(
+      rendez_->Send(Key(ALICE, kIncarnation, BOB, "a"), args, V(1.0), false));
+  TF_ASSERT_OK(Run(rendez_));
+  Tensor out = V(-1);
+  bool is_dead = false;
+  TF_ASSERT_OK(
+      rendez_->Recv(Key(BOB, kIncarnation, ALICE, "b"), args, &out, &is_dead));
+  EXPECT_EQ(4096.0, V(out));
+}
+
 void BuildConcurrentAddAssign(Graph* g) {
   auto one = test::graph::Constant(g, V(1.0));
   // A variable holds one float.
@@ -520,6 +543,56 @@ BENCHMARK(BM_const_identity)
     ->ArgPair(100, 1)
     ->ArgPair(100, 100);
 
+// Create a graph with a chain of 'depth' matmuls next to 'width' single
+// matmuls, all summed at the end. If 'prioritized', the nodes are annotated
+// with their distance to the end of the graph, like the critical_path_priority
+// Grappler optimizer does, so that the chain starts first.
+static void BM_CriticalPathPriority(::testing::benchmark::State& state) {
+  const int width = state.range(0);
+  const int inter_op_threads = state.range(1);
+  const bool prioritized = state.range(2);
+  constexpr int kDepth = 16;
+  constexpr int kDim = 128;
+
+  Graph* g = new Graph(OpRegistry::Global());
+  const auto set_priority = [prioritized](Node* n, int64_t priority) {
+    if (prioritized) n->AddAttr(kCriticalPathPriorityAttrName, priority);
+  };
+  // Multiplying this matrix with itself leaves it unchanged.
+  Tensor x(DT_FLOAT, TensorShape({kDim, kDim}));
+  x.flat<float>().setConstant(1.0f / kDim);
+
+  Node* chain = test::graph::Constant(g, x);
+  set_priority(chain, kDepth + 2);
+  for (int i = 0; i < kDepth; ++i) {
+    chain = test::graph::Matmul(g, chain, chain, false, false);
+    set_priority(chain, kDepth + 1 - i);
+  }
+  Node* sum = chain;
+  for (int i = 0; i < width; ++i) {
+    Node* branch = test::graph::Constant(g, x);
+    set_priority(branch, 3);
+    branch = test::graph::Matmul(g, branch, branch, false, false);
+    set_priority(branch, 2);
+    sum = test::graph::Add(g, sum, branch);
+    set_priority(sum, 1);
+  }
+
+  SessionOptions options;
+  options.config.set_inter_op_parallelism_threads(inter_op_threads);
+  FixupSourceAndSinkEdges(g);
+  test::Benchmark("cpu", g, &options, nullptr, nullptr, "",
+                  /*old_benchmark_api=*/false)
+      .Run(state);
+  state.SetLabel(strings::StrCat("Nodes = ", 1 + kDepth + 3 * width));
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+
+// Wide graphs at several inter-op thread counts, without and with priorities.
+BENCHMARK(BM_CriticalPathPriority)
+    ->UseRealTime()
+    ->ArgsProduct({{64, 512}, {2, 4, 8}, {0, 1}});
+
 static void BM_FeedInputFetchOutput(::testing::benchmark::State& state) {
   Graph* g = new Graph(OpRegistry::Global());
   // z = x + y: x and y are provided as benchmark inputs.  z is the
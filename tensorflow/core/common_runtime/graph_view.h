@@ -89,6 +89,9 @@ struct NodeItem {
   // The kernel for this node.
   OpKernel* kernel = nullptr;
 
+  // Value of the `kCriticalPathPriorityAttrName` attribute of this node, or 0.
+  int64_t priority = 0;
+
   // If the kernel is a Const op, this containts points to the constant tensor.
   const Tensor* const_tensor = nullptr;
 
@@ -196,6 +196,11 @@ Status ImmutableExecutorState::Initialize(const Graph& graph) {
     item->is_recv_or_switch = IsRecv(n) || IsSwitch(n);
     item->is_next_iteration = IsNextIteration(n);
     item->is_distributed_communication = IsDistributedCommunication(n);
+    if (TryGetNodeAttr(n->attrs(), kCriticalPathPriorityAttrName,
+                       &item->priority) &&
+        item->priority != 0) {
+      has_priorities_ = true;
+    }
 
     // Compute the maximum values we'll store for this node in the
     // pending counts data structure, and allocate a handle in
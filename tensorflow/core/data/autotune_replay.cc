@@ -0,0 +1,250 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/autotune_replay.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/cancellation.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/model.pb.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/mem.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/statusor.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kBaseline[] = "BASELINE";
+constexpr double kNanosPerSecond = 1.0e9;
+
+std::string NodeLongName(const model::ModelProto::Node& node) {
+  return absl::StrCat(node.name(), "(id:", node.id(), ")");
+}
+
+std::string ParameterKey(const model::ModelProto::Node& node,
+                         const model::ModelProto::Node::Parameter& parameter) {
+  return absl::StrCat(NodeLongName(node), ":", parameter.name());
+}
+
+// Makes the model values of the parameters match their actual values, which
+// are the ones the pipeline runs with. The model values can differ from them
+// if the model was saved during an optimization search.
+void SyncValuesToStateValues(model::ModelProto* model_proto) {
+  for (auto& [id, node] : *model_proto->mutable_nodes()) {
+    for (auto& parameter : *node.mutable_parameters()) {
+      if (parameter.state_value() != model::kAutotune) {
+        parameter.set_value(parameter.state_value());
+      }
+    }
+  }
+}
+
+absl::StatusOr<std::unique_ptr<model::Model>> RestoreModel(
+    const model::ModelProto& model_proto) {
+  std::unique_ptr<model::Model> model;
+  TF_RETURN_IF_ERROR(model::Model::FromProto(model_proto, &model));
+  if (model->output() == nullptr) {
+    return errors::InvalidArgument("The model has no output node.");
+  }
+  return model;
+}
+
+// Fills in the options which are not set from the optimization parameters
+// saved with the model, or from the resources of this machine.
+ReplayOptions ResolveOptions(const model::ModelProto& model_proto,
+                             const ReplayOptions& options) {
+  const model::ModelProto::OptimizationParams& params =
+      model_proto.optimization_params();
+  ReplayOptions resolved = options;
+  if (!resolved.cpu_budget.has_value()) {
+    resolved.cpu_budget = params.cpu_budget() > 0 ? params.cpu_budget()
+                                                  : port::MaxParallelism();
+  }
+  if (!resolved.ram_budget.has_value()) {
+    resolved.ram_budget = params.ram_budget() > 0 ? params.ram_budget()
+                                                  : port::AvailableRam();
+  }
+  if (!resolved.model_input_time.has_value()) {
+    resolved.model_input_time = params.model_input_time();
+  }
+  return resolved;
+}
+
+// Predicts the performance of `model`, whose parameter values are described by
+// `model_proto`.
+ReplayResult Evaluate(const model::ModelProto& model_proto,
+                      model::Model& model, double model_input_time) {
+  ReplayResult result;
+  result.output_time_nsec = model.OutputTime(model.output(), model_input_time,
+                                             /*gradients=*/nullptr);
+  if (result.output_time_nsec > 0) {
+    result.throughput = kNanosPerSecond / result.output_time_nsec;
+  }
+  result.max_buffered_bytes = model.output()->TotalMaximumBufferedBytes();
+  for (const auto& [id, node] : model_proto.nodes()) {
+    for (const auto& parameter : node.parameters()) {
+      if (parameter.tunable()) {
+        result.parameters[ParameterKey(node, parameter)] = parameter.value();
+      }
+    }
+  }
+  return result;
+}
+
+}  // namespace
+
+absl::StatusOr<model::ModelProto> LoadModelProto(const std::string& fname) {
+  model::ModelProto model_proto;
+  TF_RETURN_IF_ERROR(
+      ReadTextOrBinaryProto(Env::Default(), fname, &model_proto));
+  return model_proto;
+}
+
+absl::Status SetModelParameters(
+    const absl::btree_map<std::string, double>& values,
+    model::ModelProto* model_proto) {
+  absl::flat_hash_map<std::string, model::ModelProto::Node::Parameter*>
+      parameters;
+  for (auto& [id, node] : *model_proto->mutable_nodes()) {
+    for (auto& parameter : *node.mutable_parameters()) {
+      parameters[ParameterKey(node, parameter)] = &parameter;
+    }
+  }
+  for (const auto& [key, value] : values) {
+    auto it = parameters.find(key);
+    if (it == parameters.end()) {
+      return errors::NotFound("Parameter ", key,
+                              " was not found in the model.");
+    }
+    model::ModelProto::Node::Parameter& parameter = *it->second;
+    if (value < parameter.min() || value > parameter.max()) {
+      return errors::InvalidArgument("Value ", value, " of parameter ", key,
+                                     " is outside of its range [",
+                                     parameter.min(), ", ", parameter.max(),
+                                     "].");
+    }
+    parameter.set_value(value);
+    parameter.set_state_value(value);
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<ReplayResult> SimulateModel(const model::ModelProto& model_proto,
+                                           const ReplayOptions& options) {
+  model::ModelProto synced_proto = model_proto;
+  SyncValuesToStateValues(&synced_proto);
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<model::Model> model,
+                      RestoreModel(synced_proto));
+  const ReplayOptions resolved = ResolveOptions(model_proto, options);
+  ReplayResult result =
+      Evaluate(synced_proto, *model, *resolved.model_input_time);
+  result.name = kBaseline;
+  return result;
+}
+
+absl::StatusOr<ReplayResult> ReplayAutotune(
+    const model::ModelProto& model_proto, model::AutotuneAlgorithm algorithm,
+    const ReplayOptions& options) {
+  model::ModelProto synced_proto = model_proto;
+  SyncValuesToStateValues(&synced_proto);
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<model::Model> model,
+                      RestoreModel(synced_proto));
+  // `STAGE_BASED` derives its target time from the recorded gap times.
+  for (uint64_t gap_time_usec : model_proto.gap_times()) {
+    model->RecordIteratorGapTime(gap_time_usec);
+  }
+
+  const ReplayOptions resolved = ResolveOptions(model_proto, options);
+  const int64_t cpu_budget = *resolved.cpu_budget;
+  model::RamBudgetManager ram_budget_manager(*resolved.ram_budget);
+  CancellationManager cancellation_manager;
+  const uint64_t start_usec = Env::Default()->NowMicros();
+  model->Optimize(
+      algorithm, [cpu_budget]() { return cpu_budget; },
+      /*ram_budget_share=*/1.0, /*fixed_ram_budget=*/*resolved.ram_budget,
+      *resolved.model_input_time, ram_budget_manager, &cancellation_manager);
+  const uint64_t end_usec = Env::Default()->NowMicros();
+
+  // The algorithms update the actual values of the parameters, which the
+  // snapshot of the model shares with the model.
+  model::ModelProto tuned_proto;
+  TF_RETURN_IF_ERROR(model->ToProto(&tuned_proto));
+  SyncValuesToStateValues(&tuned_proto);
+  TF_ASSIGN_OR_RETURN(std::unique_ptr<model::Model> tuned_model,
+                      RestoreModel(tuned_proto));
+  ReplayResult result =
+      Evaluate(tuned_proto, *tuned_model, *resolved.model_input_time);
+  result.name = model::AutotuneAlgorithm_Name(algorithm);
+  result.optimization_time_usec = end_usec - start_usec;
+  return result;
+}
+
+absl::StatusOr<std::vector<ReplayResult>> CompareAutotuneAlgorithms(
+    const model::ModelProto& model_proto,
+    absl::Span<const model::AutotuneAlgorithm> algorithms,
+    const ReplayOptions& options) {
+  std::vector<ReplayResult> results;
+  TF_ASSIGN_OR_RETURN(ReplayResult baseline,
+                      SimulateModel(model_proto, options));
+  results.push_back(std::move(baseline));
+  for (model::AutotuneAlgorithm algorithm : algorithms) {
+    TF_ASSIGN_OR_RETURN(ReplayResult result,
+                        ReplayAutotune(model_proto, algorithm, options));
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
+std::string FormatReplayResults(absl::Span<const ReplayResult> results,
+                                bool print_parameters) {
+  std::string output =
+      absl::StrFormat("%-18s %16s %16s %16s %14s\n", "algorithm",
+                      "output_time_us", "elements/s", "max_buffered_MB",
+                      "optimize_ms");
+  for (const ReplayResult& result : results) {
+    absl::StrAppendFormat(&output, "%-18s %16.3f %16.1f %16.3f %14.3f\n",
+                          result.name, result.output_time_nsec / 1.0e3,
+                          result.throughput,
+                          result.max_buffered_bytes / (1 << 20),
+                          result.optimization_time_usec / 1.0e3);
+  }
+  if (print_parameters) {
+    for (const ReplayResult& result : results) {
+      absl::StrAppend(&output, "\n", result.name, ":\n");
+      for (const auto& [key, value] : result.parameters) {
+        absl::StrAppendFormat(&output, "  %s = %g\n", key, value);
+      }
+    }
+  }
+  return output;
+}
+
+}  // namespace data
+}  // namespace tensorflow
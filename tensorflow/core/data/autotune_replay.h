@@ -0,0 +1,104 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_AUTOTUNE_REPLAY_H_
+#define TENSORFLOW_CORE_DATA_AUTOTUNE_REPLAY_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/model.pb.h"
+
+namespace tensorflow {
+namespace data {
+
+// Offline replay of the tf.data autotuner.
+//
+// Loads `ModelProto` snapshots saved by `model::Model::Save` (e.g. captured
+// from production jobs), and predicts the throughput and memory usage of the
+// pipeline for given parameter values or for the values picked by an autotune
+// algorithm. This makes it possible to compare autotune algorithms on the same
+// pipelines, without running the pipelines.
+
+// Resources available to the simulated pipeline. Unset fields default to the
+// optimization parameters saved with the model.
+struct ReplayOptions {
+  // Number of available logical threads.
+  std::optional<int64_t> cpu_budget;
+  // Amount of memory in bytes available to the buffers of the pipeline.
+  std::optional<int64_t> ram_budget;
+  // Time in nanoseconds between two consecutive `GetNext` calls to the
+  // pipeline.
+  std::optional<double> model_input_time;
+};
+
+// Predicted performance of a pipeline.
+struct ReplayResult {
+  // Name of the autotune algorithm which picked the parameter values, or
+  // "BASELINE" for the values saved with the model.
+  std::string name;
+  // Time in nanoseconds to produce an element at the output of the pipeline.
+  double output_time_nsec = 0;
+  // Elements produced per second at the output of the pipeline, or 0 if the
+  // output time is unknown.
+  double throughput = 0;
+  // Bytes buffered by the pipeline when all of its buffers are full.
+  double max_buffered_bytes = 0;
+  // Time in microseconds spent by the autotune algorithm.
+  int64_t optimization_time_usec = 0;
+  // Values of the tunable parameters, keyed by "<node long name>:<parameter>",
+  // e.g. "ParallelMapV2(id:3):parallelism".
+  absl::btree_map<std::string, double> parameters;
+};
+
+// Loads a model saved by `model::Model::Save`.
+absl::StatusOr<model::ModelProto> LoadModelProto(const std::string& fname);
+
+// Sets parameters of the model to the given values, keyed like
+// `ReplayResult::parameters`. Returns an error if a parameter is not found.
+absl::Status SetModelParameters(
+    const absl::btree_map<std::string, double>& values,
+    model::ModelProto* model_proto);
+
+// Predicts the performance of the pipeline with its current parameter values.
+absl::StatusOr<ReplayResult> SimulateModel(const model::ModelProto& model_proto,
+                                           const ReplayOptions& options);
+
+// Runs one round of `algorithm` on the model, and predicts the performance of
+// the pipeline with the parameter values it picks.
+absl::StatusOr<ReplayResult> ReplayAutotune(
+    const model::ModelProto& model_proto, model::AutotuneAlgorithm algorithm,
+    const ReplayOptions& options);
+
+// Returns the baseline performance of the pipeline followed by its
+// performance with each of the given algorithms.
+absl::StatusOr<std::vector<ReplayResult>> CompareAutotuneAlgorithms(
+    const model::ModelProto& model_proto,
+    absl::Span<const model::AutotuneAlgorithm> algorithms,
+    const ReplayOptions& options);
+
+// Returns a human-readable table of the results.
+std::string FormatReplayResults(absl::Span<const ReplayResult> results,
+                                bool print_parameters);
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_AUTOTUNE_REPLAY_H_
@@ -0,0 +1,139 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Replays the tf.data autotuner on saved models. For each model, prints the
+// predicted throughput and memory usage of the pipeline with its saved
+// parameter values and with the values picked by each autotune algorithm. For
+// example:
+//
+// bazel run tensorflow/core/data:autotune_replay_main -- \
+//   --models=/tmp/model_1.pb,/tmp/model_2.pb \
+//   --algorithms=HILL_CLIMB,STAGE_BASED --cpu_budget=16
+//
+// Models are `ModelProto`s in text or binary format, e.g. saved with
+// `model::Model::Save`.
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_split.h"
+#include "tensorflow/core/data/autotune_replay.h"
+#include "tensorflow/core/framework/model.pb.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+int Run(int argc, char* argv[]) {
+  std::string models;
+  std::string algorithms = "HILL_CLIMB,GRADIENT_DESCENT,MAX_PARALLELISM";
+  std::string parameters;
+  int64_t cpu_budget = 0;
+  int64_t ram_budget = 0;
+  bool print_parameters = false;
+  std::vector<Flag> flag_list = {
+      Flag("models", &models, "comma-separated saved model files"),
+      Flag("algorithms", &algorithms,
+           "comma-separated autotune algorithms to compare"),
+      Flag("parameters", &parameters,
+           "comma-separated <node long name>:<parameter>=<value> overrides "
+           "applied to the models before simulating them"),
+      Flag("cpu_budget", &cpu_budget,
+           "number of available logical threads, or 0 to use the saved one"),
+      Flag("ram_budget", &ram_budget,
+           "bytes of memory available to the pipeline buffers, or 0 to use "
+           "the saved one"),
+      Flag("print_parameters", &print_parameters,
+           "whether to print the tuned parameter values"),
+  };
+  const std::string usage = Flags::Usage(argv[0], flag_list);
+  const bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  port::InitMain(argv[0], &argc, &argv);
+  if (!parse_result || argc > 1 || models.empty()) {
+    LOG(ERROR) << usage;
+    return 1;
+  }
+
+  std::vector<model::AutotuneAlgorithm> algorithm_list;
+  for (absl::string_view name :
+       absl::StrSplit(algorithms, ',', absl::SkipEmpty())) {
+    model::AutotuneAlgorithm algorithm;
+    if (!model::AutotuneAlgorithm_Parse(std::string(name), &algorithm)) {
+      LOG(ERROR) << "Unknown autotune algorithm " << name << ".\n" << usage;
+      return 1;
+    }
+    algorithm_list.push_back(algorithm);
+  }
+
+  absl::btree_map<std::string, double> parameter_values;
+  for (absl::string_view parameter :
+       absl::StrSplit(parameters, ',', absl::SkipEmpty())) {
+    std::vector<std::string> key_value = absl::StrSplit(parameter, '=');
+    double value;
+    if (key_value.size() != 2 || !absl::SimpleAtod(key_value[1], &value)) {
+      LOG(ERROR) << "Invalid parameter override " << parameter << ".\n"
+                 << usage;
+      return 1;
+    }
+    parameter_values[key_value[0]] = value;
+  }
+
+  ReplayOptions options;
+  if (cpu_budget > 0) {
+    options.cpu_budget = cpu_budget;
+  }
+  if (ram_budget > 0) {
+    options.ram_budget = ram_budget;
+  }
+
+  for (absl::string_view fname :
+       absl::StrSplit(models, ',', absl::SkipEmpty())) {
+    absl::StatusOr<model::ModelProto> model_proto =
+        LoadModelProto(std::string(fname));
+    if (!model_proto.ok()) {
+      LOG(ERROR) << "Failed to load " << fname << ": " << model_proto.status();
+      return 1;
+    }
+    absl::Status status = SetModelParameters(parameter_values, &*model_proto);
+    if (!status.ok()) {
+      LOG(ERROR) << "Failed to set parameters of " << fname << ": " << status;
+      return 1;
+    }
+    absl::StatusOr<std::vector<ReplayResult>> results =
+        CompareAutotuneAlgorithms(*model_proto, algorithm_list, options);
+    if (!results.ok()) {
+      LOG(ERROR) << "Failed to replay " << fname << ": " << results.status();
+      return 1;
+    }
+    std::cout << fname << "\n"
+              << FormatReplayResults(*results, print_parameters) << std::endl;
+  }
+  return 0;
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::data::Run(argc, argv);
+}
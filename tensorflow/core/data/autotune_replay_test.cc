@@ -0,0 +1,171 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/autotune_replay.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/framework/model.pb.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/path.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tsl/platform/status_matchers.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::HasSubstr;
+using ::tsl::testing::IsOkAndHolds;
+using ::tsl::testing::StatusIs;
+
+constexpr char kParallelism[] = "ParallelMapV2(id:1):parallelism";
+
+// Returns the proto of a model of `ParallelMapV2` over a source, whose
+// parallelism was tuned to `parallelism`.
+model::ModelProto MakeModelProto(int64_t parallelism) {
+  auto state = std::make_shared<model::SharedState>(
+      /*value=*/model::kAutotune, std::make_shared<mutex>(),
+      std::make_shared<condition_variable>());
+  state->value = parallelism;
+  std::shared_ptr<model::Node> map = model::MakeAsyncKnownRatioNode(
+      {1, "ParallelMapV2", nullptr}, /*ratio=*/1,
+      {model::MakeParameter(model::kParallelism, state, /*min=*/1,
+                            /*max=*/16)});
+  std::shared_ptr<model::Node> source =
+      model::MakeSourceNode({2, "Range", map});
+
+  model::Model model;
+  model.AddNode([&map](model::Node::Args args) { return map; }, map->name(),
+                nullptr, &map);
+  model.AddNode([&source](model::Node::Args args) { return source; },
+                source->name(), map, &source);
+  for (int i = 0; i < 10; ++i) {
+    source->add_processing_time(1000);
+    source->record_element();
+    map->add_processing_time(100000);
+    map->record_buffer_event(/*bytes_delta=*/1024, /*elements_delta=*/1);
+    map->record_element();
+  }
+
+  model::ModelProto model_proto;
+  TF_CHECK_OK(model.ToProto(&model_proto));
+  model_proto.mutable_optimization_params()->set_cpu_budget(8);
+  model_proto.mutable_optimization_params()->set_ram_budget(1 << 30);
+  return model_proto;
+}
+
+TEST(AutotuneReplayTest, SimulateModel) {
+  TF_ASSERT_OK_AND_ASSIGN(ReplayResult result,
+                          SimulateModel(MakeModelProto(/*parallelism=*/2),
+                                        ReplayOptions()));
+  EXPECT_EQ(result.name, "BASELINE");
+  EXPECT_GT(result.output_time_nsec, 0);
+  EXPECT_DOUBLE_EQ(result.throughput, 1.0e9 / result.output_time_nsec);
+  EXPECT_GT(result.max_buffered_bytes, 0);
+  EXPECT_EQ(result.optimization_time_usec, 0);
+  EXPECT_EQ(result.parameters.size(), 1);
+  EXPECT_EQ(result.parameters[kParallelism], 2);
+}
+
+TEST(AutotuneReplayTest, HigherParallelismIsFaster) {
+  model::ModelProto model_proto = MakeModelProto(/*parallelism=*/1);
+  TF_ASSERT_OK_AND_ASSIGN(ReplayResult sequential,
+                          SimulateModel(model_proto, ReplayOptions()));
+  TF_ASSERT_OK(SetModelParameters({{kParallelism, 8}}, &model_proto));
+  TF_ASSERT_OK_AND_ASSIGN(ReplayResult parallel,
+                          SimulateModel(model_proto, ReplayOptions()));
+  EXPECT_EQ(parallel.parameters[kParallelism], 8);
+  EXPECT_LT(parallel.output_time_nsec, sequential.output_time_nsec);
+  EXPECT_GT(parallel.max_buffered_bytes, sequential.max_buffered_bytes);
+}
+
+TEST(AutotuneReplayTest, SetUnknownParameter) {
+  model::ModelProto model_proto = MakeModelProto(/*parallelism=*/1);
+  EXPECT_THAT(SetModelParameters({{"Range(id:2):parallelism", 2}},
+                                 &model_proto),
+              StatusIs(absl::StatusCode::kNotFound,
+                       HasSubstr("Range(id:2):parallelism")));
+}
+
+TEST(AutotuneReplayTest, SetParameterOutOfRange) {
+  model::ModelProto model_proto = MakeModelProto(/*parallelism=*/1);
+  EXPECT_THAT(SetModelParameters({{kParallelism, 17}}, &model_proto),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(AutotuneReplayTest, ReplayMaxParallelism) {
+  model::ModelProto model_proto = MakeModelProto(/*parallelism=*/1);
+  TF_ASSERT_OK_AND_ASSIGN(ReplayResult baseline,
+                          SimulateModel(model_proto, ReplayOptions()));
+  TF_ASSERT_OK_AND_ASSIGN(
+      ReplayResult tuned,
+      ReplayAutotune(model_proto, model::AutotuneAlgorithm::MAX_PARALLELISM,
+                     ReplayOptions()));
+  EXPECT_EQ(tuned.name, "MAX_PARALLELISM");
+  EXPECT_EQ(tuned.parameters[kParallelism], 16);
+  EXPECT_LT(tuned.output_time_nsec, baseline.output_time_nsec);
+  EXPECT_GE(tuned.optimization_time_usec, 0);
+}
+
+TEST(AutotuneReplayTest, CompareAutotuneAlgorithms) {
+  std::vector<model::AutotuneAlgorithm> algorithms = {
+      model::AutotuneAlgorithm::HILL_CLIMB,
+      model::AutotuneAlgorithm::GRADIENT_DESCENT,
+      model::AutotuneAlgorithm::MAX_PARALLELISM};
+  EXPECT_THAT(
+      CompareAutotuneAlgorithms(MakeModelProto(/*parallelism=*/1), algorithms,
+                                ReplayOptions()),
+      IsOkAndHolds(ElementsAre(Field(&ReplayResult::name, "BASELINE"),
+                               Field(&ReplayResult::name, "HILL_CLIMB"),
+                               Field(&ReplayResult::name, "GRADIENT_DESCENT"),
+                               Field(&ReplayResult::name, "MAX_PARALLELISM"))));
+}
+
+TEST(AutotuneReplayTest, LoadSavedModel) {
+  model::ModelProto model_proto = MakeModelProto(/*parallelism=*/3);
+  std::unique_ptr<model::Model> model;
+  TF_ASSERT_OK(model::Model::FromProto(model_proto, &model));
+  const std::string fname =
+      io::JoinPath(testing::TmpDir(), "autotune_replay_model");
+  TF_ASSERT_OK(model->Save(fname, model->output(),
+                           model_proto.optimization_params()));
+
+  TF_ASSERT_OK_AND_ASSIGN(model::ModelProto loaded, LoadModelProto(fname));
+  TF_ASSERT_OK_AND_ASSIGN(ReplayResult result,
+                          SimulateModel(loaded, ReplayOptions()));
+  EXPECT_EQ(result.parameters[kParallelism], 3);
+}
+
+TEST(AutotuneReplayTest, FormatReplayResults) {
+  ReplayResult result;
+  result.name = "HILL_CLIMB";
+  result.parameters[kParallelism] = 4;
+  const std::string output =
+      FormatReplayResults({result}, /*print_parameters=*/true);
+  EXPECT_THAT(output, HasSubstr("HILL_CLIMB"));
+  EXPECT_THAT(output, HasSubstr("ParallelMapV2(id:1):parallelism = 4"));
+}
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
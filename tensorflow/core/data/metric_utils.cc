@@ -90,5 +90,22 @@ bool IteratorMetricsCollector::ShouldCollectMetrics() const {
   return device_type_ == DEVICE_CPU;
 }
 
+CheckpointMetricsCollector::CheckpointMetricsCollector(bool async,
+                                                       Stage stage,
+                                                       const Env& env)
+    : async_(async), stage_(stage), env_(env) {}
+
+absl::Time CheckpointMetricsCollector::RecordStart() {
+  return absl::FromUnixMicros(env_.NowMicros());
+}
+
+void CheckpointMetricsCollector::RecordStop(absl::Time start_time) {
+  const uint64_t end_time_us = env_.NowMicros();
+  metrics::RecordTFDataCheckpointStallTime(
+      async_ ? "async" : "sync",
+      stage_ == Stage::kSerialize ? "serialize" : "encode",
+      safe_sub(end_time_us, absl::ToUnixMicros(start_time)));
+}
+
 }  // namespace data
 }  // namespace tensorflow
@@ -81,6 +81,49 @@ class IteratorMetricsCollector {
   uint64_t end_time_us_ TF_GUARDED_BY(mu_) = 0;
 };
 
+// Exports the time during which checkpointing a tf.data iterator blocks the
+// caller. A checkpoint first serializes the iterator state
+// (`SerializeIterator`) on the thread saving the iterator, i.e. the training
+// thread. For synchronous checkpoints, the state is then compressed when the
+// checkpoint is written (e.g. by `SaveV2`). For asynchronous checkpoints, the
+// state is compressed in the background, and writing the checkpoint waits for
+// the compression to finish. If the checkpoint is written on a separate thread
+// (e.g. by `tf.train.Checkpoint` with `experimental_enable_async_checkpoint`),
+// only the serialization stalls training. Example usage:
+//
+//   ```
+//   CheckpointMetricsCollector metrics_collector(
+//       /*async=*/true, CheckpointMetricsCollector::Stage::kSerialize, env);
+//   absl::Time start_time = metrics_collector.RecordStart();
+//   TF_RETURN_IF_ERROR(SerializeIterator(...));
+//   metrics_collector.RecordStop(start_time);
+//   ```
+class CheckpointMetricsCollector {
+ public:
+  enum class Stage {
+    // Serializing the iterator state into references to its tensors.
+    kSerialize,
+    // Compressing the iterator state, or waiting for its compression, when
+    // the checkpoint is written.
+    kEncode,
+  };
+
+  // `async` is whether the iterator state is compressed in the background.
+  CheckpointMetricsCollector(bool async, Stage stage, const Env& env);
+
+  // Starts the timer for a checkpoint stage. Returns the start time.
+  absl::Time RecordStart();
+
+  // Records the time during which the checkpoint stage blocked the caller.
+  // `start_time` is the start time returned by `RecordStart`.
+  void RecordStop(absl::Time start_time);
+
+ private:
+  const bool async_;
+  const Stage stage_;
+  const Env& env_;
+};
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -148,6 +148,26 @@ TEST(MetricUtilsTest, OverlappingThreads) {
             absl::ToInt64Microseconds(absl::Seconds(2.9)));
 }
 
+TEST(MetricUtilsTest, CollectCheckpointMetrics) {
+  CellReader<Histogram> stall_time("/tensorflow/data/checkpoint_stall_time");
+  EXPECT_FLOAT_EQ(stall_time.Delta("async", "serialize").num(), 0.0);
+  EXPECT_FLOAT_EQ(stall_time.Delta("async", "encode").num(), 0.0);
+  EXPECT_FLOAT_EQ(stall_time.Delta("sync", "serialize").num(), 0.0);
+
+  CheckpointMetricsCollector metrics_collector(
+      /*async=*/true, CheckpointMetricsCollector::Stage::kSerialize,
+      *Env::Default());
+  absl::Time start_time = metrics_collector.RecordStart();
+  absl::SleepFor(absl::Seconds(1));
+  metrics_collector.RecordStop(start_time);
+
+  Histogram stall_time_histogram = stall_time.Delta("async", "serialize");
+  EXPECT_FLOAT_EQ(stall_time_histogram.num(), 1.0);
+  EXPECT_GT(stall_time_histogram.sum(), 0.0);
+  EXPECT_FLOAT_EQ(stall_time.Delta("async", "encode").num(), 0.0);
+  EXPECT_FLOAT_EQ(stall_time.Delta("sync", "serialize").num(), 0.0);
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
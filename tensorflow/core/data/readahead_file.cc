@@ -0,0 +1,312 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/readahead_file.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kFileScheme[] = "file";
+constexpr char kThreadPoolName[] = "tf_data_readahead";
+
+// Returns true if `filename` is on the local file system.
+bool IsLocalFile(const std::string& filename) {
+  absl::string_view scheme, host, path;
+  io::ParseURI(filename, &scheme, &host, &path);
+  return scheme.empty() || scheme == kFileScheme;
+}
+
+// A read of `size` bytes at `offset`, whose bytes are reserved in the budget
+// of `manager`.
+struct Block {
+  Block(ReadaheadManager* manager, uint64_t offset, size_t size, bool ahead)
+      : manager(manager),
+        offset(offset),
+        size(size),
+        ahead(ahead),
+        data(size, '\0') {}
+
+  ~Block() { manager->ReleaseBytes(size); }
+
+  ReadaheadManager* const manager;
+  const uint64_t offset;
+  const size_t size;
+  // Whether the block was read ahead of the reader, rather than when the
+  // reader needed it.
+  const bool ahead;
+  std::string data;
+  // Number of bytes read, which is less than `size` at the end of the file.
+  size_t length = 0;
+  absl::Status status;
+  bool done = false;
+};
+
+// Reads a file sequentially through the blocks read ahead by a
+// `ReadaheadManager`. A read at another offset than the end of the previous
+// one drops the blocks read ahead and restarts the readahead from there.
+// Concurrent reads are serialized.
+class ReadaheadRandomAccessFile : public RandomAccessFile {
+ public:
+  ReadaheadRandomAccessFile(std::shared_ptr<ReadaheadManager> manager,
+                            std::unique_ptr<RandomAccessFile> file)
+      : manager_(std::move(manager)), file_(std::move(file)) {}
+
+  ~ReadaheadRandomAccessFile() override {
+    mutex_lock l(mu_);
+    blocks_.clear();
+    while (num_in_flight_ > 0) {
+      cond_var_.wait(l);
+    }
+  }
+
+  absl::Status Name(absl::string_view* result) const override {
+    return file_->Name(result);
+  }
+
+  absl::Status Read(uint64_t offset, size_t n, absl::string_view* result,
+                    char* scratch) const override {
+    mutex_lock l(mu_);
+    if (offset != next_offset_) {
+      ResetLocked(offset);
+    }
+    size_t copied = 0;
+    absl::Status status;
+    while (copied < n) {
+      IssueBlocksLocked(/*required_end=*/offset + n);
+      if (blocks_.empty()) {
+        status = errors::OutOfRange("Read less bytes than requested");
+        break;
+      }
+      std::shared_ptr<Block> block = blocks_.front();
+      if (!block->done) {
+        if (block->ahead) {
+          manager_->RecordStall();
+        }
+        while (!block->done) {
+          cond_var_.wait(l);
+        }
+        if (blocks_.empty() || blocks_.front() != block) {
+          // A concurrent read at another offset dropped the blocks.
+          ResetLocked(offset + copied);
+          continue;
+        }
+      }
+      const size_t block_position = offset + copied - block->offset;
+      if (block_position >= block->length) {
+        // The file ends before the block, or reading it failed.
+        status = block->status.ok()
+                     ? errors::OutOfRange("Read less bytes than requested")
+                     : block->status;
+        ResetLocked(offset + copied);
+        break;
+      }
+      const size_t bytes =
+          std::min(n - copied, block->length - block_position);
+      std::memcpy(scratch + copied, block->data.data() + block_position,
+                  bytes);
+      copied += bytes;
+      if (block_position + bytes == block->size) {
+        blocks_.pop_front();
+      }
+    }
+    next_offset_ = offset + copied;
+    *result = absl::string_view(scratch, copied);
+    return status;
+  }
+
+ private:
+  // Drops the blocks and restarts reading at `offset`.
+  void ResetLocked(uint64_t offset) const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    blocks_.clear();
+    next_offset_ = offset;
+    issue_offset_ = offset;
+  }
+
+  // Issues the reads of the blocks up to `required_end`, which the reader is
+  // waiting for, then of the blocks up to the readahead size past it if the
+  // budget has room for them. No block is issued past the end of the file.
+  void IssueBlocksLocked(uint64_t required_end) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    const int64_t block_size = manager_->block_size();
+    while (issue_offset_ < required_end && issue_offset_ < file_size_) {
+      manager_->AcquireBytes(block_size);
+      IssueBlockLocked(block_size, /*ahead=*/false);
+    }
+    const uint64_t readahead_end = required_end + manager_->readahead_bytes();
+    while (issue_offset_ < readahead_end && issue_offset_ < file_size_ &&
+           manager_->TryAcquireBytes(block_size)) {
+      IssueBlockLocked(block_size, /*ahead=*/true);
+    }
+  }
+
+  void IssueBlockLocked(int64_t block_size, bool ahead) const
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    auto block = std::make_shared<Block>(manager_.get(), issue_offset_,
+                                         block_size, ahead);
+    blocks_.push_back(block);
+    issue_offset_ += block_size;
+    ++num_in_flight_;
+    manager_->Schedule([this, block = std::move(block)]() mutable {
+      absl::string_view data;
+      absl::Status status =
+          file_->Read(block->offset, block->size, &data, block->data.data());
+      if (data.data() != block->data.data()) {
+        std::memmove(block->data.data(), data.data(), data.size());
+      }
+      mutex_lock l(mu_);
+      block->length = data.size();
+      if (errors::IsOutOfRange(status)) {
+        file_size_ = std::min(file_size_, block->offset + data.size());
+      } else {
+        block->status = status;
+      }
+      block->done = true;
+      // Releases the block before the destructor can return, since the file
+      // keeps the manager alive.
+      block.reset();
+      --num_in_flight_;
+      cond_var_.notify_all();
+    });
+  }
+
+  const std::shared_ptr<ReadaheadManager> manager_;
+  const std::unique_ptr<RandomAccessFile> file_;
+
+  mutable mutex mu_;
+  mutable condition_variable cond_var_;
+  // Blocks issued from the offset of the next read, in order.
+  mutable std::deque<std::shared_ptr<Block>> blocks_ TF_GUARDED_BY(mu_);
+  // Offset at which the next read is expected.
+  mutable uint64_t next_offset_ TF_GUARDED_BY(mu_) = 0;
+  // Offset of the next block to issue.
+  mutable uint64_t issue_offset_ TF_GUARDED_BY(mu_) = 0;
+  // Size of the file, once a read reached its end.
+  mutable uint64_t file_size_ TF_GUARDED_BY(mu_) =
+      std::numeric_limits<uint64_t>::max();
+  mutable int64_t num_in_flight_ TF_GUARDED_BY(mu_) = 0;
+};
+
+}  // namespace
+
+ReadaheadManager::ReadaheadManager(
+    Env* env, const Options& options,
+    std::shared_ptr<model::SharedState> readahead_bytes,
+    std::shared_ptr<model::RamBudgetManager> ram_budget_manager)
+    : options_(options),
+      ram_budget_manager_(std::move(ram_budget_manager)),
+      readahead_bytes_(std::move(readahead_bytes)),
+      thread_pool_(env, kThreadPoolName, options.num_threads) {}
+
+ReadaheadManager::~ReadaheadManager() {
+  mutex_lock l(mu_);
+  if (ram_budget_manager_ && ram_budget_bytes_ > 0) {
+    ram_budget_manager_->RequestLegacyPrefetchBytes(-ram_budget_bytes_);
+  }
+}
+
+std::shared_ptr<model::SharedState> ReadaheadManager::MakeReadaheadBytes(
+    const Options& options) {
+  return std::make_shared<model::SharedState>(
+      options.block_size, std::make_shared<mutex>(),
+      std::make_shared<condition_variable>());
+}
+
+std::shared_ptr<model::Parameter> ReadaheadManager::MakeParameter(
+    const Options& options,
+    std::shared_ptr<model::SharedState> readahead_bytes) {
+  return model::MakeParameter(kReadaheadBytes, std::move(readahead_bytes),
+                              /*min=*/options.block_size,
+                              /*max=*/options.max_readahead_bytes);
+}
+
+std::unique_ptr<RandomAccessFile> ReadaheadManager::MaybeWrap(
+    const std::shared_ptr<ReadaheadManager>& manager,
+    const std::string& filename, std::unique_ptr<RandomAccessFile> file) {
+  if (manager == nullptr || IsLocalFile(filename)) {
+    return file;
+  }
+  return std::make_unique<ReadaheadRandomAccessFile>(manager, std::move(file));
+}
+
+int64_t ReadaheadManager::readahead_bytes() const {
+  tf_shared_lock l(*readahead_bytes_->mu);
+  return static_cast<int64_t>(readahead_bytes_->value);
+}
+
+bool ReadaheadManager::TryAcquireBytes(int64_t bytes) {
+  mutex_lock l(mu_);
+  if (buffered_bytes_ + bytes > options_.max_buffered_bytes) {
+    return false;
+  }
+  if (ram_budget_manager_ && buffered_bytes_ + bytes > ram_budget_bytes_) {
+    // Like `PrefetchAutotuner`, keeps the RAM it got for later reads.
+    const int64_t delta = buffered_bytes_ + bytes - ram_budget_bytes_;
+    if (!ram_budget_manager_->RequestLegacyPrefetchBytes(delta)) {
+      return false;
+    }
+    ram_budget_bytes_ += delta;
+  }
+  buffered_bytes_ += bytes;
+  return true;
+}
+
+void ReadaheadManager::AcquireBytes(int64_t bytes) {
+  mutex_lock l(mu_);
+  buffered_bytes_ += bytes;
+}
+
+void ReadaheadManager::ReleaseBytes(int64_t bytes) {
+  mutex_lock l(mu_);
+  buffered_bytes_ -= bytes;
+}
+
+void ReadaheadManager::RecordStall() {
+  mutex_lock l(*readahead_bytes_->mu);
+  const double readahead_bytes = std::min<double>(
+      readahead_bytes_->value * 2, options_.max_readahead_bytes);
+  if (readahead_bytes != readahead_bytes_->value) {
+    VLOG(2) << "Increasing readahead size to " << readahead_bytes
+            << " bytes.";
+    readahead_bytes_->value = readahead_bytes;
+  }
+}
+
+void ReadaheadManager::Schedule(std::function<void()> fn) {
+  thread_pool_.Schedule(std::move(fn));
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,134 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
+#define TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
+
+namespace tensorflow {
+namespace data {
+
+// Name of the model parameter holding the readahead size in bytes.
+inline constexpr char kReadaheadBytes[] = "readahead_bytes";
+
+// Issues large asynchronous reads ahead of the readers of many files, e.g. the
+// input iterators of a parallel interleave, within a shared memory budget.
+//
+// On file systems where the latency of a read, rather than the bandwidth,
+// bounds the throughput of a reader, the readers of the wrapped files find
+// their data already read when they need it.
+//
+// Each file reads ahead `readahead_bytes()` bytes past its reader, in reads of
+// `block_size` bytes. The readahead size doubles, up to `max_readahead_bytes`,
+// every time a reader has to wait for a read, like `PrefetchAutotuner` does
+// for buffer sizes. The bytes read ahead by all files
+// are bounded by `max_buffered_bytes` and, if set, by the RAM budget of the
+// autotuning model.
+//
+// This class is thread-safe.
+class ReadaheadManager {
+ public:
+  struct Options {
+    // Size of each read.
+    int64_t block_size = 1 << 20;
+    // Maximum number of bytes each file reads ahead.
+    int64_t max_readahead_bytes = 16 << 20;
+    // Maximum number of bytes read ahead by all the files.
+    int64_t max_buffered_bytes = 256 << 20;
+    // Number of threads issuing the reads.
+    int num_threads = 16;
+  };
+
+  // `readahead_bytes` holds the readahead size, which is shared with the model
+  // parameter returned by `MakeParameter`.
+  ReadaheadManager(Env* env, const Options& options,
+                   std::shared_ptr<model::SharedState> readahead_bytes,
+                   std::shared_ptr<model::RamBudgetManager> ram_budget_manager);
+  ~ReadaheadManager();
+
+  // Returns the initial state of the readahead size: one block.
+  static std::shared_ptr<model::SharedState> MakeReadaheadBytes(
+      const Options& options);
+
+  // Returns the model parameter for the readahead size, to add to the model
+  // node of the iterator owning the manager. The parameter is not tunable by
+  // the model optimization, which does not model the time spent in reads.
+  static std::shared_ptr<model::Parameter> MakeParameter(
+      const Options& options,
+      std::shared_ptr<model::SharedState> readahead_bytes);
+
+  ReadaheadManager(const ReadaheadManager&) = delete;
+  ReadaheadManager& operator=(const ReadaheadManager&) = delete;
+
+  // Returns a file which reads `file` through this manager. Local files, which
+  // the OS already reads ahead, are returned unchanged.
+  static std::unique_ptr<RandomAccessFile> MaybeWrap(
+      const std::shared_ptr<ReadaheadManager>& manager,
+      const std::string& filename, std::unique_ptr<RandomAccessFile> file);
+
+  // Returns the number of bytes each file reads ahead.
+  int64_t readahead_bytes() const;
+
+  int64_t block_size() const { return options_.block_size; }
+
+  // Reserves `bytes` bytes of the budget for reading ahead. Returns false if
+  // the budget does not have room for them.
+  bool TryAcquireBytes(int64_t bytes);
+
+  // Reserves `bytes` bytes of the budget for a read the reader is waiting
+  // for, which is issued even if it exceeds the budget.
+  void AcquireBytes(int64_t bytes);
+
+  // Returns `bytes` bytes to the budget.
+  void ReleaseBytes(int64_t bytes);
+
+  // Records that a reader waited for a read, which means the readahead size
+  // is too small to hide the latency of the reads.
+  void RecordStall();
+
+  // Runs `fn` on the read threads.
+  void Schedule(std::function<void()> fn);
+
+ private:
+  const Options options_;
+  const std::shared_ptr<model::RamBudgetManager> ram_budget_manager_;
+  const std::shared_ptr<model::SharedState> readahead_bytes_;
+
+  mutex mu_;
+  // Bytes of the budget reserved by the files.
+  int64_t buffered_bytes_ TF_GUARDED_BY(mu_) = 0;
+  // Bytes requested from `ram_budget_manager_`.
+  int64_t ram_budget_bytes_ TF_GUARDED_BY(mu_) = 0;
+
+  // Destroyed first, so that it waits for the reads before the members they
+  // use are destroyed.
+  thread::ThreadPool thread_pool_;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_READAHEAD_FILE_H_
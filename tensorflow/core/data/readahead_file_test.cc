@@ -0,0 +1,316 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/readahead_file.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/framework/model.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/record_reader.h"
+#include "tensorflow/core/lib/io/record_writer.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tsl/platform/status_matchers.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::tsl::testing::StatusIs;
+
+constexpr char kFilename[] = "ram://readahead_file_test";
+
+// An in-memory file whose reads take `latency`, like the reads of a file on
+// network-attached storage.
+class LatencyInjectingFile : public RandomAccessFile {
+ public:
+  LatencyInjectingFile(std::string contents, absl::Duration latency)
+      : contents_(std::move(contents)), latency_(latency) {}
+
+  absl::Status Read(uint64_t offset, size_t n, absl::string_view* result,
+                    char* scratch) const override {
+    ++num_reads_;
+    Env::Default()->SleepForMicroseconds(absl::ToInt64Microseconds(latency_));
+    if (offset == fail_at_offset_) {
+      *result = absl::string_view();
+      return errors::Unavailable("Injected error");
+    }
+    if (offset >= contents_.size()) {
+      *result = absl::string_view();
+      return errors::OutOfRange("Read past the end of the file");
+    }
+    const size_t bytes = std::min(n, contents_.size() - offset);
+    contents_.copy(scratch, bytes, offset);
+    *result = absl::string_view(scratch, bytes);
+    if (bytes < n) {
+      return errors::OutOfRange("Read less bytes than requested");
+    }
+    return absl::OkStatus();
+  }
+
+  // Makes the reads at `offset` fail.
+  void FailAtOffset(uint64_t offset) { fail_at_offset_ = offset; }
+
+  int64_t num_reads() const { return num_reads_; }
+
+ private:
+  const std::string contents_;
+  const absl::Duration latency_;
+  uint64_t fail_at_offset_ = -1;
+  mutable std::atomic<int64_t> num_reads_ = 0;
+};
+
+std::string Contents(int64_t size) {
+  std::string contents(size, '\0');
+  for (int64_t i = 0; i < size; ++i) {
+    contents[i] = 'a' + (i * 7) % 26;
+  }
+  return contents;
+}
+
+ReadaheadManager::Options MakeOptions(int64_t block_size,
+                                      int64_t max_buffered_bytes) {
+  ReadaheadManager::Options options;
+  options.block_size = block_size;
+  options.max_readahead_bytes = 8 * block_size;
+  options.max_buffered_bytes = max_buffered_bytes;
+  options.num_threads = 4;
+  return options;
+}
+
+std::shared_ptr<ReadaheadManager> MakeManager(
+    int64_t block_size, int64_t max_buffered_bytes = 1 << 20,
+    std::shared_ptr<model::RamBudgetManager> ram_budget_manager = nullptr) {
+  const ReadaheadManager::Options options =
+      MakeOptions(block_size, max_buffered_bytes);
+  return std::make_shared<ReadaheadManager>(
+      Env::Default(), options, ReadaheadManager::MakeReadaheadBytes(options),
+      std::move(ram_budget_manager));
+}
+
+std::unique_ptr<RandomAccessFile> Wrap(
+    const std::shared_ptr<ReadaheadManager>& manager,
+    std::unique_ptr<RandomAccessFile> file) {
+  return ReadaheadManager::MaybeWrap(manager, kFilename, std::move(file));
+}
+
+TEST(ReadaheadFileTest, SequentialReads) {
+  const std::string contents = Contents(600);
+  auto manager = MakeManager(/*block_size=*/64);
+  std::unique_ptr<RandomAccessFile> file = Wrap(
+      manager, std::make_unique<LatencyInjectingFile>(contents,
+                                                      absl::Milliseconds(1)));
+  std::string scratch(100, '\0');
+  uint64_t offset = 0;
+  // Reads of varying sizes, crossing the block boundaries.
+  for (size_t n : {1, 10, 63, 64, 65, 100, 3, 100, 100}) {
+    absl::string_view result;
+    TF_ASSERT_OK(file->Read(offset, n, &result, scratch.data()));
+    EXPECT_EQ(result, contents.substr(offset, n));
+    offset += n;
+  }
+  // The last read ends past the end of the file.
+  absl::string_view result;
+  EXPECT_THAT(file->Read(offset, 100, &result, scratch.data()),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_EQ(result, contents.substr(offset));
+  EXPECT_THAT(file->Read(contents.size(), 100, &result, scratch.data()),
+              StatusIs(absl::StatusCode::kOutOfRange));
+  EXPECT_TRUE(result.empty());
+}
+
+TEST(ReadaheadFileTest, NonSequentialReads) {
+  const std::string contents = Contents(1000);
+  auto manager = MakeManager(/*block_size=*/64);
+  std::unique_ptr<RandomAccessFile> file = Wrap(
+      manager, std::make_unique<LatencyInjectingFile>(contents,
+                                                      absl::ZeroDuration()));
+  std::string scratch(100, '\0');
+  for (uint64_t offset : {500, 0, 10, 900, 899, 300, 364}) {
+    absl::string_view result;
+    TF_ASSERT_OK(file->Read(offset, 100, &result, scratch.data()));
+    EXPECT_EQ(result, contents.substr(offset, 100));
+  }
+}
+
+TEST(ReadaheadFileTest, ReadsAhead) {
+  const std::string contents = Contents(64 * 100);
+  auto manager = MakeManager(/*block_size=*/64);
+  auto base_file = std::make_unique<LatencyInjectingFile>(
+      contents, absl::Milliseconds(1));
+  LatencyInjectingFile* base_file_ptr = base_file.get();
+  std::unique_ptr<RandomAccessFile> file = Wrap(manager, std::move(base_file));
+
+  std::string scratch(16, '\0');
+  absl::string_view result;
+  // The reader catches up with the readahead, which doubles the readahead
+  // size up to its maximum.
+  for (uint64_t offset = 0; offset < contents.size(); offset += 16) {
+    TF_ASSERT_OK(file->Read(offset, 16, &result, scratch.data()));
+    EXPECT_EQ(result, contents.substr(offset, 16));
+  }
+  EXPECT_GT(manager->readahead_bytes(), 64);
+  EXPECT_LE(manager->readahead_bytes(), 8 * 64);
+  // Each block is read once.
+  EXPECT_LE(base_file_ptr->num_reads(), 100 + 8);
+}
+
+TEST(ReadaheadFileTest, ReadError) {
+  const std::string contents = Contents(1000);
+  auto manager = MakeManager(/*block_size=*/64);
+  auto base_file = std::make_unique<LatencyInjectingFile>(
+      contents, absl::ZeroDuration());
+  base_file->FailAtOffset(128);
+  std::unique_ptr<RandomAccessFile> file = Wrap(manager, std::move(base_file));
+  std::string scratch(200, '\0');
+  absl::string_view result;
+  EXPECT_THAT(file->Read(100, 100, &result, scratch.data()),
+              StatusIs(absl::StatusCode::kUnavailable));
+  EXPECT_EQ(result, contents.substr(100, 28));
+}
+
+TEST(ReadaheadFileTest, SharedBudget) {
+  auto manager = MakeManager(/*block_size=*/64, /*max_buffered_bytes=*/128);
+  EXPECT_TRUE(manager->TryAcquireBytes(64));
+  EXPECT_TRUE(manager->TryAcquireBytes(64));
+  EXPECT_FALSE(manager->TryAcquireBytes(64));
+  manager->ReleaseBytes(64);
+  EXPECT_TRUE(manager->TryAcquireBytes(64));
+  manager->ReleaseBytes(128);
+}
+
+TEST(ReadaheadFileTest, RamBudget) {
+  auto ram_budget_manager = std::make_shared<model::RamBudgetManager>(100);
+  auto manager = MakeManager(/*block_size=*/64, /*max_buffered_bytes=*/1 << 20,
+                             ram_budget_manager);
+  EXPECT_TRUE(manager->TryAcquireBytes(64));
+  EXPECT_FALSE(manager->TryAcquireBytes(64));
+  EXPECT_EQ(ram_budget_manager->AvailableModelRam(), 36);
+  manager->ReleaseBytes(64);
+  manager.reset();
+  EXPECT_EQ(ram_budget_manager->AvailableModelRam(), 100);
+}
+
+TEST(ReadaheadFileTest, ReadaheadParameter) {
+  const ReadaheadManager::Options options =
+      MakeOptions(/*block_size=*/64, /*max_buffered_bytes=*/1 << 20);
+  std::shared_ptr<model::SharedState> readahead_bytes =
+      ReadaheadManager::MakeReadaheadBytes(options);
+  auto manager = std::make_shared<ReadaheadManager>(
+      Env::Default(), options, readahead_bytes, /*ram_budget_manager=*/nullptr);
+  std::shared_ptr<model::Parameter> parameter =
+      ReadaheadManager::MakeParameter(options, readahead_bytes);
+  EXPECT_EQ(parameter->name, kReadaheadBytes);
+  EXPECT_EQ(parameter->value, 64);
+  EXPECT_FALSE(parameter->state->tunable);
+  manager->RecordStall();
+  EXPECT_EQ(manager->readahead_bytes(), 128);
+  EXPECT_EQ(parameter->state->value, 128);
+}
+
+TEST(ReadaheadFileTest, DoesNotWrapLocalFiles) {
+  auto manager = MakeManager(/*block_size=*/64);
+  auto base_file = std::make_unique<LatencyInjectingFile>(
+      Contents(10), absl::ZeroDuration());
+  RandomAccessFile* base_file_ptr = base_file.get();
+  EXPECT_EQ(ReadaheadManager::MaybeWrap(manager, "/tmp/file",
+                                        std::move(base_file))
+                .get(),
+            base_file_ptr);
+}
+
+TEST(ReadaheadFileTest, RecordReader) {
+  std::string filename;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  {
+    std::unique_ptr<WritableFile> file;
+    TF_ASSERT_OK(Env::Default()->NewWritableFile(filename, &file));
+    io::RecordWriter writer(file.get());
+    for (int i = 0; i < 100; ++i) {
+      TF_ASSERT_OK(writer.WriteRecord(std::string(i * 10, 'a' + i % 26)));
+    }
+    TF_ASSERT_OK(writer.Close());
+  }
+  std::string contents;
+  TF_ASSERT_OK(ReadFileToString(Env::Default(), filename, &contents));
+
+  auto manager = MakeManager(/*block_size=*/256);
+  std::unique_ptr<RandomAccessFile> file = Wrap(
+      manager, std::make_unique<LatencyInjectingFile>(contents,
+                                                      absl::ZeroDuration()));
+  io::SequentialRecordReader reader(file.get());
+  for (int i = 0; i < 100; ++i) {
+    tstring record;
+    TF_ASSERT_OK(reader.ReadRecord(&record));
+    EXPECT_EQ(record, std::string(i * 10, 'a' + i % 26));
+  }
+  tstring record;
+  EXPECT_THAT(reader.ReadRecord(&record),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+constexpr int64_t kBenchmarkFileSize = 8 << 20;
+constexpr int64_t kBenchmarkReadSize = 256 << 10;
+
+// Reads a file with 1ms read latency in reads of `kBenchmarkReadSize` bytes,
+// like `io::RecordReader` does.
+void ReadFile(::testing::benchmark::State& state, bool readahead) {
+  const std::string contents = Contents(kBenchmarkFileSize);
+  std::string scratch(kBenchmarkReadSize, '\0');
+  for (auto s : state) {
+    std::unique_ptr<RandomAccessFile> file =
+        std::make_unique<LatencyInjectingFile>(contents,
+                                               absl::Milliseconds(1));
+    if (readahead) {
+      file = Wrap(MakeManager(/*block_size=*/1 << 20,
+                              /*max_buffered_bytes=*/64 << 20),
+                  std::move(file));
+    }
+    absl::string_view result;
+    for (int64_t offset = 0; offset < kBenchmarkFileSize;
+         offset += kBenchmarkReadSize) {
+      TF_CHECK_OK(
+          file->Read(offset, kBenchmarkReadSize, &result, scratch.data()));
+    }
+  }
+  state.SetBytesProcessed(state.iterations() * kBenchmarkFileSize);
+}
+
+void BM_ReadFileDirectly(::testing::benchmark::State& state) {
+  ReadFile(state, /*readahead=*/false);
+}
+
+void BM_ReadFileWithReadahead(::testing::benchmark::State& state) {
+  ReadFile(state, /*readahead=*/true);
+}
+
+BENCHMARK(BM_ReadFileDirectly);
+BENCHMARK(BM_ReadFileWithReadahead);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
@@ -15,24 +15,34 @@ limitations under the License.
 #include "tensorflow/core/data/serialization_utils.h"
 
 #include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
 #include "tensorflow/core/common_runtime/graph_constructor.h"
 #include "tensorflow/core/common_runtime/graph_runner.h"
 #include "tensorflow/core/data/compression_utils.h"
 #include "tensorflow/core/data/dataset_utils.h"
+#include "tensorflow/core/data/metric_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/dataset.pb.h"
 #include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/framework/variant_op_registry.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/graph/graph_def_builder.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/stringpiece.h"
 
 namespace tensorflow {
@@ -46,6 +56,97 @@ constexpr char kNumElements[] = "num_elements";
 constexpr char kIsDataset[] = ".is_dataset";
 constexpr char kIteratorVariantTypeName[] = "tensorflow::Iterator";
 constexpr char kOutputNode[] = ".output_node";
+constexpr char kSegmentFileSuffix[] = ".segment";
+constexpr char kSegmentReferenceTypeName[] =
+    "tensorflow::data::IteratorStateSegmentReference";
+
+// Compresses `tensors` into a scalar `CompressedElement` tensor.
+absl::StatusOr<Tensor> CompressSegment(const std::vector<Tensor>& tensors) {
+  CompressedElement compressed_tensors;
+  TF_RETURN_IF_ERROR(CompressElement(tensors, &compressed_tensors));
+  Tensor tensor(DT_VARIANT, TensorShape({}));
+  tensor.scalar<Variant>()() = std::move(compressed_tensors);
+  return tensor;
+}
+
+// Returns true if `tensor` is compressed into its own segment, which can be
+// reused by the next checkpoint.
+bool IsReusable(const Tensor& tensor) {
+  if (!DataTypeCanUseMemcpy(tensor.dtype()) && tensor.dtype() != DT_STRING) {
+    return false;
+  }
+  return tensor.IsInitialized() && tensor.NumElements() > 0 &&
+         tensor.TotalBytes() >=
+             AsyncIteratorStateEncoder::kMinReusedSegmentBytes;
+}
+
+// Returns the fingerprint of the type, shape and contents of `tensor`.
+Fprint128 TensorFingerprint(const Tensor& tensor) {
+  Fprint128 fingerprint = Fingerprint128(tensor.shape().DebugString());
+  fingerprint = tsl::FingerprintCat128(fingerprint, tensor.dtype());
+  if (tensor.dtype() != DT_STRING) {
+    return tsl::FingerprintCat128(fingerprint,
+                                  Fingerprint128(tensor.tensor_data()));
+  }
+  auto elements = tensor.flat<tstring>();
+  for (int64_t i = 0; i < elements.size(); ++i) {
+    fingerprint = tsl::FingerprintCat128(
+        fingerprint, Fingerprint128(absl::string_view(elements(i).data(),
+                                                      elements(i).size())));
+  }
+  return fingerprint;
+}
+
+// Returns the name of the segment file whose contents have `fingerprint`.
+std::string SegmentFileName(const Fprint128& fingerprint) {
+  return absl::StrCat(absl::Hex(fingerprint.high64, absl::kZeroPad16),
+                      absl::Hex(fingerprint.low64, absl::kZeroPad16),
+                      kSegmentFileSuffix);
+}
+
+// Reference to a segment of an iterator state written to a file by
+// `AsyncIteratorStateEncoder`, which is stored in checkpoints in place of the
+// segment.
+struct SegmentReference {
+  static std::string TypeName() { return kSegmentReferenceTypeName; }
+
+  void Encode(VariantTensorData* data) const {
+    data->set_type_name(TypeName());
+    data->set_metadata(path);
+  }
+
+  bool Decode(VariantTensorData data) {
+    if (data.type_name() != TypeName()) {
+      return false;
+    }
+    path = std::move(data.metadata_string());
+    return true;
+  }
+
+  std::string DebugString() const {
+    return absl::StrCat("SegmentReference<", path, ">");
+  }
+
+  // Path of the file with the serialized `CompressedElement`.
+  std::string path;
+};
+
+// Reads the segment referenced by `reference`, and checks that its contents
+// match the fingerprint in the name of its file.
+absl::StatusOr<CompressedElement> ReadSegment(
+    const SegmentReference& reference) {
+  std::string contents;
+  TF_RETURN_IF_ERROR(
+      ReadFileToString(Env::Default(), reference.path, &contents));
+  CompressedElement segment;
+  if (SegmentFileName(Fingerprint128(contents)) !=
+          io::Basename(reference.path) ||
+      !segment.ParseFromString(contents)) {
+    return errors::DataLoss("Iterator checkpoint segment ", reference.path,
+                            " is corrupted.");
+  }
+  return segment;
+}
 
 Status FromGraphDef(FunctionLibraryRuntime* flr, const GraphDef& graph_def,
                     const std::vector<std::pair<string, Tensor>>& input_list,
@@ -447,7 +548,8 @@ std::string IteratorStateVariant::TypeName() {
   return kIteratorVariantTypeName;
 }
 
-IteratorStateVariant::IteratorStateVariant(const IteratorStateVariant& other) {
+IteratorStateVariant::IteratorStateVariant(const IteratorStateVariant& other)
+    : async_encoding_(other.async_encoding_) {
   if (other.data_) {
     data_ = std::make_unique<VariantTensorData>(*other.data_);
   }
@@ -460,19 +562,29 @@ Status IteratorStateVariant::InitializeFromVariantData(
 }
 
 void IteratorStateVariant::Encode(VariantTensorData* data) const {
-  CompressedElement compressed_tensors;
-  Status s = CompressElement(data_->tensors(), &compressed_tensors);
-  if (!s.ok()) {
-    LOG(WARNING) << "Failed to compress iterator state variant: " << s;
+  CheckpointMetricsCollector metrics_collector(
+      /*async=*/async_encoding_ != nullptr,
+      CheckpointMetricsCollector::Stage::kEncode, *Env::Default());
+  const absl::Time start_time = metrics_collector.RecordStart();
+  if (async_encoding_) {
+    async_encoding_->done.WaitForNotification();
+    *data = async_encoding_->data;
+    metrics_collector.RecordStop(start_time);
+    return;
+  }
+
+  absl::StatusOr<Tensor> compressed = CompressSegment(data_->tensors());
+  if (!compressed.ok()) {
+    LOG(WARNING) << "Failed to compress iterator state variant: "
+                 << compressed.status();
     *data = *data_;
     return;
   }
 
   data->set_type_name(TypeName());
   data->set_metadata(data_->metadata_string());
-  Tensor tensor(DT_VARIANT, TensorShape({}));
-  tensor.scalar<Variant>()() = std::move(compressed_tensors);
-  *data->add_tensors() = std::move(tensor);
+  *data->add_tensors() = *std::move(compressed);
+  metrics_collector.RecordStop(start_time);
 }
 
 bool IteratorStateVariant::Decode(VariantTensorData data) {
@@ -480,18 +592,31 @@ bool IteratorStateVariant::Decode(VariantTensorData data) {
     return false;
   }
 
-  const CompressedElement* compressed = GetCompressedElement(data);
-  if (!compressed) {
+  std::deque<CompressedElement> referenced;
+  absl::StatusOr<std::vector<const CompressedElement*>> compressed =
+      GetCompressedElements(data, &referenced);
+  if (!compressed.ok()) {
+    LOG(ERROR) << "Failed to read iterator state variant: "
+               << compressed.status();
+    return false;
+  }
+  if (compressed->empty()) {
     data_ = std::make_unique<VariantTensorData>(std::move(data));
     return true;
   }
 
   std::vector<Tensor> tensors;
-  Status s = UncompressElement(*compressed, &tensors);
-  if (!s.ok()) {
-    LOG(WARNING) << "Failed to uncompress iterator state variant: " << s;
-    data_ = std::make_unique<VariantTensorData>(std::move(data));
-    return true;
+  for (const CompressedElement* segment : *compressed) {
+    std::vector<Tensor> segment_tensors;
+    Status s = UncompressElement(*segment, &segment_tensors);
+    if (!s.ok()) {
+      LOG(WARNING) << "Failed to uncompress iterator state variant: " << s;
+      data_ = std::make_unique<VariantTensorData>(std::move(data));
+      return true;
+    }
+    for (auto& tensor : segment_tensors) {
+      tensors.push_back(std::move(tensor));
+    }
   }
 
   data_ = std::make_unique<VariantTensorData>();
@@ -503,18 +628,35 @@ bool IteratorStateVariant::Decode(VariantTensorData data) {
   return true;
 }
 
-const CompressedElement* IteratorStateVariant::GetCompressedElement(
-    const VariantTensorData& data) {
-  bool should_uncompress =
-      data.tensors_size() == 1 &&
-      TensorShapeUtils::IsScalar(data.tensors(0).shape()) &&
-      data.tensors(0).dtype() == DT_VARIANT;
-  if (!should_uncompress) {
-    return nullptr;
+absl::StatusOr<std::vector<const CompressedElement*>>
+IteratorStateVariant::GetCompressedElements(
+    const VariantTensorData& data, std::deque<CompressedElement>* referenced) {
+  std::vector<const CompressedElement*> compressed;
+  std::vector<const SegmentReference*> references;
+  for (const Tensor& tensor : data.tensors()) {
+    if (!TensorShapeUtils::IsScalar(tensor.shape()) ||
+        tensor.dtype() != DT_VARIANT) {
+      return std::vector<const CompressedElement*>();
+    }
+    const Variant& variant = tensor.scalar<Variant>()();
+    const CompressedElement* element = variant.get<CompressedElement>();
+    const SegmentReference* reference = variant.get<SegmentReference>();
+    if (element == nullptr && reference == nullptr) {
+      return std::vector<const CompressedElement*>();
+    }
+    compressed.push_back(element);
+    references.push_back(reference);
+  }
+  // Only read the referenced segments once `data` is known to be compressed.
+  for (int i = 0; i < compressed.size(); ++i) {
+    if (references[i] != nullptr) {
+      TF_ASSIGN_OR_RETURN(CompressedElement segment,
+                          ReadSegment(*references[i]));
+      referenced->push_back(std::move(segment));
+      compressed[i] = &referenced->back();
+    }
   }
-
-  const Variant& variant = data.tensors(0).scalar<Variant>()();
-  return variant.get<CompressedElement>();
+  return compressed;
 }
 
 std::string IteratorStateVariant::DebugString() const {
@@ -525,6 +667,122 @@ std::string IteratorStateVariant::DebugString() const {
   }
 }
 
+AsyncIteratorStateEncoder::AsyncIteratorStateEncoder(
+    Env* env, absl::string_view segment_dir)
+    : env_(env),
+      segment_dir_(segment_dir),
+      thread_pool_(std::make_unique<thread::ThreadPool>(
+          env, ThreadOptions(), "tf_data_async_checkpoint",
+          /*num_threads=*/1)) {}
+
+void AsyncIteratorStateEncoder::EncodeAsync(IteratorStateVariant& variant) {
+  auto encoding = std::make_shared<IteratorStateVariant::AsyncEncoding>();
+  variant.async_encoding_ = encoding;
+  // Copying the data only copies references to its tensors.
+  thread_pool_->Schedule([this, data = *variant.data_, encoding]() {
+    Encode(data, &encoding->data);
+    encoding->done.Notify();
+  });
+}
+
+void AsyncIteratorStateEncoder::Encode(const VariantTensorData& data,
+                                       VariantTensorData* encoded) {
+  absl::StatusOr<std::vector<Tensor>> segments =
+      CompressSegments(data.tensors());
+  if (!segments.ok()) {
+    LOG(WARNING) << "Failed to compress iterator state variant: "
+                 << segments.status();
+    *encoded = data;
+    return;
+  }
+  encoded->set_type_name(IteratorStateVariant::TypeName());
+  encoded->set_metadata(data.metadata_string());
+  for (Tensor& segment : *segments) {
+    *encoded->add_tensors() = std::move(segment);
+  }
+}
+
+absl::StatusOr<std::vector<Tensor>> AsyncIteratorStateEncoder::CompressSegments(
+    const std::vector<Tensor>& tensors) {
+  std::vector<Tensor> segments;
+  std::vector<Tensor> run;
+  int64_t run_bytes = 0;
+  auto flush_run = [&]() -> Status {
+    if (run.empty()) {
+      return absl::OkStatus();
+    }
+    TF_ASSIGN_OR_RETURN(Tensor compressed, CompressSegment(run));
+    segments.push_back(std::move(compressed));
+    metrics::RecordTFDataCheckpointBytes(/*reused=*/false, run_bytes);
+    run.clear();
+    run_bytes = 0;
+    return absl::OkStatus();
+  };
+
+  mutex_lock l(mu_);
+  absl::flat_hash_map<Fprint128, Tensor, Fprint128Hasher> new_segments;
+  for (const Tensor& tensor : tensors) {
+    if (!IsReusable(tensor)) {
+      run.push_back(tensor);
+      run_bytes += tensor.TotalBytes();
+      continue;
+    }
+    TF_RETURN_IF_ERROR(flush_run());
+    const Fprint128 fingerprint = TensorFingerprint(tensor);
+    auto segment = new_segments.find(fingerprint);
+    if (segment == new_segments.end()) {
+      auto previous = segments_.find(fingerprint);
+      if (previous != segments_.end()) {
+        segment = new_segments.insert(*previous).first;
+      }
+    }
+    if (segment != new_segments.end()) {
+      metrics::RecordTFDataCheckpointBytes(/*reused=*/true,
+                                           tensor.TotalBytes());
+      segments.push_back(segment->second);
+      continue;
+    }
+    TF_ASSIGN_OR_RETURN(Tensor compressed, CompressReusableSegment(tensor));
+    metrics::RecordTFDataCheckpointBytes(/*reused=*/false,
+                                         tensor.TotalBytes());
+    segments.push_back(compressed);
+    new_segments[fingerprint] = std::move(compressed);
+  }
+  TF_RETURN_IF_ERROR(flush_run());
+  segments_ = std::move(new_segments);
+  return segments;
+}
+
+absl::StatusOr<Tensor> AsyncIteratorStateEncoder::CompressReusableSegment(
+    const Tensor& tensor) {
+  if (segment_dir_.empty()) {
+    return CompressSegment({tensor});
+  }
+  CompressedElement segment;
+  TF_RETURN_IF_ERROR(CompressElement({tensor}, &segment));
+  std::string contents;
+  if (!segment.SerializeToString(&contents)) {
+    return errors::Internal("Failed to serialize iterator checkpoint segment.");
+  }
+  SegmentReference reference;
+  reference.path = io::JoinPath(segment_dir_,
+                                SegmentFileName(Fingerprint128(contents)));
+  // The file name identifies its contents, so an existing file is complete.
+  if (!env_->FileExists(reference.path).ok()) {
+    TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(segment_dir_));
+    std::string temp_path = reference.path;
+    if (!env_->CreateUniqueFileName(&temp_path, ".tmp")) {
+      return errors::Internal("Failed to create a temporary file name for ",
+                              reference.path);
+    }
+    TF_RETURN_IF_ERROR(WriteStringToFile(env_, temp_path, contents));
+    TF_RETURN_IF_ERROR(env_->RenameFile(temp_path, reference.path));
+  }
+  Tensor result(DT_VARIANT, TensorShape({}));
+  result.scalar<Variant>()() = std::move(reference);
+  return result;
+}
+
 // Register the reader class in the global variant decode_fn registry
 // so that a Variant containing a serialized representation of iterator state
 // can be decoded using DecodeUnaryVariant. If we don't do this we will need
@@ -532,6 +790,8 @@ std::string IteratorStateVariant::DebugString() const {
 // DeserializeIteratorOp which is not recommended.
 REGISTER_UNARY_VARIANT_DECODE_FUNCTION(IteratorStateVariant,
                                        kIteratorVariantTypeName);
+REGISTER_UNARY_VARIANT_DECODE_FUNCTION(SegmentReference,
+                                       kSegmentReferenceTypeName);
 
 Status AsGraphDefForRewrite(OpKernelContext* ctx, const DatasetBase* input,
                             std::vector<std::pair<string, Tensor>>* input_list,
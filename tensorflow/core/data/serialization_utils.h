@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_CORE_DATA_SERIALIZATION_UTILS_H_
 
 #include <cstdint>
+#include <deque>
 #include <map>
 #include <memory>
 #include <string>
@@ -25,10 +26,17 @@ limitations under the License.
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/notification.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/dataset.pb.h"
+#include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/lib/core/status.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/platform/threadpool.h"
 #include "tsl/platform/statusor.h"
 
 namespace tensorflow {
@@ -187,23 +195,105 @@ class IteratorStateVariant {
 
   // Encodes this `IteratorStateVariant` into `*data`. Data will be compressed
   // and stored as a scalar `CompressedElement` tensor, or left uncompressed if
-  // compression fails.
+  // compression fails. If the encoding was started in the background by
+  // `AsyncIteratorStateEncoder`, waits for it to finish instead.
   void Encode(VariantTensorData* data) const;
 
-  // Decodes from `data`. If `data` contains a single scalar `CompressedElement`
-  // tensor, it is assumed to be compressed by `Encode`, and will be
-  // uncompressed as part of `Decode`.
+  // Decodes from `data`. If `data` only contains scalar `CompressedElement`
+  // tensors, or references to segments written by `AsyncIteratorStateEncoder`,
+  // they are assumed to be compressed by `Encode`, and will be read,
+  // uncompressed and concatenated as part of `Decode`. Returns false if a
+  // referenced segment cannot be read.
   bool Decode(VariantTensorData data);
 
   std::string DebugString() const;
 
  private:
-  // Returns the compressed element in `data`. If `data` does not contain a
-  // compressed element, returns nullptr.
-  static const CompressedElement* GetCompressedElement(
-      const VariantTensorData& data);
+  friend class AsyncIteratorStateEncoder;
+
+  // Result of encoding the state in the background, shared by the copies of
+  // the variant.
+  struct AsyncEncoding {
+    absl::Notification done;
+    VariantTensorData data;
+  };
+
+  // Returns the compressed elements in `data`. The elements referenced by
+  // `data` are read into `referenced`. If `data` does not only contain
+  // compressed elements or references, returns an empty vector.
+  static absl::StatusOr<std::vector<const CompressedElement*>>
+  GetCompressedElements(const VariantTensorData& data,
+                        std::deque<CompressedElement>* referenced);
 
   std::unique_ptr<VariantTensorData> data_;
+  std::shared_ptr<AsyncEncoding> async_encoding_;
+};
+
+// Encodes `IteratorStateVariant`s on a background thread, so that saving an
+// iterator does not block on the compression of its state. Since tensors are
+// refcounted and tf.data does not modify them once produced, the variants
+// only need to hold references to the tensors of the state while they are
+// compressed.
+//
+// The encoding is incremental: each tensor of at least
+// `kMinReusedSegmentBytes` is compressed into its own segment, which is reused
+// by the next checkpoint if it still contains a tensor with the same
+// fingerprint (e.g. an element which stayed in a shuffle buffer). The other
+// tensors are compressed in runs of consecutive tensors. The encoder only
+// keeps the encoded segments of the last checkpoint, not its tensors.
+//
+// If `segment_dir` is not empty, each reusable segment is written once to a
+// file in `segment_dir`, and the checkpoints only store references to these
+// files. A checkpoint then only writes the segments which changed since the
+// previous checkpoints. The files are named after the fingerprints of their
+// contents, so they may be shared by the iterators of several jobs, and they
+// are not deleted by the encoder: remove them along with the checkpoints.
+//
+// Usage example:
+//
+//   AsyncIteratorStateEncoder encoder(env);
+//   IteratorStateVariant variant;
+//   TF_RETURN_IF_ERROR(variant.InitializeFromVariantData(std::move(data)));
+//   encoder.EncodeAsync(variant);
+//   ...
+//   variant.Encode(&encoded);  // Waits for the background encoding.
+//
+// This class is thread-safe.
+class AsyncIteratorStateEncoder {
+ public:
+  static constexpr int64_t kMinReusedSegmentBytes = 64 << 10;  // 64 KiB
+
+  explicit AsyncIteratorStateEncoder(Env* env)
+      : AsyncIteratorStateEncoder(env, /*segment_dir=*/"") {}
+  AsyncIteratorStateEncoder(Env* env, absl::string_view segment_dir);
+
+  // Starts encoding `variant` in the background. Variants are encoded in the
+  // order of the calls.
+  void EncodeAsync(IteratorStateVariant& variant);
+
+ private:
+  // Encodes the tensors of `data` into `encoded`.
+  void Encode(const VariantTensorData& data, VariantTensorData* encoded);
+
+  // Compresses `tensors` into a list of scalar variant tensors, reusing the
+  // segments of the previous checkpoint.
+  absl::StatusOr<std::vector<Tensor>> CompressSegments(
+      const std::vector<Tensor>& tensors) TF_LOCKS_EXCLUDED(mu_);
+
+  // Compresses the reusable `tensor` into a scalar variant tensor, holding
+  // either a `CompressedElement` or a reference to the file in `segment_dir_`
+  // where the `CompressedElement` is written.
+  absl::StatusOr<Tensor> CompressReusableSegment(const Tensor& tensor);
+
+  Env* const env_;
+  const std::string segment_dir_;
+  mutex mu_;
+  // Reusable segments of the last encoded checkpoint, keyed by the
+  // fingerprints of their tensors.
+  absl::flat_hash_map<Fprint128, Tensor, Fprint128Hasher> segments_
+      TF_GUARDED_BY(mu_);
+  // Single thread, so that segments are reused in the order of checkpoints.
+  std::unique_ptr<thread::ThreadPool> thread_pool_;
 };
 
 // Returns a GraphDef representation of the given dataset.
@@ -34,10 +34,14 @@ limitations under the License.
 #include "tensorflow/core/framework/op.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/tensor_util.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/framework/variant_tensor_data.h"
 #include "tensorflow/core/framework/variant.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/path.h"
 #include "tensorflow/core/platform/str_util.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/error_codes.pb.h"
@@ -196,6 +200,21 @@ class ParameterizedIteratorStateVariantTest
     return *decoder.GetData();
   }
 
+  absl::StatusOr<VariantTensorData> EncodeAsyncAndDecode(
+      const VariantTensorData& data) const {
+    AsyncIteratorStateEncoder async_encoder(Env::Default());
+    IteratorStateVariant encoder;
+    TF_RETURN_IF_ERROR(encoder.InitializeFromVariantData(
+        std::make_unique<VariantTensorData>(data)));
+    async_encoder.EncodeAsync(encoder);
+    VariantTensorData encoded_data;
+    encoder.Encode(&encoded_data);
+
+    IteratorStateVariant decoder;
+    decoder.Decode(encoded_data);
+    return *decoder.GetData();
+  }
+
   absl::StatusOr<VariantTensorData> DecodeUncompressed(
       const VariantTensorData& data) const {
     IteratorStateVariant decoder;
@@ -249,6 +268,17 @@ TEST_P(ParameterizedIteratorStateVariantTest, EncodeAndDecode) {
   }
 }
 
+TEST_P(ParameterizedIteratorStateVariantTest, EncodeAsyncAndDecode) {
+  VariantTensorData data = GetVariantTensorData();
+  TF_ASSERT_OK_AND_ASSIGN(VariantTensorData result, EncodeAsyncAndDecode(data));
+
+  EXPECT_EQ(result.type_name(), data.type_name());
+  ASSERT_EQ(result.tensors_size(), data.tensors_size());
+  for (int i = 0; i < result.tensors_size(); ++i) {
+    test::ExpectEqual(result.tensors(i), data.tensors(i));
+  }
+}
+
 TEST_P(ParameterizedIteratorStateVariantTest, DecodeUncompressed) {
   VariantTensorData data = GetVariantTensorData();
   TF_ASSERT_OK_AND_ASSIGN(VariantTensorData result, DecodeUncompressed(data));
@@ -305,6 +335,157 @@ TEST_P(ParemeterizedCheckpointIndicesTest,
   }
 }
 
+// Encodes `tensors` with `async_encoder`, and returns the encoded data.
+VariantTensorData EncodeAsync(AsyncIteratorStateEncoder& async_encoder,
+                              const std::vector<Tensor>& tensors) {
+  auto data = std::make_unique<VariantTensorData>();
+  data->set_type_name(IteratorStateVariant::TypeName());
+  for (const Tensor& tensor : tensors) {
+    *data->add_tensors() = tensor;
+  }
+  IteratorStateVariant variant;
+  TF_CHECK_OK(variant.InitializeFromVariantData(std::move(data)));
+  async_encoder.EncodeAsync(variant);
+  VariantTensorData encoded_data;
+  variant.Encode(&encoded_data);
+  return encoded_data;
+}
+
+// Returns an int64 tensor of `num_elements` pseudo-random elements.
+Tensor CreateRandomTensor(int64_t num_elements, uint64_t seed) {
+  Tensor tensor(DT_INT64, TensorShape{num_elements});
+  auto flat = tensor.flat<int64_t>();
+  for (int64_t i = 0; i < num_elements; ++i) {
+    seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+    flat(i) = static_cast<int64_t>(seed >> 33);
+  }
+  return tensor;
+}
+
+TEST(AsyncIteratorStateEncoderTest, ReuseUnchangedSegments) {
+  AsyncIteratorStateEncoder async_encoder(Env::Default());
+  // 128 KiB tensors are compressed into their own segments.
+  Tensor unchanged = CreateRandomTensor(/*num_elements=*/16 << 10, /*seed=*/1);
+  Tensor changed = CreateRandomTensor(/*num_elements=*/16 << 10, /*seed=*/2);
+  Tensor small = CreateTensor<int64_t>(TensorShape{1}, {1});
+  VariantTensorData first =
+      EncodeAsync(async_encoder, {small, unchanged, changed});
+  // A copy of `unchanged` is reused too, since it has the same contents.
+  Tensor new_changed = CreateRandomTensor(/*num_elements=*/16 << 10,
+                                          /*seed=*/3);
+  VariantTensorData second = EncodeAsync(
+      async_encoder, {small, tensor::DeepCopy(unchanged), new_changed});
+
+  ASSERT_EQ(first.tensors_size(), 3);
+  ASSERT_EQ(second.tensors_size(), 3);
+  EXPECT_FALSE(first.tensors(0).SharesBufferWith(second.tensors(0)));
+  EXPECT_TRUE(first.tensors(1).SharesBufferWith(second.tensors(1)));
+  EXPECT_FALSE(first.tensors(2).SharesBufferWith(second.tensors(2)));
+
+  IteratorStateVariant decoder;
+  ASSERT_TRUE(decoder.Decode(second));
+  const VariantTensorData* result = decoder.GetData();
+  ASSERT_EQ(result->tensors_size(), 3);
+  test::ExpectEqual(result->tensors(0), small);
+  test::ExpectEqual(result->tensors(1), unchanged);
+  test::ExpectEqual(result->tensors(2), new_changed);
+}
+
+TEST(AsyncIteratorStateEncoderTest, WriteChangedSegmentsOnce) {
+  const std::string segment_dir =
+      io::JoinPath(testing::TmpDir(), "WriteChangedSegmentsOnce");
+  AsyncIteratorStateEncoder async_encoder(Env::Default(), segment_dir);
+  Tensor unchanged = CreateRandomTensor(/*num_elements=*/16 << 10, /*seed=*/1);
+  Tensor changed = CreateRandomTensor(/*num_elements=*/16 << 10, /*seed=*/2);
+  Tensor small = CreateTensor<int64_t>(TensorShape{1}, {1});
+  EncodeAsync(async_encoder, {small, unchanged, changed});
+  std::vector<std::string> files;
+  TF_ASSERT_OK(Env::Default()->GetChildren(segment_dir, &files));
+  EXPECT_EQ(files.size(), 2);
+
+  Tensor new_changed = CreateRandomTensor(/*num_elements=*/16 << 10,
+                                          /*seed=*/3);
+  VariantTensorData second =
+      EncodeAsync(async_encoder, {small, unchanged, new_changed});
+  files.clear();
+  TF_ASSERT_OK(Env::Default()->GetChildren(segment_dir, &files));
+  EXPECT_EQ(files.size(), 3);
+
+  // The checkpoint only stores references to the large tensors.
+  VariantTensorDataProto proto;
+  second.ToProto(&proto);
+  EXPECT_LT(proto.ByteSizeLong(), 4 << 10);
+
+  VariantTensorDataProto restored_proto;
+  ASSERT_TRUE(restored_proto.ParseFromString(proto.SerializeAsString()));
+  VariantTensorData restored(std::move(restored_proto));
+  IteratorStateVariant decoder;
+  ASSERT_TRUE(decoder.Decode(std::move(restored)));
+  const VariantTensorData* result = decoder.GetData();
+  ASSERT_EQ(result->tensors_size(), 3);
+  test::ExpectEqual(result->tensors(0), small);
+  test::ExpectEqual(result->tensors(1), unchanged);
+  test::ExpectEqual(result->tensors(2), new_changed);
+
+  // Checkpoints cannot be restored without their segments.
+  for (const std::string& file : files) {
+    TF_ASSERT_OK(Env::Default()->DeleteFile(io::JoinPath(segment_dir, file)));
+  }
+  IteratorStateVariant missing_segments_decoder;
+  EXPECT_FALSE(missing_segments_decoder.Decode(second));
+}
+
+TEST(AsyncIteratorStateEncoderTest, DoNotStallOnCompression) {
+  // 32 MiB of incompressible state.
+  std::vector<Tensor> tensors;
+  for (int i = 0; i < 32; ++i) {
+    tensors.push_back(CreateRandomTensor(/*num_elements=*/128 << 10,
+                                         /*seed=*/i));
+  }
+  auto data = std::make_unique<VariantTensorData>();
+  data->set_type_name(IteratorStateVariant::TypeName());
+  for (const Tensor& tensor : tensors) {
+    *data->add_tensors() = tensor;
+  }
+
+  IteratorStateVariant sync_variant;
+  TF_ASSERT_OK(sync_variant.InitializeFromVariantData(
+      std::make_unique<VariantTensorData>(*data)));
+  uint64_t start_us = Env::Default()->NowMicros();
+  VariantTensorData sync_encoded;
+  sync_variant.Encode(&sync_encoded);
+  const uint64_t sync_us = Env::Default()->NowMicros() - start_us;
+
+  AsyncIteratorStateEncoder async_encoder(Env::Default());
+  IteratorStateVariant async_variant;
+  TF_ASSERT_OK(async_variant.InitializeFromVariantData(std::move(data)));
+  start_us = Env::Default()->NowMicros();
+  async_encoder.EncodeAsync(async_variant);
+  const uint64_t stall_us = Env::Default()->NowMicros() - start_us;
+  VariantTensorData async_encoded;
+  async_variant.Encode(&async_encoded);
+
+  // Starting the encoding only copies references to the tensors.
+  EXPECT_LT(stall_us * 10, sync_us);
+  IteratorStateVariant decoder;
+  ASSERT_TRUE(decoder.Decode(async_encoded));
+  ASSERT_EQ(decoder.GetData()->tensors_size(), tensors.size());
+  for (int i = 0; i < tensors.size(); ++i) {
+    test::ExpectEqual(decoder.GetData()->tensors(i), tensors[i]);
+  }
+}
+
+TEST(AsyncIteratorStateEncoderTest, GroupSmallTensors) {
+  AsyncIteratorStateEncoder async_encoder(Env::Default());
+  Tensor large = CreateTensor<int64_t>(TensorShape{128, 128});
+  VariantTensorData encoded = EncodeAsync(
+      async_encoder, {CreateTensor<int64_t>(TensorShape{1}, {1}),
+                      CreateTensor<tstring>(TensorShape{1}, {"a"}), large,
+                      CreateTensor<int64_t>(TensorShape{1}, {2})});
+  // The two tensors before `large` are compressed into one segment.
+  EXPECT_EQ(encoded.tensors_size(), 3);
+}
+
 INSTANTIATE_TEST_SUITE_P(Instantiation, ParameterizedIteratorStateVariantTest,
                          ::testing::ValuesIn(TestCases()));
 
@@ -617,6 +617,7 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
   int64_t num_consecutive_skipped = 0;
   constexpr int64_t MAX_ROUND_FALLBACK_TO_BLOCKING = 5;
   bool allow_skip = true;
+  int64_t credits = 1;
 
   while (true) {
     std::shared_ptr<Result> result;
@@ -624,7 +625,7 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
       mutex_lock l(mu_);
       if (task_to_process) {
         task_to_process->in_use = false;
-        --outstanding_requests_;
+        outstanding_requests_ -= credits;
         task_to_process = nullptr;
         worker_thread_cv_.notify_one();
       }
@@ -642,7 +643,8 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
       }
       DCHECK(task_to_process != nullptr);
       task_to_process->in_use = true;
-      ++outstanding_requests_;
+      credits = IsCoordinatedRead() ? 1 : NumCredits();
+      outstanding_requests_ += credits;
       if (IsCoordinatedRead()) {
         // Reserve a spot in the results_ queue.
         results_.push(std::make_shared<Result>());
@@ -657,13 +659,13 @@ void DataServiceClient::RunWorkerThread(std::function<void()> done)
     int64_t deadline_micros = kint64max;
     Status s = GetElementTraced(task_to_process.get(), deadline_micros,
                                 /*enqueue_result=*/!IsCoordinatedRead(),
-                                allow_skip, result);
+                                allow_skip, /*max_elements=*/credits, result);
     if (!s.ok()) {
       mutex_lock l(mu_);
       VLOG(1) << "Failed to get element from worker "
               << task_to_process->info.worker_address() << ": " << s;
       task_to_process->in_use = false;
-      --outstanding_requests_;
+      outstanding_requests_ -= credits;
       status_ = errors::CreateWithUpdatedMessage(
           s, absl::StrCat("Failed to get element from worker ",
                           task_to_process->info.worker_address(), ": ",
@@ -754,9 +756,23 @@ void DataServiceClient::AdvanceTaskIndex() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
   }
 }
 
-Status DataServiceClient::TryGetElement(const Task& task, bool allow_skip,
-                                        GetElementResult& result) {
-  GetElementRequest req;
+// Returns how many elements a non-coordinated read may request from a task at
+// once: the free slots in the buffer, capped at an even split between tasks so
+// that one task can't take the whole buffer.
+int64_t DataServiceClient::NumCredits() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const int64_t free_slots = max_outstanding_requests_ -
+                             static_cast<int64_t>(results_.size()) -
+                             outstanding_requests_;
+  const int64_t fair_share =
+      max_outstanding_requests_ / std::max<int64_t>(tasks_.size(), 1);
+  return std::max<int64_t>(1, std::min(free_slots, fair_share));
+}
+
+Status DataServiceClient::TryGetElement(
+    const Task& task, bool allow_skip, int64_t max_elements,
+    std::vector<GetElementResult>& results) {
+  GetElementsRequest elements_req;
+  GetElementRequest& req = *elements_req.mutable_request();
   req.set_task_id(task.info.task_id());
   req.set_skipped_previous_round(task.skipped_previous_round);
   if (IsCoordinatedRead()) {
@@ -769,36 +785,50 @@ Status DataServiceClient::TryGetElement(const Task& task, bool allow_skip,
   if (params_.cross_trainer_cache_options) {
     req.set_trainer_id(params_.cross_trainer_cache_options->trainer_id());
   }
-  return task.worker->GetElement(req, result);
+  if (max_elements <= 1) {
+    results.emplace_back();
+    return task.worker->GetElement(req, results.back());
+  }
+  elements_req.set_max_elements(max_elements);
+  return task.worker->GetElements(elements_req, results);
 }
 
 void DataServiceClient::ProcessGetElementResponse(
-    bool enqueue_result, GetElementResult& get_element_result,
+    bool enqueue_result, std::vector<GetElementResult>& get_element_results,
     std::shared_ptr<Result> result, Task& task) TF_LOCKS_EXCLUDED(mu_) {
   mutex_lock l(mu_);
-  result->ready = true;
-  result->end_of_sequence = get_element_result.end_of_sequence;
-  result->skip = get_element_result.skip;
-  if (!get_element_result.end_of_sequence && !get_element_result.skip) {
-    task.skipped_previous_round = false;
-    result->element = std::move(get_element_result.components);
-    result->element_index = get_element_result.element_index;
-    result->task_id = task.info.task_id();
-  } else if (get_element_result.skip) {
-    task.skipped_previous_round = true;
-  } else {
-    task.end_of_sequence = true;
-    finished_tasks_++;
-  }
-  if (enqueue_result && !result->end_of_sequence && !result->skip) {
-    ctx_->RecordBufferEnqueue(result->element);
-    results_.push(std::move(result));
+  for (GetElementResult& get_element_result : get_element_results) {
+    // Only the first element has a result allocated by the caller. The others
+    // come from batched requests, which are always enqueued.
+    if (result == nullptr) {
+      result = std::make_shared<Result>();
+    }
+    result->ready = true;
+    result->end_of_sequence = get_element_result.end_of_sequence;
+    result->skip = get_element_result.skip;
+    if (!get_element_result.end_of_sequence && !get_element_result.skip) {
+      task.skipped_previous_round = false;
+      result->element = std::move(get_element_result.components);
+      result->element_index = get_element_result.element_index;
+      result->task_id = task.info.task_id();
+    } else if (get_element_result.skip) {
+      task.skipped_previous_round = true;
+    } else {
+      task.end_of_sequence = true;
+      finished_tasks_++;
+    }
+    if (enqueue_result && !result->end_of_sequence && !result->skip) {
+      ctx_->RecordBufferEnqueue(result->element);
+      results_.push(std::move(result));
+    }
+    result = nullptr;
   }
   get_next_cv_.notify_all();
 }
 
 Status DataServiceClient::GetElementTraced(Task* task, int64_t deadline_micros,
                                            bool enqueue_result, bool allow_skip,
+                                           int64_t max_elements,
                                            std::shared_ptr<Result> result)
     TF_LOCKS_EXCLUDED(mu_) {
   VLOG(3) << "Getting an element for task id " << task->info.task_id();
@@ -806,7 +836,8 @@ Status DataServiceClient::GetElementTraced(Task* task, int64_t deadline_micros,
                                   tsl::profiler::TraceMeLevel::kInfo);
   activity.AppendMetadata([&]() {
     return tsl::profiler::TraceMeEncode(
-        {{"address", task->info.worker_address()}});
+        {{"address", task->info.worker_address()},
+         {"max_elements", max_elements}});
   });
   if (IsCoordinatedRead()) {
     VLOG(3) << "Requesting element from consumer index "
@@ -817,8 +848,8 @@ Status DataServiceClient::GetElementTraced(Task* task, int64_t deadline_micros,
            {"round_index", task->round}});
     });
   }
-  Status s =
-      GetElement(task, deadline_micros, enqueue_result, allow_skip, result);
+  Status s = GetElement(task, deadline_micros, enqueue_result, allow_skip,
+                        max_elements, result);
   mutex_lock l(mu_);
   VLOG(3) << "Got an element for task id " << task->info.task_id();
   return s;
@@ -856,11 +887,14 @@ Status DataServiceClient::MaybeRemoveTask(Task& task, int64_t deadline_micros,
 
 Status DataServiceClient::GetElement(Task* task, int64_t deadline_micros,
                                      bool enqueue_result, bool allow_skip,
+                                     int64_t max_elements,
                                      std::shared_ptr<Result> result)
     TF_LOCKS_EXCLUDED(mu_) {
-  GetElementResult get_element_result;
+  std::vector<GetElementResult> get_element_results;
   while (true) {
-    Status s = TryGetElement(*task, allow_skip, get_element_result);
+    get_element_results.clear();
+    Status s = TryGetElement(*task, allow_skip, max_elements,
+                             get_element_results);
     if (s.ok()) {
       task->num_retries = 0;
       break;
@@ -917,7 +951,8 @@ Status DataServiceClient::GetElement(Task* task, int64_t deadline_micros,
       return absl::OkStatus();
     }
   }
-  ProcessGetElementResponse(enqueue_result, get_element_result, result, *task);
+  ProcessGetElementResponse(enqueue_result, get_element_results, result,
+                            *task);
   return absl::OkStatus();
 }
 
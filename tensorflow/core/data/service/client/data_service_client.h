@@ -176,17 +176,21 @@ class DataServiceClient {
   // task a chance to proceed.
   std::shared_ptr<Task> GetTaskToProcess();
   void AdvanceTaskIndex();
-  Status TryGetElement(const Task& task, bool allow_skip,
-                       GetElementResult& result);
-  void ProcessGetElementResponse(bool enqueue_result,
-                                 GetElementResult& get_element_result,
-                                 std::shared_ptr<Result> result, Task& task);
+  // Returns the number of elements a worker thread may request from a task in
+  // one call, i.e. the number of buffer slots it reserves.
+  int64_t NumCredits();
+  Status TryGetElement(const Task& task, bool allow_skip, int64_t max_elements,
+                       std::vector<GetElementResult>& results);
+  void ProcessGetElementResponse(
+      bool enqueue_result, std::vector<GetElementResult>& get_element_results,
+      std::shared_ptr<Result> result, Task& task);
   Status GetElementTraced(Task* task, int64_t deadline_micros,
                           bool enqueue_result, bool allow_skip,
-                          std::shared_ptr<Result> result);
+                          int64_t max_elements, std::shared_ptr<Result> result);
   Status MaybeRemoveTask(Task& task, int64_t deadline_micros, Result& result);
   Status GetElement(Task* task, int64_t deadline_micros, bool enqueue_result,
-                    bool allow_skip, std::shared_ptr<Result> result);
+                    bool allow_skip, int64_t max_elements,
+                    std::shared_ptr<Result> result);
   bool ResultReady() const;
   std::shared_ptr<Result> PopNextResult();
   bool IsCoordinatedRead() const;
@@ -201,7 +205,8 @@ class DataServiceClient {
 
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
 
-  // Number of outstanding requests.
+  // Number of buffer slots reserved by outstanding requests. A request which
+  // may return several elements reserves a slot for each of them.
   int64_t outstanding_requests_ TF_GUARDED_BY(mu_) = 0;
 
   // max_outstanding_requests controls how many elements may be held in memory
@@ -14,6 +14,8 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/client/data_service_client.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <string>
@@ -28,6 +30,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/test_util.h"
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
@@ -200,6 +203,60 @@ TEST(DataServiceClientTest, RecordBufferEvents) {
   client.Cancel();
 }
 
+// Each GetElements call only requests as many elements as the buffer has free
+// slots, so the buffer never holds more than `max_outstanding_requests`
+// elements, even though the worker prefetches more.
+TEST(DataServiceClientTest, CreditsLimitBufferedElements) {
+  TestCluster::Config config;
+  config.num_workers = 1;
+  config.worker_task_buffer_size = 16;
+  TestCluster test_cluster(config);
+  TF_ASSERT_OK(test_cluster.Initialize());
+  DatasetClient<int64_t> test_dataset(test_cluster);
+  TF_ASSERT_OK_AND_ASSIGN(std::string dataset_id,
+                          test_dataset.RegisterDataset(RangeDataset(100)));
+
+  mutex mu;
+  int64_t num_buffered = 0;
+  int64_t max_num_buffered = 0;
+  auto mock_context = std::make_unique<TestDataServiceContext>();
+  EXPECT_CALL(*mock_context, RecordBufferEnqueue(_))
+      .WillRepeatedly([&](const std::vector<Tensor>&) {
+        mutex_lock l(mu);
+        max_num_buffered = std::max(max_num_buffered, ++num_buffered);
+      });
+  EXPECT_CALL(*mock_context, RecordBufferDequeue(_))
+      .WillRepeatedly([&](const std::vector<Tensor>&) {
+        mutex_lock l(mu);
+        --num_buffered;
+      });
+
+  DataServiceParams params = GetDataServiceParams(
+      dataset_id, test_cluster.DispatcherAddress(), ProcessingModeDef::OFF);
+  params.max_outstanding_requests = 4;
+  DataServiceClient client(params);
+  TF_ASSERT_OK(client.Initialize(/*accelerator_device_info=*/nullptr,
+                                 /*allocator=*/nullptr));
+  std::vector<int64_t> results;
+  while (true) {
+    TF_ASSERT_OK_AND_ASSIGN(GetNextResult next,
+                            client.GetNext([&mock_context]() {
+                              return std::move(mock_context);
+                            }));
+    if (next.end_of_sequence) {
+      break;
+    }
+    results.push_back(next.tensors[0].unaligned_flat<int64_t>().data()[0]);
+    // Lets the client fill its buffer between reads.
+    Env::Default()->SleepForMicroseconds(1000);
+  }
+  client.Cancel();
+  EXPECT_THAT(results, ElementsAreArray(Range(100)));
+  mutex_lock l(mu);
+  EXPECT_LE(max_num_buffered, params.max_outstanding_requests);
+  EXPECT_GT(max_num_buffered, 1);
+}
+
 TEST(DataServiceClientTest, Cancel) {
   TestCluster test_cluster(/*num_workers=*/1);
   TF_ASSERT_OK(test_cluster.Initialize());
@@ -16,20 +16,27 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/time/clock.h"
 #include "absl/time/time.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/data/service/data_transfer.h"
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/dispatcher_client.h"
 #include "tensorflow/core/data/service/export.pb.h"
 #include "tensorflow/core/data/service/test_cluster.h"
 #include "tensorflow/core/data/service/test_util.h"
+#include "tensorflow/core/data/service/worker.pb.h"
+#include "tensorflow/core/data/service/worker_client.h"
+#include "tensorflow/core/data/service/worker_impl.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
 #include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/platform/tstring.h"
 #include "tensorflow/core/platform/types.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
@@ -38,6 +45,7 @@ namespace tensorflow {
 namespace data {
 namespace {
 
+using ::tensorflow::data::testing::InfiniteDataset;
 using ::tensorflow::data::testing::InterleaveTextlineDataset;
 using ::tensorflow::data::testing::RangeDataset;
 using ::tensorflow::data::testing::RangeDatasetWithShardHint;
@@ -320,6 +328,58 @@ TEST(DataServiceTest, WorkerStateExport) {
               SizeIs(1));
 }
 
+// Reads elements of an infinite dataset from a worker over gRPC. With
+// `max_elements` 1, each element is fetched with a GetElement RPC. Otherwise,
+// elements are fetched with GetElements RPCs of up to `max_elements` elements.
+// One iteration reads one element, so the CPU time is the CPU per element. The
+// worker runs in this process, so it includes both the client and the worker.
+void BM_ReadElements(::testing::benchmark::State& state) {
+  const int64_t max_elements = state.range(0);
+  TestCluster::Config config;
+  config.num_workers = 1;
+  config.worker_task_buffer_size = 64;
+  TestCluster cluster(config);
+  TF_ASSERT_OK(cluster.Initialize());
+  // Consider the worker to be remote so that local protocol isn't forced on.
+  LocalWorkers::Remove(cluster.WorkerAddress(0));
+  DatasetClient<int64_t> dataset_client(cluster);
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          dataset_client.CreateIteration(InfiniteDataset()));
+  TF_ASSERT_OK_AND_ASSIGN(const std::vector<TaskInfo> tasks,
+                          dataset_client.GetTasks(iteration_client_id));
+  DataServiceWorkerClient worker_client(
+      cluster.WorkerAddress(0), "grpc", kGrpcTransferProtocol,
+      /*accelerator_device_info=*/nullptr, /*allocator=*/nullptr);
+
+  GetElementsRequest request;
+  request.mutable_request()->set_task_id(tasks[0].task_id());
+  request.set_max_elements(max_elements);
+  std::vector<GetElementResult> results;
+  // The worker gets the task with its next heartbeat.
+  TF_ASSERT_OK(WaitWhile([&]() -> absl::StatusOr<bool> {
+    results.clear();
+    absl::Status status = worker_client.GetElements(request, results);
+    if (absl::IsUnavailable(status)) {
+      return true;
+    }
+    TF_RETURN_IF_ERROR(status);
+    return false;
+  }));
+
+  size_t next_result = 0;
+  for (auto s : state) {
+    if (next_result == results.size()) {
+      results.clear();
+      TF_ASSERT_OK(worker_client.GetElements(request, results));
+      next_result = 0;
+    }
+    ASSERT_FALSE(results[next_result++].end_of_sequence);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ReadElements)->Arg(1)->Arg(8)->Arg(64);
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
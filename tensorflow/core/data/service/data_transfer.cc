@@ -19,6 +19,7 @@ limitations under the License.
 #include <memory>
 #include <string>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include "absl/strings/str_join.h"
@@ -111,6 +112,14 @@ absl::Status DataTransferServer::Build(
       " ]");
 }
 
+absl::Status DataTransferClient::GetElements(
+    const GetElementsRequest& req, std::vector<GetElementResult>& results) {
+  GetElementResult result;
+  TF_RETURN_IF_ERROR(GetElement(req.request(), result));
+  results.push_back(std::move(result));
+  return absl::OkStatus();
+}
+
 void DataTransferClient::Register(std::string name, ClientFactoryT factory) {
   mutex_lock l(*get_lock());
   if (!transfer_client_factories().insert({name, factory}).second) {
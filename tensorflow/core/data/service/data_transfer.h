@@ -81,6 +81,12 @@ class DataTransferClient {
   virtual absl::Status GetElement(const GetElementRequest& req,
                                   GetElementResult& result) = 0;
 
+  // Fetches up to `req.max_elements()` elements from the same task, appending
+  // them to `results`. On success, at least one element is appended. Clients
+  // which don't support batching fetch a single element with `GetElement`.
+  virtual absl::Status GetElements(const GetElementsRequest& req,
+                                   std::vector<GetElementResult>& results);
+
   // Makes a best effort to cancel all outstanding calls in progress for the
   // client, and causes further calls to return Cancelled status.
   virtual void TryCancel() = 0;
@@ -100,6 +100,12 @@ constexpr char kDatasetsDir[] = "datasets";
 // between completing a stream and getting assigned a new one.
 constexpr int kDefaultWorkerMaxConcurrentSnapshots = 3;
 
+// Checkpointing the state takes time proportional to its size, which is
+// usually much smaller than this many updates.
+constexpr int64_t kDefaultJournalCheckpointIntervalUpdates = 100000;
+// How long to wait before retrying a failed checkpoint.
+constexpr absl::Duration kCheckpointRetryInterval = absl::Seconds(10);
+
 constexpr absl::Duration kDefaultIterationGcCheckInterval = absl::Minutes(10);
 constexpr absl::Duration kDefaultIterationGcTimeout = absl::Minutes(5);
 constexpr absl::Duration kDefaultClientTimeout = absl::Minutes(5);
@@ -184,6 +190,10 @@ DispatcherConfig ApplyConfigDefaults(const DispatcherConfig& config) {
     new_config.set_worker_max_concurrent_snapshots(
         kDefaultWorkerMaxConcurrentSnapshots);
   }
+  if (new_config.journal_checkpoint_interval_updates() == 0) {
+    new_config.set_journal_checkpoint_interval_updates(
+        kDefaultJournalCheckpointIntervalUpdates);
+  }
   return new_config;
 }
 }  // namespace
@@ -193,7 +203,8 @@ DataServiceDispatcherImpl::DataServiceDispatcherImpl(
     : config_(ApplyConfigDefaults(config)),
       env_(Env::Default()),
       snapshot_assignment_manager_(config_.worker_max_concurrent_snapshots()),
-      state_(config_) {
+      state_(config_),
+      checkpoint_state_(config_) {
   if (config_.work_dir().empty()) {
     dataset_store_ = std::make_unique<MemoryDatasetStore>();
   } else {
@@ -207,8 +218,10 @@ DataServiceDispatcherImpl::~DataServiceDispatcherImpl() {
     mutex_lock l(mu_);
     cancelled_ = true;
     maintenance_thread_cv_.notify_all();
+    checkpoint_thread_cv_.notify_all();
   }
   maintenance_thread_.reset();
+  checkpoint_thread_.reset();
 }
 
 absl::Status DataServiceDispatcherImpl::Start() {
@@ -236,23 +249,7 @@ absl::Status DataServiceDispatcherImpl::Start() {
       std::make_unique<FileJournalWriter>(env_, JournalDir(config_.work_dir()));
   LOG(INFO) << "Attempting to restore dispatcher state from journal in "
             << JournalDir(config_.work_dir());
-  Update update;
-  bool end_of_journal = false;
-  FileJournalReader reader(env_, JournalDir(config_.work_dir()));
-  absl::Status s = reader.Read(update, end_of_journal);
-  if (errors::IsNotFound(s)) {
-    LOG(INFO) << "No journal found. Starting dispatcher from new state.";
-  } else if (!s.ok()) {
-    return s;
-  } else {
-    int64_t start = env_->NowMicros();
-    while (!end_of_journal) {
-      TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
-      TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
-    }
-    absl::Duration duration = absl::Microseconds(env_->NowMicros() - start);
-    LOG(INFO) << "Restored from journal in " << duration << ".";
-  }
+  TF_RETURN_IF_ERROR(RestoreState());
   for (const auto& iteration : state_.ListIterations()) {
     if (IsDynamicShard(iteration->job->processing_mode)) {
       TF_RETURN_IF_ERROR(RestoreSplitProviders(
@@ -268,6 +265,10 @@ absl::Status DataServiceDispatcherImpl::Start() {
   // Initialize the journal writer in `Start` so that we fail fast in case it
   // can't be initialized.
   TF_RETURN_IF_ERROR(journal_writer_.value()->EnsureInitialized());
+  if (CheckpointingEnabled()) {
+    checkpoint_thread_ = absl::WrapUnique(env_->StartThread(
+        {}, "checkpoint-thread", [&] { CheckpointThread(); }));
+  }
   TF_RETURN_IF_ERROR(RestoreSnapshots());
   started_ = true;
   LOG(INFO) << "Started tf.data service dispatcher with config "
@@ -1381,7 +1382,152 @@ absl::Status DataServiceDispatcherImpl::Apply(const Update& update)
   if (journal_writer_.has_value()) {
     TF_RETURN_IF_ERROR(journal_writer_.value()->Write(update));
   }
-  return state_.Apply(update);
+  TF_RETURN_IF_ERROR(state_.Apply(update));
+  if (CheckpointingEnabled()) {
+    pending_updates_.push_back(update);
+    if (++updates_since_checkpoint_ >=
+        config_.journal_checkpoint_interval_updates()) {
+      checkpoint_thread_cv_.notify_all();
+    }
+  }
+  return absl::OkStatus();
+}
+
+bool DataServiceDispatcherImpl::CheckpointingEnabled() const {
+  return config_.fault_tolerant_mode() &&
+         config_.journal_checkpoint_interval_updates() > 0;
+}
+
+absl::Status DataServiceDispatcherImpl::RestoreState()
+    TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  const std::string journal_dir = JournalDir(config_.work_dir());
+  int64_t start = env_->NowMicros();
+  int64_t first_sequence_number = 0;
+  absl::StatusOr<DispatcherStateCheckpoint> checkpoint =
+      ReadDispatcherStateCheckpoint(env_, journal_dir);
+  if (checkpoint.ok()) {
+    TF_RETURN_IF_ERROR(state_.Restore(*checkpoint));
+    if (CheckpointingEnabled()) {
+      TF_RETURN_IF_ERROR(checkpoint_state_.Restore(*checkpoint));
+    }
+    first_sequence_number = checkpoint->journal_sequence_number();
+    LOG(INFO) << "Restored dispatcher state checkpoint "
+              << DispatcherStateCheckpointFile(journal_dir,
+                                               first_sequence_number)
+              << " in " << absl::Microseconds(env_->NowMicros() - start)
+              << ".";
+  } else if (!errors::IsNotFound(checkpoint.status())) {
+    return checkpoint.status();
+  }
+
+  Update update;
+  bool end_of_journal = false;
+  FileJournalReader reader(env_, journal_dir, first_sequence_number);
+  absl::Status s = reader.Read(update, end_of_journal);
+  if (errors::IsNotFound(s)) {
+    if (!checkpoint.ok()) {
+      LOG(INFO) << "No journal found. Starting dispatcher from new state.";
+    }
+    return absl::OkStatus();
+  }
+  TF_RETURN_IF_ERROR(s);
+  int64_t num_updates = 0;
+  while (!end_of_journal) {
+    TF_RETURN_IF_ERROR(ApplyWithoutJournaling(update));
+    if (CheckpointingEnabled()) {
+      pending_updates_.push_back(update);
+    }
+    ++num_updates;
+    TF_RETURN_IF_ERROR(reader.Read(update, end_of_journal));
+  }
+  // Checkpoint early if the journal is already long.
+  updates_since_checkpoint_ = num_updates;
+  absl::Duration duration = absl::Microseconds(env_->NowMicros() - start);
+  LOG(INFO) << "Restored from journal in " << duration << " (" << num_updates
+            << " updates).";
+  return absl::OkStatus();
+}
+
+absl::StatusOr<int64_t> DataServiceDispatcherImpl::StartCheckpoint(
+    std::vector<Update>& updates) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+  // Every update applied so far is in a journal file before the new one, so
+  // the checkpoint covers exactly those files.
+  TF_ASSIGN_OR_RETURN(int64_t sequence_number,
+                      journal_writer_.value()->StartNewFile());
+  updates_since_checkpoint_ = 0;
+  updates.swap(pending_updates_);
+  return sequence_number;
+}
+
+void DataServiceDispatcherImpl::CheckpointThread() {
+  const std::string journal_dir = JournalDir(config_.work_dir());
+  // Set after a failure, to retry once the time is reached instead of waiting
+  // for more updates.
+  std::optional<int64_t> retry_micros;
+  while (true) {
+    std::vector<Update> updates;
+    int64_t sequence_number;
+    {
+      mutex_lock l(mu_);
+      while (!cancelled_) {
+        if (!retry_micros.has_value()) {
+          if (updates_since_checkpoint_ >=
+              config_.journal_checkpoint_interval_updates()) {
+            break;
+          }
+          checkpoint_thread_cv_.wait(l);
+        } else {
+          const int64_t remaining_micros = *retry_micros - env_->NowMicros();
+          if (remaining_micros <= 0) {
+            break;
+          }
+          checkpoint_thread_cv_.wait_for(
+              l, std::chrono::microseconds(remaining_micros));
+        }
+      }
+      if (cancelled_) {
+        return;
+      }
+      retry_micros.reset();
+      absl::StatusOr<int64_t> started = StartCheckpoint(updates);
+      if (!started.ok()) {
+        LOG(WARNING) << "Error starting a new journal file to checkpoint the "
+                     << "dispatcher state, retrying in "
+                     << kCheckpointRetryInterval << ": " << started.status();
+        retry_micros = env_->NowMicros() +
+                       absl::ToInt64Microseconds(kCheckpointRetryInterval);
+        continue;
+      }
+      sequence_number = *started;
+    }
+    // `checkpoint_state_` follows `state_` through the updates handed over
+    // above, so that it is serialized without holding `mu_`.
+    int64_t start = env_->NowMicros();
+    for (const Update& update : updates) {
+      absl::Status s = checkpoint_state_.Apply(update);
+      if (!s.ok()) {
+        // Should not happen, as the update succeeded on `state_`. The journal
+        // is left as is, so the state can still be restored from it.
+        LOG(ERROR) << "Stopped checkpointing the dispatcher state, which "
+                   << "failed to apply update " << update.DebugString()
+                   << ": " << s;
+        return;
+      }
+    }
+    absl::Status s = WriteDispatcherStateCheckpoint(
+        env_, journal_dir, checkpoint_state_.Checkpoint(sequence_number));
+    if (!s.ok()) {
+      // The journal files are only deleted once a checkpoint is written, so
+      // the state can still be restored. The retry writes a newer checkpoint.
+      LOG(WARNING) << "Error checkpointing the dispatcher state, retrying in "
+                   << kCheckpointRetryInterval << ": " << s;
+      retry_micros = env_->NowMicros() +
+                     absl::ToInt64Microseconds(kCheckpointRetryInterval);
+      continue;
+    }
+    VLOG(1) << "Checkpointed the dispatcher state in "
+            << absl::Microseconds(env_->NowMicros() - start);
+  }
 }
 
 void DataServiceDispatcherImpl::MaintenanceThread() {
@@ -32,6 +32,7 @@ limitations under the License.
 #include "tensorflow/core/data/service/dispatcher.pb.h"
 #include "tensorflow/core/data/service/dispatcher_state.h"
 #include "tensorflow/core/data/service/export.pb.h"
+#include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/data/service/snapshot/snapshot_manager.h"
 #include "tensorflow/core/data/service/task_remover.h"
 #include "tensorflow/core/data/service/worker.grpc.pb.h"
@@ -200,6 +201,9 @@ class DataServiceDispatcherImpl {
   // A thread which periodically checks for iterations to clean up, clients to
   // release, workers to consider missing, and snapshot streams to reassign.
   void MaintenanceThread();
+  // A thread which checkpoints the dispatcher state every
+  // `journal_checkpoint_interval_updates` updates, and retries on errors.
+  void CheckpointThread();
 
   // Restores split providers from the state in `iteration` and stores them in
   // `restored`.
@@ -325,6 +329,15 @@ class DataServiceDispatcherImpl {
   // used when recovering state when the dispatcher starts.
   absl::Status ApplyWithoutJournaling(const Update& update)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Restores the state from the latest checkpoint and the journal after it.
+  absl::Status RestoreState() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
+  // Returns whether `CheckpointThread` checkpoints the state.
+  bool CheckpointingEnabled() const;
+  // Starts a new journal file for the updates after the checkpoint, and moves
+  // the updates before it to `updates`. Returns the sequence number of the new
+  // file.
+  absl::StatusOr<int64_t> StartCheckpoint(std::vector<Update>& updates)
+      TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
   // Removes the client with `client_id` from `auto_scaler_`
   void RemoveClientFromAutoScaler(int64_t client_id)
       TF_EXCLUSIVE_LOCKS_REQUIRED(mu_);
@@ -400,6 +413,19 @@ class DataServiceDispatcherImpl {
   // Condition variable for waking up the gc thread.
   condition_variable maintenance_thread_cv_;
   std::unique_ptr<Thread> maintenance_thread_;
+  // Number of updates journaled since the latest checkpoint.
+  int64_t updates_since_checkpoint_ TF_GUARDED_BY(mu_) = 0;
+  // The updates applied to `state_` which are not yet applied to
+  // `checkpoint_state_`.
+  std::vector<Update> pending_updates_ TF_GUARDED_BY(mu_);
+  // A replica of `state_` which `CheckpointThread` brings up to date and
+  // serializes without holding `mu_`. `DispatcherState` objects are mutated in
+  // place, so they can't be shared with `state_`. Only accessed by
+  // `RestoreState` before the checkpoint thread starts, and by that thread.
+  DispatcherState checkpoint_state_;
+  // Condition variable for waking up the checkpoint thread.
+  condition_variable checkpoint_thread_cv_;
+  std::unique_ptr<Thread> checkpoint_thread_;
   MultipleIterationsAutoScaler auto_scaler_;
 
   DataServiceDispatcherImpl(const DataServiceDispatcherImpl&) = delete;
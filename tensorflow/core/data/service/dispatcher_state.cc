@@ -17,10 +17,14 @@ limitations under the License.
 #include <algorithm>
 #include <memory>
 #include <optional>
+#include <queue>
 #include <string>
+#include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "tensorflow/core/data/service/common.h"
@@ -95,6 +99,304 @@ absl::Status DispatcherState::Apply(const Update& update) {
   return absl::OkStatus();
 }
 
+DispatcherStateCheckpoint DispatcherState::Checkpoint(
+    int64_t journal_sequence_number) const {
+  DispatcherStateCheckpoint checkpoint;
+  checkpoint.set_journal_sequence_number(journal_sequence_number);
+  checkpoint.set_next_available_dataset_id(next_available_dataset_id_);
+  checkpoint.set_next_available_job_id(next_available_job_id_);
+  checkpoint.set_next_available_iteration_id(next_available_iteration_id_);
+  checkpoint.set_next_available_iteration_client_id(
+      next_available_iteration_client_id_);
+  checkpoint.set_next_available_task_id(next_available_task_id_);
+
+  std::vector<std::shared_ptr<Dataset>> datasets;
+  datasets.reserve(datasets_by_id_.size());
+  for (const auto& [dataset_id, dataset] : datasets_by_id_) {
+    datasets.push_back(dataset);
+  }
+  absl::c_sort(datasets, [](const auto& lhs, const auto& rhs) {
+    return lhs->dataset_id < rhs->dataset_id;
+  });
+  for (const auto& dataset : datasets) {
+    RegisterDatasetUpdate* register_dataset = checkpoint.add_datasets();
+    register_dataset->set_dataset_id(dataset->dataset_id);
+    *register_dataset->mutable_metadata() = dataset->metadata;
+  }
+
+  for (const std::string& address : worker_addresses_) {
+    const Worker& worker = *workers_.at(address);
+    RegisterWorkerUpdate* register_worker = checkpoint.add_workers();
+    register_worker->set_worker_address(worker.address);
+    for (const DataTransferServerInfo& transfer_server :
+         worker.transfer_servers) {
+      *register_worker->add_transfer_servers() = transfer_server;
+    }
+    for (const std::string& tag : worker.tags) {
+      register_worker->add_worker_tags(tag);
+    }
+    register_worker->set_worker_uid(worker.uid);
+  }
+
+  std::vector<std::shared_ptr<Job>> jobs;
+  jobs.reserve(jobs_by_id_.size());
+  for (const auto& [job_id, job] : jobs_by_id_) {
+    jobs.push_back(job);
+  }
+  absl::c_sort(jobs, [](const auto& lhs, const auto& rhs) {
+    return lhs->id < rhs->id;
+  });
+  for (const auto& job : jobs) {
+    CreateJobUpdate* create_job = checkpoint.add_jobs();
+    create_job->set_job_id(job->id);
+    create_job->set_job_name(job->job_name);
+    create_job->set_dataset_id(job->dataset_id);
+    *create_job->mutable_processing_mode_def() = job->processing_mode;
+    if (job->num_consumers.has_value()) {
+      create_job->set_num_consumers(*job->num_consumers);
+    }
+    create_job->set_target_workers(job->target_workers);
+    create_job->set_use_cross_trainer_cache(job->use_cross_trainer_cache);
+  }
+
+  // Pending tasks stay in their iteration's queue after they are removed, so
+  // they are checkpointed together with the tasks in `tasks_`.
+  std::vector<std::shared_ptr<Task>> tasks;
+  tasks.reserve(tasks_.size());
+  for (const auto& [task_id, task] : tasks_) {
+    tasks.push_back(task);
+  }
+  std::vector<std::shared_ptr<Iteration>> iterations;
+  iterations.reserve(iterations_.size());
+  for (const auto& [iteration_id, iteration] : iterations_) {
+    iterations.push_back(iteration);
+  }
+  absl::c_sort(iterations, [](const auto& lhs, const auto& rhs) {
+    return lhs->iteration_id < rhs->iteration_id;
+  });
+  for (const auto& iteration : iterations) {
+    IterationCheckpoint* iteration_checkpoint = checkpoint.add_iterations();
+    CreateIterationUpdate* create_iteration =
+        iteration_checkpoint->mutable_create_iteration();
+    create_iteration->set_iteration_id(iteration->iteration_id);
+    create_iteration->set_job_id(iteration->job->id);
+    create_iteration->set_repetition(iteration->iteration_key.repetition);
+    if (iteration->distributed_epoch_state.has_value()) {
+      const DistributedEpochState& state = *iteration->distributed_epoch_state;
+      create_iteration->set_num_split_providers(state.repetitions.size());
+      iteration_checkpoint->mutable_split_repetitions()->Add(
+          state.repetitions.begin(), state.repetitions.end());
+      iteration_checkpoint->mutable_split_indices()->Add(state.indices.begin(),
+                                                         state.indices.end());
+    }
+    if (auto it = tasks_by_iteration_.find(iteration->iteration_id);
+        it != tasks_by_iteration_.end()) {
+      for (const auto& task : it->second) {
+        iteration_checkpoint->add_task_ids(task->task_id);
+      }
+    }
+    std::queue<PendingTask> pending_tasks = iteration->pending_tasks;
+    for (; !pending_tasks.empty(); pending_tasks.pop()) {
+      const PendingTask& pending_task = pending_tasks.front();
+      PendingTaskCheckpoint* pending_task_checkpoint =
+          iteration_checkpoint->add_pending_tasks();
+      pending_task_checkpoint->set_task_id(pending_task.task->task_id);
+      pending_task_checkpoint->set_target_round(pending_task.target_round);
+      std::vector<int64_t> ready_consumers(pending_task.ready_consumers.begin(),
+                                           pending_task.ready_consumers.end());
+      absl::c_sort(ready_consumers);
+      pending_task_checkpoint->mutable_ready_consumers()->Add(
+          ready_consumers.begin(), ready_consumers.end());
+      pending_task_checkpoint->set_failures(pending_task.failures);
+      if (pending_task.task->removed) {
+        tasks.push_back(pending_task.task);
+      }
+    }
+    iteration_checkpoint->set_num_clients(iteration->num_clients);
+    iteration_checkpoint->set_last_client_released_micros(
+        iteration->last_client_released_micros);
+    iteration_checkpoint->set_finished(iteration->finished);
+    iteration_checkpoint->set_garbage_collected(iteration->garbage_collected);
+  }
+
+  absl::c_sort(tasks, [](const auto& lhs, const auto& rhs) {
+    return lhs->task_id < rhs->task_id;
+  });
+  for (const auto& task : tasks) {
+    TaskCheckpoint* task_checkpoint = checkpoint.add_tasks();
+    CreateTaskUpdate* create_task = task_checkpoint->mutable_create_task();
+    create_task->set_task_id(task->task_id);
+    create_task->set_iteration_id(task->iteration->iteration_id);
+    create_task->set_worker_address(task->worker_address);
+    for (const DataTransferServerInfo& transfer_server :
+         task->transfer_servers) {
+      *create_task->add_transfer_servers() = transfer_server;
+    }
+    for (const std::string& tag : task->worker_tags) {
+      create_task->add_worker_tags(tag);
+    }
+    create_task->set_worker_uid(task->worker_uid);
+    task_checkpoint->set_starting_round(task->starting_round);
+    task_checkpoint->set_finished(task->finished);
+    task_checkpoint->set_removed(task->removed);
+  }
+
+  for (const auto& [iteration_client_id, iteration] :
+       iterations_for_client_ids_) {
+    // `IterationForIterationClientId` leaves null entries for unknown ids.
+    if (iteration) {
+      (*checkpoint.mutable_iteration_client_ids())[iteration_client_id] =
+          iteration->iteration_id;
+    }
+  }
+  std::vector<std::string> snapshot_paths(snapshot_paths_.begin(),
+                                          snapshot_paths_.end());
+  absl::c_sort(snapshot_paths);
+  for (const std::string& snapshot_path : snapshot_paths) {
+    checkpoint.add_snapshot_paths(snapshot_path);
+  }
+  for (const auto& [dataset_id, compression_disabled] :
+       compression_disabled_at_runtime_) {
+    (*checkpoint.mutable_compression_disabled_at_runtime())[dataset_id] =
+        compression_disabled;
+  }
+  return checkpoint;
+}
+
+absl::Status DispatcherState::Restore(
+    const DispatcherStateCheckpoint& checkpoint) {
+  if (!datasets_by_id_.empty() || !workers_.empty() || !jobs_by_id_.empty() ||
+      !iterations_.empty() || !tasks_.empty() || !snapshot_paths_.empty()) {
+    return errors::FailedPrecondition(
+        "Dispatcher state can only be restored from a checkpoint when it is "
+        "empty.");
+  }
+  for (const RegisterDatasetUpdate& register_dataset : checkpoint.datasets()) {
+    RegisterDataset(register_dataset);
+  }
+  for (const RegisterWorkerUpdate& register_worker : checkpoint.workers()) {
+    RegisterWorker(register_worker);
+  }
+  for (const CreateJobUpdate& create_job : checkpoint.jobs()) {
+    CreateJob(create_job);
+  }
+  TF_RETURN_IF_ERROR(RestoreIterations(checkpoint));
+  for (const auto& [iteration_client_id, iteration_id] :
+       checkpoint.iteration_client_ids()) {
+    auto it = iterations_.find(iteration_id);
+    if (it == iterations_.end()) {
+      return errors::DataLoss("Dispatcher state checkpoint has client ",
+                              iteration_client_id, " for unknown iteration ",
+                              iteration_id);
+    }
+    iterations_for_client_ids_[iteration_client_id] = it->second;
+  }
+  snapshot_paths_.insert(checkpoint.snapshot_paths().begin(),
+                         checkpoint.snapshot_paths().end());
+  for (const auto& [dataset_id, compression_disabled] :
+       checkpoint.compression_disabled_at_runtime()) {
+    compression_disabled_at_runtime_[dataset_id] = compression_disabled;
+  }
+
+  next_available_dataset_id_ = checkpoint.next_available_dataset_id();
+  next_available_job_id_ = checkpoint.next_available_job_id();
+  next_available_iteration_id_ = checkpoint.next_available_iteration_id();
+  next_available_iteration_client_id_ =
+      checkpoint.next_available_iteration_client_id();
+  next_available_task_id_ = checkpoint.next_available_task_id();
+  return absl::OkStatus();
+}
+
+absl::Status DispatcherState::RestoreIterations(
+    const DispatcherStateCheckpoint& checkpoint) {
+  // Iterations are checkpointed in id order, so that later iterations replace
+  // garbage collected ones in `iterations_by_key_`.
+  for (const IterationCheckpoint& iteration_checkpoint :
+       checkpoint.iterations()) {
+    const CreateIterationUpdate& create_iteration =
+        iteration_checkpoint.create_iteration();
+    if (!jobs_by_id_.contains(create_iteration.job_id())) {
+      return errors::DataLoss("Dispatcher state checkpoint has iteration ",
+                              create_iteration.iteration_id(),
+                              " for unknown job ", create_iteration.job_id());
+    }
+    CreateIteration(create_iteration);
+    Iteration& iteration = *iterations_[create_iteration.iteration_id()];
+    if (iteration.distributed_epoch_state.has_value()) {
+      DistributedEpochState& state = *iteration.distributed_epoch_state;
+      state.repetitions.assign(iteration_checkpoint.split_repetitions().begin(),
+                               iteration_checkpoint.split_repetitions().end());
+      state.indices.assign(iteration_checkpoint.split_indices().begin(),
+                           iteration_checkpoint.split_indices().end());
+    }
+    iteration.num_clients = iteration_checkpoint.num_clients();
+    iteration.last_client_released_micros =
+        iteration_checkpoint.last_client_released_micros();
+    iteration.finished = iteration_checkpoint.finished();
+    iteration.garbage_collected = iteration_checkpoint.garbage_collected();
+  }
+
+  TasksById tasks;
+  for (const TaskCheckpoint& task_checkpoint : checkpoint.tasks()) {
+    const CreateTaskUpdate& create_task = task_checkpoint.create_task();
+    auto it = iterations_.find(create_task.iteration_id());
+    if (it == iterations_.end()) {
+      return errors::DataLoss("Dispatcher state checkpoint has task ",
+                              create_task.task_id(), " for unknown iteration ",
+                              create_task.iteration_id());
+    }
+    int64_t task_id = create_task.task_id();
+    auto task = std::make_shared<Task>(create_task, it->second);
+    task->starting_round = task_checkpoint.starting_round();
+    task->finished = task_checkpoint.finished();
+    task->removed = task_checkpoint.removed();
+    if (!task->removed) {
+      tasks_[task_id] = task;
+      if (!task->finished) {
+        tasks_by_worker_[task->worker_address][task_id] = task;
+      }
+    }
+    tasks[task_id] = std::move(task);
+  }
+  auto find_task = [&tasks](int64_t task_id) -> std::shared_ptr<Task> {
+    auto it = tasks.find(task_id);
+    return it == tasks.end() ? nullptr : it->second;
+  };
+  for (const IterationCheckpoint& iteration_checkpoint :
+       checkpoint.iterations()) {
+    int64_t iteration_id =
+        iteration_checkpoint.create_iteration().iteration_id();
+    std::vector<std::shared_ptr<Task>>& tasks_for_iteration =
+        tasks_by_iteration_[iteration_id];
+    for (int64_t task_id : iteration_checkpoint.task_ids()) {
+      std::shared_ptr<Task> task = find_task(task_id);
+      if (!task) {
+        return errors::DataLoss("Dispatcher state checkpoint is missing task ",
+                                task_id, " of iteration ", iteration_id);
+      }
+      tasks_for_iteration.push_back(std::move(task));
+    }
+    Iteration& iteration = *iterations_[iteration_id];
+    for (const PendingTaskCheckpoint& pending_task_checkpoint :
+         iteration_checkpoint.pending_tasks()) {
+      std::shared_ptr<Task> task = find_task(pending_task_checkpoint.task_id());
+      if (!task) {
+        return errors::DataLoss(
+            "Dispatcher state checkpoint is missing pending task ",
+            pending_task_checkpoint.task_id(), " of iteration ", iteration_id);
+      }
+      PendingTask pending_task(std::move(task),
+                               pending_task_checkpoint.target_round());
+      pending_task.ready_consumers.insert(
+          pending_task_checkpoint.ready_consumers().begin(),
+          pending_task_checkpoint.ready_consumers().end());
+      pending_task.failures = pending_task_checkpoint.failures();
+      iteration.pending_tasks.push(std::move(pending_task));
+    }
+  }
+  return absl::OkStatus();
+}
+
 void DispatcherState::RegisterDataset(
     const RegisterDatasetUpdate& register_dataset) {
   std::string dataset_id = register_dataset.dataset_id();
@@ -110,6 +412,7 @@ void DispatcherState::RegisterWorker(
   std::string address = register_worker.worker_address();
   DCHECK(!workers_.contains(address));
   workers_[address] = std::make_shared<Worker>(register_worker);
+  worker_addresses_.push_back(address);
   tasks_by_worker_[address] =
       absl::flat_hash_map<int64_t, std::shared_ptr<Task>>();
   worker_index_resolver_.AddWorker(address);
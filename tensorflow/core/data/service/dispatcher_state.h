@@ -73,6 +73,16 @@ class DispatcherState {
   // Applies the given update to the dispatcher's state.
   absl::Status Apply(const Update& update);
 
+  // Returns a checkpoint of the current state. Restoring it has the same
+  // effect as applying all the updates applied so far.
+  // `journal_sequence_number` is the sequence number of the first journal
+  // file that is not covered by the checkpoint.
+  DispatcherStateCheckpoint Checkpoint(int64_t journal_sequence_number) const;
+
+  // Restores the state from `checkpoint`. The state must be empty, i.e. no
+  // updates may have been applied before.
+  absl::Status Restore(const DispatcherStateCheckpoint& checkpoint);
+
   // A dataset registered with the dispatcher.
   struct Dataset {
     explicit Dataset(const std::string& dataset_id,
@@ -330,12 +340,18 @@ class DispatcherState {
   // Updates the next available dataset ID.
   void UpdateNextAvailableDatasetId();
 
+  // Restores the iterations and their tasks in `Restore`.
+  absl::Status RestoreIterations(const DispatcherStateCheckpoint& checkpoint);
+
   int64_t next_available_dataset_id_ = 1000;
   // Registered datasets, keyed by dataset ids.
   absl::flat_hash_map<std::string, std::shared_ptr<Dataset>> datasets_by_id_;
 
   // Registered workers, keyed by address.
   absl::flat_hash_map<std::string, std::shared_ptr<Worker>> workers_;
+  // Addresses of the registered workers, in registration order. The order
+  // determines the worker indexes assigned by `worker_index_resolver_`.
+  std::vector<std::string> worker_addresses_;
 
   // Assigns an index to each worker according to worker addresses list
   // specified in the dispatcher config.
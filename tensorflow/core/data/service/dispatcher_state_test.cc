@@ -23,9 +23,13 @@ limitations under the License.
 #include "absl/strings/str_cat.h"
 #include "xla/tsl/lib/core/status_test_util.h"
 #include "tensorflow/core/data/service/common.pb.h"
+#include "tensorflow/core/data/service/journal.h"
 #include "tensorflow/core/data/service/journal.pb.h"
+#include "tensorflow/core/data/service/test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/random.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
 #include "tensorflow/core/protobuf/service_config.pb.h"
 #include "tsl/platform/status_matchers.h"
@@ -40,10 +44,12 @@ using IterationKey = DispatcherState::IterationKey;
 using Job = DispatcherState::Job;
 using Iteration = DispatcherState::Iteration;
 using Task = DispatcherState::Task;
+using ::tensorflow::data::testing::EqualsProto;
 using ::testing::HasSubstr;
 using ::testing::IsEmpty;
 using ::testing::SizeIs;
 using ::testing::UnorderedElementsAre;
+using ::tsl::testing::IsOkAndHolds;
 using ::tsl::testing::StatusIs;
 
 absl::Status RegisterDataset(const std::string& dataset_id,
@@ -140,6 +146,38 @@ absl::Status Snapshot(const std::string& path, DispatcherState& state) {
   return state.Apply(update);
 }
 
+// Returns a journal with `num_updates` updates, mostly splits produced for a
+// dynamically sharded iteration, with a task created every 100 updates.
+std::vector<Update> RecoveryBenchmarkJournal(int64_t num_updates) {
+  std::vector<Update> journal(4);
+  journal[0].mutable_register_dataset()->set_dataset_id("dataset_id");
+  journal[1].mutable_register_worker()->set_worker_address("worker");
+  CreateJobUpdate* create_job = journal[2].mutable_create_job();
+  create_job->set_job_id(1);
+  create_job->set_job_name("job");
+  create_job->set_dataset_id("dataset_id");
+  create_job->mutable_processing_mode_def()->set_sharding_policy(
+      ProcessingModeDef::DYNAMIC);
+  CreateIterationUpdate* create_iteration =
+      journal[3].mutable_create_iteration();
+  create_iteration->set_iteration_id(1);
+  create_iteration->set_job_id(1);
+  create_iteration->set_num_split_providers(1);
+  for (int64_t i = journal.size(); i < num_updates; ++i) {
+    Update& update = journal.emplace_back();
+    if (i % 100 == 0) {
+      CreateTaskUpdate* create_task = update.mutable_create_task();
+      create_task->set_task_id(i);
+      create_task->set_iteration_id(1);
+      create_task->set_worker_address("worker");
+    } else {
+      ProduceSplitUpdate* produce_split = update.mutable_produce_split();
+      produce_split->set_iteration_id(1);
+    }
+  }
+  return journal;
+}
+
 }  // namespace
 
 TEST(DispatcherState, RegisterDataset) {
@@ -658,5 +696,207 @@ TEST(DispatcherState, GetNumberOfRegisteredWorkers) {
   EXPECT_EQ(state.GetNumberOfRegisteredWorkers(), 2);
 }
 
+TEST(DispatcherState, CheckpointRoundTrip) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset("dataset_id", state));
+  TF_ASSERT_OK(RegisterWorker("worker_a", state));
+  TF_ASSERT_OK(RegisterWorker("worker_b", state));
+  TF_ASSERT_OK(CreateIteration(/*iteration_id=*/1, "dataset_id",
+                               IterationKey("job", 0), state));
+  TF_ASSERT_OK(CreateTask(/*task_id=*/10, /*iteration_id=*/1, "worker_a",
+                          state));
+  TF_ASSERT_OK(CreateTask(/*task_id=*/11, /*iteration_id=*/1, "worker_b",
+                          state));
+  TF_ASSERT_OK(FinishTask(/*task_id=*/10, state));
+  TF_ASSERT_OK(AcquireIterationClientId(/*iteration_id=*/1,
+                                        /*iteration_client_id=*/100, state));
+
+  // A round-robin iteration with a pending task accepted by one of its two
+  // consumers.
+  {
+    Update update;
+    CreateJobUpdate* create_job = update.mutable_create_job();
+    create_job->set_job_id(20);
+    create_job->set_dataset_id("dataset_id");
+    create_job->set_job_name("round_robin_job");
+    create_job->set_num_consumers(2);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+  {
+    Update update;
+    CreateIterationUpdate* create_iteration = update.mutable_create_iteration();
+    create_iteration->set_iteration_id(2);
+    create_iteration->set_job_id(20);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+  {
+    Update update;
+    CreatePendingTaskUpdate* create_pending_task =
+        update.mutable_create_pending_task();
+    create_pending_task->set_task_id(12);
+    create_pending_task->set_iteration_id(2);
+    create_pending_task->set_worker_address("worker_a");
+    create_pending_task->set_starting_round(5);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+  TF_ASSERT_OK(AcquireIterationClientId(/*iteration_id=*/2,
+                                        /*iteration_client_id=*/101, state));
+  {
+    Update update;
+    ClientHeartbeatUpdate* client_heartbeat = update.mutable_client_heartbeat();
+    client_heartbeat->set_iteration_client_id(101);
+    client_heartbeat->set_task_accepted(true);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+
+  // A garbage collected iteration replaced by a new iteration with the same
+  // key.
+  TF_ASSERT_OK(CreateIteration(/*iteration_id=*/3, "dataset_id",
+                               IterationKey("gc_job", 0), state));
+  {
+    Update update;
+    update.mutable_garbage_collect_iteration()->set_iteration_id(3);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+  std::shared_ptr<const Job> gc_job;
+  TF_ASSERT_OK(state.JobByName("gc_job", gc_job));
+  {
+    Update update;
+    CreateIterationUpdate* create_iteration = update.mutable_create_iteration();
+    create_iteration->set_iteration_id(4);
+    create_iteration->set_job_id(gc_job->id);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+  TF_ASSERT_OK(Snapshot("snapshot_path", state));
+  {
+    Update update;
+    CompressionDisabledAtRuntimeUpdate* compression_disabled_at_runtime =
+        update.mutable_compression_disabled_at_runtime();
+    compression_disabled_at_runtime->set_dataset_id("dataset_id");
+    compression_disabled_at_runtime->set_compression_disabled(true);
+    TF_ASSERT_OK(state.Apply(update));
+  }
+
+  DispatcherStateCheckpoint checkpoint =
+      state.Checkpoint(/*journal_sequence_number=*/7);
+  DispatcherState restored;
+  TF_ASSERT_OK(restored.Restore(checkpoint));
+  EXPECT_THAT(restored.Checkpoint(/*journal_sequence_number=*/7),
+              EqualsProto(checkpoint));
+
+  std::vector<std::shared_ptr<const Task>> tasks;
+  TF_ASSERT_OK(restored.TasksForIteration(/*iteration_id=*/1, tasks));
+  ASSERT_THAT(tasks, SizeIs(2));
+  EXPECT_EQ(tasks[0]->task_id, 10);
+  EXPECT_TRUE(tasks[0]->finished);
+  EXPECT_EQ(tasks[1]->task_id, 11);
+  TF_ASSERT_OK(restored.TasksForWorker("worker_a", tasks));
+  ASSERT_THAT(tasks, SizeIs(1));
+  EXPECT_EQ(tasks[0]->task_id, 12);
+
+  std::shared_ptr<const Iteration> iteration;
+  TF_ASSERT_OK(restored.IterationForIterationClientId(101, iteration));
+  EXPECT_EQ(iteration->iteration_id, 2);
+  ASSERT_EQ(iteration->pending_tasks.size(), 1);
+  EXPECT_EQ(iteration->pending_tasks.front().target_round, 5);
+  EXPECT_THAT(iteration->pending_tasks.front().ready_consumers,
+              UnorderedElementsAre(101));
+  TF_ASSERT_OK(restored.IterationByKey(IterationKey("gc_job", 0), iteration));
+  EXPECT_EQ(iteration->iteration_id, 4);
+  EXPECT_EQ(restored.NextAvailableTaskId(), state.NextAvailableTaskId());
+  EXPECT_EQ(restored.NextAvailableDatasetId(), state.NextAvailableDatasetId());
+  EXPECT_EQ(restored.CompressionDisabledAtRuntime("dataset_id"), true);
+}
+
+TEST(DispatcherState, CheckpointPreservesWorkerIndexes) {
+  experimental::DispatcherConfig config;
+  config.add_worker_addresses("/worker/task/0:%port%");
+  config.add_worker_addresses("/worker/task/0:%port%");
+  DispatcherState state(config);
+  TF_ASSERT_OK(RegisterWorker("/worker/task/0:20000", state));
+  TF_ASSERT_OK(RegisterWorker("/worker/task/0:10000", state));
+
+  DispatcherState restored(config);
+  TF_ASSERT_OK(
+      restored.Restore(state.Checkpoint(/*journal_sequence_number=*/0)));
+  EXPECT_THAT(restored.GetWorkerIndex("/worker/task/0:20000"), IsOkAndHolds(0));
+  EXPECT_THAT(restored.GetWorkerIndex("/worker/task/0:10000"), IsOkAndHolds(1));
+}
+
+TEST(DispatcherState, RestoreNonEmptyState) {
+  DispatcherState state;
+  TF_ASSERT_OK(RegisterDataset("dataset_id", state));
+  EXPECT_THAT(state.Restore(state.Checkpoint(/*journal_sequence_number=*/0)),
+              StatusIs(error::FAILED_PRECONDITION));
+}
+
+TEST(DispatcherState, RestoreCheckpointWithUnknownIteration) {
+  DispatcherStateCheckpoint checkpoint;
+  checkpoint.add_tasks()->mutable_create_task()->set_iteration_id(1);
+  DispatcherState state;
+  EXPECT_THAT(state.Restore(checkpoint), StatusIs(error::DATA_LOSS));
+}
+
+// Compares restoring the state of a dispatcher by replaying its journal, and
+// by reading a checkpoint written after the same updates.
+void BM_RestoreFromJournal(::testing::benchmark::State& state) {
+  const int64_t num_updates = state.range(0);
+  std::string journal_dir;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&journal_dir));
+  {
+    FileJournalWriter writer(Env::Default(), journal_dir);
+    for (const Update& update : RecoveryBenchmarkJournal(num_updates)) {
+      TF_ASSERT_OK(writer.Write(update));
+    }
+  }
+
+  for (auto s : state) {
+    DispatcherState dispatcher_state;
+    FileJournalReader reader(Env::Default(), journal_dir);
+    Update update;
+    bool end_of_journal = false;
+    TF_ASSERT_OK(reader.Read(update, end_of_journal));
+    while (!end_of_journal) {
+      TF_ASSERT_OK(dispatcher_state.Apply(update));
+      TF_ASSERT_OK(reader.Read(update, end_of_journal));
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * num_updates);
+  int64_t undeleted_files, undeleted_dirs;
+  TF_ASSERT_OK(Env::Default()->DeleteRecursively(journal_dir, &undeleted_files,
+                                                 &undeleted_dirs));
+}
+
+void BM_RestoreFromCheckpoint(::testing::benchmark::State& state) {
+  const int64_t num_updates = state.range(0);
+  std::string journal_dir;
+  ASSERT_TRUE(Env::Default()->LocalTempFilename(&journal_dir));
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(journal_dir));
+  {
+    DispatcherState dispatcher_state;
+    for (const Update& update : RecoveryBenchmarkJournal(num_updates)) {
+      TF_ASSERT_OK(dispatcher_state.Apply(update));
+    }
+    TF_ASSERT_OK(WriteDispatcherStateCheckpoint(
+        Env::Default(), journal_dir,
+        dispatcher_state.Checkpoint(/*journal_sequence_number=*/1)));
+  }
+
+  for (auto s : state) {
+    absl::StatusOr<DispatcherStateCheckpoint> checkpoint =
+        ReadDispatcherStateCheckpoint(Env::Default(), journal_dir);
+    TF_ASSERT_OK(checkpoint.status());
+    DispatcherState dispatcher_state;
+    TF_ASSERT_OK(dispatcher_state.Restore(*checkpoint));
+  }
+  state.SetItemsProcessed(state.iterations() * num_updates);
+  int64_t undeleted_files, undeleted_dirs;
+  TF_ASSERT_OK(Env::Default()->DeleteRecursively(journal_dir, &undeleted_files,
+                                                 &undeleted_dirs));
+}
+
+BENCHMARK(BM_RestoreFromJournal)->Arg(1000)->Arg(100000)->Arg(1000000);
+BENCHMARK(BM_RestoreFromCheckpoint)->Arg(1000)->Arg(100000)->Arg(1000000);
+
 }  // namespace data
 }  // namespace tensorflow
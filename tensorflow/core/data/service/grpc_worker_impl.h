@@ -61,6 +61,7 @@ class GrpcWorkerImpl : public WorkerService::Service {
                         method##Response* response) override;
   HANDLER(ProcessTask);
   HANDLER(GetElement);
+  HANDLER(GetElements);
   HANDLER(GetWorkerTasks);
   HANDLER(GetSnapshotTaskProgresses);
 #undef HANDLER
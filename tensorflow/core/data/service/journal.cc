@@ -16,12 +16,15 @@ limitations under the License.
 #include "tensorflow/core/data/service/journal.h"
 
 #include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/io/record_reader.h"
 #include "tensorflow/core/lib/io/record_writer.h"
@@ -35,10 +38,15 @@ namespace data {
 
 namespace {
 constexpr StringPiece kJournal = "journal";
+constexpr StringPiece kCheckpoint = "checkpoint";
+// Suffix of checkpoints that are being written.
+constexpr StringPiece kTempSuffix = ".tmp";
 
+// Parses the sequence number of a journal file or checkpoint.
 absl::Status ParseSequenceNumber(const std::string& journal_file,
                                  int64_t* sequence_number) {
-  if (!RE2::FullMatch(journal_file, ".*_(\\d+)", sequence_number)) {
+  if (!RE2::FullMatch(journal_file, ".*_(\\d+)(?:\\.tmp)?",
+                      sequence_number)) {
     return errors::InvalidArgument("Failed to parse journal file name: ",
                                    journal_file);
   }
@@ -52,6 +60,74 @@ std::string DataServiceJournalFile(const std::string& journal_dir,
                       absl::StrCat(kJournal, "_", sequence_number));
 }
 
+std::string DispatcherStateCheckpointFile(const std::string& journal_dir,
+                                          int64_t sequence_number) {
+  return io::JoinPath(journal_dir,
+                      absl::StrCat(kCheckpoint, "_", sequence_number));
+}
+
+absl::Status WriteDispatcherStateCheckpoint(
+    Env* env, const std::string& journal_dir,
+    const DispatcherStateCheckpoint& checkpoint) {
+  const int64_t sequence_number = checkpoint.journal_sequence_number();
+  std::string checkpoint_file =
+      DispatcherStateCheckpointFile(journal_dir, sequence_number);
+  std::string temp_file = absl::StrCat(checkpoint_file, kTempSuffix);
+  std::string serialized;
+  if (!checkpoint.SerializeToString(&serialized)) {
+    return errors::Internal("Failed to serialize dispatcher state checkpoint ",
+                            checkpoint_file);
+  }
+  std::unique_ptr<WritableFile> file;
+  TF_RETURN_IF_ERROR(env->NewWritableFile(temp_file, &file));
+  TF_RETURN_IF_ERROR(file->Append(serialized));
+  TF_RETURN_IF_ERROR(file->Sync());
+  TF_RETURN_IF_ERROR(file->Close());
+  TF_RETURN_IF_ERROR(env->RenameFile(temp_file, checkpoint_file));
+  VLOG(1) << "Wrote dispatcher state checkpoint " << checkpoint_file << " ("
+          << serialized.size() << " bytes)";
+
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  for (const auto& child : files) {
+    int64_t child_sequence_number;
+    if (ParseSequenceNumber(child, &child_sequence_number).ok() &&
+        child_sequence_number < sequence_number) {
+      TF_RETURN_IF_ERROR(env->DeleteFile(io::JoinPath(journal_dir, child)));
+    }
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<DispatcherStateCheckpoint> ReadDispatcherStateCheckpoint(
+    Env* env, const std::string& journal_dir) {
+  std::vector<std::string> files;
+  TF_RETURN_IF_ERROR(env->GetChildren(journal_dir, &files));
+  const std::string pattern = absl::StrCat(kCheckpoint, "_(\\d+)");
+  int64_t latest_sequence_number = -1;
+  for (const auto& file : files) {
+    int64_t sequence_number;
+    if (RE2::FullMatch(file, pattern, &sequence_number)) {
+      latest_sequence_number =
+          std::max(latest_sequence_number, sequence_number);
+    }
+  }
+  if (latest_sequence_number < 0) {
+    return errors::NotFound("No dispatcher state checkpoint found in ",
+                            journal_dir);
+  }
+  std::string checkpoint_file =
+      DispatcherStateCheckpointFile(journal_dir, latest_sequence_number);
+  DispatcherStateCheckpoint checkpoint;
+  TF_RETURN_IF_ERROR(ReadBinaryProto(env, checkpoint_file, &checkpoint));
+  if (checkpoint.journal_sequence_number() != latest_sequence_number) {
+    return errors::DataLoss("Dispatcher state checkpoint ", checkpoint_file,
+                            " has journal sequence number ",
+                            checkpoint.journal_sequence_number());
+  }
+  return checkpoint;
+}
+
 FileJournalWriter::FileJournalWriter(Env* env, const std::string& journal_dir)
     : env_(env), journal_dir_(journal_dir) {}
 
@@ -62,16 +138,32 @@ absl::Status FileJournalWriter::EnsureInitialized() {
   std::vector<std::string> journal_files;
   TF_RETURN_IF_ERROR(env_->RecursivelyCreateDir(journal_dir_));
   TF_RETURN_IF_ERROR(env_->GetChildren(journal_dir_, &journal_files));
+  // Checkpoints count as well, so that new journal files are never covered by
+  // existing checkpoints.
   int64_t latest_sequence_number = -1;
   for (const auto& file : journal_files) {
     int64_t sequence_number;
     TF_RETURN_IF_ERROR(ParseSequenceNumber(file, &sequence_number));
     latest_sequence_number = std::max(latest_sequence_number, sequence_number);
   }
+  return OpenFile(latest_sequence_number + 1);
+}
+
+absl::StatusOr<int64_t> FileJournalWriter::StartNewFile() {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  TF_RETURN_IF_ERROR(writer_->Close());
+  writer_.reset();
+  TF_RETURN_IF_ERROR(file_->Close());
+  TF_RETURN_IF_ERROR(OpenFile(sequence_number_ + 1));
+  return sequence_number_;
+}
+
+absl::Status FileJournalWriter::OpenFile(int64_t sequence_number) {
   std::string journal_file =
-      DataServiceJournalFile(journal_dir_, latest_sequence_number + 1);
+      DataServiceJournalFile(journal_dir_, sequence_number);
   TF_RETURN_IF_ERROR(env_->NewAppendableFile(journal_file, &file_));
   writer_ = std::make_unique<io::RecordWriter>(file_.get());
+  sequence_number_ = sequence_number;
   VLOG(1) << "Created journal writer to write to " << journal_file;
   return absl::OkStatus();
 }
@@ -92,14 +184,17 @@ absl::Status FileJournalWriter::Write(const Update& update) {
   return absl::OkStatus();
 }
 
-FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir)
-    : env_(env), journal_dir_(journal_dir) {}
+FileJournalReader::FileJournalReader(Env* env, StringPiece journal_dir,
+                                     int64_t first_sequence_number)
+    : env_(env),
+      journal_dir_(journal_dir),
+      sequence_number_(first_sequence_number) {}
 
 absl::Status FileJournalReader::EnsureInitialized() {
   if (reader_) {
     return absl::OkStatus();
   }
-  return UpdateFile(DataServiceJournalFile(journal_dir_, 0));
+  return UpdateFile(DataServiceJournalFile(journal_dir_, sequence_number_));
 }
 
 absl::Status FileJournalReader::Read(Update& update, bool& end_of_journal) {
@@ -15,9 +15,11 @@ limitations under the License.
 #ifndef TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 #define TENSORFLOW_CORE_DATA_SERVICE_JOURNAL_H_
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "absl/status/statusor.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status.h"
 #include "tensorflow/core/lib/io/record_reader.h"
@@ -31,6 +33,23 @@ namespace data {
 std::string DataServiceJournalFile(const std::string& journal_dir,
                                    int64_t sequence_number);
 
+// Returns the location of the dispatcher state checkpoint covering the journal
+// files before `sequence_number`.
+std::string DispatcherStateCheckpointFile(const std::string& journal_dir,
+                                          int64_t sequence_number);
+
+// Atomically writes `checkpoint` to the journal directory, then deletes the
+// journal files and older checkpoints it supersedes, i.e. the ones with
+// sequence numbers smaller than `checkpoint.journal_sequence_number()`.
+absl::Status WriteDispatcherStateCheckpoint(
+    Env* env, const std::string& journal_dir,
+    const DispatcherStateCheckpoint& checkpoint);
+
+// Reads the latest dispatcher state checkpoint in the journal directory.
+// Returns NOT_FOUND if there is no checkpoint.
+absl::StatusOr<DispatcherStateCheckpoint> ReadDispatcherStateCheckpoint(
+    Env* env, const std::string& journal_dir);
+
 // Interface for writing to a journal.
 class JournalWriter {
  public:
@@ -39,6 +58,9 @@ class JournalWriter {
   virtual absl::Status Write(const Update& update) = 0;
   // Initializes the writer if it is not yet initialized.
   virtual absl::Status EnsureInitialized() = 0;
+  // Closes the current journal file and writes the following updates to a new
+  // one. Returns the sequence number of the new file.
+  virtual absl::StatusOr<int64_t> StartNewFile() = 0;
 };
 
 // FileJournalWriter is not thread-safe, requiring external synchronization when
@@ -57,6 +79,10 @@ class JournalWriter {
 // "journal_0", "journal_1", and "journal_2", the writer will write to
 // "journal_3". The writer will flush updates as they are written, so that they
 // can be stored durably in case of machine failure.
+//
+// The directory may also contain dispatcher state checkpoints, e.g.
+// "checkpoint_2" replaces "journal_0" and "journal_1" once it is written. See
+// `WriteDispatcherStateCheckpoint`.
 class FileJournalWriter : public JournalWriter {
  public:
   // Creates a journal writer to write to the given journal directory.
@@ -68,10 +94,16 @@ class FileJournalWriter : public JournalWriter {
 
   absl::Status Write(const Update& update) override;
   absl::Status EnsureInitialized() override;
+  absl::StatusOr<int64_t> StartNewFile() override;
 
  private:
+  // Opens the journal file with the given sequence number for writing.
+  absl::Status OpenFile(int64_t sequence_number);
+
   Env* env_;
   const std::string journal_dir_;
+  // Sequence number of current journal file.
+  int64_t sequence_number_ = -1;
   std::unique_ptr<WritableFile> file_;
   std::unique_ptr<io::RecordWriter> writer_;
 };
@@ -89,10 +121,12 @@ class JournalReader {
 // used by multiple threads.
 //
 // The journal reader reads through all journal files in the configured journal
-// directory, in order of their sequence numbers. See FileJournalWriter above.
+// directory, in order of their sequence numbers, starting from
+// `first_sequence_number`. See FileJournalWriter above.
 class FileJournalReader : public JournalReader {
  public:
-  explicit FileJournalReader(Env* env, StringPiece journal_dir);
+  explicit FileJournalReader(Env* env, StringPiece journal_dir,
+                             int64_t first_sequence_number = 0);
   FileJournalReader(const FileJournalReader&) = delete;
   FileJournalReader& operator=(const FileJournalReader&) = delete;
 
@@ -107,7 +141,7 @@ class FileJournalReader : public JournalReader {
   Env* env_;
   const std::string journal_dir_;
   // Sequence number of current journal file.
-  int64_t sequence_number_ = 0;
+  int64_t sequence_number_;
   std::unique_ptr<RandomAccessFile> file_;
   std::unique_ptr<io::SequentialRecordReader> reader_;
 };
@@ -20,11 +20,13 @@ limitations under the License.
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "tensorflow/core/data/service/common.pb.h"
 #include "tensorflow/core/data/service/journal.pb.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/statusor.h"
 #include "tensorflow/core/platform/test.h"
 #include "tensorflow/core/protobuf/data_service.pb.h"
 
@@ -32,7 +34,9 @@ namespace tensorflow {
 namespace data {
 
 namespace {
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
+using ::testing::UnorderedElementsAre;
 
 bool NewJournalDir(std::string& journal_dir) {
   std::string filename = testing::TmpDir();
@@ -68,8 +72,9 @@ Update MakeRegisterDatasetUpdate() {
 }
 
 absl::Status CheckJournalContent(StringPiece journal_dir,
-                                 const std::vector<Update>& expected) {
-  FileJournalReader reader(Env::Default(), journal_dir);
+                                 const std::vector<Update>& expected,
+                                 int64_t first_sequence_number = 0) {
+  FileJournalReader reader(Env::Default(), journal_dir, first_sequence_number);
   for (const auto& update : expected) {
     Update result;
     bool end_of_journal = true;
@@ -165,5 +170,87 @@ TEST(Journal, InvalidRecordData) {
   EXPECT_THAT(s.message(), HasSubstr("Failed to parse journal record"));
   EXPECT_EQ(s.code(), error::DATA_LOSS);
 }
+
+TEST(Journal, StartNewFile) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+  TF_ASSERT_OK_AND_ASSIGN(int64_t sequence_number, writer.StartNewFile());
+  EXPECT_EQ(sequence_number, 1);
+  TF_EXPECT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeCreateIterationUpdate(), MakeRegisterDatasetUpdate(),
+                    MakeFinishTaskUpdate()}));
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeRegisterDatasetUpdate(), MakeFinishTaskUpdate()},
+      /*first_sequence_number=*/1));
+}
+
+TEST(Journal, CheckpointTruncatesJournal) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  FileJournalWriter writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(writer.Write(MakeCreateIterationUpdate()));
+  TF_ASSERT_OK(writer.StartNewFile().status());
+  TF_EXPECT_OK(writer.Write(MakeRegisterDatasetUpdate()));
+  TF_ASSERT_OK_AND_ASSIGN(int64_t sequence_number, writer.StartNewFile());
+  TF_EXPECT_OK(writer.Write(MakeFinishTaskUpdate()));
+
+  DispatcherStateCheckpoint checkpoint;
+  checkpoint.set_journal_sequence_number(sequence_number);
+  checkpoint.set_next_available_task_id(9);
+  TF_ASSERT_OK(
+      WriteDispatcherStateCheckpoint(Env::Default(), journal_dir, checkpoint));
+  std::vector<std::string> files;
+  TF_ASSERT_OK(Env::Default()->GetChildren(journal_dir, &files));
+  EXPECT_THAT(files, UnorderedElementsAre("checkpoint_2", "journal_2"));
+
+  TF_ASSERT_OK_AND_ASSIGN(
+      DispatcherStateCheckpoint restored,
+      ReadDispatcherStateCheckpoint(Env::Default(), journal_dir));
+  EXPECT_EQ(restored.SerializeAsString(), checkpoint.SerializeAsString());
+  TF_EXPECT_OK(CheckJournalContent(journal_dir, {MakeFinishTaskUpdate()},
+                                   sequence_number));
+
+  // New writers continue after both the journal and the checkpoint.
+  FileJournalWriter new_writer(Env::Default(), journal_dir);
+  TF_EXPECT_OK(new_writer.Write(MakeCreateIterationUpdate()));
+  TF_EXPECT_OK(CheckJournalContent(
+      journal_dir, {MakeFinishTaskUpdate(), MakeCreateIterationUpdate()},
+      sequence_number));
+}
+
+TEST(Journal, ReadLatestCheckpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(journal_dir));
+  // Writing the checkpoint for journal files before 3 deletes the older one.
+  for (int64_t sequence_number : {1, 3}) {
+    DispatcherStateCheckpoint checkpoint;
+    checkpoint.set_journal_sequence_number(sequence_number);
+    TF_ASSERT_OK(WriteDispatcherStateCheckpoint(Env::Default(), journal_dir,
+                                                checkpoint));
+  }
+  std::vector<std::string> files;
+  TF_ASSERT_OK(Env::Default()->GetChildren(journal_dir, &files));
+  EXPECT_THAT(files, ElementsAre("checkpoint_3"));
+  TF_ASSERT_OK_AND_ASSIGN(
+      DispatcherStateCheckpoint checkpoint,
+      ReadDispatcherStateCheckpoint(Env::Default(), journal_dir));
+  EXPECT_EQ(checkpoint.journal_sequence_number(), 3);
+}
+
+TEST(Journal, MissingCheckpoint) {
+  std::string journal_dir;
+  EXPECT_TRUE(NewJournalDir(journal_dir));
+  EXPECT_TRUE(absl::IsNotFound(
+      ReadDispatcherStateCheckpoint(Env::Default(), journal_dir).status()));
+  TF_ASSERT_OK(Env::Default()->RecursivelyCreateDir(journal_dir));
+  EXPECT_TRUE(absl::IsNotFound(
+      ReadDispatcherStateCheckpoint(Env::Default(), journal_dir).status()));
+}
 }  // namespace data
 }  // namespace tensorflow
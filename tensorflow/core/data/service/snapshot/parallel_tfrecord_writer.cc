@@ -122,6 +122,13 @@ absl::Status ParallelTFRecordWriter::WriteFile() ABSL_LOCKS_EXCLUDED(mu_) {
     TF_RETURN_IF_ERROR(WriteRecord(filename, writer));
   }
   TF_RETURN_IF_ERROR(writer.Close());
+  {
+    absl::MutexLock l(&mu_);
+    auto iterator = file_stats_.find(filename);
+    if (iterator != file_stats_.end()) {
+      iterator->second.restart_points = writer.RestartPoints();
+    }
+  }
   return DeleteEmptyFile(filename);
 }
 
@@ -139,7 +146,7 @@ bool ParallelTFRecordWriter::ShouldWriteFile(const std::string& filename) const
 absl::Status ParallelTFRecordWriter::WriteRecord(
     const std::string& filename, snapshot_util::TFRecordWriter& writer) {
   TF_ASSIGN_OR_RETURN(std::optional<std::vector<Tensor>> record,
-                      GetNextRecord(filename));
+                      GetNextRecord(filename, writer.Offset()));
   if (!record.has_value()) {
     return absl::OkStatus();
   }
@@ -151,7 +158,8 @@ absl::Status ParallelTFRecordWriter::WriteRecord(
 }
 
 absl::StatusOr<std::optional<std::vector<Tensor>>>
-ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
+ParallelTFRecordWriter::GetNextRecord(const std::string& filename,
+                                      uint64_t offset)
     ABSL_LOCKS_EXCLUDED(mu_) {
   absl::MutexLock l(&mu_);
   while (status_.ok() && !finalized_ && buffer_.empty()) {
@@ -166,8 +174,10 @@ ParallelTFRecordWriter::GetNextRecord(const std::string& filename)
   ByteSize estimated_size = EstimatedSize(record);
   LOG_EVERY_N_SEC(INFO, 1) << "Writing TFRecord of " << estimated_size
                            << " to file " << filename << "*.";
-  ++file_stats_[filename].num_records;
-  file_stats_[filename].estimated_size += estimated_size;
+  FileStats& file_stats = file_stats_[filename];
+  ++file_stats.num_records;
+  file_stats.estimated_size += estimated_size;
+  file_stats.record_offsets.push_back(offset);
   buffer_.pop_front();
   ready_to_push_.SignalAll();
   return record;
@@ -70,10 +70,15 @@ class ParallelTFRecordWriter {
   // blocks until there is enough space to buffer the record.
   absl::Status Write(std::vector<Tensor> record);
 
-  // File stats: number of records in a file and the estimated size of the file.
+  // File stats: number of records in a file, the estimated size of the file,
+  // and the offsets of the records and the restart points of the file, which
+  // can be passed to `snapshot_util::TFRecordReader::Seek` to read the records
+  // out of order.
   struct FileStats {
     int64_t num_records = 0;
     ByteSize estimated_size;
+    std::vector<uint64_t> record_offsets;
+    std::vector<snapshot_util::RestartPoint> restart_points;
   };
   using FileToStatsMap = absl::flat_hash_map<std::string, FileStats>;
 
@@ -101,10 +106,10 @@ class ParallelTFRecordWriter {
   absl::Status WriteRecord(const std::string& filename,
                            snapshot_util::TFRecordWriter& writer);
 
-  // Gets the next record from the buffer to write. Returns `std::nullopt` if
-  // there are no more records to write.
+  // Gets the next record from the buffer to write at `offset` of `filename`.
+  // Returns `std::nullopt` if there are no more records to write.
   absl::StatusOr<std::optional<std::vector<Tensor>>> GetNextRecord(
-      const std::string& filename);
+      const std::string& filename, uint64_t offset);
 
   // Deletes the file if it's empty.
   absl::Status DeleteEmptyFile(const std::string& filename);
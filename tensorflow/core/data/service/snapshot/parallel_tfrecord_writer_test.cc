@@ -124,6 +124,29 @@ absl::StatusOr<std::vector<T>> ReadRecords(const std::string& filename,
   return result;
 }
 
+// Reads the records at `offsets` of `filename`, in reverse order.
+template <class T>
+absl::StatusOr<std::vector<T>> ReadRecordsAtOffsets(
+    const std::string& filename, const std::string& compression,
+    const std::vector<uint64_t>& offsets,
+    const std::vector<snapshot_util::RestartPoint>& restart_points) {
+  snapshot_util::TFRecordReader reader(filename, compression,
+                                       DataTypeVector{DT_INT64});
+  TF_RETURN_IF_ERROR(reader.Initialize(tsl::Env::Default()));
+
+  std::vector<T> result;
+  for (auto it = offsets.rbegin(); it != offsets.rend(); ++it) {
+    reader.Seek(*it, restart_points);
+    std::vector<Tensor> record;
+    TF_RETURN_IF_ERROR(reader.ReadTensors(&record));
+    for (const Tensor& tensor : record) {
+      result.push_back(tensor.unaligned_flat<T>().data()[0]);
+    }
+  }
+  absl::c_reverse(result);
+  return result;
+}
+
 template <class T>
 absl::StatusOr<std::vector<T>> ReadRecords(
     const std::vector<std::string>& filenames, const std::string& compression) {
@@ -185,6 +208,11 @@ class ParallelTFRecordWriterParamTest
     EXPECT_EQ(absl::c_accumulate(file_stats, 0, add_num_elements),
               expected_num_elements);
 
+    // Each record has an offset.
+    for (const ParallelTFRecordWriter::FileStats& stats : file_stats) {
+      EXPECT_THAT(stats.record_offsets, SizeIs(stats.num_records));
+    }
+
     // There should be no empty file.
     EXPECT_THAT(
         file_stats,
@@ -227,6 +255,28 @@ TEST_P(ParallelTFRecordWriterParamTest, WriteRecords) {
   VerifyFileStats(stats, NumElements());
 }
 
+TEST_P(ParallelTFRecordWriterParamTest, SeekRecords) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
+  ParallelTFRecordWriter parallel_tfrecord_writer(
+      test_dir, Compression(), tsl::Env::Default(), MaxFileSize(),
+      NumWriteThreads(), BufferSize());
+
+  RangeIterator range_iterator(NumElements());
+  TF_ASSERT_OK_AND_ASSIGN(
+      ParallelTFRecordWriter::FileToStatsMap file_stats,
+      WriteRecords(parallel_tfrecord_writer, range_iterator));
+
+  for (const auto& [file, stats] : file_stats) {
+    TF_ASSERT_OK_AND_ASSIGN(std::vector<int64_t> records,
+                            ReadRecords<int64_t>(file, Compression()));
+    EXPECT_THAT(
+        ReadRecordsAtOffsets<int64_t>(file, Compression(),
+                                      stats.record_offsets,
+                                      stats.restart_points),
+        IsOkAndHolds(records));
+  }
+}
+
 TEST_P(ParallelTFRecordWriterParamTest, ConcurrentWrites) {
   TF_ASSERT_OK_AND_ASSIGN(std::string test_dir, TestDir());
   ParallelTFRecordWriter parallel_tfrecord_writer(
@@ -43,6 +43,7 @@ constexpr const char kSplitsDirectoryName[] = "splits";
 constexpr const char kCheckpointsDirectoryName[] = "checkpoints";
 constexpr const char kCommittedChunksDirectoryName[] = "chunks";
 constexpr const char kUncommittedChunksDirectoryName[] = "uncommitted_chunks";
+constexpr const char kCommittedChunkIndicesDirectoryName[] = "chunk_indices";
 constexpr int64_t kUnknownNumElements = -1;
 
 }  // namespace
@@ -233,5 +234,15 @@ std::string UncommittedChunksDirectory(absl::string_view snapshot_path,
   return tsl::io::JoinPath(StreamDirectory(snapshot_path, stream_index),
                            kUncommittedChunksDirectoryName);
 }
+
+std::string CommittedChunkIndicesDirectory(absl::string_view snapshot_path) {
+  return tsl::io::JoinPath(snapshot_path, kCommittedChunkIndicesDirectoryName);
+}
+
+std::string CommittedChunkIndexFilePath(absl::string_view snapshot_path,
+                                        absl::string_view chunk_filename) {
+  return tsl::io::JoinPath(CommittedChunkIndicesDirectory(snapshot_path),
+                           chunk_filename);
+}
 }  // namespace data
 }  // namespace tensorflow
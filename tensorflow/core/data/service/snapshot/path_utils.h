@@ -128,6 +128,15 @@ std::string CommittedChunksDirectory(absl::string_view snapshot_path);
 std::string UncommittedChunksDirectory(absl::string_view snapshot_path,
                                        int64_t stream_index);
 
+// Returns the directory path for the record offset indices of committed
+// chunks.
+std::string CommittedChunkIndicesDirectory(absl::string_view snapshot_path);
+
+// Returns the path of the record offset index of the committed chunk
+// `chunk_filename`.
+std::string CommittedChunkIndexFilePath(absl::string_view snapshot_path,
+                                        absl::string_view chunk_filename);
+
 }  // namespace data
 }  // namespace tensorflow
 
@@ -260,6 +260,17 @@ TEST(PathUtilsTest, UncommittedChunksDirectory) {
       MatchesRegex("/path/to/snapshot.streams.stream_0.uncommitted_chunks"));
 }
 
+TEST(PathUtilsTest, CommittedChunkIndicesDirectory) {
+  EXPECT_THAT(CommittedChunkIndicesDirectory("/path/to/snapshot"),
+              MatchesRegex("/path/to/snapshot.chunk_indices"));
+}
+
+TEST(PathUtilsTest, CommittedChunkIndexFilePath) {
+  EXPECT_THAT(
+      CommittedChunkIndexFilePath("/path/to/snapshot", "chunk_0_1_10"),
+      MatchesRegex("/path/to/snapshot.chunk_indices.chunk_0_1_10"));
+}
+
 }  // namespace
 }  // namespace data
 }  // namespace tensorflow
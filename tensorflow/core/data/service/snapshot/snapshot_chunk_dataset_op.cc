@@ -12,15 +12,21 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "tensorflow/core/data/global_shuffle_utils.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/service/snapshot/path_utils.h"
 #include "tensorflow/core/data/snapshot_utils.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -29,8 +35,13 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/platform/mutex.h"
+#include "tensorflow/core/platform/thread_annotations.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tsl/platform/env.h"
+#include "tsl/platform/errors.h"
 #include "tsl/platform/path.h"
+#include "tsl/platform/statusor.h"
 #include "tsl/platform/tstring.h"
 
 namespace tensorflow {
@@ -46,12 +57,46 @@ constexpr const char* const kSnapshotChunkDataset = "SnapshotChunkDataset";
 
 constexpr int64_t kTFRecordReaderOutputBufferSize = 512 << 20;  // 512MB
 
+// Maximum number of readers kept for `Get` calls between calls.
+constexpr size_t kMaxIdleRandomAccessReaders = 4;
+
 absl::string_view GetSnapshotPath(absl::string_view chunk_file) {
   // Snapshot chunks are placed in snapshot_path/chunks/chunk_x.
   absl::string_view chunk_dir = tsl::io::Dirname(chunk_file);
   return tsl::io::Dirname(chunk_dir);
 }
 
+// Record offset index of a chunk file.
+struct ChunkIndex {
+  // Offsets of the elements, ordered by element index.
+  std::vector<uint64_t> element_offsets;
+  // Restart points of the compressed chunk file, ordered by offset.
+  std::vector<snapshot_util::RestartPoint> restart_points;
+};
+
+// Reads the record offset index of `chunk_file`, written when the chunk was
+// committed. Returns `std::nullopt` if the chunk does not have an index, e.g.
+// if it was committed by a recovered stream or an older writer.
+absl::StatusOr<std::optional<ChunkIndex>> ReadChunkIndex(
+    tsl::Env* env, absl::string_view chunk_file) {
+  const std::string index_file = TranslateFileName(CommittedChunkIndexFilePath(
+      GetSnapshotPath(chunk_file), tsl::io::Basename(chunk_file)));
+  experimental::SnapshotChunkIndex index;
+  absl::Status status = ReadBinaryProto(env, index_file, &index);
+  if (absl::IsNotFound(status)) {
+    return std::nullopt;
+  }
+  TF_RETURN_IF_ERROR(status);
+  ChunkIndex chunk_index;
+  chunk_index.element_offsets.assign(index.element_offsets().begin(),
+                                     index.element_offsets().end());
+  for (const auto& restart_point : index.restart_points()) {
+    chunk_index.restart_points.push_back(
+        {restart_point.file_offset(), restart_point.record_offset()});
+  }
+  return chunk_index;
+}
+
 // A reader dataset is responsible for reading one chunk file of a snapshot.
 // TODO(b/250921378): Merge this with `snapshot_util::Reader::Dataset`.
 class SnapshotChunkDatasetOp : public DatasetOpKernel {
@@ -72,12 +117,15 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
  public:
   Dataset(DatasetContext&& ctx, const std::string& chunk_file,
           const std::string& compression, const DataTypeVector& dtypes,
-          const std::vector<PartialTensorShape>& shapes)
+          const std::vector<PartialTensorShape>& shapes,
+          std::optional<ChunkIndex> index, tsl::Env* env)
       : DatasetBase(std::move(ctx)),
         chunk_file_(chunk_file),
         compression_(compression),
         dtypes_(dtypes),
-        shapes_(shapes) {}
+        shapes_(shapes),
+        index_(std::move(index)),
+        env_(env) {}
 
   const DataTypeVector& output_dtypes() const override { return dtypes_; }
 
@@ -94,6 +142,42 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
 
   absl::Status CheckExternalState() const override { return absl::OkStatus(); }
 
+  int64_t CardinalityInternal(CardinalityOptions options) const override {
+    if (!index_.has_value()) {
+      return kUnknownCardinality;
+    }
+    return index_->element_offsets.size();
+  }
+
+  absl::Status Get(OpKernelContext* ctx, int64_t index,
+                   std::vector<Tensor>* out_tensors) const override {
+    return Get(AnyContext(ctx), index, out_tensors);
+  }
+
+  absl::Status Get(AnyContext ctx, int64_t index,
+                   std::vector<Tensor>* out_tensors) const override {
+    TF_RETURN_IF_ERROR(CheckRandomAccessCompatible(index));
+    TF_ASSIGN_OR_RETURN(std::unique_ptr<snapshot_util::TFRecordReader> reader,
+                        GetRandomAccessReader());
+    reader->Seek(index_->element_offsets[index], index_->restart_points);
+    out_tensors->clear();
+    TF_RETURN_WITH_CONTEXT_IF_ERROR(reader->ReadTensors(out_tensors),
+                                    " Failed to read element ", index,
+                                    " of tf.data snapshot file: ", chunk_file_);
+    ReturnRandomAccessReader(std::move(reader));
+    return absl::OkStatus();
+  }
+
+  absl::Status RandomIndexingCompatible() const override {
+    if (!index_.has_value()) {
+      return absl::FailedPreconditionError(absl::StrCat(
+          "tf.data snapshot chunk ", chunk_file_,
+          " does not have a record offset index, which is required for "
+          "random access."));
+    }
+    return absl::OkStatus();
+  }
+
  protected:
   absl::Status AsGraphDefInternal(SerializationContext* ctx,
                                   DatasetGraphDefBuilder* b,
@@ -120,10 +204,39 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
   }
 
  private:
+  // Returns the most recently returned idle reader, or a new reader if there
+  // are none. Concurrent `Get` calls read with different readers.
+  absl::StatusOr<std::unique_ptr<snapshot_util::TFRecordReader>>
+  GetRandomAccessReader() const {
+    {
+      mutex_lock l(mu_);
+      if (!idle_readers_.empty()) {
+        std::unique_ptr<snapshot_util::TFRecordReader> reader =
+            std::move(idle_readers_.back());
+        idle_readers_.pop_back();
+        return reader;
+      }
+    }
+    auto reader = std::make_unique<snapshot_util::TFRecordReader>(
+        TranslateFileName(chunk_file_), compression_, dtypes_,
+        kTFRecordReaderOutputBufferSize);
+    TF_RETURN_IF_ERROR(reader->Initialize(env_));
+    return reader;
+  }
+
+  void ReturnRandomAccessReader(
+      std::unique_ptr<snapshot_util::TFRecordReader> reader) const {
+    mutex_lock l(mu_);
+    if (idle_readers_.size() < kMaxIdleRandomAccessReaders) {
+      idle_readers_.push_back(std::move(reader));
+    }
+  }
+
   class Iterator : public DatasetIterator<Dataset> {
    public:
     explicit Iterator(const Params& params)
-        : DatasetIterator<Dataset>(params) {}
+        : DatasetIterator<Dataset>(params),
+          global_shuffle_iterator_(dataset()) {}
 
     ~Iterator() override { RecordBytesRead(); }
 
@@ -138,6 +251,11 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     absl::Status GetNextInternal(IteratorContext* ctx,
                                  std::vector<Tensor>* out_tensors,
                                  bool* end_of_sequence) override {
+      if (ctx->index_mapper() != nullptr) {
+        return global_shuffle_iterator_.GetNext(ctx, out_tensors,
+                                                end_of_sequence);
+      }
+
       *end_of_sequence = false;
       absl::Status status = reader_->ReadTensors(out_tensors);
       if (absl::IsOutOfRange(status)) {
@@ -155,11 +273,15 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
                               IteratorStateWriter* writer) override {
       TF_RETURN_IF_ERROR(
           writer->WriteScalar(full_name(kStartIndex), start_index_));
+      TF_RETURN_IF_ERROR(global_shuffle_iterator_.Save(prefix(), ctx, writer));
       return absl::OkStatus();
     }
 
     absl::Status RestoreInternal(IteratorContext* ctx,
                                  IteratorStateReader* reader) override {
+      if (ctx->restored_element_count().has_value()) {
+        return global_shuffle_iterator_.Restore(prefix(), ctx, reader);
+      }
       TF_RETURN_IF_ERROR(
           reader->ReadScalar(full_name(kStartIndex), &start_index_));
       TF_RETURN_IF_ERROR(Initialize(ctx));
@@ -167,10 +289,15 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
-    // TODO(b/250921378): Optimize this to not parse every single element. We
-    // may consider switching the data format to ArrayRecords so we can use the
-    // index to jump straight to the starting record.
+    // Uses the record offset index to jump straight to the starting record if
+    // the chunk has one. Otherwise, parses every element before it.
     absl::Status AdvanceToStartIndex(IteratorContext* ctx) {
+      const std::optional<ChunkIndex>& index = dataset()->index_;
+      if (index.has_value() && start_index_ < index->element_offsets.size()) {
+        reader_->Seek(index->element_offsets[start_index_],
+                      index->restart_points);
+        return absl::OkStatus();
+      }
       for (int64_t i = 0; i < start_index_; ++i) {
         std::vector<Tensor> unused;
         TF_RETURN_IF_ERROR(reader_->ReadTensors(&unused));
@@ -186,12 +313,22 @@ class SnapshotChunkDatasetOp::Dataset : public DatasetBase {
 
     std::unique_ptr<snapshot_util::TFRecordReader> reader_;
     int64_t start_index_ = 0;
+    GlobalShuffleIterator global_shuffle_iterator_;
   };
 
   const tstring chunk_file_;
   const tstring compression_;
   const DataTypeVector dtypes_;
   const std::vector<PartialTensorShape> shapes_;
+  // Record offset index of the chunk, if the chunk has one.
+  const std::optional<ChunkIndex> index_;
+  tsl::Env* const env_;
+
+  // Readers for `Get` that are not in use. Each `Get` call takes one, seeks to
+  // the requested element, and returns it after reading.
+  mutable mutex mu_;
+  mutable std::vector<std::unique_ptr<snapshot_util::TFRecordReader>>
+      idle_readers_ TF_GUARDED_BY(mu_);
 };
 
 SnapshotChunkDatasetOp::SnapshotChunkDatasetOp(OpKernelConstruction* ctx)
@@ -205,10 +342,13 @@ void SnapshotChunkDatasetOp::MakeDataset(OpKernelContext* ctx,
                                          DatasetBase** output) {
   tstring chunk_file;
   OP_REQUIRES_OK(ctx, ParseScalarArgument(ctx, kChunkFile, &chunk_file));
+  absl::StatusOr<std::optional<ChunkIndex>> index =
+      ReadChunkIndex(ctx->env(), chunk_file);
+  OP_REQUIRES_OK(ctx, index.status());
 
-  *output = new SnapshotChunkDatasetOp::Dataset(DatasetContext(ctx), chunk_file,
-                                                compression_, output_types_,
-                                                output_shapes_);
+  *output = new SnapshotChunkDatasetOp::Dataset(
+      DatasetContext(ctx), chunk_file, compression_, output_types_,
+      output_shapes_, *std::move(index), ctx->env());
   metrics::RecordTFDataServiceSnapshotOp(
       std::string(GetSnapshotPath(chunk_file)), kSnapshotChunkDataset);
 }
@@ -43,6 +43,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor.pb.h"
 #include "tensorflow/core/framework/types.pb.h"
+#include "tensorflow/core/protobuf/snapshot.pb.h"
 #include "tsl/platform/env.h"
 #include "tsl/platform/mutex.h"
 #include "tsl/platform/path.h"
@@ -221,18 +222,42 @@ absl::Status SnapshotStreamWriter::Commit(
   // worker should commit the uncommitted chunks (see SyncCheckpointWithChunks).
   TF_RETURN_IF_ERROR(Save(file_stats));
 
-  // Commits all chunks since the last commit.
+  // Commits all chunks since the last commit. The record offset index of a
+  // chunk is written before the chunk, so readers that see a committed chunk
+  // can use its index for random access.
   for (const auto& [file, stats] : file_stats) {
+    const std::string chunk_filename =
+        absl::StrCat("chunk_", params_.stream_index, "_", chunk_index_++, "_",
+                     stats.num_records);
+    TF_RETURN_IF_ERROR(WriteChunkIndex(chunk_filename, stats));
     std::string committed_chunk_path =
-        tsl::io::JoinPath(params_.CommittedChunksDirectory(),
-                          absl::StrCat("chunk_", params_.stream_index, "_",
-                                       chunk_index_++, "_", stats.num_records));
+        tsl::io::JoinPath(params_.CommittedChunksDirectory(), chunk_filename);
     TF_RETURN_IF_ERROR(params_.env->RenameFile(file, committed_chunk_path));
   }
   last_commit_time_ = absl::FromUnixMicros(params_.env->NowMicros());
   return absl::OkStatus();
 }
 
+absl::Status SnapshotStreamWriter::WriteChunkIndex(
+    const std::string& chunk_filename,
+    const ParallelTFRecordWriter::FileStats& stats) {
+  TF_RETURN_IF_ERROR(params_.env->RecursivelyCreateDir(
+      CommittedChunkIndicesDirectory(params_.snapshot_path)));
+  experimental::SnapshotChunkIndex index;
+  index.mutable_element_offsets()->Assign(stats.record_offsets.begin(),
+                                          stats.record_offsets.end());
+  for (const snapshot_util::RestartPoint& restart_point :
+       stats.restart_points) {
+    experimental::SnapshotChunkIndex::RestartPoint* proto =
+        index.add_restart_points();
+    proto->set_file_offset(restart_point.file_offset);
+    proto->set_record_offset(restart_point.record_offset);
+  }
+  return AtomicallyWriteBinaryProto(
+      CommittedChunkIndexFilePath(params_.snapshot_path, chunk_filename),
+      index, params_.env);
+}
+
 absl::Status SnapshotStreamWriter::FinalizeStream(absl::Status status) {
   if (status.ok()) {
     status = WriteDoneFile();
@@ -175,6 +175,11 @@ class SnapshotStreamWriter {
   // Commits the chunks since the last commit.
   absl::Status Commit(const ParallelTFRecordWriter::FileToStatsMap& file_stats);
 
+  // Writes the record offset index of the chunk `chunk_filename` before it is
+  // committed.
+  absl::Status WriteChunkIndex(const std::string& chunk_filename,
+                               const ParallelTFRecordWriter::FileStats& stats);
+
   // Writes a DONE file when the stream is finished. Writes an ERROR file if it
   // failed.
   absl::Status FinalizeStream(absl::Status status);
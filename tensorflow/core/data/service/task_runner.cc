@@ -48,6 +48,9 @@ namespace {
 constexpr int64_t kWaitBeforeSkipUs = 100 * 1000;  // 100ms.
 constexpr size_t kDefaultCrossTrainerCacheSizeBytes =
     10 * (size_t{1} << 30);  // 10GB
+// Elements prefetched by first-come-first-served tasks, which is also the most
+// elements a batched `GetElements` call can return.
+constexpr size_t kDefaultTaskBufferSize = 8;
 
 }  // namespace
 
@@ -103,14 +106,18 @@ absl::Status TaskRunner::Create(const experimental::WorkerConfig& worker_config,
     out = std::make_unique<CachingTaskRunner>(std::move(iterator),
                                               max_cache_size_bytes);
   } else {
-    out = std::make_unique<FirstComeFirstServedTaskRunner>(std::move(iterator));
+    const size_t buffer_size = worker_config.task_buffer_size() > 0
+                                   ? worker_config.task_buffer_size()
+                                   : kDefaultTaskBufferSize;
+    out = std::make_unique<FirstComeFirstServedTaskRunner>(std::move(iterator),
+                                                           buffer_size);
   }
   return absl::OkStatus();
 }
 
 FirstComeFirstServedTaskRunner::FirstComeFirstServedTaskRunner(
-    std::unique_ptr<TaskIterator> iterator)
-    : iterator_(std::move(iterator)), buffer_(/*buffer_size=*/1) {
+    std::unique_ptr<TaskIterator> iterator, size_t buffer_size)
+    : iterator_(std::move(iterator)), buffer_(buffer_size) {
   RunPrefetchThread();
 }
 
@@ -109,8 +109,9 @@ class TaskRunner {
 // It does not consider which consumer is making the request.
 class FirstComeFirstServedTaskRunner : public TaskRunner {
  public:
+  // Prefetches up to `buffer_size` elements ahead of `GetNext` calls.
   explicit FirstComeFirstServedTaskRunner(
-      std::unique_ptr<TaskIterator> iterator);
+      std::unique_ptr<TaskIterator> iterator, size_t buffer_size = 1);
   ~FirstComeFirstServedTaskRunner() override;
 
   // Gets the next element. It may block if the element is not ready yet.
@@ -44,7 +44,9 @@ TestCluster::TestCluster(int num_workers,
       data_transfer_protocol_(data_transfer_protocol) {}
 
 TestCluster::TestCluster(const TestCluster::Config& config)
-    : num_workers_(config.num_workers), config_(config) {}
+    : num_workers_(config.num_workers),
+      data_transfer_protocol_(config.data_transfer_protocol),
+      config_(config) {}
 
 TestCluster::~TestCluster() {
   if (!config_.work_dir.empty()) {
@@ -106,6 +108,7 @@ absl::Status TestCluster::AddWorker(
       port.has_value() ? absl::StrCat("localhost:", *port) : "localhost:%port%";
   config.set_worker_address(worker_address);
   config.set_heartbeat_interval_ms(config_.worker_heartbeat_interval_ms);
+  config.set_task_buffer_size(config_.worker_task_buffer_size);
   TF_RETURN_IF_ERROR(NewWorkerServer(config, worker));
   TF_RETURN_IF_ERROR(worker->Start());
   worker_addresses_.push_back(absl::StrCat("localhost:", worker->BoundPort()));
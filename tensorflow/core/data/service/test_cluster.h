@@ -55,7 +55,9 @@ class TestCluster {
     int64_t job_gc_check_interval_ms = 0;
     int64_t job_gc_timeout_ms = 0;
     int64_t worker_max_concurrent_snapshots = 0;
+    int64_t worker_task_buffer_size = 0;
     std::string work_dir;
+    std::optional<std::string> data_transfer_protocol;
   };
 
   // Creates a new test cluster with a dispatcher and `num_workers` workers.
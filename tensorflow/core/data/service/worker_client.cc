@@ -28,6 +28,7 @@ limitations under the License.
 #include "grpcpp/support/status.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/memory/memory.h"
+#include "absl/status/status.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
 #include "tensorflow/core/data/service/credentials_factory.h"
@@ -45,6 +46,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor_types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/framework/variant.h"
+#include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/status.h"
@@ -80,6 +82,12 @@ absl::Status DataServiceWorkerClient::GetElement(const GetElementRequest& req,
   return client_->GetElement(req, result);
 }
 
+absl::Status DataServiceWorkerClient::GetElements(
+    const GetElementsRequest& req, std::vector<GetElementResult>& results) {
+  TF_RETURN_IF_ERROR(EnsureInitialized());
+  return client_->GetElements(req, results);
+}
+
 absl::Status DataServiceWorkerClient::EnsureInitialized() {
   mutex_lock l(mu_);
   if (client_) {
@@ -116,37 +124,100 @@ class GrpcDataTransferClient : public DataTransferClient {
                           GetElementResult& result) override {
     VLOG(3) << "GetElement for task " << req.task_id() << " from gRPC worker "
             << "server.";
+    GetElementResponse resp;
+    TF_RETURN_IF_ERROR(Call(
+        [&](grpc::ClientContext* ctx) {
+          return stub_->GetElement(ctx, req, &resp);
+        },
+        "Failed to get element"));
+    return ResponseToResult(resp, result);
+  }
+
+  absl::Status GetElements(const GetElementsRequest& req,
+                           std::vector<GetElementResult>& results) override {
     {
       mutex_lock l(mu_);
-      if (cancelled_) {
-        return errors::Cancelled("Client was cancelled.");
+      if (req.max_elements() <= 1 || !get_elements_supported_) {
+        return DataTransferClient::GetElements(req, results);
+      }
+    }
+    VLOG(3) << "GetElements for task " << req.request().task_id()
+            << " with up to " << req.max_elements()
+            << " elements from gRPC worker server.";
+    GetElementsResponse resp;
+    absl::Status s = Call(
+        [&](grpc::ClientContext* ctx) {
+          return stub_->GetElements(ctx, req, &resp);
+        },
+        "Failed to get elements");
+    if (absl::IsUnimplemented(s)) {
+      VLOG(1) << "Worker does not support GetElements, falling back to "
+              << "GetElement: " << s;
+      {
+        mutex_lock l(mu_);
+        get_elements_supported_ = false;
       }
+      return DataTransferClient::GetElements(req, results);
+    }
+    TF_RETURN_IF_ERROR(s);
+    if (resp.elements().empty()) {
+      return errors::Internal("GetElements returned no elements for task ",
+                              req.request().task_id());
+    }
+    for (GetElementResponse& element : *resp.mutable_elements()) {
+      GetElementResult result;
+      TF_RETURN_IF_ERROR(ResponseToResult(element, result));
+      results.push_back(std::move(result));
     }
+    return absl::OkStatus();
+  }
+
+  void TryCancel() override {
+    VLOG(2) << "Cancel GrpcDataTransferClient.";
+    mutex_lock l(mu_);
+    cancelled_ = true;
+    for (const auto& ctx : active_contexts_) {
+      ctx->TryCancel();
+    }
+  }
+
+ private:
+  // Issues an RPC through `rpc`, which may be cancelled by `TryCancel`.
+  absl::Status Call(
+      const std::function<grpc::Status(grpc::ClientContext*)>& rpc,
+      const std::string& error_message) {
     grpc::ClientContext ctx;
-    gtl::Cleanup<std::function<void()>> cleanup;
     {
       mutex_lock l(mu_);
+      if (cancelled_) {
+        return errors::Cancelled("Client was cancelled.");
+      }
       active_contexts_.insert(&ctx);
-      cleanup = gtl::MakeCleanup([this, &ctx] {
-        mutex_lock l(mu_);
-        active_contexts_.erase(&ctx);
-      });
     }
-    GetElementResponse resp;
+    auto cleanup = gtl::MakeCleanup([this, &ctx] {
+      mutex_lock l(mu_);
+      active_contexts_.erase(&ctx);
+    });
     int64_t start_time_us = env_->NowMicros();
-    grpc::Status s = stub_->GetElement(&ctx, req, &resp);
+    grpc::Status s = rpc(&ctx);
     int64_t end_time_us = env_->NowMicros();
     if (!s.ok()) {
-      return grpc_util::WrapError("Failed to get element", s);
+      return grpc_util::WrapError(error_message, s);
     }
     metrics::RecordTFDataServiceGetElementDuration(kGrpcTransferProtocol,
                                                    end_time_us - start_time_us);
+    return absl::OkStatus();
+  }
+
+  // Converts `resp` to `result`, moving the element out of `resp`.
+  absl::Status ResponseToResult(GetElementResponse& resp,
+                                GetElementResult& result) const {
     result.end_of_sequence = resp.end_of_sequence();
     result.skip = resp.skip_task();
     switch (resp.element_case()) {
       case GetElementResponse::kCompressed: {
         Tensor tensor(DT_VARIANT, TensorShape{});
-        tensor.scalar<Variant>()() = std::move(resp.compressed());
+        tensor.scalar<Variant>()() = std::move(*resp.mutable_compressed());
         result.components.push_back(tensor);
         break;
       }
@@ -168,16 +239,6 @@ class GrpcDataTransferClient : public DataTransferClient {
     return absl::OkStatus();
   }
 
-  void TryCancel() override {
-    VLOG(2) << "Cancel GrpcDataTransferClient.";
-    mutex_lock l(mu_);
-    cancelled_ = true;
-    for (const auto& ctx : active_contexts_) {
-      ctx->TryCancel();
-    }
-  }
-
- private:
   Allocator* const allocator_;
   mutex mu_;
   std::unique_ptr<WorkerService::Stub> stub_;
@@ -188,6 +249,9 @@ class GrpcDataTransferClient : public DataTransferClient {
   // Indicates that the client has been cancelled, so no further requests should
   // be accepted.
   bool cancelled_ TF_GUARDED_BY(mu_) = false;
+  // Set to false once the worker rejects a GetElements call, e.g. because it
+  // runs an older version. Later calls then use GetElement.
+  bool get_elements_supported_ TF_GUARDED_BY(mu_) = true;
 };
 
 class GrpcTransferClientRegistrar {
@@ -230,6 +294,21 @@ class LocalDataTransferClient : public DataTransferClient {
     return s;
   }
 
+  absl::Status GetElements(const GetElementsRequest& req,
+                           std::vector<GetElementResult>& results) override {
+    VLOG(3) << "GetElements for task " << req.request().task_id()
+            << " from local worker.";
+    TF_RETURN_IF_ERROR(VerifyClientIsNotCancelled());
+    TF_ASSIGN_OR_RETURN(std::shared_ptr<DataServiceWorkerImpl> worker,
+                        GetWorker(req.request()));
+    int64_t start_time_us = env_->NowMicros();
+    TF_RETURN_IF_ERROR(worker->GetElementResults(&req, &results));
+    int64_t end_time_us = env_->NowMicros();
+    metrics::RecordTFDataServiceGetElementDuration(kLocalTransferProtocol,
+                                                   end_time_us - start_time_us);
+    return absl::OkStatus();
+  }
+
   void TryCancel() override {
     VLOG(2) << "Cancel LocalDataTransferClient for worker " << worker_address_
             << ".";
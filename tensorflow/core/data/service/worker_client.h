@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
@@ -47,6 +48,11 @@ class DataServiceWorkerClient : public DataServiceClientBase {
   // Fetches an element from the worker.
   Status GetElement(const GetElementRequest& req, GetElementResult& result);
 
+  // Fetches up to `req.max_elements()` elements from the worker, appending
+  // them to `results`.
+  Status GetElements(const GetElementsRequest& req,
+                     std::vector<GetElementResult>& results);
+
   // Makes a best effort to cancel all outstanding calls in progress for the
   // client, and causes further calls to return Cancelled status.
   void TryCancel();
@@ -18,10 +18,12 @@ limitations under the License.
 #include <optional>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/memory/memory.h"
 #include "absl/status/status.h"
 #include "absl/strings/substitute.h"
+#include "absl/time/time.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/data/service/common.h"
 #include "tensorflow/core/data/service/common.pb.h"
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/core/framework/tensor.h"
 #include "tensorflow/core/framework/tensor_testutil.h"
 #include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
 #include "tensorflow/core/platform/errors.h"
 #include "tensorflow/core/platform/status.h"
 #include "tensorflow/core/platform/status_matchers.h"
@@ -51,19 +54,30 @@ namespace {
 
 using ::tensorflow::data::testing::RangeSquareDataset;
 using ::tensorflow::testing::StatusIs;
+using ::testing::Contains;
+using ::testing::Each;
 using ::testing::MatchesRegex;
 
 constexpr const char kProtocol[] = "grpc";
 constexpr const char kAltTransferProtocol[] = "alt";
+// Large enough for a task to prefetch a full batch of the batched reads.
+constexpr int64_t kTaskBufferSize = 16;
+// How long the batched reads wait before each call, which is plenty of time to
+// prefetch a batch of the test datasets.
+constexpr absl::Duration kPrefetchDelay = absl::Milliseconds(10);
 
 class WorkerClientTest : public ::testing::TestWithParam<std::string> {
  protected:
   void SetUp() override { InitializeTestCluster(); }
 
   void InitializeTestCluster(
-      std::optional<std::string> data_transfer_protocol = std::nullopt) {
-    test_cluster_ = std::make_unique<TestCluster>(/*num_workers=*/1,
-                                                  data_transfer_protocol);
+      std::optional<std::string> data_transfer_protocol = std::nullopt,
+      int64_t task_buffer_size = 0) {
+    TestCluster::Config config;
+    config.num_workers = 1;
+    config.worker_task_buffer_size = task_buffer_size;
+    config.data_transfer_protocol = data_transfer_protocol;
+    test_cluster_ = std::make_unique<TestCluster>(config);
     TF_ASSERT_OK(test_cluster_->Initialize());
     dispatcher_client_ = std::make_unique<DataServiceDispatcherClient>(
         test_cluster_->DispatcherAddress(), kProtocol);
@@ -126,6 +140,41 @@ class WorkerClientTest : public ::testing::TestWithParam<std::string> {
     return result;
   }
 
+  struct GetElementsOutput {
+    std::vector<int64_t> elements;
+    // The number of elements returned by each call.
+    std::vector<int64_t> batch_sizes;
+  };
+
+  // Reads task `task_id` to the end with GetElements calls of up to
+  // `max_elements` elements. Waits `delay` before each call, so that the task
+  // can prefetch elements.
+  absl::StatusOr<GetElementsOutput> ReadWithGetElements(
+      DataServiceWorkerClient& client, const int64_t task_id,
+      const int64_t max_elements, absl::Duration delay = absl::ZeroDuration()) {
+    GetElementsRequest request;
+    request.mutable_request()->set_task_id(task_id);
+    request.set_max_elements(max_elements);
+    GetElementsOutput output;
+    while (true) {
+      Env::Default()->SleepForMicroseconds(absl::ToInt64Microseconds(delay));
+      std::vector<GetElementResult> results;
+      TF_RETURN_IF_ERROR(client.GetElements(request, results));
+      if (results.empty() ||
+          static_cast<int64_t>(results.size()) > max_elements) {
+        return errors::Internal("GetElements returned ", results.size(),
+                                " elements, expected 1 to ", max_elements);
+      }
+      output.batch_sizes.push_back(results.size());
+      for (const GetElementResult& result : results) {
+        if (result.end_of_sequence) {
+          return output;
+        }
+        output.elements.push_back(result.components[0].scalar<int64_t>()());
+      }
+    }
+  }
+
   std::string GetDispatcherAddress() const {
     return test_cluster_->DispatcherAddress();
   }
@@ -275,6 +324,37 @@ TEST_P(DataTransferProtocolWorkerClientTest, NetworkRead) {
   }
 }
 
+TEST_P(DataTransferProtocolWorkerClientTest, NetworkReadBatched) {
+  std::string data_transfer_protocol = GetParam();
+  InitializeTestCluster(data_transfer_protocol, kTaskBufferSize);
+  LocalWorkers::Remove(GetWorkerAddress());
+
+  const int64_t range = 100;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<DataServiceWorkerClient> client,
+                          GetWorkerClient(data_transfer_protocol));
+  TF_ASSERT_OK_AND_ASSIGN(
+      GetElementsOutput output,
+      ReadWithGetElements(*client, task_id, /*max_elements=*/8,
+                          kPrefetchDelay));
+  std::vector<int64_t> expected;
+  for (int64_t i = 0; i < range; ++i) {
+    expected.push_back(i * i);
+  }
+  EXPECT_EQ(output.elements, expected);
+  if (data_transfer_protocol == kGrpcTransferProtocol) {
+    // The delay lets the task prefetch a full batch before each call.
+    EXPECT_THAT(output.batch_sizes, Contains(8));
+  } else {
+    // The alt protocol fetches one element per call.
+    EXPECT_THAT(output.batch_sizes, Each(1));
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     NetworkProtocols, DataTransferProtocolWorkerClientTest,
     ::testing::Values(kGrpcTransferProtocol, kAltTransferProtocol),
@@ -283,6 +363,47 @@ INSTANTIATE_TEST_SUITE_P(
       return info.param;
     });
 
+TEST_F(WorkerClientTest, LocalReadBatched) {
+  InitializeTestCluster(/*data_transfer_protocol=*/std::nullopt,
+                        kTaskBufferSize);
+  const int64_t range = 100;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<DataServiceWorkerClient> client,
+                          GetWorkerClient(kLocalTransferProtocol));
+  TF_ASSERT_OK_AND_ASSIGN(
+      GetElementsOutput output,
+      ReadWithGetElements(*client, task_id, /*max_elements=*/8,
+                          kPrefetchDelay));
+  std::vector<int64_t> expected;
+  for (int64_t i = 0; i < range; ++i) {
+    expected.push_back(i * i);
+  }
+  EXPECT_EQ(output.elements, expected);
+  EXPECT_THAT(output.batch_sizes, Contains(8));
+}
+
+TEST_F(WorkerClientTest, LocalReadBatchedByDefault) {
+  InitializeTestCluster(/*data_transfer_protocol=*/std::nullopt);
+  const int64_t range = 100;
+  TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id, RegisterDataset(range));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t iteration_client_id,
+                          CreateIteration(dataset_id));
+  TF_ASSERT_OK_AND_ASSIGN(const int64_t task_id,
+                          GetTaskToRead(iteration_client_id));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<DataServiceWorkerClient> client,
+                          GetWorkerClient(kLocalTransferProtocol));
+  TF_ASSERT_OK_AND_ASSIGN(
+      GetElementsOutput output,
+      ReadWithGetElements(*client, task_id, /*max_elements=*/8,
+                          kPrefetchDelay));
+  EXPECT_EQ(output.elements.size(), range);
+  EXPECT_THAT(output.batch_sizes, Contains(8));
+}
+
 TEST_F(WorkerClientTest, LocalServerShutsDown) {
   TF_ASSERT_OK_AND_ASSIGN(const std::string dataset_id,
                           RegisterDataset(/*range=*/5));
@@ -14,6 +14,7 @@ limitations under the License.
 ==============================================================================*/
 #include "tensorflow/core/data/service/worker_impl.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 #include <optional>
@@ -104,6 +105,16 @@ Status MoveElementToResponse(std::vector<Tensor>&& element,
   return absl::OkStatus();
 }
 
+Status MoveResultToResponse(GetElementResult&& result,
+                            GetElementResponse& resp) {
+  resp.set_end_of_sequence(result.end_of_sequence);
+  resp.set_skip_task(result.skip);
+  if (result.end_of_sequence || result.skip) {
+    return absl::OkStatus();
+  }
+  return MoveElementToResponse(std::move(result.components), resp);
+}
+
 WorkerConfig ApplyWorkerDefaults(const WorkerConfig& config) {
   WorkerConfig new_config(config);
   if (new_config.heartbeat_interval_ms() == 0) {
@@ -481,16 +492,68 @@ Status DataServiceWorkerImpl::GetElement(const GetElementRequest* request,
   VLOG(3) << "Received GetElement request for task " << request->task_id();
   struct GetElementResult result;
   TF_RETURN_IF_ERROR(GetElementResult(request, &result));
-  response->set_end_of_sequence(result.end_of_sequence);
-  response->set_skip_task(result.skip);
+  TF_RETURN_IF_ERROR(MoveResultToResponse(std::move(result), *response));
   if (!response->end_of_sequence() && !response->skip_task()) {
-    TF_RETURN_IF_ERROR(
-        MoveElementToResponse(std::move(result.components), *response));
     VLOG(3) << "Producing an element for task " << request->task_id();
   }
   return absl::OkStatus();
 }
 
+Status DataServiceWorkerImpl::GetElementResults(
+    const GetElementsRequest* request,
+    std::vector<struct GetElementResult>* results) {
+  GetElementRequest element_request = request->request();
+  // Coordinated reads hand out exactly one element per consumer and round, and
+  // cross-trainer cache reads are served from a shared sliding window, so only
+  // first-come-first-served reads are batched.
+  int64_t max_elements = 1;
+  if (element_request.optional_round_index_case() ==
+          GetElementRequest::OPTIONAL_ROUND_INDEX_NOT_SET &&
+      element_request.trainer_id().empty()) {
+    max_elements = std::max<int64_t>(request->max_elements(), 1);
+  }
+  for (int64_t i = 0; i < max_elements; ++i) {
+    struct GetElementResult result;
+    Status s = GetElementResult(&element_request, &result);
+    if (!s.ok()) {
+      if (results->empty()) {
+        return s;
+      }
+      // Return the elements we already have. The error will be reported by
+      // the client's next request.
+      break;
+    }
+    if (i > 0 && result.skip) {
+      // Nothing else is ready yet.
+      break;
+    }
+    const bool last = result.end_of_sequence || result.skip;
+    results->push_back(std::move(result));
+    if (last) {
+      break;
+    }
+    // Only wait for the first element.
+    element_request.set_allow_skip(true);
+  }
+  return absl::OkStatus();
+}
+
+Status DataServiceWorkerImpl::GetElements(const GetElementsRequest* request,
+                                          GetElementsResponse* response) {
+  VLOG(3) << "Received GetElements request for task "
+          << request->request().task_id() << " with up to "
+          << request->max_elements() << " elements";
+  std::vector<struct GetElementResult> results;
+  TF_RETURN_IF_ERROR(GetElementResults(request, &results));
+  for (struct GetElementResult& result : results) {
+    TF_RETURN_IF_ERROR(
+        MoveResultToResponse(std::move(result), *response->add_elements()));
+  }
+  VLOG(3) << "Producing " << response->elements_size()
+          << " elements for task " << request->request().task_id();
+  return absl::OkStatus();
+}
+
 Status DataServiceWorkerImpl::GetWorkerTasks(
     const GetWorkerTasksRequest* request, GetWorkerTasksResponse* response) {
   mutex_lock l(mu_);
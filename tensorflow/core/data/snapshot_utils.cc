@@ -78,6 +78,27 @@ std::string ProtoSerializationErrorMessage(const TensorProto& proto,
   return error_message;
 }
 
+// Reads `file` from `file_offset`, so a `RecordReader` can start at a
+// compressed stream in the middle of the file.
+class OffsetRandomAccessFile : public RandomAccessFile {
+ public:
+  OffsetRandomAccessFile(const RandomAccessFile* file, uint64_t file_offset)
+      : file_(file), file_offset_(file_offset) {}
+
+  absl::Status Name(absl::string_view* result) const override {
+    return file_->Name(result);
+  }
+
+  absl::Status Read(uint64 offset, size_t n, absl::string_view* result,
+                    char* scratch) const override {
+    return file_->Read(file_offset_ + offset, n, result, scratch);
+  }
+
+ private:
+  const RandomAccessFile* const file_;
+  const uint64_t file_offset_;
+};
+
 }  // namespace
 
 /* static */ constexpr const int64_t
@@ -150,6 +171,7 @@ absl::Status TFRecordWriter::Initialize(tensorflow::Env* env) {
 }
 
 absl::Status TFRecordWriter::WriteTensors(const std::vector<Tensor>& tensors) {
+  TF_RETURN_IF_ERROR(MaybeAddRestartPoint());
   for (const auto& tensor : tensors) {
     TensorProto proto;
     tensor.AsProtoTensorContent(&proto);
@@ -165,14 +187,43 @@ absl::Status TFRecordWriter::WriteTensors(const std::vector<Tensor>& tensors) {
     absl::Cord proto_serialized = absl::MakeCordFromExternal(
         *proto_buffer,
         [proto_buffer](absl::string_view) { delete proto_buffer; });
+    const uint64_t record_size = proto_serialized.size();
     TF_RETURN_IF_ERROR(record_writer_->WriteRecord(proto_serialized));
 #else   // TF_CORD_SUPPORT
     std::string proto_serialized;
     if (!proto.SerializeToString(&proto_serialized)) {
       return errors::DataLoss(ProtoSerializationErrorMessage(proto, filename_));
     }
+    const uint64_t record_size = proto_serialized.size();
     TF_RETURN_IF_ERROR(record_writer_->WriteRecord(proto_serialized));
 #endif  // TF_CORD_SUPPORT
+    offset_ += io::RecordWriter::kHeaderSize + record_size +
+               io::RecordWriter::kFooterSize;
+  }
+  return absl::OkStatus();
+}
+
+absl::Status TFRecordWriter::MaybeAddRestartPoint() {
+  if (compression_type_ != io::compression::kSnappy &&
+      compression_type_ != io::compression::kGzip) {
+    return absl::OkStatus();
+  }
+  if (offset_ - stream_offset_ < kRestartIntervalBytes) {
+    return absl::OkStatus();
+  }
+  // Closing the record writer ends its compressed stream but keeps `dest_`
+  // open for the next one.
+  TF_RETURN_IF_ERROR(record_writer_->Close());
+  record_writer_ = std::make_unique<io::RecordWriter>(
+      dest_.get(), io::RecordWriterOptions::CreateRecordWriterOptions(
+                       /*compression_type=*/compression_type_));
+  stream_offset_ = offset_;
+  // Filesystems that do not support `Tell` get no restart points; their
+  // readers decompress from the start of the file.
+  int64_t file_offset = 0;
+  if (dest_->Tell(&file_offset).ok()) {
+    restart_points_.push_back(
+        {static_cast<uint64_t>(file_offset), stream_offset_});
   }
   return absl::OkStatus();
 }
@@ -756,12 +807,49 @@ absl::Status TFRecordReaderImpl::Initialize(Env* env) {
     options.zlib_options.output_buffer_size = *output_buffer_size_;
   }
 #endif  // IS_SLIM_BUILD
-  record_reader_ = std::make_unique<io::RecordReader>(file_.get(), options);
+  options_ = options;
+  OpenRecordReader(RestartPoint());
   bytes_read_ = 0;
   return absl::OkStatus();
 }
 
+void TFRecordReaderImpl::OpenRecordReader(const RestartPoint& restart) {
+  record_reader_ = nullptr;
+  restart_file_ = nullptr;
+  restart_ = restart;
+  RandomAccessFile* file = file_.get();
+  if (restart.file_offset > 0) {
+    restart_file_ = std::make_unique<OffsetRandomAccessFile>(
+        file_.get(), restart.file_offset);
+    file = restart_file_.get();
+  }
+  record_reader_ = std::make_unique<io::RecordReader>(file, options_);
+}
+
+void TFRecordReaderImpl::Seek(uint64_t offset,
+                              absl::Span<const RestartPoint> restart_points) {
+  auto it = std::upper_bound(
+      restart_points.begin(), restart_points.end(), offset,
+      [](uint64_t record_offset, const RestartPoint& restart_point) {
+        return record_offset < restart_point.record_offset;
+      });
+  const RestartPoint restart =
+      it == restart_points.begin() ? RestartPoint() : *std::prev(it);
+  // Within the current compressed stream, `record_reader_` skips forward or
+  // rewinds to the start of the stream by itself.
+  if (restart.record_offset == restart_.record_offset) {
+    pending_restart_.reset();
+  } else {
+    pending_restart_ = restart;
+  }
+  offset_ = offset - restart.record_offset;
+}
+
 absl::StatusOr<Tensor> TFRecordReaderImpl::GetNext() {
+  if (pending_restart_.has_value()) {
+    OpenRecordReader(*pending_restart_);
+    pending_restart_.reset();
+  }
   tstring record;
   TF_RETURN_IF_ERROR(record_reader_->ReadRecord(&offset_, &record));
   bytes_read_ += record.size();
@@ -25,6 +25,7 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/types/span.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op_kernel.h"
 #include "tensorflow/core/framework/tensor.h"
@@ -80,6 +81,15 @@ std::string ShardDirectory(const std::string& run_directory, int64_t shard_id);
 std::string GetCheckpointFileName(const std::string& shard_directory,
                                   uint64 checkpoint_id);
 
+// Position from which a compressed `TFRecordWriter` file can be read without
+// decompressing the data before it: a compressed stream starts at
+// `file_offset` of the file, with the record at `record_offset` of the
+// uncompressed record stream.
+struct RestartPoint {
+  uint64_t file_offset = 0;
+  uint64_t record_offset = 0;
+};
+
 // This is a interface class that exposes snapshot writing functionality.
 class Writer {
  public:
@@ -119,14 +129,37 @@ class TFRecordWriter : public Writer {
 
   absl::Status Close() override;
 
+  // Returns the offset of the next record in the uncompressed record stream.
+  // Passing the offset to `TFRecordReader::Seek` positions the reader at the
+  // tensors written by the next `WriteTensors` call.
+  uint64_t Offset() const { return offset_; }
+
+  // Returns the restart points of the file, in the order of their offsets.
+  // With SNAPPY and GZIP compression, whose readers support consecutive
+  // compressed streams, the writer starts a new compressed stream before the
+  // first `WriteTensors` call after every `kRestartIntervalBytes` of records.
+  const std::vector<RestartPoint>& RestartPoints() const {
+    return restart_points_;
+  }
+
   ~TFRecordWriter() override;
 
+  static constexpr uint64_t kRestartIntervalBytes = 1 << 20;  // 1 MiB
+
  private:
+  // Starts a new compressed stream if the current one holds at least
+  // `kRestartIntervalBytes` of records.
+  absl::Status MaybeAddRestartPoint();
+
   const std::string filename_;
   const std::string compression_type_;
 
   std::unique_ptr<WritableFile> dest_;
   std::unique_ptr<io::RecordWriter> record_writer_;
+  uint64_t offset_ = 0;
+  // Record offset at which the current compressed stream starts.
+  uint64_t stream_offset_ = 0;
+  std::vector<RestartPoint> restart_points_;
 };
 
 // Writes snapshot with a custom (legacy) file format.
@@ -266,6 +299,15 @@ class TFRecordReaderImpl {
   // Reads all Tensors in the input file.
   absl::StatusOr<std::vector<Tensor>> GetTensors();
 
+  // Makes the next `GetNext` call read the record at `offset` of the
+  // uncompressed record stream. For uncompressed files, this does not read the
+  // records before `offset`. For compressed files, this only decompresses the
+  // records after the last of `restart_points`, as returned by
+  // `TFRecordWriter::RestartPoints`, before `offset`, unless the reader is
+  // already past that restart point.
+  void Seek(uint64_t offset,
+            absl::Span<const RestartPoint> restart_points = {});
+
   // Returns the number of bytes read.
   uint64_t BytesRead() const { return bytes_read_; }
 
@@ -273,9 +315,20 @@ class TFRecordReaderImpl {
   // Parses `record` into a Tensor.
   absl::StatusOr<Tensor> Parse(const tstring& record);
 
+  // Creates `record_reader_` to read the compressed stream at `restart`.
+  void OpenRecordReader(const RestartPoint& restart);
+
   std::string filename_;
   std::unique_ptr<RandomAccessFile> file_;
+  // View of `file_` from the restart point read by `record_reader_`.
+  std::unique_ptr<RandomAccessFile> restart_file_;
   std::unique_ptr<io::RecordReader> record_reader_;
+  io::RecordReaderOptions options_;
+  // The restart point read by `record_reader_`. `offset_` is relative to its
+  // record offset.
+  RestartPoint restart_;
+  // Restart point to read from on the next `GetNext` call, set by `Seek`.
+  std::optional<RestartPoint> pending_restart_;
   uint64_t offset_ = 0;
   uint64_t bytes_read_ = 0;
 
@@ -302,6 +355,13 @@ class TFRecordReader : public Reader {
   // end of file, or an error status if there is an error.
   absl::Status ReadTensors(std::vector<Tensor>* read_tensors) override;
 
+  // Makes the next `ReadTensors` call read the tensors at `offset`, as
+  // returned by `TFRecordWriter::Offset`. See `TFRecordReaderImpl::Seek`.
+  void Seek(uint64_t offset,
+            absl::Span<const RestartPoint> restart_points = {}) {
+    reader_impl_.Seek(offset, restart_points);
+  }
+
   // Returns the number of bytes read.
   uint64_t BytesRead() const { return reader_impl_.BytesRead(); }
 
@@ -15,7 +15,10 @@ limitations under the License.
 
 #include "tensorflow/core/data/snapshot_utils.h"
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <random>
 #include <string>
 #include <vector>
 
@@ -120,6 +123,75 @@ TEST(SnapshotUtilTest, MetadataFileDoesntExist) {
   EXPECT_FALSE(file_exists);
 }
 
+TEST(SnapshotUtilTest, TFRecordSeek) {
+  tensorflow::DataTypeVector dtypes;
+  std::vector<Tensor> tensors;
+  GenerateTensorVector(dtypes, tensors);
+
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  TFRecordWriter writer(filename, io::compression::kNone);
+  TF_ASSERT_OK(writer.Initialize(Env::Default()));
+  std::vector<uint64_t> offsets;
+  for (int i = 0; i < 5; ++i) {
+    offsets.push_back(writer.Offset());
+    TF_ASSERT_OK(writer.WriteTensors({Tensor(static_cast<int64_t>(i))}));
+  }
+  TF_ASSERT_OK(writer.Close());
+
+  TFRecordReader reader(filename, io::compression::kNone,
+                        DataTypeVector{DT_INT64});
+  TF_ASSERT_OK(reader.Initialize(Env::Default()));
+  for (int i : {3, 0, 4, 1}) {
+    reader.Seek(offsets[i]);
+    std::vector<Tensor> read_tensors;
+    TF_ASSERT_OK(reader.ReadTensors(&read_tensors));
+    ASSERT_EQ(read_tensors.size(), 1);
+    EXPECT_EQ(read_tensors[0].scalar<int64_t>()(), i);
+  }
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+TEST(SnapshotUtilTest, CompressedTFRecordSeek) {
+  constexpr int kNumElements = 300;
+  for (const std::string& compression :
+       {io::compression::kSnappy, io::compression::kGzip}) {
+    std::string filename;
+    EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+    TFRecordWriter writer(filename, compression);
+    TF_ASSERT_OK(writer.Initialize(Env::Default()));
+    std::vector<uint64_t> offsets;
+    for (int i = 0; i < kNumElements; ++i) {
+      offsets.push_back(writer.Offset());
+      TF_ASSERT_OK(writer.WriteTensors(
+          {Tensor(std::string(8 << 10, 'a' + i % 26))}));
+    }
+    TF_ASSERT_OK(writer.Close());
+    // 300 elements of 8 KiB span three compressed streams.
+    const std::vector<RestartPoint> restart_points = writer.RestartPoints();
+    ASSERT_EQ(restart_points.size(), 2);
+    EXPECT_LT(restart_points[0].record_offset, restart_points[1].record_offset);
+
+    TFRecordReader reader(filename, compression, DataTypeVector{DT_STRING});
+    TF_ASSERT_OK(reader.Initialize(Env::Default()));
+    for (int i = 0; i < kNumElements; ++i) {
+      std::vector<Tensor> read_tensors;
+      TF_ASSERT_OK(reader.ReadTensors(&read_tensors));
+      ASSERT_EQ(read_tensors.size(), 1);
+      EXPECT_EQ(read_tensors[0].scalar<tstring>()()[0], 'a' + i % 26);
+    }
+    for (int i : {kNumElements - 1, 0, 150, 149, 151, 299, 1}) {
+      reader.Seek(offsets[i], restart_points);
+      std::vector<Tensor> read_tensors;
+      TF_ASSERT_OK(reader.ReadTensors(&read_tensors));
+      ASSERT_EQ(read_tensors.size(), 1);
+      EXPECT_EQ(read_tensors[0].scalar<tstring>()(),
+                std::string(8 << 10, 'a' + i % 26));
+    }
+    TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+  }
+}
+
 void SnapshotReaderBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
   tensorflow::DataTypeVector dtypes;
@@ -176,6 +248,78 @@ BENCHMARK(SnapshotCustomReaderSnappyBenchmark);
 BENCHMARK(SnapshotTFRecordReaderNoneBenchmark);
 BENCHMARK(SnapshotTFRecordReaderGzipBenchmark);
 
+// Reads elements of a TFRecord snapshot file in order if `random_access` is
+// false, or at random offsets if `random_access` is true.
+void SnapshotTFRecordSeekBenchmarkLoop(::testing::benchmark::State& state,
+                                       std::string compression_type,
+                                       bool random_access) {
+  constexpr int kNumElements = 1000;
+  tensorflow::DataTypeVector dtypes;
+  std::vector<Tensor> tensors;
+  GenerateTensorVector(dtypes, tensors);
+
+  std::string filename;
+  EXPECT_TRUE(Env::Default()->LocalTempFilename(&filename));
+  TFRecordWriter writer(filename, compression_type);
+  TF_ASSERT_OK(writer.Initialize(Env::Default()));
+  std::vector<uint64_t> offsets;
+  for (int i = 0; i < kNumElements; ++i) {
+    offsets.push_back(writer.Offset());
+    TF_ASSERT_OK(writer.WriteTensors(tensors));
+  }
+  TF_ASSERT_OK(writer.Close());
+  if (random_access) {
+    std::shuffle(offsets.begin(), offsets.end(), std::mt19937(/*seed=*/1));
+  }
+
+  TFRecordReader reader(filename, compression_type, dtypes);
+  TF_ASSERT_OK(reader.Initialize(Env::Default()));
+  int64_t i = 0;
+  for (auto s : state) {
+    reader.Seek(offsets[i++ % kNumElements], writer.RestartPoints());
+    std::vector<Tensor> read_tensors;
+    reader.ReadTensors(&read_tensors).IgnoreError();
+  }
+
+  TF_ASSERT_OK(Env::Default()->DeleteFile(filename));
+}
+
+void SnapshotTFRecordSequentialReadNoneBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotTFRecordSeekBenchmarkLoop(state, io::compression::kNone,
+                                    /*random_access=*/false);
+}
+
+void SnapshotTFRecordRandomReadNoneBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotTFRecordSeekBenchmarkLoop(state, io::compression::kNone,
+                                    /*random_access=*/true);
+}
+
+void SnapshotTFRecordSequentialReadGzipBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotTFRecordSeekBenchmarkLoop(state, io::compression::kGzip,
+                                    /*random_access=*/false);
+}
+
+void SnapshotTFRecordRandomReadGzipBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotTFRecordSeekBenchmarkLoop(state, io::compression::kGzip,
+                                    /*random_access=*/true);
+}
+
+void SnapshotTFRecordRandomReadSnappyBenchmark(
+    ::testing::benchmark::State& state) {
+  SnapshotTFRecordSeekBenchmarkLoop(state, io::compression::kSnappy,
+                                    /*random_access=*/true);
+}
+
+BENCHMARK(SnapshotTFRecordSequentialReadNoneBenchmark);
+BENCHMARK(SnapshotTFRecordRandomReadNoneBenchmark);
+BENCHMARK(SnapshotTFRecordSequentialReadGzipBenchmark);
+BENCHMARK(SnapshotTFRecordRandomReadGzipBenchmark);
+BENCHMARK(SnapshotTFRecordRandomReadSnappyBenchmark);
+
 void SnapshotWriterBenchmarkLoop(::testing::benchmark::State& state,
                                  std::string compression_type, int version) {
   tensorflow::DataTypeVector dtypes;
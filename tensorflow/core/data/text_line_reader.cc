@@ -0,0 +1,165 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/text_line_reader.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+constexpr char kFileScheme[] = "file";
+
+// Returns true if `filename` is on the local file system, which can be
+// memory-mapped without copying the file into memory.
+bool IsLocalFile(const std::string& filename) {
+  absl::string_view scheme, host, path;
+  io::ParseURI(filename, &scheme, &host, &path);
+  return scheme.empty() || scheme == kFileScheme;
+}
+
+// Copies `length` bytes at `data` into `line`, dropping '\r' characters.
+void AssignLine(const char* data, size_t length, tstring* line) {
+  if (std::memchr(data, '\r', length) == nullptr) {
+    line->assign(data, length);
+    return;
+  }
+  line->resize_uninitialized(length);
+  char* out = line->mdata();
+  const char* end = std::remove_copy(data, data + length, out, '\r');
+  line->resize(end - out);
+}
+
+}  // namespace
+
+absl::StatusOr<std::unique_ptr<TextLineReader>> TextLineReader::Create(
+    Env* env, const std::string& filename, size_t block_size,
+    bool memory_map) {
+  if (memory_map && IsLocalFile(filename)) {
+    std::unique_ptr<ReadOnlyMemoryRegion> region;
+    // Falls back to block reads if the file cannot be mapped, e.g. if it is
+    // empty.
+    if (env->NewReadOnlyMemoryRegionFromFile(filename, &region).ok()) {
+      return absl::WrapUnique(new TextLineReader(std::move(region)));
+    }
+  }
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file));
+  return absl::WrapUnique(new TextLineReader(std::move(file), block_size));
+}
+
+TextLineReader::TextLineReader(std::unique_ptr<RandomAccessFile> file,
+                               size_t block_size)
+    : file_(std::move(file)), buffer_(std::max<size_t>(block_size, 1), '\0') {
+  data_ = buffer_.data();
+}
+
+TextLineReader::TextLineReader(std::unique_ptr<ReadOnlyMemoryRegion> region)
+    : region_(std::move(region)) {
+  data_ = static_cast<const char*>(region_->data());
+  limit_ = region_->length();
+  eof_ = true;
+}
+
+absl::Status TextLineReader::ReadLine(tstring* line) {
+  while (true) {
+    const char* begin = data_ + pos_;
+    const size_t available = limit_ - pos_;
+    const char* eol =
+        static_cast<const char*>(std::memchr(begin, '\n', available));
+    if (eol != nullptr) {
+      AssignLine(begin, eol - begin, line);
+      pos_ += eol - begin + 1;
+      return absl::OkStatus();
+    }
+    if (eof_) {
+      // Like `BufferedInputStream::ReadLine`, the last line is only produced
+      // if it is not empty.
+      AssignLine(begin, available, line);
+      pos_ = limit_;
+      if (line->empty()) {
+        return errors::OutOfRange("End of file");
+      }
+      return absl::OkStatus();
+    }
+    TF_RETURN_IF_ERROR(FillBuffer());
+  }
+}
+
+absl::Status TextLineReader::Seek(int64_t position) {
+  if (position < 0) {
+    return errors::InvalidArgument("Seeking to a negative position: ",
+                                   position);
+  }
+  if (memory_mapped()) {
+    if (static_cast<size_t>(position) > limit_) {
+      return errors::OutOfRange("Seeking to position ", position,
+                                " past the end of the file of size ", limit_);
+    }
+    pos_ = position;
+    return absl::OkStatus();
+  }
+  buffer_offset_ = position;
+  pos_ = 0;
+  limit_ = 0;
+  eof_ = false;
+  return absl::OkStatus();
+}
+
+absl::Status TextLineReader::FillBuffer() {
+  // Keeps the unread bytes, which do not contain a line end, at the front of
+  // the buffer, and grows the buffer if a line does not fit in it.
+  const size_t unread = limit_ - pos_;
+  if (unread == buffer_.size()) {
+    buffer_.resize(buffer_.size() * 2);
+  }
+  std::memmove(buffer_.data(), buffer_.data() + pos_, unread);
+  buffer_offset_ += pos_;
+  pos_ = 0;
+  data_ = buffer_.data();
+
+  absl::string_view result;
+  char* scratch = buffer_.data() + unread;
+  absl::Status s = file_->Read(buffer_offset_ + unread, buffer_.size() - unread,
+                               &result, scratch);
+  if (result.data() != scratch) {
+    std::memmove(scratch, result.data(), result.size());
+  }
+  limit_ = unread + result.size();
+  if (errors::IsOutOfRange(s)) {
+    eof_ = true;
+    return absl::OkStatus();
+  }
+  return s;
+}
+
+}  // namespace data
+}  // namespace tensorflow
@@ -0,0 +1,94 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_CORE_DATA_TEXT_LINE_READER_H_
+#define TENSORFLOW_CORE_DATA_TEXT_LINE_READER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/file_system.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace data {
+
+// Reads the lines of an uncompressed text file.
+//
+// Unlike `io::BufferedInputStream::ReadLine`, which inspects one byte at a
+// time, the reader scans whole blocks for line ends with `memchr` (which is
+// vectorized by the C library) and copies each line into its output with one
+// copy. Local files are memory-mapped when possible, so lines are copied
+// straight from the page cache; other files are read in blocks of
+// `block_size` bytes.
+//
+// Lines are split on '\n', and '\r' characters are dropped, matching
+// `io::BufferedInputStream::ReadLine`. This class is not thread-safe.
+class TextLineReader {
+ public:
+  // Opens `filename` for reading. If `memory_map` is true and `filename` is a
+  // local file, tries to memory-map the file before falling back to block
+  // reads.
+  static absl::StatusOr<std::unique_ptr<TextLineReader>> Create(
+      Env* env, const std::string& filename, size_t block_size,
+      bool memory_map);
+
+  TextLineReader(const TextLineReader&) = delete;
+  TextLineReader& operator=(const TextLineReader&) = delete;
+
+  // Reads the next line into `line`, without the line end. Returns an
+  // `OutOfRange` error at the end of the file.
+  absl::Status ReadLine(tstring* line);
+
+  // Returns the offset in the file of the next line.
+  int64_t Tell() const { return buffer_offset_ + pos_; }
+
+  // Makes the next `ReadLine` call read from `position`.
+  absl::Status Seek(int64_t position);
+
+  // Returns true if the file is memory-mapped.
+  bool memory_mapped() const { return region_ != nullptr; }
+
+ private:
+  TextLineReader(std::unique_ptr<RandomAccessFile> file, size_t block_size);
+  explicit TextLineReader(std::unique_ptr<ReadOnlyMemoryRegion> region);
+
+  // Reads the next block of the file after the unread bytes of the buffer.
+  absl::Status FillBuffer();
+
+  const std::unique_ptr<RandomAccessFile> file_;
+  const std::unique_ptr<ReadOnlyMemoryRegion> region_;
+
+  // Buffer of the block reads. Unused if the file is memory-mapped.
+  std::string buffer_;
+
+  // The bytes of the file which have been read, starting at `buffer_offset_`.
+  const char* data_ = nullptr;
+  size_t limit_ = 0;
+  int64_t buffer_offset_ = 0;
+  // Position of the next line in `data_`.
+  size_t pos_ = 0;
+  // Whether `data_` ends at the end of the file.
+  bool eof_ = false;
+};
+
+}  // namespace data
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_DATA_TEXT_LINE_READER_H_
@@ -0,0 +1,251 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/core/data/text_line_reader.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/io/buffered_inputstream.h"
+#include "tensorflow/core/lib/io/random_inputstream.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/statusor.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+#include "tensorflow/core/platform/tstring.h"
+#include "tsl/platform/status_matchers.h"
+
+namespace tensorflow {
+namespace data {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::tsl::testing::StatusIs;
+
+absl::StatusOr<std::string> WriteFile(const std::string& contents) {
+  std::string filename;
+  if (!Env::Default()->LocalTempFilename(&filename)) {
+    return errors::FailedPrecondition("Failed to create local temp file.");
+  }
+  TF_RETURN_IF_ERROR(WriteStringToFile(Env::Default(), filename, contents));
+  return filename;
+}
+
+absl::StatusOr<std::vector<std::string>> ReadLines(TextLineReader& reader) {
+  std::vector<std::string> lines;
+  while (true) {
+    tstring line;
+    absl::Status status = reader.ReadLine(&line);
+    if (errors::IsOutOfRange(status)) {
+      return lines;
+    }
+    TF_RETURN_IF_ERROR(status);
+    lines.push_back(line);
+  }
+}
+
+// Reads the lines with `io::BufferedInputStream::ReadLine`, the behavior
+// `TextLineReader` should match.
+absl::StatusOr<std::vector<std::string>> ReadLinesWithInputStream(
+    const std::string& filename) {
+  std::unique_ptr<RandomAccessFile> file;
+  TF_RETURN_IF_ERROR(Env::Default()->NewRandomAccessFile(filename, &file));
+  io::RandomAccessInputStream input_stream(file.get());
+  io::BufferedInputStream buffered_input_stream(&input_stream, 1 << 10);
+  std::vector<std::string> lines;
+  while (true) {
+    tstring line;
+    absl::Status status = buffered_input_stream.ReadLine(&line);
+    if (errors::IsOutOfRange(status)) {
+      return lines;
+    }
+    TF_RETURN_IF_ERROR(status);
+    lines.push_back(line);
+  }
+}
+
+class TextLineReaderTest
+    : public ::testing::TestWithParam<std::tuple<int64_t, bool>> {
+ protected:
+  int64_t BlockSize() const { return std::get<0>(GetParam()); }
+  bool MemoryMap() const { return std::get<1>(GetParam()); }
+
+  absl::StatusOr<std::unique_ptr<TextLineReader>> CreateReader(
+      const std::string& filename) const {
+    return TextLineReader::Create(Env::Default(), filename, BlockSize(),
+                                  MemoryMap());
+  }
+};
+
+TEST_P(TextLineReaderTest, ReadLines) {
+  const std::string contents = absl::StrCat(
+      "first\n", "\n", "windows line\r\n", std::string(100, 'x'), "\n",
+      "a\rb\n", "last line without line end");
+  TF_ASSERT_OK_AND_ASSIGN(std::string filename, WriteFile(contents));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TextLineReader> reader,
+                          CreateReader(filename));
+  EXPECT_EQ(reader->memory_mapped(), MemoryMap());
+
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<std::string> lines, ReadLines(*reader));
+  EXPECT_THAT(lines, ElementsAre("first", "", "windows line",
+                                 std::string(100, 'x'), "ab",
+                                 "last line without line end"));
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<std::string> expected_lines,
+                          ReadLinesWithInputStream(filename));
+  EXPECT_THAT(lines, ElementsAreArray(expected_lines));
+}
+
+TEST_P(TextLineReaderTest, TrailingLineEnd) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string filename, WriteFile("a\nb\n\r"));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TextLineReader> reader,
+                          CreateReader(filename));
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<std::string> lines, ReadLines(*reader));
+  EXPECT_THAT(lines, ElementsAre("a", "b"));
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<std::string> expected_lines,
+                          ReadLinesWithInputStream(filename));
+  EXPECT_THAT(lines, ElementsAreArray(expected_lines));
+}
+
+TEST_P(TextLineReaderTest, TellAndSeek) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string filename,
+                          WriteFile("zero\none\ntwo\nthree\n"));
+  TF_ASSERT_OK_AND_ASSIGN(std::unique_ptr<TextLineReader> reader,
+                          CreateReader(filename));
+  tstring line;
+  TF_ASSERT_OK(reader->ReadLine(&line));
+  TF_ASSERT_OK(reader->ReadLine(&line));
+  EXPECT_EQ(line, "one");
+  const int64_t position = reader->Tell();
+  EXPECT_EQ(position, 9);
+
+  TF_ASSERT_OK(reader->ReadLine(&line));
+  TF_ASSERT_OK(reader->ReadLine(&line));
+  EXPECT_EQ(line, "three");
+  EXPECT_THAT(reader->ReadLine(&line),
+              StatusIs(absl::StatusCode::kOutOfRange));
+
+  TF_ASSERT_OK(reader->Seek(position));
+  TF_ASSERT_OK_AND_ASSIGN(std::vector<std::string> lines, ReadLines(*reader));
+  EXPECT_THAT(lines, ElementsAre("two", "three"));
+
+  TF_ASSERT_OK(reader->Seek(0));
+  TF_ASSERT_OK(reader->ReadLine(&line));
+  EXPECT_EQ(line, "zero");
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    TextLineReaderTests, TextLineReaderTest,
+    ::testing::Combine(/*BlockSize*/ ::testing::Values(1, 7, 1 << 10),
+                       /*MemoryMap*/ ::testing::Bool()));
+
+TEST(TextLineReaderTest, EmptyFile) {
+  TF_ASSERT_OK_AND_ASSIGN(std::string filename, WriteFile(""));
+  TF_ASSERT_OK_AND_ASSIGN(
+      std::unique_ptr<TextLineReader> reader,
+      TextLineReader::Create(Env::Default(), filename, /*block_size=*/1 << 10,
+                             /*memory_map=*/true));
+  tstring line;
+  EXPECT_THAT(reader->ReadLine(&line),
+              StatusIs(absl::StatusCode::kOutOfRange));
+}
+
+TEST(TextLineReaderTest, FileDoesNotExist) {
+  EXPECT_THAT(TextLineReader::Create(Env::Default(), "/file/does/not/exist",
+                                     /*block_size=*/1 << 10,
+                                     /*memory_map=*/true),
+              StatusIs(absl::StatusCode::kNotFound));
+}
+
+// Writes a file of `num_lines` lines of `line_length` bytes.
+std::string WriteBenchmarkFile(int64_t num_lines, int64_t line_length) {
+  std::string contents;
+  contents.reserve(num_lines * (line_length + 1));
+  for (int64_t i = 0; i < num_lines; ++i) {
+    contents.append(line_length, 'a' + i % 26);
+    contents.push_back('\n');
+  }
+  std::string filename;
+  CHECK(Env::Default()->LocalTempFilename(&filename));
+  TF_CHECK_OK(WriteStringToFile(Env::Default(), filename, contents));
+  return filename;
+}
+
+constexpr int64_t kBenchmarkNumLines = 1 << 20;
+constexpr int64_t kBenchmarkBlockSize = 256 << 10;
+
+void BM_BufferedInputStreamReadLine(::testing::benchmark::State& state) {
+  const int64_t line_length = state.range(0);
+  const std::string filename =
+      WriteBenchmarkFile(kBenchmarkNumLines, line_length);
+  std::unique_ptr<RandomAccessFile> file;
+  TF_CHECK_OK(Env::Default()->NewRandomAccessFile(filename, &file));
+  int64_t num_lines = 0;
+  for (auto s : state) {
+    io::RandomAccessInputStream input_stream(file.get());
+    io::BufferedInputStream buffered_input_stream(&input_stream,
+                                                  kBenchmarkBlockSize);
+    tstring line;
+    while (buffered_input_stream.ReadLine(&line).ok()) {
+      ++num_lines;
+    }
+  }
+  state.SetBytesProcessed(num_lines * (line_length + 1));
+  state.SetItemsProcessed(num_lines);
+  TF_CHECK_OK(Env::Default()->DeleteFile(filename));
+}
+
+void TextLineReaderBenchmark(::testing::benchmark::State& state,
+                             bool memory_map) {
+  const int64_t line_length = state.range(0);
+  const std::string filename =
+      WriteBenchmarkFile(kBenchmarkNumLines, line_length);
+  int64_t num_lines = 0;
+  for (auto s : state) {
+    std::unique_ptr<TextLineReader> reader =
+        *TextLineReader::Create(Env::Default(), filename, kBenchmarkBlockSize,
+                                memory_map);
+    tstring line;
+    while (reader->ReadLine(&line).ok()) {
+      ++num_lines;
+    }
+  }
+  state.SetBytesProcessed(num_lines * (line_length + 1));
+  state.SetItemsProcessed(num_lines);
+  TF_CHECK_OK(Env::Default()->DeleteFile(filename));
+}
+
+void BM_TextLineReaderBlockRead(::testing::benchmark::State& state) {
+  TextLineReaderBenchmark(state, /*memory_map=*/false);
+}
+
+void BM_TextLineReaderMemoryMap(::testing::benchmark::State& state) {
+  TextLineReaderBenchmark(state, /*memory_map=*/true);
+}
+
+BENCHMARK(BM_BufferedInputStreamReadLine)->Arg(16)->Arg(128)->Arg(1024);
+BENCHMARK(BM_TextLineReaderBlockRead)->Arg(16)->Arg(128)->Arg(1024);
+BENCHMARK(BM_TextLineReaderMemoryMap)->Arg(16)->Arg(128)->Arg(1024);
+
+}  // namespace
+}  // namespace data
+}  // namespace tensorflow
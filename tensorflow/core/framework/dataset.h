@@ -386,6 +386,7 @@ class GraphDefBuilderWrapper {
   GraphDefBuilder* b_;
 };
 
+class ReadaheadManager;
 class StatsAggregator;
 
 // A utility class for running a function and ensuring that there is always a
@@ -692,6 +693,7 @@ class IteratorContext {
           model(ctx->model()),
           options(ctx->options()),
           ram_budget_manager(ctx->ram_budget_manager()),
+          readahead_manager(ctx->readahead_manager()),
           resource_mgr(ctx->resource_mgr()),
           runner(*(ctx->runner())),
           runner_threadpool_size(ctx->runner_threadpool_size()),
@@ -772,6 +774,11 @@ class IteratorContext {
     // Manager for the ram budget when using autotune.
     std::shared_ptr<model::RamBudgetManager> ram_budget_manager = nullptr;
 
+    // If non-null, file readers should read their files through it, so that
+    // their reads are issued asynchronously ahead of consumption. Set by
+    // parallel interleave for its input iterators.
+    std::shared_ptr<ReadaheadManager> readahead_manager = nullptr;
+
     // A resource manager for storing dataset-related state, e.g. random
     // seeds or cached tensors. Not owned.
     ResourceMgr* resource_mgr = nullptr;
@@ -885,6 +892,10 @@ class IteratorContext {
     return params_.ram_budget_manager;
   }
 
+  const std::shared_ptr<ReadaheadManager>& readahead_manager() const {
+    return params_.readahead_manager;
+  }
+
   ResourceMgr* resource_mgr() { return params_.resource_mgr; }
 
   std::function<void(std::function<void()>)>* runner() {
@@ -925,6 +936,11 @@ class IteratorContext {
 
   void SetModel(std::shared_ptr<model::Model> model) { params_.model = model; }
 
+  void SetReadaheadManager(
+      std::shared_ptr<ReadaheadManager> readahead_manager) {
+    params_.readahead_manager = std::move(readahead_manager);
+  }
+
   void SetIndexMapper(const IndexMapperFn& index_mapper) {
     params_.index_mapper = index_mapper;
   };
@@ -195,6 +195,21 @@ auto* tf_data_iterator_gap_msec_histogram = tsl::monitoring::Sampler<0>::New(
     // Power of 1.5 with bucket count of 20 (from 1 msec to about 2.2 secs).
     {tsl::monitoring::Buckets::Exponential(1, 1.5, 20)});
 
+auto* tf_data_checkpoint_stall_msec_histogram =
+    tsl::monitoring::Sampler<2>::New(
+        {"/tensorflow/data/checkpoint_stall_time",
+         "The time (in milliseconds) during which a stage of saving a tf.data "
+         "iterator checkpoint blocked the caller.",
+         "mode", "stage"},
+        // Power of 1.5 with bucket count of 30 (from 1 msec to about 3 mins).
+        {tsl::monitoring::Buckets::Exponential(1, 1.5, 30)});
+
+auto* tf_data_checkpoint_bytes_counter = tsl::monitoring::Counter<1>::New(
+    "/tensorflow/data/checkpoint_bytes",
+    "The number of bytes of tf.data iterator state compressed or reused by "
+    "asynchronous checkpointing.",
+    "reused");
+
 auto* tf_data_optimization_counter = tsl::monitoring::Counter<1>::New(
     "/tensorflow/data/optimization", "tf.data optimization", "name");
 
@@ -604,6 +619,17 @@ void RecordTFDataIteratorGap(uint64 duration_us) {
   tf_data_iterator_gap_msec_histogram_cell->Add(duration_us * 0.001);
 }
 
+void RecordTFDataCheckpointStallTime(const string& mode, const string& stage,
+                                     uint64 duration_us) {
+  tf_data_checkpoint_stall_msec_histogram->GetCell(mode, stage)->Add(
+      duration_us * 0.001);
+}
+
+void RecordTFDataCheckpointBytes(bool reused, int64_t num_bytes) {
+  tf_data_checkpoint_bytes_counter->GetCell(reused ? "true" : "false")
+      ->IncrementBy(num_bytes);
+}
+
 void RecordTFDataOptimization(const string& name, int64_t num_changes) {
   tf_data_optimization_counter->GetCell(name)->IncrementBy(num_changes);
 }
@@ -138,6 +138,17 @@ void RecordTFDataIteratorLifetime(uint64 duration_us);
 // request.
 void RecordTFDataIteratorGap(uint64 duration_us);
 
+// Records the time (in microseconds) during which a stage of saving a tf.data
+// iterator checkpoint blocked the caller. `mode` is "sync" or "async", and
+// `stage` is "serialize" or "encode".
+void RecordTFDataCheckpointStallTime(const string& mode, const string& stage,
+                                     uint64 duration_us);
+
+// Records the number of bytes of tf.data iterator state which were compressed
+// (`reused` is false) or reused from the previous checkpoint (`reused` is
+// true) by asynchronous checkpointing.
+void RecordTFDataCheckpointBytes(bool reused, int64_t num_bytes);
+
 // Records the number of independent graph changes resulting from the
 // application of a tf.data optimization.
 //
@@ -51,6 +51,7 @@ const char* const kColocationGroupPrefix = "loc:@";
 // DistributedTPURewritePass for more details.
 const char* const kTpuExecuteStagingOp = "IdentityN";
 const char* const kTpuExecuteStagingNodeName = "_variable_copy";
+const char* const kCriticalPathPriorityAttrName = "_critical_path_priority";
 
 AttrSlice::AttrSlice() : ndef_(nullptr) {
   static const AttrValueMap* const kEmptyAttrValueMap = new AttrValueMap;
@@ -62,6 +62,11 @@ extern const char* const kColocationGroupPrefix;
 extern const char* const kTpuExecuteStagingOp;
 extern const char* const kTpuExecuteStagingNodeName;
 
+// Name of the int attribute holding the estimated cost, in nanoseconds, of the
+// longest path from a node to the end of its graph. The executor runs ready
+// nodes with a higher value first.
+extern const char* const kCriticalPathPriorityAttrName;
+
 // Produce a human-readable version of a Node or NodeDef that is more concise
 // than a text-format proto.
 //
@@ -0,0 +1,68 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the host CPU and saves the HostCalibration used by the
+// OpLevelCostEstimator when TF_GRAPPLER_HOST_CALIBRATION_FILE points to it.
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "absl/time/time.h"
+#include "tensorflow/core/grappler/costs/host_calibration.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/init_main.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/command_line_flags.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+int main(int argc, char* argv[]) {
+  std::string output;
+  int num_threads = 0;
+  int min_time_ms = 200;
+  std::vector<Flag> flag_list = {
+      Flag("output", &output, "Path of the HostCalibration text proto"),
+      Flag("num_threads", &num_threads,
+           "Number of benchmark threads; 0 uses all the schedulable CPUs"),
+      Flag("min_time_ms", &min_time_ms,
+           "Minimum running time of each benchmark, in milliseconds"),
+  };
+  std::string usage = Flags::Usage(argv[0], flag_list);
+  bool parse_result = Flags::Parse(&argc, argv, flag_list);
+  if (!parse_result || output.empty()) {
+    std::cerr << usage;
+    return -1;
+  }
+  port::InitMain(argv[0], &argc, &argv);
+
+  HostCalibrationOptions options;
+  options.num_threads = num_threads;
+  options.min_time = absl::Milliseconds(min_time_ms);
+  const HostCalibration calibration = CalibrateHost(options);
+  TF_CHECK_OK(SaveHostCalibration(Env::Default(), output, calibration));
+  std::cout << calibration.DebugString();
+  return 0;
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
+
+int main(int argc, char* argv[]) {
+  return tensorflow::grappler::main(argc, argv);
+}
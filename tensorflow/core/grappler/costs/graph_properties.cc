@@ -15,6 +15,9 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/costs/graph_properties.h"
 
+#include <algorithm>
+#include <numeric>
+
 #include "absl/hash/hash.h"
 #include "absl/types/optional.h"
 #include "tensorflow/core/common_runtime/function.h"
@@ -35,9 +38,14 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils.h"
 #include "tensorflow/core/grappler/utils/functions.h"
 #include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/flatset.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/str_util.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -491,6 +499,169 @@ uint64 NumElementsFromTensorProto(const TensorProto& tensor_proto) {
   return num_elements;
 }
 
+// Returns the smallest symbolic dimension of `properties`, or -1.
+int64_t MinSymbolicDim(
+    const absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>&
+        properties) {
+  int64_t min_dim = -1;
+  for (const auto& node_properties : properties) {
+    for (const auto& tensor : node_properties.second) {
+      for (const auto& dim : tensor.shape().dim()) {
+        min_dim = std::min(min_dim, dim.size());
+      }
+    }
+  }
+  return min_dim;
+}
+
+// Output properties of the function bodies inferred so far, keyed by the
+// fingerprint of the body and of its arguments specialized to the shapes and
+// values of the inputs of the call. A function called with the same inputs by
+// many nodes, or in every InferStatically call of a pass, is inferred once per
+// process.
+class FunctionShapeCache {
+ public:
+  static FunctionShapeCache* Global() {
+    static FunctionShapeCache* const cache = new FunctionShapeCache;
+    return cache;
+  }
+
+  // Returns the fingerprint of the function `body` before specialization,
+  // computed once per function by every SymbolicShapeRefiner.
+  static Fprint128 BodyFingerprint(const GraphDef& body) {
+    std::string serialized;
+    SerializeToStringDeterministic(body, &serialized);
+    return Fingerprint128(serialized);
+  }
+
+  // Returns the key of a call of the function with `body_fingerprint`, whose
+  // `args` are the _Arg nodes annotated with the shapes of the inputs of the
+  // call, or the Const nodes that replaced them. Specialization changes no
+  // other node, so only the arguments are serialized for every call. A hit
+  // returns the outputs of another call, so the key is a 128-bit fingerprint
+  // rather than a hash, to make collisions negligible.
+  static Fprint128 Key(const Fprint128& body_fingerprint,
+                       const std::vector<const NodeDef*>& args,
+                       bool aggressive_shape_inference) {
+    Fprint128 key = tsl::FingerprintCat128(body_fingerprint,
+                                           aggressive_shape_inference ? 1 : 0);
+    std::string serialized;
+    for (const NodeDef* arg : args) {
+      SerializeToStringDeterministic(*arg, &serialized);
+      key = tsl::FingerprintCat128(key, Fingerprint128(serialized));
+    }
+    return key;
+  }
+
+  bool Lookup(const Fprint128& key,
+              std::vector<OpInfo::TensorProperties>* outputs) {
+    mutex_lock l(mu_);
+    auto it = outputs_.find(key);
+    if (it == outputs_.end()) return false;
+    *outputs = it->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key,
+              std::vector<OpInfo::TensorProperties> outputs) {
+    mutex_lock l(mu_);
+    // Entries are a few shapes each, so the number of entries bounds the
+    // memory. When full, the cache starts over rather than tracking recency:
+    // the functions of the current pass are inferred again on their next call.
+    if (outputs_.size() >= kMaxEntries) outputs_.clear();
+    outputs_[key] = std::move(outputs);
+  }
+
+ private:
+  static constexpr int kMaxEntries = 16384;
+
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::vector<OpInfo::TensorProperties>,
+                      Fprint128Hasher>
+      outputs_ TF_GUARDED_BY(mu_);
+};
+
+// Graphs with fewer nodes are inferred on a single thread.
+constexpr int kMinNodesToShardShapeInference = 4096;
+
+// Returns the threads refining the shards of large graphs, created on first use
+// and shared by all the GraphProperties of the process.
+thread::ThreadPool* ShapeInferenceThreadPool() {
+  static thread::ThreadPool* const pool = new thread::ThreadPool(
+      Env::Default(), "graph_properties", port::MaxParallelism());
+  return pool;
+}
+
+// Splits `topo_order` into at most `num_shards` groups of weakly connected
+// components of the graph, linked by regular edges and by the enqueue ops of
+// the queues. Shapes only propagate along these links, so every group can be
+// refined separately. The components are assigned largest first to the
+// smallest group, and every group is in topological order.
+std::vector<std::vector<const NodeDef*>> ShardIndependentNodes(
+    const GraphView& graph_view, const std::vector<const NodeDef*>& topo_order,
+    const absl::flat_hash_map<const NodeDef*, const NodeDef*>& resource_handles,
+    int num_shards) {
+  const int num_nodes = topo_order.size();
+  absl::flat_hash_map<const NodeDef*, int> index;
+  index.reserve(num_nodes);
+  for (int i = 0; i < num_nodes; ++i) index.emplace(topo_order[i], i);
+
+  std::vector<int> parent(num_nodes);
+  std::iota(parent.begin(), parent.end(), 0);
+  auto find = [&parent](int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+  auto unite = [&](const NodeDef* a, const NodeDef* b) {
+    auto a_it = index.find(a);
+    auto b_it = index.find(b);
+    if (a_it == index.end() || b_it == index.end()) return;
+    parent[find(a_it->second)] = find(b_it->second);
+  };
+  for (const NodeDef* node : topo_order) {
+    for (const auto& fanin :
+         graph_view.GetFanins(*node, /*include_controlling_nodes=*/false)) {
+      unite(node, fanin.node);
+    }
+  }
+  for (const auto& resource_handle : resource_handles) {
+    unite(resource_handle.first, resource_handle.second);
+  }
+
+  absl::flat_hash_map<int, int> component_sizes;
+  for (int i = 0; i < num_nodes; ++i) ++component_sizes[find(i)];
+  num_shards = std::min<int>(num_shards, component_sizes.size());
+  if (num_shards <= 1) return {topo_order};
+
+  std::vector<std::pair<int, int>> components(component_sizes.begin(),
+                                              component_sizes.end());
+  std::sort(components.begin(), components.end(),
+            [](const std::pair<int, int>& a, const std::pair<int, int>& b) {
+              return a.second > b.second ||
+                     (a.second == b.second && a.first < b.first);
+            });
+  std::vector<int> shard_sizes(num_shards, 0);
+  absl::flat_hash_map<int, int> component_shards;
+  for (const auto& component : components) {
+    const int shard =
+        std::min_element(shard_sizes.begin(), shard_sizes.end()) -
+        shard_sizes.begin();
+    shard_sizes[shard] += component.second;
+    component_shards[component.first] = shard;
+  }
+  std::vector<std::vector<const NodeDef*>> shards(num_shards);
+  for (int shard = 0; shard < num_shards; ++shard) {
+    shards[shard].reserve(shard_sizes[shard]);
+  }
+  for (int i = 0; i < num_nodes; ++i) {
+    shards[component_shards[find(i)]].push_back(topo_order[i]);
+  }
+  return shards;
+}
+
 }  // namespace
 
 // Note that tensor_as_shape input should not include kUnknownDimFromConst.
@@ -775,6 +946,20 @@ class SymbolicShapeRefiner {
     return it->second.inference_context.get();
   }
 
+  // Takes over the node contexts of `other`, which refined a disjoint set of
+  // nodes of the same graph. `other` is kept alive since the contexts point to
+  // the tensors it owns.
+  void Absorb(std::unique_ptr<SymbolicShapeRefiner> other) {
+    node_to_context_.reserve(node_to_context_.size() +
+                             other->node_to_context_.size());
+    for (auto& node_and_context : other->node_to_context_) {
+      node_to_context_.emplace(node_and_context.first,
+                               std::move(node_and_context.second));
+    }
+    other->node_to_context_.clear();
+    absorbed_refiners_.push_back(std::move(other));
+  }
+
   // Forward the shapes from the function input nodes, PartitionedCalls or
   // StatefulPartitionedCall to
   // the argument nodes (which are Placeholder nodes), then
@@ -893,6 +1078,13 @@ class SymbolicShapeRefiner {
     for (const auto& output_arg : grappler_function_item.outputs()) {
       output_nodes[output_arg.node_name] = gv.GetNode(output_arg.node_name);
     }
+    // ReplaceInputWithConst() overwrites the _Arg nodes in place, so these
+    // point to the specialized arguments once the inputs are replaced.
+    std::vector<const NodeDef*> arg_nodes;
+    arg_nodes.reserve(grappler_function_item.inputs().size());
+    for (const auto& input_arg : grappler_function_item.inputs()) {
+      arg_nodes.push_back(gv.GetNode(input_arg.node_name));
+    }
 
     // Replace input nodes with Consts, if values are known. Note that
     // we don't check exceptions here as it's done in the above loop.
@@ -936,38 +1128,51 @@ class SymbolicShapeRefiner {
       output_node->mutable_attr()->erase("index");
     }
 
-    // Perform inference on function body.
-    GraphProperties gp(grappler_function_item);
-    TF_RETURN_IF_ERROR(gp.InferStatically(
-        /*assume_valid_feeds=*/true,
-        /*aggressive_shape_inference=*/aggressive_shape_inference_,
-        /*include_tensor_values=*/true));
+    // Perform inference on function body, unless a call with the same
+    // specialized body was inferred before.
+    const Fprint128 cache_key =
+        FunctionShapeCache::Key(fun_to_body_fingerprint_.at(function.name()),
+                                arg_nodes, aggressive_shape_inference_);
+    std::vector<OpInfo::TensorProperties> function_outputs;
+    if (!FunctionShapeCache::Global()->Lookup(cache_key, &function_outputs)) {
+      GraphProperties gp(grappler_function_item);
+      TF_RETURN_IF_ERROR(gp.InferStatically(
+          /*assume_valid_feeds=*/true,
+          /*aggressive_shape_inference=*/aggressive_shape_inference_,
+          /*include_tensor_values=*/true));
+      for (auto const& out_arg : grappler_function_item.outputs()) {
+        // It is guaranteed that output_tensors does not contain any control
+        // inputs, so port_id >= 0.
+        TensorId out_tensor = ParseTensorName(out_arg.node_name);
+
+        if (output_nodes.count(out_tensor.node()) <= 0) {
+          return errors::FailedPrecondition(
+              "Unable to find return function_node ", out_tensor.node(),
+              " for ", function_node->name());
+        }
+        const NodeDef* retnode = output_nodes[out_tensor.node()];
+
+        const auto& output_properties =
+            gp.GetOutputProperties(retnode->name());
+        int output_properties_size = output_properties.size();
+        if (out_tensor.index() >= output_properties_size) {
+          return errors::InvalidArgument(
+              out_tensor.ToString(), " has invalid position ",
+              out_tensor.index(),
+              " (output_properties.size() = ", output_properties.size(), ").");
+        }
+        function_outputs.push_back(output_properties[out_tensor.index()]);
+      }
+      FunctionShapeCache::Global()->Insert(cache_key, function_outputs);
+    }
 
     // Add return nodes for output shapes.
-    int output = 0;
     ctx->output_tensors_as_shapes.resize(grappler_function_item.output_size());
     ctx->output_tensor_protos.resize(grappler_function_item.output_size(),
                                      nullptr);
-    for (auto const& out_arg : grappler_function_item.outputs()) {
-      // It is guaranteed that output_tensors does not contain any control
-      // inputs, so port_id >= 0.
-      TensorId out_tensor = ParseTensorName(out_arg.node_name);
-
-      if (output_nodes.count(out_tensor.node()) <= 0) {
-        return errors::FailedPrecondition(
-            "Unable to find return function_node ", out_tensor.node(), " for ",
-            function_node->name());
-      }
-      const NodeDef* retnode = output_nodes[out_tensor.node()];
-
-      auto output_properties = gp.GetOutputProperties(retnode->name());
-      int output_properties_size = output_properties.size();
-      if (out_tensor.index() >= output_properties_size) {
-        return errors::InvalidArgument(
-            out_tensor.ToString(), " has invalid position ", out_tensor.index(),
-            " (output_properties.size() = ", output_properties.size(), ").");
-      }
-      auto& outprop = output_properties[out_tensor.index()];
+    for (int output = 0, end = function_outputs.size(); output < end;
+         ++output) {
+      const auto& outprop = function_outputs[output];
       TensorShapeProto shape = outprop.shape();
       NormalizeShapeForOutput(&shape);
       ShapeHandle out;
@@ -980,7 +1185,6 @@ class SymbolicShapeRefiner {
         const_tensors_to_propagate_.push_back(outprop.value());
         ctx->output_tensor_protos[output] = &const_tensors_to_propagate_.back();
       }
-      output++;
     }
 
     return absl::OkStatus();
@@ -1345,8 +1549,10 @@ class SymbolicShapeRefiner {
       }
     }
 
+    fun_to_body_fingerprint_[function_def->signature().name()] =
+        FunctionShapeCache::BodyFingerprint(grappler_function_item.graph);
     fun_to_grappler_function_item_[function_def->signature().name()] =
-        grappler_function_item;
+        std::move(grappler_function_item);
 
     return absl::OkStatus();
   }
@@ -2051,6 +2257,9 @@ class SymbolicShapeRefiner {
   // instantiation failed it will have an `absl::nullopt`.
   absl::flat_hash_map<string, absl::optional<GrapplerFunctionItem>>
       fun_to_grappler_function_item_;
+  // Fingerprints of the bodies of the valid functions, keying their calls in
+  // FunctionShapeCache.
+  absl::flat_hash_map<string, Fprint128> fun_to_body_fingerprint_;
   FunctionLibraryDefinition function_library_;
   const absl::flat_hash_map<string, absl::flat_hash_set<int>>& fed_ports_;
   // Store TensorProtos for tensor value propagation. Note that we use deque,
@@ -2062,6 +2271,8 @@ class SymbolicShapeRefiner {
   // For more aggressive shape and value inference.
   bool aggressive_shape_inference_;
   ResourceMgr resource_mgr_;
+
+  std::vector<std::unique_ptr<SymbolicShapeRefiner>> absorbed_refiners_;
 };
 
 // Keep track of shapes and dimensions in a graph.
@@ -2607,18 +2818,35 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   auto refiner = std::make_unique<SymbolicShapeRefiner>(
       graph_view, fed_ports, aggressive_shape_inference);
 
-  TopoQueue new_shapes(topo_order);
-  // Also seed the propagation of shapes in the fanout of primary inputs.
-  for (const NodeDef* node : primary_inputs) {
-    new_shapes.push(node);
-  }
-  // Also seed the propagation of shapes in the fanout of fed nodes.
-  for (const NodeDef* node : fed_nodes) {
-    new_shapes.push(node);
+  // Independent parts of large graphs are refined on separate threads.
+  std::vector<std::vector<const NodeDef*>> shards;
+  if (item_.graph.node_size() >= kMinNodesToShardShapeInference) {
+    shards = ShardIndependentNodes(
+        graph_view, topo_order, resource_handles,
+        item_.optimization_options().intra_op_parallelism_threads);
+  }
+  if (shards.size() > 1) {
+    // Seed the propagation of shapes in the fanout of primary inputs and fed
+    // nodes.
+    absl::flat_hash_set<const NodeDef*> seeds = primary_inputs;
+    seeds.insert(fed_nodes.begin(), fed_nodes.end());
+    TF_RETURN_IF_ERROR(PropagateShapesInShards(
+        shards, seeds, fed_ports, graph_view, resource_handles,
+        aggressive_shape_inference, num_loops, refiner.get()));
+  } else {
+    TopoQueue new_shapes(topo_order);
+    // Also seed the propagation of shapes in the fanout of primary inputs.
+    for (const NodeDef* node : primary_inputs) {
+      new_shapes.push(node);
+    }
+    // Also seed the propagation of shapes in the fanout of fed nodes.
+    for (const NodeDef* node : fed_nodes) {
+      new_shapes.push(node);
+    }
+    // Propagate shapes normally.
+    TF_RETURN_IF_ERROR(PropagateShapes(refiner.get(), &new_shapes,
+                                       resource_handles, num_loops));
   }
-  // Propagate shapes normally.
-  TF_RETURN_IF_ERROR(
-      PropagateShapes(refiner.get(), &new_shapes, resource_handles, num_loops));
 
   // Track shapes globally across the graph.
   std::unique_ptr<SymbolicShapeManager> shape_manager =
@@ -2756,6 +2984,212 @@ Status GraphProperties::InferStatically(bool assume_valid_feeds,
   TF_RETURN_IF_ERROR(VerboseShapeInferenceLogging(item_.graph, refiner.get(),
                                                   shape_manager.get()));
 
+  inferred_statically_ = true;
+  assume_valid_feeds_ = assume_valid_feeds;
+  aggressive_shape_inference_ = aggressive_shape_inference;
+  include_input_tensor_values_ = include_input_tensor_values;
+  include_output_tensor_values_ = include_output_tensor_values;
+  min_symbolic_dim_ = std::min(min_symbolic_dim_,
+                               MinSymbolicDim(input_properties_));
+  min_symbolic_dim_ = std::min(min_symbolic_dim_,
+                               MinSymbolicDim(output_properties_));
+  return absl::OkStatus();
+}
+
+Status GraphProperties::PropagateShapesInShards(
+    const std::vector<std::vector<const NodeDef*>>& shards,
+    const absl::flat_hash_set<const NodeDef*>& seeds,
+    const absl::flat_hash_map<string, absl::flat_hash_set<int>>& fed_ports,
+    const GraphView& graph_view,
+    const absl::flat_hash_map<const NodeDef*, const NodeDef*>&
+        resource_handles,
+    bool aggressive_shape_inference, int num_loops,
+    SymbolicShapeRefiner* refiner) const {
+  VLOG(1) << "Propagating shapes in " << shards.size() << " shards";
+  std::vector<std::unique_ptr<SymbolicShapeRefiner>> shard_refiners(
+      shards.size());
+  std::vector<Status> statuses(shards.size());
+  const auto propagate = [&](int64_t begin, int64_t end) {
+    for (int64_t i = begin; i < end; ++i) {
+      shard_refiners[i] = std::make_unique<SymbolicShapeRefiner>(
+          graph_view, fed_ports, aggressive_shape_inference);
+      TopoQueue new_shapes(shards[i]);
+      for (const NodeDef* node : shards[i]) {
+        if (seeds.contains(node)) new_shapes.push(node);
+      }
+      statuses[i] = PropagateShapes(shard_refiners[i].get(), &new_shapes,
+                                    resource_handles, num_loops);
+    }
+  };
+  thread::ThreadPool* pool = ShapeInferenceThreadPool();
+  if (pool->CurrentThreadId() >= 0) {
+    // A large function body inferred from a shard must not wait for threads of
+    // the pool that may all be waiting for it.
+    propagate(0, shards.size());
+  } else {
+    pool->ParallelFor(
+        shards.size(),
+        thread::ThreadPool::SchedulingParams(
+            thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+            std::nullopt, /*block_size=*/1),
+        propagate);
+  }
+  for (const Status& status : statuses) {
+    TF_RETURN_IF_ERROR(status);
+  }
+  for (auto& shard_refiner : shard_refiners) {
+    refiner->Absorb(std::move(shard_refiner));
+  }
+  return absl::OkStatus();
+}
+
+Status GraphProperties::UpdateStatically(
+    const absl::flat_hash_set<string>& modified_nodes) {
+  if (!inferred_statically_) {
+    return errors::FailedPrecondition(
+        "UpdateStatically requires properties inferred by InferStatically");
+  }
+  auto infer_from_scratch = [this]() {
+    input_properties_.clear();
+    output_properties_.clear();
+    incompatible_shape_nodes_.clear();
+    return InferStatically(assume_valid_feeds_, aggressive_shape_inference_,
+                           include_input_tensor_values_,
+                           include_output_tensor_values_);
+  };
+
+  // Collects the transitive fanout of the nodes still in the graph.
+  GraphView graph_view(&item_.graph);
+  absl::flat_hash_set<const NodeDef*> fanout;
+  std::vector<const NodeDef*> ready;
+  for (const string& name : modified_nodes) {
+    const NodeDef* node = graph_view.GetNode(name);
+    if (node == nullptr) {
+      ClearInputProperties(name);
+      ClearOutputProperties(name);
+      incompatible_shape_nodes_.erase(name);
+    } else if (fanout.insert(node).second) {
+      ready.push_back(node);
+    }
+  }
+  while (!ready.empty()) {
+    const NodeDef* node = ready.back();
+    ready.pop_back();
+    // Queues link their enqueue and dequeue ops outside of the regular edges.
+    if (IsQueue(*node) || IsEnqueue(*node) || IsDequeue(*node)) {
+      return infer_from_scratch();
+    }
+    for (const auto& fanout_port :
+         graph_view.GetFanouts(*node, /*include_controlled_nodes=*/false)) {
+      if (fanout.insert(fanout_port.node).second) {
+        ready.push_back(fanout_port.node);
+      }
+    }
+  }
+  if (fanout.empty()) return absl::OkStatus();
+
+  // Infers the fanout as a graph of its own, which reads the tensors produced
+  // by the rest of the graph from constants or placeholders of the inferred
+  // properties.
+  GrapplerItem subgraph;
+  subgraph.id = item_.id;
+  subgraph.optimization_options() = item_.optimization_options();
+  *subgraph.graph.mutable_versions() = item_.graph.versions();
+  *subgraph.graph.mutable_library() = item_.graph.library();
+  absl::flat_hash_map<string, string> boundary_nodes;
+  auto add_boundary_node = [&](const TensorId& tensor,
+                               string* boundary_name) -> bool {
+    const NodeDef* producer = graph_view.GetNode(tensor.node());
+    const auto& properties = GetOutputProperties(producer->name());
+    if (tensor.index() >= static_cast<int>(properties.size())) return false;
+    const OpInfo::TensorProperties& output = properties[tensor.index()];
+    string name = AddPrefixToNodeName(
+        strings::StrCat(tensor.node(), "_", tensor.index()),
+        "GraphPropertiesBoundary");
+    while (graph_view.GetNode(name) != nullptr) name += "_";
+    NodeDef* node = subgraph.graph.add_node();
+    node->set_name(name);
+    node->set_device(producer->device());
+    if (output.has_value()) {
+      node->set_op("Const");
+      (*node->mutable_attr())["dtype"].set_type(output.value().dtype());
+      *(*node->mutable_attr())["value"].mutable_tensor() = output.value();
+    } else {
+      node->set_op("Placeholder");
+      (*node->mutable_attr())["dtype"].set_type(BaseType(output.dtype()));
+      TensorShapeProto shape = output.shape();
+      NormalizeShapeForOutput(&shape);
+      *(*node->mutable_attr())["shape"].mutable_shape() = shape;
+    }
+    *boundary_name = name;
+    return true;
+  };
+  for (const NodeDef& node : item_.graph.node()) {
+    if (!fanout.contains(&node)) continue;
+    NodeDef* copy = subgraph.graph.add_node();
+    *copy = node;
+    copy->clear_input();
+    for (const string& input : node.input()) {
+      const TensorId tensor = ParseTensorName(input);
+      const NodeDef* producer = graph_view.GetNode(tensor.node());
+      if (producer != nullptr && fanout.contains(producer)) {
+        copy->add_input(input);
+      } else if (producer == nullptr || tensor.index() < 0) {
+        // Control dependencies do not change shapes.
+        continue;
+      } else {
+        string& boundary_name = boundary_nodes[input];
+        if (boundary_name.empty() &&
+            !add_boundary_node(tensor, &boundary_name)) {
+          return infer_from_scratch();
+        }
+        copy->add_input(boundary_name);
+      }
+    }
+  }
+  for (const auto& feed : item_.feed) {
+    const NodeDef* node = graph_view.GetNode(NodeName(feed.first));
+    if (node != nullptr && fanout.contains(node)) {
+      subgraph.feed.push_back(feed);
+    }
+  }
+  VLOG(1) << "Updating the properties of " << fanout.size() << " nodes";
+
+  GraphProperties properties(subgraph);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      assume_valid_feeds_, aggressive_shape_inference_,
+      include_input_tensor_values_, include_output_tensor_values_));
+
+  // Numbers the symbolic dimensions of the fanout below those of the rest of
+  // the graph, so that they are not mistaken for each other.
+  const int64_t symbolic_dim_offset = min_symbolic_dim_ + 1;
+  auto renumber = [&](std::vector<OpInfo::TensorProperties> tensors) {
+    for (auto& tensor : tensors) {
+      for (auto& dim : *tensor.mutable_shape()->mutable_dim()) {
+        if (dim.size() < -1) {
+          dim.set_size(dim.size() + symbolic_dim_offset);
+          min_symbolic_dim_ = std::min(min_symbolic_dim_, dim.size());
+        }
+      }
+    }
+    return tensors;
+  };
+  for (const NodeDef* node : fanout) {
+    const string& name = node->name();
+    ClearInputProperties(name);
+    ClearOutputProperties(name);
+    incompatible_shape_nodes_.erase(name);
+    if (properties.HasInputProperties(name)) {
+      input_properties_[name] = renumber(properties.GetInputProperties(name));
+    }
+    if (properties.HasOutputProperties(name)) {
+      output_properties_[name] =
+          renumber(properties.GetOutputProperties(name));
+    }
+    if (properties.CheckShapeIncompatible(name)) {
+      incompatible_shape_nodes_.insert(name);
+    }
+  }
   return absl::OkStatus();
 }
 
@@ -21,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "tensorflow/core/framework/shape_inference.h"
 #include "tensorflow/core/grappler/clusters/cluster.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
@@ -69,6 +70,7 @@ ABSL_CONST_INIT const char kOutputTypes[] = "_output_dtype_vector";
 // Outputs TensorShapeProto vector.
 ABSL_CONST_INIT const char kOutputShapes[] = "_output_shape_vector";
 
+class GraphView;
 class SymbolicShapeRefiner;
 class TopoQueue;
 
@@ -114,6 +116,14 @@ class GraphProperties {
                            /*aggressive_shape_inference=*/false,
                            /*include_tensor_values=*/true);
   }
+  // Re-infers the properties of the nodes in the transitive fanout of
+  // `modified_nodes`, which were changed, added or removed in the graph of the
+  // item since the properties were inferred statically, and keeps those of the
+  // other nodes. The options of the last InferStatically call are reused. The
+  // fanout sees the inputs it reads from the rest of the graph as unrelated
+  // symbolic dimensions, so the result can be less precise than that of
+  // InferStatically.
+  Status UpdateStatically(const absl::flat_hash_set<string>& modified_nodes);
   // Infer the shape by running the graph on the specified cluster and recording
   // the shapes of the processed tensors.
   Status InferDynamically(Cluster* cluster);
@@ -156,6 +166,7 @@ class GraphProperties {
   void Clear() {
     input_properties_.clear();
     output_properties_.clear();
+    inferred_statically_ = false;
   }
 
  private:
@@ -200,6 +211,19 @@ class GraphProperties {
           resource_handles,
       int num_loops) const;
 
+  // Propagates the shapes of every shard, a group of nodes sharing no regular
+  // edge or resource with the other shards, with its own SymbolicShapeRefiner
+  // on a thread of a shared pool, then moves the results into `refiner`.
+  Status PropagateShapesInShards(
+      const std::vector<std::vector<const NodeDef*>>& shards,
+      const absl::flat_hash_set<const NodeDef*>& seeds,
+      const absl::flat_hash_map<string, absl::flat_hash_set<int>>& fed_ports,
+      const GraphView& graph_view,
+      const absl::flat_hash_map<const NodeDef*, const NodeDef*>&
+          resource_handles,
+      bool aggressive_shape_inference, int num_loops,
+      SymbolicShapeRefiner* refiner) const;
+
   // Data members
   const GrapplerItem& item_;
   absl::flat_hash_map<string, std::vector<OpInfo::TensorProperties>>
@@ -211,6 +235,16 @@ class GraphProperties {
   // Nodes with output shape incompatible between shape inference and
   // annotation.
   std::unordered_set<string> incompatible_shape_nodes_;
+
+  // Options of the last InferStatically call, reused by UpdateStatically.
+  bool inferred_statically_ = false;
+  bool assume_valid_feeds_ = false;
+  bool aggressive_shape_inference_ = false;
+  bool include_input_tensor_values_ = false;
+  bool include_output_tensor_values_ = false;
+  // Smallest symbolic dimension of the properties, so that UpdateStatically
+  // numbers new ones below it.
+  int64_t min_symbolic_dim_ = -1;
 };
 
 // Helper function for GraphProperties.
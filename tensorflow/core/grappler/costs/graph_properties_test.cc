@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/protobuf.h"
 #include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 #ifdef INTEL_MKL
 #include "tensorflow/core/graph/mkl_graph_util.h"
 #endif
@@ -1508,6 +1509,37 @@ TEST_F(GraphPropertiesTest, FunctionWithIdentityOfConstInput) {
   EXPECT_EQ("float: [1,2,3,4]", PropToString(out_prop0));
 }
 
+TEST_F(GraphPropertiesTest, FunctionCallsWithDifferentConstInputs) {
+  // Both calls share the body of MyFillFunc, but its specialized arguments
+  // differ, so the second call must not reuse the shapes of the first one.
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  TF_ASSERT_OK(s.graph()->AddFunctionLibrary(function_lib_));
+  Output shape1 = ops::Const(s.WithOpName("shape1"), {1, 2, 3, 4});
+  Output shape2 = ops::Const(s.WithOpName("shape2"), {5, 6});
+  Output value = ops::Const(s.WithOpName("value"), 0.1f, {});
+  auto _value = tensorflow::ops::AsNodeOut(s, value);
+  tensorflow::Node* func_op;
+  TF_ASSERT_OK(tensorflow::NodeBuilder("fill1", "MyFillFunc",
+                                       s.graph()->op_registry())
+                   .Input(tensorflow::ops::AsNodeOut(s, shape1))
+                   .Input(_value)
+                   .Finalize(s.graph(), &func_op));
+  TF_ASSERT_OK(tensorflow::NodeBuilder("fill2", "MyFillFunc",
+                                       s.graph()->op_registry())
+                   .Input(tensorflow::ops::AsNodeOut(s, shape2))
+                   .Input(_value)
+                   .Finalize(s.graph(), &func_op));
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphProperties properties(item);
+  TF_ASSERT_OK(properties.InferStatically(false));
+  EXPECT_EQ("float: [1,2,3,4]",
+            PropToString(properties.GetOutputProperties("fill1")[0]));
+  EXPECT_EQ("float: [5,6]",
+            PropToString(properties.GetOutputProperties("fill2")[0]));
+}
+
 TEST_F(GraphPropertiesTest, FunctionReturnTensorValue) {
   FunctionDefLibrary library;
   *library.add_function() = FunctionDefHelper::Create(
@@ -2675,6 +2707,145 @@ TEST(HelperFunctions, IsShapeFullyDefinedIntegerVectorOrScalar) {
   EXPECT_FALSE(IsShapeFullyDefinedIntegerVectorOrScalar(
       &ic, fully_defined_vector, vector_with_unknown_from_const, DT_INT32));
 }
+
+// Builds `num_towers` independent chains of `depth` matmuls, whose batch
+// dimension is unknown.
+GraphDef MakeTowersGraph(int num_towers, int depth) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  for (int t = 0; t < num_towers; ++t) {
+    Output y = ops::Placeholder(s.WithOpName("x_", t), DT_FLOAT,
+                                ops::Placeholder::Shape({-1, 16}));
+    Output w = ops::Const(s.WithOpName("w_", t), 1.0f, {16, 16});
+    for (int d = 0; d < depth; ++d) {
+      y = ops::MatMul(s.WithOpName("matmul_", t, "_", d), y, w);
+      y = ops::Relu(s.WithOpName("relu_", t, "_", d), y);
+    }
+  }
+  GraphDef graph;
+  TF_CHECK_OK(s.ToGraphDef(&graph));
+  return graph;
+}
+
+TEST_F(GraphPropertiesTest, ShardedInferenceMatchesSequential) {
+  GrapplerItem item;
+  item.graph = MakeTowersGraph(/*num_towers=*/256, /*depth=*/8);
+  item.optimization_options().intra_op_parallelism_threads = 1;
+  GrapplerItem sharded_item = item;
+  sharded_item.optimization_options().intra_op_parallelism_threads = 4;
+
+  GraphProperties sequential(item);
+  TF_ASSERT_OK(sequential.InferStatically(false));
+  GraphProperties sharded(sharded_item);
+  TF_ASSERT_OK(sharded.InferStatically(false));
+
+  for (const NodeDef& node : item.graph.node()) {
+    const auto& expected = sequential.GetOutputProperties(node.name());
+    const auto& actual = sharded.GetOutputProperties(node.name());
+    ASSERT_EQ(expected.size(), actual.size()) << node.name();
+    for (size_t i = 0; i < expected.size(); ++i) {
+      EXPECT_EQ(PropToString(expected[i]), PropToString(actual[i]));
+    }
+  }
+  // The batch dimension is the same symbolic dimension within a tower and a
+  // different one across towers.
+  std::set<int64_t> batch_dims;
+  for (int t = 0; t < 256; ++t) {
+    const int64_t batch_dim =
+        sharded.GetOutputProperties(strings::StrCat("x_", t))[0]
+            .shape()
+            .dim(0)
+            .size();
+    EXPECT_LT(batch_dim, -1);
+    EXPECT_TRUE(batch_dims.insert(batch_dim).second);
+    EXPECT_EQ(batch_dim,
+              sharded.GetOutputProperties(strings::StrCat("relu_", t, "_7"))[0]
+                  .shape()
+                  .dim(0)
+                  .size());
+  }
+}
+
+TEST_F(GraphPropertiesTest, UpdateStaticallyReinfersTheFanout) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  Output x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 3}));
+  Output relu = ops::Relu(s.WithOpName("relu"), x);
+  Output identity = ops::Identity(s.WithOpName("identity"), relu);
+  Output y = ops::Placeholder(s.WithOpName("y"), DT_FLOAT,
+                              ops::Placeholder::Shape({-1, 5}));
+  Output other = ops::Relu(s.WithOpName("other"), y);
+  GrapplerItem item;
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphProperties properties(item);
+  EXPECT_FALSE(properties.UpdateStatically({"relu"}).ok());
+  TF_ASSERT_OK(properties.InferStatically(false));
+  auto batch_dim = [&properties](const string& name) {
+    return properties.GetOutputProperties(name)[0].shape().dim(0).size();
+  };
+  const int64_t x_dim = batch_dim("x");
+  const int64_t y_dim = batch_dim("y");
+
+  // Feed y rather than x to relu.
+  for (NodeDef& node : *item.graph.mutable_node()) {
+    if (node.name() == "relu") node.set_input(0, "y");
+  }
+  TF_ASSERT_OK(properties.UpdateStatically({"relu"}));
+  EXPECT_EQ("float: [-1,5]",
+            PropToString(properties.GetInputProperties("relu")[0]));
+  EXPECT_EQ("float: [-1,5]",
+            PropToString(properties.GetOutputProperties("identity")[0]));
+  EXPECT_EQ("float: [-1,5]",
+            PropToString(properties.GetOutputProperties("other")[0]));
+  // The nodes outside of the fanout are not inferred again, and the fanout
+  // does not reuse their symbolic dimensions.
+  EXPECT_EQ(x_dim, batch_dim("x"));
+  EXPECT_EQ(y_dim, batch_dim("y"));
+  EXPECT_LT(batch_dim("relu"), -1);
+  EXPECT_NE(batch_dim("relu"), x_dim);
+  EXPECT_NE(batch_dim("relu"), y_dim);
+  EXPECT_EQ(batch_dim("relu"), batch_dim("identity"));
+
+  // The properties of removed nodes are dropped.
+  item.graph.mutable_node()->erase(std::find_if(
+      item.graph.mutable_node()->begin(), item.graph.mutable_node()->end(),
+      [](const NodeDef& node) { return node.name() == "identity"; }));
+  TF_ASSERT_OK(properties.UpdateStatically({"identity"}));
+  EXPECT_FALSE(properties.HasOutputProperties("identity"));
+  EXPECT_TRUE(properties.HasOutputProperties("relu"));
+}
+
+void BM_InferStatically(::testing::benchmark::State& state) {
+  const int num_towers = state.range(0);
+  GrapplerItem item;
+  item.graph = MakeTowersGraph(num_towers, /*depth=*/32);
+  item.optimization_options().intra_op_parallelism_threads = state.range(1);
+  for (auto s : state) {
+    GraphProperties properties(item);
+    TF_CHECK_OK(properties.InferStatically(false));
+  }
+  state.SetItemsProcessed(state.iterations() * item.graph.node_size());
+}
+BENCHMARK(BM_InferStatically)
+    ->ArgPair(64, 1)
+    ->ArgPair(64, 8)
+    ->ArgPair(1024, 1)
+    ->ArgPair(1024, 8)
+    ->ArgPair(4096, 8);
+
+// Updates the properties after a change in the middle of a tower.
+void BM_UpdateStatically(::testing::benchmark::State& state) {
+  const int num_towers = state.range(0);
+  GrapplerItem item;
+  item.graph = MakeTowersGraph(num_towers, /*depth=*/32);
+  GraphProperties properties(item);
+  TF_CHECK_OK(properties.InferStatically(false));
+  for (auto s : state) {
+    TF_CHECK_OK(properties.UpdateStatically({"relu_0_16"}));
+  }
+}
+BENCHMARK(BM_UpdateStatically)->Arg(64)->Arg(1024)->Arg(4096);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
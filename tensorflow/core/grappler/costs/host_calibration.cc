@@ -0,0 +1,243 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/host_calibration.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "Eigen/Core"  // from @eigen_archive
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/lib/core/blocking_counter.h"
+#include "tensorflow/core/lib/core/notification.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/util/env_var.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+// Smallest working set of the main memory benchmark.
+constexpr int64_t kMinMainMemoryWorkingSetBytes = 256 << 20;
+
+// Returns the average running time of `fn` in seconds, over as many calls as
+// fit in `min_time` after a warm up call.
+template <typename Fn>
+double SecondsPerCall(absl::Duration min_time, Fn fn) {
+  fn();
+  int64_t calls = 0;
+  const absl::Time start = absl::Now();
+  absl::Duration elapsed;
+  do {
+    fn();
+    ++calls;
+    elapsed = absl::Now() - start;
+  } while (elapsed < min_time);
+  return absl::ToDoubleSeconds(elapsed) / calls;
+}
+
+double MeasureMatMulGflops(const Eigen::ThreadPoolDevice& device,
+                           absl::Duration min_time) {
+  constexpr int kSize = 1024;
+  Eigen::Tensor<float, 2, Eigen::RowMajor> lhs(kSize, kSize);
+  Eigen::Tensor<float, 2, Eigen::RowMajor> rhs(kSize, kSize);
+  Eigen::Tensor<float, 2, Eigen::RowMajor> out(kSize, kSize);
+  lhs.setRandom();
+  rhs.setRandom();
+  const Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> dims = {
+      Eigen::IndexPair<Eigen::Index>(1, 0)};
+  const double seconds = SecondsPerCall(
+      min_time, [&]() { out.device(device) = lhs.contract(rhs, dims); });
+  return 2.0 * kSize * kSize * kSize / seconds / 1e9;
+}
+
+// Measures a 3x3 convolution of 64 into 64 channels over 56x56 images, as in
+// the first blocks of a ResNet. Like the Eigen spatial convolution of the CPU
+// kernels, it contracts the image patches with the filter.
+double MeasureConvGflops(const Eigen::ThreadPoolDevice& device,
+                         absl::Duration min_time) {
+  constexpr int kBatch = 8;
+  constexpr int kSize = 56;
+  constexpr int kChannels = 64;
+  constexpr int kFilterSize = 3;
+  constexpr int kPatchSize = kFilterSize * kFilterSize * kChannels;
+  Eigen::Tensor<float, 4, Eigen::RowMajor> input(kBatch, kSize, kSize,
+                                                 kChannels);
+  Eigen::Tensor<float, 2, Eigen::RowMajor> filter(kPatchSize, kChannels);
+  Eigen::Tensor<float, 2, Eigen::RowMajor> out(kBatch * kSize * kSize,
+                                               kChannels);
+  input.setRandom();
+  filter.setRandom();
+  const Eigen::array<Eigen::Index, 2> patches_shape = {kBatch * kSize * kSize,
+                                                       kPatchSize};
+  const Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> dims = {
+      Eigen::IndexPair<Eigen::Index>(1, 0)};
+  const double seconds = SecondsPerCall(min_time, [&]() {
+    out.device(device) = input.extract_image_patches(kFilterSize, kFilterSize)
+                             .reshape(patches_shape)
+                             .contract(filter, dims);
+  });
+  return 2.0 * kBatch * kSize * kSize * kPatchSize * kChannels / seconds / 1e9;
+}
+
+// Measures the read bandwidth of `num_threads` threads of `pool`, each summing
+// its own buffer of `bytes_per_thread` bytes.
+double MeasureReadGbPerSec(thread::ThreadPool* pool, int num_threads,
+                           int64_t bytes_per_thread, absl::Duration min_time) {
+  const int64_t size = std::max<int64_t>(bytes_per_thread / sizeof(float), 1);
+  std::vector<std::vector<float>> buffers(num_threads,
+                                          std::vector<float>(size, 1.0f));
+  // Reads small buffers several times per task, to amortize the dispatch.
+  const int64_t repeats =
+      std::max<int64_t>(1, (16 << 20) / (size * sizeof(float)));
+  std::vector<float> sums(num_threads);
+  const double seconds = SecondsPerCall(min_time, [&]() {
+    BlockingCounter counter(num_threads);
+    for (int i = 0; i < num_threads; ++i) {
+      pool->Schedule([&, i]() {
+        const Eigen::Map<const Eigen::ArrayXf> buffer(buffers[i].data(), size);
+        // Accumulates locally, as adjacent sums share a cache line.
+        float sum = 0;
+        for (int64_t r = 0; r < repeats; ++r) {
+          sum += buffer.sum();
+          // Keeps the compiler from hoisting the read out of the loop.
+          std::atomic_signal_fence(std::memory_order_seq_cst);
+        }
+        sums[i] = sum;
+        counter.DecrementCount();
+      });
+    }
+    counter.Wait();
+  });
+  VLOG(2) << "Read checksum: " << sums[0];
+  return static_cast<double>(num_threads) * size * sizeof(float) * repeats /
+         seconds / 1e9;
+}
+
+double MeasureDispatchOverheadNs(thread::ThreadPool* pool,
+                                 absl::Duration min_time) {
+  return 1e9 * SecondsPerCall(min_time, [pool]() {
+           Notification done;
+           pool->Schedule([&done]() { done.Notify(); });
+           done.WaitForNotification();
+         });
+}
+
+}  // namespace
+
+HostCalibration CalibrateHost(const HostCalibrationOptions& options) {
+  const DeviceProperties cpu = GetLocalCPUInfo();
+  const int num_threads = options.num_threads > 0
+                              ? options.num_threads
+                              : port::NumSchedulableCPUs();
+  thread::ThreadPool pool(Env::Default(), "host_calibration", num_threads);
+  Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), num_threads);
+
+  HostCalibration calibration;
+  calibration.set_vendor(cpu.vendor());
+  calibration.set_model(cpu.model());
+  calibration.set_num_cores(cpu.num_cores());
+  calibration.set_matmul_gflops(MeasureMatMulGflops(device, options.min_time));
+  calibration.set_conv_gflops(MeasureConvGflops(device, options.min_time));
+
+  // The first two cache levels are private to each core and the last one is
+  // shared; each working set fills half of a level.
+  std::vector<int64_t> bytes_per_thread;
+  if (cpu.l1_cache_size() > 0) {
+    bytes_per_thread.push_back(cpu.l1_cache_size() / 2);
+  }
+  if (cpu.l2_cache_size() > 0) {
+    bytes_per_thread.push_back(cpu.l2_cache_size() / 2);
+  }
+  if (cpu.l3_cache_size() > 0) {
+    bytes_per_thread.push_back(cpu.l3_cache_size() / 2 / num_threads);
+  }
+  bytes_per_thread.push_back(
+      std::max(kMinMainMemoryWorkingSetBytes, 4 * cpu.l3_cache_size()) /
+      num_threads);
+  for (int64_t bytes : bytes_per_thread) {
+    auto* bandwidth = calibration.add_memory_bandwidth();
+    bandwidth->set_working_set_bytes(bytes * num_threads);
+    bandwidth->set_gb_per_sec(
+        MeasureReadGbPerSec(&pool, num_threads, bytes, options.min_time));
+  }
+
+  calibration.set_dispatch_overhead_ns(
+      MeasureDispatchOverheadNs(&pool, options.min_time));
+  VLOG(1) << "Host calibration: " << calibration.ShortDebugString();
+  return calibration;
+}
+
+absl::Status SaveHostCalibration(Env* env, const std::string& path,
+                                 const HostCalibration& calibration) {
+  return WriteTextProto(env, path, calibration);
+}
+
+absl::Status LoadHostCalibration(Env* env, const std::string& path,
+                                 HostCalibration* calibration) {
+  return ReadTextOrBinaryProto(env, path, calibration);
+}
+
+bool HostCalibrationMatches(const HostCalibration& calibration,
+                            const DeviceProperties& device) {
+  return device.type() == "CPU" && device.vendor() == calibration.vendor() &&
+         device.model() == calibration.model() &&
+         device.num_cores() == calibration.num_cores();
+}
+
+double HostCalibrationGbPerSec(const HostCalibration& calibration,
+                               double working_set_bytes) {
+  for (const auto& bandwidth : calibration.memory_bandwidth()) {
+    if (working_set_bytes <= bandwidth.working_set_bytes()) {
+      return bandwidth.gb_per_sec();
+    }
+  }
+  return calibration.memory_bandwidth().empty()
+             ? -1
+             : calibration.memory_bandwidth().rbegin()->gb_per_sec();
+}
+
+const HostCalibration* GetHostCalibration() {
+  static const HostCalibration* const calibration =
+      []() -> const HostCalibration* {
+    std::string path;
+    absl::Status status =
+        ReadStringFromEnvVar(kHostCalibrationFileEnvVar, "", &path);
+    if (!status.ok() || path.empty()) return nullptr;
+    auto* calibration = new HostCalibration;
+    status = LoadHostCalibration(Env::Default(), path, calibration);
+    if (!status.ok()) {
+      LOG(WARNING) << "Ignoring the host calibration in " << path << ": "
+                   << status;
+      delete calibration;
+      return nullptr;
+    }
+    return calibration;
+  }();
+  return calibration;
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
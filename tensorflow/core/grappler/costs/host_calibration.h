@@ -0,0 +1,72 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_COSTS_HOST_CALIBRATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_COSTS_HOST_CALIBRATION_H_
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+#include "tensorflow/core/grappler/costs/host_calibration.pb.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Environment variable naming the file of the HostCalibration used by the
+// OpLevelCostEstimator.
+inline constexpr char kHostCalibrationFileEnvVar[] =
+    "TF_GRAPPLER_HOST_CALIBRATION_FILE";
+
+struct HostCalibrationOptions {
+  // Number of threads of the benchmarks; 0 uses all the schedulable CPUs.
+  int num_threads = 0;
+  // Minimum running time of each benchmark.
+  absl::Duration min_time = absl::Milliseconds(200);
+};
+
+// Measures the throughput of the host CPU with microbenchmarks. This takes a
+// few seconds, so the result is meant to be saved once per host.
+HostCalibration CalibrateHost(const HostCalibrationOptions& options);
+
+// Saves `calibration` to `path` as a text proto.
+absl::Status SaveHostCalibration(Env* env, const std::string& path,
+                                 const HostCalibration& calibration);
+
+// Loads a HostCalibration from a text or binary proto.
+absl::Status LoadHostCalibration(Env* env, const std::string& path,
+                                 HostCalibration* calibration);
+
+// Returns true if `calibration` was measured on a CPU like `device`.
+bool HostCalibrationMatches(const HostCalibration& calibration,
+                            const DeviceProperties& device);
+
+// Returns the read bandwidth of the smallest calibrated working set holding
+// `working_set_bytes`, or of the main memory if none does. Returns a negative
+// value if `calibration` has no bandwidth measurements.
+double HostCalibrationGbPerSec(const HostCalibration& calibration,
+                               double working_set_bytes);
+
+// Returns the HostCalibration loaded from the file named by the
+// `kHostCalibrationFileEnvVar` environment variable on the first call, or
+// nullptr if the variable is not set or the file cannot be loaded.
+const HostCalibration* GetHostCalibration();
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_COSTS_HOST_CALIBRATION_H_
@@ -0,0 +1,218 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/costs/host_calibration.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/grappler/clusters/utils.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/lib/core/threadpool.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/path.h"
+#include "tensorflow/core/platform/cpu_info.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/protobuf/device_properties.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+HostCalibration TestCalibration() {
+  HostCalibration calibration;
+  calibration.set_vendor("GenuineIntel");
+  calibration.set_model("85");
+  calibration.set_num_cores(16);
+  calibration.set_matmul_gflops(500);
+  calibration.set_conv_gflops(300);
+  auto* l1 = calibration.add_memory_bandwidth();
+  l1->set_working_set_bytes(256 << 10);
+  l1->set_gb_per_sec(1000);
+  auto* l2 = calibration.add_memory_bandwidth();
+  l2->set_working_set_bytes(8 << 20);
+  l2->set_gb_per_sec(400);
+  auto* dram = calibration.add_memory_bandwidth();
+  dram->set_working_set_bytes(256 << 20);
+  dram->set_gb_per_sec(50);
+  calibration.set_dispatch_overhead_ns(2000);
+  return calibration;
+}
+
+void DescribeMatrix(int rows, int columns,
+                    OpInfo::TensorProperties* tensor) {
+  tensor->set_dtype(DT_FLOAT);
+  tensor->mutable_shape()->add_dim()->set_size(rows);
+  tensor->mutable_shape()->add_dim()->set_size(columns);
+}
+
+// Returns the average running time of `fn` in nanoseconds.
+template <typename Fn>
+double MeasureNs(Fn fn) {
+  fn();
+  int64_t calls = 0;
+  const absl::Time start = absl::Now();
+  absl::Duration elapsed;
+  do {
+    fn();
+    ++calls;
+    elapsed = absl::Now() - start;
+  } while (elapsed < absl::Milliseconds(200));
+  return absl::ToDoubleNanoseconds(elapsed) / calls;
+}
+
+TEST(HostCalibrationTest, SaveAndLoad) {
+  const HostCalibration calibration = TestCalibration();
+  const std::string path =
+      io::JoinPath(testing::TmpDir(), "host_calibration.pbtxt");
+  TF_ASSERT_OK(SaveHostCalibration(Env::Default(), path, calibration));
+  HostCalibration loaded;
+  TF_ASSERT_OK(LoadHostCalibration(Env::Default(), path, &loaded));
+  EXPECT_EQ(loaded.DebugString(), calibration.DebugString());
+}
+
+TEST(HostCalibrationTest, Matches) {
+  const HostCalibration calibration = TestCalibration();
+  DeviceProperties device;
+  device.set_type("CPU");
+  device.set_vendor("GenuineIntel");
+  device.set_model("85");
+  device.set_num_cores(16);
+  EXPECT_TRUE(HostCalibrationMatches(calibration, device));
+
+  device.set_num_cores(8);
+  EXPECT_FALSE(HostCalibrationMatches(calibration, device));
+  device.set_num_cores(16);
+  device.set_model("106");
+  EXPECT_FALSE(HostCalibrationMatches(calibration, device));
+  device.set_model("85");
+  device.set_type("GPU");
+  EXPECT_FALSE(HostCalibrationMatches(calibration, device));
+}
+
+TEST(HostCalibrationTest, GbPerSecOfWorkingSet) {
+  const HostCalibration calibration = TestCalibration();
+  EXPECT_EQ(HostCalibrationGbPerSec(calibration, 1024), 1000);
+  EXPECT_EQ(HostCalibrationGbPerSec(calibration, 256 << 10), 1000);
+  EXPECT_EQ(HostCalibrationGbPerSec(calibration, 1 << 20), 400);
+  EXPECT_EQ(HostCalibrationGbPerSec(calibration, 64 << 20), 50);
+  EXPECT_EQ(HostCalibrationGbPerSec(calibration, 1e12), 50);
+  EXPECT_LT(HostCalibrationGbPerSec(HostCalibration(), 1024), 0);
+}
+
+TEST(HostCalibrationTest, CalibrateHost) {
+  HostCalibrationOptions options;
+  options.num_threads = 2;
+  options.min_time = absl::Milliseconds(1);
+  const HostCalibration calibration = CalibrateHost(options);
+  EXPECT_TRUE(HostCalibrationMatches(calibration, GetLocalCPUInfo()));
+  EXPECT_GT(calibration.matmul_gflops(), 0);
+  EXPECT_GT(calibration.conv_gflops(), 0);
+  ASSERT_GT(calibration.memory_bandwidth_size(), 0);
+  for (int i = 0; i < calibration.memory_bandwidth_size(); ++i) {
+    EXPECT_GT(calibration.memory_bandwidth(i).gb_per_sec(), 0);
+    if (i > 0) {
+      EXPECT_GT(calibration.memory_bandwidth(i).working_set_bytes(),
+                calibration.memory_bandwidth(i - 1).working_set_bytes());
+    }
+  }
+  EXPECT_GT(calibration.dispatch_overhead_ns(), 0);
+}
+
+// Compares the predictions of the calibrated OpLevelCostEstimator with the
+// measured running times of a compute bound matmul, of another shape than the
+// calibration one, and of a memory bound add. The tolerance allows for the
+// noise of shared test machines; it does not cover convolutions nor the
+// cache resident working sets, which are only checked by the cost_analyzer.
+TEST(HostCalibrationTest, PredictionsMatchMeasurements) {
+  HostCalibrationOptions options;
+  options.min_time = absl::Milliseconds(50);
+  const HostCalibration calibration = CalibrateHost(options);
+  const std::string path =
+      io::JoinPath(testing::TmpDir(), "measured_host_calibration.pbtxt");
+  TF_ASSERT_OK(SaveHostCalibration(Env::Default(), path, calibration));
+  // GetHostCalibration() reads the variable once, and no other test uses it.
+  ASSERT_EQ(setenv(kHostCalibrationFileEnvVar, path.c_str(), 1), 0);
+  ASSERT_NE(GetHostCalibration(), nullptr);
+
+  const int num_threads = port::NumSchedulableCPUs();
+  thread::ThreadPool pool(Env::Default(), "measure", num_threads);
+  Eigen::ThreadPoolDevice device(pool.AsEigenThreadPool(), num_threads);
+  OpLevelCostEstimator estimator;
+  constexpr double kTolerance = 4;
+
+  {
+    constexpr int kM = 512;
+    constexpr int kK = 2048;
+    constexpr int kN = 384;
+    OpContext op_context;
+    op_context.op_info.set_op("MatMul");
+    *op_context.op_info.mutable_device() = GetLocalCPUInfo();
+    DescribeMatrix(kM, kK, op_context.op_info.add_inputs());
+    DescribeMatrix(kK, kN, op_context.op_info.add_inputs());
+    DescribeMatrix(kM, kN, op_context.op_info.add_outputs());
+    const double predicted_ns =
+        estimator.PredictCosts(op_context).execution_time.count();
+
+    Eigen::Tensor<float, 2, Eigen::RowMajor> lhs(kM, kK);
+    Eigen::Tensor<float, 2, Eigen::RowMajor> rhs(kK, kN);
+    Eigen::Tensor<float, 2, Eigen::RowMajor> out(kM, kN);
+    lhs.setRandom();
+    rhs.setRandom();
+    const Eigen::array<Eigen::IndexPair<Eigen::Index>, 1> dims = {
+        Eigen::IndexPair<Eigen::Index>(1, 0)};
+    const double measured_ns =
+        MeasureNs([&]() { out.device(device) = lhs.contract(rhs, dims); });
+    LOG(INFO) << "MatMul predicted " << predicted_ns << " ns, measured "
+              << measured_ns << " ns";
+    EXPECT_LT(predicted_ns, kTolerance * measured_ns);
+    EXPECT_GT(predicted_ns, measured_ns / kTolerance);
+  }
+
+  {
+    constexpr int kRows = 4096;
+    constexpr int kColumns = 4096;
+    OpContext op_context;
+    op_context.op_info.set_op("Add");
+    *op_context.op_info.mutable_device() = GetLocalCPUInfo();
+    DescribeMatrix(kRows, kColumns, op_context.op_info.add_inputs());
+    DescribeMatrix(kRows, kColumns, op_context.op_info.add_inputs());
+    DescribeMatrix(kRows, kColumns, op_context.op_info.add_outputs());
+    const double predicted_ns =
+        estimator.PredictCosts(op_context).execution_time.count();
+
+    Eigen::Tensor<float, 2, Eigen::RowMajor> lhs(kRows, kColumns);
+    Eigen::Tensor<float, 2, Eigen::RowMajor> rhs(kRows, kColumns);
+    Eigen::Tensor<float, 2, Eigen::RowMajor> out(kRows, kColumns);
+    lhs.setRandom();
+    rhs.setRandom();
+    const double measured_ns =
+        MeasureNs([&]() { out.device(device) = lhs + rhs; });
+    LOG(INFO) << "Add predicted " << predicted_ns << " ns, measured "
+              << measured_ns << " ns";
+    EXPECT_LT(predicted_ns, kTolerance * measured_ns);
+    EXPECT_GT(predicted_ns, measured_ns / kTolerance);
+  }
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -42,6 +42,7 @@ limitations under the License.
 #include "tensorflow/core/framework/types.h"
 #include "tensorflow/core/framework/types.pb.h"
 #include "tensorflow/core/grappler/costs/cost_estimator.h"
+#include "tensorflow/core/grappler/costs/host_calibration.h"
 #include "tensorflow/core/grappler/costs/op_context.h"
 #include "tensorflow/core/grappler/costs/op_performance_data.pb.h"
 #include "tensorflow/core/grappler/costs/utils.h"
@@ -175,6 +176,14 @@ Padding GetPadding(const OpInfo& op_info) {
   return Padding::SAME;  // Default padding.
 }
 
+bool IsConvOp(const std::string& op) {
+  return op == kConv2d || op == kConv2dBackpropFilter ||
+         op == kConv2dBackpropInput || op == kFusedConv2dBiasActivation ||
+         op == kDepthwiseConv2dNative ||
+         op == kDepthwiseConv2dNativeBackpropFilter ||
+         op == kDepthwiseConv2dNativeBackpropInput;
+}
+
 bool IsTraining(const OpInfo& op_info) {
   if (op_info.attr().find("is_training") != op_info.attr().end() &&
       op_info.attr().at("is_training").b()) {
@@ -734,7 +743,14 @@ DeviceInfo OpLevelCostEstimator::GetDeviceInfo(
   double gflops = -1;
   double gb_per_sec = -1;
 
-  if (device.type() == "CPU") {
+  const HostCalibration* calibration = GetHostCalibration();
+  if (calibration != nullptr && HostCalibrationMatches(*calibration, device) &&
+      calibration->matmul_gflops() > 0 &&
+      !calibration->memory_bandwidth().empty()) {
+    // Use the measured throughput of the host rather than its peak.
+    gflops = calibration->matmul_gflops();
+    gb_per_sec = calibration->memory_bandwidth().rbegin()->gb_per_sec();
+  } else if (device.type() == "CPU") {
     // Check if vector instructions are available, and refine performance
     // prediction based on this.
     // Frequencies are stored in MHz in the DeviceProperties.
@@ -859,12 +875,30 @@ Costs OpLevelCostEstimator::PredictOpCountBasedCost(
             << " device model:" << op_info.device().model();
   }
 
-  Costs::NanoSeconds compute_cost(std::ceil(operations / device_info.gigaops));
+  double gigaops = device_info.gigaops;
+  double gb_per_sec = device_info.gb_per_sec;
+  double dispatch_overhead_ns = 0;
+  const HostCalibration* calibration = GetHostCalibration();
+  if (calibration != nullptr &&
+      HostCalibrationMatches(*calibration, op_info.device())) {
+    // Convolutions run at a lower throughput than matmuls, working sets that
+    // fit in a cache are read at its bandwidth, and every op pays for its
+    // dispatch.
+    if (IsConvOp(op_info.op()) && calibration->conv_gflops() > 0) {
+      gigaops = calibration->conv_gflops();
+    }
+    const double cache_gb_per_sec =
+        HostCalibrationGbPerSec(*calibration, total_io_bytes);
+    if (cache_gb_per_sec > 0) gb_per_sec = cache_gb_per_sec;
+    dispatch_overhead_ns = calibration->dispatch_overhead_ns();
+  }
+
+  Costs::NanoSeconds compute_cost(
+      std::ceil(operations / gigaops + dispatch_overhead_ns));
   VLOG(1) << "Op:" << op_info.op() << " GOps:" << operations / 1e9
           << " Compute Time (ns):" << compute_cost.count();
 
-  Costs::NanoSeconds memory_cost(
-      std::ceil(total_io_bytes / device_info.gb_per_sec));
+  Costs::NanoSeconds memory_cost(std::ceil(total_io_bytes / gb_per_sec));
   VLOG(1) << "Op:" << op_info.op() << " Size (KB):" << (total_io_bytes) / 1e3
           << " Memory Time (ns):" << memory_cost.count();
 
@@ -17,9 +17,13 @@ limitations under the License.
 
 #include "tensorflow/core/grappler/optimizers/constant_folding.h"
 
+#include <algorithm>
 #include <cmath>
+#include <memory>
+#include <optional>
 
 #include "absl/status/status.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/strings/substitute.h"
@@ -45,13 +49,17 @@ limitations under the License.
 #include "tensorflow/core/grappler/utils/symbolic_shapes.h"
 #include "tensorflow/core/lib/core/errors.h"
 #include "tensorflow/core/lib/core/stringpiece.h"
+#include "tensorflow/core/lib/core/threadpool.h"
 #include "tensorflow/core/lib/gtl/cleanup.h"
 #include "tensorflow/core/lib/gtl/inlined_vector.h"
 #include "tensorflow/core/lib/strings/numbers.h"
+#include "tensorflow/core/lib/strings/proto_serialization.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/cpu_info.h"
 #include "tensorflow/core/platform/denormal.h"
 #include "tensorflow/core/platform/env.h"
+#include "tensorflow/core/platform/fingerprint.h"
+#include "tensorflow/core/platform/mutex.h"
 #include "tensorflow/core/platform/setround.h"
 #include "tensorflow/core/platform/tensor_coding.h"
 #include "tensorflow/core/public/version.h"
@@ -66,6 +74,10 @@ using TensorVector = absl::InlinedVector<TensorValue, 4UL>;
 // We only fold/materialize constants smaller than 100kB.
 const int64_t kMaxConstantSize = 100 * 1024;
 
+// Foldable nodes reading fewer input elements in total are evaluated on the
+// optimizer thread, as the dispatch would cost more than it saves.
+constexpr int64_t kMinInputElementsToFoldInParallel = 1 << 16;
+
 namespace {
 template <typename T>
 bool AllValuesAre(const TensorProto& proto, const T& value) {
@@ -188,6 +200,97 @@ float QuantizedTypeMaxAsFloat(DataType data_type) {
   }
 }
 
+// Constants folded so far, keyed by the op, attributes and input values of
+// the folded node. It outlives the optimizer, so the constant subgraphs
+// shared by the functions of a model, or folded again in every meta optimizer
+// iteration and at every load of the model, are evaluated once per process.
+class FoldedConstantCache {
+ public:
+  static FoldedConstantCache* Global() {
+    static FoldedConstantCache* const cache = new FoldedConstantCache;
+    return cache;
+  }
+
+  // Looks up the unnamed constant nodes of the outputs of a folded node.
+  bool Lookup(const Fprint128& key, std::vector<NodeDef>* outputs) {
+    mutex_lock l(mu_);
+    auto it = outputs_.find(key);
+    if (it == outputs_.end()) return false;
+    *outputs = it->second;
+    return true;
+  }
+
+  void Insert(const Fprint128& key, const std::vector<NodeDef>& outputs) {
+    int64_t bytes = 0;
+    for (const NodeDef& output : outputs) bytes += output.ByteSizeLong();
+    if (bytes > kMaxEntryBytes) return;
+    mutex_lock l(mu_);
+    // Folded tensors range from scalars to kMaxEntryBytes, so the cache is
+    // bounded by the bytes it holds rather than by its number of entries. Like
+    // the function shapes of GraphProperties, it starts over when full instead
+    // of tracking recency; the next pass folds its constants again.
+    if (bytes_ + bytes > kMaxBytes) {
+      outputs_.clear();
+      bytes_ = 0;
+    }
+    if (outputs_.emplace(key, outputs).second) bytes_ += bytes;
+  }
+
+ private:
+  static constexpr int64_t kMaxBytes = 64 << 20;
+  static constexpr int64_t kMaxEntryBytes = 1 << 20;
+
+  mutex mu_;
+  absl::flat_hash_map<Fprint128, std::vector<NodeDef>, Fprint128Hasher> outputs_
+      TF_GUARDED_BY(mu_);
+  int64_t bytes_ TF_GUARDED_BY(mu_) = 0;
+};
+
+// Returns the key of `node` in the FoldedConstantCache, given the values of
+// its inputs. A hit returns the constants of another node, so the key is a
+// 128-bit fingerprint rather than a hash, to make collisions negligible.
+Fprint128 FoldedConstantKey(const NodeDef& node,
+                            absl::Span<const TensorProto* const> input_values) {
+  NodeDef op_and_attrs;
+  op_and_attrs.set_op(node.op());
+  for (const auto& attr : node.attr()) {
+    // Internal attributes, such as _class or _output_shapes, do not change the
+    // value of the node, except for the label selecting its kernel.
+    if (absl::StartsWith(attr.first, "_") && attr.first != "_kernel") continue;
+    (*op_and_attrs.mutable_attr())[attr.first] = attr.second;
+  }
+  std::string serialized;
+  SerializeToStringDeterministic(op_and_attrs, &serialized);
+  Fprint128 key = Fingerprint128(serialized);
+  for (const TensorProto* value : input_values) {
+    SerializeToStringDeterministic(*value, &serialized);
+    key = tsl::FingerprintCat128(key, Fingerprint128(serialized));
+  }
+  return key;
+}
+
+// Returns the number of elements of the constant `node`, or 0 if it is not a
+// constant.
+int64_t NumConstantElements(const NodeDef& node) {
+  auto it = node.attr().find("value");
+  if (it == node.attr().end() || !it->second.has_tensor()) return 0;
+  int64_t num_elements = 1;
+  for (const auto& dim : it->second.tensor().tensor_shape().dim()) {
+    num_elements =
+        MultiplyWithoutOverflow(num_elements, std::max<int64_t>(dim.size(), 0));
+    if (num_elements < 0) return kMinInputElementsToFoldInParallel;
+  }
+  return num_elements;
+}
+
+// Returns the threads evaluating the independent foldable nodes, created on
+// first use and shared by all the optimizers of the process.
+thread::ThreadPool* FoldThreadPool() {
+  static thread::ThreadPool* const pool = new thread::ThreadPool(
+      Env::Default(), "constant_folding", port::MaxParallelism());
+  return pool;
+}
+
 }  // namespace
 
 ConstantFolding::ConstantFolding(RewriterConfig::Toggle opt_level,
@@ -1344,20 +1447,7 @@ Status ConstantFolding::EvaluateNode(const NodeDef& node,
 Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
                                             std::vector<NodeDef>* outputs,
                                             bool* result_too_large) {
-  TensorVector inputs;
-  TensorVector output_tensors;
-  auto inputs_cleanup = gtl::MakeCleanup([&inputs, &output_tensors] {
-    for (const auto& input : inputs) {
-      delete input.tensor;
-    }
-    for (const auto& output : output_tensors) {
-      if (output.tensor) {
-        delete output.tensor;
-      }
-    }
-  });
-
-  size_t total_inputs_size = 0;
+  std::vector<const TensorProto*> input_values;
   for (const auto& input : node.input()) {
     const TensorId input_tensor = ParseTensorName(input);
     if (input_tensor.index() < 0) {
@@ -1384,41 +1474,70 @@ Status ConstantFolding::EvaluateOneFoldable(const NodeDef& node,
           "Not allowed to construct a tensor with reference dtype, got ",
           DataTypeString(raw_val.dtype())));
     }
-    Tensor* value = new Tensor(raw_val.dtype(), raw_val.tensor_shape());
-    if (!value->FromProto(raw_val)) {
-      delete (value);
-      return absl::InvalidArgumentError(
-          absl::StrCat("Unable to make Tensor from proto for ", node.name(),
-                       " with shape ", raw_val.tensor_shape().DebugString()));
-    }
-    inputs.emplace_back(value);
-    total_inputs_size += value->TotalBytes();
+    input_values.push_back(&raw_val);
   }
 
-  TF_RETURN_IF_ERROR(EvaluateNode(node, inputs, &output_tensors));
-  if (output_tensors.empty()) {
-    return Status(absl::StatusCode::kInvalidArgument,
-                  "Expected at least one output.");
+  const Fprint128 cache_key = FoldedConstantKey(node, input_values);
+  if (!FoldedConstantCache::Global()->Lookup(cache_key, outputs)) {
+    TensorVector inputs;
+    TensorVector output_tensors;
+    auto inputs_cleanup = gtl::MakeCleanup([&inputs, &output_tensors] {
+      for (const auto& input : inputs) {
+        delete input.tensor;
+      }
+      for (const auto& output : output_tensors) {
+        if (output.tensor) {
+          delete output.tensor;
+        }
+      }
+    });
+
+    size_t total_inputs_size = 0;
+    for (const TensorProto* raw_val : input_values) {
+      Tensor* value = new Tensor(raw_val->dtype(), raw_val->tensor_shape());
+      if (!value->FromProto(*raw_val)) {
+        delete (value);
+        return absl::InvalidArgumentError(absl::StrCat(
+            "Unable to make Tensor from proto for ", node.name(),
+            " with shape ", raw_val->tensor_shape().DebugString()));
+      }
+      inputs.emplace_back(value);
+      total_inputs_size += value->TotalBytes();
+    }
+
+    TF_RETURN_IF_ERROR(EvaluateNode(node, inputs, &output_tensors));
+    if (output_tensors.empty()) {
+      return Status(absl::StatusCode::kInvalidArgument,
+                    "Expected at least one output.");
+    }
+
+    outputs->resize(output_tensors.size());
+    for (size_t i = 0; i < output_tensors.size(); i++) {
+      if (output_tensors[i].tensor) {
+        // The node is named below, since the cached constants are shared.
+        Status s = CreateNodeDef(node.name(), output_tensors[i],
+                                 &outputs->at(i), total_inputs_size);
+        if (!s.ok()) {
+          *result_too_large = true;
+          return s;
+        }
+      } else {
+        // Create an empty NodeDef to identify dead outputs (e.g. the output of
+        // a switch that's not selected by the switch predicate).
+        outputs->at(i) = NodeDef();
+      }
+    }
+    FoldedConstantCache::Global()->Insert(cache_key, *outputs);
   }
 
-  outputs->resize(output_tensors.size());
-  for (size_t i = 0; i < output_tensors.size(); i++) {
+  for (size_t i = 0; i < outputs->size(); i++) {
+    // Dead outputs keep an empty name.
+    if (outputs->at(i).op().empty()) continue;
     string node_name = OptimizedNodeName(node, "-folded");
-    if (output_tensors.size() > 1) {
+    if (outputs->size() > 1) {
       node_name = strings::StrCat(node_name, "-", i);
     }
-    if (output_tensors[i].tensor) {
-      Status s = CreateNodeDef(node_name, output_tensors[i], &outputs->at(i),
-                               total_inputs_size);
-      if (!s.ok()) {
-        *result_too_large = true;
-        return s;
-      }
-    } else {
-      // Create an empty NodeDef to identify dead outputs (e.g. the output of a
-      // switch that's not selected by the switch predicate).
-      outputs->at(i) = NodeDef();
-    }
+    outputs->at(i).set_name(node_name);
   }
   return absl::OkStatus();
 }
@@ -1525,11 +1644,17 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
   std::vector<NodeDef> const_nodes;
   TF_RETURN_IF_ERROR(
       EvaluateOneFoldable(*node, &const_nodes, result_too_large));
+  return FoldNodeToConstants(node, &const_nodes, output_graph);
+}
+
+Status ConstantFolding::FoldNodeToConstants(NodeDef* node,
+                                            std::vector<NodeDef>* const_nodes,
+                                            GraphDef* output_graph) {
   VLOG(2) << "Folded node: " << SummarizeNodeDef(*node);
 
   NodeDef* constant_output = nullptr;
-  for (int i = 0, end = const_nodes.size(); i < end; i++) {
-    NodeDef* const_node = &const_nodes[i];
+  for (int i = 0, end = const_nodes->size(); i < end; i++) {
+    NodeDef* const_node = &(*const_nodes)[i];
     VLOG(3) << "Generated constant node: " << SummarizeNodeDef(*const_node);
     if (const_node->name().empty()) {
       // Dead output: we can't create a constant to encode its value, so we'll
@@ -1567,7 +1692,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
 
     // We rewrite the existing node if it only has a single output, and
     // create new nodes otherwise.
-    if (const_nodes.size() == 1) {
+    if (const_nodes->size() == 1) {
       node->set_op("Const");
       // Note we need to clear the inputs in NodeMap before we clear the inputs
       // in the node, otherwise NodeMap would see empty inputs and effectively
@@ -1600,7 +1725,7 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
     }
   }
 
-  if (const_nodes.size() > 1) {
+  if (const_nodes->size() > 1) {
     // We make a copy because we mutate the nodes.
     auto outputs = node_map_->GetOutputs(node->name());
     for (NodeDef* output : outputs) {
@@ -1616,12 +1741,12 @@ Status ConstantFolding::FoldNode(NodeDef* node, GraphDef* output_graph,
                                      constant_output->name());
               *output->mutable_input(i) = AsControlDependency(*constant_output);
             }
-          } else if (port < static_cast<int>(const_nodes.size()) &&
-                     !const_nodes[port].name().empty()) {
+          } else if (port < static_cast<int>(const_nodes->size()) &&
+                     !(*const_nodes)[port].name().empty()) {
             // Replace alive outputs with the corresponding constant.
             node_map_->UpdateInput(output->name(), NodeName(output->input(i)),
-                                   const_nodes[port].name());
-            *output->mutable_input(i) = const_nodes[port].name();
+                                   (*const_nodes)[port].name());
+            *output->mutable_input(i) = (*const_nodes)[port].name();
           } else {
             // Leave this edge alone.
             VLOG(3) << "Preserving edge from " << node->name() << ":" << port
@@ -1656,29 +1781,93 @@ Status ConstantFolding::FoldGraph(
     }
   }
   while (!queue.empty()) {
-    NodeDef* node = queue.front();
-    queue.pop_front();
-    if (processed_nodes.count(node->name())) {
-      continue;
+    // Every queued node only reads constants, so the queue is evaluated at
+    // once, concurrently, then the nodes are folded in order. Merge nodes are
+    // folded without evaluation.
+    std::vector<NodeDef*> nodes;
+    absl::flat_hash_set<NodeDef*> queued_nodes;
+    for (NodeDef* node : queue) {
+      if (!processed_nodes.count(node->name()) &&
+          queued_nodes.insert(node).second) {
+        nodes.push_back(node);
+      }
     }
-    // We need to record a copy of output nodes before FoldNode() modifies it.
-    // We also need to ensure that the fanout is sorted deterministically.
-    std::vector<NodeDef*> fanout =
-        node_map_->GetOutputsOrderedByNodeName(node->name());
-    bool result_too_large = false;
-    Status s = FoldNode(node, optimized_graph, &result_too_large);
-    processed_nodes.insert(node->name());
-    if (!s.ok()) {
-      VLOG(1) << "Failed to fold node " << node->DebugString()
-              << "\nError message: " << s;
-      if (result_too_large) {
-        nodes_to_not_simplify->emplace(node->name());
+    queue.clear();
+
+    struct Evaluation {
+      Status status;
+      std::vector<NodeDef> const_nodes;
+      bool result_too_large = false;
+    };
+    std::vector<Evaluation> evaluations(nodes.size());
+    auto evaluate = [&](int64_t begin, int64_t end) {
+      // The rounding mode and denormal flushing are per thread.
+      port::ScopedFlushDenormal flush;
+      port::ScopedSetRound round(FE_TONEAREST);
+      for (int64_t i = begin; i < end; ++i) {
+        if (IsMerge(*nodes[i])) continue;
+        Evaluation& evaluation = evaluations[i];
+        evaluation.status = EvaluateOneFoldable(
+            *nodes[i], &evaluation.const_nodes, &evaluation.result_too_large);
+      }
+    };
+    int64_t num_input_elements = 0;
+    if (nodes.size() > 1 && num_fold_threads_ > 1) {
+      for (const NodeDef* node : nodes) {
+        for (const string& input : node->input()) {
+          if (IsControlInput(input)) break;
+          const NodeDef* input_node = node_map_->GetNode(input);
+          if (input_node != nullptr) {
+            num_input_elements += NumConstantElements(*input_node);
+          }
+        }
+        if (num_input_elements >= kMinInputElementsToFoldInParallel) break;
       }
+    }
+    if (num_input_elements >= kMinInputElementsToFoldInParallel) {
+      // Splits the nodes into at most num_fold_threads_ blocks.
+      const int64_t block_size =
+          (nodes.size() + num_fold_threads_ - 1) / num_fold_threads_;
+      FoldThreadPool()->ParallelFor(
+          nodes.size(),
+          thread::ThreadPool::SchedulingParams(
+              thread::ThreadPool::SchedulingStrategy::kFixedBlockSize,
+              std::nullopt, block_size),
+          evaluate);
     } else {
-      for (auto& fanout_node : fanout) {
-        if (IsFoldable(*fanout_node, &properties) &&
-            !nodes_to_not_simplify->count(fanout_node->name())) {
-          queue.push_back(fanout_node);
+      evaluate(0, nodes.size());
+    }
+
+    for (int i = 0, end = nodes.size(); i < end; ++i) {
+      NodeDef* node = nodes[i];
+      Evaluation& evaluation = evaluations[i];
+      // We need to record a copy of output nodes before FoldNode() modifies
+      // it. We also need to ensure that the fanout is sorted
+      // deterministically.
+      std::vector<NodeDef*> fanout =
+          node_map_->GetOutputsOrderedByNodeName(node->name());
+      Status s;
+      if (IsMerge(*node)) {
+        s = FoldMergeNode(node, optimized_graph);
+      } else if (evaluation.status.ok()) {
+        s = FoldNodeToConstants(node, &evaluation.const_nodes,
+                                optimized_graph);
+      } else {
+        s = evaluation.status;
+      }
+      processed_nodes.insert(node->name());
+      if (!s.ok()) {
+        VLOG(1) << "Failed to fold node " << node->DebugString()
+                << "\nError message: " << s;
+        if (evaluation.result_too_large) {
+          nodes_to_not_simplify->emplace(node->name());
+        }
+      } else {
+        for (auto& fanout_node : fanout) {
+          if (IsFoldable(*fanout_node, &properties) &&
+              !nodes_to_not_simplify->count(fanout_node->name())) {
+            queue.push_back(fanout_node);
+          }
         }
       }
     }
@@ -4082,6 +4271,8 @@ Status ConstantFolding::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   has_fetch_ = !item.fetch.empty();
+  num_fold_threads_ =
+      std::max(1, item.optimization_options().intra_op_parallelism_threads);
   GrapplerItem item_to_optimize = item;
   GraphProperties properties(item_to_optimize);
   // It's possible to feed a placeholder with a tensor of any shape: make sure
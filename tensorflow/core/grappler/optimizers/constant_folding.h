@@ -98,6 +98,9 @@ class ConstantFolding : public GraphOptimizer {
   Status FoldMergeNode(NodeDef* node, GraphDef* output_graph);
   Status FoldNode(NodeDef* node, GraphDef* output_graph,
                   bool* result_too_large);
+  // Replaces `node` by the constants evaluated by EvaluateOneFoldable.
+  Status FoldNodeToConstants(NodeDef* node, std::vector<NodeDef>* const_nodes,
+                             GraphDef* output_graph);
 
   bool IsOnes(const NodeDef& node) const;
   bool IsZeros(const NodeDef& node) const;
@@ -341,6 +344,8 @@ class ConstantFolding : public GraphOptimizer {
   bool graph_contains_assign_or_inplace_op_;
   bool disable_compressed_tensor_optimization_;
   bool fold_quantization_emulation_;
+  // Number of threads evaluating the independent foldable nodes.
+  int num_fold_threads_ = 1;
 };
 
 }  // end namespace grappler
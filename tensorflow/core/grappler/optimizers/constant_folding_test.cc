@@ -34,6 +34,7 @@ limitations under the License.
 #include "tensorflow/core/lib/strings/str_util.h"
 #include "tensorflow/core/lib/strings/strcat.h"
 #include "tensorflow/core/platform/tensor_coding.h"
+#include "tensorflow/core/platform/test_benchmark.h"
 
 namespace tensorflow {
 namespace grappler {
@@ -4411,6 +4412,133 @@ TEST_F(ConstantFoldingTest, RedundantVariableUpdateAddZerosToHandle) {
   }
 }
 
+// Returns `num_chains` independent chains of `depth` foldable matmuls, which
+// are fetched as "chain_<i>". `seed` sets the values of the constants.
+GraphDef MakeFoldableChains(int num_chains, int depth, float seed) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  for (int i = 0; i < num_chains; ++i) {
+    Tensor value(DT_FLOAT, TensorShape({64, 64}));
+    value.flat<float>().setConstant(seed + i);
+    Output x = ops::Const(s.WithOpName(strings::StrCat("c_", i)),
+                          Input::Initializer(value));
+    for (int j = 0; j < depth; ++j) {
+      x = ops::MatMul(s.WithOpName(strings::StrCat("matmul_", i, "_", j)), x,
+                      x);
+      x = ops::Tanh(s.WithOpName(strings::StrCat("tanh_", i, "_", j)), x);
+    }
+    ops::Identity(s.WithOpName(strings::StrCat("chain_", i)), x);
+  }
+  GraphDef graph;
+  TF_CHECK_OK(s.ToGraphDef(&graph));
+  return graph;
+}
+
+TEST_F(ConstantFoldingTest, FoldsIndependentNodesConcurrently) {
+  constexpr int kNumChains = 16;
+  GrapplerItem item;
+  item.graph = MakeFoldableChains(kNumChains, /*depth=*/3, /*seed=*/0.125f);
+  for (int i = 0; i < kNumChains; ++i) {
+    item.fetch.push_back(strings::StrCat("chain_", i));
+  }
+
+  GrapplerItem sequential_item = item;
+  sequential_item.optimization_options().intra_op_parallelism_threads = 1;
+  ConstantFolding sequential_optimizer(/*cpu_device=*/nullptr);
+  GraphDef sequential_output;
+  TF_EXPECT_OK(sequential_optimizer.Optimize(
+      /*cluster=*/nullptr, sequential_item, &sequential_output));
+
+  item.optimization_options().intra_op_parallelism_threads = 4;
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+
+  for (const NodeDef& node : output.node()) {
+    if (absl::StartsWith(node.name(), "chain_")) {
+      EXPECT_EQ(node.op(), "Const") << node.name();
+    }
+  }
+  CompareGraphs(sequential_output, output);
+
+  auto expected = EvaluateNodes(item.graph, item.fetch);
+  auto actual = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(expected.size(), actual.size());
+  for (int i = 0; i < expected.size(); ++i) {
+    test::ExpectTensorNear<float>(expected[i], actual[i], 1e-5);
+  }
+}
+
+TEST_F(ConstantFoldingTest, ReusesFoldedConstants) {
+  GrapplerItem item;
+  item.graph = MakeFoldableChains(/*num_chains=*/4, /*depth=*/2,
+                                  /*seed=*/0.25f);
+  item.fetch = {"chain_0", "chain_1", "chain_2", "chain_3"};
+
+  // The second optimizer finds the constants folded by the first.
+  GraphDef outputs[2];
+  for (GraphDef& output : outputs) {
+    ConstantFolding optimizer(/*cpu_device=*/nullptr);
+    TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+  }
+  CompareGraphs(outputs[0], outputs[1]);
+
+  // The cached constants are named after the nodes they replace.
+  GrapplerItem renamed_item;
+  renamed_item.graph = item.graph;
+  for (NodeDef& node : *renamed_item.graph.mutable_node()) {
+    if (node.name() == "chain_0") node.set_name("renamed");
+  }
+  renamed_item.fetch = {"renamed"};
+  ConstantFolding optimizer(/*cpu_device=*/nullptr);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(/*cluster=*/nullptr, renamed_item, &output));
+  auto expected = EvaluateNodes(outputs[0], {"chain_0"});
+  auto actual = EvaluateNodes(output, {"renamed"});
+  ASSERT_EQ(actual.size(), 1);
+  test::ExpectTensorEqual<float>(expected[0], actual[0]);
+}
+
+// Folds graphs never seen before, as when a model is loaded.
+void BM_FoldConstants(::testing::benchmark::State& state) {
+  const int num_chains = state.range(0);
+  GrapplerItem item;
+  for (int i = 0; i < num_chains; ++i) {
+    item.fetch.push_back(strings::StrCat("chain_", i));
+  }
+  item.optimization_options().intra_op_parallelism_threads = state.range(1);
+  float seed = 0;
+  for (auto s : state) {
+    state.PauseTiming();
+    item.graph = MakeFoldableChains(num_chains, /*depth=*/8, seed);
+    seed += num_chains;
+    state.ResumeTiming();
+    ConstantFolding optimizer(/*cpu_device=*/nullptr);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+  }
+}
+BENCHMARK(BM_FoldConstants)
+    ->ArgPair(16, 1)
+    ->ArgPair(16, 8)
+    ->ArgPair(256, 1)
+    ->ArgPair(256, 8);
+
+// Folds the same graph again, as the meta optimizer iterations do.
+void BM_FoldCachedConstants(::testing::benchmark::State& state) {
+  const int num_chains = state.range(0);
+  GrapplerItem item;
+  item.graph = MakeFoldableChains(num_chains, /*depth=*/8, /*seed=*/0.5f);
+  for (int i = 0; i < num_chains; ++i) {
+    item.fetch.push_back(strings::StrCat("chain_", i));
+  }
+  for (auto s : state) {
+    ConstantFolding optimizer(/*cpu_device=*/nullptr);
+    GraphDef output;
+    TF_CHECK_OK(optimizer.Optimize(/*cluster=*/nullptr, item, &output));
+  }
+}
+BENCHMARK(BM_FoldCachedConstants)->Arg(16)->Arg(256);
+
 }  // namespace
 }  // namespace grappler
 }  // namespace tensorflow
@@ -0,0 +1,428 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/log/log.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/op.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_shape.pb.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/mutable_graph_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/lib/gtl/map_util.h"
+#include "tensorflow/core/platform/status.h"
+#include "tensorflow/core/platform/types.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kBatchDataset[] = "BatchDataset";
+constexpr char kBatchDatasetV2[] = "BatchDatasetV2";
+constexpr char kMapDataset[] = "MapDataset";
+constexpr char kParallelMapDatasetV2[] = "ParallelMapDatasetV2";
+constexpr char kMapDefun[] = "MapDefun";
+constexpr char kConst[] = "Const";
+constexpr char kOutputShapes[] = "output_shapes";
+constexpr char kOutputTypes[] = "output_types";
+
+// Ops which compute each element of their output from the elements at the
+// same position of their broadcast inputs. Applied to stacked operands of the
+// same rank, they compute the stack of their per-element results.
+bool IsElementwiseOp(absl::string_view op) {
+  static const auto* const kElementwiseOps =
+      new absl::flat_hash_set<absl::string_view>{
+          "Abs", "Acos", "Acosh", "Add", "AddV2", "Asin", "Asinh", "Atan",
+          "Atan2", "Atanh", "BitwiseAnd", "BitwiseOr", "BitwiseXor", "Cast",
+          "Ceil", "Cos", "Cosh", "Div", "DivNoNan", "Elu", "Equal", "Erf",
+          "Erfc", "Exp", "Expm1", "Floor", "FloorDiv", "FloorMod", "Greater",
+          "GreaterEqual", "Identity", "Invert", "IsFinite", "IsInf", "IsNan",
+          "Less", "LessEqual", "Log", "Log1p", "LogicalAnd", "LogicalNot",
+          "LogicalOr", "Maximum", "Minimum", "Mod", "Mul", "MulNoNan", "Neg",
+          "NotEqual", "Pow", "RealDiv", "Reciprocal", "Relu", "Relu6", "Rint",
+          "Round", "Rsqrt", "SelectV2", "Selu", "Sigmoid", "Sign", "Sin",
+          "Sinh", "Softplus", "Softsign", "Sqrt", "Square", "SquaredDifference",
+          "Sub", "Tan", "Tanh", "TruncateDiv", "TruncateMod", "Xdivy", "Xlogy",
+      };
+  return kElementwiseOps->contains(op);
+}
+
+// Describes a tensor of a map function applied to a batch of elements.
+struct TensorKind {
+  // Whether the tensor stacks the per-element values along a new leading
+  // dimension. Otherwise, it is the same for every element.
+  bool batched = false;
+  // The shape of the tensor for a single element.
+  PartialTensorShape shape;
+};
+
+// Returns the broadcast of shapes `a` and `b`, which must have known ranks, or
+// nullopt if they are not compatible.
+std::optional<PartialTensorShape> BroadcastShapes(const PartialTensorShape& a,
+                                                  const PartialTensorShape& b) {
+  const int rank = std::max(a.dims(), b.dims());
+  std::vector<int64_t> dims(rank);
+  for (int i = 0; i < rank; ++i) {
+    const int a_index = a.dims() - rank + i;
+    const int b_index = b.dims() - rank + i;
+    const int64_t a_dim = a_index >= 0 ? a.dim_size(a_index) : 1;
+    const int64_t b_dim = b_index >= 0 ? b.dim_size(b_index) : 1;
+    if (a_dim == 1 || a_dim == b_dim) {
+      dims[i] = b_dim;
+    } else if (b_dim == 1) {
+      dims[i] = a_dim;
+    } else if (a_dim == -1 || b_dim == -1) {
+      dims[i] = std::max(a_dim, b_dim);
+    } else {
+      return std::nullopt;
+    }
+  }
+  return PartialTensorShape(dims);
+}
+
+// Returns the kind of the output of an element-wise op with `operands`, or
+// nullopt if applying the op to them does not vectorize it. Stacked operands
+// must have the same rank, so that their per-element dimensions line up.
+// Operands shared by all elements must not have a higher rank, so that they
+// are broadcast along the per-element dimensions only.
+std::optional<TensorKind> ElementwiseKind(
+    const std::vector<TensorKind>& operands) {
+  TensorKind result;
+  result.shape = PartialTensorShape({});
+  int batched_rank = -1;
+  for (const TensorKind& operand : operands) {
+    if (operand.shape.unknown_rank()) {
+      return std::nullopt;
+    }
+    if (!operand.batched) {
+      continue;
+    }
+    if (batched_rank >= 0 && operand.shape.dims() != batched_rank) {
+      return std::nullopt;
+    }
+    batched_rank = operand.shape.dims();
+    result.batched = true;
+  }
+  for (const TensorKind& operand : operands) {
+    if (result.batched && !operand.batched &&
+        operand.shape.dims() > batched_rank) {
+      return std::nullopt;
+    }
+    std::optional<PartialTensorShape> shape =
+        BroadcastShapes(result.shape, operand.shape);
+    if (!shape) {
+      return std::nullopt;
+    }
+    result.shape = *std::move(shape);
+  }
+  return result;
+}
+
+// Returns whether applying `function` to batched arguments computes the batch
+// of its per-element results. The first `input_shapes.size()` arguments are
+// batched, with the given per-element shapes. The others are captured inputs.
+bool IsVectorizable(const FunctionDef& function,
+                    const std::vector<PartialTensorShape>& input_shapes) {
+  absl::flat_hash_map<std::string, TensorKind> kinds;
+  const auto& args = function.signature().input_arg();
+  for (int i = 0; i < args.size(); ++i) {
+    TensorKind& kind = kinds[args[i].name()];
+    if (i < input_shapes.size()) {
+      kind.batched = true;
+      kind.shape = input_shapes[i];
+    }
+  }
+
+  // Function nodes are not necessarily sorted, so resolve them in as many
+  // passes as needed.
+  std::vector<const NodeDef*> pending;
+  for (const NodeDef& node : function.node_def()) {
+    pending.push_back(&node);
+  }
+  while (!pending.empty()) {
+    std::vector<const NodeDef*> unresolved;
+    for (const NodeDef* node : pending) {
+      if (node->op() == kConst) {
+        const AttrValue* value = gtl::FindOrNull(node->attr(), "value");
+        if (value == nullptr) {
+          return false;
+        }
+        kinds[node->name()].shape =
+            PartialTensorShape(value->tensor().tensor_shape());
+        continue;
+      }
+      if (!IsElementwiseOp(node->op())) {
+        VLOG(2) << "Op " << node->op() << " has no batched equivalent.";
+        return false;
+      }
+      std::vector<TensorKind> operands;
+      for (const std::string& input : node->input()) {
+        if (IsControlInput(input)) {
+          continue;
+        }
+        const TensorKind* kind = gtl::FindOrNull(
+            kinds, function_utils::FunctionDefTensorDesc(input).node_name);
+        if (kind == nullptr) {
+          break;
+        }
+        operands.push_back(*kind);
+      }
+      if (static_cast<int>(operands.size()) != NumNonControlInputs(*node)) {
+        unresolved.push_back(node);
+        continue;
+      }
+      std::optional<TensorKind> kind = ElementwiseKind(operands);
+      if (!kind) {
+        return false;
+      }
+      kinds[node->name()] = *std::move(kind);
+    }
+    if (unresolved.size() == pending.size()) {
+      return false;
+    }
+    pending = std::move(unresolved);
+  }
+
+  // Outputs which don't depend on the batched arguments would need to be
+  // tiled to the batch size.
+  for (const auto& [output, tensor] : function.ret()) {
+    const TensorKind* kind = gtl::FindOrNull(
+        kinds, function_utils::FunctionDefTensorDesc(tensor).node_name);
+    if (kind == nullptr || !kind->batched) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns a function which applies `function` to each element of its batched
+// arguments with a `MapDefun` op.
+FunctionDef MakeMapDefunFunction(const NodeDef& map_node,
+                                 const DataTypeVector& input_types,
+                                 const DataTypeVector& captured_types,
+                                 const DataTypeVector& output_types,
+                                 const std::vector<PartialTensorShape>&
+                                     output_shapes) {
+  FunctionDef function;
+  std::vector<std::string> inputs;
+  for (int i = 0; i < input_types.size(); ++i) {
+    inputs.push_back(function_utils::AddFunctionInput(
+                         absl::StrCat("args_", i), &function, input_types[i])
+                         ->name());
+  }
+  for (int i = 0; i < captured_types.size(); ++i) {
+    inputs.push_back(
+        function_utils::AddFunctionInput(absl::StrCat("captured_", i),
+                                         &function, captured_types[i])
+            ->name());
+  }
+
+  AttrValue input_types_attr, captured_types_attr, output_types_attr,
+      output_shapes_attr;
+  SetAttrValue(input_types, &input_types_attr);
+  SetAttrValue(captured_types, &captured_types_attr);
+  SetAttrValue(output_types, &output_types_attr);
+  SetAttrValue(output_shapes, &output_shapes_attr);
+  NodeDef* map_defun = function_utils::AddNode(
+      "map_defun", kMapDefun, inputs,
+      {{"Targuments", input_types_attr},
+       {"Tcaptured", captured_types_attr},
+       {"output_types", output_types_attr},
+       {"output_shapes", output_shapes_attr},
+       {"f", map_node.attr().at("f")}},
+      &function);
+  for (int i = 0; i < output_types.size(); ++i) {
+    function_utils::AddFunctionOutputWithUniqueName(
+        "output", absl::StrCat(map_defun->name(), ":output:", i), &function,
+        output_types[i]);
+  }
+  return function;
+}
+
+std::vector<PartialTensorShape> GetShapes(const NodeDef& node) {
+  std::vector<PartialTensorShape> shapes;
+  for (const TensorShapeProto& shape :
+       node.attr().at(kOutputShapes).list().shape()) {
+    shapes.emplace_back(shape);
+  }
+  return shapes;
+}
+
+DataTypeVector GetTypes(const NodeDef& node, const std::string& attr_name) {
+  DataTypeVector types;
+  for (int type : node.attr().at(attr_name).list().type()) {
+    types.push_back(static_cast<DataType>(type));
+  }
+  return types;
+}
+
+}  // namespace
+
+Status MapVectorization::OptimizeAndCollectStats(Cluster* cluster,
+                                                 const GrapplerItem& item,
+                                                 GraphDef* output,
+                                                 OptimizationStats* stats) {
+  *output = item.graph;
+  MutableGraphView graph(output);
+  absl::flat_hash_set<string> nodes_to_delete;
+  FunctionLibraryDefinition function_library(OpRegistry::Global(),
+                                             item.graph.library());
+
+  for (const NodeDef& node : item.graph.node()) {
+    if (node.op() != kBatchDataset && node.op() != kBatchDatasetV2) {
+      continue;
+    }
+    const NodeDef& batch_node = node;
+    NodeDef* map_node = graph_utils::GetInputNode(batch_node, graph);
+    if (map_node == nullptr ||
+        (map_node->op() != kMapDataset &&
+         map_node->op() != kParallelMapDatasetV2) ||
+        graph.GetFanouts(*map_node, /*include_controlled_nodes=*/true).size() !=
+            1) {
+      continue;
+    }
+    const AttrValue* preserve_cardinality =
+        gtl::FindOrNull(map_node->attr(), "preserve_cardinality");
+    const AttrValue* use_unbounded_threadpool =
+        gtl::FindOrNull(map_node->attr(), "use_unbounded_threadpool");
+    if (preserve_cardinality == nullptr || !preserve_cardinality->b() ||
+        (use_unbounded_threadpool != nullptr &&
+         use_unbounded_threadpool->b())) {
+      continue;
+    }
+    const FunctionDef* function =
+        function_library.Find(map_node->attr().at("f").func().name());
+    if (function == nullptr ||
+        function_utils::IsFunctionStateful(function_library, *function)) {
+      continue;
+    }
+
+    // The input elements are now batched instead of the map outputs, so they
+    // must have the same shape.
+    NodeDef* input_node = graph_utils::GetInputNode(*map_node, graph);
+    NodeDef input_attrs;
+    if (input_node == nullptr ||
+        !graph_utils::CopyShapesAndTypesAttrs(*input_node, &input_attrs) ||
+        !gtl::FindOrNull(batch_node.attr(), kOutputShapes) ||
+        !gtl::FindOrNull(map_node->attr(), kOutputShapes)) {
+      continue;
+    }
+    const std::vector<PartialTensorShape> input_shapes =
+        GetShapes(input_attrs);
+    const DataTypeVector input_types = GetTypes(input_attrs, kOutputTypes);
+    const std::vector<PartialTensorShape> batch_shapes = GetShapes(batch_node);
+    if (input_shapes.empty() || input_shapes.size() != input_types.size() ||
+        batch_shapes.empty() || batch_shapes[0].unknown_rank() ||
+        batch_shapes[0].dims() == 0 ||
+        !absl::c_all_of(input_shapes,
+                        [](const PartialTensorShape& shape) {
+                          return shape.IsFullyDefined();
+                        }) ||
+        !absl::c_all_of(input_types, [](DataType type) {
+          return type != DT_VARIANT && type != DT_RESOURCE;
+        })) {
+      continue;
+    }
+
+    FunctionDef vectorized_function;
+    const bool vectorizable = IsVectorizable(*function, input_shapes);
+    if (vectorizable) {
+      vectorized_function = *function;
+      // Per-element argument shapes no longer apply.
+      for (int i = 0; i < input_shapes.size(); ++i) {
+        vectorized_function.mutable_arg_attr()->erase(i);
+      }
+    } else {
+      VLOG(1) << "Map function " << function->signature().name()
+              << " is not element-wise, vectorizing it with MapDefun.";
+      vectorized_function = MakeMapDefunFunction(
+          *map_node, input_types, GetTypes(*map_node, "Targuments"),
+          GetTypes(*map_node, kOutputTypes), GetShapes(*map_node));
+    }
+    graph_utils::SetUniqueGraphFunctionName(
+        absl::StrCat("vectorized_", function->signature().name()),
+        output->mutable_library(), &vectorized_function);
+    *output->mutable_library()->add_function() = vectorized_function;
+    TF_RETURN_IF_ERROR(function_library.AddFunctionDef(vectorized_function));
+
+    // batch(n) over the map inputs.
+    NodeDef new_batch_node = batch_node;
+    graph_utils::SetUniqueGraphNodeName("vectorized/batch", graph.graph(),
+                                        &new_batch_node);
+    new_batch_node.set_input(0, map_node->input(0));
+    AttrValue& batch_types = (*new_batch_node.mutable_attr())[kOutputTypes];
+    batch_types = input_attrs.attr().at(kOutputTypes);
+    std::vector<PartialTensorShape> new_batch_shapes;
+    for (const PartialTensorShape& shape : input_shapes) {
+      new_batch_shapes.push_back(
+          PartialTensorShape({batch_shapes[0].dim_size(0)}).Concatenate(shape));
+    }
+    SetAttrValue(new_batch_shapes,
+                 &(*new_batch_node.mutable_attr())[kOutputShapes]);
+    NodeDef* new_batch = graph.AddNode(std::move(new_batch_node));
+
+    // map(vectorized_f) over the batches.
+    NodeDef new_map_node = *map_node;
+    graph_utils::SetUniqueGraphNodeName("vectorized/map", graph.graph(),
+                                        &new_map_node);
+    new_map_node.set_input(0, new_batch->name());
+    NameAttrList* new_function =
+        (*new_map_node.mutable_attr())["f"].mutable_func();
+    new_function->set_name(vectorized_function.signature().name());
+    if (!vectorizable) {
+      // The `MapDefun` function is not polymorphic, `f` is instantiated by
+      // its `MapDefun` node instead.
+      new_function->clear_attr();
+    }
+    graph_utils::CopyShapesAndTypesAttrs(batch_node, &new_map_node);
+    NodeDef* new_map = graph.AddNode(std::move(new_map_node));
+
+    TF_RETURN_IF_ERROR(graph.UpdateFanouts(batch_node.name(), new_map->name()));
+    nodes_to_delete.insert(map_node->name());
+    nodes_to_delete.insert(batch_node.name());
+    stats->num_changes++;
+  }
+
+  TF_RETURN_IF_ERROR(graph.DeleteNodes(nodes_to_delete));
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(MapVectorization, "map_vectorization");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,214 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/data/map_vectorization.h"
+
+#include <gtest/gtest.h>
+#include "absl/strings/string_view.h"
+#include "tensorflow/core/framework/attr_value_util.h"
+#include "tensorflow/core/framework/function.h"
+#include "tensorflow/core/framework/function_testlib.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/data/function_utils.h"
+#include "tensorflow/core/grappler/optimizers/data/graph_utils.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+using test::function::NDef;
+
+// Creates a dataset source of elements with the given type and shape.
+NodeDef MakeSourceNode(absl::string_view name, DataType dtype,
+                       const PartialTensorShape& shape) {
+  return NDef(name, "RangeDataset", {"start", "stop", "step"},
+              {{"output_shapes", absl::Span<const PartialTensorShape>{shape}},
+               {"output_types", absl::Span<const DataType>{dtype}}});
+}
+
+NodeDef MakeMapNode(absl::string_view name, absl::string_view input,
+                    absl::string_view function_name, DataType dtype,
+                    const PartialTensorShape& shape,
+                    bool preserve_cardinality = true) {
+  return NDef(name, "MapDataset", {string(input)},
+              {{"f", FunctionDefHelper::FunctionRef(string(function_name),
+                                                    {{"T", dtype}})},
+               {"Targuments", {}},
+               {"preserve_cardinality", preserve_cardinality},
+               {"output_shapes", absl::Span<const PartialTensorShape>{shape}},
+               {"output_types", absl::Span<const DataType>{dtype}}});
+}
+
+NodeDef MakeBatchNode(absl::string_view name, absl::string_view input,
+                      DataType dtype, const PartialTensorShape& shape) {
+  return NDef(name, "BatchDatasetV2",
+              {string(input), "batch_size", "drop_remainder"},
+              {{"parallel_copy", false},
+               {"output_shapes", absl::Span<const PartialTensorShape>{shape}},
+               {"output_types", absl::Span<const DataType>{dtype}}});
+}
+
+GrapplerItem MakeItem(const NodeDef& source_node, const NodeDef& map_node,
+                      const NodeDef& batch_node,
+                      const std::vector<FunctionDef>& functions) {
+  GrapplerItem item;
+  item.graph = test::function::GDef(
+      {NDef("start", "Const", {}, {{"value", 0}, {"dtype", DT_INT32}}),
+       NDef("stop", "Const", {}, {{"value", 10}, {"dtype", DT_INT32}}),
+       NDef("step", "Const", {}, {{"value", 1}, {"dtype", DT_INT32}}),
+       NDef("batch_size", "Const", {}, {{"value", 4}, {"dtype", DT_INT64}}),
+       NDef("drop_remainder", "Const", {},
+            {{"value", false}, {"dtype", DT_BOOL}}),
+       source_node, map_node, batch_node,
+       NDef("sink", "Identity", {string(batch_node.name())}, {})},
+      functions);
+  return item;
+}
+
+TEST(MapVectorizationTest, VectorizeElementwiseFunction) {
+  GrapplerItem item = MakeItem(
+      MakeSourceNode("range", DT_INT64, PartialTensorShape({3})),
+      MakeMapNode("map", "range", "XTimesTwo", DT_INT64,
+                  PartialTensorShape({3})),
+      MakeBatchNode("batch", "map", DT_INT64, PartialTensorShape({-1, 3})),
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  const NodeDef& batch_node =
+      output.node(graph_utils::FindGraphNodeWithOp("BatchDatasetV2", output));
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithOp("MapDataset", output));
+  const NodeDef& sink_node =
+      output.node(graph_utils::FindGraphNodeWithName("sink", output));
+  EXPECT_EQ(batch_node.input(0), "range");
+  EXPECT_EQ(map_node.input(0), batch_node.name());
+  EXPECT_EQ(sink_node.input(0), map_node.name());
+
+  AttrValue batch_shapes;
+  SetAttrValue(absl::Span<const PartialTensorShape>{{-1, 3}}, &batch_shapes);
+  EXPECT_TRUE(
+      AreAttrValuesEqual(batch_node.attr().at("output_shapes"), batch_shapes));
+  EXPECT_TRUE(
+      AreAttrValuesEqual(map_node.attr().at("output_shapes"), batch_shapes));
+
+  const FunctionDef* function = nullptr;
+  for (const FunctionDef& fdef : output.library().function()) {
+    if (fdef.signature().name() == map_node.attr().at("f").func().name()) {
+      function = &fdef;
+    }
+  }
+  ASSERT_NE(function, nullptr);
+  EXPECT_NE(function->signature().name(), "XTimesTwo");
+  EXPECT_TRUE(function_utils::ContainsFunctionNodeWithOp("Mul", *function));
+  EXPECT_FALSE(
+      function_utils::ContainsFunctionNodeWithOp("MapDefun", *function));
+}
+
+TEST(MapVectorizationTest, VectorizeWithMapDefun) {
+  // `Softmax` is not element-wise, so it is applied to each element of the
+  // batch with `MapDefun`.
+  const FunctionDef softmax = FunctionDefHelper::Define(
+      "Softmax", {"x: T"}, {"y: T"}, {"T: {float, double}"},
+      {{{"y"}, "Softmax", {"x"}, {{"T", "$T"}}}});
+  GrapplerItem item = MakeItem(
+      MakeSourceNode("range", DT_FLOAT, PartialTensorShape({3})),
+      MakeMapNode("map", "range", "Softmax", DT_FLOAT, PartialTensorShape({3})),
+      MakeBatchNode("batch", "map", DT_FLOAT, PartialTensorShape({-1, 3})),
+      {softmax});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_FALSE(graph_utils::ContainsGraphNodeWithName("batch", output));
+  const NodeDef& map_node =
+      output.node(graph_utils::FindGraphNodeWithOp("MapDataset", output));
+  EXPECT_TRUE(map_node.attr().at("f").func().attr().empty());
+
+  const FunctionDef* vectorized_function = nullptr;
+  for (const FunctionDef& fdef : output.library().function()) {
+    if (fdef.signature().name() == map_node.attr().at("f").func().name()) {
+      vectorized_function = &fdef;
+    }
+  }
+  ASSERT_NE(vectorized_function, nullptr);
+  ASSERT_EQ(vectorized_function->node_def_size(), 1);
+  const NodeDef& map_defun_node = vectorized_function->node_def(0);
+  EXPECT_EQ(map_defun_node.op(), "MapDefun");
+  EXPECT_EQ(map_defun_node.attr().at("f").func().name(), "Softmax");
+  EXPECT_EQ(map_defun_node.attr().at("f").func().attr().at("T").type(),
+            DT_FLOAT);
+}
+
+TEST(MapVectorizationTest, NoChange_StatefulFunction) {
+  GrapplerItem item = MakeItem(
+      MakeSourceNode("range", DT_INT64, PartialTensorShape({})),
+      MakeMapNode("map", "range", "RandomUniformFn", DT_INT64,
+                  PartialTensorShape({})),
+      MakeBatchNode("batch", "map", DT_INT64, PartialTensorShape({-1})),
+      {test::function::RandomUniform()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, NoChange_PartiallyDefinedInputShape) {
+  GrapplerItem item = MakeItem(
+      MakeSourceNode("range", DT_INT64, PartialTensorShape({-1})),
+      MakeMapNode("map", "range", "XTimesTwo", DT_INT64,
+                  PartialTensorShape({-1})),
+      MakeBatchNode("batch", "map", DT_INT64, PartialTensorShape({-1, -1})),
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+TEST(MapVectorizationTest, NoChange_CardinalityNotPreserved) {
+  GrapplerItem item = MakeItem(
+      MakeSourceNode("range", DT_INT64, PartialTensorShape({})),
+      MakeMapNode("map", "range", "XTimesTwo", DT_INT64,
+                  PartialTensorShape({}), /*preserve_cardinality=*/false),
+      MakeBatchNode("batch", "map", DT_INT64, PartialTensorShape({-1})),
+      {test::function::XTimesTwo()});
+
+  MapVectorization optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("map", output));
+  EXPECT_TRUE(graph_utils::ContainsGraphNodeWithName("batch", output));
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,491 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/grappler/utils/symbolic_shapes.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/cpu_info.h"
+
+namespace tensorflow {
+namespace grappler {
+
+namespace {
+
+constexpr char kSuffix[] = "-NCHWc-LayoutOptimizer";
+
+// Returns the name of the node computing `node` in the NCHWc layout.
+string BlockedName(const string& node) {
+  return strings::StrCat(node, kSuffix);
+}
+
+bool GetConstTensor(const NodeDef& node, Tensor* tensor) {
+  if (!IsConstant(node)) return false;
+  const auto it = node.attr().find("value");
+  return it != node.attr().end() && tensor->FromProto(it->second.tensor()) &&
+         tensor->dtype() == DT_FLOAT;
+}
+
+// Reads the row and column values of a [1, rows, cols, 1] attribute.
+bool GetWindowAttr(const NodeDef& node, const string& name,
+                   std::vector<int32>* values) {
+  std::vector<int32> nhwc;
+  if (!TryGetNodeAttr(node, name, &nhwc) || nhwc.size() != 4 ||
+      nhwc[0] != 1 || nhwc[3] != 1) {
+    return false;
+  }
+  *values = {nhwc[1], nhwc[2]};
+  return true;
+}
+
+bool HasWindowPadding(const NodeDef& node) {
+  string padding;
+  return TryGetNodeAttr(node, "padding", &padding) &&
+         (padding == "SAME" || padding == "VALID");
+}
+
+bool IsFloatNHWCOnCpu(const NodeDef& node) {
+  DataType dtype;
+  if (!TryGetNodeAttr(node, "T", &dtype) || dtype != DT_FLOAT) return false;
+  string data_format;
+  if (TryGetNodeAttr(node, "data_format", &data_format) &&
+      data_format != "NHWC") {
+    return false;
+  }
+  return node.device().empty() || NodeIsOnCpu(&node);
+}
+
+// Elementwise ops mapping 0 to a finite value, which keeps the padded
+// channels harmless.
+bool IsBlockedUnaryOp(const NodeDef& node) {
+  return IsRelu(node) || IsRelu6(node) || IsElu(node) || IsTanh(node) ||
+         IsSigmoid(node) || IsIdentity(node);
+}
+
+bool IsBlockedBinaryOp(const NodeDef& node) {
+  return IsAdd(node) || IsSub(node) || IsMul(node) || IsMaximum(node) ||
+         IsMinimum(node);
+}
+
+bool IsPool(const NodeDef& node) {
+  return node.op() == "MaxPool" || node.op() == "AvgPool";
+}
+
+// Returns `filter`, of shape [rows, cols, in, out], with the output channels
+// blocked and the input channels padded: [out / c, rows, cols, in, c].
+Tensor PackFilter(const Tensor& filter, int block_size) {
+  const int64_t rows = filter.dim_size(0);
+  const int64_t cols = filter.dim_size(1);
+  const int64_t in = filter.dim_size(2);
+  const int64_t out = filter.dim_size(3);
+  const int64_t in_padded = (in + block_size - 1) / block_size * block_size;
+  const int64_t out_blocks = (out + block_size - 1) / block_size;
+  Tensor packed(DT_FLOAT, TensorShape({out_blocks, rows, cols, in_padded,
+                                       block_size}));
+  packed.flat<float>().setZero();
+  auto f = filter.tensor<float, 4>();
+  auto p = packed.tensor<float, 5>();
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int64_t s = 0; s < cols; ++s) {
+      for (int64_t i = 0; i < in; ++i) {
+        for (int64_t o = 0; o < out; ++o) {
+          p(o / block_size, r, s, i, o % block_size) = f(r, s, i, o);
+        }
+      }
+    }
+  }
+  return packed;
+}
+
+// Returns `bias` padded to whole blocks, in the given shape.
+Tensor PadBias(const Tensor& bias, int block_size, bool broadcast) {
+  const int64_t blocks = (bias.NumElements() + block_size - 1) / block_size;
+  Tensor padded(DT_FLOAT,
+                broadcast ? TensorShape({blocks, 1, 1, block_size})
+                          : TensorShape({blocks * block_size}));
+  padded.flat<float>().setZero();
+  std::copy_n(bias.flat<float>().data(), bias.NumElements(),
+              padded.flat<float>().data());
+  return padded;
+}
+
+class NCHWcConverter {
+ public:
+  NCHWcConverter(const GrapplerItem& item, int block_size, GraphDef* graph)
+      : item_(item),
+        nodes_to_preserve_(item.NodesToPreserve()),
+        block_size_(block_size),
+        graph_(graph) {}
+
+  Status Convert();
+
+ private:
+  // A convolution with the BiasAdd and activation fused into it.
+  struct FusedConv {
+    const NodeDef* conv = nullptr;
+    const NodeDef* bias_add = nullptr;
+    string activation = "Identity";
+  };
+
+  // Returns the channels of `node` if it can be computed in the NCHWc layout,
+  // or -1.
+  int64_t BlockedChannels(const NodeDef& node) const;
+  // Returns the only node reading `node`, if it reads it once through its
+  // first input, or nullptr.
+  const NodeDef* SoleBlockedFanout(const NodeDef& node) const;
+  // Returns the NCHWc tensor of `input`, converting it if it is not blocked.
+  string BlockedInput(const string& input, const string& device);
+  // Adds a constant holding `value`.
+  string AddConstant(const string& name, const string& device,
+                     const Tensor& value, const NodeDef& source);
+  NodeDef BlockedNode(const NodeDef& node, const FusedConv* fused);
+
+  const GrapplerItem& item_;
+  const std::unordered_set<string> nodes_to_preserve_;
+  const int block_size_;
+  GraphDef* graph_;
+  // The shapes of the nodes, while they are classified.
+  GraphProperties* properties_ = nullptr;
+  absl::flat_hash_map<string, const NodeDef*> nodes_;
+  // The nodes reading each node, once per input.
+  absl::flat_hash_map<string, std::vector<const NodeDef*>> fanouts_;
+  // The channels of the nodes computed in the NCHWc layout.
+  absl::flat_hash_map<string, int64_t> channels_;
+  std::vector<NodeDef> new_nodes_;
+  absl::flat_hash_set<string> new_node_names_;
+  // The constants and conversions to NHWC that may no longer be read.
+  absl::flat_hash_set<string> maybe_unused_nodes_;
+};
+
+int64_t NCHWcConverter::BlockedChannels(const NodeDef& node) const {
+  if (!IsFloatNHWCOnCpu(node) || node.input_size() == 0) return -1;
+  if (IsConv2D(node)) {
+    std::vector<int32> strides;
+    std::vector<int32> dilations;
+    if (!GetWindowAttr(node, "strides", &strides) || !HasWindowPadding(node) ||
+        (TryGetNodeAttr(node, "dilations", &dilations) &&
+         std::any_of(dilations.begin(), dilations.end(),
+                     [](int32 d) { return d != 1; }))) {
+      return -1;
+    }
+    const auto filter = nodes_.find(NodeName(node.input(1)));
+    Tensor filter_value;
+    if (filter == nodes_.end() ||
+        !GetConstTensor(*filter->second, &filter_value) ||
+        filter_value.dims() != 4) {
+      return -1;
+    }
+    return filter_value.dim_size(3);
+  }
+
+  // The other nodes are converted when they read converted nodes.
+  const TensorId input = ParseTensorName(node.input(0));
+  const auto input_channels = channels_.find(input.node());
+  if (input.index() != 0 || input_channels == channels_.end()) return -1;
+  const int64_t channels = input_channels->second;
+  if (IsBiasAdd(node)) {
+    const auto bias = nodes_.find(NodeName(node.input(1)));
+    Tensor bias_value;
+    if (bias == nodes_.end() || !GetConstTensor(*bias->second, &bias_value) ||
+        bias_value.dims() != 1 || bias_value.NumElements() != channels) {
+      return -1;
+    }
+    return channels;
+  }
+  if (IsBlockedUnaryOp(node)) return channels;
+  if (IsBlockedBinaryOp(node)) {
+    // Only the inputs of identical shapes, which do not broadcast.
+    const TensorId other = ParseTensorName(node.input(1));
+    const auto other_channels = channels_.find(other.node());
+    if (other.index() != 0 || other_channels == channels_.end() ||
+        other_channels->second != channels || properties_ == nullptr ||
+        !properties_->HasInputProperties(node.name())) {
+      return -1;
+    }
+    const auto& inputs = properties_->GetInputProperties(node.name());
+    if (inputs.size() != 2 ||
+        !ShapesSymbolicallyEqual(inputs[0].shape(), inputs[1].shape())) {
+      return -1;
+    }
+    return channels;
+  }
+  if (IsPool(node)) {
+    std::vector<int32> ksize;
+    std::vector<int32> strides;
+    if (!GetWindowAttr(node, "ksize", &ksize) ||
+        !GetWindowAttr(node, "strides", &strides) || !HasWindowPadding(node)) {
+      return -1;
+    }
+    return channels;
+  }
+  return -1;
+}
+
+const NodeDef* NCHWcConverter::SoleBlockedFanout(const NodeDef& node) const {
+  if (nodes_to_preserve_.count(node.name())) return nullptr;
+  const auto it = fanouts_.find(node.name());
+  if (it == fanouts_.end() || it->second.size() != 1) return nullptr;
+  const NodeDef* fanout = it->second[0];
+  if (NodeName(fanout->input(0)) != node.name() ||
+      !channels_.contains(fanout->name())) {
+    return nullptr;
+  }
+  return fanout;
+}
+
+string NCHWcConverter::AddConstant(const string& name, const string& device,
+                                   const Tensor& value, const NodeDef& source) {
+  maybe_unused_nodes_.insert(source.name());
+  NodeDef constant;
+  constant.set_name(name);
+  constant.set_op("Const");
+  constant.set_device(device);
+  // The constant follows the control dependencies of the one it replaces.
+  for (const string& input : source.input()) {
+    if (IsControlInput(input)) constant.add_input(input);
+  }
+  (*constant.mutable_attr())["dtype"].set_type(DT_FLOAT);
+  value.AsProtoTensorContent(
+      (*constant.mutable_attr())["value"].mutable_tensor());
+  new_nodes_.push_back(std::move(constant));
+  return name;
+}
+
+string NCHWcConverter::BlockedInput(const string& input,
+                                    const string& device) {
+  const TensorId tensor = ParseTensorName(input);
+  if (tensor.index() == 0 && channels_.contains(tensor.node())) {
+    return BlockedName(string(tensor.node()));
+  }
+  const string name = strings::StrCat(tensor.node(), "-", tensor.index(),
+                                      "-NHWCToNCHWc-LayoutOptimizer");
+  if (new_node_names_.insert(name).second) {
+    NodeDef convert;
+    convert.set_name(name);
+    convert.set_op("_NHWCToNCHWc");
+    convert.set_device(device);
+    convert.add_input(input);
+    (*convert.mutable_attr())["T"].set_type(DT_FLOAT);
+    (*convert.mutable_attr())["block_size"].set_i(block_size_);
+    new_nodes_.push_back(std::move(convert));
+  }
+  return name;
+}
+
+NodeDef NCHWcConverter::BlockedNode(const NodeDef& node,
+                                    const FusedConv* fused) {
+  NodeDef blocked;
+  blocked.set_name(BlockedName(node.name()));
+  blocked.set_device(node.device());
+  auto* attr = blocked.mutable_attr();
+  (*attr)["T"].set_type(DT_FLOAT);
+  std::vector<const NodeDef*> sources = {&node};
+  std::vector<int32> values;
+
+  if (fused != nullptr) {
+    const NodeDef& conv = *fused->conv;
+    blocked.set_op("_NCHWcConv2D");
+    blocked.add_input(BlockedInput(conv.input(0), node.device()));
+    const NodeDef& filter = *nodes_.at(NodeName(conv.input(1)));
+    Tensor filter_value;
+    GetConstTensor(filter, &filter_value);
+    blocked.add_input(AddConstant(
+        strings::StrCat(node.name(), "-Filter", kSuffix), node.device(),
+        PackFilter(filter_value, block_size_), filter));
+    Tensor bias_value(DT_FLOAT, TensorShape({filter_value.dim_size(3)}));
+    bias_value.flat<float>().setZero();
+    const NodeDef* bias = &filter;
+    if (fused->bias_add != nullptr) {
+      bias = nodes_.at(NodeName(fused->bias_add->input(1)));
+      GetConstTensor(*bias, &bias_value);
+    }
+    blocked.add_input(AddConstant(
+        strings::StrCat(node.name(), "-Bias", kSuffix), node.device(),
+        PadBias(bias_value, block_size_, /*broadcast=*/false), *bias));
+    GetWindowAttr(conv, "strides", &values);
+    SetAttrValue(values, &(*attr)["strides"]);
+    (*attr)["padding"] = conv.attr().at("padding");
+    (*attr)["activation"].set_s(fused->activation);
+    sources = {&conv};
+    if (fused->bias_add != nullptr) sources.push_back(fused->bias_add);
+    if (&node != &conv && &node != fused->bias_add) sources.push_back(&node);
+  } else if (IsBiasAdd(node)) {
+    blocked.set_op("AddV2");
+    blocked.add_input(BlockedInput(node.input(0), node.device()));
+    const NodeDef& bias = *nodes_.at(NodeName(node.input(1)));
+    Tensor bias_value;
+    GetConstTensor(bias, &bias_value);
+    blocked.add_input(AddConstant(
+        strings::StrCat(node.name(), "-Bias", kSuffix), node.device(),
+        PadBias(bias_value, block_size_, /*broadcast=*/true), bias));
+  } else if (IsPool(node)) {
+    blocked.set_op(node.op() == "MaxPool" ? "_NCHWcMaxPool" : "_NCHWcAvgPool");
+    blocked.add_input(BlockedInput(node.input(0), node.device()));
+    GetWindowAttr(node, "ksize", &values);
+    SetAttrValue(values, &(*attr)["ksize"]);
+    GetWindowAttr(node, "strides", &values);
+    SetAttrValue(values, &(*attr)["strides"]);
+    (*attr)["padding"] = node.attr().at("padding");
+  } else {
+    // Elementwise ops keep their attributes.
+    blocked.set_op(node.op());
+    for (const auto& node_attr : node.attr()) {
+      if (node_attr.first != kAttrOutputShape) {
+        (*attr)[node_attr.first] = node_attr.second;
+      }
+    }
+    for (const string& input : node.input()) {
+      if (IsControlInput(input)) break;
+      blocked.add_input(BlockedInput(input, node.device()));
+    }
+  }
+
+  for (const NodeDef* source : sources) {
+    for (const string& input : source->input()) {
+      if (IsControlInput(input)) blocked.add_input(input);
+    }
+  }
+  return blocked;
+}
+
+Status NCHWcConverter::Convert() {
+  *graph_ = item_.graph;
+  // The nodes are converted after their inputs.
+  if (!TopologicalSort(graph_).ok()) return absl::OkStatus();
+  GraphProperties properties(item_);
+  if (properties.InferStatically(/*assume_valid_feeds=*/false).ok()) {
+    properties_ = &properties;
+  }
+
+  for (const NodeDef& node : graph_->node()) {
+    nodes_[node.name()] = &node;
+    for (const string& input : node.input()) {
+      fanouts_[NodeName(input)].push_back(&node);
+    }
+  }
+  for (const NodeDef& node : graph_->node()) {
+    const int64_t channels = BlockedChannels(node);
+    if (channels > 0) channels_[node.name()] = channels;
+  }
+  if (channels_.empty()) return absl::OkStatus();
+  properties_ = nullptr;
+
+  // Fuses the BiasAdd and activation reading only a convolution into it. The
+  // fused nodes are computed by the last one.
+  absl::flat_hash_map<string, FusedConv> fused_convs;
+  std::set<string> nodes_to_delete;
+  for (const NodeDef& node : graph_->node()) {
+    if (!IsConv2D(node) || !channels_.contains(node.name())) continue;
+    FusedConv fused;
+    fused.conv = &node;
+    const NodeDef* last = &node;
+    const NodeDef* fanout = SoleBlockedFanout(*last);
+    if (fanout != nullptr && IsBiasAdd(*fanout)) {
+      fused.bias_add = fanout;
+      nodes_to_delete.insert(last->name());
+      last = fanout;
+      fanout = SoleBlockedFanout(*last);
+    }
+    if (fanout != nullptr && (IsRelu(*fanout) || IsRelu6(*fanout))) {
+      fused.activation = fanout->op();
+      nodes_to_delete.insert(last->name());
+      last = fanout;
+    }
+    fused_convs[last->name()] = fused;
+  }
+
+  std::vector<std::pair<int, NodeDef>> converted;
+  for (int i = 0; i < graph_->node_size(); ++i) {
+    const NodeDef& node = graph_->node(i);
+    if (!channels_.contains(node.name()) ||
+        nodes_to_delete.count(node.name())) {
+      continue;
+    }
+    const auto fused = fused_convs.find(node.name());
+    new_nodes_.push_back(BlockedNode(
+        node, fused == fused_convs.end() ? nullptr : &fused->second));
+    // The node converts its result back for the nodes reading it.
+    NodeDef convert;
+    convert.set_name(node.name());
+    convert.set_op("_NCHWcToNHWC");
+    convert.set_device(node.device());
+    convert.add_input(BlockedName(node.name()));
+    (*convert.mutable_attr())["T"].set_type(DT_FLOAT);
+    (*convert.mutable_attr())["channels"].set_i(channels_.at(node.name()));
+    maybe_unused_nodes_.insert(node.name());
+    converted.emplace_back(i, std::move(convert));
+  }
+  VLOG(1) << "Converted " << channels_.size() << " nodes to NCHWc"
+          << " with blocks of " << block_size_ << " channels";
+
+  // The pointers into the graph are not used below.
+  for (auto& node : converted) {
+    graph_->mutable_node(node.first)->Swap(&node.second);
+  }
+  for (NodeDef& node : new_nodes_) {
+    graph_->add_node()->Swap(&node);
+  }
+
+  // Drops the conversions and constants that nothing reads anymore.
+  absl::flat_hash_set<string> read_nodes;
+  for (const NodeDef& node : graph_->node()) {
+    if (nodes_to_delete.count(node.name())) continue;
+    for (const string& input : node.input()) {
+      read_nodes.insert(NodeName(input));
+    }
+  }
+  for (const NodeDef& node : graph_->node()) {
+    if (maybe_unused_nodes_.contains(node.name()) &&
+        !read_nodes.contains(node.name()) &&
+        !nodes_to_preserve_.count(node.name())) {
+      nodes_to_delete.insert(node.name());
+    }
+  }
+  EraseNodesFromGraph(nodes_to_delete, graph_);
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+int NCHWcBlockSize() {
+  return port::TestCPUFeature(port::CPUFeature::AVX512F) ? 16 : 8;
+}
+
+Status ConvertToNCHWc(const GrapplerItem& item, int block_size,
+                      GraphDef* output) {
+  NCHWcConverter converter(item, block_size, output);
+  return converter.Convert();
+}
+
+}  // end namespace grappler
+}  // end namespace tensorflow
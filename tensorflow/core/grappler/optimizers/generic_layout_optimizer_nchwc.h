@@ -0,0 +1,41 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/platform/status.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Returns the number of float channels in a SIMD register of the host, which
+// is the block size of the NCHWc layout.
+int NCHWcBlockSize();
+
+// Converts the float NHWC Conv2D nodes placed on the CPU with constant filters
+// to the blocked NCHWc layout, along with the BiasAdd, pooling and elementwise
+// nodes reading them. A BiasAdd and a Relu or Relu6 following a convolution
+// are fused into it. The tensors are converted back to NHWC only where a node
+// that is not converted reads them, so the converted nodes keep their names.
+Status ConvertToNCHWc(const GrapplerItem& item, int block_size,
+                      GraphDef* output);
+
+}  // end namespace grappler
+}  // end namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_GENERIC_LAYOUT_OPTIMIZER_NCHWC_H_
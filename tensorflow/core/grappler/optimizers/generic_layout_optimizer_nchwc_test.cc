@@ -0,0 +1,231 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/generic_layout_optimizer_nchwc.h"
+
+#include <map>
+#include <string>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/common_runtime/graph_constructor.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/graph.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/strings/strcat.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+Output RandomConst(const Scope& s, const TensorShape& shape) {
+  Tensor value(DT_FLOAT, shape);
+  value.flat<float>().setRandom();
+  value.flat<float>() = (value.flat<float>() - 0.5f) * 0.2f;
+  return ops::Const(s, Input::Initializer(value));
+}
+
+// A convolution with a bias and a relu, as in ResNet.
+Output ConvBiasRelu(const Scope& s, const string& name, Output input,
+                    int in_channels, int out_channels, int size, int stride) {
+  Output filter = RandomConst(s.WithOpName(name + "/filter"),
+                              {size, size, in_channels, out_channels});
+  Output bias = RandomConst(s.WithOpName(name + "/bias"), {out_channels});
+  Output conv = ops::Conv2D(s.WithOpName(name + "/conv"), input, filter,
+                            {1, stride, stride, 1}, "SAME");
+  Output bias_add =
+      ops::BiasAdd(s.WithOpName(name + "/bias_add"), conv, bias);
+  return ops::Relu(s.WithOpName(name + "/relu"), bias_add);
+}
+
+// Adds a ResNet of `num_blocks` bottleneck blocks of `channels` channels
+// reading `image` of shape [batch, size, size, 3], with the output "output".
+void AddResNet(const Scope& s, Output image, int channels, int num_blocks) {
+  Output input = ops::Identity(s.WithOpName("image"), image);
+  Output x = ConvBiasRelu(s, "stem", input, 3, channels, 7, 2);
+  x = ops::MaxPool(s.WithOpName("stem/pool"), x, {1, 3, 3, 1}, {1, 2, 2, 1},
+                   "SAME");
+  for (int i = 0; i < num_blocks; ++i) {
+    const string block = strings::StrCat("block", i);
+    Output y = ConvBiasRelu(s, block + "/a", x, channels, channels / 4, 1, 1);
+    y = ConvBiasRelu(s, block + "/b", y, channels / 4, channels / 4, 3, 1);
+    Output filter = RandomConst(s.WithOpName(block + "/c/filter"),
+                                {1, 1, channels / 4, channels});
+    y = ops::Conv2D(s.WithOpName(block + "/c/conv"), y, filter, {1, 1, 1, 1},
+                    "VALID");
+    x = ops::Relu(s.WithOpName(block + "/relu"),
+                  ops::AddV2(s.WithOpName(block + "/add"), x, y));
+  }
+  x = ops::AvgPool(s.WithOpName("pool"), x, {1, 2, 2, 1}, {1, 2, 2, 1},
+                   "VALID");
+  ops::Identity(s.WithOpName("output"), x);
+}
+
+class NCHWcLayoutTest : public GrapplerTest {
+ protected:
+  static std::map<string, int> CountOps(const GraphDef& graph) {
+    std::map<string, int> counts;
+    for (const NodeDef& node : graph.node()) ++counts[node.op()];
+    return counts;
+  }
+
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  // Checks that `output` computes the fetches of `item` like its graph.
+  void ExpectSameValues(const GrapplerItem& item, const GraphDef& output,
+                        const Tensor& image) {
+    const auto expected =
+        EvaluateNodes(item.graph, item.fetch, {{"image_input", image}});
+    const auto actual =
+        EvaluateNodes(output, item.fetch, {{"image_input", image}});
+    ASSERT_EQ(expected.size(), actual.size());
+    for (int i = 0; i < expected.size(); ++i) {
+      test::ExpectClose(expected[i], actual[i], /*atol=*/1e-4, /*rtol=*/1e-4);
+    }
+  }
+};
+
+TEST_F(NCHWcLayoutTest, ResNet) {
+  Scope s = Scope::NewRootScope();
+  auto image = ops::Placeholder(s.WithOpName("image_input"), DT_FLOAT,
+                                ops::Placeholder::Shape({2, 32, 32, 3}));
+  AddResNet(s, image, /*channels=*/32, /*num_blocks=*/2);
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_ASSERT_OK(ConvertToNCHWc(item, /*block_size=*/8, &output));
+
+  auto counts = CountOps(output);
+  EXPECT_EQ(counts["Conv2D"], 0);
+  EXPECT_EQ(counts["BiasAdd"], 0);
+  EXPECT_EQ(counts["MaxPool"], 0);
+  EXPECT_EQ(counts["AvgPool"], 0);
+  EXPECT_EQ(counts["_NCHWcConv2D"], 7);
+  EXPECT_EQ(counts["_NCHWcMaxPool"], 1);
+  EXPECT_EQ(counts["_NCHWcAvgPool"], 1);
+  // The image is converted once and the output back once.
+  EXPECT_EQ(counts["_NHWCToNCHWc"], 1);
+  EXPECT_EQ(counts["_NCHWcToNHWC"], 1);
+
+  // The bias and relu are fused into the convolutions.
+  const NodeDef* stem = FindNode(output, "stem/relu-NCHWc-LayoutOptimizer");
+  ASSERT_NE(stem, nullptr);
+  EXPECT_EQ(stem->op(), "_NCHWcConv2D");
+  EXPECT_EQ(stem->attr().at("activation").s(), "Relu");
+  EXPECT_EQ(FindNode(output, "stem/conv"), nullptr);
+  const NodeDef* fetch = FindNode(output, "output");
+  ASSERT_NE(fetch, nullptr);
+  EXPECT_EQ(fetch->op(), "_NCHWcToNHWC");
+
+  ExpectSameValues(item, output,
+                   GenerateRandomTensor<DT_FLOAT>({2, 32, 32, 3}));
+}
+
+TEST_F(NCHWcLayoutTest, PaddedChannels) {
+  Scope s = Scope::NewRootScope();
+  auto image = ops::Placeholder(s.WithOpName("image_input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 9, 9, 5}));
+  Output x = ConvBiasRelu(s, "conv", image, 5, 12, 3, 2);
+  ops::MaxPool(s.WithOpName("pool"), x, {1, 2, 2, 1}, {1, 1, 1, 1}, "VALID");
+  GrapplerItem item;
+  // The convolution is fetched, so it is not fused.
+  item.fetch = {"conv/conv", "pool"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_ASSERT_OK(ConvertToNCHWc(item, /*block_size=*/16, &output));
+
+  auto counts = CountOps(output);
+  EXPECT_EQ(counts["_NCHWcConv2D"], 1);
+  EXPECT_EQ(counts["AddV2"], 1);
+  EXPECT_EQ(counts["_NCHWcToNHWC"], 2);
+  const NodeDef* conv = FindNode(output, "conv/conv-NCHWc-LayoutOptimizer");
+  ASSERT_NE(conv, nullptr);
+  EXPECT_EQ(conv->attr().at("activation").s(), "Identity");
+
+  ExpectSameValues(item, output, GenerateRandomTensor<DT_FLOAT>({1, 9, 9, 5}));
+}
+
+TEST_F(NCHWcLayoutTest, KeepsUnsupportedConvolutions) {
+  Scope s = Scope::NewRootScope();
+  auto image = ops::Placeholder(s.WithOpName("image_input"), DT_FLOAT,
+                                ops::Placeholder::Shape({1, 8, 8, 8}));
+  Output filter = RandomConst(s.WithOpName("filter"), {3, 3, 8, 8});
+  // Dilated.
+  ops::Conv2D(s.WithOpName("dilated"), image, filter, {1, 1, 1, 1}, "SAME",
+              ops::Conv2D::Dilations({1, 2, 2, 1}));
+  // Explicitly padded.
+  ops::Conv2D(s.WithOpName("explicit"), image, filter, {1, 1, 1, 1},
+              "EXPLICIT",
+              ops::Conv2D::ExplicitPaddings({0, 0, 1, 1, 1, 1, 0, 0}));
+  // The filter is not constant.
+  ops::Conv2D(s.WithOpName("variable"), image, image, {1, 1, 1, 1}, "SAME");
+  // Placed on a GPU.
+  ops::Conv2D(s.WithOpName("gpu").WithDevice("/device:GPU:0"), image, filter,
+              {1, 1, 1, 1}, "SAME");
+  GrapplerItem item;
+  item.fetch = {"dilated", "explicit", "variable", "gpu"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  GraphDef output;
+  TF_ASSERT_OK(ConvertToNCHWc(item, /*block_size=*/8, &output));
+  CompareGraphs(item.graph, output);
+}
+
+// Runs a ResNet on images of `batch` x 112 x 112, converted to NCHWc with
+// blocks of `block_size` channels, or kept in NHWC if it is 0.
+void BM_ResNet(::testing::benchmark::State& state) {
+  const int batch = state.range(0);
+  const int block_size = state.range(1);
+  Scope s = Scope::NewRootScope();
+  AddResNet(s, RandomConst(s.WithOpName("image_input"), {batch, 112, 112, 3}),
+            /*channels=*/64, /*num_blocks=*/3);
+  GrapplerItem item;
+  item.fetch = {"output"};
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  GraphDef graph_def = item.graph;
+  if (block_size > 0) {
+    TF_CHECK_OK(ConvertToNCHWc(item, block_size, &graph_def));
+  }
+  Graph* graph = new Graph(OpRegistry::Global());
+  TF_CHECK_OK(
+      ConvertGraphDefToGraph(GraphConstructorOptions(), graph_def, graph));
+  test::Benchmark("cpu", graph, /*old_benchmark_api*/ false).Run(state);
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * batch);
+}
+BENCHMARK(BM_ResNet)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 8)
+    ->ArgPair(1, 16)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 8)
+    ->ArgPair(8, 16)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
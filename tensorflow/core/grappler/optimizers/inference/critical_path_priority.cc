@@ -0,0 +1,113 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/inference/critical_path_priority.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
+#include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/costs/virtual_placer.h"
+#include "tensorflow/core/grappler/graph_topology_view.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils/topological_sort.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+
+Status CriticalPathPriority::Optimize(Cluster* cluster,
+                                      const GrapplerItem& item,
+                                      GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+
+  GraphProperties properties(item);
+  TF_RETURN_IF_ERROR(properties.InferStatically(
+      /*assume_valid_feeds=*/false,
+      /*aggressive_shape_inference=*/false,
+      /*include_input_tensor_values=*/false,
+      /*include_output_tensor_values=*/false));
+
+  GraphTopologyView graph_view;
+  TF_RETURN_IF_ERROR(graph_view.InitializeFromGraph(*optimized_graph));
+  std::vector<const NodeDef*> topo_order;
+  TF_RETURN_IF_ERROR(ComputeTopologicalOrder(*optimized_graph, &topo_order));
+
+  // Without a cluster, the costs are estimated on the devices named by the
+  // nodes.
+  std::unique_ptr<VirtualPlacer> placer;
+  if (cluster != nullptr && !cluster->GetDevices().empty()) {
+    placer = std::make_unique<VirtualPlacer>(cluster->GetDevices());
+  }
+  std::unordered_map<string, const NodeDef*> name_to_node;
+  for (const NodeDef& node : optimized_graph->node()) {
+    name_to_node[node.name()] = &node;
+  }
+
+  OpLevelCostEstimator estimator;
+  const auto estimate_cost = [&](const NodeDef& node) -> int64_t {
+    OpContext op_context;
+    op_context.name = node.name();
+    op_context.device_name = node.device();
+    op_context.op_info = BuildOpInfoWithoutDevice(
+        node, name_to_node, properties.GetInputProperties(node.name()));
+    for (const auto& output : properties.GetOutputProperties(node.name())) {
+      *op_context.op_info.add_outputs() = output;
+    }
+    *op_context.op_info.mutable_device() =
+        placer ? placer->get_device(node) : GetDeviceInfo(node.device());
+    if (item.graph.has_library()) {
+      op_context.function_library = &item.graph.library();
+    }
+    // Nodes the estimator knows nothing about still cost their dispatch.
+    return std::max<int64_t>(
+        estimator.PredictCosts(op_context).execution_time.count(), 1);
+  };
+
+  // Visits the consumers of a node before the node. The back edges of loops
+  // are ignored, since NextIteration nodes come after the Merge nodes they
+  // feed.
+  std::vector<int64_t> priorities(optimized_graph->node_size(), 0);
+  for (auto it = topo_order.rbegin(); it != topo_order.rend(); ++it) {
+    const int index = *graph_view.GetNodeIndex(**it);
+    int64_t remaining = 0;
+    for (int fanout : graph_view.GetFanout(index)) {
+      remaining = std::max(remaining, priorities[fanout]);
+    }
+    priorities[index] = estimate_cost(**it) + remaining;
+  }
+
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    (*optimized_graph->mutable_node(i)
+          ->mutable_attr())[kCriticalPathPriorityAttrName]
+        .set_i(priorities[i]);
+  }
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(CriticalPathPriority, "critical_path_priority");
+
+}  // namespace grappler
+}  // namespace tensorflow
@@ -0,0 +1,55 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_CRITICAL_PATH_PRIORITY_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_CRITICAL_PATH_PRIORITY_H_
+
+#include <string>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// This optimization does the following:
+//
+// Annotate every node with the `kCriticalPathPriorityAttrName` attribute,
+// holding the cost of the longest path from the node to the end of the graph,
+// as estimated by the `OpLevelCostEstimator`. When several nodes are ready,
+// the executor runs the ones with the highest priority first, so that the
+// long-latency chains of wide graphs start as early as possible.
+class CriticalPathPriority : public CustomGraphOptimizer {
+ public:
+  Status Init(const RewriterConfig_CustomGraphOptimizer* config) override {
+    return absl::OkStatus();
+  }
+
+  std::string name() const override { return "critical_path_priority"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_CRITICAL_PATH_PRIORITY_H_
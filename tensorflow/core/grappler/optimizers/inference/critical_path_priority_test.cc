@@ -0,0 +1,102 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/inference/critical_path_priority.h"
+
+#include <cstdint>
+#include <string>
+
+#include "absl/container/flat_hash_map.h"
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+absl::flat_hash_map<std::string, int64_t> GetPriorities(
+    const GraphDef& graph) {
+  absl::flat_hash_map<std::string, int64_t> priorities;
+  for (const NodeDef& node : graph.node()) {
+    int64_t priority;
+    if (TryGetNodeAttr(node, kCriticalPathPriorityAttrName, &priority)) {
+      priorities[node.name()] = priority;
+    }
+  }
+  return priorities;
+}
+
+TEST(CriticalPathPriorityTest, LongChainComesFirst) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice(
+      "/job:localhost/replica:0/task:0/device:CPU:0");
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({256, 256}));
+  // A chain of three matmuls next to a single one.
+  auto chain_0 = ops::MatMul(s.WithOpName("chain_0"), x, x);
+  auto chain_1 = ops::MatMul(s.WithOpName("chain_1"), chain_0, x);
+  auto chain_2 = ops::MatMul(s.WithOpName("chain_2"), chain_1, x);
+  auto branch = ops::MatMul(s.WithOpName("branch"), x, x);
+  auto sum = ops::AddV2(s.WithOpName("sum"), chain_2, branch);
+
+  GrapplerItem item;
+  item.fetch = {"sum"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  CriticalPathPriority optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  auto priorities = GetPriorities(output);
+  ASSERT_EQ(priorities.size(), item.graph.node_size());
+  EXPECT_GT(priorities["sum"], 0);
+  EXPECT_GT(priorities["chain_2"], priorities["sum"]);
+  EXPECT_GT(priorities["chain_1"], priorities["chain_2"]);
+  EXPECT_GT(priorities["chain_0"], priorities["chain_1"]);
+  // The matmuls have the same cost, so the chain is longer than the branch.
+  EXPECT_EQ(priorities["branch"], priorities["chain_2"]);
+  EXPECT_GT(priorities["chain_0"], priorities["branch"]);
+  EXPECT_GT(priorities["x"], priorities["chain_0"]);
+}
+
+TEST(CriticalPathPriorityTest, ControlDependenciesAreOnThePath) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto a = ops::Const(s.WithOpName("a"), 1.0f, {16});
+  auto b = ops::Const(s.WithOpName("b"), 2.0f, {16});
+  auto add = ops::AddV2(s.WithOpName("add"), a, b);
+  auto c = ops::Const(s.WithOpName("c").WithControlDependencies(add), 3.0f,
+                      {16});
+  auto mul = ops::Mul(s.WithOpName("mul"), c, c);
+
+  GrapplerItem item;
+  item.fetch = {"mul"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  CriticalPathPriority optimizer;
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  auto priorities = GetPriorities(output);
+  EXPECT_GT(priorities["c"], priorities["mul"]);
+  EXPECT_GT(priorities["add"], priorities["c"]);
+  EXPECT_GT(priorities["a"], priorities["add"]);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
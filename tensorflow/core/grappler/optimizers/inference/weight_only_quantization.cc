@@ -0,0 +1,239 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/inference/weight_only_quantization.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include "absl/status/status.h"
+#include "tensorflow/core/framework/attr_value.pb.h"
+#include "tensorflow/core/framework/node_def.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor.pb.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/grappler/op_types.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer_registry.h"
+#include "tensorflow/core/grappler/utils.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+constexpr char kQuantizedMatMul[] = "_WeightOnlyQuantizedMatMul";
+
+// Returns the float weights of shape [K, N] that `node` multiplies by, read
+// from the constant `weights_node`, or false if the node is not eligible.
+bool GetMatMulWeights(const NodeDef& node, const NodeDef& weights_node,
+                      Tensor* weights, bool* transpose_a) {
+  if (!IsConstant(weights_node)) return false;
+  DataType dtype;
+  if (!TryGetNodeAttr(node, "T", &dtype) || dtype != DT_FLOAT) return false;
+  if (!node.device().empty() && !NodeIsOnCpu(&node)) return false;
+
+  bool transpose_b = false;
+  if (IsMatMul(node)) {
+    if (!TryGetNodeAttr(node, "transpose_a", transpose_a) ||
+        !TryGetNodeAttr(node, "transpose_b", &transpose_b)) {
+      return false;
+    }
+  } else if (IsAnyBatchMatMul(node)) {
+    // The batch dimensions of the lhs flatten into the rows of a matmul by
+    // a single matrix, which they cannot do when the lhs is transposed.
+    bool adj_x = false;
+    if (!TryGetNodeAttr(node, "adj_x", &adj_x) || adj_x ||
+        !TryGetNodeAttr(node, "adj_y", &transpose_b)) {
+      return false;
+    }
+    *transpose_a = false;
+  } else {
+    return false;
+  }
+
+  const auto it = weights_node.attr().find("value");
+  if (it == weights_node.attr().end() ||
+      !weights->FromProto(it->second.tensor()) ||
+      weights->dtype() != DT_FLOAT || weights->dims() != 2) {
+    return false;
+  }
+  if (transpose_b) {
+    Tensor transposed(DT_FLOAT, TensorShape({weights->dim_size(1),
+                                             weights->dim_size(0)}));
+    transposed.matrix<float>() =
+        weights->matrix<float>().shuffle(Eigen::array<int, 2>{1, 0});
+    *weights = transposed;
+  }
+  return true;
+}
+
+}  // namespace
+
+QuantizedWeights QuantizeWeights(const Tensor& weights, int num_bits) {
+  const int64_t k = weights.dim_size(0);
+  const int64_t n = weights.dim_size(1);
+  const int max_value = (1 << (num_bits - 1)) - 1;
+  QuantizedWeights quantized;
+  quantized.weights =
+      Tensor(DT_INT8, TensorShape({num_bits == 8 ? k : (k + 1) / 2, n}));
+  quantized.weights.flat<int8_t>().setZero();
+  quantized.scales = Tensor(DT_FLOAT, TensorShape({n}));
+
+  auto w = weights.matrix<float>();
+  auto q = quantized.weights.matrix<int8_t>();
+  auto scales = quantized.scales.vec<float>();
+  double error = 0;
+  double norm = 0;
+  for (int64_t j = 0; j < n; ++j) {
+    float max_abs = 0;
+    for (int64_t i = 0; i < k; ++i) {
+      max_abs = std::max(max_abs, std::abs(w(i, j)));
+    }
+    scales(j) = max_abs > 0 ? max_abs / max_value : 1.0f;
+    for (int64_t i = 0; i < k; ++i) {
+      const int value =
+          std::clamp(static_cast<int>(std::round(w(i, j) / scales(j))),
+                     -max_value, max_value);
+      if (num_bits == 8) {
+        q(i, j) = value;
+      } else {
+        q(i / 2, j) |= (value & 0xF) << (4 * (i % 2));
+      }
+      const double diff = w(i, j) - value * scales(j);
+      error += diff * diff;
+      norm += static_cast<double>(w(i, j)) * w(i, j);
+    }
+  }
+  quantized.relative_error = norm > 0 ? std::sqrt(error / norm) : 0;
+  return quantized;
+}
+
+Status WeightOnlyQuantization::Init(
+    const RewriterConfig_CustomGraphOptimizer* config) {
+  bool has_max_relative_error = false;
+  if (config != nullptr) {
+    const auto& params = config->parameter_map();
+    if (params.count("num_bits")) num_bits_ = params.at("num_bits").i();
+    if (params.count("min_weight_elements")) {
+      min_weight_elements_ = params.at("min_weight_elements").i();
+    }
+    if (params.count("max_relative_error")) {
+      max_relative_error_ = params.at("max_relative_error").f();
+      has_max_relative_error = true;
+    }
+  }
+  if (num_bits_ != 4 && num_bits_ != 8) {
+    return errors::InvalidArgument("num_bits must be 4 or 8, got ", num_bits_);
+  }
+  if (!has_max_relative_error) {
+    max_relative_error_ = num_bits_ == 8 ? 0.02 : 0.15;
+  }
+  return absl::OkStatus();
+}
+
+Status WeightOnlyQuantization::Optimize(Cluster* cluster,
+                                        const GrapplerItem& item,
+                                        GraphDef* optimized_graph) {
+  *optimized_graph = item.graph;
+  std::unordered_map<string, int> node_index;
+  for (int i = 0; i < optimized_graph->node_size(); ++i) {
+    node_index[optimized_graph->node(i).name()] = i;
+  }
+
+  std::set<string> quantized_weights;
+  const int num_nodes = optimized_graph->node_size();
+  for (int i = 0; i < num_nodes; ++i) {
+    NodeDef* node = optimized_graph->mutable_node(i);
+    if (node->input_size() < 2 || IsControlInput(node->input(1))) continue;
+    const auto weights_it = node_index.find(NodeName(node->input(1)));
+    if (weights_it == node_index.end()) continue;
+    const NodeDef& weights_node = optimized_graph->node(weights_it->second);
+
+    Tensor weights;
+    bool transpose_a = false;
+    if (!GetMatMulWeights(*node, weights_node, &weights, &transpose_a) ||
+        weights.NumElements() < min_weight_elements_) {
+      continue;
+    }
+    const QuantizedWeights quantized = QuantizeWeights(weights, num_bits_);
+    if (quantized.relative_error > max_relative_error_) {
+      VLOG(1) << "Not quantizing the weights of " << node->name()
+              << ": relative error " << quantized.relative_error;
+      continue;
+    }
+    VLOG(1) << "Quantizing the weights of " << node->name() << " to "
+            << num_bits_ << " bits: relative error "
+            << quantized.relative_error;
+
+    // The constants follow the control dependencies of the float weights.
+    auto add_constant = [&](const string& suffix, const Tensor& value) {
+      NodeDef* constant = optimized_graph->add_node();
+      constant->set_name(AddPrefixToNodeName(suffix, node->name()));
+      constant->set_op("Const");
+      constant->set_device(node->device());
+      for (const string& input : weights_node.input()) {
+        if (IsControlInput(input)) *constant->add_input() = input;
+      }
+      (*constant->mutable_attr())["dtype"].set_type(value.dtype());
+      value.AsProtoTensorContent(
+          (*constant->mutable_attr())["value"].mutable_tensor());
+      return constant->name();
+    };
+    const string b = add_constant("quantized_weights", quantized.weights);
+    const string b_scales = add_constant("weight_scales", quantized.scales);
+
+    NodeDef rewritten;
+    rewritten.set_name(node->name());
+    rewritten.set_op(kQuantizedMatMul);
+    rewritten.set_device(node->device());
+    rewritten.add_input(node->input(0));
+    rewritten.add_input(b);
+    rewritten.add_input(b_scales);
+    for (int j = 2; j < node->input_size(); ++j) {
+      rewritten.add_input(node->input(j));
+    }
+    auto* attr = rewritten.mutable_attr();
+    (*attr)["T"].set_type(DT_FLOAT);
+    (*attr)["transpose_a"].set_b(transpose_a);
+    (*attr)["num_bits"].set_i(num_bits_);
+    node->Swap(&rewritten);
+    quantized_weights.insert(weights_node.name());
+  }
+
+  // Drops the float weights that nothing reads anymore.
+  if (!quantized_weights.empty()) {
+    const auto nodes_to_preserve = item.NodesToPreserve();
+    for (const NodeDef& node : optimized_graph->node()) {
+      for (const string& input : node.input()) {
+        quantized_weights.erase(NodeName(input));
+      }
+    }
+    for (const string& name : nodes_to_preserve) {
+      quantized_weights.erase(name);
+    }
+    EraseNodesFromGraph(quantized_weights, optimized_graph);
+  }
+  return absl::OkStatus();
+}
+
+REGISTER_GRAPH_OPTIMIZER_AS(WeightOnlyQuantization,
+                            "weight_only_quantization");
+
+}  // namespace grappler
+}  // namespace tensorflow
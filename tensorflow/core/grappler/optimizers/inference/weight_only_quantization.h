@@ -0,0 +1,80 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_WEIGHT_ONLY_QUANTIZATION_H_
+#define TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_WEIGHT_ONLY_QUANTIZATION_H_
+
+#include <cstdint>
+#include <string>
+
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/grappler/clusters/cluster.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/optimizers/custom_graph_optimizer.h"
+#include "tensorflow/core/protobuf/rewriter_config.pb.h"
+
+namespace tensorflow {
+namespace grappler {
+
+// Weights of a matmul quantized per output channel, as the inputs of
+// `_WeightOnlyQuantizedMatMul`.
+struct QuantizedWeights {
+  // Signed integers of `num_bits` bits, packed two per byte for 4 bits.
+  Tensor weights;
+  // Scale of every column of the weights.
+  Tensor scales;
+  // Norm of the quantization error over the norm of the weights.
+  double relative_error = 0;
+};
+
+// Quantizes the float `weights` of shape [K, N] symmetrically per column.
+QuantizedWeights QuantizeWeights(const Tensor& weights, int num_bits);
+
+// This optimization does the following:
+//
+// Rewrite the float MatMul and BatchMatMul ops of the CPU whose right-hand
+// side is a constant matrix into `_WeightOnlyQuantizedMatMul` ops, which read
+// the weights quantized to 8 or 4 bits per output channel and dequantize them
+// inside the matrix multiplication. Small batches read every weight once, so
+// they run up to 4 or 8 times less memory traffic than the float matmuls.
+//
+// The parameters of the custom optimizer config are:
+//   num_bits: 8 (default) or 4.
+//   min_weight_elements: weights with fewer elements stay float (default
+//     65536).
+//   max_relative_error: weights whose relative quantization error is larger
+//     stay float (default 0.02 for 8 bits and 0.15 for 4 bits).
+class WeightOnlyQuantization : public CustomGraphOptimizer {
+ public:
+  Status Init(const RewriterConfig_CustomGraphOptimizer* config) override;
+
+  std::string name() const override { return "weight_only_quantization"; }
+
+  bool UsesFunctionLibrary() const override { return false; }
+
+  Status Optimize(Cluster* cluster, const GrapplerItem& item,
+                  GraphDef* optimized_graph) override;
+
+ private:
+  int num_bits_ = 8;
+  int64_t min_weight_elements_ = 65536;
+  float max_relative_error_ = 0.02;
+};
+
+}  // namespace grappler
+}  // namespace tensorflow
+
+#endif  // TENSORFLOW_CORE_GRAPPLER_OPTIMIZERS_INFERENCE_WEIGHT_ONLY_QUANTIZATION_H_
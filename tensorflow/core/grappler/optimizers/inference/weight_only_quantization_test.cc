@@ -0,0 +1,227 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/core/grappler/optimizers/inference/weight_only_quantization.h"
+
+#include <vector>
+
+#include "tensorflow/cc/ops/standard_ops.h"
+#include "tensorflow/core/framework/graph.pb.h"
+#include "tensorflow/core/framework/node_def_util.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/grappler/grappler_item.h"
+#include "tensorflow/core/grappler/utils/grappler_test.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace grappler {
+namespace {
+
+class WeightOnlyQuantizationTest : public GrapplerTest {
+ protected:
+  // Returns the node named `name` of `graph`, or nullptr.
+  static const NodeDef* FindNode(const GraphDef& graph, const string& name) {
+    for (const NodeDef& node : graph.node()) {
+      if (node.name() == name) return &node;
+    }
+    return nullptr;
+  }
+
+  // Checks that `name` was rewritten to a `num_bits` quantized matmul and
+  // computes the same values as in `item`.
+  void ExpectQuantized(const GrapplerItem& item, const GraphDef& output,
+                       const string& name, int num_bits, double atol) {
+    const NodeDef* node = FindNode(output, name);
+    ASSERT_NE(node, nullptr);
+    EXPECT_EQ(node->op(), "_WeightOnlyQuantizedMatMul");
+    ASSERT_EQ(node->input_size(), 3);
+    EXPECT_EQ(node->input(1), name + "/quantized_weights");
+    EXPECT_EQ(node->input(2), name + "/weight_scales");
+    int bits;
+    TF_ASSERT_OK(GetNodeAttr(*node, "num_bits", &bits));
+    EXPECT_EQ(bits, num_bits);
+
+    const Tensor x = GenerateTensorWithSetRandom<DT_FLOAT>({16, 256});
+    const auto expected = EvaluateNodes(item.graph, {name}, {{"x", x}});
+    const auto actual = EvaluateNodes(output, {name}, {{"x", x}});
+    ASSERT_EQ(actual.size(), 1);
+    test::ExpectClose(expected[0], actual[0], atol, /*rtol=*/0);
+  }
+};
+
+TEST_F(WeightOnlyQuantizationTest, MatMul) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({-1, 256}));
+  auto w = ops::Const(s.WithOpName("w"),
+                      Input::Initializer(
+                          GenerateTensorWithSetRandom<DT_FLOAT>({256, 512})));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w);
+
+  GrapplerItem item;
+  item.fetch = {"matmul"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  WeightOnlyQuantization optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ExpectQuantized(item, output, "matmul", 8, 0.5);
+  // The float weights are no longer read.
+  EXPECT_EQ(FindNode(output, "w"), nullptr);
+  const NodeDef* weights = FindNode(output, "matmul/quantized_weights");
+  ASSERT_NE(weights, nullptr);
+  EXPECT_EQ(weights->attr().at("dtype").type(), DT_INT8);
+}
+
+TEST_F(WeightOnlyQuantizationTest, TransposedWeights) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({-1, 256}));
+  auto w = ops::Const(s.WithOpName("w"),
+                      Input::Initializer(
+                          GenerateTensorWithSetRandom<DT_FLOAT>({512, 256})));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w,
+                            ops::MatMul::TransposeB(true));
+  auto batch_matmul = ops::BatchMatMulV2(s.WithOpName("batch_matmul"), x, w,
+                                         ops::BatchMatMulV2::AdjY(true));
+
+  GrapplerItem item;
+  item.fetch = {"matmul", "batch_matmul"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  WeightOnlyQuantization optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ExpectQuantized(item, output, "matmul", 8, 0.5);
+  ExpectQuantized(item, output, "batch_matmul", 8, 0.5);
+  EXPECT_EQ(FindNode(output, "w"), nullptr);
+}
+
+TEST_F(WeightOnlyQuantizationTest, Int4) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({-1, 256}));
+  auto w = ops::Const(s.WithOpName("w"),
+                      Input::Initializer(
+                          GenerateTensorWithSetRandom<DT_FLOAT>({256, 64})));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w);
+
+  GrapplerItem item;
+  item.fetch = {"matmul"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["num_bits"].set_i(4);
+  (*config.mutable_parameter_map())["min_weight_elements"].set_i(1024);
+  WeightOnlyQuantization optimizer;
+  TF_ASSERT_OK(optimizer.Init(&config));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ExpectQuantized(item, output, "matmul", 4, 8.0);
+  const NodeDef* weights = FindNode(output, "matmul/quantized_weights");
+  ASSERT_NE(weights, nullptr);
+  Tensor packed;
+  ASSERT_TRUE(packed.FromProto(weights->attr().at("value").tensor()));
+  EXPECT_EQ(packed.shape(), TensorShape({128, 64}));
+}
+
+TEST_F(WeightOnlyQuantizationTest, KeepsIneligibleMatMuls) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({256, 256}));
+  auto small = ops::Const(s.WithOpName("small"), 1.0f, {256, 16});
+  auto large = ops::Const(s.WithOpName("large"), 1.0f, {256, 512});
+  // Too small to be worth quantizing.
+  auto small_matmul = ops::MatMul(s.WithOpName("small_matmul"), x, small);
+  // The weights are not constant.
+  auto variable_matmul = ops::MatMul(s.WithOpName("variable_matmul"), x, x);
+  // The lhs cannot be flattened into a matrix.
+  auto adjoint_matmul = ops::BatchMatMulV2(s.WithOpName("adjoint_matmul"), x,
+                                           large,
+                                           ops::BatchMatMulV2::AdjX(true));
+  // Placed on a GPU.
+  auto gpu_matmul = ops::MatMul(
+      s.WithOpName("gpu_matmul").WithDevice("/device:GPU:0"), x, large);
+
+  GrapplerItem item;
+  item.fetch = {"small_matmul", "variable_matmul", "adjoint_matmul",
+                "gpu_matmul"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  WeightOnlyQuantization optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  CompareGraphs(item.graph, output);
+}
+
+TEST_F(WeightOnlyQuantizationTest, KeepsPreservedWeights) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+  auto x = ops::Placeholder(s.WithOpName("x"), DT_FLOAT,
+                            ops::Placeholder::Shape({-1, 256}));
+  auto w = ops::Const(s.WithOpName("w"),
+                      Input::Initializer(
+                          GenerateTensorWithSetRandom<DT_FLOAT>({256, 512})));
+  auto matmul = ops::MatMul(s.WithOpName("matmul"), x, w);
+
+  GrapplerItem item;
+  item.fetch = {"matmul", "w"};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  WeightOnlyQuantization optimizer;
+  TF_ASSERT_OK(optimizer.Init(nullptr));
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  ExpectQuantized(item, output, "matmul", 8, 0.5);
+  EXPECT_NE(FindNode(output, "w"), nullptr);
+}
+
+TEST_F(WeightOnlyQuantizationTest, InvalidNumBits) {
+  RewriterConfig_CustomGraphOptimizer config;
+  (*config.mutable_parameter_map())["num_bits"].set_i(3);
+  WeightOnlyQuantization optimizer;
+  EXPECT_FALSE(optimizer.Init(&config).ok());
+}
+
+TEST(QuantizeWeightsTest, RelativeError) {
+  Tensor weights(DT_FLOAT, TensorShape({3, 2}));
+  test::FillValues<float>(&weights, {1.0f, -2.0f, 0.5f, 1.0f, -1.0f, 0.0f});
+  const QuantizedWeights int8 = QuantizeWeights(weights, 8);
+  test::ExpectTensorEqual<int8_t>(
+      int8.weights,
+      test::AsTensor<int8_t>({127, -127, 64, 64, -127, 0}, {3, 2}));
+  test::ExpectClose(int8.scales,
+                    test::AsTensor<float>({1.0f / 127, 2.0f / 127}));
+  EXPECT_LT(int8.relative_error, 0.01);
+
+  // Rows 0 and 1 share the first row of bytes, and row 2 the low nibbles of
+  // the second.
+  const QuantizedWeights int4 = QuantizeWeights(weights, 4);
+  test::ExpectTensorEqual<int8_t>(
+      int4.weights, test::AsTensor<int8_t>({0x47, 0x49, 0x09, 0x00}, {2, 2}));
+  EXPECT_LT(int4.relative_error, 0.1);
+}
+
+}  // namespace
+}  // namespace grappler
+}  // namespace tensorflow
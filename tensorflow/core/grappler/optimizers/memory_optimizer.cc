@@ -16,6 +16,7 @@ limitations under the License.
 #include "tensorflow/core/grappler/optimizers/memory_optimizer.h"
 
 #include <algorithm>
+#include <memory>
 #include <queue>
 #include <set>
 #include <unordered_map>
@@ -30,7 +31,10 @@ limitations under the License.
 #include "tensorflow/core/grappler/clusters/virtual_cluster.h"
 #include "tensorflow/core/grappler/costs/graph_memory.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
+#include "tensorflow/core/grappler/costs/op_context.h"
+#include "tensorflow/core/grappler/costs/op_level_cost_estimator.h"
 #include "tensorflow/core/grappler/costs/utils.h"
+#include "tensorflow/core/grappler/costs/virtual_placer.h"
 #include "tensorflow/core/grappler/graph_topology_view.h"
 #include "tensorflow/core/grappler/grappler_item.h"
 #include "tensorflow/core/grappler/mutable_graph_view.h"
@@ -440,6 +444,36 @@ void RecomputeSubgraph(
   }
 }
 
+// Nodes whose inputs we may want to recompute. This matches node names that
+// contain recomputation_targets_name_scope as a name scope, meaning it either
+// begins with or contains the name scope. Defaults to "gradients/" which will
+// match any node names that begins with "gradients/" or contains
+// "/gradients/".
+bool IsRecomputationTarget(const string& recomputation_targets_name_scope,
+                           const NodeDef& node) {
+  return absl::StartsWith(node.name(), recomputation_targets_name_scope) ||
+         static_cast<int>(
+             node.name().find("/" + recomputation_targets_name_scope)) != -1;
+}
+
+// Duplicates the groups of `recomputed_subgraphs` and feeds their target nodes
+// from the copies.
+void RecomputeSubgraphs(
+    const std::vector<RecomputedSubGraph>& recomputed_subgraphs,
+    const NodeMap& node_map, GraphDef* graph) {
+  std::unordered_map<const NodeDef*, int> topological_numbering;
+  for (int node_number = 0; node_number < graph->node().size();
+       ++node_number) {
+    topological_numbering[graph->mutable_node(node_number)] =
+        graph->node().size() - node_number - 1;
+  }
+  // Duplicate the indicated sub-graphs and set up control dependencies
+  for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
+    RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
+                      node_map, topological_numbering, graph);
+  }
+}
+
 void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
                                 const string& recomputation_targets_name_scope,
                                 GraphDef* graph, const GrapplerItem& item) {
@@ -461,15 +495,7 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
   }
   std::function<bool(const NodeDef&)> is_target =
       [&recomputation_targets_name_scope](const NodeDef& node) {
-        // Nodes whose inputs we may want to recompute. This matches node names
-        // that contain recomputation_targets_name_scope as a name scope,
-        // meaning it either begins with or contains the name scope.
-        // Defaults to "gradients/" which will match any node names that begins
-        // with "gradients/" or contains "/gradients/".
-        return absl::StartsWith(node.name(),
-                                recomputation_targets_name_scope) ||
-               static_cast<int>(node.name().find(
-                   "/" + recomputation_targets_name_scope)) != -1;
+        return IsRecomputationTarget(recomputation_targets_name_scope, node);
       };
 
   if (optimization_level == RewriterConfig::RECOMPUTATION_HEURISTICS ||
@@ -498,20 +524,192 @@ void RecomputationRewritingPass(RewriterConfig::MemOptType optimization_level,
         is_target);
   }
   if (!recomputed_subgraphs.empty()) {
-    std::unordered_map<const NodeDef*, int> topological_numbering;
-    for (int node_number = 0; node_number < graph->node().size();
-         ++node_number) {
-      topological_numbering[graph->mutable_node(node_number)] =
-          graph->node().size() - node_number - 1;
+    RecomputeSubgraphs(recomputed_subgraphs, node_map, graph);
+  }
+}
+
+// Maximum number of times the cost based recomputation pass re-estimates the
+// peak memory usage and picks more activations to recompute.
+constexpr int kMaxCostBasedRecomputationRounds = 8;
+
+// Logs the predicted peak memory usage of the devices, before and after the
+// recomputation. At VLOG(1), also runs the optimized graph on the cluster to
+// log the measured peak memory usage next to the prediction.
+void ReportRecomputationPeakMemory(
+    Cluster* cluster, const GrapplerItem& item,
+    const std::unordered_map<string, int64_t>& initial_peaks,
+    const std::unordered_map<string, int64_t>& final_peaks,
+    int64_t budget_bytes) {
+  std::unique_ptr<GraphMemory> measured;
+  if (VLOG_IS_ON(1)) {
+    measured = std::make_unique<GraphMemory>(item);
+    Status s = measured->InferDynamically(cluster);
+    if (!s.ok()) {
+      VLOG(1) << "Failed to measure memory usage: " << s.message();
+      measured.reset();
     }
-    // Duplicate the indicated sub-graphs and set up control dependencies
-    for (const RecomputedSubGraph& subgraph : recomputed_subgraphs) {
-      RecomputeSubgraph(subgraph.recomputed_source_nodes, subgraph.target_nodes,
-                        node_map, topological_numbering, graph);
+  }
+  for (const auto& device : final_peaks) {
+    auto it = initial_peaks.find(device.first);
+    LOG(INFO) << "Recomputation on " << device.first
+              << ": predicted peak memory "
+              << (it == initial_peaks.end() ? -1 : it->second) << " -> "
+              << device.second << " bytes (budget " << budget_bytes << ")";
+    if (measured != nullptr) {
+      VLOG(1) << "Measured peak memory on " << device.first << ": "
+              << measured->GetPeakMemoryUsage(device.first).used_memory
+              << " bytes";
     }
   }
 }
 
+// Recomputes forward activations in the backward pass until the predicted
+// peak memory usage of every device of `cluster` fits in `budget_bytes`.
+// Among the activations live at the peak of a device, the pass picks the ones
+// with the most bytes per nanosecond of recomputation, as estimated by the
+// OpLevelCostEstimator. Returns true if the graph changed.
+bool CostBasedRecomputationPass(Cluster* cluster, int64_t budget_bytes,
+                                const string& recomputation_targets_name_scope,
+                                GrapplerItem* item) {
+  std::unordered_set<string> feeds;
+  for (const auto& feed : item->feed) {
+    feeds.insert(NodeName(feed.first));
+  }
+  const string recomputed_prefix = strings::StrCat(kRecomputedNodePrefix, "/");
+  std::function<bool(const NodeDef&)> is_target =
+      [&recomputation_targets_name_scope](const NodeDef& node) {
+        return IsRecomputationTarget(recomputation_targets_name_scope, node);
+      };
+  std::function<bool(const NodeDef&)> is_candidate =
+      [&](const NodeDef& node) {
+        return !is_target(node) && feeds.count(node.name()) == 0 &&
+               !absl::StartsWith(node.name(), recomputed_prefix) &&
+               IsFreeOfSideEffect(node);
+      };
+  const VirtualPlacer placer(cluster->GetDevices());
+  OpLevelCostEstimator estimator;
+
+  std::unordered_map<string, int64_t> initial_peaks;
+  std::unordered_map<string, int64_t> peaks;
+  bool updated_graph = false;
+  for (int round = 0;; ++round) {
+    GraphMemory memory(*item);
+    Status s = memory.InferStatically(cluster->GetDevices());
+    if (!s.ok()) {
+      VLOG(1) << "Failed to infer memory usage: " << s.message();
+      break;
+    }
+    // Bytes of activations to stop keeping alive, by device.
+    std::unordered_map<string, int64_t> excess_bytes;
+    for (const auto& device : cluster->GetDevices()) {
+      const GraphMemory::MemoryUsage& usage =
+          memory.GetPeakMemoryUsage(device.first);
+      if (usage.used_memory < 0) continue;
+      peaks[device.first] = usage.used_memory;
+      if (usage.used_memory > budget_bytes) {
+        excess_bytes[device.first] = usage.used_memory - budget_bytes;
+      }
+    }
+    if (round == 0) initial_peaks = peaks;
+    if (excess_bytes.empty() || round == kMaxCostBasedRecomputationRounds) {
+      break;
+    }
+
+    NodeMap node_map(&item->graph);
+    const std::unordered_set<const NodeDef*> candidates =
+        FindCandidateRecomputeNodes(node_map, &item->graph, is_candidate,
+                                    is_target);
+    GraphProperties properties(*item);
+    s = properties.InferStatically(/*assume_valid_feeds=*/false,
+                                   /*aggressive_shape_inference=*/false,
+                                   /*include_tensor_values=*/false);
+    if (!s.ok()) {
+      VLOG(1) << "Failed to infer shapes: " << s.message();
+      break;
+    }
+    std::unordered_map<string, const NodeDef*> name_to_node;
+    for (const NodeDef& node : item->graph.node()) {
+      name_to_node[node.name()] = &node;
+    }
+    const auto recompute_cost = [&](const NodeDef& node) -> int64_t {
+      OpContext op_context;
+      op_context.name = node.name();
+      op_context.device_name = node.device();
+      op_context.op_info = BuildOpInfoWithoutDevice(
+          node, name_to_node, properties.GetInputProperties(node.name()));
+      for (const auto& output : properties.GetOutputProperties(node.name())) {
+        *op_context.op_info.add_outputs() = output;
+      }
+      *op_context.op_info.mutable_device() = placer.get_device(node);
+      return std::max<int64_t>(
+          estimator.PredictCosts(op_context).execution_time.count(), 1);
+    };
+
+    // Collects the activations live at the peak of the devices over budget.
+    struct Activation {
+      const NodeDef* node;
+      string device;
+      int64_t bytes = 0;
+      double bytes_per_ns = 0;
+    };
+    std::vector<Activation> activations;
+    for (const auto& device : excess_bytes) {
+      std::unordered_map<const NodeDef*, int64_t> live_bytes;
+      for (const auto& live :
+           memory.GetPeakMemoryUsage(device.first).live_tensors) {
+        const NodeDef* node = node_map.GetNode(live.node);
+        if (node != nullptr && candidates.count(node) > 0) {
+          live_bytes[node] += live.memory_used;
+        }
+      }
+      for (const auto& live : live_bytes) {
+        activations.push_back({live.first, device.first, live.second,
+                               static_cast<double>(live.second) /
+                                   recompute_cost(*live.first)});
+      }
+    }
+    std::sort(activations.begin(), activations.end(),
+              [](const Activation& a, const Activation& b) {
+                return a.bytes_per_ns > b.bytes_per_ns ||
+                       (a.bytes_per_ns == b.bytes_per_ns &&
+                        a.node->name() < b.node->name());
+              });
+    std::unordered_set<string> recomputed_node_names;
+    for (const Activation& activation : activations) {
+      int64_t& excess = excess_bytes[activation.device];
+      if (excess <= 0) continue;
+      excess -= activation.bytes;
+      recomputed_node_names.insert(activation.node->name());
+      VLOG(2) << "Recomputing " << activation.node->name() << ": "
+              << activation.bytes << " bytes, " << activation.bytes_per_ns
+              << " bytes/ns";
+    }
+    if (recomputed_node_names.empty()) break;
+
+    // The topological numbering of RecomputeSubgraphs relies on a sorted
+    // graph. Sorting invalidates the NodeDef pointers, so the node map is
+    // rebuilt.
+    TF_CHECK_OK(TopologicalSort(&item->graph));
+    NodeMap sorted_node_map(&item->graph);
+    std::vector<RecomputedSubGraph> recomputed_subgraphs =
+        GetOpGroupsToRecompute(
+            &item->graph, sorted_node_map,
+            [&](const NodeDef& node) {
+              return recomputed_node_names.count(node.name()) > 0;
+            },
+            is_target);
+    if (recomputed_subgraphs.empty()) break;
+    RecomputeSubgraphs(recomputed_subgraphs, sorted_node_map, &item->graph);
+    updated_graph = true;
+  }
+
+  if (updated_graph) {
+    ReportRecomputationPeakMemory(cluster, *item, initial_peaks, peaks,
+                                  budget_bytes);
+  }
+  return updated_graph;
+}
+
 bool SchedulingPass(Cluster* cluster, std::unique_ptr<GraphMemory>* memory_ptr,
                     GrapplerItem* item) {
   // Look for AddN nodes (and equivalent) and record input names.
@@ -1395,9 +1593,21 @@ Status MemoryOptimizer::Optimize(Cluster* cluster, const GrapplerItem& item,
   RelaxAssignNodes(nodes_to_relax, &optimized_item.graph);
 
   if (run_recomputation_pass) {
-    RecomputationRewritingPass(optimization_level_,
-                               recomputation_targets_name_scope_,
-                               &optimized_item.graph, item);
+    if (recomputation_budget_bytes_ > 0 &&
+        optimization_level_ != RewriterConfig::MANUAL && cluster != nullptr &&
+        !item.fetch.empty()) {
+      // Annotated nodes are still recomputed, the budget picks the others.
+      RecomputationRewritingPass(RewriterConfig::MANUAL,
+                                 recomputation_targets_name_scope_,
+                                 &optimized_item.graph, item);
+      CostBasedRecomputationPass(cluster, recomputation_budget_bytes_,
+                                 recomputation_targets_name_scope_,
+                                 &optimized_item);
+    } else {
+      RecomputationRewritingPass(optimization_level_,
+                                 recomputation_targets_name_scope_,
+                                 &optimized_item.graph, item);
+    }
   }
 
   std::unordered_set<string> skip_list;
@@ -448,6 +448,60 @@ TEST_F(MemoryOptimizerTest, AccumulationRewrites) {
   }
 }
 
+TEST_F(MemoryOptimizerTest, CostBasedRecomputationUnderBudget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output c = ops::Const(s.WithOpName("c"), 1.0f, {256, 256});
+  Output mm = ops::MatMul(s.WithOpName("mm"), c, c);
+  Output relu = ops::Relu(s.WithOpName("relu"), mm);
+  Output g = ops::AddN(s.WithOpName("gradients/g"), {mm, relu});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/g"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                            "gradients/",
+                            /*recomputation_budget_bytes=*/int64_t{1} << 40);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+  EXPECT_EQ(item.graph.node_size(), output.node_size());
+}
+
+TEST_F(MemoryOptimizerTest, CostBasedRecomputationOverBudget) {
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope().WithDevice("/cpu:0");
+  Output c = ops::Const(s.WithOpName("c"), 1.0f, {256, 256});
+  Output mm = ops::MatMul(s.WithOpName("mm"), c, c);
+  Output relu = ops::Relu(s.WithOpName("relu"), mm);
+  Output g = ops::AddN(s.WithOpName("gradients/g"), {mm, relu});
+
+  GrapplerItem item;
+  TF_CHECK_OK(s.ToGraphDef(&item.graph));
+  item.fetch = {"gradients/g"};
+
+  std::unique_ptr<VirtualCluster> cluster(CreateVirtualCluster());
+  MemoryOptimizer optimizer(RewriterConfig::RECOMPUTATION_HEURISTICS,
+                            "gradients/",
+                            /*recomputation_budget_bytes=*/1);
+  GraphDef output;
+  TF_EXPECT_OK(optimizer.Optimize(cluster.get(), item, &output));
+
+  // The two activations have the same size, and the relu is much cheaper to
+  // recompute than the matmul, so it is picked first.
+  NodeMap node_map(&output);
+  const NodeDef* recomputed_relu = node_map.GetNode("Recomputed/relu");
+  ASSERT_NE(recomputed_relu, nullptr);
+  EXPECT_EQ("Relu", recomputed_relu->op());
+  const NodeDef* new_g = node_map.GetNode("gradients/g");
+  ASSERT_NE(new_g, nullptr);
+  EXPECT_EQ("Recomputed/relu", new_g->input(1));
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch);
+  auto tensors = EvaluateNodes(output, item.fetch);
+  ASSERT_EQ(1, tensors.size());
+  test::ExpectTensorEqual<float>(tensors_expected[0], tensors[0]);
+}
+
 class RelaxAllocatorConstraintsTest : public GrapplerTest {};
 
 TEST_F(RelaxAllocatorConstraintsTest, SameDevice) {
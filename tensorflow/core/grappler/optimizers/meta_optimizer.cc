@@ -473,13 +473,15 @@ Status MetaOptimizer::InitializeOptimizers(
                              xla_auto_clustering_on_) &&
       PLUGIN_NOT_OFF(memory_optimization)) {
     if (cfg_.memory_optimizer_target_node_name_scope().empty()) {
-      optimizers->push_back(
+      optimizers->push_back(std::make_unique<MemoryOptimizer>(
+          cfg_.memory_optimization(),
           // Use the default target node name prefix "gradients/"
-          std::make_unique<MemoryOptimizer>(cfg_.memory_optimization()));
+          "gradients/", cfg_.memory_optimizer_recomputation_budget_bytes()));
     } else {
       optimizers->push_back(std::make_unique<MemoryOptimizer>(
           cfg_.memory_optimization(),
-          cfg_.memory_optimizer_target_node_name_scope()));
+          cfg_.memory_optimizer_target_node_name_scope(),
+          cfg_.memory_optimizer_recomputation_budget_bytes()));
     }
   }
   if (cfg_.auto_parallel().enable() && PLUGIN_IS_ON(auto_parallel)) {
@@ -24,7 +24,10 @@ limitations under the License.
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "tensorflow/core/framework/tensor_shape.h"
 #include "tensorflow/core/framework/versions.pb.h"
 #include "tensorflow/core/grappler/costs/graph_properties.h"
@@ -74,6 +77,11 @@ namespace grappler {
 //
 // Sigmoid + Mul -> _MklSwish  // This fusion only works on Intel CPU.
 //
+// Elementwise ops -> _FusedElementwise  // This fusion only works on CPU.
+//   (1) Mul + AddV2 + Tanh + ..., and other groups of elementwise ops whose
+//       arguments are scalars or broadcast over the innermost dimensions.
+//       Enabled with TF_ENABLE_FUSED_ELEMENTWISE=1.
+//
 //
 // In all cases, the supported activation functions are Relu, Relu6, and Elu.
 //
@@ -92,6 +100,8 @@ constexpr char kFusedDepthwiseConv2dNative[] = "_FusedDepthwiseConv2dNative";
 constexpr char kFusedBatchNormEx[] = "_FusedBatchNormEx";
 constexpr char kFusedBatchNormGradEx[] = "_FusedBatchNormGradEx";
 constexpr char kTensorToHashBucket[] = "_TensorToHashBucketFast";
+constexpr char kFusedElementwise[] = "_FusedElementwise";
+constexpr char kUnaryOpsComposition[] = "_UnaryOpsComposition";
 constexpr char kLeakyRelu[] = "LeakyRelu";
 constexpr char kMklFusedMish[] = "_MklFusedMish";
 constexpr char kRelu[] = "Relu";
@@ -106,6 +116,9 @@ constexpr char kFill[] = "fill";
 
 constexpr int kMissingIndex = -1;
 
+// Maximum number of nodes fused into a _FusedElementwise node.
+constexpr int kMaxFusedElementwiseNodes = 32;
+
 struct RemapperContext {
   explicit RemapperContext(GrapplerItem* item, Status* status,
                            RewriterConfig::CpuLayout cpu_layout_conversion,
@@ -301,6 +314,19 @@ struct ContractionWithBiasAndAddActivation {
   int bias_port = 1;
 };
 
+// Elementwise ops whose outputs all have the shape of the root output.
+struct FusedElementwise {
+  int root = kMissingIndex;
+  // Nodes fused into the root.
+  std::vector<int> fused;
+  // Tensors read by the fused ops and computed by other nodes.
+  std::vector<string> args;
+  // Fused ops in topological order, and their operands in the encoding of the
+  // `_FusedElementwise` attributes.
+  std::vector<string> ops;
+  std::vector<int> operands;
+};
+
 bool IsInPreserveSet(const RemapperContext& ctx, const NodeDef* node) {
   return ctx.nodes_to_preserve.count(node->name()) > 0;
 }
@@ -388,6 +414,18 @@ bool BlasLtMatmulEnabled() {
   return is_enabled;
 }
 
+// The _FusedElementwise rewrite is off by default until it has been proven on
+// more models. Set TF_ENABLE_FUSED_ELEMENTWISE=1 to enable it.
+bool FusedElementwiseEnabled() {
+  static bool is_enabled = [] {
+    bool is_enabled = false;
+    TF_CHECK_OK(tensorflow::ReadBoolFromEnvVar(
+        "TF_ENABLE_FUSED_ELEMENTWISE", /*default_val=*/false, &is_enabled));
+    return is_enabled;
+  }();
+  return is_enabled;
+}
+
 bool IsGpuCompatibleDataFormat(const RemapperContext& ctx,
                                const NodeDef* conv2d) {
   DCHECK(IsConv2D(*conv2d)) << "Expected Conv2D op";
@@ -4706,6 +4744,264 @@ Status ReplaceSoftplusTanhAndMulWithMish(
   return absl::OkStatus();
 }
 
+// Returns the number of inputs of `node` if the _FusedElementwise kernel
+// supports it, or 0 otherwise. The _UnaryOpsComposition nodes created by the
+// arithmetic optimizer are fused as the sequence of their ops.
+// WARN: This should be consistent with fused_elementwise_op.cc.
+int NumFusedElementwiseInputs(const NodeDef& node) {
+  // clang-format off
+  static const auto* const kNumInputs = new absl::flat_hash_map<string, int>({
+      {"Abs",               1},
+      {"Ceil",              1},
+      {"Exp",               1},
+      {"Expm1",             1},
+      {"Floor",             1},
+      {"Inv",               1},
+      {"Log",               1},
+      {"Log1p",             1},
+      {"Neg",               1},
+      {"Reciprocal",        1},
+      {"Rsqrt",             1},
+      {"Sigmoid",           1},
+      {"Sqrt",              1},
+      {"Square",            1},
+      {"Tanh",              1},
+      {"Relu",              1},
+      {"Relu6",             1},
+      {"Add",               2},
+      {"AddV2",             2},
+      {"Div",               2},
+      {"Maximum",           2},
+      {"Minimum",           2},
+      {"Mul",               2},
+      {"RealDiv",           2},
+      {"SquaredDifference", 2},
+      {"Sub",               2},
+  });
+  // clang-format on
+  if (node.op() == kUnaryOpsComposition) {
+    std::vector<string> op_names;
+    if (!TryGetNodeAttr(node, "op_names", &op_names) || op_names.empty()) {
+      return 0;
+    }
+    for (const string& op_name : op_names) {
+      auto it = kNumInputs->find(op_name);
+      if (it == kNumInputs->end() || it->second != 1) return 0;
+    }
+    return 1;
+  }
+  auto it = kNumInputs->find(node.op());
+  return it == kNumInputs->end() ? 0 : it->second;
+}
+
+// Returns true if the _FusedElementwise kernel broadcasts an argument of shape
+// `arg` to `shape`: the argument has the same shape, a single element, or the
+// innermost dimensions of `shape`.
+bool IsFusedElementwiseArgShape(const TensorShapeProto& arg,
+                                const TensorShapeProto& shape) {
+  if (ShapesSymbolicallyEqual(arg, shape)) return true;
+  if (arg.unknown_rank() || shape.unknown_rank() ||
+      arg.dim_size() > shape.dim_size()) {
+    return false;
+  }
+  if (NumCoefficients(arg) == 1) return true;
+  const int offset = shape.dim_size() - arg.dim_size();
+  for (int i = 0; i < arg.dim_size(); ++i) {
+    if (IsUnknown(arg.dim(i)) ||
+        arg.dim(i).size() != shape.dim(offset + i).size()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Finds the largest group of elementwise ops computed by the root node and
+// the nodes it reads from, directly or not, that a _FusedElementwise node can
+// compute in a single pass over memory.
+//
+// Fanins join the group from the last one in topological order, so that a
+// fanin joins only once all its consumers did: the group never reads a value
+// that it also computes, and only the root has consumers outside of it. All
+// the fused nodes have the shape of the root output, so that the fused node
+// computes them over the same elements.
+bool FindFusedElementwise(const RemapperContext& ctx, int node_index,
+                          FusedElementwise* matched) {
+  const auto* root_view = ctx.graph_view.GetNode(node_index);
+  const auto* root = root_view->node();
+  const DataType dtype = GetDataTypeFromAttr(*root, "T");
+  if (dtype != DT_FLOAT && dtype != DT_DOUBLE) return false;
+  if (NumFusedElementwiseInputs(*root) == 0 || !NodeIsOnCpu(root)) {
+    return false;
+  }
+  const GraphProperties& properties = ctx.graph_properties;
+  if (!properties.HasOutputProperties(root->name())) return false;
+  const TensorShapeProto& shape =
+      properties.GetOutputProperties(root->name())[0].shape();
+  if (shape.unknown_rank()) return false;
+
+  // Returns the shape of the tensor read by `fanin`, or nullptr if unknown.
+  const auto get_fanin_shape =
+      [&](const utils::MutableFanoutView& fanin) -> const TensorShapeProto* {
+    const string& name = fanin.node_view()->GetName();
+    if (!properties.HasOutputProperties(name)) return nullptr;
+    const auto& outputs = properties.GetOutputProperties(name);
+    if (fanin.index() < 0 || fanin.index() >= outputs.size()) {
+      return nullptr;
+    }
+    return &outputs[fanin.index()].shape();
+  };
+
+  const auto is_fusible = [&](const utils::MutableNodeView& node_view) {
+    const auto* node = node_view.node();
+    const int num_inputs = NumFusedElementwiseInputs(*node);
+    if (num_inputs == 0 || num_inputs != node_view.NumRegularFanins() ||
+        GetDataTypeFromAttr(*node, "T") != dtype ||
+        node->device() != root->device()) {
+      return false;
+    }
+    for (const auto& fanin : node_view.GetRegularFanins()) {
+      const TensorShapeProto* fanin_shape = get_fanin_shape(fanin);
+      if (fanin_shape == nullptr ||
+          !IsFusedElementwiseArgShape(*fanin_shape, shape)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  if (!is_fusible(*root_view)) return false;
+
+  absl::flat_hash_set<int> fused = {node_index};
+  std::set<int, std::greater<int>> candidates;
+  for (const auto& fanin : root_view->GetRegularFanins()) {
+    candidates.insert(fanin.node_index());
+  }
+  while (!candidates.empty() && fused.size() < kMaxFusedElementwiseNodes) {
+    const int index = *candidates.begin();
+    candidates.erase(candidates.begin());
+    const auto* node_view = ctx.graph_view.GetNode(index);
+    const auto* node = node_view->node();
+    if (IsInPreserveSet(ctx, node) || HasControlFaninOrFanout(*node_view) ||
+        !is_fusible(*node_view) ||
+        !properties.HasOutputProperties(node->name()) ||
+        !ShapesSymbolicallyEqual(
+            properties.GetOutputProperties(node->name())[0].shape(), shape)) {
+      continue;
+    }
+    bool has_other_consumers = false;
+    for (const auto& fanouts : node_view->GetRegularFanouts()) {
+      for (const auto& fanout : fanouts) {
+        if (!fused.contains(fanout.node_index())) has_other_consumers = true;
+      }
+    }
+    if (has_other_consumers) continue;
+
+    fused.insert(index);
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      candidates.insert(fanin.node_index());
+    }
+  }
+  if (fused.size() < 2) return false;
+
+  // Node indices are in topological order.
+  std::vector<int> nodes(fused.begin(), fused.end());
+  std::sort(nodes.begin(), nodes.end());
+
+  matched->root = node_index;
+  matched->fused.clear();
+  matched->args.clear();
+  matched->ops.clear();
+  matched->operands.clear();
+  absl::flat_hash_map<string, int> arg_indices;
+  bool has_output_shape = false;
+  for (int index : nodes) {
+    const auto* node_view = ctx.graph_view.GetNode(index);
+    for (int i = 0; i < node_view->NumRegularFanins(); ++i) {
+      const auto& fanin = node_view->GetRegularFanin(i);
+      if (fused.contains(fanin.node_index())) continue;
+      const string tensor =
+          absl::StrCat(fanin.node_view()->GetName(), ":", fanin.index());
+      if (arg_indices.emplace(tensor, matched->args.size()).second) {
+        matched->args.push_back(node_view->node()->input(i));
+        has_output_shape |=
+            ShapesSymbolicallyEqual(*get_fanin_shape(fanin), shape);
+      }
+    }
+  }
+  // The kernel computes the shape of its output from its arguments.
+  if (!has_output_shape) return false;
+
+  const int num_args = matched->args.size();
+  absl::flat_hash_map<int, int> results;
+  for (int index : nodes) {
+    const auto* node_view = ctx.graph_view.GetNode(index);
+    const auto* node = node_view->node();
+    std::vector<int> operands;
+    for (const auto& fanin : node_view->GetRegularFanins()) {
+      auto it = results.find(fanin.node_index());
+      operands.push_back(it != results.end()
+                             ? it->second
+                             : arg_indices.at(absl::StrCat(
+                                   fanin.node_view()->GetName(), ":",
+                                   fanin.index())));
+    }
+    if (node->op() == kUnaryOpsComposition) {
+      std::vector<string> op_names;
+      TryGetNodeAttr(*node, "op_names", &op_names);
+      for (const string& op_name : op_names) {
+        matched->ops.push_back(op_name);
+        matched->operands.push_back(operands[0]);
+        operands[0] = num_args + matched->ops.size() - 1;
+      }
+    } else {
+      matched->ops.push_back(node->op());
+      matched->operands.insert(matched->operands.end(), operands.begin(),
+                               operands.end());
+    }
+    results[index] = num_args + matched->ops.size() - 1;
+    if (index != node_index) matched->fused.push_back(index);
+  }
+  return true;
+}
+
+Status AddFusedElementwiseNode(RemapperContext* ctx,
+                               const FusedElementwise& matched,
+                               std::vector<bool>* invalidated_nodes,
+                               std::vector<bool>* nodes_to_delete) {
+  const GraphDef* graph = ctx->graph_view.graph();
+  const NodeDef& root = graph->node(matched.root);
+  VLOG(2) << "Fuse elementwise ops: root=" << root.name() << " fused_ops=["
+          << absl::StrJoin(matched.ops, ", ") << "] on device="
+          << root.device();
+
+  NodeDef fused_op;
+  fused_op.set_name(root.name());
+  fused_op.set_op(kFusedElementwise);
+  fused_op.set_device(root.device());
+  for (const string& arg : matched.args) fused_op.add_input(arg);
+  for (const string& input : root.input()) {
+    if (IsControlInput(input)) fused_op.add_input(input);
+  }
+
+  auto* attr = fused_op.mutable_attr();
+  (*attr)["T"] = root.attr().at("T");
+  SetAttrValue(static_cast<int>(matched.args.size()), &(*attr)["num_args"]);
+  SetAttrValue(matched.ops, &(*attr)["fused_ops"]);
+  SetAttrValue(matched.operands, &(*attr)["fused_operands"]);
+
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  Status status;
+  mutation->AddNode(std::move(fused_op), &status);
+  TF_RETURN_IF_ERROR(status);
+  TF_RETURN_IF_ERROR(mutation->Apply());
+
+  (*invalidated_nodes)[matched.root] = true;
+  for (int index : matched.fused) {
+    (*nodes_to_delete)[index] = true;
+  }
+
+  return absl::OkStatus();
+}
+
 // Check if a node is a candidate to one of the patterns that require inferred
 // shapes:
 //   (1) Splitting FusedBatchNorm into primitives.
@@ -4863,6 +5159,18 @@ bool RequiresInferredShapes(const RemapperContext& ctx, int node_index,
          is_act_biasadd_matmul_candidate();
 }
 
+// Removes the nodes marked in `nodes_to_delete`.
+Status RemoveNodes(RemapperContext* ctx,
+                   const std::vector<bool>& nodes_to_delete) {
+  utils::Mutation* mutation = ctx->graph_view.GetMutationBuilder();
+  for (int i = 0; i < nodes_to_delete.size(); ++i) {
+    if (nodes_to_delete[i]) {
+      mutation->RemoveNode(ctx->graph_view.GetNode(i));
+    }
+  }
+  return mutation->Apply();
+}
+
 inline bool IsXlaCpuGlobalJitOn() {
   std::vector<string> tf_xla_flags;
   const std::string tf_xla_cpu_global_jit = "--tf_xla_cpu_global_jit";
@@ -4901,22 +5209,27 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   bool allow_non_differentiable_rewrites =
       item.optimization_options().allow_non_differentiable_rewrites;
 
+  // Infer properties lazily in case they are not needed.
+  const auto infer_graph_properties = [&]() -> Status {
+    if (ctx.inferred_graph_properties) return absl::OkStatus();
+    const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
+    TF_RETURN_IF_ERROR(ctx.graph_properties.InferStatically(
+        assume_valid_feeds,
+        /*aggressive_shape_inference=*/false,
+        /*include_input_tensor_values=*/true,
+        /*include_output_tensor_values=*/false));
+    ctx.inferred_graph_properties = true;
+    return absl::OkStatus();
+  };
+
   for (int i = num_nodes - 1; i >= 0; --i) {
     // Check if node was invalidated by one of the previous remaps.
     if (invalidated_nodes[i] || nodes_to_delete[i]) {
       continue;
     }
 
-    // Infer properties lazily in case they are not needed.
-    if (!ctx.inferred_graph_properties &&
-        RequiresInferredShapes(ctx, i, cluster)) {
-      const bool assume_valid_feeds = opt_level_ == RewriterConfig::AGGRESSIVE;
-      TF_RETURN_IF_ERROR(ctx.graph_properties.InferStatically(
-          assume_valid_feeds,
-          /*aggressive_shape_inference=*/false,
-          /*include_input_tensor_values=*/true,
-          /*include_output_tensor_values=*/false));
-      ctx.inferred_graph_properties = true;
+    if (RequiresInferredShapes(ctx, i, cluster)) {
+      TF_RETURN_IF_ERROR(infer_graph_properties());
     }
 
     ContractionWithBiasAddAndAdd contract_with_bias_and_add;
@@ -5233,13 +5546,39 @@ Status Remapper::Optimize(Cluster* cluster, const GrapplerItem& item,
   }
 
   // Remove invalidated nodes.
-  utils::Mutation* mutation = ctx.graph_view.GetMutationBuilder();
-  for (int i = 0; i < num_nodes; ++i) {
-    if (nodes_to_delete[i]) {
-      mutation->RemoveNode(ctx.graph_view.GetNode(i));
+  TF_RETURN_IF_ERROR(RemoveNodes(&ctx, nodes_to_delete));
+
+  // Fuse the groups of elementwise ops left by the fusions above, which only
+  // fuse elementwise ops into specific patterns. oneDNN builds leave the
+  // elementwise ops to the oneDNN layout pass instead.
+  if (FusedElementwiseEnabled() && allow_non_differentiable_rewrites &&
+      !IsMKLEnabled() && !ctx.xla_cpu_jit_disable_fusion) {
+    TF_RETURN_IF_ERROR(
+        ctx.graph_view.SortTopologically(/*ignore_cycles=*/false, {}));
+    // Properties inferred above describe the graph before the remaps, so
+    // infer them again to see the shapes of the nodes the remaps created.
+    if (ctx.inferred_graph_properties) {
+      ctx.graph_properties.Clear();
+      ctx.inferred_graph_properties = false;
+    }
+    const int num_remaining_nodes = ctx.graph_view.NumNodes();
+    std::vector<bool> fused_roots(num_remaining_nodes);
+    std::vector<bool> fused_nodes(num_remaining_nodes);
+    for (int i = num_remaining_nodes - 1; i >= 0; --i) {
+      if (fused_roots[i] || fused_nodes[i]) continue;
+      const NodeDef* node = ctx.graph_view.GetNode(i)->node();
+      if (NumFusedElementwiseInputs(*node) == 0 || !NodeIsOnCpu(node)) {
+        continue;
+      }
+      TF_RETURN_IF_ERROR(infer_graph_properties());
+      FusedElementwise fused_elementwise;
+      if (FindFusedElementwise(ctx, i, &fused_elementwise)) {
+        TF_RETURN_IF_ERROR(AddFusedElementwiseNode(
+            &ctx, fused_elementwise, &fused_roots, &fused_nodes));
+      }
     }
+    TF_RETURN_IF_ERROR(RemoveNodes(&ctx, fused_nodes));
   }
-  TF_RETURN_IF_ERROR(mutation->Apply());
 
   *optimized_graph = std::move(mutable_item.graph);
 
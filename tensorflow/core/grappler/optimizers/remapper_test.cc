@@ -42,6 +42,8 @@ class RemapperTest : public GrapplerTest {
     setenv("TF_USE_CUDNN_BATCHNORM_SPATIAL_PERSISTENT", "1", 1 /* replace */);
     // This is a requirement for fusing FusedMatmul + BiasAdd (+ Activation).
     setenv("TF_USE_CUBLASLT", "1", 1 /* replace */);
+    // This is a requirement for fusing chains of elementwise ops.
+    setenv("TF_ENABLE_FUSED_ELEMENTWISE", "1", 1 /* replace */);
   }
 };
 
@@ -1767,6 +1769,141 @@ TEST_F(RemapperTensorToHashBucketTest, I32) { RunTest<DT_INT32>(); }
 
 TEST_F(RemapperTensorToHashBucketTest, I64) { RunTest<DT_INT64>(); }
 
+TEST_F(RemapperTest, FuseElementwiseOps) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Fusion not available with oneDNN.";
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x_shape = ops::Placeholder::Shape({8, 32});
+  auto channel_shape = ops::Placeholder::Shape({32});
+
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT, x_shape);
+  auto scale = Placeholder(s.WithOpName("scale"), DT_FLOAT, channel_shape);
+  auto bias = Placeholder(s.WithOpName("bias"), DT_FLOAT, channel_shape);
+
+  auto mul = ops::Mul(s.WithOpName("mul"), x, scale);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, bias);
+  auto tanh = ops::Tanh(s.WithOpName("tanh"), add);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), tanh);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto scale_t = GenerateRandomTensor<DT_FLOAT>({32});
+  auto bias_t = GenerateRandomTensor<DT_FLOAT>({32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch"};
+  item.feed = {{"x", x_t}, {"scale", scale_t}, {"bias", bias_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "mul");
+    EXPECT_NE(node.name(), "add");
+    if (node.name() == "tanh") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "x");
+      EXPECT_EQ(node.input(1), "scale");
+      EXPECT_EQ(node.input(2), "bias");
+      EXPECT_EQ(node.attr().at("num_args").i(), 3);
+
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 3);
+      EXPECT_EQ(fused_ops[0], "Mul");
+      EXPECT_EQ(fused_ops[1], "AddV2");
+      EXPECT_EQ(fused_ops[2], "Tanh");
+
+      const auto fused_operands = node.attr().at("fused_operands").list().i();
+      ASSERT_EQ(fused_operands.size(), 5);
+      EXPECT_EQ(fused_operands[0], 0);
+      EXPECT_EQ(fused_operands[1], 1);
+      EXPECT_EQ(fused_operands[2], 3);
+      EXPECT_EQ(fused_operands[3], 2);
+      EXPECT_EQ(fused_operands[4], 4);
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 1);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 1);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 1);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+}
+
+TEST_F(RemapperTest, FuseElementwiseOpsWithSharedIntermediate) {
+  if (IsMKLEnabled()) GTEST_SKIP() << "Fusion not available with oneDNN.";
+  using ::tensorflow::ops::Placeholder;
+  tensorflow::Scope s = tensorflow::Scope::NewRootScope();
+
+  auto x_shape = ops::Placeholder::Shape({8, 32});
+  auto x = Placeholder(s.WithOpName("x"), DT_FLOAT, x_shape);
+  auto y = Placeholder(s.WithOpName("y"), DT_FLOAT, x_shape);
+
+  // "mul" is also fetched, so it must stay a separate node.
+  auto mul = ops::Mul(s.WithOpName("mul"), x, y);
+  auto add = ops::AddV2(s.WithOpName("add"), mul, x);
+  auto sub = ops::Sub(s.WithOpName("sub"), mul, y);
+  auto max = ops::Maximum(s.WithOpName("max"), add, sub);
+  auto fetch = ops::Identity(s.WithOpName("fetch"), max);
+  auto mul_fetch = ops::Identity(s.WithOpName("mul_fetch"), mul);
+
+  auto x_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+  auto y_t = GenerateRandomTensor<DT_FLOAT>({8, 32});
+
+  GrapplerItem item;
+  item.fetch = {"fetch", "mul_fetch"};
+  item.feed = {{"x", x_t}, {"y", y_t}};
+  TF_ASSERT_OK(s.ToGraphDef(&item.graph));
+
+  // Place all nodes on CPU.
+  for (int i = 0; i < item.graph.node_size(); ++i) {
+    item.graph.mutable_node(i)->set_device("/device:CPU:0");
+  }
+
+  Remapper optimizer(RewriterConfig::ON);
+  GraphDef output;
+  TF_ASSERT_OK(optimizer.Optimize(nullptr, item, &output));
+
+  int found = 0;
+  for (const NodeDef& node : output.node()) {
+    EXPECT_NE(node.name(), "add");
+    EXPECT_NE(node.name(), "sub");
+    if (node.name() == "max") {
+      EXPECT_EQ(node.op(), "_FusedElementwise");
+      ASSERT_EQ(node.input_size(), 3);
+      EXPECT_EQ(node.input(0), "mul");
+      EXPECT_EQ(node.attr().at("num_args").i(), 3);
+      const auto fused_ops = node.attr().at("fused_ops").list().s();
+      ASSERT_EQ(fused_ops.size(), 3);
+      EXPECT_EQ(fused_ops[2], "Maximum");
+      found++;
+    }
+    if (node.name() == "mul") {
+      EXPECT_EQ(node.op(), "Mul");
+      found++;
+    }
+  }
+  EXPECT_EQ(found, 2);
+
+  auto tensors_expected = EvaluateNodes(item.graph, item.fetch, item.feed);
+  ASSERT_EQ(tensors_expected.size(), 2);
+  auto tensors = EvaluateNodes(output, item.fetch, item.feed);
+  ASSERT_EQ(tensors.size(), 2);
+  test::ExpectClose(tensors[0], tensors_expected[0], 1e-6);
+  test::ExpectClose(tensors[1], tensors_expected[1], 1e-6);
+}
+
 class RemapperFuseMatMulWithBiasTest : public RemapperTest {
  public:
   template <DataType DTYPE>
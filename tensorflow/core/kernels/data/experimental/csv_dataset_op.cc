@@ -12,6 +12,20 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif  // __SSE2__
+
+#include "absl/numeric/bits.h"
+#include "absl/strings/ascii.h"
+#include "absl/strings/string_view.h"
 #include "tensorflow/core/framework/common_shape_fns.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/op.h"
@@ -20,12 +34,257 @@ limitations under the License.
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/byte_order.h"
 
 namespace tensorflow {
 namespace data {
 namespace experimental {
 namespace {
 
+// Structural index of a buffer of CSV data: one bit per byte, set for the
+// delimiter, '\n', '\r' and, if quotes are delimiters, '"'. Like the first
+// stage of SIMD JSON parsers, it is built 64 bytes at a time, so that the
+// parser finds the end of a field by scanning bits rather than bytes.
+class StructuralIndex {
+ public:
+  StructuralIndex(char delim, bool use_quote_delim)
+      : delim_(delim), use_quote_delim_(use_quote_delim) {}
+
+  // Indexes `data[0, size)`, replacing the previous index.
+  void Build(const char* data, size_t size) {
+    size_ = size;
+    masks_.resize((size + kBlockSize - 1) / kBlockSize);
+    size_t block = 0;
+    for (; (block + 1) * kBlockSize <= size; ++block) {
+      masks_[block] = BlockMask(data + block * kBlockSize);
+    }
+    if (block < masks_.size()) {
+      const size_t tail_size = size - block * kBlockSize;
+      char tail[kBlockSize] = {};
+      std::memcpy(tail, data + block * kBlockSize, tail_size);
+      masks_[block] = BlockMask(tail) & ((uint64_t{1} << tail_size) - 1);
+    }
+  }
+
+  // Returns the position of the first structural character at or after
+  // `pos`, or the size of the indexed data if there is none.
+  size_t Find(size_t pos) const {
+    if (pos >= size_) {
+      return size_;
+    }
+    size_t block = pos / kBlockSize;
+    uint64_t mask = masks_[block] & (~uint64_t{0} << (pos % kBlockSize));
+    while (mask == 0) {
+      if (++block == masks_.size()) {
+        return size_;
+      }
+      mask = masks_[block];
+    }
+    return block * kBlockSize + absl::countr_zero(mask);
+  }
+
+ private:
+  static constexpr size_t kBlockSize = 64;
+
+  // Returns the structural characters of `block[0, kBlockSize)` as a bitmask.
+  uint64_t BlockMask(const char* block) const {
+#if defined(__SSE2__)
+    const __m128i delim = _mm_set1_epi8(delim_);
+    const __m128i line_feed = _mm_set1_epi8('\n');
+    const __m128i carriage_return = _mm_set1_epi8('\r');
+    const __m128i quote = _mm_set1_epi8('"');
+    uint64_t mask = 0;
+    for (size_t i = 0; i < kBlockSize; i += sizeof(__m128i)) {
+      const __m128i bytes =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+      __m128i matches =
+          _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(bytes, delim),
+                                    _mm_cmpeq_epi8(bytes, line_feed)),
+                       _mm_cmpeq_epi8(bytes, carriage_return));
+      if (use_quote_delim_) {
+        matches = _mm_or_si128(matches, _mm_cmpeq_epi8(bytes, quote));
+      }
+      mask |= static_cast<uint64_t>(
+                  static_cast<uint16_t>(_mm_movemask_epi8(matches)))
+              << i;
+    }
+    return mask;
+#else
+    uint64_t mask = 0;
+    if (!port::kLittleEndian) {
+      for (size_t i = 0; i < kBlockSize; ++i) {
+        if (IsStructuralChar(block[i])) {
+          mask |= uint64_t{1} << i;
+        }
+      }
+      return mask;
+    }
+    // Matches 8 bytes at a time in 64-bit words (SWAR, "SIMD within a
+    // register").
+    for (size_t i = 0; i < kBlockSize; i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, block + i, sizeof(word));
+      uint64_t matches = ZeroBytes(word ^ Broadcast(delim_)) |
+                         ZeroBytes(word ^ Broadcast('\n')) |
+                         ZeroBytes(word ^ Broadcast('\r'));
+      if (use_quote_delim_) {
+        matches |= ZeroBytes(word ^ Broadcast('"'));
+      }
+      // Gathers the high bit of each byte into the high byte, in byte order.
+      mask |= (((matches >> 7) * 0x0102040810204080ULL) >> 56) << i;
+    }
+    return mask;
+#endif  // __SSE2__
+  }
+
+  bool IsStructuralChar(char c) const {
+    return c == delim_ || c == '\n' || c == '\r' ||
+           (use_quote_delim_ && c == '"');
+  }
+
+  static constexpr uint64_t Broadcast(char c) {
+    return 0x0101010101010101ULL * static_cast<uint8_t>(c);
+  }
+
+  // Returns the high bit of each zero byte of `word`.
+  static uint64_t ZeroBytes(uint64_t word) {
+    constexpr uint64_t kLowBits = 0x7F7F7F7F7F7F7F7FULL;
+    return ~(((word & kLowBits) + kLowBits) | word | kLowBits);
+  }
+
+  const char delim_;
+  const bool use_quote_delim_;
+  std::vector<uint64_t> masks_;
+  size_t size_ = 0;
+};
+
+// Parses `digits`, which are all '0'-'9', into `*value`. Converts 8 digits at
+// a time in a 64-bit word. `digits` must have at most 19 characters.
+uint64_t ParseDigits(absl::string_view digits) {
+  uint64_t value = 0;
+  size_t i = 0;
+  if (port::kLittleEndian) {
+    for (; i + sizeof(uint64_t) <= digits.size(); i += sizeof(uint64_t)) {
+      uint64_t word;
+      std::memcpy(&word, digits.data() + i, sizeof(word));
+      word = (word & 0x0F0F0F0F0F0F0F0FULL) * 2561 >> 8;
+      word = (word & 0x00FF00FF00FF00FFULL) * 6553601 >> 16;
+      word = (word & 0x0000FFFF0000FFFFULL) * 42949672960001ULL >> 32;
+      value = value * 100000000 + word;
+    }
+  }
+  for (; i < digits.size(); ++i) {
+    value = value * 10 + (digits[i] - '0');
+  }
+  return value;
+}
+
+// Returns the length of the run of digits at the start of `text`.
+size_t DigitRunLength(absl::string_view text) {
+  size_t i = 0;
+  while (i < text.size() && absl::ascii_isdigit(text[i])) {
+    ++i;
+  }
+  return i;
+}
+
+// Parses `field` into `*value` if it is a plain decimal integer, optionally
+// negative, with few enough digits that it cannot overflow. Returns false
+// otherwise; the caller then falls back to `strings::safe_strto*`, which
+// also handles whitespace, signs and range checks.
+template <typename T>
+bool FastParseInt(absl::string_view field, T* value) {
+  constexpr size_t kMaxDigits = std::numeric_limits<T>::digits10;
+  const bool negative = !field.empty() && field[0] == '-';
+  if (negative) {
+    field.remove_prefix(1);
+  }
+  if (field.empty() || field.size() > kMaxDigits ||
+      DigitRunLength(field) != field.size()) {
+    return false;
+  }
+  const T magnitude = static_cast<T>(ParseDigits(field));
+  *value = negative ? -magnitude : magnitude;
+  return true;
+}
+
+// Parses `field` into `*value` if it is a decimal number, optionally negative
+// and with an exponent, whose digits and power of ten are exactly
+// representable in `T`. Then one multiplication or division by the power of
+// ten is correctly rounded, so the result matches `strings::safe_strtof` and
+// `strings::safe_strtod` (Clinger's fast path). Returns false otherwise; the
+// caller then falls back to those.
+template <typename T>
+bool FastParseFloat(absl::string_view field, T* value) {
+  static constexpr double kPowersOf10[] = {
+      1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  // Largest exactly representable mantissa and power of ten.
+  constexpr uint64_t kMaxMantissa = uint64_t{1}
+                                    << std::numeric_limits<T>::digits;
+  constexpr int kMaxPowerOf10 = std::is_same_v<T, float> ? 10 : 22;
+
+  const bool negative = !field.empty() && field[0] == '-';
+  if (negative) {
+    field.remove_prefix(1);
+  }
+  const size_t num_integer_digits = DigitRunLength(field);
+  if (num_integer_digits == 0) {
+    return false;
+  }
+  absl::string_view integer_digits = field.substr(0, num_integer_digits);
+  field.remove_prefix(num_integer_digits);
+  absl::string_view fraction_digits;
+  if (!field.empty() && field[0] == '.') {
+    field.remove_prefix(1);
+    fraction_digits = field.substr(0, DigitRunLength(field));
+    if (fraction_digits.empty()) {
+      return false;
+    }
+    field.remove_prefix(fraction_digits.size());
+  }
+  int exponent = 0;
+  if (!field.empty() && (field[0] == 'e' || field[0] == 'E')) {
+    field.remove_prefix(1);
+    const bool negative_exponent = !field.empty() && field[0] == '-';
+    if (!field.empty() && (field[0] == '-' || field[0] == '+')) {
+      field.remove_prefix(1);
+    }
+    if (field.empty() || field.size() > 3 ||
+        DigitRunLength(field) != field.size()) {
+      return false;
+    }
+    exponent = static_cast<int>(ParseDigits(field));
+    if (negative_exponent) {
+      exponent = -exponent;
+    }
+    field = absl::string_view();
+  }
+  if (!field.empty() ||
+      integer_digits.size() + fraction_digits.size() > 19) {
+    return false;
+  }
+
+  uint64_t mantissa = ParseDigits(integer_digits);
+  for (size_t i = 0; i < fraction_digits.size(); ++i) {
+    mantissa *= 10;
+  }
+  mantissa += ParseDigits(fraction_digits);
+  exponent -= static_cast<int>(fraction_digits.size());
+  if (mantissa > kMaxMantissa ||
+      (mantissa != 0 && std::abs(exponent) > kMaxPowerOf10)) {
+    return false;
+  }
+  T result = static_cast<T>(mantissa);
+  if (mantissa != 0 && exponent > 0) {
+    result *= static_cast<T>(kPowersOf10[exponent]);
+  } else if (mantissa != 0 && exponent < 0) {
+    result /= static_cast<T>(kPowersOf10[-exponent]);
+  }
+  *value = negative ? -result : result;
+  return true;
+}
+
 class CSVDatasetOp : public DatasetOpKernel {
  public:
   explicit CSVDatasetOp(OpKernelConstruction* ctx)
@@ -33,6 +292,20 @@ class CSVDatasetOp : public DatasetOpKernel {
         op_version_(ctx->def().op() == "CSVDatasetV2" ? 2 : 1) {
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_types", &output_types_));
     OP_REQUIRES_OK(ctx, ctx->GetAttr("output_shapes", &output_shapes_));
+    if (ctx->HasAttr("batch_size")) {
+      OP_REQUIRES_OK(ctx, ctx->GetAttr("batch_size", &batch_size_));
+    }
+    OP_REQUIRES(ctx, batch_size_ >= 0,
+                errors::InvalidArgument("batch_size must be non-negative"));
+    if (batch_size_ > 0) {
+      for (const PartialTensorShape& shape : output_shapes_) {
+        OP_REQUIRES(
+            ctx, shape.IsCompatibleWith(PartialTensorShape({-1})),
+            errors::InvalidArgument(
+                "output_shapes must be vectors if batch_size is positive, got ",
+                shape.DebugString()));
+      }
+    }
   }
 
   void MakeDataset(OpKernelContext* ctx, DatasetBase** output) override {
@@ -157,7 +430,7 @@ class CSVDatasetOp : public DatasetOpKernel {
                           output_types_, output_shapes_,
                           std::move(record_defaults), std::move(select_cols),
                           std::move(exclude_cols), use_quote_delim, delim[0],
-                          std::move(na_value), op_version_);
+                          std::move(na_value), op_version_, batch_size_);
   }
 
  private:
@@ -169,7 +442,8 @@ class CSVDatasetOp : public DatasetOpKernel {
             const std::vector<PartialTensorShape>& output_shapes,
             std::vector<Tensor> record_defaults,
             std::vector<int64_t> select_cols, std::vector<int64_t> exclude_cols,
-            bool use_quote_delim, char delim, string na_value, int op_version)
+            bool use_quote_delim, char delim, string na_value, int op_version,
+            int64_t batch_size)
         : DatasetBase(DatasetContext(ctx)),
           filenames_(std::move(filenames)),
           header_(header),
@@ -182,6 +456,7 @@ class CSVDatasetOp : public DatasetOpKernel {
           delim_(delim),
           na_value_(std::move(na_value)),
           op_version_(op_version),
+          batch_size_(batch_size),
           use_compression_(!compression_type.empty()),
           compression_type_(std::move(compression_type)),
           options_(options) {}
@@ -244,6 +519,8 @@ class CSVDatasetOp : public DatasetOpKernel {
       TF_RETURN_IF_ERROR(b->AddVector(exclude_cols_, &exclude_cols));
 
       if (op_version_ > 1) {
+        AttrValue batch_size;
+        b->BuildAttrValue(batch_size_, &batch_size);
         TF_RETURN_IF_ERROR(b->AddDataset(
             this,
             {std::make_pair(0, filenames), std::make_pair(1, compression_type),
@@ -252,7 +529,7 @@ class CSVDatasetOp : public DatasetOpKernel {
              std::make_pair(6, na_value), std::make_pair(7, select_cols),
              std::make_pair(9, exclude_cols)},     // Single tensor inputs
             {std::make_pair(8, record_defaults)},  // Tensor list inputs
-            {}, output));
+            {std::make_pair("batch_size", batch_size)}, output));
       } else {
         TF_RETURN_IF_ERROR(b->AddDataset(
             this,
@@ -276,48 +553,18 @@ class CSVDatasetOp : public DatasetOpKernel {
     class Iterator : public DatasetIterator<Dataset> {
      public:
       explicit Iterator(const Params& params)
-          : DatasetIterator<Dataset>(params) {}
+          : DatasetIterator<Dataset>(params),
+            structural_index_(dataset()->delim_, dataset()->use_quote_delim_) {
+      }
 
       Status GetNextInternal(IteratorContext* ctx,
                              std::vector<Tensor>* out_tensors,
                              bool* end_of_sequence) override {
         mutex_lock l(mu_);
-        bool select_all =
-            dataset()->select_cols_.empty() && dataset()->exclude_cols_.empty();
-        do {
-          // We are currently processing a file, so try to read the next record
-          if (input_stream_) {
-            Status s =
-                ReadRecord(ctx, out_tensors, select_all,
-                           dataset()->select_cols_, dataset()->exclude_cols_);
-            if (s.ok()) {
-              // Validate output
-              if (out_tensors->size() != dataset()->out_type_.size()) {
-                return errors::InvalidArgument(
-                    "Expect ", dataset()->out_type_.size(), " fields but have ",
-                    out_tensors->size(), " in record");
-              }
-
-              *end_of_sequence = false;
-              return s;
-            }
-            if (!errors::IsOutOfRange(s)) {
-              // Not at the end of file, return OK or non-EOF errors to caller.
-              *end_of_sequence = false;
-              return s;
-            }
-            // We have reached the end of the current file, so maybe
-            // move on to next file.
-            ResetStreamsLocked();
-            ++current_file_index_;
-          }
-          // Iteration ends when there are no more files to process.
-          if (current_file_index_ == dataset()->filenames_.size()) {
-            *end_of_sequence = true;
-            return absl::OkStatus();
-          }
-          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        } while (true);
+        if (dataset()->batch_size_ > 0) {
+          return GetNextBatch(ctx, out_tensors, end_of_sequence);
+        }
+        return GetNextRecord(ctx, out_tensors, end_of_sequence);
       }
 
      protected:
@@ -384,6 +631,118 @@ class CSVDatasetOp : public DatasetOpKernel {
       }
 
      private:
+      // Decides which fields of a record are converted to outputs.
+      class FieldSelector {
+       public:
+        FieldSelector(bool select_all, const std::vector<int64_t>& selected,
+                      const std::vector<int64_t>& excluded)
+            : select_all_(select_all),
+              selected_(selected),
+              excluded_(excluded) {}
+
+        // Returns whether the next field of the record is included.
+        bool Next() {
+          bool explicit_exclude =
+              num_excluded_parsed_ < excluded_.size() &&
+              excluded_[num_excluded_parsed_] == num_parsed_;
+          bool include = select_all_ ||
+                         (num_selected_parsed_ < selected_.size() &&
+                          selected_[num_selected_parsed_] == num_parsed_) ||
+                         (!excluded_.empty() && !explicit_exclude);
+          num_parsed_++;
+          if (include) num_selected_parsed_++;
+          if (explicit_exclude) num_excluded_parsed_++;
+          return include;
+        }
+
+       private:
+        const bool select_all_;
+        const std::vector<int64_t>& selected_;
+        const std::vector<int64_t>& excluded_;
+        size_t num_parsed_ = 0;
+        size_t num_selected_parsed_ = 0;
+        size_t num_excluded_parsed_ = 0;
+      };
+
+      // Reads the next record into `out_tensors`, moving on to the next file
+      // at the end of each file. Sets `end_of_sequence` after the last file.
+      Status GetNextRecord(IteratorContext* ctx,
+                           std::vector<Tensor>* out_tensors,
+                           bool* end_of_sequence)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        bool select_all =
+            dataset()->select_cols_.empty() && dataset()->exclude_cols_.empty();
+        do {
+          // We are currently processing a file, so try to read the next record
+          if (input_stream_) {
+            Status s =
+                ReadRecord(ctx, out_tensors, select_all,
+                           dataset()->select_cols_, dataset()->exclude_cols_);
+            if (s.ok()) {
+              // Validate output
+              if (num_output_fields_ != dataset()->out_type_.size()) {
+                return errors::InvalidArgument(
+                    "Expect ", dataset()->out_type_.size(), " fields but have ",
+                    num_output_fields_, " in record");
+              }
+
+              *end_of_sequence = false;
+              return s;
+            }
+            if (!errors::IsOutOfRange(s)) {
+              // Not at the end of file, return OK or non-EOF errors to caller.
+              *end_of_sequence = false;
+              return s;
+            }
+            // We have reached the end of the current file, so maybe
+            // move on to next file.
+            ResetStreamsLocked();
+            ++current_file_index_;
+          }
+          // Iteration ends when there are no more files to process.
+          if (current_file_index_ == dataset()->filenames_.size()) {
+            *end_of_sequence = true;
+            return absl::OkStatus();
+          }
+          TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        } while (true);
+      }
+
+      // Reads up to `batch_size_` records straight into one vector per
+      // column. An invalid record fails the whole batch.
+      Status GetNextBatch(IteratorContext* ctx,
+                          std::vector<Tensor>* out_tensors,
+                          bool* end_of_sequence)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        const int64_t batch_size = dataset()->batch_size_;
+        std::vector<Tensor> columns;
+        columns.reserve(dataset()->out_type_.size());
+        for (DataType dtype : dataset()->out_type_) {
+          columns.emplace_back(ctx->allocator({}), dtype,
+                               TensorShape({batch_size}));
+        }
+        int64_t num_rows = 0;
+        for (; num_rows < batch_size; ++num_rows) {
+          batch_row_ = num_rows;
+          bool end_of_input = false;
+          TF_RETURN_IF_ERROR(GetNextRecord(ctx, &columns, &end_of_input));
+          if (end_of_input) {
+            break;
+          }
+        }
+        *end_of_sequence = num_rows == 0;
+        if (*end_of_sequence) {
+          return absl::OkStatus();
+        }
+        if (num_rows < batch_size) {
+          for (Tensor& column : columns) {
+            column = column.Slice(0, num_rows);
+          }
+        }
+        *out_tensors = std::move(columns);
+        return absl::OkStatus();
+      }
+
       // Reads an entire CSV row from the input stream, either from the
       // existing buffer or by filling the buffer as needed. Converts extracted
       // fields to output tensors as we go.
@@ -406,33 +765,67 @@ class CSVDatasetOp : public DatasetOpKernel {
         // \r\n linebreak between this and the previous record. If so, skip it.
 
         bool end_of_record = false;  // Keep track of when we find \n, \r or EOF
-        size_t num_parsed = 0;
-        size_t num_selected_parsed = 0;
-        size_t num_excluded_parsed = 0;
+        num_output_fields_ = 0;
+        FieldSelector field_selector(select_all, selected, excluded);
 
         Status result;
+        if (ParseUnquotedRecordInBuffer(ctx, out_tensors, &field_selector,
+                                        &result)) {
+          return result;
+        }
 
         while (!end_of_record) {  // Read till we reach \n, \r or EOF
-          bool explicit_exclude = num_excluded_parsed < excluded.size() &&
-                                  excluded[num_excluded_parsed] == num_parsed;
-          bool include = select_all ||
-                         (num_selected_parsed < selected.size() &&
-                          selected[num_selected_parsed] == num_parsed) ||
-                         (!excluded.empty() && !explicit_exclude);
-
           // Don't fail fast, so that the next call to GetNext may still return
           // a valid record
-          result.Update(
-              ParseOneField(ctx, out_tensors, &end_of_record, include));
-
-          num_parsed++;
-          if (include) num_selected_parsed++;
-          if (explicit_exclude) num_excluded_parsed++;
+          result.Update(ParseOneField(ctx, out_tensors, &end_of_record,
+                                      field_selector.Next()));
         }
 
         return result;
       }
 
+      // Parses the record at pos_ if it ends in the buffer and has no quotes:
+      // finds all of its field boundaries in the structural index first, then
+      // converts the fields straight from the buffer. Returns false, without
+      // consuming any input, for other records.
+      bool ParseUnquotedRecordInBuffer(IteratorContext* ctx,
+                                       std::vector<Tensor>* out_tensors,
+                                       FieldSelector* field_selector,
+                                       Status* result)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        field_ends_.clear();
+        size_t pos = pos_;
+        while (true) {
+          pos = structural_index_.Find(pos);
+          if (pos >= buffer_.size()) {
+            return false;
+          }
+          const char ch = buffer_[pos];
+          if (ch == dataset()->delim_) {
+            field_ends_.push_back(pos++);
+          } else if (ch == '\n' || ch == '\r') {
+            field_ends_.push_back(pos);
+            break;
+          } else {
+            return false;  // A quote.
+          }
+        }
+
+        size_t start = pos_;
+        for (size_t end : field_ends_) {
+          if (field_selector->Next()) {
+            // Don't fail fast, so that the next call to GetNext may still
+            // return a valid record
+            result->Update(FieldToOutput(
+                ctx, StringPiece(&buffer_[start], end - start), out_tensors));
+          }
+          start = end + 1;
+        }
+        pos_ = start;
+        if (buffer_[pos_ - 1] == '\r') SkipNewLineIfNecessary();
+        return true;
+      }
+
       // Parses one field from position pos_ in the buffer. Fields are
       // delimited by delim, CRLF, or EOF. Advances pos_ to the first char of
       // the next field.
@@ -562,7 +955,13 @@ class CSVDatasetOp : public DatasetOpKernel {
             }
 
           } else {
-            pos_++;
+            // Skips to the next quote, which is the only character with a
+            // special meaning inside of quoted fields.
+            const void* quote = std::memchr(&buffer_[pos_], '"',
+                                            buffer_.size() - pos_);
+            pos_ = quote == nullptr
+                       ? buffer_.size()
+                       : static_cast<const char*>(quote) - buffer_.data();
           }
         }
       }
@@ -641,7 +1040,10 @@ class CSVDatasetOp : public DatasetOpKernel {
         size_t start = pos_;
         Status parse_result;
 
-        while (true) {  // Each iter reads 1 char, filling buffer if necessary
+        // Each iteration skips to the next structural character, filling the
+        // buffer if necessary.
+        while (true) {
+          pos_ = structural_index_.Find(pos_);
           if (pos_ >= buffer_.size()) {
             Status s = SaveAndFillBuffer(&earlier_pieces, &start, include);
             // Handle errors
@@ -682,7 +1084,6 @@ class CSVDatasetOp : public DatasetOpKernel {
             parse_result.Update(errors::InvalidArgument(
                 "Unquoted fields cannot have quotes inside"));
           }
-          // Otherwise, go to next character
           pos_++;
         }
       }
@@ -692,6 +1093,7 @@ class CSVDatasetOp : public DatasetOpKernel {
         ++num_buffer_reads_;
         Status s = input_stream_->ReadNBytes(
             dataset()->options_.input_buffer_size, result);
+        structural_index_.Build(result->data(), result->size());
 
         if (errors::IsOutOfRange(s) && !result->empty()) {
           // Ignore OutOfRange error when ReadNBytes read < N bytes.
@@ -700,10 +1102,13 @@ class CSVDatasetOp : public DatasetOpKernel {
         return s;
       }
 
-      // Given a field, converts it to the right output tensor type
+      // Given a field, converts it to the right output tensor type. If the
+      // dataset is batched, writes it to row batch_row_ of the column in
+      // out_tensors instead of appending a scalar.
       Status FieldToOutput(IteratorContext* ctx, StringPiece field,
-                           std::vector<Tensor>* out_tensors) {
-        size_t output_idx = out_tensors->size();
+                           std::vector<Tensor>* out_tensors)
+          TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+        size_t output_idx = num_output_fields_++;
         if (output_idx >= dataset()->out_type_.size()) {
           // We can get here if we're selecting all columns, but the number of
           // fields exceeds the number of defaults provided
@@ -711,8 +1116,16 @@ class CSVDatasetOp : public DatasetOpKernel {
                                          " fields but have more in record");
         }
         const DataType& dtype = dataset()->out_type_[output_idx];
-        out_tensors->emplace_back(ctx->allocator({}), dtype, TensorShape({}));
-        Tensor& component = out_tensors->back();
+        Tensor* component;
+        int64_t row = 0;
+        if (dataset()->batch_size_ > 0) {
+          component = &(*out_tensors)[output_idx];
+          row = batch_row_;
+        } else {
+          out_tensors->emplace_back(ctx->allocator({}), dtype,
+                                    TensorShape({}));
+          component = &out_tensors->back();
+        }
         if ((field.empty() || field == dataset()->na_value_) &&
             dataset()->record_defaults_[output_idx].NumElements() != 1) {
           // If the field is empty or NA value, and default is not given,
@@ -726,70 +1139,74 @@ class CSVDatasetOp : public DatasetOpKernel {
           // Otherwise, we convert it to the right type.
           case DT_INT32: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<int32>()() =
+              component->flat<int32>()(row) =
                   dataset()->record_defaults_[output_idx].flat<int32>()(0);
             } else {
               int32_t value;
-              if (!strings::safe_strto32(field, &value)) {
+              if (!FastParseInt(field, &value) &&
+                  !strings::safe_strto32(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int32: ", field);
               }
-              component.scalar<int32>()() = value;
+              component->flat<int32>()(row) = value;
             }
             break;
           }
           case DT_INT64: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<int64_t>()() =
+              component->flat<int64_t>()(row) =
                   dataset()->record_defaults_[output_idx].flat<int64_t>()(0);
             } else {
               int64_t value;
-              if (!strings::safe_strto64(field, &value)) {
+              if (!FastParseInt(field, &value) &&
+                  !strings::safe_strto64(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid int64: ", field);
               }
-              component.scalar<int64_t>()() = value;
+              component->flat<int64_t>()(row) = value;
             }
             break;
           }
           case DT_FLOAT: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<float>()() =
+              component->flat<float>()(row) =
                   dataset()->record_defaults_[output_idx].flat<float>()(0);
             } else {
               float value;
-              if (!strings::safe_strtof(field, &value)) {
+              if (!FastParseFloat(field, &value) &&
+                  !strings::safe_strtof(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid float: ", field);
               }
-              component.scalar<float>()() = value;
+              component->flat<float>()(row) = value;
             }
             break;
           }
           case DT_DOUBLE: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<double>()() =
+              component->flat<double>()(row) =
                   dataset()->record_defaults_[output_idx].flat<double>()(0);
             } else {
               double value;
-              if (!strings::safe_strtod(field, &value)) {
+              if (!FastParseFloat(field, &value) &&
+                  !strings::safe_strtod(field, &value)) {
                 return errors::InvalidArgument(
                     "Field ", output_idx,
                     " in record is not a valid double: ", field);
               }
-              component.scalar<double>()() = value;
+              component->flat<double>()(row) = value;
             }
             break;
           }
           case DT_STRING: {
             if (field.empty() || field == dataset()->na_value_) {
-              component.scalar<tstring>()() =
+              component->flat<tstring>()(row) =
                   dataset()->record_defaults_[output_idx].flat<tstring>()(0);
             } else {
-              component.scalar<tstring>()() = string(field);
+              component->flat<tstring>()(row) = string(field);
             }
             break;
           }
@@ -904,7 +1321,15 @@ class CSVDatasetOp : public DatasetOpKernel {
       size_t current_file_index_ TF_GUARDED_BY(mu_) = 0;
       std::unique_ptr<RandomAccessFile> file_
           TF_GUARDED_BY(mu_);  // must outlive input_stream_
-    };                         // class Iterator
+      StructuralIndex structural_index_ TF_GUARDED_BY(mu_);  // Of buffer_
+      // Ends of the fields of the record parsed by
+      // ParseUnquotedRecordInBuffer, reused across records.
+      std::vector<size_t> field_ends_ TF_GUARDED_BY(mu_);
+      // Number of fields converted by FieldToOutput in the current record.
+      size_t num_output_fields_ TF_GUARDED_BY(mu_) = 0;
+      // Row of the batch that FieldToOutput writes to, if batched.
+      int64_t batch_row_ TF_GUARDED_BY(mu_) = 0;
+    };  // class Iterator
 
     const std::vector<string> filenames_;
     const bool header_;
@@ -917,12 +1342,16 @@ class CSVDatasetOp : public DatasetOpKernel {
     const char delim_;
     const tstring na_value_;
     const int op_version_;
+    // If positive, each element holds up to `batch_size_` records, with one
+    // vector per column.
+    const int64_t batch_size_;
     const bool use_compression_;
     const tstring compression_type_;
     const io::ZlibCompressionOptions options_;
   };  // class Dataset
 
   const int op_version_;
+  int64_t batch_size_ = 0;
 
   DataTypeVector output_types_;
   std::vector<PartialTensorShape> output_shapes_;
@@ -78,6 +78,12 @@ bool SymbolicCheckpointEnabled(const Options& options) {
          options.symbolic_checkpoint();
 }
 
+bool AsyncCheckpointEnabled(const Options& options) {
+  return options.optional_async_checkpoint_case() ==
+             Options::kAsyncCheckpoint &&
+         options.async_checkpoint();
+}
+
 }  // namespace
 
 /* static */ constexpr const char* const
@@ -214,6 +220,21 @@ Status IteratorResource::Save(OpKernelContext* ctx,
   return iterator->Save(&serialization_ctx, writer);
 }
 
+AsyncIteratorStateEncoder* IteratorResource::GetAsyncCheckpointEncoder(
+    OpKernelContext* ctx) {
+  mutex_lock l(mu_);
+  const DatasetBase* dataset = iterator_state_->dataset();
+  if (dataset == nullptr || !AsyncCheckpointEnabled(dataset->options()) ||
+      SymbolicCheckpointEnabled(dataset->options())) {
+    return nullptr;
+  }
+  if (!async_checkpoint_encoder_) {
+    async_checkpoint_encoder_ = std::make_unique<AsyncIteratorStateEncoder>(
+        ctx->env(), dataset->options().async_checkpoint_segment_dir());
+  }
+  return async_checkpoint_encoder_.get();
+}
+
 Status IteratorResource::Restore(OpKernelContext* ctx,
                                  IteratorStateReader* reader) {
   const DatasetBase* dataset;
@@ -379,6 +400,12 @@ class IteratorVariantSerializer {
   Status InitializeFromIterator(OpKernelContext* ctx,
                                 ExternalStatePolicy external_state_policy,
                                 IteratorResource* iterator_resource) {
+    AsyncIteratorStateEncoder* encoder =
+        iterator_resource->GetAsyncCheckpointEncoder(ctx);
+    CheckpointMetricsCollector metrics_collector(
+        /*async=*/encoder != nullptr,
+        CheckpointMetricsCollector::Stage::kSerialize, *ctx->env());
+    const absl::Time start_time = metrics_collector.RecordStart();
     VariantTensorDataWriter writer;
     TF_RETURN_IF_ERROR(
         iterator_resource->Save(ctx, external_state_policy, &writer));
@@ -389,10 +416,16 @@ class IteratorVariantSerializer {
     for (auto& it : data) {
       IteratorStateVariant v;
       TF_RETURN_IF_ERROR(v.InitializeFromVariantData(std::move(it)));
+      if (encoder != nullptr) {
+        // The variant is compressed while the training step continues, and
+        // only blocks if it is encoded before the compression finishes.
+        encoder->EncodeAsync(v);
+      }
       variants_.push_back(v);
     }
     num_tensors_ = variants_.size();
     can_serialize_ = true;
+    metrics_collector.RecordStop(start_time);
     return absl::OkStatus();
   }
 
@@ -22,6 +22,7 @@ limitations under the License.
 
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/metric_utils.h"
+#include "tensorflow/core/data/serialization_utils.h"
 #include "tensorflow/core/data/tfdataz_metrics.h"
 #include "tensorflow/core/data/unbounded_thread_pool.h"
 #include "tensorflow/core/framework/dataset.h"
@@ -62,6 +63,11 @@ class IteratorResource : public ResourceBase {
   Status Save(OpKernelContext* ctx, ExternalStatePolicy external_state_policy,
               IteratorStateWriter* writer);
 
+  // Returns the encoder which compresses the checkpoints of this iterator in
+  // the background, or nullptr if asynchronous checkpointing is not enabled for
+  // the dataset of the iterator.
+  AsyncIteratorStateEncoder* GetAsyncCheckpointEncoder(OpKernelContext* ctx);
+
   // Restores the state of the iterator from a checkpoint created by `Save`.
   Status Restore(OpKernelContext* ctx, IteratorStateReader* reader);
 
@@ -159,6 +165,11 @@ class IteratorResource : public ResourceBase {
   const Env& env_;
   const std::unique_ptr<DeviceMgr> device_mgr_ TF_GUARDED_BY(mu_);
   std::shared_ptr<State> iterator_state_ TF_GUARDED_BY(mu_);
+  // Created upon the first asynchronous checkpoint, and shared by the
+  // iterators of this resource so that `Restore` does not drop the segments
+  // of the previous checkpoint.
+  std::unique_ptr<AsyncIteratorStateEncoder> async_checkpoint_encoder_
+      TF_GUARDED_BY(mu_);
   const DataTypeVector output_dtypes_;
   const std::vector<PartialTensorShape> output_shapes_;
 };
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/core/data/captured_function.h"
 #include "tensorflow/core/data/dataset_utils.h"
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/readahead_file.h"
 #include "tensorflow/core/data/stats_utils.h"
 #include "tensorflow/core/framework/dataset.h"
 #include "tensorflow/core/framework/metrics.h"
@@ -365,6 +366,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
               params.dataset->num_parallel_calls_, mu_,
               num_parallel_calls_cond_var_)),
           deterministic_(deterministic),
+          readahead_bytes_(
+              GetExperiments().contains("interleave_readahead")
+                  ? ReadaheadManager::MakeReadaheadBytes(ReadaheadOptions())
+                  : nullptr),
           current_elements_(params.dataset->cycle_length_) {}
 
     ~ParallelInterleaveIterator() override { CancelThreads(/*wait=*/true); }
@@ -400,6 +405,13 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
         num_parallel_calls_->value = std::min(
             GetAutotuneDefaultParallelism(ctx), dataset()->cycle_length_);
       }
+      if (readahead_bytes_) {
+        // Reads the files of the input iterators ahead of them, within a
+        // budget shared by the whole cycle.
+        readahead_manager_ = std::make_shared<ReadaheadManager>(
+            ctx->env(), ReadaheadOptions(), readahead_bytes_,
+            ctx->ram_budget_manager());
+      }
       cancellation_manager_ = std::make_unique<CancellationManager>();
       IteratorContext::Params params(ctx);
       params.interleave_depth += 1;
@@ -475,19 +487,24 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
                     static_cast<double>(dataset()->cycle_length_),
                     std::ceil(std::pow(27 * dataset()->cycle_length_, 0.5)))
               : 1;
-      return model::MakeAsyncInterleaveManyNode(
-          std::move(args),
-          {model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/min,
-                                /*max=*/dataset()->cycle_length_),
-           model::MakeNonTunableParameter(kCycleLength,
-                                          dataset()->cycle_length_),
-           model::MakeNonTunableParameter(kDeterministic,
-                                          deterministic_ ? 1.0 : 0.0),
-           model::MakeNonTunableParameter(
-               kMaxBufferedElements,
-               ComputeMaxBufferedElements(dataset()->prefetch_input_elements_,
-                                          dataset()->buffer_output_elements_,
-                                          dataset()->cycle_length_))});
+      std::vector<std::shared_ptr<model::Parameter>> parameters = {
+          model::MakeParameter(kParallelism, num_parallel_calls_, /*min=*/min,
+                               /*max=*/dataset()->cycle_length_),
+          model::MakeNonTunableParameter(kCycleLength,
+                                         dataset()->cycle_length_),
+          model::MakeNonTunableParameter(kDeterministic,
+                                         deterministic_ ? 1.0 : 0.0),
+          model::MakeNonTunableParameter(
+              kMaxBufferedElements,
+              ComputeMaxBufferedElements(dataset()->prefetch_input_elements_,
+                                         dataset()->buffer_output_elements_,
+                                         dataset()->cycle_length_))};
+      if (readahead_bytes_) {
+        parameters.push_back(ReadaheadManager::MakeParameter(
+            ReadaheadOptions(), readahead_bytes_));
+      }
+      return model::MakeAsyncInterleaveManyNode(std::move(args),
+                                                std::move(parameters));
     }
 
     Status SaveInternal(SerializationContext* ctx,
@@ -625,6 +642,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     }
 
    private:
+    // Returns the options of the readahead of the input files, which uses one
+    // read thread per element of the cycle.
+    ReadaheadManager::Options ReadaheadOptions() const {
+      ReadaheadManager::Options options;
+      options.num_threads = dataset()->cycle_length_;
+      return options;
+    }
+
     // Represents the result of fetching an element from a dataset.
     struct Result {
       explicit Result(IteratorContext* ctx)
@@ -728,6 +753,10 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
       if (!threads_started_) {
         IncrementOutstandingThreads();
         auto ctx_copy = std::make_shared<IteratorContext>(*ctx);
+        if (readahead_manager_) {
+          // The worker threads create and read from the input iterators.
+          ctx_copy->SetReadaheadManager(readahead_manager_);
+        }
         thread_pool_->Schedule(
             [this, ctx_copy]() { WorkerManagerThread(ctx_copy); });
         if (ctx->stats_aggregator()) {
@@ -1672,6 +1701,14 @@ class ParallelInterleaveDatasetOp::Dataset : public DatasetBase {
     // Determines whether outputs can be produced in deterministic order.
     const bool deterministic_;
 
+    // Identifies the number of bytes each input file is read ahead of its
+    // reader. Null unless the `interleave_readahead` experiment is enabled.
+    const std::shared_ptr<model::SharedState> readahead_bytes_;
+
+    // Reads the files of the input iterators ahead of them. Null unless
+    // `readahead_bytes_` is set.
+    std::shared_ptr<ReadaheadManager> readahead_manager_ TF_GUARDED_BY(mu_);
+
     // Controls cancellation of `input_impl_`. Must be ordered before
     // `input_impl_` so that `input_impl_` is destroyed first.
     std::unique_ptr<CancellationManager> cancellation_manager_;
@@ -15,6 +15,7 @@ limitations under the License.
 #include "tensorflow/core/kernels/data/text_line_dataset_op.h"
 
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/text_line_reader.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -24,6 +25,7 @@ limitations under the License.
 #include "tensorflow/core/lib/io/random_inputstream.h"
 #include "tensorflow/core/lib/io/zlib_compression_options.h"
 #include "tensorflow/core/lib/io/zlib_inputstream.h"
+#include "tensorflow/core/platform/statusor.h"
 
 namespace tensorflow {
 namespace data {
@@ -106,10 +108,10 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(mu_);
       do {
         // We are currently processing a file, so try to read the next line.
-        if (buffered_input_stream_) {
+        if (HasOpenFileLocked()) {
           Tensor line_contents(tstring{});
           tstring& line_contents_str = line_contents.scalar<tstring>()();
-          Status s = buffered_input_stream_->ReadLine(&line_contents_str);
+          Status s = ReadLineLocked(&line_contents_str);
 
           if (s.ok()) {
             // Produce the line as output.
@@ -151,12 +153,12 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
       mutex_lock l(mu_);
       TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCurrentFileIndex,
                                              current_file_index_));
-      // `buffered_input_stream_` is empty if
+      // There is no open file if
       // 1. GetNext has not been called even once.
       // 2. All files have been read and iterator has been exhausted.
-      if (buffered_input_stream_) {
-        TF_RETURN_IF_ERROR(writer->WriteScalar(prefix(), kCurrentPos,
-                                               buffered_input_stream_->Tell()));
+      if (HasOpenFileLocked()) {
+        TF_RETURN_IF_ERROR(
+            writer->WriteScalar(prefix(), kCurrentPos, TellLocked()));
       }
       return absl::OkStatus();
     }
@@ -177,7 +179,11 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
             reader->ReadScalar(prefix(), kCurrentPos, &current_pos));
 
         TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
-        TF_RETURN_IF_ERROR(buffered_input_stream_->Seek(current_pos));
+        if (line_reader_) {
+          TF_RETURN_IF_ERROR(line_reader_->Seek(current_pos));
+        } else {
+          TF_RETURN_IF_ERROR(buffered_input_stream_->Seek(current_pos));
+        }
       }
       return absl::OkStatus();
     }
@@ -191,29 +197,55 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
             " >= filenames_.size():", dataset()->filenames_.size());
       }
 
-      // Actually move on to next file.
-      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
-          TranslateFileName(dataset()->filenames_[current_file_index_]),
-          &file_));
+      // Actually move on to next file. Uncompressed files are read with
+      // `TextLineReader`, which splits whole blocks into lines.
+      const std::string filename =
+          TranslateFileName(dataset()->filenames_[current_file_index_]);
+      if (!dataset()->use_compression_) {
+        TF_ASSIGN_OR_RETURN(
+            line_reader_,
+            TextLineReader::Create(env, filename,
+                                   dataset()->options_.input_buffer_size,
+                                   /*memory_map=*/true));
+        return absl::OkStatus();
+      }
+
+      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(filename, &file_));
       input_stream_ =
           std::make_unique<io::RandomAccessInputStream>(file_.get(), false);
 
-      if (dataset()->use_compression_) {
-        zlib_input_stream_ = std::make_unique<io::ZlibInputStream>(
-            input_stream_.get(), dataset()->options_.input_buffer_size,
-            dataset()->options_.input_buffer_size, dataset()->options_);
-        buffered_input_stream_ = std::make_unique<io::BufferedInputStream>(
-            zlib_input_stream_.get(), dataset()->options_.input_buffer_size,
-            false);
-      } else {
-        buffered_input_stream_ = std::make_unique<io::BufferedInputStream>(
-            input_stream_.get(), dataset()->options_.input_buffer_size, false);
-      }
+      zlib_input_stream_ = std::make_unique<io::ZlibInputStream>(
+          input_stream_.get(), dataset()->options_.input_buffer_size,
+          dataset()->options_.input_buffer_size, dataset()->options_);
+      buffered_input_stream_ = std::make_unique<io::BufferedInputStream>(
+          zlib_input_stream_.get(), dataset()->options_.input_buffer_size,
+          false);
       return absl::OkStatus();
     }
 
+    bool HasOpenFileLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      return line_reader_ != nullptr || buffered_input_stream_ != nullptr;
+    }
+
+    // Reads the next line of the open file.
+    Status ReadLineLocked(tstring* line) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (line_reader_) {
+        return line_reader_->ReadLine(line);
+      }
+      return buffered_input_stream_->ReadLine(line);
+    }
+
+    // Returns the position of the next line in the open file.
+    int64_t TellLocked() const TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      if (line_reader_) {
+        return line_reader_->Tell();
+      }
+      return buffered_input_stream_->Tell();
+    }
+
     // Resets all reader streams.
     void ResetStreamsLocked() TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+      line_reader_.reset();
       input_stream_.reset();
       zlib_input_stream_.reset();
       buffered_input_stream_.reset();
@@ -221,6 +253,7 @@ class TextLineDatasetOp::Dataset : public DatasetBase {
     }
 
     mutex mu_;
+    std::unique_ptr<TextLineReader> line_reader_ TF_GUARDED_BY(mu_);
     std::unique_ptr<io::RandomAccessInputStream> input_stream_
         TF_GUARDED_BY(mu_);
     std::unique_ptr<io::ZlibInputStream> zlib_input_stream_ TF_GUARDED_BY(mu_);
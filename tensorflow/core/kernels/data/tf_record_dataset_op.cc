@@ -17,6 +17,7 @@ limitations under the License.
 #include <cstdint>
 
 #include "tensorflow/core/data/name_utils.h"
+#include "tensorflow/core/data/readahead_file.h"
 #include "tensorflow/core/data/utils.h"
 #include "tensorflow/core/framework/metrics.h"
 #include "tensorflow/core/framework/partial_tensor_shape.h"
@@ -175,7 +176,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
           return absl::OkStatus();
         }
 
-        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx));
       } while (true);
     }
 
@@ -216,7 +217,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
           return absl::OkStatus();
         }
 
-        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx));
       } while (true);
     }
 
@@ -250,7 +251,7 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
       if (reader->Contains(prefix(), kOffset)) {
         int64_t offset;
         TF_RETURN_IF_ERROR(reader->ReadScalar(prefix(), kOffset, &offset));
-        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx->env()));
+        TF_RETURN_IF_ERROR(SetupStreamsLocked(ctx));
         TF_RETURN_IF_ERROR(reader_->SeekOffset(offset));
       }
       return absl::OkStatus();
@@ -258,7 +259,8 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
 
    private:
     // Sets up reader streams to read from the file at `current_file_index_`.
-    Status SetupStreamsLocked(Env* env) TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
+    Status SetupStreamsLocked(IteratorContext* ctx)
+        TF_EXCLUSIVE_LOCKS_REQUIRED(mu_) {
       if (current_file_index_ >= dataset()->filenames_.size()) {
         return errors::InvalidArgument(
             "current_file_index_:", current_file_index_,
@@ -274,9 +276,12 @@ class TFRecordDatasetOp::Dataset : public DatasetBase {
           },
           tsl::profiler::kInfo);
 
-      TF_RETURN_IF_ERROR(env->NewRandomAccessFile(
-          TranslateFileName(dataset()->filenames_[current_file_index_]),
-          &file_));
+      const std::string filename =
+          TranslateFileName(dataset()->filenames_[current_file_index_]);
+      TF_RETURN_IF_ERROR(ctx->env()->NewRandomAccessFile(filename, &file_));
+      // Inside a parallel interleave, reads the file ahead of the reader.
+      file_ = ReadaheadManager::MaybeWrap(ctx->readahead_manager(), filename,
+                                          std::move(file_));
       reader_ = std::make_unique<io::SequentialRecordReader>(
           file_.get(), dataset()->options_);
       if (!dataset()->byte_offsets_.empty()) {
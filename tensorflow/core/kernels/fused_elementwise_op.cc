@@ -0,0 +1,405 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/strings/str_join.h"
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_types.h"
+#include "tensorflow/core/kernels/cwise_ops.h"
+#include "tensorflow/core/platform/errors.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Number of elements each op computes at a time. The ops of a composition
+// read and write tiles of this size, which stay in cache between the ops.
+constexpr int64_t kTileSize = 1024;
+
+// An elementwise op of a composition, which computes `n` elements from the
+// same elements of its operands.
+template <typename T>
+struct FusedElementwiseFn {
+  using UnaryFn = void (*)(const T* x, T* y, int64_t n);
+  using BinaryFn = void (*)(const T* x, const T* y, T* z, int64_t n);
+
+  int num_operands;
+  UnaryFn unary;
+  BinaryFn binary;
+  int cost;
+};
+
+template <typename T>
+using ConstTile = typename TTypes<T>::UnalignedConstFlat;
+template <typename T>
+using Tile = typename TTypes<T>::UnalignedFlat;
+
+template <typename T, typename Functor>
+void ComputeUnary(const T* x, T* y, int64_t n) {
+  Tile<T>(y, n) = ConstTile<T>(x, n).unaryExpr(typename Functor::func());
+}
+
+template <typename T, typename Functor>
+void ComputeBinary(const T* x, const T* y, T* z, int64_t n) {
+  Tile<T>(z, n) = ConstTile<T>(x, n).binaryExpr(ConstTile<T>(y, n),
+                                                typename Functor::func());
+}
+
+// Relu and Relu6 match `functor::Relu` and `functor::Relu6`.
+template <typename T>
+void ComputeRelu(const T* x, T* y, int64_t n) {
+  Tile<T>(y, n) = ConstTile<T>(x, n).cwiseMax(static_cast<T>(0));
+}
+
+template <typename T>
+void ComputeRelu6(const T* x, T* y, int64_t n) {
+  Tile<T>(y, n) = ConstTile<T>(x, n)
+                      .cwiseMax(static_cast<T>(0))
+                      .cwiseMin(static_cast<T>(6));
+}
+
+template <typename Functor>
+int Cost() {
+  return Eigen::internal::functor_traits<typename Functor::func>::Cost;
+}
+
+template <typename T, typename Functor>
+FusedElementwiseFn<T> Unary() {
+  return {1, ComputeUnary<T, Functor>, nullptr, Cost<Functor>()};
+}
+
+template <typename T, typename Functor>
+FusedElementwiseFn<T> Binary() {
+  return {2, nullptr, ComputeBinary<T, Functor>, Cost<Functor>()};
+}
+
+// Returns the ops supported in a composition, by name.
+// WARN: This should be consistent with the remapper.
+template <typename T>
+const absl::flat_hash_map<std::string, FusedElementwiseFn<T>>&
+FusedElementwiseFns() {
+  using MaxCost = functor::maximum<T>;
+  static const auto* const fns =
+      new absl::flat_hash_map<std::string, FusedElementwiseFn<T>>({
+          // clang-format off
+          {"Abs",               Unary<T, functor::abs<T>>()},
+          {"Ceil",              Unary<T, functor::ceil<T>>()},
+          {"Exp",               Unary<T, functor::exp<T>>()},
+          {"Expm1",             Unary<T, functor::expm1<T>>()},
+          {"Floor",             Unary<T, functor::floor<T>>()},
+          {"Inv",               Unary<T, functor::inverse<T>>()},
+          {"Log",               Unary<T, functor::log<T>>()},
+          {"Log1p",             Unary<T, functor::log1p<T>>()},
+          {"Neg",               Unary<T, functor::neg<T>>()},
+          {"Reciprocal",        Unary<T, functor::inverse<T>>()},
+          {"Rsqrt",             Unary<T, functor::rsqrt<T>>()},
+          {"Sigmoid",           Unary<T, functor::sigmoid<T>>()},
+          {"Sqrt",              Unary<T, functor::sqrt<T>>()},
+          {"Square",            Unary<T, functor::square<T>>()},
+          {"Tanh",              Unary<T, functor::tanh<T>>()},
+          {"Relu",              {1, ComputeRelu<T>, nullptr,
+                                 Cost<MaxCost>()}},
+          {"Relu6",             {1, ComputeRelu6<T>, nullptr,
+                                 2 * Cost<MaxCost>()}},
+          {"Add",               Binary<T, functor::add<T>>()},
+          {"AddV2",             Binary<T, functor::add<T>>()},
+          {"Div",               Binary<T, functor::div<T>>()},
+          {"Maximum",           Binary<T, functor::maximum<T>>()},
+          {"Minimum",           Binary<T, functor::minimum<T>>()},
+          {"Mul",               Binary<T, functor::mul<T>>()},
+          {"RealDiv",           Binary<T, functor::div<T>>()},
+          {"SquaredDifference", Binary<T, functor::squared_difference<T>>()},
+          {"Sub",               Binary<T, functor::sub<T>>()},
+          // clang-format on
+      });
+  return *fns;
+}
+
+// Returns true if an argument of shape `arg` broadcasts to `shape` by
+// repeating its elements: it is a scalar, or it has the innermost dimensions
+// of `shape`.
+bool IsRepeatedTo(const TensorShape& arg, const TensorShape& shape) {
+  if (arg.dims() > shape.dims()) return false;
+  if (arg.num_elements() == 1) return true;
+  const int offset = shape.dims() - arg.dims();
+  for (int i = 0; i < arg.dims(); ++i) {
+    if (arg.dim_size(i) != shape.dim_size(offset + i)) return false;
+  }
+  return true;
+}
+
+// Copies the elements [begin, begin + n) of the repetition of the `size`
+// elements of `arg` to `tile`.
+template <typename T>
+void RepeatTile(const T* arg, int64_t size, int64_t begin, int64_t n,
+                T* tile) {
+  int64_t position = begin % size;
+  while (n > 0) {
+    const int64_t length = std::min(n, size - position);
+    std::copy_n(arg + position, length, tile);
+    tile += length;
+    n -= length;
+    position = 0;
+  }
+}
+
+}  // namespace
+
+// Evaluates the ops of the composition one tile of the output at a time, so
+// that the intermediate results stay in cache instead of going through memory
+// like the results of separate kernels do. The ops are evaluated with
+// vectorized Eigen expressions over each tile.
+template <typename T>
+class FusedElementwiseOp : public OpKernel {
+ public:
+  using Packet = typename Eigen::internal::packet_traits<T>::type;
+
+  explicit FusedElementwiseOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    std::vector<std::string> fused_ops;
+    std::vector<int> fused_operands;
+    OP_REQUIRES_OK(context, context->GetAttr("num_args", &num_args_));
+    OP_REQUIRES_OK(context, context->GetAttr("fused_ops", &fused_ops));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("fused_operands", &fused_operands));
+    OP_REQUIRES(context, !fused_ops.empty(),
+                errors::InvalidArgument(
+                    "Elementwise op composition must have at least one op"));
+
+    const auto& fns = FusedElementwiseFns<T>();
+    int num_operands = 0;
+    for (int i = 0; i < fused_ops.size(); ++i) {
+      auto it = fns.find(fused_ops[i]);
+      OP_REQUIRES(context, it != fns.end(),
+                  errors::InvalidArgument(
+                      "Unsupported op in elementwise op composition: ",
+                      fused_ops[i]));
+      Instruction instruction;
+      instruction.fn = it->second;
+      for (int j = 0; j < instruction.fn.num_operands; ++j, ++num_operands) {
+        OP_REQUIRES(context, num_operands < fused_operands.size(),
+                    errors::InvalidArgument("Missing operands of op ", i, ": ",
+                                            fused_ops[i]));
+        const int operand = fused_operands[num_operands];
+        OP_REQUIRES(context, operand >= 0 && operand < num_args_ + i,
+                    errors::InvalidArgument("Invalid operand ", operand,
+                                            " of op ", i, ": ", fused_ops[i]));
+        instruction.operands[j] = operand;
+      }
+      cost_ += instruction.fn.cost;
+      instructions_.push_back(instruction);
+    }
+    OP_REQUIRES(context, num_operands == fused_operands.size(),
+                errors::InvalidArgument("Expected ", num_operands,
+                                        " operands, got ",
+                                        fused_operands.size()));
+    AllocateRegisters();
+
+    VLOG(2) << "Composed elementwise op: [" << absl::StrJoin(fused_ops, ", ")
+            << "]; operands=[" << absl::StrJoin(fused_operands, ", ")
+            << "]; registers=" << num_registers_ << "; cost=" << cost_;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    OpInputList args;
+    OP_REQUIRES_OK(ctx, ctx->input_list("args", &args));
+
+    // The output has the shape of the largest argument, which the other
+    // arguments broadcast to. Of arguments with the same number of elements,
+    // e.g. [1, 3] and [3], the one with the most dimensions is the largest.
+    int largest = 0;
+    for (int i = 1; i < args.size(); ++i) {
+      if (args[i].NumElements() > args[largest].NumElements() ||
+          (args[i].NumElements() == args[largest].NumElements() &&
+           args[i].dims() > args[largest].dims())) {
+        largest = i;
+      }
+    }
+    const TensorShape& shape = args[largest].shape();
+    absl::InlinedVector<int, 4> forwardable_inputs;
+    for (int i = 0; i < args.size(); ++i) {
+      if (args[i].shape() == shape) {
+        forwardable_inputs.push_back(i);
+        continue;
+      }
+      OP_REQUIRES(ctx, IsRepeatedTo(args[i].shape(), shape),
+                  errors::InvalidArgument(
+                      "Argument ", i, " of shape ",
+                      args[i].shape().DebugString(),
+                      " does not broadcast to shape ", shape.DebugString()));
+    }
+
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->forward_input_or_allocate_output(
+                            forwardable_inputs, 0, shape, &out));
+    const int64_t num_elements = shape.num_elements();
+    if (num_elements == 0) return;
+
+    absl::InlinedVector<const T*, 4> arg_data;
+    absl::InlinedVector<int64_t, 4> arg_sizes;
+    int num_repeated_args = 0;
+    for (int i = 0; i < args.size(); ++i) {
+      arg_data.push_back(args[i].flat<T>().data());
+      arg_sizes.push_back(args[i].NumElements());
+      if (arg_sizes.back() != num_elements) ++num_repeated_args;
+    }
+    T* out_data = out->flat<T>().data();
+
+    auto compute_fn = [&](int64_t begin, int64_t end) {
+      // One tile for each repeated argument, followed by the registers.
+      std::unique_ptr<T[]> scratch(
+          new T[(num_repeated_args + num_registers_) * kTileSize]);
+      T* registers = scratch.get() + num_repeated_args * kTileSize;
+
+      absl::InlinedVector<const T*, 16> values(num_args_ +
+                                               instructions_.size());
+      absl::InlinedVector<T*, 4> repeated_tiles(num_args_, nullptr);
+      T* next_tile = scratch.get();
+      for (int i = 0; i < num_args_; ++i) {
+        if (arg_sizes[i] == num_elements) continue;
+        repeated_tiles[i] = next_tile;
+        next_tile += kTileSize;
+        if (arg_sizes[i] == 1) {
+          std::fill_n(repeated_tiles[i], kTileSize, arg_data[i][0]);
+        }
+      }
+
+      for (int64_t tile_begin = begin; tile_begin < end;
+           tile_begin += kTileSize) {
+        const int64_t n = std::min(kTileSize, end - tile_begin);
+        for (int i = 0; i < num_args_; ++i) {
+          if (repeated_tiles[i] == nullptr) {
+            values[i] = arg_data[i] + tile_begin;
+            continue;
+          }
+          if (arg_sizes[i] > 1) {
+            RepeatTile(arg_data[i], arg_sizes[i], tile_begin, n,
+                       repeated_tiles[i]);
+          }
+          values[i] = repeated_tiles[i];
+        }
+        for (int i = 0; i < instructions_.size(); ++i) {
+          const Instruction& instruction = instructions_[i];
+          // The last op writes the output, which may be a forwarded argument:
+          // every op reads the same elements of its operands as it writes.
+          T* result = i + 1 == instructions_.size()
+                          ? out_data + tile_begin
+                          : registers + instruction.result * kTileSize;
+          if (instruction.fn.num_operands == 1) {
+            instruction.fn.unary(values[instruction.operands[0]], result, n);
+          } else {
+            instruction.fn.binary(values[instruction.operands[0]],
+                                  values[instruction.operands[1]], result, n);
+          }
+          values[num_args_ + i] = result;
+        }
+      }
+    };
+
+    const CPUDevice& device = ctx->eigen_device<CPUDevice>();
+    const int kOverheadCycles = static_cast<int>(instructions_.size()) * 10;
+    Eigen::TensorOpCost cost(/*bytes_loaded=*/sizeof(T) * num_args_,
+                             /*bytes_stored=*/sizeof(T),
+                             kOverheadCycles + cost_);
+    device.parallelFor(num_elements, cost, AlignBlockSize,
+                       std::move(compute_fn));
+  }
+
+ private:
+  struct Instruction {
+    FusedElementwiseFn<T> fn;
+    int operands[2] = {0, 0};
+    // Register holding the result, unless the op is the last one.
+    int result = 0;
+  };
+
+  static constexpr int kPacketSize =
+      Eigen::internal::unpacket_traits<Packet>::size;
+
+  static inline int64_t AlignBlockSize(int64_t block_size) {
+    // Align block size to whole tiles, unless it is smaller than a tile.
+    if (block_size >= kTileSize) {
+      return (block_size + kTileSize - 1) / kTileSize * kTileSize;
+    }
+    return (block_size + kPacketSize - 1) & ~(kPacketSize - 1);
+  }
+
+  // Assigns a register to the result of every op but the last one. A register
+  // is reused once the ops reading its value have been evaluated.
+  void AllocateRegisters() {
+    const int num_ops = instructions_.size();
+    std::vector<int> last_use(num_ops, -1);
+    for (int i = 0; i < num_ops; ++i) {
+      for (int j = 0; j < instructions_[i].fn.num_operands; ++j) {
+        const int operand = instructions_[i].operands[j];
+        if (operand >= num_args_) last_use[operand - num_args_] = i;
+      }
+    }
+    std::vector<int> free_registers;
+    for (int i = 0; i + 1 < num_ops; ++i) {
+      Instruction& instruction = instructions_[i];
+      if (free_registers.empty()) {
+        instruction.result = num_registers_++;
+      } else {
+        instruction.result = free_registers.back();
+        free_registers.pop_back();
+      }
+      // Releases the registers of the operands read for the last time, once
+      // the result has its own register.
+      for (int j = 0; j < instruction.fn.num_operands; ++j) {
+        const int operand = instruction.operands[j] - num_args_;
+        if (operand >= 0 && last_use[operand] == i &&
+            (j == 0 || instruction.operands[0] != instruction.operands[1])) {
+          free_registers.push_back(instructions_[operand].result);
+        }
+      }
+      if (last_use[i] < 0) free_registers.push_back(instruction.result);
+    }
+  }
+
+  int num_args_ = 0;
+  std::vector<Instruction> instructions_;
+  int num_registers_ = 0;
+  int cost_ = 0;
+};
+
+#define REGISTER_CPU(T)                                                    \
+  REGISTER_KERNEL_BUILDER(                                                 \
+      Name("_FusedElementwise").Device(DEVICE_CPU).TypeConstraint<T>("T"), \
+      FusedElementwiseOp<T>);
+
+REGISTER_CPU(float);
+REGISTER_CPU(double);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,325 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// A composition of elementwise ops, in the encoding of the
+// `_FusedElementwise` attributes.
+struct Program {
+  int num_args;
+  std::vector<string> ops;
+  std::vector<int> operands;
+};
+
+// tanh(x * scale + bias), with a scalar scale and a bias broadcast over the
+// innermost dimension of x.
+Program ScaleShiftTanh() {
+  // Args: x, scale, bias.
+  return {3, {"Mul", "AddV2", "Tanh"}, {0, 1, 3, 2, 4}};
+}
+
+// The tanh approximation of GELU:
+//   0.5 * x * (1 + tanh(0.797885 * (x + 0.044715 * x^3))),
+// where every argument but x is a scalar.
+Program Gelu() {
+  // Args: x, 0.044715, 0.797885, 1, 0.5.
+  return {5,
+          {"Square", "Mul", "Mul", "AddV2", "Mul", "Tanh", "AddV2", "Mul",
+           "Mul"},
+          {0,          // 5: x^2
+           5, 0,       // 6: x^3
+           6, 1,       // 7: 0.044715 * x^3
+           0, 7,       // 8: x + 0.044715 * x^3
+           8, 2,       // 9: 0.797885 * (...)
+           9,          // 10: tanh(...)
+           10, 3,      // 11: 1 + tanh(...)
+           0, 4,       // 12: 0.5 * x
+           12, 11}};   // 13: output
+}
+
+float GeluReference(float x) {
+  return 0.5f * x *
+         (1.0f + std::tanh(0.797885f * (x + 0.044715f * x * x * x)));
+}
+
+Tensor Scalar(float value) {
+  Tensor tensor(DT_FLOAT, TensorShape({}));
+  tensor.scalar<float>()() = value;
+  return tensor;
+}
+
+std::vector<Tensor> GeluArgs(const Tensor& x) {
+  return {x, Scalar(0.044715f), Scalar(0.797885f), Scalar(1.0f),
+          Scalar(0.5f)};
+}
+
+class FusedElementwiseOpTest : public OpsTestBase {
+ protected:
+  Status InitFusedOp(const Program& program, DataType dtype = DT_FLOAT) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("fused_elementwise", "_FusedElementwise")
+            .Input(FakeInput(program.num_args, dtype))
+            .Attr("T", dtype)
+            .Attr("num_args", program.num_args)
+            .Attr("fused_ops", program.ops)
+            .Attr("fused_operands", program.operands)
+            .Finalize(node_def()));
+    return InitOp();
+  }
+
+  Status RunFusedOp(const Program& program, const std::vector<Tensor>& args) {
+    TF_RETURN_IF_ERROR(InitFusedOp(program));
+    for (const Tensor& arg : args) {
+      AddInputFromArray<float>(
+          arg.shape(),
+          absl::Span<const float>(arg.flat<float>().data(), arg.NumElements()));
+    }
+    return RunOpKernel();
+  }
+};
+
+TEST_F(FusedElementwiseOpTest, ScaleShiftTanh) {
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(&x, {-1.0f, 0.0f, 1.0f, 2.0f, 3.0f, 4.0f});
+  Tensor bias(DT_FLOAT, TensorShape({3}));
+  test::FillValues<float>(&bias, {0.5f, -0.5f, 0.0f});
+
+  TF_ASSERT_OK(RunFusedOp(ScaleShiftTanh(), {x, Scalar(0.25f), bias}));
+
+  Tensor expected(DT_FLOAT, TensorShape({2, 3}));
+  test::FillValues<float>(
+      &expected, {std::tanh(-0.25f + 0.5f), std::tanh(0.0f - 0.5f),
+                  std::tanh(0.25f), std::tanh(0.5f + 0.5f),
+                  std::tanh(0.75f - 0.5f), std::tanh(1.0f)});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, Gelu) {
+  Tensor x(DT_FLOAT, TensorShape({5}));
+  test::FillValues<float>(&x, {-3.0f, -0.5f, 0.0f, 0.5f, 3.0f});
+
+  TF_ASSERT_OK(RunFusedOp(Gelu(), GeluArgs(x)));
+
+  Tensor expected(DT_FLOAT, TensorShape({5}));
+  test::FillValues<float>(&expected,
+                          {GeluReference(-3.0f), GeluReference(-0.5f),
+                           GeluReference(0.0f), GeluReference(0.5f),
+                           GeluReference(3.0f)});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, ManyTiles) {
+  // The innermost dimension does not divide the tiles, so the bias repeats
+  // across tile boundaries.
+  constexpr int kRows = 4099;
+  constexpr int kCols = 7;
+  Tensor x(DT_FLOAT, TensorShape({kRows, kCols}));
+  x.flat<float>().setRandom();
+  Tensor bias(DT_FLOAT, TensorShape({kCols}));
+  bias.flat<float>().setRandom();
+
+  TF_ASSERT_OK(RunFusedOp(ScaleShiftTanh(), {x, Scalar(2.0f), bias}));
+
+  Tensor expected(DT_FLOAT, TensorShape({kRows, kCols}));
+  auto x_matrix = x.matrix<float>();
+  auto expected_matrix = expected.matrix<float>();
+  for (int i = 0; i < kRows; ++i) {
+    for (int j = 0; j < kCols; ++j) {
+      expected_matrix(i, j) =
+          std::tanh(x_matrix(i, j) * 2.0f + bias.flat<float>()(j));
+    }
+  }
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, Double) {
+  TF_ASSERT_OK(InitFusedOp({2, {"Sub", "Square"}, {0, 1, 2}}, DT_DOUBLE));
+  AddInputFromArray<double>(TensorShape({3}), {1.0, 2.0, 3.0});
+  AddInputFromArray<double>(TensorShape({}), {1.5});
+  TF_ASSERT_OK(RunOpKernel());
+
+  Tensor expected(DT_DOUBLE, TensorShape({3}));
+  test::FillValues<double>(&expected, {0.25, 0.25, 2.25});
+  test::ExpectClose(expected, *GetOutput(0));
+}
+
+TEST_F(FusedElementwiseOpTest, UnsupportedOp) {
+  Status status = InitFusedOp({1, {"Tanh", "Erf"}, {0, 1}});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, InvalidOperand) {
+  // The second op reads its own result.
+  Status status = InitFusedOp({1, {"Tanh", "Tanh"}, {0, 2}});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, WrongNumberOfOperands) {
+  Status status = InitFusedOp({2, {"Mul"}, {0, 1, 1}});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+TEST_F(FusedElementwiseOpTest, ArgumentDoesNotBroadcast) {
+  Tensor x(DT_FLOAT, TensorShape({2, 3}));
+  x.flat<float>().setZero();
+  Tensor bias(DT_FLOAT, TensorShape({2}));
+  bias.flat<float>().setZero();
+
+  Status status = RunFusedOp(ScaleShiftTanh(), {x, Scalar(1.0f), bias});
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+// Performance benchmarks below.
+
+// The ops of `program` as separate graph nodes.
+static Graph* UnfusedGraph(const Program& program,
+                           const std::vector<Tensor>& args) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<Node*> values;
+  for (const Tensor& arg : args) {
+    values.push_back(test::graph::Constant(g, arg));
+  }
+  int operand = 0;
+  for (const string& op : program.ops) {
+    NodeBuilder builder(g->NewName("n"), op);
+    // The benchmarked programs only use these unary ops.
+    const int num_operands = (op == "Tanh" || op == "Square") ? 1 : 2;
+    for (int i = 0; i < num_operands; ++i) {
+      builder.Input(values[program.operands[operand++]]);
+    }
+    Node* node;
+    TF_CHECK_OK(builder.Attr("T", DT_FLOAT).Finalize(g, &node));
+    values.push_back(node);
+  }
+  return g;
+}
+
+// The ops of `program` fused into a `_FusedElementwise` node.
+static Graph* FusedGraph(const Program& program,
+                         const std::vector<Tensor>& args) {
+  Graph* g = new Graph(OpRegistry::Global());
+  std::vector<NodeBuilder::NodeOut> inputs;
+  for (const Tensor& arg : args) {
+    inputs.emplace_back(test::graph::Constant(g, arg));
+  }
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_FusedElementwise")
+                  .Input(inputs)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("num_args", program.num_args)
+                  .Attr("fused_ops", program.ops)
+                  .Attr("fused_operands", program.operands)
+                  .Finalize(g, &node));
+  return g;
+}
+
+static Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  return tensor;
+}
+
+static std::vector<Tensor> ScaleShiftTanhArgs(int rows, int cols) {
+  return {RandomTensor(TensorShape({rows, cols})), Scalar(0.5f),
+          RandomTensor(TensorShape({cols}))};
+}
+
+static std::vector<Tensor> GeluArgs(int rows, int cols) {
+  return GeluArgs(RandomTensor(TensorShape({rows, cols})));
+}
+
+// Bytes of full size tensors each graph reads from and writes to memory: the
+// separate kernels read the operands and write the result of every op, while
+// the fused kernel only reads its full size arguments and writes its output.
+static int64_t UnfusedBytes(const Program& program,
+                            const std::vector<Tensor>& args,
+                            int64_t num_elements) {
+  int64_t bytes = program.ops.size() * num_elements * sizeof(float);
+  for (int operand : program.operands) {
+    if (operand >= program.num_args ||
+        args[operand].NumElements() == num_elements) {
+      bytes += num_elements * sizeof(float);
+    }
+  }
+  return bytes;
+}
+
+static int64_t FusedBytes(const std::vector<Tensor>& args,
+                          int64_t num_elements) {
+  int64_t bytes = num_elements * sizeof(float);
+  for (const Tensor& arg : args) {
+    if (arg.NumElements() == num_elements) bytes += arg.TotalBytes();
+  }
+  return bytes;
+}
+
+#define BM_FusedElementwise(PROGRAM, ROWS, COLS)                             \
+  static void BM_Unfused_##PROGRAM##_##ROWS##_##COLS(                        \
+      ::testing::benchmark::State& state) {                                  \
+    const Program program = PROGRAM();                                       \
+    const std::vector<Tensor> args = PROGRAM##Args(ROWS, COLS);              \
+    test::Benchmark("cpu", UnfusedGraph(program, args),                      \
+                    /*old_benchmark_api*/ false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *      \
+                            ROWS * COLS * program.ops.size());               \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *      \
+                            UnfusedBytes(program, args, ROWS * COLS));       \
+  }                                                                          \
+  BENCHMARK(BM_Unfused_##PROGRAM##_##ROWS##_##COLS);                         \
+                                                                             \
+  static void BM_Fused_##PROGRAM##_##ROWS##_##COLS(                          \
+      ::testing::benchmark::State& state) {                                  \
+    const Program program = PROGRAM();                                       \
+    const std::vector<Tensor> args = PROGRAM##Args(ROWS, COLS);              \
+    test::Benchmark("cpu", FusedGraph(program, args),                        \
+                    /*old_benchmark_api*/ false)                             \
+        .Run(state);                                                         \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) *      \
+                            ROWS * COLS * program.ops.size());               \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) *      \
+                            FusedBytes(args, ROWS * COLS));                  \
+  }                                                                          \
+  BENCHMARK(BM_Fused_##PROGRAM##_##ROWS##_##COLS);
+
+// BenchmarkName(program, rows, cols)
+
+BM_FusedElementwise(ScaleShiftTanh, 1024, 64);
+BM_FusedElementwise(ScaleShiftTanh, 4096, 1024);
+BM_FusedElementwise(ScaleShiftTanh, 16384, 1024);
+
+BM_FusedElementwise(Gelu, 1024, 64);
+BM_FusedElementwise(Gelu, 4096, 1024);
+BM_FusedElementwise(Gelu, 16384, 1024);
+
+}  // namespace
+}  // namespace tensorflow
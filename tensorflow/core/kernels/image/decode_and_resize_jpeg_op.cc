@@ -0,0 +1,318 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/image_ops.cc
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/op_requires.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/platform/logging.h"
+#include "tensorflow/core/platform/stringpiece.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace {
+
+// The DCT scaling denominators supported by `jpeg::Uncompress`, largest first.
+constexpr int kDctScales[] = {8, 4, 2, 1};
+
+// Returns the largest DCT scaling denominator for which the crop window,
+// shrunk by the decoder, still has at least as many pixels as the target in
+// both dimensions. Decoding at that scale skips most of the inverse DCT work
+// without ever upsampling what the resize then samples.
+int ChooseDctScale(int crop_height, int crop_width, int target_height,
+                   int target_width) {
+  for (const int scale : kDctScales) {
+    if (static_cast<int64_t>(target_height) * scale <= crop_height &&
+        static_cast<int64_t>(target_width) * scale <= crop_width) {
+      return scale;
+    }
+  }
+  return 1;
+}
+
+// Interpolation of one output coordinate from two input coordinates.
+struct Interpolation {
+  int64_t lower;
+  int64_t upper;
+  float lerp;
+};
+
+// Computes the bilinear interpolation, with half pixel centers, of the
+// `out_size` output coordinates from the window [`in_start`, `in_start` +
+// `in_size`) of the original image, in the `decoded_size` pixels decoded from
+// the scaled window starting at `decoded_start` with scale `scale`. The input
+// indices are scaled by `channels`.
+std::vector<Interpolation> ComputeInterpolations(int64_t out_size,
+                                                 int64_t in_start,
+                                                 int64_t in_size, int scale,
+                                                 int64_t decoded_start,
+                                                 int64_t decoded_size,
+                                                 int64_t channels) {
+  std::vector<Interpolation> interpolations(out_size);
+  const double step = static_cast<double>(in_size) / out_size;
+  for (int64_t i = 0; i < out_size; ++i) {
+    // The center of the output pixel in the original image, then in the
+    // decoded pixels, which are `scale` times larger.
+    const double in = in_start + (i + 0.5) * step;
+    const double decoded = in / scale - 0.5 - decoded_start;
+    const double clamped =
+        std::min<double>(std::max(decoded, 0.0), decoded_size - 1);
+    const int64_t lower = static_cast<int64_t>(std::floor(clamped));
+    Interpolation& interpolation = interpolations[i];
+    interpolation.lower = lower * channels;
+    interpolation.upper = std::min(lower + 1, decoded_size - 1) * channels;
+    interpolation.lerp = static_cast<float>(clamped - lower);
+  }
+  return interpolations;
+}
+
+// Resizes the `channels`-channel row `in` horizontally into `out`.
+void ResizeRow(const uint8* in, const std::vector<Interpolation>& xs,
+               int channels, float* out) {
+  const int64_t out_width = xs.size();
+  for (int64_t x = 0; x < out_width; ++x) {
+    const Interpolation& xi = xs[x];
+    const uint8* left = in + xi.lower;
+    const uint8* right = in + xi.upper;
+    for (int c = 0; c < channels; ++c) {
+      const float l = left[c];
+      out[c] = l + (right[c] - l) * xi.lerp;
+    }
+    out += channels;
+  }
+}
+
+// Decodes a JPEG image and resizes a crop window of it to a fixed size.
+//
+// The image is decoded at the largest DCT scale which keeps at least as many
+// pixels as the output, and only the scanlines and the MCU columns covering
+// the crop window are decoded. The resize is separable: each decoded row is
+// resized horizontally at most once, and the two rows surrounding an output
+// row are blended vertically.
+class DecodeAndResizeJpegOp : public OpKernel {
+ public:
+  explicit DecodeAndResizeJpegOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+    OP_REQUIRES(context, channels_ == 0 || channels_ == 1 || channels_ == 3,
+                errors::InvalidArgument("channels must be 0, 1, or 3 for "
+                                        "DecodeAndResizeJpeg, got ",
+                                        channels_));
+    OP_REQUIRES_OK(context, context->GetAttr("fancy_upscaling",
+                                             &flags_.fancy_upscaling));
+    OP_REQUIRES_OK(context,
+                   context->GetAttr("try_recover_truncated",
+                                    &flags_.try_recover_truncated_jpeg));
+    OP_REQUIRES_OK(context, context->GetAttr("acceptable_fraction",
+                                             &flags_.min_acceptable_fraction));
+    string dct_method;
+    OP_REQUIRES_OK(context, context->GetAttr("dct_method", &dct_method));
+    OP_REQUIRES(
+        context,
+        (dct_method.empty() || dct_method == "INTEGER_FAST" ||
+         dct_method == "INTEGER_ACCURATE"),
+        errors::InvalidArgument("dct_method must be one of "
+                                "{'', 'INTEGER_FAST', 'INTEGER_ACCURATE'}"));
+    if (dct_method.empty() || dct_method == "INTEGER_FAST") {
+      flags_.dct_method = JDCT_IFAST;
+    } else if (dct_method == "INTEGER_ACCURATE") {
+      flags_.dct_method = JDCT_ISLOW;
+    }
+    flags_.components = channels_;
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& contents = context->input(0);
+    OP_REQUIRES(context, TensorShapeUtils::IsScalar(contents.shape()),
+                errors::InvalidArgument("`contents` must be scalar but got ",
+                                        contents.shape().DebugString()));
+    const StringPiece input = contents.scalar<tstring>()();
+    OP_REQUIRES(context, !input.empty(),
+                errors::InvalidArgument("Input is empty."));
+    OP_REQUIRES(context, input.size() <= std::numeric_limits<int>::max(),
+                errors::InvalidArgument(
+                    "Input contents are too large for int: ", input.size()));
+
+    const Tensor& size = context->input(2);
+    OP_REQUIRES(context, size.dims() == 1 && size.NumElements() == 2,
+                errors::InvalidArgument("size must be 1-D with two elements, "
+                                        "got shape ",
+                                        size.shape().DebugString()));
+    const int target_height = size.vec<int32>()(0);
+    const int target_width = size.vec<int32>()(1);
+    OP_REQUIRES(context, target_height > 0 && target_width > 0,
+                errors::InvalidArgument("size must be positive, got [",
+                                        target_height, ", ", target_width,
+                                        "]"));
+
+    int image_width, image_height, image_channels;
+    OP_REQUIRES(context,
+                jpeg::GetImageInfo(input.data(), input.size(), &image_width,
+                                   &image_height, &image_channels),
+                errors::InvalidArgument("Invalid JPEG data, size ",
+                                        input.size()));
+
+    const Tensor& crop_window = context->input(1);
+    OP_REQUIRES(context, crop_window.dims() == 1,
+                errors::InvalidArgument("crop_window must be 1-D, got shape ",
+                                        crop_window.shape().DebugString()));
+    OP_REQUIRES(
+        context,
+        crop_window.NumElements() == 0 || crop_window.NumElements() == 4,
+        errors::InvalidArgument("crop_window must be empty or have four "
+                                "elements, got shape ",
+                                crop_window.shape().DebugString()));
+    int crop_y = 0, crop_x = 0;
+    int crop_height = image_height, crop_width = image_width;
+    if (crop_window.NumElements() == 4) {
+      auto crop_window_vec = crop_window.vec<int32>();
+      crop_y = crop_window_vec(0);
+      crop_x = crop_window_vec(1);
+      crop_height = crop_window_vec(2);
+      crop_width = crop_window_vec(3);
+    }
+    OP_REQUIRES(
+        context,
+        crop_y >= 0 && crop_x >= 0 && crop_height > 0 && crop_width > 0 &&
+            static_cast<int64_t>(crop_y) + crop_height <= image_height &&
+            static_cast<int64_t>(crop_x) + crop_width <= image_width,
+        errors::InvalidArgument("Invalid crop window [", crop_y, ", ", crop_x,
+                                ", ", crop_height, ", ", crop_width,
+                                "] for image of size ", image_height, "x",
+                                image_width));
+
+    // Maps the crop window onto the pixels the decoder produces at the chosen
+    // scale: libjpeg scales an image of size `n` to `ceil(n / scale)`.
+    jpeg::UncompressFlags flags = flags_;
+    flags.ratio =
+        ChooseDctScale(crop_height, crop_width, target_height, target_width);
+    const int scaled_height = (image_height + flags.ratio - 1) / flags.ratio;
+    const int scaled_width = (image_width + flags.ratio - 1) / flags.ratio;
+    flags.crop = true;
+    flags.crop_y = crop_y / flags.ratio;
+    flags.crop_x = crop_x / flags.ratio;
+    flags.crop_height =
+        std::min((crop_y + crop_height + flags.ratio - 1) / flags.ratio,
+                 scaled_height) -
+        flags.crop_y;
+    flags.crop_width =
+        std::min((crop_x + crop_width + flags.ratio - 1) / flags.ratio,
+                 scaled_width) -
+        flags.crop_x;
+
+    Tensor decoded;
+    int decoded_channels = 0;
+    const uint8* buffer = jpeg::Uncompress(
+        input.data(), input.size(), flags, /*nwarn=*/nullptr,
+        [&](int width, int height, int channels) -> uint8* {
+          Status status = context->allocate_temp(
+              DT_UINT8, TensorShape({height, width, channels}), &decoded);
+          if (!status.ok()) {
+            VLOG(1) << status;
+            context->SetStatus(status);
+            return nullptr;
+          }
+          decoded_channels = channels;
+          return decoded.flat<uint8>().data();
+        });
+    OP_REQUIRES(
+        context, buffer,
+        errors::InvalidArgument(
+            "jpeg::Uncompress failed. Invalid JPEG data or crop window."));
+
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       TensorShape({target_height, target_width,
+                                    decoded_channels}),
+                       &output));
+    Resize(decoded, crop_y, crop_x, crop_height, crop_width, flags, output);
+  }
+
+ private:
+  // Resizes the crop window of the original image to `output`, from the
+  // `decoded` pixels of its scaled crop window.
+  void Resize(const Tensor& decoded, int crop_y, int crop_x, int crop_height,
+              int crop_width, const jpeg::UncompressFlags& flags,
+              Tensor* output) const {
+    const int64_t decoded_height = decoded.dim_size(0);
+    const int64_t decoded_width = decoded.dim_size(1);
+    const int channels = decoded.dim_size(2);
+    const int64_t out_height = output->dim_size(0);
+    const int64_t out_width = output->dim_size(1);
+    const int64_t decoded_row_size = decoded_width * channels;
+    const int64_t out_row_size = out_width * channels;
+
+    const std::vector<Interpolation> ys = ComputeInterpolations(
+        out_height, crop_y, crop_height, flags.ratio, flags.crop_y,
+        decoded_height, /*channels=*/1);
+    const std::vector<Interpolation> xs =
+        ComputeInterpolations(out_width, crop_x, crop_width, flags.ratio,
+                              flags.crop_x, decoded_width, channels);
+
+    // The horizontally resized rows `rows[i]` of the decoded row
+    // `row_indices[i]`. Output rows are produced in order, so each decoded
+    // row is resized at most once.
+    std::vector<float> rows[2] = {std::vector<float>(out_row_size),
+                                  std::vector<float>(out_row_size)};
+    int64_t row_indices[2] = {-1, -1};
+    auto resized_row = [&](int64_t y) -> const float* {
+      for (int i = 0; i < 2; ++i) {
+        if (row_indices[i] == y) return rows[i].data();
+      }
+      // Replaces the row which is not the other end of the current
+      // interpolation, i.e. the lower-indexed one.
+      const int i = row_indices[0] < row_indices[1] ? 0 : 1;
+      ResizeRow(decoded.flat<uint8>().data() + y * decoded_row_size, xs,
+                channels, rows[i].data());
+      row_indices[i] = y;
+      return rows[i].data();
+    };
+
+    float* out = output->flat<float>().data();
+    for (int64_t y = 0; y < out_height; ++y) {
+      const Interpolation& yi = ys[y];
+      const float* top = resized_row(yi.lower);
+      const float* bottom = resized_row(yi.upper);
+      const float lerp = yi.lerp;
+      for (int64_t i = 0; i < out_row_size; ++i) {
+        out[i] = top[i] + (bottom[i] - top[i]) * lerp;
+      }
+      out += out_row_size;
+    }
+  }
+
+  int channels_;
+  jpeg::UncompressFlags flags_;
+};
+
+REGISTER_KERNEL_BUILDER(Name("DecodeAndResizeJpeg").Device(DEVICE_CPU),
+                        DecodeAndResizeJpegOp);
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <vector>
+
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/lib/random/simple_philox.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+
+// Returns a scalar string tensor holding a `width`x`height` RGB JPEG image of
+// a noisy gradient.
+static Tensor EncodedImage(int width, int height) {
+  random::PhiloxRandom philox(301, 17);
+  random::SimplePhilox rnd(&philox);
+  std::vector<uint8> pixels(width * height * 3);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < 3; ++c) {
+        pixels[(y * width + x) * 3 + c] =
+            ((x + y) * (c + 1) + rnd.Uniform(32)) % 256;
+      }
+    }
+  }
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  Tensor contents(DT_STRING, TensorShape({}));
+  contents.scalar<tstring>()() =
+      jpeg::Compress(pixels.data(), width, height, flags);
+  return contents;
+}
+
+static Tensor Size(int height, int width) {
+  Tensor size(DT_INT32, TensorShape({2}));
+  size.flat<int32>()(0) = height;
+  size.flat<int32>()(1) = width;
+  return size;
+}
+
+// Crops the central 80% of the image, as inference pipelines often do.
+static Tensor CentralCropWindow(int width, int height) {
+  Tensor crop_window(DT_INT32, TensorShape({4}));
+  auto crop_window_flat = crop_window.flat<int32>();
+  crop_window_flat(0) = height / 10;
+  crop_window_flat(1) = width / 10;
+  crop_window_flat(2) = height * 8 / 10;
+  crop_window_flat(3) = width * 8 / 10;
+  return crop_window;
+}
+
+static Graph* DecodeAndResizeJpeg(int width, int height, int out_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "DecodeAndResizeJpeg")
+                  .Input(test::graph::Constant(g, EncodedImage(width, height)))
+                  .Input(test::graph::Constant(
+                      g, CentralCropWindow(width, height)))
+                  .Input(test::graph::Constant(g, Size(out_size, out_size)))
+                  .Attr("channels", 3)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+// The unfused pipeline: decodes the crop window at full scale, then resizes
+// it with `ResizeBilinear`.
+static Graph* DecodeThenResize(int width, int height, int out_size) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* decoded;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "DecodeAndCropJpeg")
+                  .Input(test::graph::Constant(g, EncodedImage(width, height)))
+                  .Input(test::graph::Constant(
+                      g, CentralCropWindow(width, height)))
+                  .Attr("channels", 3)
+                  .Finalize(g, &decoded));
+  Tensor axis(DT_INT32, TensorShape({}));
+  axis.scalar<int32>()() = 0;
+  Node* batched;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ExpandDims")
+                  .Input(decoded)
+                  .Input(test::graph::Constant(g, axis))
+                  .Finalize(g, &batched));
+  Node* ret;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "ResizeBilinear")
+                  .Input(batched)
+                  .Input(test::graph::Constant(g, Size(out_size, out_size)))
+                  .Attr("half_pixel_centers", true)
+                  .Finalize(g, &ret));
+  return g;
+}
+
+#define BM_DecodeAndResizeJpegDev(DEVICE, FUNC, W, H, S)                  \
+  static void BM_##FUNC##_##DEVICE##_##W##_##H##_##S(                    \
+      ::testing::benchmark::State& state) {                              \
+    test::Benchmark(#DEVICE, FUNC(W, H, S), /*old_benchmark_api*/ false) \
+        .Run(state);                                                     \
+    state.SetItemsProcessed(state.iterations());                         \
+  }                                                                      \
+  BENCHMARK(BM_##FUNC##_##DEVICE##_##W##_##H##_##S);
+
+BM_DecodeAndResizeJpegDev(cpu, DecodeAndResizeJpeg, 1024, 768, 224);
+BM_DecodeAndResizeJpegDev(cpu, DecodeThenResize, 1024, 768, 224);
+BM_DecodeAndResizeJpegDev(cpu, DecodeAndResizeJpeg, 1024, 768, 512);
+BM_DecodeAndResizeJpegDev(cpu, DecodeThenResize, 1024, 768, 512);
+BM_DecodeAndResizeJpegDev(cpu, DecodeAndResizeJpeg, 4032, 3024, 224);
+BM_DecodeAndResizeJpegDev(cpu, DecodeThenResize, 4032, 3024, 224);
+
+}  // namespace tensorflow
@@ -0,0 +1,197 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "absl/strings/match.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/lib/jpeg/jpeg_mem.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/tstring.h"
+
+namespace tensorflow {
+namespace {
+
+constexpr int kImageHeight = 96;
+constexpr int kImageWidth = 128;
+constexpr int kChannels = 3;
+
+// Encodes a smooth RGB gradient, which DCT scaling reproduces closely.
+tstring EncodeGradient() {
+  std::vector<uint8> pixels(kImageHeight * kImageWidth * kChannels);
+  for (int y = 0; y < kImageHeight; ++y) {
+    for (int x = 0; x < kImageWidth; ++x) {
+      uint8* pixel = &pixels[(y * kImageWidth + x) * kChannels];
+      pixel[0] = x * 255 / (kImageWidth - 1);
+      pixel[1] = y * 255 / (kImageHeight - 1);
+      pixel[2] = (x + y) * 255 / (kImageWidth + kImageHeight - 2);
+    }
+  }
+  jpeg::CompressFlags flags;
+  flags.format = jpeg::FORMAT_RGB;
+  flags.quality = 100;
+  return jpeg::Compress(pixels.data(), kImageWidth, kImageHeight, flags);
+}
+
+// Decodes `contents` in full and resizes the crop window with half pixel
+// centered bilinear interpolation, like `ResizeBilinear`.
+Tensor DecodeThenResize(const tstring& contents, int crop_y, int crop_x,
+                        int crop_height, int crop_width, int height,
+                        int width) {
+  jpeg::UncompressFlags flags;
+  flags.dct_method = JDCT_ISLOW;
+  int image_width = 0, image_channels = 0;
+  std::unique_ptr<uint8[]> image(jpeg::Uncompress(
+      contents.data(), contents.size(), flags, /*nwarn=*/nullptr,
+      [&](int w, int h, int c) {
+        image_width = w;
+        image_channels = c;
+        return new uint8[w * h * c];
+      }));
+  CHECK(image != nullptr);
+
+  auto interpolate = [](int out, int out_size, int in_start, int in_size,
+                        int* lower, int* upper, double* lerp) {
+    const double in = (out + 0.5) * in_size / out_size - 0.5;
+    const double clamped = std::min<double>(std::max(in, 0.0), in_size - 1);
+    *lower = static_cast<int>(std::floor(clamped));
+    *upper = std::min(*lower + 1, in_size - 1);
+    *lerp = clamped - *lower;
+    *lower += in_start;
+    *upper += in_start;
+  };
+  auto pixel = [&](int y, int x, int c) -> double {
+    return image[(y * image_width + x) * image_channels + c];
+  };
+  Tensor expected(DT_FLOAT, TensorShape({height, width, image_channels}));
+  auto expected_tensor = expected.tensor<float, 3>();
+  for (int y = 0; y < height; ++y) {
+    int y0, y1;
+    double ly;
+    interpolate(y, height, crop_y, crop_height, &y0, &y1, &ly);
+    for (int x = 0; x < width; ++x) {
+      int x0, x1;
+      double lx;
+      interpolate(x, width, crop_x, crop_width, &x0, &x1, &lx);
+      for (int c = 0; c < image_channels; ++c) {
+        const double top = pixel(y0, x0, c) + (pixel(y0, x1, c) -
+                                               pixel(y0, x0, c)) * lx;
+        const double bottom = pixel(y1, x0, c) + (pixel(y1, x1, c) -
+                                                  pixel(y1, x0, c)) * lx;
+        expected_tensor(y, x, c) = top + (bottom - top) * ly;
+      }
+    }
+  }
+  return expected;
+}
+
+class DecodeAndResizeJpegOpTest : public OpsTestBase {
+ protected:
+  void MakeOp(int channels) {
+    TF_ASSERT_OK(NodeDefBuilder("decode_and_resize_jpeg", "DecodeAndResizeJpeg")
+                     .Input(FakeInput(DT_STRING))
+                     .Input(FakeInput(DT_INT32))
+                     .Input(FakeInput(DT_INT32))
+                     .Attr("channels", channels)
+                     .Attr("dct_method", "INTEGER_ACCURATE")
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+  }
+
+  Status Run(const tstring& contents, const std::vector<int32>& crop_window,
+             int height, int width) {
+    AddInputFromArray<tstring>(TensorShape({}), {contents});
+    AddInputFromArray<int32>(
+        TensorShape({static_cast<int64_t>(crop_window.size())}), crop_window);
+    AddInputFromArray<int32>(TensorShape({2}), {height, width});
+    return RunOpKernel();
+  }
+};
+
+TEST_F(DecodeAndResizeJpegOpTest, UpsamplingMatchesDecodeThenResize) {
+  // Upsampling decodes at full scale, so only rounding differs.
+  MakeOp(/*channels=*/3);
+  const tstring contents = EncodeGradient();
+  TF_ASSERT_OK(Run(contents, {10, 20, 30, 40}, 45, 50));
+  test::ExpectClose(*GetOutput(0),
+                    DecodeThenResize(contents, 10, 20, 30, 40, 45, 50),
+                    /*atol=*/1e-3, /*rtol=*/0);
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, DownsamplingApproximatesDecodeThenResize) {
+  // The whole image is decoded at 1/4 scale; DCT scaling averages pixels
+  // instead of interpolating them, which a smooth image hides.
+  MakeOp(/*channels=*/0);
+  const tstring contents = EncodeGradient();
+  TF_ASSERT_OK(Run(contents, {}, 24, 32));
+  EXPECT_EQ(GetOutput(0)->shape(), TensorShape({24, 32, kChannels}));
+  test::ExpectClose(*GetOutput(0),
+                    DecodeThenResize(contents, 0, 0, kImageHeight, kImageWidth,
+                                     24, 32),
+                    /*atol=*/4, /*rtol=*/0);
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, DownsamplingCropWindow) {
+  // A crop window which is not aligned to the 1/2 scale grid.
+  MakeOp(/*channels=*/3);
+  const tstring contents = EncodeGradient();
+  TF_ASSERT_OK(Run(contents, {13, 7, 61, 83}, 20, 30));
+  test::ExpectClose(*GetOutput(0),
+                    DecodeThenResize(contents, 13, 7, 61, 83, 20, 30),
+                    /*atol=*/4, /*rtol=*/0);
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, Grayscale) {
+  MakeOp(/*channels=*/1);
+  TF_ASSERT_OK(Run(EncodeGradient(), {}, 10, 10));
+  EXPECT_EQ(GetOutput(0)->shape(), TensorShape({10, 10, 1}));
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InvalidCropWindow) {
+  MakeOp(/*channels=*/3);
+  Status status = Run(EncodeGradient(), {90, 0, 10, 10}, 5, 5);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "Invalid crop window"))
+      << status;
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InvalidSize) {
+  MakeOp(/*channels=*/3);
+  Status status = Run(EncodeGradient(), {}, 0, 5);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+  EXPECT_TRUE(absl::StrContains(status.message(), "size must be positive"))
+      << status;
+}
+
+TEST_F(DecodeAndResizeJpegOpTest, InvalidJpeg) {
+  MakeOp(/*channels=*/3);
+  Status status = Run("not a jpeg", {}, 5, 5);
+  EXPECT_TRUE(errors::IsInvalidArgument(status));
+}
+
+}  // namespace
+}  // namespace tensorflow
@@ -0,0 +1,474 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/nn_ops.cc.
+//
+// The kernels below work on tensors in the blocked NCHWc layout, where the
+// innermost dimension holds a block of channels as wide as a SIMD register.
+// The loops over a block have a constant trip count, which the compiler turns
+// into vector instructions, so there is no packing of the data as in the
+// Eigen spatial convolutions.
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "tensorflow/core/framework/kernel_shape_util.h"
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/padding.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+namespace {
+
+// A window over the rows and columns of an input, with its padding.
+struct NCHWcWindow {
+  int64_t filter_rows;
+  int64_t filter_cols;
+  int64_t stride_rows;
+  int64_t stride_cols;
+  int64_t in_rows;
+  int64_t in_cols;
+  int64_t out_rows;
+  int64_t out_cols;
+  int64_t pad_top;
+  int64_t pad_left;
+
+  // Returns the range [begin, end) of the output columns reading input
+  // columns for the filter column `col`.
+  void ValidOutputCols(int64_t col, int64_t* begin, int64_t* end) const {
+    const int64_t first = pad_left - col;
+    *begin = first > 0 ? (first + stride_cols - 1) / stride_cols : 0;
+    const int64_t last = in_cols - 1 + pad_left - col;
+    *end = last < 0 ? 0 : std::min(out_cols, last / stride_cols + 1);
+  }
+};
+
+Status GetNCHWcWindow(const Tensor& input, int64_t filter_rows,
+                      int64_t filter_cols, const std::vector<int32>& strides,
+                      Padding padding, NCHWcWindow* window) {
+  window->filter_rows = filter_rows;
+  window->filter_cols = filter_cols;
+  window->stride_rows = strides[0];
+  window->stride_cols = strides[1];
+  window->in_rows = input.dim_size(2);
+  window->in_cols = input.dim_size(3);
+  int64_t unused;
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeVerbose(
+      window->in_rows, filter_rows, /*dilation_rate=*/1, strides[0], padding,
+      &window->out_rows, &window->pad_top, &unused));
+  return GetWindowedOutputSizeVerbose(window->in_cols, filter_cols,
+                                      /*dilation_rate=*/1, strides[1], padding,
+                                      &window->out_cols, &window->pad_left,
+                                      &unused);
+}
+
+Status GetStrides(OpKernelConstruction* context, const string& name,
+                  std::vector<int32>* values) {
+  TF_RETURN_IF_ERROR(context->GetAttr(name, values));
+  if (values->size() != 2 || (*values)[0] < 1 || (*values)[1] < 1) {
+    return errors::InvalidArgument(
+        name, " must contain 2 positive values for the rows and columns");
+  }
+  return absl::OkStatus();
+}
+
+// Computes output row `out_row` of output channel block `out_block` of image
+// `image` of a convolution. `filter` has the shape
+// [out_blocks, filter_rows, filter_cols, in_blocks * kBlock, kBlock].
+template <int kBlock>
+void NCHWcConvRow(const float* input, const float* filter, const float* bias,
+                  int64_t in_blocks, const NCHWcWindow& w, int64_t image,
+                  int64_t out_block, int64_t out_row, int64_t out_blocks,
+                  float* output) {
+  float* out = output + ((image * out_blocks + out_block) * w.out_rows +
+                         out_row) * w.out_cols * kBlock;
+  const float* block_bias = bias + out_block * kBlock;
+  for (int64_t col = 0; col < w.out_cols; ++col) {
+    for (int c = 0; c < kBlock; ++c) out[col * kBlock + c] = block_bias[c];
+  }
+  const int64_t in_channels = in_blocks * kBlock;
+  for (int64_t fr = 0; fr < w.filter_rows; ++fr) {
+    const int64_t in_row = out_row * w.stride_rows - w.pad_top + fr;
+    if (in_row < 0 || in_row >= w.in_rows) continue;
+    for (int64_t ib = 0; ib < in_blocks; ++ib) {
+      const float* in = input + ((image * in_blocks + ib) * w.in_rows +
+                                 in_row) * w.in_cols * kBlock;
+      for (int64_t fc = 0; fc < w.filter_cols; ++fc) {
+        int64_t begin, end;
+        w.ValidOutputCols(fc, &begin, &end);
+        // The [kBlock, kBlock] weights from the input channels of block `ib`
+        // to the output channels of `out_block`.
+        const float* weights =
+            filter + (((out_block * w.filter_rows + fr) * w.filter_cols + fc) *
+                          in_channels +
+                      ib * kBlock) *
+                         kBlock;
+        for (int64_t col = begin; col < end; ++col) {
+          const float* x =
+              in + (col * w.stride_cols - w.pad_left + fc) * kBlock;
+          float* y = out + col * kBlock;
+          for (int ic = 0; ic < kBlock; ++ic) {
+            const float value = x[ic];
+            const float* weight = weights + ic * kBlock;
+            for (int c = 0; c < kBlock; ++c) y[c] += value * weight[c];
+          }
+        }
+      }
+    }
+  }
+}
+
+template <int kBlock, bool kMax>
+void NCHWcPoolRow(const float* input, const NCHWcWindow& w,
+                  int64_t image_block, int64_t out_row, float* output) {
+  const float* in = input + image_block * w.in_rows * w.in_cols * kBlock;
+  float* out = output + (image_block * w.out_rows + out_row) * w.out_cols *
+                            kBlock;
+  const int64_t row_start = out_row * w.stride_rows - w.pad_top;
+  const int64_t row_begin = std::max<int64_t>(row_start, 0);
+  const int64_t row_end = std::min(row_start + w.filter_rows, w.in_rows);
+  for (int64_t col = 0; col < w.out_cols; ++col) {
+    const int64_t col_start = col * w.stride_cols - w.pad_left;
+    const int64_t col_begin = std::max<int64_t>(col_start, 0);
+    const int64_t col_end = std::min(col_start + w.filter_cols, w.in_cols);
+    float acc[kBlock];
+    for (int c = 0; c < kBlock; ++c) {
+      acc[c] = kMax ? std::numeric_limits<float>::lowest() : 0.0f;
+    }
+    for (int64_t r = row_begin; r < row_end; ++r) {
+      for (int64_t k = col_begin; k < col_end; ++k) {
+        const float* x = in + (r * w.in_cols + k) * kBlock;
+        for (int c = 0; c < kBlock; ++c) {
+          acc[c] = kMax ? std::max(acc[c], x[c]) : acc[c] + x[c];
+        }
+      }
+    }
+    float* y = out + col * kBlock;
+    if (kMax) {
+      for (int c = 0; c < kBlock; ++c) y[c] = acc[c];
+    } else {
+      const float scale =
+          1.0f / std::max<int64_t>((row_end - row_begin) *
+                                       (col_end - col_begin),
+                                   1);
+      for (int c = 0; c < kBlock; ++c) y[c] = acc[c] * scale;
+    }
+  }
+}
+
+bool IsSupportedBlockSize(int64_t block_size) {
+  return block_size == 4 || block_size == 8 || block_size == 16;
+}
+
+}  // namespace
+
+class NHWCToNCHWcOp : public OpKernel {
+ public:
+  explicit NHWCToNCHWcOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("block_size", &block_size_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OP_REQUIRES(context, x.dims() == 4,
+                errors::InvalidArgument("x must be 4-dimensional, got shape ",
+                                        x.shape().DebugString()));
+    const int64_t batch = x.dim_size(0);
+    const int64_t rows = x.dim_size(1);
+    const int64_t cols = x.dim_size(2);
+    const int64_t channels = x.dim_size(3);
+    const int64_t blocks = (channels + block_size_ - 1) / block_size_;
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0, TensorShape({batch, blocks, rows, cols, block_size_}),
+                       &y));
+    const float* in = x.flat<float>().data();
+    float* out = y->flat<float>().data();
+    const int64_t block_size = block_size_;
+    // Each unit is a row of a channel block of an image.
+    auto convert = [&](int64_t begin, int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t row = unit % rows;
+        const int64_t block = (unit / rows) % blocks;
+        const int64_t image = unit / (rows * blocks);
+        const int64_t c0 = block * block_size;
+        const int64_t valid = std::min(block_size, channels - c0);
+        float* dst = out + unit * cols * block_size;
+        const float* src = in + ((image * rows + row) * cols) * channels + c0;
+        for (int64_t col = 0; col < cols; ++col) {
+          std::copy_n(src + col * channels, valid, dst + col * block_size);
+          std::fill(dst + col * block_size + valid,
+                    dst + (col + 1) * block_size, 0.0f);
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    Shard(workers.num_threads, workers.workers, batch * blocks * rows,
+          /*cost_per_unit=*/cols * block_size, convert);
+  }
+
+ private:
+  int64_t block_size_;
+};
+
+class NCHWcToNHWCOp : public OpKernel {
+ public:
+  explicit NCHWcToNHWCOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("channels", &channels_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& x = context->input(0);
+    OP_REQUIRES(context, x.dims() == 5,
+                errors::InvalidArgument("x must be 5-dimensional, got shape ",
+                                        x.shape().DebugString()));
+    const int64_t batch = x.dim_size(0);
+    const int64_t blocks = x.dim_size(1);
+    const int64_t rows = x.dim_size(2);
+    const int64_t cols = x.dim_size(3);
+    const int64_t block_size = x.dim_size(4);
+    const int64_t channels = channels_;
+    OP_REQUIRES(context, channels <= blocks * block_size,
+                errors::InvalidArgument("x has fewer than ", channels,
+                                        " channels: ",
+                                        x.shape().DebugString()));
+    Tensor* y = nullptr;
+    OP_REQUIRES_OK(context, context->allocate_output(
+                                0, TensorShape({batch, rows, cols, channels}),
+                                &y));
+    const float* in = x.flat<float>().data();
+    float* out = y->flat<float>().data();
+    // Each unit is a row of an image.
+    auto convert = [&](int64_t begin, int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t row = unit % rows;
+        const int64_t image = unit / rows;
+        float* dst = out + unit * cols * channels;
+        for (int64_t block = 0; block < blocks; ++block) {
+          const int64_t c0 = block * block_size;
+          const int64_t valid = std::min(block_size, channels - c0);
+          if (valid <= 0) break;
+          const float* src =
+              in + ((image * blocks + block) * rows + row) * cols * block_size;
+          for (int64_t col = 0; col < cols; ++col) {
+            std::copy_n(src + col * block_size, valid,
+                        dst + col * channels + c0);
+          }
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    Shard(workers.num_threads, workers.workers, batch * rows,
+          /*cost_per_unit=*/cols * channels, convert);
+  }
+
+ private:
+  int64_t channels_;
+};
+
+class NCHWcConv2DOp : public OpKernel {
+ public:
+  explicit NCHWcConv2DOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetStrides(context, "strides", &strides_));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+    string activation;
+    OP_REQUIRES_OK(context, context->GetAttr("activation", &activation));
+    relu_ = activation != "Identity";
+    relu6_ = activation == "Relu6";
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    const Tensor& filter = context->input(1);
+    const Tensor& bias = context->input(2);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional, got ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, filter.dims() == 5,
+                errors::InvalidArgument("filter must be 5-dimensional, got ",
+                                        filter.shape().DebugString()));
+    const int64_t block_size = input.dim_size(4);
+    OP_REQUIRES(context, IsSupportedBlockSize(block_size),
+                errors::InvalidArgument("Unsupported block size ",
+                                        block_size));
+    const int64_t in_blocks = input.dim_size(1);
+    const int64_t out_blocks = filter.dim_size(0);
+    OP_REQUIRES(context,
+                filter.dim_size(3) == in_blocks * block_size &&
+                    filter.dim_size(4) == block_size,
+                errors::InvalidArgument("filter of shape ",
+                                        filter.shape().DebugString(),
+                                        " does not match the input of shape ",
+                                        input.shape().DebugString()));
+    OP_REQUIRES(context, bias.NumElements() == out_blocks * block_size,
+                errors::InvalidArgument("bias must have ",
+                                        out_blocks * block_size,
+                                        " elements, got shape ",
+                                        bias.shape().DebugString()));
+    NCHWcWindow window;
+    OP_REQUIRES_OK(context,
+                   GetNCHWcWindow(input, filter.dim_size(1),
+                                  filter.dim_size(2), strides_, padding_,
+                                  &window));
+    const int64_t batch = input.dim_size(0);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       TensorShape({batch, out_blocks, window.out_rows,
+                                    window.out_cols, block_size}),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    const float* in = input.flat<float>().data();
+    const float* weights = filter.flat<float>().data();
+    const float* biases = bias.flat<float>().data();
+    float* out = output->flat<float>().data();
+    const bool relu = relu_;
+    const bool relu6 = relu6_;
+    // Each unit is an output row of a channel block of an image.
+    auto compute = [&](int64_t begin, int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t row = unit % window.out_rows;
+        const int64_t out_block = (unit / window.out_rows) % out_blocks;
+        const int64_t image = unit / (window.out_rows * out_blocks);
+        switch (block_size) {
+          case 4:
+            NCHWcConvRow<4>(in, weights, biases, in_blocks, window, image,
+                            out_block, row, out_blocks, out);
+            break;
+          case 8:
+            NCHWcConvRow<8>(in, weights, biases, in_blocks, window, image,
+                            out_block, row, out_blocks, out);
+            break;
+          case 16:
+            NCHWcConvRow<16>(in, weights, biases, in_blocks, window, image,
+                             out_block, row, out_blocks, out);
+            break;
+        }
+        if (relu) {
+          float* y = out + unit * window.out_cols * block_size;
+          for (int64_t i = 0; i < window.out_cols * block_size; ++i) {
+            y[i] = relu6 ? std::min(std::max(y[i], 0.0f), 6.0f)
+                         : std::max(y[i], 0.0f);
+          }
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t cost = 2 * window.out_cols * block_size * in_blocks *
+                         block_size * window.filter_rows * window.filter_cols;
+    Shard(workers.num_threads, workers.workers,
+          batch * out_blocks * window.out_rows, cost, compute);
+  }
+
+ private:
+  std::vector<int32> strides_;
+  Padding padding_;
+  bool relu_;
+  bool relu6_;
+};
+
+template <bool kMax>
+class NCHWcPoolOp : public OpKernel {
+ public:
+  explicit NCHWcPoolOp(OpKernelConstruction* context) : OpKernel(context) {
+    OP_REQUIRES_OK(context, GetStrides(context, "ksize", &ksize_));
+    OP_REQUIRES_OK(context, GetStrides(context, "strides", &strides_));
+    OP_REQUIRES_OK(context, context->GetAttr("padding", &padding_));
+  }
+
+  void Compute(OpKernelContext* context) override {
+    const Tensor& input = context->input(0);
+    OP_REQUIRES(context, input.dims() == 5,
+                errors::InvalidArgument("input must be 5-dimensional, got ",
+                                        input.shape().DebugString()));
+    const int64_t block_size = input.dim_size(4);
+    OP_REQUIRES(context, IsSupportedBlockSize(block_size),
+                errors::InvalidArgument("Unsupported block size ",
+                                        block_size));
+    NCHWcWindow window;
+    OP_REQUIRES_OK(context, GetNCHWcWindow(input, ksize_[0], ksize_[1],
+                                           strides_, padding_, &window));
+    const int64_t batch = input.dim_size(0);
+    const int64_t blocks = input.dim_size(1);
+    Tensor* output = nullptr;
+    OP_REQUIRES_OK(context,
+                   context->allocate_output(
+                       0,
+                       TensorShape({batch, blocks, window.out_rows,
+                                    window.out_cols, block_size}),
+                       &output));
+    if (output->NumElements() == 0) return;
+
+    const float* in = input.flat<float>().data();
+    float* out = output->flat<float>().data();
+    // Each unit is an output row of a channel block of an image.
+    auto compute = [&](int64_t begin, int64_t end) {
+      for (int64_t unit = begin; unit < end; ++unit) {
+        const int64_t row = unit % window.out_rows;
+        const int64_t image_block = unit / window.out_rows;
+        switch (block_size) {
+          case 4:
+            NCHWcPoolRow<4, kMax>(in, window, image_block, row, out);
+            break;
+          case 8:
+            NCHWcPoolRow<8, kMax>(in, window, image_block, row, out);
+            break;
+          case 16:
+            NCHWcPoolRow<16, kMax>(in, window, image_block, row, out);
+            break;
+        }
+      }
+    };
+    const auto& workers = *context->device()->tensorflow_cpu_worker_threads();
+    const int64_t cost =
+        window.out_cols * block_size * window.filter_rows * window.filter_cols;
+    Shard(workers.num_threads, workers.workers,
+          batch * blocks * window.out_rows, cost, compute);
+  }
+
+ private:
+  std::vector<int32> ksize_;
+  std::vector<int32> strides_;
+  Padding padding_;
+};
+
+REGISTER_KERNEL_BUILDER(
+    Name("_NHWCToNCHWc").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NHWCToNCHWcOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NCHWcToNHWC").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NCHWcToNHWCOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NCHWcConv2D").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NCHWcConv2DOp);
+REGISTER_KERNEL_BUILDER(
+    Name("_NCHWcMaxPool").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NCHWcPoolOp<true>);
+REGISTER_KERNEL_BUILDER(
+    Name("_NCHWcAvgPool").Device(DEVICE_CPU).TypeConstraint<float>("T"),
+    NCHWcPoolOp<false>);
+
+}  // namespace tensorflow
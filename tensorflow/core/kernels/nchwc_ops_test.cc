@@ -0,0 +1,337 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+
+namespace tensorflow {
+namespace {
+
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  tensor.flat<float>() = tensor.flat<float>() - 0.5f;
+  return tensor;
+}
+
+// Converts an NHWC tensor to NCHWc, as `_NHWCToNCHWc` does.
+Tensor ToNCHWc(const Tensor& x, int64_t block_size) {
+  const int64_t channels = x.dim_size(3);
+  const int64_t blocks = (channels + block_size - 1) / block_size;
+  Tensor y(DT_FLOAT, TensorShape({x.dim_size(0), blocks, x.dim_size(1),
+                                  x.dim_size(2), block_size}));
+  auto in = x.tensor<float, 4>();
+  auto out = y.tensor<float, 5>();
+  for (int64_t n = 0; n < x.dim_size(0); ++n) {
+    for (int64_t h = 0; h < x.dim_size(1); ++h) {
+      for (int64_t w = 0; w < x.dim_size(2); ++w) {
+        for (int64_t c = 0; c < blocks * block_size; ++c) {
+          out(n, c / block_size, h, w, c % block_size) =
+              c < channels ? in(n, h, w, c) : 0.0f;
+        }
+      }
+    }
+  }
+  return y;
+}
+
+// Converts an NCHWc tensor to NHWC with `channels` channels.
+Tensor ToNHWC(const Tensor& x, int64_t channels) {
+  const int64_t block_size = x.dim_size(4);
+  Tensor y(DT_FLOAT, TensorShape({x.dim_size(0), x.dim_size(2),
+                                  x.dim_size(3), channels}));
+  auto in = x.tensor<float, 5>();
+  auto out = y.tensor<float, 4>();
+  for (int64_t n = 0; n < y.dim_size(0); ++n) {
+    for (int64_t h = 0; h < y.dim_size(1); ++h) {
+      for (int64_t w = 0; w < y.dim_size(2); ++w) {
+        for (int64_t c = 0; c < channels; ++c) {
+          out(n, h, w, c) = in(n, c / block_size, h, w, c % block_size);
+        }
+      }
+    }
+  }
+  return y;
+}
+
+// Packs an HWIO filter into the layout of the `_NCHWcConv2D` filter.
+Tensor PackFilter(const Tensor& filter, int64_t block_size) {
+  const int64_t rows = filter.dim_size(0);
+  const int64_t cols = filter.dim_size(1);
+  const int64_t in = filter.dim_size(2);
+  const int64_t out = filter.dim_size(3);
+  const int64_t in_padded = (in + block_size - 1) / block_size * block_size;
+  const int64_t out_blocks = (out + block_size - 1) / block_size;
+  Tensor packed(DT_FLOAT, TensorShape({out_blocks, rows, cols, in_padded,
+                                       block_size}));
+  packed.flat<float>().setZero();
+  auto f = filter.tensor<float, 4>();
+  auto p = packed.tensor<float, 5>();
+  for (int64_t r = 0; r < rows; ++r) {
+    for (int64_t s = 0; s < cols; ++s) {
+      for (int64_t i = 0; i < in; ++i) {
+        for (int64_t o = 0; o < out; ++o) {
+          p(o / block_size, r, s, i, o % block_size) = f(r, s, i, o);
+        }
+      }
+    }
+  }
+  return packed;
+}
+
+// Returns the output size and the padding before a windowed dimension.
+void Window(int64_t in, int64_t size, int64_t stride, const string& padding,
+            int64_t* out, int64_t* pad) {
+  if (padding == "VALID") {
+    *out = (in - size + stride) / stride;
+    *pad = 0;
+  } else {
+    *out = (in + stride - 1) / stride;
+    *pad = std::max<int64_t>((*out - 1) * stride + size - in, 0) / 2;
+  }
+}
+
+// The NHWC convolution of `x` by the HWIO `filter`, plus `bias`.
+Tensor Conv2D(const Tensor& x, const Tensor& filter, const Tensor& bias,
+              int stride, const string& padding) {
+  int64_t out_rows, out_cols, pad_top, pad_left;
+  Window(x.dim_size(1), filter.dim_size(0), stride, padding, &out_rows,
+         &pad_top);
+  Window(x.dim_size(2), filter.dim_size(1), stride, padding, &out_cols,
+         &pad_left);
+  Tensor y(DT_FLOAT, TensorShape({x.dim_size(0), out_rows, out_cols,
+                                  filter.dim_size(3)}));
+  auto in = x.tensor<float, 4>();
+  auto f = filter.tensor<float, 4>();
+  auto out = y.tensor<float, 4>();
+  for (int64_t n = 0; n < y.dim_size(0); ++n) {
+    for (int64_t h = 0; h < out_rows; ++h) {
+      for (int64_t w = 0; w < out_cols; ++w) {
+        for (int64_t o = 0; o < y.dim_size(3); ++o) {
+          double sum = bias.flat<float>()(o);
+          for (int64_t r = 0; r < filter.dim_size(0); ++r) {
+            for (int64_t s = 0; s < filter.dim_size(1); ++s) {
+              const int64_t ih = h * stride - pad_top + r;
+              const int64_t iw = w * stride - pad_left + s;
+              if (ih < 0 || ih >= x.dim_size(1) || iw < 0 ||
+                  iw >= x.dim_size(2)) {
+                continue;
+              }
+              for (int64_t i = 0; i < x.dim_size(3); ++i) {
+                sum += in(n, ih, iw, i) * f(r, s, i, o);
+              }
+            }
+          }
+          out(n, h, w, o) = sum;
+        }
+      }
+    }
+  }
+  return y;
+}
+
+// The NHWC max or average pooling of `x`.
+Tensor Pool(const Tensor& x, int size, int stride, const string& padding,
+            bool max) {
+  int64_t out_rows, out_cols, pad_top, pad_left;
+  Window(x.dim_size(1), size, stride, padding, &out_rows, &pad_top);
+  Window(x.dim_size(2), size, stride, padding, &out_cols, &pad_left);
+  Tensor y(DT_FLOAT, TensorShape({x.dim_size(0), out_rows, out_cols,
+                                  x.dim_size(3)}));
+  auto in = x.tensor<float, 4>();
+  auto out = y.tensor<float, 4>();
+  for (int64_t n = 0; n < y.dim_size(0); ++n) {
+    for (int64_t h = 0; h < out_rows; ++h) {
+      for (int64_t w = 0; w < out_cols; ++w) {
+        for (int64_t c = 0; c < y.dim_size(3); ++c) {
+          float acc = max ? std::numeric_limits<float>::lowest() : 0.0f;
+          int count = 0;
+          for (int64_t r = 0; r < size; ++r) {
+            for (int64_t s = 0; s < size; ++s) {
+              const int64_t ih = h * stride - pad_top + r;
+              const int64_t iw = w * stride - pad_left + s;
+              if (ih < 0 || ih >= x.dim_size(1) || iw < 0 ||
+                  iw >= x.dim_size(2)) {
+                continue;
+              }
+              acc = max ? std::max(acc, in(n, ih, iw, c))
+                        : acc + in(n, ih, iw, c);
+              ++count;
+            }
+          }
+          out(n, h, w, c) = max ? acc : acc / count;
+        }
+      }
+    }
+  }
+  return y;
+}
+
+class NCHWcOpsTest : public OpsTestBase {
+ protected:
+  void AddTensor(const Tensor& tensor) {
+    AddInputFromArray<float>(
+        tensor.shape(), absl::Span<const float>(tensor.flat<float>().data(),
+                                                tensor.NumElements()));
+  }
+
+  // Checks `_NCHWcConv2D` against the NHWC convolution.
+  void CheckConv2D(const TensorShape& input_shape, int filter_size,
+                   int out_channels, int stride, const string& padding,
+                   int block_size) {
+    const Tensor x = RandomTensor(input_shape);
+    const Tensor filter = RandomTensor(
+        TensorShape({filter_size, filter_size, input_shape.dim_size(3),
+                     out_channels}));
+    const Tensor bias = RandomTensor(TensorShape({out_channels}));
+    const int64_t out_blocks = (out_channels + block_size - 1) / block_size;
+    Tensor padded_bias(DT_FLOAT, TensorShape({out_blocks * block_size}));
+    padded_bias.flat<float>().setZero();
+    std::copy_n(bias.flat<float>().data(), out_channels,
+                padded_bias.flat<float>().data());
+
+    TF_ASSERT_OK(NodeDefBuilder("conv", "_NCHWcConv2D")
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("strides", {stride, stride})
+                     .Attr("padding", padding)
+                     .Attr("activation", "Relu")
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddTensor(ToNCHWc(x, block_size));
+    AddTensor(PackFilter(filter, block_size));
+    AddTensor(padded_bias);
+    TF_ASSERT_OK(RunOpKernel());
+
+    Tensor expected = Conv2D(x, filter, bias, stride, padding);
+    expected.flat<float>() = expected.flat<float>().cwiseMax(0.0f);
+    test::ExpectClose(expected, ToNHWC(*GetOutput(0), out_channels),
+                      /*atol=*/1e-4, /*rtol=*/1e-4);
+  }
+
+  void CheckPool(const string& op, const TensorShape& input_shape, int size,
+                 int stride, const string& padding, int block_size) {
+    const Tensor x = RandomTensor(input_shape);
+    TF_ASSERT_OK(NodeDefBuilder("pool", op)
+                     .Input(FakeInput(DT_FLOAT))
+                     .Attr("T", DT_FLOAT)
+                     .Attr("ksize", {size, size})
+                     .Attr("strides", {stride, stride})
+                     .Attr("padding", padding)
+                     .Finalize(node_def()));
+    TF_ASSERT_OK(InitOp());
+    AddTensor(ToNCHWc(x, block_size));
+    TF_ASSERT_OK(RunOpKernel());
+
+    const Tensor expected =
+        Pool(x, size, stride, padding, op == "_NCHWcMaxPool");
+    test::ExpectClose(expected, ToNHWC(*GetOutput(0), input_shape.dim_size(3)),
+                      /*atol=*/1e-5, /*rtol=*/1e-5);
+  }
+};
+
+TEST_F(NCHWcOpsTest, NHWCToNCHWc) {
+  const Tensor x = RandomTensor(TensorShape({2, 3, 5, 11}));
+  TF_ASSERT_OK(NodeDefBuilder("to_nchwc", "_NHWCToNCHWc")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("block_size", 8)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddTensor(x);
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(ToNCHWc(x, 8), *GetOutput(0));
+}
+
+TEST_F(NCHWcOpsTest, NCHWcToNHWC) {
+  const Tensor x = RandomTensor(TensorShape({2, 2, 3, 5, 8}));
+  TF_ASSERT_OK(NodeDefBuilder("to_nhwc", "_NCHWcToNHWC")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("channels", 11)
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddTensor(x);
+  TF_ASSERT_OK(RunOpKernel());
+  test::ExpectTensorEqual<float>(ToNHWC(x, 11), *GetOutput(0));
+}
+
+TEST_F(NCHWcOpsTest, Conv2DSame) {
+  CheckConv2D(TensorShape({2, 9, 7, 16}), /*filter_size=*/3,
+              /*out_channels=*/16, /*stride=*/1, "SAME", /*block_size=*/8);
+}
+
+TEST_F(NCHWcOpsTest, Conv2DStridedValid) {
+  CheckConv2D(TensorShape({1, 11, 10, 8}), /*filter_size=*/3,
+              /*out_channels=*/32, /*stride=*/2, "VALID", /*block_size=*/16);
+}
+
+TEST_F(NCHWcOpsTest, Conv2DPaddedChannels) {
+  // The 3 input and 10 output channels are padded to 2 blocks of 8.
+  CheckConv2D(TensorShape({2, 8, 8, 3}), /*filter_size=*/7,
+              /*out_channels=*/10, /*stride=*/2, "SAME", /*block_size=*/8);
+}
+
+TEST_F(NCHWcOpsTest, Conv2DPointwise) {
+  CheckConv2D(TensorShape({2, 5, 5, 24}), /*filter_size=*/1,
+              /*out_channels=*/8, /*stride=*/1, "VALID", /*block_size=*/4);
+}
+
+TEST_F(NCHWcOpsTest, MaxPool) {
+  CheckPool("_NCHWcMaxPool", TensorShape({2, 9, 9, 16}), /*size=*/3,
+            /*stride=*/2, "SAME", /*block_size=*/8);
+}
+
+TEST_F(NCHWcOpsTest, AvgPoolSame) {
+  // The windows at the edges average fewer values.
+  CheckPool("_NCHWcAvgPool", TensorShape({1, 7, 6, 16}), /*size=*/3,
+            /*stride=*/2, "SAME", /*block_size=*/16);
+}
+
+TEST_F(NCHWcOpsTest, AvgPoolValid) {
+  CheckPool("_NCHWcAvgPool", TensorShape({1, 7, 6, 16}), /*size=*/2,
+            /*stride=*/2, "VALID", /*block_size=*/16);
+}
+
+TEST_F(NCHWcOpsTest, UnsupportedBlockSize) {
+  TF_ASSERT_OK(NodeDefBuilder("pool", "_NCHWcMaxPool")
+                   .Input(FakeInput(DT_FLOAT))
+                   .Attr("T", DT_FLOAT)
+                   .Attr("ksize", {2, 2})
+                   .Attr("strides", {2, 2})
+                   .Attr("padding", "VALID")
+                   .Finalize(node_def()));
+  TF_ASSERT_OK(InitOp());
+  AddTensor(RandomTensor(TensorShape({1, 1, 4, 4, 5})));
+  Status status = RunOpKernel();
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+}  // namespace
+}  // namespace tensorflow
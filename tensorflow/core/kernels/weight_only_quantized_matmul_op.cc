@@ -0,0 +1,207 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// See docs in ../ops/math_ops.cc.
+
+#define EIGEN_USE_THREADS
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "Eigen/Core"  // from @eigen_archive
+#include "unsupported/Eigen/CXX11/Tensor"  // from @eigen_archive
+#include "tensorflow/core/framework/op_kernel.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_shape.h"
+#include "tensorflow/core/framework/types.h"
+#include "tensorflow/core/platform/errors.h"
+#include "tensorflow/core/util/work_sharder.h"
+
+namespace tensorflow {
+
+typedef Eigen::ThreadPoolDevice CPUDevice;
+
+namespace {
+
+// Columns of the weights each shard multiplies at a time.
+constexpr int64_t kColumnBlock = 64;
+// Rows of the weights dequantized at a time. A block of dequantized weights
+// stays in cache while it is multiplied, so the float weights are never
+// written to memory.
+constexpr int64_t kRowBlock = 256;
+
+// Writes rows [k0, k1) and columns [n0, n1) of the integer weights packed in
+// `b`, which has `n` columns, to `block` in row major order.
+template <typename T>
+void UnpackInt8(const int8_t* b, int64_t n, int64_t k0, int64_t k1,
+                int64_t n0, int64_t n1, T* block) {
+  for (int64_t k = k0; k < k1; ++k) {
+    const int8_t* row = b + k * n;
+    for (int64_t j = n0; j < n1; ++j) *block++ = static_cast<T>(row[j]);
+  }
+}
+
+template <typename T>
+void UnpackInt4(const int8_t* b, int64_t n, int64_t k0, int64_t k1,
+                int64_t n0, int64_t n1, T* block) {
+  for (int64_t k = k0; k < k1; ++k) {
+    const int8_t* row = b + (k / 2) * n;
+    if (k % 2 == 0) {
+      for (int64_t j = n0; j < n1; ++j) {
+        const auto low = static_cast<int8_t>(static_cast<uint8_t>(row[j]) << 4);
+        *block++ = static_cast<T>(low >> 4);
+      }
+    } else {
+      for (int64_t j = n0; j < n1; ++j) {
+        *block++ = static_cast<T>(row[j] >> 4);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+template <typename T>
+class WeightOnlyQuantizedMatMulOp : public OpKernel {
+ public:
+  using Matrix =
+      Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+  using ConstMatrixMap =
+      Eigen::Map<const Matrix, Eigen::Unaligned, Eigen::OuterStride<>>;
+  using MatrixMap = Eigen::Map<Matrix, Eigen::Unaligned, Eigen::OuterStride<>>;
+  using UnpackFn = void (*)(const int8_t*, int64_t, int64_t, int64_t, int64_t,
+                            int64_t, T*);
+
+  explicit WeightOnlyQuantizedMatMulOp(OpKernelConstruction* context)
+      : OpKernel(context) {
+    OP_REQUIRES_OK(context, context->GetAttr("transpose_a", &transpose_a_));
+    OP_REQUIRES_OK(context, context->GetAttr("num_bits", &num_bits_));
+    OP_REQUIRES(context, num_bits_ == 4 || num_bits_ == 8,
+                errors::InvalidArgument("num_bits must be 4 or 8, got ",
+                                        num_bits_));
+    unpack_ = num_bits_ == 8 ? UnpackInt8<T> : UnpackInt4<T>;
+  }
+
+  void Compute(OpKernelContext* ctx) override {
+    const Tensor& a = ctx->input(0);
+    const Tensor& b = ctx->input(1);
+    const Tensor& b_scales = ctx->input(2);
+    OP_REQUIRES(ctx, a.dims() >= 2,
+                errors::InvalidArgument("a must have rank >= 2, got shape ",
+                                        a.shape().DebugString()));
+    OP_REQUIRES(ctx, !transpose_a_ || a.dims() == 2,
+                errors::InvalidArgument(
+                    "a must be a matrix if transpose_a is true, got shape ",
+                    a.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsMatrix(b.shape()),
+                errors::InvalidArgument("b must be a matrix, got shape ",
+                                        b.shape().DebugString()));
+    OP_REQUIRES(ctx, TensorShapeUtils::IsVector(b_scales.shape()),
+                errors::InvalidArgument("b_scales must be a vector, got shape ",
+                                        b_scales.shape().DebugString()));
+
+    const int64_t k = a.dim_size(transpose_a_ ? 0 : a.dims() - 1);
+    const int64_t n = b.dim_size(1);
+    const int64_t packed_k = num_bits_ == 8 ? k : (k + 1) / 2;
+    OP_REQUIRES(ctx, b.dim_size(0) == packed_k,
+                errors::InvalidArgument("b must have ", packed_k,
+                                        " rows for ", k, " ", num_bits_,
+                                        "-bit weights, got shape ",
+                                        b.shape().DebugString()));
+    OP_REQUIRES(ctx, b_scales.dim_size(0) == n,
+                errors::InvalidArgument("b_scales must have ", n,
+                                        " elements, got shape ",
+                                        b_scales.shape().DebugString()));
+
+    TensorShape out_shape = a.shape();
+    if (transpose_a_) out_shape.set_dim(0, a.dim_size(1));
+    out_shape.set_dim(out_shape.dims() - 1, n);
+    Tensor* out = nullptr;
+    OP_REQUIRES_OK(ctx, ctx->allocate_output(0, out_shape, &out));
+    if (out->NumElements() == 0) return;
+    if (k == 0) {
+      out->flat<T>().setZero();
+      return;
+    }
+    const int64_t m = out->NumElements() / n;
+
+    const T* a_data = a.flat<T>().data();
+    Tensor a_transposed;
+    if (transpose_a_) {
+      OP_REQUIRES_OK(ctx, ctx->allocate_temp(DataTypeToEnum<T>::value,
+                                             TensorShape({m, k}),
+                                             &a_transposed));
+      a_transposed.matrix<T>().device(ctx->eigen_device<CPUDevice>()) =
+          a.matrix<T>().shuffle(Eigen::array<int, 2>{1, 0});
+      a_data = a_transposed.flat<T>().data();
+    }
+    const int8_t* b_data = b.flat<int8_t>().data();
+    const T* scales = b_scales.flat<T>().data();
+    T* out_data = out->flat<T>().data();
+    const UnpackFn unpack = unpack_;
+
+    // Each shard computes blocks of output columns, so every weight is
+    // dequantized once.
+    auto compute_blocks = [&](int64_t begin, int64_t end) {
+      std::vector<T> weights(kRowBlock * kColumnBlock);
+      for (int64_t block = begin; block < end; ++block) {
+        const int64_t n0 = block * kColumnBlock;
+        const int64_t n1 = std::min(n, n0 + kColumnBlock);
+        MatrixMap out_block(out_data + n0, m, n1 - n0,
+                            Eigen::OuterStride<>(n));
+        for (int64_t k0 = 0; k0 < k; k0 += kRowBlock) {
+          const int64_t k1 = std::min(k, k0 + kRowBlock);
+          unpack(b_data, n, k0, k1, n0, n1, weights.data());
+          ConstMatrixMap a_block(a_data + k0, m, k1 - k0,
+                                 Eigen::OuterStride<>(k));
+          ConstMatrixMap weights_block(weights.data(), k1 - k0, n1 - n0,
+                                       Eigen::OuterStride<>(n1 - n0));
+          if (k0 == 0) {
+            out_block.noalias() = a_block * weights_block;
+          } else {
+            out_block.noalias() += a_block * weights_block;
+          }
+        }
+        // The scale of a column factors out of its dot products.
+        out_block.array().rowwise() *=
+            Eigen::Map<const Eigen::Array<T, 1, Eigen::Dynamic>>(scales + n0,
+                                                                 n1 - n0);
+      }
+    };
+    const auto& worker_threads =
+        *ctx->device()->tensorflow_cpu_worker_threads();
+    const int64_t num_blocks = (n + kColumnBlock - 1) / kColumnBlock;
+    Shard(worker_threads.num_threads, worker_threads.workers, num_blocks,
+          /*cost_per_unit=*/2 * m * k * kColumnBlock, compute_blocks);
+  }
+
+ private:
+  bool transpose_a_;
+  int num_bits_;
+  UnpackFn unpack_;
+};
+
+#define REGISTER_CPU(T)                                         \
+  REGISTER_KERNEL_BUILDER(Name("_WeightOnlyQuantizedMatMul")    \
+                              .Device(DEVICE_CPU)               \
+                              .TypeConstraint<T>("T"),          \
+                          WeightOnlyQuantizedMatMulOp<T>);
+
+REGISTER_CPU(float);
+
+#undef REGISTER_CPU
+
+}  // namespace tensorflow
@@ -0,0 +1,290 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "absl/types/span.h"
+#include "tensorflow/core/common_runtime/kernel_benchmark_testlib.h"
+#include "tensorflow/core/framework/fake_input.h"
+#include "tensorflow/core/framework/node_def_builder.h"
+#include "tensorflow/core/framework/tensor.h"
+#include "tensorflow/core/framework/tensor_testutil.h"
+#include "tensorflow/core/graph/node_builder.h"
+#include "tensorflow/core/kernels/ops_testutil.h"
+#include "tensorflow/core/lib/core/status_test_util.h"
+#include "tensorflow/core/platform/test.h"
+#include "tensorflow/core/platform/test_benchmark.h"
+
+namespace tensorflow {
+namespace {
+
+// Weights quantized per column, in the encoding of the
+// `_WeightOnlyQuantizedMatMul` inputs.
+struct QuantizedWeights {
+  Tensor b;
+  Tensor scales;
+};
+
+QuantizedWeights Quantize(const Tensor& weights, int num_bits) {
+  const int64_t k = weights.dim_size(0);
+  const int64_t n = weights.dim_size(1);
+  const int max_value = (1 << (num_bits - 1)) - 1;
+  QuantizedWeights quantized;
+  quantized.b = Tensor(
+      DT_INT8, TensorShape({num_bits == 8 ? k : (k + 1) / 2, n}));
+  quantized.b.flat<int8_t>().setZero();
+  quantized.scales = Tensor(DT_FLOAT, TensorShape({n}));
+  auto w = weights.matrix<float>();
+  auto b = quantized.b.matrix<int8_t>();
+  for (int64_t j = 0; j < n; ++j) {
+    float max_abs = 0;
+    for (int64_t i = 0; i < k; ++i) {
+      max_abs = std::max(max_abs, std::abs(w(i, j)));
+    }
+    const float scale = max_abs > 0 ? max_abs / max_value : 1.0f;
+    quantized.scales.flat<float>()(j) = scale;
+    for (int64_t i = 0; i < k; ++i) {
+      const int q = std::clamp(static_cast<int>(std::round(w(i, j) / scale)),
+                               -max_value, max_value);
+      if (num_bits == 8) {
+        b(i, j) = q;
+      } else {
+        b(i / 2, j) |= (q & 0xF) << (4 * (i % 2));
+      }
+    }
+  }
+  return quantized;
+}
+
+// The float weights that `quantized` encodes.
+Tensor Dequantize(const QuantizedWeights& quantized, int64_t k,
+                  int num_bits) {
+  const int64_t n = quantized.scales.NumElements();
+  Tensor weights(DT_FLOAT, TensorShape({k, n}));
+  auto b = quantized.b.matrix<int8_t>();
+  for (int64_t i = 0; i < k; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      int q = b(num_bits == 8 ? i : i / 2, j);
+      // Sign extends the nibble holding the weight.
+      if (num_bits == 4) q = (i % 2 == 0) ? ((q & 0xF) ^ 8) - 8 : q >> 4;
+      weights.matrix<float>()(i, j) = q * quantized.scales.flat<float>()(j);
+    }
+  }
+  return weights;
+}
+
+Tensor RandomTensor(const TensorShape& shape) {
+  Tensor tensor(DT_FLOAT, shape);
+  tensor.flat<float>().setRandom();
+  tensor.flat<float>() = tensor.flat<float>() - 0.5f;
+  return tensor;
+}
+
+// The product of `a`, with shape [..., K], and `weights`, with shape [K, N].
+Tensor MatMul(const Tensor& a, const Tensor& weights) {
+  const int64_t k = weights.dim_size(0);
+  const int64_t n = weights.dim_size(1);
+  const int64_t m = a.NumElements() / k;
+  TensorShape shape = a.shape();
+  shape.set_dim(shape.dims() - 1, n);
+  Tensor product(DT_FLOAT, shape);
+  auto x = a.shaped<float, 2>({m, k});
+  auto w = weights.matrix<float>();
+  auto y = product.shaped<float, 2>({m, n});
+  for (int64_t i = 0; i < m; ++i) {
+    for (int64_t j = 0; j < n; ++j) {
+      double sum = 0;
+      for (int64_t l = 0; l < k; ++l) sum += x(i, l) * w(l, j);
+      y(i, j) = sum;
+    }
+  }
+  return product;
+}
+
+class WeightOnlyQuantizedMatMulOpTest : public OpsTestBase {
+ protected:
+  Status RunQuantizedMatMul(const Tensor& a, const QuantizedWeights& weights,
+                            int num_bits, bool transpose_a = false) {
+    TF_RETURN_IF_ERROR(
+        NodeDefBuilder("quantized_matmul", "_WeightOnlyQuantizedMatMul")
+            .Input(FakeInput(DT_FLOAT))
+            .Input(FakeInput(DT_INT8))
+            .Input(FakeInput(DT_FLOAT))
+            .Attr("T", DT_FLOAT)
+            .Attr("transpose_a", transpose_a)
+            .Attr("num_bits", num_bits)
+            .Finalize(node_def()));
+    TF_RETURN_IF_ERROR(InitOp());
+    AddInputFromArray<float>(
+        a.shape(), absl::Span<const float>(a.flat<float>().data(),
+                                           a.NumElements()));
+    AddInputFromArray<int8_t>(
+        weights.b.shape(),
+        absl::Span<const int8_t>(weights.b.flat<int8_t>().data(),
+                                 weights.b.NumElements()));
+    AddInputFromArray<float>(
+        weights.scales.shape(),
+        absl::Span<const float>(weights.scales.flat<float>().data(),
+                                weights.scales.NumElements()));
+    return RunOpKernel();
+  }
+
+  // Checks the product against the float product with the dequantized
+  // weights, and returns the relative error of the product with the
+  // original weights.
+  double CheckQuantizedMatMul(const TensorShape& a_shape, int64_t n,
+                              int num_bits) {
+    const Tensor a = RandomTensor(a_shape);
+    const int64_t k = a_shape.dim_size(a_shape.dims() - 1);
+    const Tensor weights = RandomTensor(TensorShape({k, n}));
+    const QuantizedWeights quantized = Quantize(weights, num_bits);
+    TF_CHECK_OK(RunQuantizedMatMul(a, quantized, num_bits));
+
+    const Tensor& product = *GetOutput(0);
+    test::ExpectClose(MatMul(a, Dequantize(quantized, k, num_bits)), product,
+                      /*atol=*/1e-4, /*rtol=*/1e-4);
+    const Tensor expected = MatMul(a, weights);
+    double error = 0;
+    double norm = 0;
+    for (int64_t i = 0; i < product.NumElements(); ++i) {
+      const double diff = product.flat<float>()(i) - expected.flat<float>()(i);
+      error += diff * diff;
+      norm += expected.flat<float>()(i) * expected.flat<float>()(i);
+    }
+    return std::sqrt(error / norm);
+  }
+};
+
+TEST_F(WeightOnlyQuantizedMatMulOpTest, Int8) {
+  const double error =
+      CheckQuantizedMatMul(TensorShape({5, 300}), /*n=*/70, /*num_bits=*/8);
+  EXPECT_LT(error, 0.01);
+}
+
+TEST_F(WeightOnlyQuantizedMatMulOpTest, Int4) {
+  // K is odd, so the last byte of every column holds a single weight.
+  const double error =
+      CheckQuantizedMatMul(TensorShape({5, 301}), /*n=*/70, /*num_bits=*/4);
+  EXPECT_LT(error, 0.15);
+}
+
+TEST_F(WeightOnlyQuantizedMatMulOpTest, BatchedInput) {
+  const double error = CheckQuantizedMatMul(TensorShape({2, 3, 64}),
+                                            /*n=*/16, /*num_bits=*/8);
+  EXPECT_LT(error, 0.01);
+  EXPECT_EQ(TensorShape({2, 3, 16}), GetOutput(0)->shape());
+}
+
+TEST_F(WeightOnlyQuantizedMatMulOpTest, TransposeA) {
+  const Tensor a = RandomTensor(TensorShape({32, 4}));
+  const Tensor weights = RandomTensor(TensorShape({32, 8}));
+  const QuantizedWeights quantized = Quantize(weights, /*num_bits=*/8);
+  TF_ASSERT_OK(RunQuantizedMatMul(a, quantized, /*num_bits=*/8,
+                                  /*transpose_a=*/true));
+
+  Tensor a_transposed(DT_FLOAT, TensorShape({4, 32}));
+  a_transposed.matrix<float>() =
+      a.matrix<float>().shuffle(Eigen::array<int, 2>{1, 0});
+  test::ExpectClose(MatMul(a_transposed, Dequantize(quantized, 32, 8)),
+                    *GetOutput(0), /*atol=*/1e-4, /*rtol=*/1e-4);
+}
+
+TEST_F(WeightOnlyQuantizedMatMulOpTest, WrongNumberOfRows) {
+  const Tensor a = RandomTensor(TensorShape({2, 16}));
+  const QuantizedWeights quantized =
+      Quantize(RandomTensor(TensorShape({16, 4})), /*num_bits=*/8);
+  // 4-bit weights of 16 rows pack into 8 rows.
+  Status status = RunQuantizedMatMul(a, quantized, /*num_bits=*/4);
+  EXPECT_TRUE(errors::IsInvalidArgument(status)) << status;
+}
+
+// Performance benchmarks below.
+
+static Graph* FloatMatMulGraph(int m, int k, int n) {
+  Graph* g = new Graph(OpRegistry::Global());
+  Node* a = test::graph::Constant(g, RandomTensor(TensorShape({m, k})));
+  Node* b = test::graph::Constant(g, RandomTensor(TensorShape({k, n})));
+  test::graph::Matmul(g, a, b, /*transpose_a=*/false, /*transpose_b=*/false);
+  return g;
+}
+
+static Graph* QuantizedMatMulGraph(int m, int k, int n, int num_bits) {
+  Graph* g = new Graph(OpRegistry::Global());
+  const QuantizedWeights quantized =
+      Quantize(RandomTensor(TensorShape({k, n})), num_bits);
+  Node* a = test::graph::Constant(g, RandomTensor(TensorShape({m, k})));
+  Node* b = test::graph::Constant(g, quantized.b);
+  Node* scales = test::graph::Constant(g, quantized.scales);
+  Node* node;
+  TF_CHECK_OK(NodeBuilder(g->NewName("n"), "_WeightOnlyQuantizedMatMul")
+                  .Input(a)
+                  .Input(b)
+                  .Input(scales)
+                  .Attr("T", DT_FLOAT)
+                  .Attr("num_bits", num_bits)
+                  .Finalize(g, &node));
+  return g;
+}
+
+// The items are the multiply-adds, and the bytes are the weights, which
+// dominate the memory traffic of small batches.
+#define BM_WeightOnlyQuantizedMatMul(M, K, N)                               \
+  static void BM_FloatMatMul_##M##_##K##_##N(                               \
+      ::testing::benchmark::State& state) {                                 \
+    test::Benchmark("cpu", FloatMatMulGraph(M, K, N),                       \
+                    /*old_benchmark_api*/ false)                            \
+        .Run(state);                                                        \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * M * \
+                            K * N);                                         \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * K * \
+                            N * sizeof(float));                             \
+  }                                                                         \
+  BENCHMARK(BM_FloatMatMul_##M##_##K##_##N)->UseRealTime();                 \
+                                                                            \
+  static void BM_Int8MatMul_##M##_##K##_##N(                                \
+      ::testing::benchmark::State& state) {                                 \
+    test::Benchmark("cpu", QuantizedMatMulGraph(M, K, N, 8),                \
+                    /*old_benchmark_api*/ false)                            \
+        .Run(state);                                                        \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * M * \
+                            K * N);                                         \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * K * \
+                            N);                                             \
+  }                                                                         \
+  BENCHMARK(BM_Int8MatMul_##M##_##K##_##N)->UseRealTime();                  \
+                                                                            \
+  static void BM_Int4MatMul_##M##_##K##_##N(                                \
+      ::testing::benchmark::State& state) {                                 \
+    test::Benchmark("cpu", QuantizedMatMulGraph(M, K, N, 4),                \
+                    /*old_benchmark_api*/ false)                            \
+        .Run(state);                                                        \
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * M * \
+                            K * N);                                         \
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * K * \
+                            N / 2);                                         \
+  }                                                                         \
+  BENCHMARK(BM_Int4MatMul_##M##_##K##_##N)->UseRealTime();
+
+// BenchmarkName(m, k, n)
+
+BM_WeightOnlyQuantizedMatMul(1, 4096, 4096);
+BM_WeightOnlyQuantizedMatMul(16, 4096, 4096);
+BM_WeightOnlyQuantizedMatMul(128, 4096, 4096);
+BM_WeightOnlyQuantizedMatMul(16, 1024, 16384);
+
+}  // namespace
+}  // namespace tensorflow
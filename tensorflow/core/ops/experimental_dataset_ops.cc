@@ -252,6 +252,9 @@ REGISTER_OP("CSVDatasetV2")
     .Output("handle: variant")
     .Attr("output_types: list({float,double,int32,int64,string}) >= 1")
     .Attr("output_shapes: list(shape) >= 1")
+    // If positive, each element holds up to `batch_size` records, with one
+    // vector per column, and `output_shapes` must be vectors.
+    .Attr("batch_size: int = 0")
     .SetDoNotOptimize()  // TODO(b/123753214): See comment in dataset_ops.cc.
     .SetTypeConstructor(full_type::VariadicTensorContainer(TFT_DATASET,
                                                            "output_types"))
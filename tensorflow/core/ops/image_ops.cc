@@ -526,6 +526,45 @@ REGISTER_OP("DecodeAndCropJpeg")
       return absl::OkStatus();
     });
 
+// --------------------------------------------------------------------------
+REGISTER_OP("DecodeAndResizeJpeg")
+    .Input("contents: string")
+    .Input("crop_window: int32")
+    .Input("size: int32")
+    .Attr("channels: int = 0")
+    .Attr("fancy_upscaling: bool = true")
+    .Attr("try_recover_truncated: bool = false")
+    .Attr("acceptable_fraction: float = 1.0")
+    .Attr("dct_method: string = ''")
+    .Output("image: float")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle unused;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 0, &unused));
+      // The crop window is either empty, to resize the whole image, or holds
+      // the 4 elements [y, x, h, w].
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 1, &unused));
+
+      DimensionHandle channels_dim = c->UnknownDim();
+      int32_t channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      if (channels != 0) {
+        if (channels < 0) {
+          return errors::InvalidArgument("channels must be non-negative, got ",
+                                         channels);
+        }
+        channels_dim = c->MakeDim(channels);
+      }
+
+      TF_RETURN_IF_ERROR(SetOutputToSizedImage(c, c->UnknownDim(),
+                                               2 /* size_input_idx */,
+                                               channels_dim));
+      // Drops the batch dimension of the sized image.
+      ShapeHandle image;
+      TF_RETURN_IF_ERROR(c->Subshape(c->output(0), 1, &image));
+      c->set_output(0, image);
+      return absl::OkStatus();
+    });
+
 // --------------------------------------------------------------------------
 REGISTER_OP("EncodeJpeg")
     .Input("image: uint8")
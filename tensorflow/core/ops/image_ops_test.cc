@@ -171,6 +171,48 @@ TEST(ImageOpsTest, DecodeAndCropJpeg_InvalidCropWindow) {
   INFER_OK(op, "[];[?]", "[?,?,?]");
 }
 
+TEST(ImageOpsTest, DecodeAndResizeJpeg_ShapeFn) {
+  const char* op_name = "DecodeAndResizeJpeg";
+  ShapeInferenceTestOp op(op_name);
+  op.input_tensors.resize(3);
+
+  // Rank and size checks.
+  INFER_ERROR("Shape must be rank 0 but is rank 1", op, "[1];?;?");
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op, "[];[];?");
+  INFER_ERROR("Shape must be rank 1 but is rank 0", op, "[];?;[]");
+  INFER_ERROR("Dimension must be 2 but is 3", op, "[];?;[3]");
+
+  // Set the channel to zero - the channels are not known.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Input({"size", 2, DT_INT32})
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[];[?];[2]", "[?,?,?]");
+
+  // The output size comes from the size tensor.
+  Tensor size_tensor = test::AsTensor<int32>({20, 30});
+  op.input_tensors[2] = &size_tensor;
+  INFER_OK(op, "[];[?];[2]", "[20,30,?]");
+
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Input({"size", 2, DT_INT32})
+                   .Attr("channels", 3)
+                   .Finalize(&op.node_def));
+  INFER_OK(op, "[];[4];[2]", "[20,30,3]");
+
+  // Negative channel value is rejected.
+  TF_ASSERT_OK(NodeDefBuilder("test", op_name)
+                   .Input({"img", 0, DT_STRING})
+                   .Input({"crop_window", 1, DT_INT32})
+                   .Input({"size", 2, DT_INT32})
+                   .Attr("channels", -1)
+                   .Finalize(&op.node_def));
+  INFER_ERROR("channels must be non-negative, got -1", op, "[];[];[2]");
+}
+
 TEST(ImageOpsTest, EncodeImage_ShapeFn) {
   for (const char* op_name : {"EncodeJpeg"}) {
     ShapeInferenceTestOp op(op_name);
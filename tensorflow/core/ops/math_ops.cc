@@ -352,6 +352,35 @@ REGISTER_OP("_UnaryOpsComposition")
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_FusedElementwise")
+    .Input("args: num_args * T")
+    .Output("y: T")
+    .Attr("T: {float, double}")
+    .Attr("num_args: int >= 1")
+    .Attr("fused_ops: list(string)")
+    .Attr("fused_operands: list(int)")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle out = c->input(0);
+      for (int i = 1; i < c->num_inputs(); ++i) {
+        TF_RETURN_IF_ERROR(BroadcastBinaryOpOutputShapeFnHelper(
+            c, out, c->input(i), /*incompatible_shape_error=*/true, &out));
+      }
+      c->set_output(0, out);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Computes a composition of elementwise unary and binary ops.
+
+`fused_ops` lists the ops in evaluation order, and `fused_operands` lists their
+operands one op after the other: value `i < num_args` is `args[i]`, and value
+`num_args + j` is the result of `fused_ops[j]`. The result of the last op is
+the output. Each argument is a scalar, or has the shape of the output or of its
+innermost dimensions.
+
+*NOTE*: Do not invoke this operator directly in Python. Graph rewrite pass is
+expected to create these operators.
+)doc");
+
 #undef UNARY
 #undef UNARY_REAL
 #undef UNARY_COMPLEX
@@ -937,6 +966,63 @@ _FusedConv2D output.
 expected to create these operators.
 )doc");
 
+REGISTER_OP("_WeightOnlyQuantizedMatMul")
+    .Input("a: T")
+    .Input("b: int8")
+    .Input("b_scales: T")
+    .Output("product: T")
+    .Attr("transpose_a: bool = false")
+    .Attr("num_bits: int = 8")
+    .Attr("T: {float}")
+    .SetShapeFn([](InferenceContext* c) {
+      bool transpose_a;
+      int num_bits;
+      TF_RETURN_IF_ERROR(c->GetAttr("transpose_a", &transpose_a));
+      TF_RETURN_IF_ERROR(c->GetAttr("num_bits", &num_bits));
+      if (num_bits != 4 && num_bits != 8) {
+        return errors::InvalidArgument("num_bits must be 4 or 8, got ",
+                                       num_bits);
+      }
+      ShapeHandle a;
+      TF_RETURN_IF_ERROR(c->WithRankAtLeast(c->input(0), 2, &a));
+      if (transpose_a) TF_RETURN_IF_ERROR(c->WithRank(a, 2, &a));
+      ShapeHandle b;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 2, &b));
+      ShapeHandle b_scales;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &b_scales));
+      DimensionHandle n;
+      TF_RETURN_IF_ERROR(c->Merge(c->Dim(b, 1), c->Dim(b_scales, 0), &n));
+      if (num_bits == 8) {
+        DimensionHandle k;
+        TF_RETURN_IF_ERROR(
+            c->Merge(c->Dim(a, transpose_a ? 0 : -1), c->Dim(b, 0), &k));
+      }
+      ShapeHandle out;
+      if (transpose_a) {
+        out = c->Matrix(c->Dim(a, 1), n);
+      } else {
+        ShapeHandle outer;
+        TF_RETURN_IF_ERROR(c->Subshape(a, 0, -1, &outer));
+        TF_RETURN_IF_ERROR(c->Concatenate(outer, c->Vector(n), &out));
+      }
+      c->set_output(0, out);
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Multiplies `a` by a matrix `b` of weights quantized per output channel.
+
+The weights of column `n` are `b_scales[n]` times the signed integers of column
+`n` of `b`. With `num_bits` 8, `b` has shape `[K, N]`. With `num_bits` 4, every
+byte of `b` packs rows `2k` (low nibble) and `2k + 1` (high nibble) of the
+`[K, N]` weights, so `b` has shape `[(K + 1) / 2, N]`.
+
+`a` has shape `[..., K]`, or `[K, M]` if `transpose_a` is true, and the product
+has shape `[..., N]`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is
+expected to create these operators.
+)doc");
+
 // --------------------------------------------------------------------------
 
 // For operations where the output is a reduction function along some
@@ -630,6 +630,165 @@ REGISTER_OP("DataFormatVecPermute")
     .Attr("dst_format: string = 'NCHW'")
     .SetShapeFn(shape_inference::UnchangedShape);
 
+// --------------------------------------------------------------------------
+// Ops in the blocked NCHWc layout, where a tensor of NHWC shape [N, H, W, C]
+// has the shape [N, C / c, H, W, c] for a block of c channels. The channels
+// are padded with zeros to a multiple of the block size.
+
+namespace {
+
+// Sets the output of a window over the height and width of an NCHWc input,
+// with `filter_rows` x `filter_cols` windows and `out_blocks` channel blocks.
+Status NCHWcWindowShape(InferenceContext* c, DimensionHandle filter_rows,
+                        DimensionHandle filter_cols,
+                        DimensionHandle out_blocks) {
+  ShapeHandle input;
+  TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &input));
+  std::vector<int32> strides;
+  TF_RETURN_IF_ERROR(c->GetAttr("strides", &strides));
+  if (strides.size() != 2) {
+    return errors::InvalidArgument(
+        "strides must contain the 2 strides of the rows and columns, got ",
+        strides.size());
+  }
+  Padding padding;
+  TF_RETURN_IF_ERROR(c->GetAttr("padding", &padding));
+  DimensionHandle output_rows, output_cols;
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+      c, c->Dim(input, 2), filter_rows, strides[0], padding, &output_rows));
+  TF_RETURN_IF_ERROR(GetWindowedOutputSizeFromDims(
+      c, c->Dim(input, 3), filter_cols, strides[1], padding, &output_cols));
+  c->set_output(0, c->MakeShape({c->Dim(input, 0), out_blocks, output_rows,
+                                 output_cols, c->Dim(input, 4)}));
+  return absl::OkStatus();
+}
+
+Status NCHWcPoolShape(InferenceContext* c) {
+  std::vector<int32> ksize;
+  TF_RETURN_IF_ERROR(c->GetAttr("ksize", &ksize));
+  if (ksize.size() != 2) {
+    return errors::InvalidArgument(
+        "ksize must contain the 2 sizes of the rows and columns, got ",
+        ksize.size());
+  }
+  return NCHWcWindowShape(c, c->MakeDim(ksize[0]), c->MakeDim(ksize[1]),
+                          c->Dim(c->input(0), 1));
+}
+
+}  // namespace
+
+REGISTER_OP("_NHWCToNCHWc")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("block_size: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 4, &x));
+      int64_t block_size;
+      TF_RETURN_IF_ERROR(c->GetAttr("block_size", &block_size));
+      DimensionHandle blocks;
+      TF_RETURN_IF_ERROR(c->Add(c->Dim(x, 3), block_size - 1, &blocks));
+      TF_RETURN_IF_ERROR(c->Divide(blocks, block_size,
+                                   /*evenly_divisible=*/false, &blocks));
+      c->set_output(0, c->MakeShape({c->Dim(x, 0), blocks, c->Dim(x, 1),
+                                     c->Dim(x, 2), c->MakeDim(block_size)}));
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Converts an NHWC tensor to the blocked NCHWc layout.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcToNHWC")
+    .Input("x: T")
+    .Output("y: T")
+    .Attr("T: {float}")
+    .Attr("channels: int >= 1")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle x;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(0), 5, &x));
+      int64_t channels;
+      TF_RETURN_IF_ERROR(c->GetAttr("channels", &channels));
+      c->set_output(0, c->MakeShape({c->Dim(x, 0), c->Dim(x, 2), c->Dim(x, 3),
+                                     c->MakeDim(channels)}));
+      return absl::OkStatus();
+    })
+    .Doc(R"doc(
+Converts a tensor in the blocked NCHWc layout to NHWC, dropping the channels
+padded beyond `channels`.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcConv2D")
+    .Input("input: T")
+    .Input("filter: T")
+    .Input("bias: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .Attr("activation: {'Identity', 'Relu', 'Relu6'} = 'Identity'")
+    .SetShapeFn([](InferenceContext* c) {
+      ShapeHandle filter;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(1), 5, &filter));
+      ShapeHandle bias;
+      TF_RETURN_IF_ERROR(c->WithRank(c->input(2), 1, &bias));
+      DimensionHandle unused;
+      TF_RETURN_IF_ERROR(
+          c->Merge(c->Dim(c->input(0), 4), c->Dim(filter, 4), &unused));
+      return NCHWcWindowShape(c, c->Dim(filter, 1), c->Dim(filter, 2),
+                              c->Dim(filter, 0));
+    })
+    .Doc(R"doc(
+Computes a 2-D convolution of an input in the blocked NCHWc layout, adds a
+bias and applies an activation.
+
+The filter of shape [out_channels / c, filter_height, filter_width,
+in_channels, c] holds the HWIO filter with the output channels blocked and the
+input channels padded to the channels of `input`. The bias holds the padded
+output channels.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcMaxPool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("ksize: list(int)")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn(NCHWcPoolShape)
+    .Doc(R"doc(
+Performs max pooling over the rows and columns of an input in the blocked
+NCHWc layout.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
+REGISTER_OP("_NCHWcAvgPool")
+    .Input("input: T")
+    .Output("output: T")
+    .Attr("T: {float}")
+    .Attr("ksize: list(int)")
+    .Attr("strides: list(int)")
+    .Attr(GetPaddingAttrString())
+    .SetShapeFn(NCHWcPoolShape)
+    .Doc(R"doc(
+Performs average pooling over the rows and columns of an input in the blocked
+NCHWc layout. As in AvgPool, the padding is not averaged.
+
+*NOTE*: Do not invoke this operator directly in Python. Grappler is expected to
+create these operators.
+)doc");
+
 REGISTER_OP("FusedResizeAndPadConv2D")
     .Input("input: T")
     .Input("size: int32")
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/delegates/xnnpack/conv_2d_tester.h"
 #include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
 #include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/kernels/packed_weight_registry.h"
 #include "tensorflow/lite/mutable_op_resolver.h"
 
 namespace tflite {
@@ -178,6 +179,43 @@ TEST(XNNPACK_WEIGHTS_CACHE, SoftFinalization) {
   ASSERT_EQ(kTfLiteOk, interpreter2->Invoke());
 }
 
+TEST(XNNPACK_WEIGHTS_CACHE, SharedAcrossInterpreters) {
+  std::vector<char> buffer = Conv2DTester().CreateTfLiteModel();
+  const Model* model = GetModel(buffer.data());
+  DummyOpResolver resolver;
+
+  TfLiteXNNPackDelegateOptions delegate_options =
+      TfLiteXNNPackDelegateOptionsDefault();
+  delegate_options.flags |= TFLITE_XNNPACK_DELEGATE_FLAG_SHARE_WEIGHTS_CACHE;
+
+  const PackedWeightRegistry& registry = PackedWeightRegistry::Global();
+  const PackedWeightRegistry::Stats initial = registry.GetStats();
+  std::vector<std::unique_ptr<Interpreter>> interpreters;
+  std::vector<
+      std::unique_ptr<TfLiteDelegate, decltype(&TfLiteXNNPackDelegateDelete)>>
+      delegates;
+  for (int i = 0; i < 4; i++) {
+    std::unique_ptr<Interpreter> interpreter;
+    ASSERT_EQ(kTfLiteOk, InterpreterBuilder(model, resolver)(&interpreter));
+    ASSERT_EQ(kTfLiteOk, interpreter->AllocateTensors());
+    delegates.emplace_back(TfLiteXNNPackDelegateCreate(&delegate_options),
+                           TfLiteXNNPackDelegateDelete);
+    ASSERT_EQ(kTfLiteOk,
+              interpreter->ModifyGraphWithDelegate(delegates.back().get()));
+    // No explicit finalization is needed.
+    ASSERT_EQ(kTfLiteOk, interpreter->Invoke());
+    interpreters.push_back(std::move(interpreter));
+
+    // All interpreters share a single cache.
+    EXPECT_EQ(registry.GetStats().num_entries, initial.num_entries + 1);
+  }
+  EXPECT_EQ(registry.GetStats().hits - initial.hits, 3);
+
+  interpreters.clear();
+  delegates.clear();
+  EXPECT_EQ(registry.GetStats().num_entries, initial.num_entries);
+}
+
 // Dummy class to use with parameterized test.
 class WeightsCacheTest : public testing::TestWithParam<size_t> {};
 
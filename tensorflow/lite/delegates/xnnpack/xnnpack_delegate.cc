@@ -53,6 +53,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/utils/sparsity_format_converter.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/packed_weight_registry.h"
 #include "tensorflow/lite/kernels/padding.h"
 #include "tensorflow/lite/logger.h"
 #include "tensorflow/lite/minimal_logging.h"
@@ -499,6 +500,48 @@ class VariableHolder {
   std::map<uint32_t, const TfLiteTensor*> global_id_to_dims_and_type_;
 };
 
+// XNNPACK weights cache shared through the PackedWeightRegistry by all
+// delegates running the same model with the same options.
+class SharedWeightsCache : public PackedWeights {
+ public:
+  static std::unique_ptr<SharedWeightsCache> Create() {
+    xnn_weights_cache_t weights_cache = nullptr;
+    if (xnn_create_weights_cache(&weights_cache) != xnn_status_success) {
+      return nullptr;
+    }
+    return std::unique_ptr<SharedWeightsCache>(
+        new SharedWeightsCache(weights_cache));
+  }
+
+  ~SharedWeightsCache() override { xnn_delete_weights_cache(weights_cache_); }
+
+  xnn_weights_cache_t get() const { return weights_cache_; }
+
+  // XNNPACK does not report the size of its in-memory weights cache, so these
+  // entries are only counted, not sized.
+  size_t bytes() const override { return 0; }
+
+  // Runtimes can only run once the cache is finalized. Soft finalization still
+  // lets delegates created later look up their (identical) packed weights.
+  bool Finalize() {
+    std::call_once(finalize_once_, [this]() {
+      finalized_ = xnn_finalize_weights_cache(
+                       weights_cache_,
+                       xnn_weights_cache_finalization_kind_soft) ==
+                   xnn_status_success;
+    });
+    return finalized_;
+  }
+
+ private:
+  explicit SharedWeightsCache(xnn_weights_cache_t weights_cache)
+      : weights_cache_(weights_cache) {}
+
+  xnn_weights_cache_t weights_cache_;
+  std::once_flag finalize_once_;
+  bool finalized_ = false;
+};
+
 class Subgraph;
 
 class Delegate {
@@ -647,13 +690,66 @@ class Delegate {
   }
 
   xnn_weights_cache_t weights_cache() const {
-    if (options_.weights_cache == nullptr) {
+    if (shared_weights_cache_ != nullptr) {
+      return shared_weights_cache_->get();
+    } else if (options_.weights_cache == nullptr) {
       return nullptr;
     } else {
       return reinterpret_cast<xnn_weights_cache_t>(options_.weights_cache);
     }
   }
 
+  bool share_weights_cache() const {
+    return options_.weights_cache == nullptr &&
+           (options_.flags &
+            TFLITE_XNNPACK_DELEGATE_FLAG_SHARE_WEIGHTS_CACHE) != 0;
+  }
+
+  // Looks up the weights cache shared by all delegates running the model in
+  // `context`, if requested and not done yet.
+  TfLiteStatus MaybeAcquireSharedWeightsCache(TfLiteContext* context) {
+    if (!share_weights_cache() || shared_weights_cache_ != nullptr) {
+      return kTfLiteOk;
+    }
+    // Interpreters built from the same model share its read-only buffers, so
+    // the first static tensor identifies the model.
+    const TfLiteTensor* model_tensor = nullptr;
+    for (size_t t = 0; t < context->tensors_size; t++) {
+      const TfLiteTensor& tensor = context->tensors[t];
+      if (tensor.allocation_type == kTfLiteMmapRo &&
+          tensor.data.raw != nullptr) {
+        model_tensor = &tensor;
+        break;
+      }
+    }
+    if (model_tensor == nullptr) {
+      // No static weights to pack.
+      return kTfLiteOk;
+    }
+    const PackedWeightRegistry::Key key{
+        model_tensor->data.raw, model_tensor->bytes,
+        "xnnpack/" + std::to_string(options_.flags)};
+    shared_weights_cache_ =
+        PackedWeightRegistry::Global().GetOrCreate<SharedWeightsCache>(
+            key, &SharedWeightsCache::Create);
+    if (shared_weights_cache_ == nullptr) {
+      TF_LITE_KERNEL_LOG(context,
+                         "failed to create shared XNNPACK weights cache");
+      return kTfLiteError;
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus MaybeFinalizeSharedWeightsCache(TfLiteContext* context) {
+    if (shared_weights_cache_ != nullptr &&
+        !shared_weights_cache_->Finalize()) {
+      TF_LITE_KERNEL_LOG(context,
+                         "failed to finalize shared XNNPACK weights cache");
+      return kTfLiteError;
+    }
+    return kTfLiteOk;
+  }
+
   xnn_workspace_t workspace() const { return workspace_.get(); }
 
   TfLiteStatus AssociateVariableWithTensor(int local_id,
@@ -751,6 +847,10 @@ class Delegate {
   // If no weight cache is provided and a cache is set in the delegate options,
   // this will be used as a weight cache.
   MMapWeightCacheProvider weight_cache_provider_;
+
+  // Weights cache shared with other delegates running the same model, set when
+  // TFLITE_XNNPACK_DELEGATE_FLAG_SHARE_WEIGHTS_CACHE is used.
+  std::shared_ptr<SharedWeightsCache> shared_weights_cache_;
 };
 
 class Subgraph {
@@ -1160,6 +1260,9 @@ class Subgraph {
         return nullptr;
       }
     }
+    if (delegate.MaybeAcquireSharedWeightsCache(context) != kTfLiteOk) {
+      return nullptr;
+    }
     status = xnn_create_runtime_v4(subgraph.get(), delegate.weights_cache(),
                                    delegate.workspace(), delegate.threadpool(),
                                    flags, &runtime_ptr);
@@ -1183,6 +1286,7 @@ class Subgraph {
   TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node,
                        bool enable_subgraph_reshaping, Delegate* delegate) {
     std::lock_guard<std::mutex> lock(delegate->workspace_mutex_);
+    TF_LITE_ENSURE_STATUS(delegate->MaybeFinalizeSharedWeightsCache(context));
 
     if (enable_subgraph_reshaping) {
       xnn_status status = xnn_status_invalid_state;
@@ -1240,6 +1344,7 @@ class Subgraph {
   TfLiteStatus Invoke(TfLiteContext* context, bool enable_subgraph_reshaping,
                       Delegate* delegate) {
     std::lock_guard<std::mutex> lock(delegate->workspace_mutex_);
+    TF_LITE_ENSURE_STATUS(delegate->MaybeFinalizeSharedWeightsCache(context));
 
     bool any_pointers_changed = false;
     for (std::pair<int, void*> io_info : externals_) {
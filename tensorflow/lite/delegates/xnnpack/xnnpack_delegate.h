@@ -48,6 +48,10 @@ extern "C" {
 // Enable XNNPack subgraph reshaping. This means that models with dynamic
 // tensors are supported and that inputs may be efficiently resized.
 #define TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING 0x00000080
+// Share packed weights with all other delegates in the process that run the
+// same model (i.e. interpreters built from the same model buffer) with the same
+// flags. Ignored if `weights_cache` or `weight_cache_file_path` is set.
+#define TFLITE_XNNPACK_DELEGATE_FLAG_SHARE_WEIGHTS_CACHE 0x00000100
 
 struct TfLiteXNNPackDelegateWeightsCache;
 
@@ -64,6 +68,7 @@ typedef struct {
   // - TFLITE_XNNPACK_DELEGATE_FLAG_TRANSIENT_INDIRECTION_BUFFER
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_LATEST_OPERATORS
   // - TFLITE_XNNPACK_DELEGATE_FLAG_ENABLE_SUBGRAPH_RESHAPING
+  // - TFLITE_XNNPACK_DELEGATE_FLAG_SHARE_WEIGHTS_CACHE
   uint32_t flags;
   // Cache for packed weights, can be shared between multiple instances of
   // delegates.
@@ -0,0 +1,235 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/signature_batcher.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/minimal_logging.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+namespace experimental {
+namespace batching {
+
+std::unique_ptr<SignatureBatcher> SignatureBatcher::Create(
+    SignatureRunner* runner, const SignatureBatcherOptions& options) {
+  if (runner == nullptr || options.max_batch_size < 1) {
+    return nullptr;
+  }
+  std::unique_ptr<SignatureBatcher> batcher(
+      new SignatureBatcher(runner, options));
+  if (batcher->Initialize() != kTfLiteOk) {
+    return nullptr;
+  }
+  batcher->scheduler_thread_ =
+      std::thread([self = batcher.get()] { self->ProcessBatches(); });
+  return batcher;
+}
+
+SignatureBatcher::SignatureBatcher(SignatureRunner* runner,
+                                   const SignatureBatcherOptions& options)
+    : runner_(runner), options_(options) {}
+
+SignatureBatcher::~SignatureBatcher() {
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    cancelled_ = true;
+  }
+  queue_cv_.notify_all();
+  if (scheduler_thread_.joinable()) {
+    scheduler_thread_.join();
+  }
+}
+
+TfLiteStatus SignatureBatcher::Initialize() {
+  const std::vector<const char*>& input_names = runner_->input_names();
+  input_dims_.resize(input_names.size());
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    const TfLiteTensor* tensor = runner_->input_tensor(input_names[i]);
+    if (tensor == nullptr || tensor->dims == nullptr ||
+        tensor->dims->size < 1 || tensor->type == kTfLiteString) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "SignatureBatcher: input '%s' has no batch dimension.",
+                      input_names[i]);
+      return kTfLiteError;
+    }
+    input_dims_[i].assign(tensor->dims->data,
+                          tensor->dims->data + tensor->dims->size);
+  }
+  // Allocate at batch size 1 so that the per-row footprint of every input can
+  // be read back from the tensors themselves, independently of their type.
+  if (MaybeResize(1) != kTfLiteOk) {
+    return kTfLiteError;
+  }
+  input_row_bytes_.resize(input_names.size());
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    input_row_bytes_[i] = runner_->input_tensor(input_names[i])->bytes;
+  }
+  for (const char* name : runner_->output_names()) {
+    const TfLiteTensor* tensor = runner_->output_tensor(name);
+    if (tensor == nullptr || tensor->type == kTfLiteString) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "SignatureBatcher: output '%s' cannot be batched.", name);
+      return kTfLiteError;
+    }
+  }
+  output_row_bytes_.resize(runner_->output_size());
+  return kTfLiteOk;
+}
+
+TfLiteStatus SignatureBatcher::Run(int num_rows,
+                                   const std::vector<const void*>& inputs,
+                                   std::vector<std::vector<char>>* outputs) {
+  if (num_rows < 1 || num_rows > options_.max_batch_size ||
+      inputs.size() != input_row_bytes_.size() || outputs == nullptr) {
+    return kTfLiteError;
+  }
+  Request request;
+  request.num_rows = num_rows;
+  request.inputs = &inputs;
+  request.outputs = outputs;
+  request.enqueue_time = std::chrono::steady_clock::now();
+
+  std::unique_lock<std::mutex> lock(mu_);
+  if (cancelled_) return kTfLiteError;
+  queue_.push_back(&request);
+  queued_rows_ += num_rows;
+  ++stats_.num_requests;
+  queue_cv_.notify_one();
+  done_cv_.wait(lock, [&request] { return request.done; });
+  return request.status;
+}
+
+SignatureBatcherStats SignatureBatcher::stats() const {
+  std::lock_guard<std::mutex> lock(mu_);
+  return stats_;
+}
+
+void SignatureBatcher::ProcessBatches() {
+  std::vector<Request*> batch;
+  while (true) {
+    int total_rows = 0;
+    {
+      std::unique_lock<std::mutex> lock(mu_);
+      queue_cv_.wait(lock, [this] { return cancelled_ || !queue_.empty(); });
+      if (cancelled_ && queue_.empty()) return;
+      // Wait for the batch to fill up, but never past the deadline of the
+      // oldest request.
+      const auto deadline =
+          queue_.front()->enqueue_time + options_.batch_timeout;
+      queue_cv_.wait_until(lock, deadline, [this] {
+        return cancelled_ || queued_rows_ >= options_.max_batch_size;
+      });
+      while (!queue_.empty() &&
+             total_rows + queue_.front()->num_rows <= options_.max_batch_size) {
+        total_rows += queue_.front()->num_rows;
+        queued_rows_ -= queue_.front()->num_rows;
+        batch.push_back(queue_.front());
+        queue_.pop_front();
+      }
+      ++stats_.num_invocations;
+    }
+
+    const TfLiteStatus status = ExecuteBatch(batch, total_rows);
+
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      for (Request* request : batch) {
+        request->status = status;
+        request->done = true;
+      }
+    }
+    done_cv_.notify_all();
+    batch.clear();
+  }
+}
+
+TfLiteStatus SignatureBatcher::MaybeResize(int total_rows) {
+  if (total_rows == current_batch_size_) return kTfLiteOk;
+  const std::vector<const char*>& input_names = runner_->input_names();
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    input_dims_[i][0] = total_rows;
+    if (runner_->ResizeInputTensor(input_names[i], input_dims_[i]) !=
+        kTfLiteOk) {
+      current_batch_size_ = -1;
+      return kTfLiteError;
+    }
+  }
+  if (runner_->AllocateTensors() != kTfLiteOk) {
+    current_batch_size_ = -1;
+    return kTfLiteError;
+  }
+  current_batch_size_ = total_rows;
+  {
+    std::lock_guard<std::mutex> lock(mu_);
+    ++stats_.num_resizes;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus SignatureBatcher::ExecuteBatch(const std::vector<Request*>& batch,
+                                            int total_rows) {
+  if (MaybeResize(total_rows) != kTfLiteOk) return kTfLiteError;
+
+  const std::vector<const char*>& input_names = runner_->input_names();
+  for (size_t i = 0; i < input_names.size(); ++i) {
+    char* dst = runner_->input_tensor(input_names[i])->data.raw;
+    for (const Request* request : batch) {
+      const size_t bytes = request->num_rows * input_row_bytes_[i];
+      std::memcpy(dst, (*request->inputs)[i], bytes);
+      dst += bytes;
+    }
+  }
+
+  if (runner_->Invoke() != kTfLiteOk) return kTfLiteError;
+
+  const std::vector<const char*>& output_names = runner_->output_names();
+  for (size_t i = 0; i < output_names.size(); ++i) {
+    const TfLiteTensor* tensor = runner_->output_tensor(output_names[i]);
+    if (tensor->dims->size < 1 || tensor->dims->data[0] != total_rows) {
+      TFLITE_LOG_PROD(TFLITE_LOG_ERROR,
+                      "SignatureBatcher: output '%s' is not batched along "
+                      "dimension 0.",
+                      output_names[i]);
+      return kTfLiteError;
+    }
+    // Outputs may be dynamic, so the row size is re-derived on every run.
+    output_row_bytes_[i] = tensor->bytes / total_rows;
+  }
+  for (Request* request : batch) {
+    request->outputs->resize(output_names.size());
+  }
+  for (size_t i = 0; i < output_names.size(); ++i) {
+    const char* src = runner_->output_tensor(output_names[i])->data.raw;
+    for (Request* request : batch) {
+      const size_t bytes = request->num_rows * output_row_bytes_[i];
+      (*request->outputs)[i].assign(src, src + bytes);
+      src += bytes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace batching
+}  // namespace experimental
+}  // namespace tflite
@@ -0,0 +1,151 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_SIGNATURE_BATCHER_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_SIGNATURE_BATCHER_H_
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+namespace experimental {
+namespace batching {
+
+// Options controlling how `SignatureBatcher` forms batches.
+struct SignatureBatcherOptions {
+  // Maximum number of rows (summed over all queued requests) that are
+  // concatenated into a single invocation.
+  int max_batch_size = 8;
+
+  // Maximum time the oldest queued request waits for the batch to fill up
+  // before an under-sized batch is executed anyway.
+  std::chrono::microseconds batch_timeout = std::chrono::microseconds(1000);
+};
+
+// Statistics accumulated over the lifetime of a `SignatureBatcher`.
+struct SignatureBatcherStats {
+  int64_t num_requests = 0;
+  int64_t num_invocations = 0;
+  int64_t num_resizes = 0;
+};
+
+// Queues concurrent invocations of a single `SignatureRunner` and executes
+// them as one invocation over inputs concatenated along dimension 0.
+//
+// Every input and output of the signature must be a non-string tensor whose
+// first dimension is the batch dimension. Each request supplies, for every
+// signature input (in `SignatureRunner::input_names()` order), a dense buffer
+// holding `num_rows` rows. The batcher copies those rows into the shared
+// input tensors, runs `Invoke()` once, and slices the output tensors back
+// into per-request buffers (in `SignatureRunner::output_names()` order).
+//
+// The interpreter is only resized when the total number of rows in a batch
+// differs from the previous invocation, so steady-state traffic at a stable
+// batch size reuses the existing tensor allocations.
+//
+// The batcher takes exclusive ownership of the `SignatureRunner` for its
+// lifetime: no other code may touch the runner (or its interpreter) until the
+// batcher is destroyed. `Run` is thread-safe.
+//
+// WARNING: This is an experimental API and subject to change.
+class SignatureBatcher {
+ public:
+  // Creates a batcher around `runner`, which must outlive the batcher.
+  // Returns nullptr if the signature cannot be batched, e.g. because one of
+  // its inputs or outputs is a scalar or a string tensor.
+  static std::unique_ptr<SignatureBatcher> Create(
+      SignatureRunner* runner, const SignatureBatcherOptions& options);
+
+  ~SignatureBatcher();
+
+  SignatureBatcher(const SignatureBatcher&) = delete;
+  SignatureBatcher& operator=(const SignatureBatcher&) = delete;
+
+  // Runs the signature on `num_rows` rows. `inputs[i]` must point to
+  // `num_rows` rows of input `i`; `outputs` is resized to the number of
+  // signature outputs and filled with `num_rows` rows per output. Blocks until
+  // the batch containing this request has been executed.
+  //
+  // Returns kTfLiteError if the request is malformed, if `num_rows` exceeds
+  // `max_batch_size`, or if the batched invocation failed.
+  TfLiteStatus Run(int num_rows, const std::vector<const void*>& inputs,
+                   std::vector<std::vector<char>>* outputs);
+
+  // Returns the number of bytes occupied by a single row of input `index`.
+  size_t input_row_bytes(int index) const { return input_row_bytes_[index]; }
+
+  SignatureBatcherStats stats() const;
+
+ private:
+  struct Request {
+    int num_rows;
+    const std::vector<const void*>* inputs;
+    std::vector<std::vector<char>>* outputs;
+    std::chrono::steady_clock::time_point enqueue_time;
+    TfLiteStatus status = kTfLiteOk;
+    bool done = false;
+  };
+
+  SignatureBatcher(SignatureRunner* runner,
+                   const SignatureBatcherOptions& options);
+
+  // Computes the per-row byte sizes of every input and output tensor.
+  TfLiteStatus Initialize();
+
+  // Body of the scheduler thread.
+  void ProcessBatches();
+
+  // Executes `batch` (holding `total_rows` rows) on the runner. Called without
+  // holding `mu_`.
+  TfLiteStatus ExecuteBatch(const std::vector<Request*>& batch,
+                            int total_rows);
+
+  // Resizes every input to `total_rows` rows and reallocates tensors if the
+  // current batch size differs.
+  TfLiteStatus MaybeResize(int total_rows);
+
+  SignatureRunner* const runner_;
+  const SignatureBatcherOptions options_;
+
+  std::vector<size_t> input_row_bytes_;
+  std::vector<size_t> output_row_bytes_;
+  std::vector<std::vector<int>> input_dims_;
+  int current_batch_size_ = -1;
+
+  mutable std::mutex mu_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  int queued_rows_ = 0;
+  bool cancelled_ = false;
+  SignatureBatcherStats stats_;
+
+  std::thread scheduler_thread_;
+};
+
+}  // namespace batching
+}  // namespace experimental
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_BATCHING_SIGNATURE_BATCHER_H_
@@ -0,0 +1,127 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include <chrono>  // NOLINT(build/c++11)
+#include <cstring>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/experimental/batching/signature_batcher.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+namespace experimental {
+namespace batching {
+namespace {
+
+constexpr char kModelPath[] = "tensorflow/lite/testdata/add.bin";
+constexpr int kRowElements = 8 * 8 * 3;
+
+// Owns a model and interpreter that are shared by all benchmark threads.
+struct SharedRunner {
+  SharedRunner() {
+    model = FlatBufferModel::BuildFromFile(kModelPath);
+    ABSL_CHECK(model != nullptr);
+    ops::builtin::BuiltinOpResolver resolver;
+    ABSL_CHECK_EQ(InterpreterBuilder(*model, resolver)(&interpreter),
+                  kTfLiteOk);
+    runner = interpreter->GetSignatureRunner(nullptr);
+    ABSL_CHECK(runner != nullptr);
+    ABSL_CHECK_EQ(runner->AllocateTensors(), kTfLiteOk);
+  }
+
+  std::unique_ptr<FlatBufferModel> model;
+  std::unique_ptr<Interpreter> interpreter;
+  SignatureRunner* runner = nullptr;
+};
+
+SharedRunner* shared_runner = nullptr;
+std::mutex shared_runner_mu;
+SignatureBatcher* shared_batcher = nullptr;
+
+// Baseline: every request invokes the interpreter on its own batch-1 input,
+// serialized by a mutex since `SignatureRunner` is not thread-safe.
+void BM_Unbatched(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    shared_runner = new SharedRunner();
+  }
+  std::vector<float> input(kRowElements, 1.0f);
+  std::vector<float> output(kRowElements);
+  for (auto _ : state) {
+    std::lock_guard<std::mutex> lock(shared_runner_mu);
+    SignatureRunner* runner = shared_runner->runner;
+    std::memcpy(runner->input_tensor("input")->data.raw, input.data(),
+                input.size() * sizeof(float));
+    ABSL_CHECK_EQ(runner->Invoke(), kTfLiteOk);
+    std::memcpy(output.data(), runner->output_tensor("output")->data.raw,
+                output.size() * sizeof(float));
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    delete shared_runner;
+    shared_runner = nullptr;
+  }
+}
+
+// Same traffic routed through a `SignatureBatcher`; `range(0)` is the maximum
+// batch size.
+void BM_Batched(benchmark::State& state) {
+  if (state.thread_index() == 0) {
+    shared_runner = new SharedRunner();
+    SignatureBatcherOptions options;
+    options.max_batch_size = state.range(0);
+    options.batch_timeout = std::chrono::microseconds(200);
+    shared_batcher =
+        SignatureBatcher::Create(shared_runner->runner, options).release();
+  }
+  std::vector<float> input(kRowElements, 1.0f);
+  std::vector<std::vector<char>> outputs;
+  for (auto _ : state) {
+    ABSL_CHECK_EQ(shared_batcher->Run(1, {input.data()}, &outputs), kTfLiteOk);
+  }
+  state.SetItemsProcessed(state.iterations());
+  if (state.thread_index() == 0) {
+    const SignatureBatcherStats stats = shared_batcher->stats();
+    state.counters["avg_batch"] =
+        stats.num_invocations == 0
+            ? 0
+            : static_cast<double>(stats.num_requests) / stats.num_invocations;
+    delete shared_batcher;
+    shared_batcher = nullptr;
+    delete shared_runner;
+    shared_runner = nullptr;
+  }
+}
+
+BENCHMARK(BM_Unbatched)->ThreadRange(1, 32)->UseRealTime();
+BENCHMARK(BM_Batched)
+    ->Arg(8)
+    ->Arg(32)
+    ->ThreadRange(1, 32)
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace batching
+}  // namespace experimental
+}  // namespace tflite
+
+BENCHMARK_MAIN();
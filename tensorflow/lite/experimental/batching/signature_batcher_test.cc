@@ -0,0 +1,151 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/experimental/batching/signature_batcher.h"
+
+#include <chrono>  // NOLINT(build/c++11)
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/core/interpreter.h"
+#include "tensorflow/lite/core/interpreter_builder.h"
+#include "tensorflow/lite/core/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/signature_runner.h"
+
+namespace tflite {
+namespace experimental {
+namespace batching {
+namespace {
+
+// add.bin computes `output = input + input + input` on a [1, 8, 8, 3] float
+// tensor.
+constexpr int kRowElements = 8 * 8 * 3;
+
+class SignatureBatcherTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    model_ = FlatBufferModel::BuildFromFile(
+        "tensorflow/lite/testdata/add.bin");
+    ASSERT_NE(model_, nullptr);
+    ops::builtin::BuiltinOpResolver resolver;
+    ASSERT_EQ(InterpreterBuilder(*model_, resolver)(&interpreter_), kTfLiteOk);
+    runner_ = interpreter_->GetSignatureRunner(nullptr);
+    ASSERT_NE(runner_, nullptr);
+  }
+
+  std::unique_ptr<FlatBufferModel> model_;
+  std::unique_ptr<Interpreter> interpreter_;
+  SignatureRunner* runner_ = nullptr;
+};
+
+TEST_F(SignatureBatcherTest, SingleRequest) {
+  auto batcher = SignatureBatcher::Create(runner_, SignatureBatcherOptions());
+  ASSERT_NE(batcher, nullptr);
+  EXPECT_EQ(batcher->input_row_bytes(0), kRowElements * sizeof(float));
+
+  std::vector<float> input(kRowElements, 2.0f);
+  std::vector<std::vector<char>> outputs;
+  ASSERT_EQ(batcher->Run(1, {input.data()}, &outputs), kTfLiteOk);
+  ASSERT_EQ(outputs.size(), 1);
+  ASSERT_EQ(outputs[0].size(), kRowElements * sizeof(float));
+  const float* result = reinterpret_cast<const float*>(outputs[0].data());
+  for (int i = 0; i < kRowElements; ++i) {
+    EXPECT_FLOAT_EQ(result[i], 6.0f);
+  }
+}
+
+TEST_F(SignatureBatcherTest, MultiRowRequest) {
+  auto batcher = SignatureBatcher::Create(runner_, SignatureBatcherOptions());
+  ASSERT_NE(batcher, nullptr);
+
+  std::vector<float> input(3 * kRowElements);
+  for (int i = 0; i < 3 * kRowElements; ++i) input[i] = i;
+  std::vector<std::vector<char>> outputs;
+  ASSERT_EQ(batcher->Run(3, {input.data()}, &outputs), kTfLiteOk);
+  ASSERT_EQ(outputs[0].size(), 3 * kRowElements * sizeof(float));
+  const float* result = reinterpret_cast<const float*>(outputs[0].data());
+  for (int i = 0; i < 3 * kRowElements; ++i) {
+    EXPECT_FLOAT_EQ(result[i], 3 * input[i]);
+  }
+}
+
+TEST_F(SignatureBatcherTest, RejectsOversizedRequest) {
+  SignatureBatcherOptions options;
+  options.max_batch_size = 2;
+  auto batcher = SignatureBatcher::Create(runner_, options);
+  ASSERT_NE(batcher, nullptr);
+
+  std::vector<float> input(3 * kRowElements);
+  std::vector<std::vector<char>> outputs;
+  EXPECT_EQ(batcher->Run(3, {input.data()}, &outputs), kTfLiteError);
+  EXPECT_EQ(batcher->Run(1, {}, &outputs), kTfLiteError);
+}
+
+TEST_F(SignatureBatcherTest, ConcurrentRequestsAreBatched) {
+  constexpr int kNumThreads = 8;
+  SignatureBatcherOptions options;
+  options.max_batch_size = kNumThreads;
+  // A generous timeout so that all threads land in the same batch.
+  options.batch_timeout = std::chrono::seconds(10);
+  auto batcher = SignatureBatcher::Create(runner_, options);
+  ASSERT_NE(batcher, nullptr);
+
+  std::vector<std::vector<std::vector<char>>> outputs(kNumThreads);
+  std::vector<TfLiteStatus> statuses(kNumThreads, kTfLiteError);
+  std::vector<std::vector<float>> inputs(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kNumThreads; ++t) {
+    inputs[t].assign(kRowElements, static_cast<float>(t));
+    threads.emplace_back([&, t] {
+      statuses[t] = batcher->Run(1, {inputs[t].data()}, &outputs[t]);
+    });
+  }
+  for (std::thread& thread : threads) thread.join();
+
+  for (int t = 0; t < kNumThreads; ++t) {
+    ASSERT_EQ(statuses[t], kTfLiteOk);
+    const float* result = reinterpret_cast<const float*>(outputs[t][0].data());
+    for (int i = 0; i < kRowElements; ++i) {
+      EXPECT_FLOAT_EQ(result[i], 3.0f * t);
+    }
+  }
+  const SignatureBatcherStats stats = batcher->stats();
+  EXPECT_EQ(stats.num_requests, kNumThreads);
+  EXPECT_EQ(stats.num_invocations, 1);
+}
+
+TEST_F(SignatureBatcherTest, ReusesAllocationForStableBatchSize) {
+  SignatureBatcherOptions options;
+  options.batch_timeout = std::chrono::microseconds(0);
+  auto batcher = SignatureBatcher::Create(runner_, options);
+  ASSERT_NE(batcher, nullptr);
+
+  std::vector<float> input(kRowElements, 1.0f);
+  std::vector<std::vector<char>> outputs;
+  for (int i = 0; i < 4; ++i) {
+    ASSERT_EQ(batcher->Run(1, {input.data()}, &outputs), kTfLiteOk);
+  }
+  // Only the initial allocation at batch size 1 happened.
+  EXPECT_EQ(batcher->stats().num_resizes, 1);
+  EXPECT_EQ(batcher->stats().num_invocations, 4);
+}
+
+}  // namespace
+}  // namespace batching
+}  // namespace experimental
+}  // namespace tflite
@@ -18,6 +18,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -42,6 +43,9 @@ absl::Status Prepare(AbsOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(AbsOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kAbs, input, output)) {
+    return absl::OkStatus();
+  }
   Abs abs;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
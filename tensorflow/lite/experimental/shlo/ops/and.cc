@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/binary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -46,6 +47,9 @@ absl::Status Prepare(AndOp& op, const Tensor& lhs, const Tensor& rhs,
 
 absl::Status Evaluate(AndOp& op, const Tensor& lhs, const Tensor& rhs,
                       Tensor& output) {
+  if (EvaluateVectorized(BinaryKernel::kAnd, lhs, rhs, output)) {
+    return absl::OkStatus();
+  }
   if (IsIntTensor(lhs)) {
     // Note: all the integer types share the same implementation.
     And<DataType::kSI32> and_func;
@@ -17,6 +17,7 @@ limitations under the License.
 #define TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_BINARY_ELEMENTWISE_H_
 
 #include "tensorflow/lite/experimental/shlo/data_type.h"
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
 #include "tensorflow/lite/experimental/shlo/quantize.h"
 #include "tensorflow/lite/experimental/shlo/quantized_tensor_element_type.h"
 #include "tensorflow/lite/experimental/shlo/shape.h"
@@ -48,16 +49,19 @@ void DequantizeOpQuantizePerTensor(F&& func, const Tensor& lhs,
   const StorageT* rhs_data = rhs.GetDataAs<storage_type>();
   StorageT* output_data = output.GetDataAs<storage_type>();
   const ExpressedT inv_scale = static_cast<ExpressedT>(1) / output_scale;
-  for (DimensionSize i = 0; i < num_elements;
-       ++i, ++lhs_data, ++rhs_data, ++output_data) {
-    const ExpressedT dequantized_lhs =
-        Dequantize(*lhs_data, lhs_zero_point, lhs_scale);
-    const ExpressedT dequantized_rhs =
-        Dequantize(*rhs_data, rhs_zero_point, rhs_scale);
-    const ExpressedT dequantized_res = func(dequantized_lhs, dequantized_rhs);
-    *output_data = Quantize<storage_type, expressed_type>(
-        dequantized_res, output_zero_point, inv_scale);
-  }
+  ParallelFor(num_elements, kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                for (DimensionSize i = begin; i < end; ++i) {
+                  const ExpressedT dequantized_lhs =
+                      Dequantize(lhs_data[i], lhs_zero_point, lhs_scale);
+                  const ExpressedT dequantized_rhs =
+                      Dequantize(rhs_data[i], rhs_zero_point, rhs_scale);
+                  const ExpressedT dequantized_res =
+                      func(dequantized_lhs, dequantized_rhs);
+                  output_data[i] = Quantize<storage_type, expressed_type>(
+                      dequantized_res, output_zero_point, inv_scale);
+                }
+              });
 }
 
 template <DataType data_type, class F>
@@ -67,11 +71,13 @@ void EvaluateNoQuantization(F&& func, const Tensor& lhs, const Tensor& rhs,
   const T* lhs_data = lhs.GetDataAs<data_type>();
   const T* rhs_data = rhs.GetDataAs<data_type>();
   T* output_data = output.GetDataAs<data_type>();
-  const DimensionSize num_elements = lhs.NumElements();
-  for (DimensionSize i = 0; i < num_elements;
-       ++i, ++output_data, ++lhs_data, ++rhs_data) {
-    *output_data = static_cast<T>(func(*lhs_data, *rhs_data));
-  }
+  ParallelFor(lhs.NumElements(), kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                for (DimensionSize i = begin; i < end; ++i) {
+                  output_data[i] =
+                      static_cast<T>(func(lhs_data[i], rhs_data[i]));
+                }
+              });
 }
 
 }  // namespace detail
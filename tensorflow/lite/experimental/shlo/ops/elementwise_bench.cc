@@ -0,0 +1,261 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Compares the vectorized elementwise kernels against the scalar
+// implementation of the same ops. Each benchmark takes the number of elements,
+// the maximum instruction set (0 is the scalar implementation, see `Isa`) and
+// the maximum number of threads. Ops without vectorized kernels only run the
+// scalar implementation, as a baseline for future kernels. is_finite has its
+// own benchmark.
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/log/absl_check.h"
+#include "absl/types/span.h"
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/experimental/shlo/data_type.h"
+#include "tensorflow/lite/experimental/shlo/ops/abs.h"
+#include "tensorflow/lite/experimental/shlo/ops/and.h"
+#include "tensorflow/lite/experimental/shlo/ops/benchmark_util.h"
+#include "tensorflow/lite/experimental/shlo/ops/cbrt.h"
+#include "tensorflow/lite/experimental/shlo/ops/ceil.h"
+#include "tensorflow/lite/experimental/shlo/ops/compare.h"
+#include "tensorflow/lite/experimental/shlo/ops/cosine.h"
+#include "tensorflow/lite/experimental/shlo/ops/count_leading_zeros.h"
+#include "tensorflow/lite/experimental/shlo/ops/divide.h"
+#include "tensorflow/lite/experimental/shlo/ops/exponential.h"
+#include "tensorflow/lite/experimental/shlo/ops/exponential_minus_one.h"
+#include "tensorflow/lite/experimental/shlo/ops/floor.h"
+#include "tensorflow/lite/experimental/shlo/ops/log.h"
+#include "tensorflow/lite/experimental/shlo/ops/log_plus_one.h"
+#include "tensorflow/lite/experimental/shlo/ops/logistic.h"
+#include "tensorflow/lite/experimental/shlo/ops/maximum.h"
+#include "tensorflow/lite/experimental/shlo/ops/minimum.h"
+#include "tensorflow/lite/experimental/shlo/ops/multiply.h"
+#include "tensorflow/lite/experimental/shlo/ops/negate.h"
+#include "tensorflow/lite/experimental/shlo/ops/not.h"
+#include "tensorflow/lite/experimental/shlo/ops/or.h"
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
+#include "tensorflow/lite/experimental/shlo/ops/popcnt.h"
+#include "tensorflow/lite/experimental/shlo/ops/sign.h"
+#include "tensorflow/lite/experimental/shlo/ops/sine.h"
+#include "tensorflow/lite/experimental/shlo/ops/sqrt.h"
+#include "tensorflow/lite/experimental/shlo/ops/subtract.h"
+#include "tensorflow/lite/experimental/shlo/ops/tanh.h"
+#include "tensorflow/lite/experimental/shlo/ops/xor.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
+#include "tensorflow/lite/experimental/shlo/shape.h"
+#include "tensorflow/lite/experimental/shlo/tensor.h"
+#include "tensorflow/lite/experimental/shlo/tensor_with_data.h"
+
+namespace shlo_ref {
+namespace {
+
+// Applies the instruction set and thread count arguments for the duration of
+// a benchmark.
+class ScopedConfig {
+ public:
+  explicit ScopedConfig(const benchmark::State& state)
+      : max_num_threads_(GetMaxNumThreads()) {
+    SetMaxIsa(static_cast<Isa>(state.range(1)));
+    SetMaxNumThreads(state.range(2));
+  }
+
+  ~ScopedConfig() {
+    SetMaxIsa(Isa::kAvx2);
+    SetMaxNumThreads(max_num_threads_);
+  }
+
+ private:
+  int max_num_threads_;
+};
+
+template <DataType data_type>
+TensorWithData CreateOperand(DimensionSize num_elements) {
+  if constexpr (IsInteger(data_type)) {
+    auto values = GenerateRandomVector<DataType::kF32>(num_elements);
+    return TensorWithData::Create<data_type, DataType::kF32>(
+        Shape{{num_elements}}, values, 0.1, 0);
+  } else {
+    auto values = GenerateRandomVector<data_type>(num_elements);
+    return TensorWithData::Create<data_type>(Shape{{num_elements}}, values);
+  }
+}
+
+// Creates a tensor of integers or bools, which CreateOperand quantizes.
+template <DataType data_type>
+TensorWithData CreateIntegerOperand(DimensionSize num_elements) {
+  if constexpr (data_type == DataType::kI1) {
+    const auto bytes = GenerateRandomVector<DataType::kSI8>(num_elements);
+    auto values = std::make_unique<bool[]>(num_elements);
+    for (DimensionSize i = 0; i < num_elements; ++i) {
+      values[i] = bytes[i] & 1;
+    }
+    return TensorWithData::Create<data_type>(
+        Shape{{num_elements}},
+        absl::MakeConstSpan(values.get(), num_elements));
+  } else {
+    auto values = GenerateRandomVector<data_type>(num_elements);
+    return TensorWithData::Create<data_type>(Shape{{num_elements}}, values);
+  }
+}
+
+template <class Op>
+void RunUnary(benchmark::State& state, const TensorWithData& operand) {
+  Op op = Create(typename Op::Attributes{});
+  Tensor result{.type = operand.tensor().type};
+  ABSL_CHECK_OK(Prepare(op, operand.tensor(), result));
+  std::vector<std::byte> result_values(result.SizeInBytes());
+  result.data = result_values.data();
+
+  ScopedConfig config(state);
+  for (auto _ : state) {
+    ABSL_CHECK_OK(Evaluate(op, operand.tensor(), result));
+  }
+  state.SetItemsProcessed(state.iterations() * operand.tensor().NumElements());
+}
+
+template <class Op>
+void RunBinary(benchmark::State& state, Op op, const TensorWithData& lhs,
+               const TensorWithData& rhs, Tensor result) {
+  ABSL_CHECK_OK(Prepare(op, lhs.tensor(), rhs.tensor(), result));
+  std::vector<std::byte> result_values(result.SizeInBytes());
+  result.data = result_values.data();
+
+  ScopedConfig config(state);
+  for (auto _ : state) {
+    ABSL_CHECK_OK(Evaluate(op, lhs.tensor(), rhs.tensor(), result));
+  }
+  state.SetItemsProcessed(state.iterations() * lhs.tensor().NumElements());
+}
+
+template <class Op, DataType data_type>
+void BM_Unary(benchmark::State& state) {
+  RunUnary<Op>(state, CreateOperand<data_type>(state.range(0)));
+}
+
+template <class Op, DataType data_type>
+void BM_IntegerUnary(benchmark::State& state) {
+  RunUnary<Op>(state, CreateIntegerOperand<data_type>(state.range(0)));
+}
+
+template <class Op, DataType data_type>
+void BM_Binary(benchmark::State& state) {
+  const TensorWithData lhs = CreateOperand<data_type>(state.range(0));
+  const TensorWithData rhs = CreateOperand<data_type>(state.range(0));
+  RunBinary(state, Create(typename Op::Attributes{}), lhs, rhs,
+            Tensor{.type = lhs.tensor().type});
+}
+
+template <class Op, DataType data_type>
+void BM_IntegerBinary(benchmark::State& state) {
+  const TensorWithData lhs = CreateIntegerOperand<data_type>(state.range(0));
+  const TensorWithData rhs = CreateIntegerOperand<data_type>(state.range(0));
+  RunBinary(state, Create(typename Op::Attributes{}), lhs, rhs,
+            Tensor{.type = lhs.tensor().type});
+}
+
+template <DataType data_type>
+void BM_Compare(benchmark::State& state) {
+  const TensorWithData lhs = CreateOperand<data_type>(state.range(0));
+  const TensorWithData rhs = CreateOperand<data_type>(state.range(0));
+  RunBinary(state,
+            Create(CompareOp::Attributes{
+                .comparison_direction = CompareOp::ComparisonDirection::kLt}),
+            lhs, rhs,
+            Tensor{.type = TensorType{.shape = lhs.tensor().shape(),
+                                      .element_type = DataType::kI1}});
+}
+
+void AddArgs(benchmark::internal::Benchmark* b, Isa isa) {
+  b->Args({KiB(64), static_cast<int64_t>(isa), 1});
+  for (const int64_t threads : {1, 4}) {
+    b->Args({KiB(1024), static_cast<int64_t>(isa), threads});
+  }
+}
+
+void ElementwiseArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"elements", "isa", "threads"})->UseRealTime();
+  for (const Isa isa : {Isa::kScalar, Isa::kAvx2}) {
+    AddArgs(b, isa);
+  }
+}
+
+void ScalarElementwiseArgs(benchmark::internal::Benchmark* b) {
+  b->ArgNames({"elements", "isa", "threads"})->UseRealTime();
+  AddArgs(b, Isa::kScalar);
+}
+
+#define SHLO_REF_ELEMENTWISE_BENCHMARKS(BM, Op, Args) \
+  BENCHMARK(BM<Op, DataType::kF32>)->Apply(Args);     \
+  BENCHMARK(BM<Op, DataType::kBF16>)->Apply(Args);    \
+  BENCHMARK(BM<Op, DataType::kF16>)->Apply(Args);     \
+  BENCHMARK(BM<Op, DataType::kSI8>)->Apply(Args);
+
+#define SHLO_REF_INTEGER_BENCHMARKS(BM, Op, Args)  \
+  BENCHMARK(BM<Op, DataType::kSI8>)->Apply(Args);  \
+  BENCHMARK(BM<Op, DataType::kSI16>)->Apply(Args); \
+  BENCHMARK(BM<Op, DataType::kSI32>)->Apply(Args);
+
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, AbsOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, CbrtOp, ScalarElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, CeilOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, CosineOp, ScalarElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, ExponentialOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, ExponentialMinusOneOp,
+                                ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, FloorOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, LogOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, LogPlusOneOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, LogisticOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, NegateOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, SignOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, SineOp, ScalarElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, SqrtOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Unary, TanhOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Binary, DivideOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Binary, MaximumOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Binary, MinimumOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Binary, MultiplyOp, ElementwiseArgs)
+SHLO_REF_ELEMENTWISE_BENCHMARKS(BM_Binary, SubtractOp, ElementwiseArgs)
+
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerUnary, CountLeadingZerosOp,
+                            ScalarElementwiseArgs)
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerUnary, NotOp, ElementwiseArgs)
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerUnary, PopcntOp, ScalarElementwiseArgs)
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerBinary, AndOp, ElementwiseArgs)
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerBinary, OrOp, ElementwiseArgs)
+SHLO_REF_INTEGER_BENCHMARKS(BM_IntegerBinary, XorOp, ElementwiseArgs)
+
+BENCHMARK(BM_IntegerUnary<NotOp, DataType::kI1>)->Apply(ElementwiseArgs);
+BENCHMARK(BM_IntegerBinary<AndOp, DataType::kI1>)->Apply(ElementwiseArgs);
+BENCHMARK(BM_IntegerBinary<OrOp, DataType::kI1>)->Apply(ElementwiseArgs);
+BENCHMARK(BM_IntegerBinary<XorOp, DataType::kI1>)->Apply(ElementwiseArgs);
+
+BENCHMARK(BM_Compare<DataType::kF32>)->Apply(ScalarElementwiseArgs);
+BENCHMARK(BM_Compare<DataType::kBF16>)->Apply(ScalarElementwiseArgs);
+BENCHMARK(BM_Compare<DataType::kF16>)->Apply(ScalarElementwiseArgs);
+BENCHMARK(BM_Compare<DataType::kSI8>)->Apply(ScalarElementwiseArgs);
+
+#undef SHLO_REF_INTEGER_BENCHMARKS
+#undef SHLO_REF_ELEMENTWISE_BENCHMARKS
+
+}  // namespace
+}  // namespace shlo_ref
+
+BENCHMARK_MAIN();
@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/f16.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -59,6 +60,9 @@ absl::Status Prepare(ExponentialMinusOneOp& op, const Tensor& input,
 
 absl::Status Evaluate(ExponentialMinusOneOp& op, const Tensor& input,
                       Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kExponentialMinusOne, input, output)) {
+    return absl::OkStatus();
+  }
   ExponentialMinusOne exponential_minus_one;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
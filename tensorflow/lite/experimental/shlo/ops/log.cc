@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/f16.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -56,6 +57,9 @@ absl::Status Prepare(LogOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(LogOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kLog, input, output)) {
+    return absl::OkStatus();
+  }
   Log log;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
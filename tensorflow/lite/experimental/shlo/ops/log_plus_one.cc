@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/f16.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -57,6 +58,9 @@ absl::Status Prepare(LogPlusOneOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(LogPlusOneOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kLogPlusOne, input, output)) {
+    return absl::OkStatus();
+  }
   LogPlusOne log_plus_one;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/binary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -47,6 +48,9 @@ absl::Status Prepare(MinimumOp& op, const Tensor& lhs, const Tensor& rhs,
 
 absl::Status Evaluate(MinimumOp& op, const Tensor& lhs, const Tensor& rhs,
                       Tensor& output) {
+  if (EvaluateVectorized(BinaryKernel::kMinimum, lhs, rhs, output)) {
+    return absl::OkStatus();
+  }
   Minimum minimum;
   if (IsBoolTensor(lhs) || IsIntTensor(lhs) || IsFloatTensor(lhs)) {
     // Note: all the arithmetic types share the same implementation.
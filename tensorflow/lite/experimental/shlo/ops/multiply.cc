@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/binary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -54,6 +55,9 @@ absl::Status Prepare(MultiplyOp& op, const Tensor& lhs, const Tensor& rhs,
 
 absl::Status Evaluate(MultiplyOp& op, const Tensor& lhs, const Tensor& rhs,
                       Tensor& output) {
+  if (EvaluateVectorized(BinaryKernel::kMultiply, lhs, rhs, output)) {
+    return absl::OkStatus();
+  }
   if (IsBoolTensor(lhs)) {
     detail::EvaluateNoQuantization<DataType::kI1>(Multiply<DataType::kI1>(),
                                                   lhs, rhs, output);
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -40,6 +41,9 @@ absl::Status Prepare(NegateOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(NegateOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kNegate, input, output)) {
+    return absl::OkStatus();
+  }
   Negate negate;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
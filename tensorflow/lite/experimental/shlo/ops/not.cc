@@ -19,6 +19,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -47,6 +48,9 @@ absl::Status Prepare(NotOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(NotOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kNot, input, output)) {
+    return absl::OkStatus();
+  }
   Not not_func;
   if (IsIntTensor(input) || IsBoolTensor(input)) {
     DISPATCH_BOOL_INT(detail::EvaluateNoQuantization,
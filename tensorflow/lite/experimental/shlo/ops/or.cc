@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/binary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -46,6 +47,9 @@ absl::Status Prepare(OrOp& op, const Tensor& lhs, const Tensor& rhs,
 
 absl::Status Evaluate(OrOp& op, const Tensor& lhs, const Tensor& rhs,
                       Tensor& output) {
+  if (EvaluateVectorized(BinaryKernel::kOr, lhs, rhs, output)) {
+    return absl::OkStatus();
+  }
   if (IsIntTensor(lhs)) {
     // Note: all the integer types share the same implementation.
     Or<DataType::kSI32> or_func;
@@ -0,0 +1,130 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <deque>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+
+#include "absl/functional/function_ref.h"
+#include "tensorflow/lite/experimental/shlo/shape.h"
+
+namespace shlo_ref {
+
+namespace {
+
+std::atomic<int>& MaxNumThreads() {
+  static std::atomic<int> max_num_threads(1);
+  return max_num_threads;
+}
+
+// Worker threads shared by all the ParallelFor calls of the process. They are
+// started the first time they are needed and never stopped, so that an op does
+// not pay for starting threads.
+class WorkerPool {
+ public:
+  static WorkerPool& Get() {
+    static WorkerPool* pool = new WorkerPool();
+    return *pool;
+  }
+
+  // Calls `task(i)` for every i in [0, num_tasks), using the calling thread
+  // and up to `num_tasks - 1` workers, and returns once all the calls are done.
+  void Run(DimensionSize num_tasks,
+           absl::FunctionRef<void(DimensionSize)> task) {
+    Batch batch{task, num_tasks};
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (; num_workers_ < num_tasks - 1; ++num_workers_) {
+      std::thread([this]() { WorkerLoop(); }).detach();
+    }
+    batches_.push_back(&batch);
+    work_available_.notify_all();
+    // The calling thread runs tasks as well, so the call completes even if
+    // the workers are busy with other calls.
+    while (RunNextTask(batch, lock)) {
+    }
+    work_done_.wait(lock, [&]() { return batch.num_done == num_tasks; });
+  }
+
+ private:
+  struct Batch {
+    absl::FunctionRef<void(DimensionSize)> task;
+    DimensionSize num_tasks;
+    DimensionSize next = 0;
+    DimensionSize num_done = 0;
+  };
+
+  // Runs the next task of `batch` without holding `lock`. Returns false if all
+  // of them have been started.
+  bool RunNextTask(Batch& batch, std::unique_lock<std::mutex>& lock) {
+    if (batch.next == batch.num_tasks) return false;
+    const DimensionSize index = batch.next++;
+    if (batch.next == batch.num_tasks) {
+      batches_.erase(std::find(batches_.begin(), batches_.end(), &batch));
+    }
+    lock.unlock();
+    batch.task(index);
+    lock.lock();
+    if (++batch.num_done == batch.num_tasks) work_done_.notify_all();
+    return true;
+  }
+
+  void WorkerLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_available_.wait(lock, [this]() { return !batches_.empty(); });
+      RunNextTask(*batches_.front(), lock);
+    }
+  }
+
+  std::mutex mutex_;
+  std::condition_variable work_available_;
+  std::condition_variable work_done_;
+  // The calls with tasks that have not been started.
+  std::deque<Batch*> batches_;
+  DimensionSize num_workers_ = 0;
+};
+
+}  // namespace
+
+int GetMaxNumThreads() { return MaxNumThreads().load(); }
+
+void SetMaxNumThreads(int num_threads) {
+  MaxNumThreads().store(std::max(1, num_threads));
+}
+
+void ParallelFor(DimensionSize size, DimensionSize min_chunk_size,
+                 absl::FunctionRef<void(DimensionSize, DimensionSize)> func) {
+  const DimensionSize num_chunks = std::min<DimensionSize>(
+      GetMaxNumThreads(), size / std::max<DimensionSize>(min_chunk_size, 1));
+  if (num_chunks <= 1) {
+    func(0, size);
+    return;
+  }
+  // Spread the remainder over the first chunks so their sizes differ by at
+  // most one element.
+  const DimensionSize chunk_size = size / num_chunks;
+  const DimensionSize remainder = size % num_chunks;
+  WorkerPool::Get().Run(num_chunks, [&](DimensionSize i) {
+    const DimensionSize begin = i * chunk_size + std::min(i, remainder);
+    func(begin, begin + chunk_size + (i < remainder ? 1 : 0));
+  });
+}
+
+}  // namespace shlo_ref
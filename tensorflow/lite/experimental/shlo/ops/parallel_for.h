@@ -0,0 +1,45 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_PARALLEL_FOR_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_PARALLEL_FOR_H_
+
+#include "absl/functional/function_ref.h"
+#include "tensorflow/lite/experimental/shlo/shape.h"
+
+namespace shlo_ref {
+
+// Elementwise ops only use more than one thread when every thread gets at least
+// this many elements, to amortize the cost of starting the threads.
+inline constexpr DimensionSize kMinElementsPerThread = 1 << 16;
+
+// Returns the maximum number of threads ParallelFor uses. Defaults to 1, so
+// that ops only run on the calling thread unless the application opts in.
+int GetMaxNumThreads();
+
+// Sets the maximum number of threads ParallelFor uses. 1 disables threading.
+void SetMaxNumThreads(int num_threads);
+
+// Calls `func(begin, end)` on consecutive chunks that together cover
+// [0, size). The chunks are processed concurrently, using at most
+// GetMaxNumThreads() threads (including the calling thread) and giving each of
+// them at least `min_chunk_size` elements. The other threads come from a pool
+// kept for the lifetime of the process.
+void ParallelFor(DimensionSize size, DimensionSize min_chunk_size,
+                 absl::FunctionRef<void(DimensionSize, DimensionSize)> func);
+
+}  // namespace shlo_ref
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_PARALLEL_FOR_H_
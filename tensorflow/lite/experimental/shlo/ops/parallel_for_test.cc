@@ -0,0 +1,100 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>   // NOLINT(build/c++11)
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "tensorflow/lite/experimental/shlo/shape.h"
+
+namespace shlo_ref {
+namespace {
+
+class ParallelForTest : public ::testing::Test {
+ protected:
+  void TearDown() override { SetMaxNumThreads(default_max_num_threads_); }
+
+  // Runs ParallelFor and returns the chunks it was called with, sorted.
+  std::vector<std::pair<DimensionSize, DimensionSize>> Chunks(
+      DimensionSize size, DimensionSize min_chunk_size) {
+    std::mutex mutex;
+    std::vector<std::pair<DimensionSize, DimensionSize>> chunks;
+    ParallelFor(size, min_chunk_size,
+                [&](DimensionSize begin, DimensionSize end) {
+                  std::lock_guard<std::mutex> lock(mutex);
+                  chunks.emplace_back(begin, end);
+                });
+    std::sort(chunks.begin(), chunks.end());
+    return chunks;
+  }
+
+ private:
+  const int default_max_num_threads_ = GetMaxNumThreads();
+};
+
+TEST_F(ParallelForTest, DefaultsToOneThread) {
+  EXPECT_EQ(GetMaxNumThreads(), 1);
+  EXPECT_EQ(Chunks(1000, 10).size(), 1);
+}
+
+TEST_F(ParallelForTest, SmallSizesUseOneChunk) {
+  SetMaxNumThreads(4);
+  using Chunks = std::vector<std::pair<DimensionSize, DimensionSize>>;
+  EXPECT_EQ(this->Chunks(0, 10), (Chunks{{0, 0}}));
+  EXPECT_EQ(this->Chunks(19, 10), (Chunks{{0, 19}}));
+}
+
+TEST_F(ParallelForTest, ChunksCoverTheRangeEvenly) {
+  SetMaxNumThreads(4);
+  using Chunks = std::vector<std::pair<DimensionSize, DimensionSize>>;
+  EXPECT_EQ(this->Chunks(30, 10), (Chunks{{0, 10}, {10, 20}, {20, 30}}));
+  EXPECT_EQ(this->Chunks(103, 10),
+            (Chunks{{0, 26}, {26, 52}, {52, 78}, {78, 103}}));
+}
+
+TEST_F(ParallelForTest, MaxNumThreadsLimitsChunks) {
+  SetMaxNumThreads(1);
+  EXPECT_EQ(Chunks(1000, 10).size(), 1);
+  SetMaxNumThreads(2);
+  EXPECT_EQ(Chunks(1000, 10).size(), 2);
+  SetMaxNumThreads(0);
+  EXPECT_EQ(GetMaxNumThreads(), 1);
+}
+
+TEST_F(ParallelForTest, ConcurrentCallsShareThePool) {
+  SetMaxNumThreads(4);
+  std::atomic<DimensionSize> total(0);
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 8; ++i) {
+    callers.emplace_back([&]() {
+      for (int j = 0; j < 100; ++j) {
+        ParallelFor(1000, 10, [&](DimensionSize begin, DimensionSize end) {
+          total += end - begin;
+        });
+      }
+    });
+  }
+  for (std::thread& caller : callers) caller.join();
+  EXPECT_EQ(total.load(), 8 * 100 * 1000);
+}
+
+}  // namespace
+}  // namespace shlo_ref
@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/f16.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -59,6 +60,9 @@ absl::Status Prepare(SignOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(SignOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kSign, input, output)) {
+    return absl::OkStatus();
+  }
   Sign sign;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
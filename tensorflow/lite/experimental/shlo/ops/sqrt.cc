@@ -23,6 +23,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/f16.h"
 #include "tensorflow/lite/experimental/shlo/ops/unary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -56,6 +57,9 @@ absl::Status Prepare(SqrtOp& op, const Tensor& input, Tensor& output) {
 }
 
 absl::Status Evaluate(SqrtOp& op, const Tensor& input, Tensor& output) {
+  if (EvaluateVectorized(UnaryKernel::kSqrt, input, output)) {
+    return absl::OkStatus();
+  }
   Sqrt sqrt;
   if (input.IsPerTensorQuantized()) {
     DISPATCH_QUANTIZED(
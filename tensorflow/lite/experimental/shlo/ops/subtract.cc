@@ -21,6 +21,7 @@ limitations under the License.
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
 #include "tensorflow/lite/experimental/shlo/ops/binary_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
 #include "tensorflow/lite/experimental/shlo/tensor.h"
 
 namespace shlo_ref {
@@ -44,6 +45,9 @@ absl::Status Prepare(SubtractOp& op, const Tensor& lhs, const Tensor& rhs,
 
 absl::Status Evaluate(SubtractOp& op, const Tensor& lhs, const Tensor& rhs,
                       Tensor& output) {
+  if (EvaluateVectorized(BinaryKernel::kSubtract, lhs, rhs, output)) {
+    return absl::OkStatus();
+  }
   Subtract subtract;
   if (IsIntTensor(lhs) || IsFloatTensor(lhs)) {
     // Note: all the arithmetic types share the same implementation.
@@ -16,13 +16,14 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_UNARY_ELEMENTWISE_H_
 #define TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_UNARY_ELEMENTWISE_H_
 
+#include <algorithm>
 #include <cstddef>
 
-#include "absl/algorithm/container.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
 #include "tensorflow/lite/experimental/shlo/data_type.h"
 #include "tensorflow/lite/experimental/shlo/dispatch.h"
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
 #include "tensorflow/lite/experimental/shlo/ops/util.h"
 #include "tensorflow/lite/experimental/shlo/quantize.h"
 #include "tensorflow/lite/experimental/shlo/quantized_tensor_element_type.h"
@@ -118,20 +119,28 @@ void DequantizeOpQuantizePerTensor(F& func, const Tensor& input,
   const StorageT* input_data = input.GetDataAs<storage_type>();
   StorageT* output_data = output.GetDataAs<storage_type>();
   const ExpressedT inv_scale = static_cast<ExpressedT>(1) / output_scale;
-  for (DimensionSize i = 0; i < num_elements;
-       ++i, ++input_data, ++output_data) {
-    const ExpressedT dequantized_input =
-        Dequantize(*input_data, input_zero_point, input_scale);
-    const ExpressedT dequantized_res = func(dequantized_input);
-    *output_data = Quantize<storage_type, expressed_type>(
-        dequantized_res, output_zero_point, inv_scale);
-  }
+  ParallelFor(num_elements, kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                for (DimensionSize i = begin; i < end; ++i) {
+                  const ExpressedT dequantized_input = Dequantize(
+                      input_data[i], input_zero_point, input_scale);
+                  const ExpressedT dequantized_res = func(dequantized_input);
+                  output_data[i] = Quantize<storage_type, expressed_type>(
+                      dequantized_res, output_zero_point, inv_scale);
+                }
+              });
 }
 
 template <DataType data_type, class F>
 void EvaluateNoQuantization(F&& func, const Tensor& input, Tensor& output) {
-  absl::c_transform(input.Flat<data_type>(), output.GetDataAs<data_type>(),
-                    static_cast<F&&>(func));
+  using T = StorageType<data_type>;
+  const T* input_data = input.GetDataAs<data_type>();
+  T* output_data = output.GetDataAs<data_type>();
+  ParallelFor(input.NumElements(), kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                std::transform(input_data + begin, input_data + end,
+                               output_data + begin, func);
+              });
 }
 
 }  // namespace detail
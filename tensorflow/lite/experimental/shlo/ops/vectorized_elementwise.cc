@@ -0,0 +1,877 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "tensorflow/lite/experimental/shlo/data_type.h"
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
+#include "tensorflow/lite/experimental/shlo/shape.h"
+#include "tensorflow/lite/experimental/shlo/tensor.h"
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define SHLO_REF_HAS_AVX2_KERNELS 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace shlo_ref {
+
+namespace {
+
+std::atomic<Isa>& MaxIsa() {
+  static std::atomic<Isa> max_isa(Isa::kAvx2);
+  return max_isa;
+}
+
+Isa DetectIsa() {
+#ifdef SHLO_REF_HAS_AVX2_KERNELS
+  __builtin_cpu_init();
+  unsigned int eax, ebx, ecx, edx;
+  if (__builtin_cpu_supports("avx2") &&
+      __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_F16C)) {
+    return Isa::kAvx2;
+  }
+#endif
+  return Isa::kScalar;
+}
+
+}  // namespace
+
+Isa GetIsa() {
+  static const Isa supported_isa = DetectIsa();
+  return std::min(supported_isa, MaxIsa().load());
+}
+
+void SetMaxIsa(Isa isa) { MaxIsa().store(isa); }
+
+#ifdef SHLO_REF_HAS_AVX2_KERNELS
+
+// The kernels are compiled for AVX2 regardless of the target flags and only
+// called after checking the CPU supports it. FMA is deliberately not enabled:
+// contracting `a * b + c` would round differently from the scalar ops.
+#define SHLO_REF_AVX2 __attribute__((target("avx2,f16c")))
+
+namespace {
+
+// Each kernel works on 8 f32 lanes. How a kernel computes its result decides
+// how it is applied to 16-bit floats:
+//
+// - kArithmetic kernels compute a new value with `Apply`. 16-bit inputs are
+//   widened to f32 and the result rounded back, like the scalar ops do.
+// - kSignFlip kernels negate the lanes selected by `Mask`, kReplace kernels
+//   replace them with the result of `Apply`, and kSelect kernels pick the lhs
+//   in the lanes selected by `Mask` and the rhs elsewhere. These pass the
+//   other 16-bit values through as is, since rounding them back from f32
+//   would not preserve NaN payloads.
+enum class KernelKind { kArithmetic, kSignFlip, kReplace, kSelect };
+
+SHLO_REF_AVX2 inline __m256 SignMask() { return _mm256_set1_ps(-0.0f); }
+
+struct AbsKernel {
+  static constexpr KernelKind kKind = KernelKind::kSignFlip;
+  // Mirrors `val < 0 ? -val : val`, which leaves -0 and NaN untouched.
+  SHLO_REF_AVX2 static __m256 Mask(__m256 v) {
+    return _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_LT_OQ);
+  }
+};
+
+struct NegateKernel {
+  static constexpr KernelKind kKind = KernelKind::kSignFlip;
+  SHLO_REF_AVX2 static __m256 Mask(__m256 v) {
+    return _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+  }
+};
+
+// Rounding instructions quiet signaling NaNs, std::ceil and std::floor return
+// them as is.
+SHLO_REF_AVX2 inline __m256 KeepNans(__m256 result, __m256 v) {
+  return _mm256_blendv_ps(result, v, _mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+}
+
+struct CeilKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) {
+    return KeepNans(
+        _mm256_round_ps(v, _MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC), v);
+  }
+};
+
+struct FloorKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) {
+    return KeepNans(
+        _mm256_round_ps(v, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC), v);
+  }
+};
+
+struct SqrtKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) { return _mm256_sqrt_ps(v); }
+};
+
+struct DivideKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 lhs, __m256 rhs) {
+    return _mm256_div_ps(lhs, rhs);
+  }
+};
+
+struct MultiplyKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 lhs, __m256 rhs) {
+    return _mm256_mul_ps(lhs, rhs);
+  }
+};
+
+struct SubtractKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 lhs, __m256 rhs) {
+    return _mm256_sub_ps(lhs, rhs);
+  }
+};
+
+struct MaximumKernel {
+  static constexpr KernelKind kKind = KernelKind::kSelect;
+  // Mirrors `lhs > rhs ? lhs : rhs`.
+  SHLO_REF_AVX2 static __m256 Mask(__m256 lhs, __m256 rhs) {
+    return _mm256_cmp_ps(lhs, rhs, _CMP_GT_OQ);
+  }
+};
+
+struct MinimumKernel {
+  static constexpr KernelKind kKind = KernelKind::kSelect;
+  // Mirrors `lhs < rhs ? lhs : rhs`.
+  SHLO_REF_AVX2 static __m256 Mask(__m256 lhs, __m256 rhs) {
+    return _mm256_cmp_ps(lhs, rhs, _CMP_LT_OQ);
+  }
+};
+
+struct SignKernel {
+  static constexpr KernelKind kKind = KernelKind::kReplace;
+  // Mirrors `v < 0 ? -1 : (v > 0 ? 1 : v)`, which leaves zeros and NaNs
+  // untouched.
+  SHLO_REF_AVX2 static __m256 Mask(__m256 v) {
+    return _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+  }
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) {
+    return _mm256_or_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(v, SignMask()));
+  }
+};
+
+// The transcendental kernels below approximate the f32 functions of the
+// standard library, with the Cephes polynomials, to within a few ulp. They
+// return quiet NaNs for NaNs and handle infinities, zeros and denormals like
+// the standard library.
+
+SHLO_REF_AVX2 inline __m256 IsNan(__m256 v) {
+  return _mm256_cmp_ps(v, v, _CMP_UNORD_Q);
+}
+
+// Evaluates the polynomial with `coefficients`, highest degree first, at `x`.
+template <size_t kSize>
+SHLO_REF_AVX2 inline __m256 Polynomial(__m256 x,
+                                       const float (&coefficients)[kSize]) {
+  __m256 result = _mm256_set1_ps(coefficients[0]);
+  for (size_t i = 1; i < kSize; ++i) {
+    result = _mm256_add_ps(_mm256_mul_ps(result, x),
+                           _mm256_set1_ps(coefficients[i]));
+  }
+  return result;
+}
+
+// 2^n for integral n in [-126, 127].
+SHLO_REF_AVX2 inline __m256 Pow2(__m256 n) {
+  return _mm256_castsi256_ps(_mm256_slli_epi32(
+      _mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23));
+}
+
+// v * 2^n for integral n in [-150, 128], in two steps so that the result can
+// be denormal or overflow without the scale itself doing so.
+SHLO_REF_AVX2 inline __m256 Scale(__m256 v, __m256 n) {
+  const __m256 n1 = _mm256_floor_ps(_mm256_mul_ps(n, _mm256_set1_ps(0.5f)));
+  return _mm256_mul_ps(_mm256_mul_ps(v, Pow2(n1)),
+                       Pow2(_mm256_sub_ps(n, n1)));
+}
+
+// Splits `x`, clamped to the range where e^x is neither 0 nor infinite, into
+// n * ln(2) + r with |r| <= ln(2) / 2 and returns e^r - 1.
+SHLO_REF_AVX2 inline __m256 ExpM1Reduced(__m256 x, __m256& n) {
+  static constexpr float kCoefficients[] = {
+      1.9875691500e-4f, 1.3981999507e-3f, 8.3334519073e-3f,
+      4.1665795894e-2f, 1.6666665459e-1f, 5.0000001201e-1f};
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-104.0f)),
+                    _mm256_set1_ps(89.0f));
+  n = _mm256_round_ps(_mm256_mul_ps(x, _mm256_set1_ps(1.44269504088896341f)),
+                      _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  // ln(2) split in two so that n * the first part is exact.
+  __m256 r = _mm256_sub_ps(x, _mm256_mul_ps(n, _mm256_set1_ps(0.693359375f)));
+  r = _mm256_sub_ps(r, _mm256_mul_ps(n, _mm256_set1_ps(-2.12194440e-4f)));
+  return _mm256_add_ps(
+      r, _mm256_mul_ps(_mm256_mul_ps(r, r), Polynomial(r, kCoefficients)));
+}
+
+SHLO_REF_AVX2 inline __m256 Exp(__m256 x) {
+  __m256 n;
+  const __m256 em1 = ExpM1Reduced(x, n);
+  const __m256 result = Scale(_mm256_add_ps(em1, _mm256_set1_ps(1.0f)), n);
+  return _mm256_blendv_ps(result, _mm256_add_ps(x, x), IsNan(x));
+}
+
+SHLO_REF_AVX2 inline __m256 ExpM1(__m256 x) {
+  __m256 n;
+  const __m256 em1 = ExpM1Reduced(x, n);
+  // 2^n * (e^r - 1) + (2^n - 1) rounds once, and is exact for n = 0. Out of
+  // [-24, 24], 2^n - 1 is not exact but the other term dominates anyway.
+  const __m256 in_range = _mm256_cmp_ps(
+      _mm256_andnot_ps(SignMask(), n), _mm256_set1_ps(24.0f), _CMP_LE_OQ);
+  const __m256 pow2 = Pow2(_mm256_and_ps(n, in_range));
+  const __m256 small = _mm256_add_ps(
+      _mm256_mul_ps(pow2, em1), _mm256_sub_ps(pow2, _mm256_set1_ps(1.0f)));
+  const __m256 large = _mm256_sub_ps(
+      Scale(_mm256_add_ps(em1, _mm256_set1_ps(1.0f)), n),
+      _mm256_set1_ps(1.0f));
+  __m256 result = _mm256_blendv_ps(large, small, in_range);
+  // Keeps the sign of zeros.
+  result = _mm256_blendv_ps(
+      result, x, _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+  return _mm256_blendv_ps(result, _mm256_add_ps(x, x), IsNan(x));
+}
+
+// Natural logarithm of positive, finite and normal values.
+SHLO_REF_AVX2 inline __m256 LogNormal(__m256 x, __m256 exponent_offset) {
+  static constexpr float kCoefficients[] = {
+      7.0376836292e-2f,  -1.1514610310e-1f, 1.1676998740e-1f,
+      -1.2420140846e-1f, 1.4249322787e-1f,  -1.6668057665e-1f,
+      2.0000714765e-1f,  -2.4999993993e-1f, 3.3333331174e-1f};
+  // x = m * 2^e with m in [0.5, 1).
+  const __m256i bits = _mm256_castps_si256(x);
+  __m256 e = _mm256_add_ps(
+      _mm256_cvtepi32_ps(_mm256_sub_epi32(_mm256_srli_epi32(bits, 23),
+                                          _mm256_set1_epi32(126))),
+      exponent_offset);
+  __m256 m = _mm256_castsi256_ps(
+      _mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007fffff)),
+                      _mm256_set1_epi32(0x3f000000)));
+  // Moves m to [sqrt(0.5), sqrt(2)) and takes m - 1.
+  const __m256 below =
+      _mm256_cmp_ps(m, _mm256_set1_ps(0.707106781186547524f), _CMP_LT_OQ);
+  e = _mm256_sub_ps(e, _mm256_and_ps(below, _mm256_set1_ps(1.0f)));
+  m = _mm256_sub_ps(_mm256_add_ps(m, _mm256_and_ps(below, m)),
+                    _mm256_set1_ps(1.0f));
+  const __m256 z = _mm256_mul_ps(m, m);
+  __m256 y = _mm256_mul_ps(_mm256_mul_ps(m, z), Polynomial(m, kCoefficients));
+  y = _mm256_add_ps(y, _mm256_mul_ps(e, _mm256_set1_ps(-2.12194440e-4f)));
+  y = _mm256_sub_ps(y, _mm256_mul_ps(z, _mm256_set1_ps(0.5f)));
+  return _mm256_add_ps(_mm256_add_ps(m, y),
+                       _mm256_mul_ps(e, _mm256_set1_ps(0.693359375f)));
+}
+
+SHLO_REF_AVX2 inline __m256 Log(__m256 x) {
+  // Denormals are scaled by 2^23 to make them normal.
+  const __m256 denormal =
+      _mm256_cmp_ps(x, _mm256_set1_ps(1.17549435e-38f), _CMP_LT_OQ);
+  const __m256 scaled =
+      _mm256_blendv_ps(x, _mm256_mul_ps(x, _mm256_set1_ps(8388608.0f)),
+                       denormal);
+  __m256 result = LogNormal(
+      scaled, _mm256_and_ps(denormal, _mm256_set1_ps(-23.0f)));
+  const __m256 inf = _mm256_set1_ps(std::numeric_limits<float>::infinity());
+  result = _mm256_blendv_ps(result, inf, _mm256_cmp_ps(x, inf, _CMP_EQ_OQ));
+  result = _mm256_blendv_ps(
+      result, _mm256_set1_ps(-std::numeric_limits<float>::infinity()),
+      _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ));
+  result = _mm256_blendv_ps(
+      result, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()),
+      _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ));
+  return _mm256_blendv_ps(result, _mm256_add_ps(x, x), IsNan(x));
+}
+
+SHLO_REF_AVX2 inline __m256 Log1P(__m256 x) {
+  // log(u) - ((u - 1) - x) / u, with u = 1 + x, corrects the rounding of u.
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 u = _mm256_add_ps(one, x);
+  __m256 result = _mm256_sub_ps(
+      Log(u), _mm256_div_ps(_mm256_sub_ps(_mm256_sub_ps(u, one), x), u));
+  // The correction is 0 / 0 or inf / inf for -1 and infinity, and loses the
+  // sign of zeros.
+  result = _mm256_blendv_ps(
+      result, _mm256_set1_ps(-std::numeric_limits<float>::infinity()),
+      _mm256_cmp_ps(u, _mm256_setzero_ps(), _CMP_EQ_OQ));
+  result = _mm256_blendv_ps(
+      result, x,
+      _mm256_or_ps(
+          _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_EQ_OQ),
+          _mm256_cmp_ps(
+              x, _mm256_set1_ps(std::numeric_limits<float>::infinity()),
+              _CMP_EQ_OQ)));
+  return _mm256_blendv_ps(result, _mm256_add_ps(x, x), IsNan(x));
+}
+
+struct ExponentialKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) { return Exp(v); }
+};
+
+struct ExponentialMinusOneKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) { return ExpM1(v); }
+};
+
+struct LogKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) { return Log(v); }
+};
+
+struct LogPlusOneKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) { return Log1P(v); }
+};
+
+struct LogisticKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  // Same formula as the scalar op: 1 / (1 + e^-v).
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    return _mm256_div_ps(
+        one, _mm256_add_ps(one, Exp(_mm256_xor_ps(v, SignMask()))));
+  }
+};
+
+struct TanhKernel {
+  static constexpr KernelKind kKind = KernelKind::kArithmetic;
+  SHLO_REF_AVX2 static __m256 Apply(__m256 v) {
+    static constexpr float kCoefficients[] = {
+        -5.70498872745e-3f, 2.06390887954e-2f, -5.37397155531e-2f,
+        1.33314422036e-1f, -3.33332819422e-1f};
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 abs = _mm256_andnot_ps(SignMask(), v);
+    // v + v^3 * P(v^2) close to 0, 1 - 2 / (e^2|v| + 1) with the sign of v
+    // elsewhere.
+    const __m256 z = _mm256_mul_ps(v, v);
+    const __m256 small = _mm256_add_ps(
+        v, _mm256_mul_ps(_mm256_mul_ps(v, z), Polynomial(z, kCoefficients)));
+    __m256 large = _mm256_sub_ps(
+        one, _mm256_div_ps(_mm256_set1_ps(2.0f),
+                           _mm256_add_ps(Exp(_mm256_add_ps(abs, abs)), one)));
+    large = _mm256_or_ps(large, _mm256_and_ps(v, SignMask()));
+    const __m256 result = _mm256_blendv_ps(
+        large, small, _mm256_cmp_ps(abs, _mm256_set1_ps(0.625f), _CMP_LT_OQ));
+    return _mm256_blendv_ps(result, _mm256_add_ps(v, v), IsNan(v));
+  }
+};
+
+template <class Kernel>
+SHLO_REF_AVX2 inline __m256 ApplyF32(__m256 v) {
+  if constexpr (Kernel::kKind == KernelKind::kSignFlip) {
+    return _mm256_blendv_ps(v, _mm256_xor_ps(v, SignMask()), Kernel::Mask(v));
+  } else if constexpr (Kernel::kKind == KernelKind::kReplace) {
+    return _mm256_blendv_ps(v, Kernel::Apply(v), Kernel::Mask(v));
+  } else {
+    return Kernel::Apply(v);
+  }
+}
+
+template <class Kernel>
+SHLO_REF_AVX2 inline __m256 ApplyF32(__m256 lhs, __m256 rhs) {
+  if constexpr (Kernel::kKind == KernelKind::kSelect) {
+    return _mm256_blendv_ps(rhs, lhs, Kernel::Mask(lhs, rhs));
+  } else {
+    return Kernel::Apply(lhs, rhs);
+  }
+}
+
+// Narrows an f32 lane mask to 16-bit lanes.
+SHLO_REF_AVX2 inline __m128i PackMask(__m256 mask) {
+  const __m256i m = _mm256_castps_si256(mask);
+  return _mm_packs_epi32(_mm256_castsi256_si128(m),
+                         _mm256_extracti128_si256(m, 1));
+}
+
+// Conversions between 8 16-bit floats and f32 lanes.
+//
+// `Negate` mirrors the unary minus of the matching scalar type. F16 negates
+// in f32, which quiets signaling NaNs; BF16 only flips the sign bit.
+struct F16Format {
+  SHLO_REF_AVX2 static __m256 ToF32(__m128i bits) {
+    return _mm256_cvtph_ps(bits);
+  }
+  SHLO_REF_AVX2 static __m128i FromF32(__m256 v) {
+    return _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+  }
+  SHLO_REF_AVX2 static __m128i Negate(__m128i bits) {
+    return FromF32(_mm256_xor_ps(ToF32(bits), SignMask()));
+  }
+};
+
+struct BF16Format {
+  SHLO_REF_AVX2 static __m256 ToF32(__m128i bits) {
+    return _mm256_castsi256_ps(
+        _mm256_slli_epi32(_mm256_cvtepu16_epi32(bits), 16));
+  }
+  // Same rounding as the BF16 float constructor: round to nearest even, and
+  // quiet NaNs by setting the top mantissa bit that survives the truncation.
+  SHLO_REF_AVX2 static __m128i FromF32(__m256 v) {
+    const __m256i u = _mm256_castps_si256(v);
+    const __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(u, 16),
+                                         _mm256_set1_epi32(1));
+    const __m256i rounded = _mm256_srli_epi32(
+        _mm256_add_epi32(_mm256_add_epi32(u, _mm256_set1_epi32(0x7fff)), lsb),
+        16);
+    const __m256i quiet_nan = _mm256_srli_epi32(
+        _mm256_or_si256(u, _mm256_set1_epi32(0x00200000)), 16);
+    const __m256i is_nan =
+        _mm256_castps_si256(_mm256_cmp_ps(v, v, _CMP_UNORD_Q));
+    const __m256i r = _mm256_blendv_epi8(rounded, quiet_nan, is_nan);
+    return _mm_packus_epi32(_mm256_castsi256_si128(r),
+                            _mm256_extracti128_si256(r, 1));
+  }
+  SHLO_REF_AVX2 static __m128i Negate(__m128i bits) {
+    return _mm_xor_si128(bits, _mm_set1_epi16(static_cast<int16_t>(0x8000)));
+  }
+};
+
+// Per tensor quantization parameters of an si8 tensor with f32 expressed type.
+struct QuantParams {
+  explicit QuantParams(const Tensor& tensor)
+      : zero_point(tensor.quantized_per_tensor_element_type()
+                       .ZeroPointAs<DataType::kSI8>()),
+        scale(tensor.quantized_per_tensor_element_type()
+                  .ScaleAs<DataType::kF32>()),
+        inv_scale(1.0f / scale) {}
+
+  int32_t zero_point;
+  float scale;
+  float inv_scale;
+};
+
+SHLO_REF_AVX2 inline __m256 Dequantize(const int8_t* data,
+                                       const QuantParams& params) {
+  const __m256i q = _mm256_cvtepi8_epi32(
+      _mm_loadl_epi64(reinterpret_cast<const __m128i*>(data)));
+  return _mm256_mul_ps(
+      _mm256_cvtepi32_ps(
+          _mm256_sub_epi32(q, _mm256_set1_epi32(params.zero_point))),
+      _mm256_set1_ps(params.scale));
+}
+
+// Same computation as `Quantize`, including the wrap around when adding the
+// zero point overflows the storage type.
+SHLO_REF_AVX2 inline void Quantize(__m256 v, const QuantParams& params,
+                                   int8_t* data) {
+  const __m256 rounding_extra =
+      _mm256_blendv_ps(_mm256_set1_ps(-0.5f), _mm256_set1_ps(0.5f),
+                       _mm256_cmp_ps(v, _mm256_setzero_ps(), _CMP_GT_OQ));
+  __m256 tmp = _mm256_add_ps(
+      _mm256_mul_ps(v, _mm256_set1_ps(params.inv_scale)), rounding_extra);
+  tmp = _mm256_min_ps(_mm256_max_ps(tmp, _mm256_set1_ps(-128.0f)),
+                      _mm256_set1_ps(127.0f));
+  __m256i q = _mm256_add_epi32(_mm256_cvttps_epi32(tmp),
+                               _mm256_set1_epi32(params.zero_point));
+  q = _mm256_and_si256(q, _mm256_set1_epi32(0xff));
+  const __m128i q16 = _mm_packus_epi32(_mm256_castsi256_si128(q),
+                                       _mm256_extracti128_si256(q, 1));
+  _mm_storel_epi64(reinterpret_cast<__m128i*>(data),
+                   _mm_packus_epi16(q16, q16));
+}
+
+SHLO_REF_AVX2 inline __m128i Load16(const uint16_t* data) {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+}
+
+SHLO_REF_AVX2 inline void Store16(uint16_t* data, __m128i v) {
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(data), v);
+}
+
+template <class Kernel, class Format>
+SHLO_REF_AVX2 inline __m128i Apply16(__m128i bits) {
+  if constexpr (Kernel::kKind == KernelKind::kSignFlip) {
+    const __m128i mask = PackMask(Kernel::Mask(Format::ToF32(bits)));
+    return _mm_blendv_epi8(bits, Format::Negate(bits), mask);
+  } else if constexpr (Kernel::kKind == KernelKind::kReplace) {
+    const __m256 v = Format::ToF32(bits);
+    return _mm_blendv_epi8(bits, Format::FromF32(Kernel::Apply(v)),
+                           PackMask(Kernel::Mask(v)));
+  } else {
+    return Format::FromF32(Kernel::Apply(Format::ToF32(bits)));
+  }
+}
+
+template <class Kernel, class Format>
+SHLO_REF_AVX2 inline __m128i Apply16(__m128i lhs, __m128i rhs) {
+  if constexpr (Kernel::kKind == KernelKind::kSelect) {
+    const __m128i mask =
+        PackMask(Kernel::Mask(Format::ToF32(lhs), Format::ToF32(rhs)));
+    return _mm_blendv_epi8(rhs, lhs, mask);
+  } else {
+    return Format::FromF32(
+        Kernel::Apply(Format::ToF32(lhs), Format::ToF32(rhs)));
+  }
+}
+
+// Steps compute one vector of kLanes consecutive elements, 8 f32 lanes for
+// the floating point kernels.
+constexpr DimensionSize kF32Lanes = 8;
+
+template <class Kernel>
+struct F32Step {
+  static constexpr DimensionSize kLanes = kF32Lanes;
+
+  SHLO_REF_AVX2 void operator()(const float* input, float* output) const {
+    _mm256_storeu_ps(output, ApplyF32<Kernel>(_mm256_loadu_ps(input)));
+  }
+  SHLO_REF_AVX2 void operator()(const float* lhs, const float* rhs,
+                                float* output) const {
+    _mm256_storeu_ps(output, ApplyF32<Kernel>(_mm256_loadu_ps(lhs),
+                                              _mm256_loadu_ps(rhs)));
+  }
+};
+
+template <class Kernel, class Format>
+struct Float16Step {
+  static constexpr DimensionSize kLanes = kF32Lanes;
+  SHLO_REF_AVX2 void operator()(const uint16_t* input,
+                                uint16_t* output) const {
+    Store16(output, Apply16<Kernel, Format>(Load16(input)));
+  }
+  SHLO_REF_AVX2 void operator()(const uint16_t* lhs, const uint16_t* rhs,
+                                uint16_t* output) const {
+    Store16(output, Apply16<Kernel, Format>(Load16(lhs), Load16(rhs)));
+  }
+};
+
+template <class Kernel>
+struct QuantizedStep {
+  static constexpr DimensionSize kLanes = kF32Lanes;
+  SHLO_REF_AVX2 void operator()(const int8_t* input, int8_t* output) const {
+    Quantize(ApplyF32<Kernel>(Dequantize(input, lhs_params)), output_params,
+             output);
+  }
+  SHLO_REF_AVX2 void operator()(const int8_t* lhs, const int8_t* rhs,
+                                int8_t* output) const {
+    Quantize(ApplyF32<Kernel>(Dequantize(lhs, lhs_params),
+                              Dequantize(rhs, rhs_params)),
+             output_params, output);
+  }
+
+  // For unary kernels, the input parameters go in `lhs_params`.
+  QuantParams lhs_params;
+  QuantParams rhs_params;
+  QuantParams output_params;
+};
+
+// Bitwise kernels work on the bytes of integer and bool tensors, whatever
+// their element type.
+struct AndKernel {
+  SHLO_REF_AVX2 static __m256i Apply(__m256i lhs, __m256i rhs) {
+    return _mm256_and_si256(lhs, rhs);
+  }
+};
+
+struct OrKernel {
+  SHLO_REF_AVX2 static __m256i Apply(__m256i lhs, __m256i rhs) {
+    return _mm256_or_si256(lhs, rhs);
+  }
+};
+
+struct XorKernel {
+  SHLO_REF_AVX2 static __m256i Apply(__m256i lhs, __m256i rhs) {
+    return _mm256_xor_si256(lhs, rhs);
+  }
+};
+
+template <class Kernel>
+struct BitwiseStep {
+  static constexpr DimensionSize kLanes = 32;
+
+  // Not is a xor with `flip`: all ones for integers, 1 for bools.
+  SHLO_REF_AVX2 void operator()(const uint8_t* input, uint8_t* output) const {
+    const __m256i v =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output),
+                        _mm256_xor_si256(v, _mm256_set1_epi8(flip)));
+  }
+  SHLO_REF_AVX2 void operator()(const uint8_t* lhs, const uint8_t* rhs,
+                                uint8_t* output) const {
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(output),
+        Kernel::Apply(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lhs)),
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(rhs))));
+  }
+
+  char flip = 0;
+};
+
+// Runs `step` over the [begin, end) range. The tail is padded to a full vector
+// in a local buffer so that it goes through the same code as the rest.
+template <class T, class Step>
+SHLO_REF_AVX2 void UnaryLoop(const Step& step, const T* input, T* output,
+                             DimensionSize begin, DimensionSize end) {
+  DimensionSize i = begin;
+  for (; i + Step::kLanes <= end; i += Step::kLanes) {
+    step(input + i, output + i);
+  }
+  if (i < end) {
+    const size_t tail_bytes = (end - i) * sizeof(T);
+    T input_tail[Step::kLanes] = {};
+    T output_tail[Step::kLanes];
+    std::memcpy(input_tail, input + i, tail_bytes);
+    step(input_tail, output_tail);
+    std::memcpy(output + i, output_tail, tail_bytes);
+  }
+}
+
+template <class T, class Step>
+SHLO_REF_AVX2 void BinaryLoop(const Step& step, const T* lhs, const T* rhs,
+                              T* output, DimensionSize begin,
+                              DimensionSize end) {
+  DimensionSize i = begin;
+  for (; i + Step::kLanes <= end; i += Step::kLanes) {
+    step(lhs + i, rhs + i, output + i);
+  }
+  if (i < end) {
+    const size_t tail_bytes = (end - i) * sizeof(T);
+    T lhs_tail[Step::kLanes] = {};
+    T rhs_tail[Step::kLanes] = {};
+    T output_tail[Step::kLanes];
+    std::memcpy(lhs_tail, lhs + i, tail_bytes);
+    std::memcpy(rhs_tail, rhs + i, tail_bytes);
+    step(lhs_tail, rhs_tail, output_tail);
+    std::memcpy(output + i, output_tail, tail_bytes);
+  }
+}
+
+template <class T, class Step>
+void ParallelUnary(const Step& step, const T* input, T* output,
+                   DimensionSize size) {
+  ParallelFor(size, kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                UnaryLoop(step, input, output, begin, end);
+              });
+}
+
+template <class T, class Step>
+void ParallelBinary(const Step& step, const T* lhs, const T* rhs, T* output,
+                    DimensionSize size) {
+  ParallelFor(size, kMinElementsPerThread,
+              [&](DimensionSize begin, DimensionSize end) {
+                BinaryLoop(step, lhs, rhs, output, begin, end);
+              });
+}
+
+bool IsSupportedQuantizedTensor(const Tensor& tensor) {
+  return tensor.IsPerTensorQuantized() &&
+         tensor.quantized_per_tensor_element_type().StorageType() ==
+             DataType::kSI8 &&
+         tensor.quantized_per_tensor_element_type().ExpressedType() ==
+             DataType::kF32;
+}
+
+template <class Kernel>
+bool EvaluateUnaryAvx2(const Tensor& input, Tensor& output) {
+  const DimensionSize size = input.NumElements();
+  if (IsSupportedQuantizedTensor(input) &&
+      IsSupportedQuantizedTensor(output)) {
+    const QuantizedStep<Kernel> step{QuantParams(input), QuantParams(input),
+                                     QuantParams(output)};
+    ParallelUnary(step, input.GetDataAs<DataType::kSI8>(),
+                  output.GetDataAs<DataType::kSI8>(), size);
+    return true;
+  }
+  if (input.IsQuantized() || output.IsQuantized() ||
+      input.tensor_element_type() != output.tensor_element_type()) {
+    return false;
+  }
+  switch (input.tensor_element_type()) {
+    case DataType::kF32:
+      ParallelUnary(F32Step<Kernel>(), input.GetDataAs<DataType::kF32>(),
+                    output.GetDataAs<DataType::kF32>(), size);
+      return true;
+    case DataType::kF16:
+      ParallelUnary(Float16Step<Kernel, F16Format>(),
+                    input.GetDataAs<DataType::kF16, uint16_t>(),
+                    output.GetDataAs<DataType::kF16, uint16_t>(), size);
+      return true;
+    case DataType::kBF16:
+      ParallelUnary(Float16Step<Kernel, BF16Format>(),
+                    input.GetDataAs<DataType::kBF16, uint16_t>(),
+                    output.GetDataAs<DataType::kBF16, uint16_t>(), size);
+      return true;
+    default:
+      return false;
+  }
+}
+
+template <class Kernel>
+bool EvaluateBinaryAvx2(const Tensor& lhs, const Tensor& rhs,
+                        Tensor& output) {
+  const DimensionSize size = lhs.NumElements();
+  if (IsSupportedQuantizedTensor(lhs) && IsSupportedQuantizedTensor(rhs) &&
+      IsSupportedQuantizedTensor(output)) {
+    const QuantizedStep<Kernel> step{QuantParams(lhs), QuantParams(rhs),
+                                     QuantParams(output)};
+    ParallelBinary(step, lhs.GetDataAs<DataType::kSI8>(),
+                   rhs.GetDataAs<DataType::kSI8>(),
+                   output.GetDataAs<DataType::kSI8>(), size);
+    return true;
+  }
+  if (lhs.IsQuantized() || rhs.IsQuantized() || output.IsQuantized() ||
+      lhs.tensor_element_type() != rhs.tensor_element_type() ||
+      lhs.tensor_element_type() != output.tensor_element_type()) {
+    return false;
+  }
+  switch (lhs.tensor_element_type()) {
+    case DataType::kF32:
+      ParallelBinary(F32Step<Kernel>(), lhs.GetDataAs<DataType::kF32>(),
+                     rhs.GetDataAs<DataType::kF32>(),
+                     output.GetDataAs<DataType::kF32>(), size);
+      return true;
+    case DataType::kF16:
+      ParallelBinary(Float16Step<Kernel, F16Format>(),
+                     lhs.GetDataAs<DataType::kF16, uint16_t>(),
+                     rhs.GetDataAs<DataType::kF16, uint16_t>(),
+                     output.GetDataAs<DataType::kF16, uint16_t>(), size);
+      return true;
+    case DataType::kBF16:
+      ParallelBinary(Float16Step<Kernel, BF16Format>(),
+                     lhs.GetDataAs<DataType::kBF16, uint16_t>(),
+                     rhs.GetDataAs<DataType::kBF16, uint16_t>(),
+                     output.GetDataAs<DataType::kBF16, uint16_t>(), size);
+      return true;
+    default:
+      return false;
+  }
+}
+
+// The bools and the integer types supported by the scalar ops, except for si4
+// whose storage has bits outside of the value.
+bool IsBitwiseTensor(const Tensor& tensor) {
+  if (tensor.IsQuantized()) return false;
+  switch (tensor.tensor_element_type()) {
+    case DataType::kI1:
+    case DataType::kSI8:
+    case DataType::kSI16:
+    case DataType::kSI32:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool EvaluateNotAvx2(const Tensor& input, Tensor& output) {
+  if (!IsBitwiseTensor(input) ||
+      input.tensor_element_type() != output.tensor_element_type()) {
+    return false;
+  }
+  BitwiseStep<XorKernel> step;
+  step.flip = input.tensor_element_type() == DataType::kI1 ? 1 : -1;
+  ParallelUnary(step, static_cast<const uint8_t*>(input.data),
+                static_cast<uint8_t*>(output.data), input.SizeInBytes());
+  return true;
+}
+
+template <class Kernel>
+bool EvaluateBitwiseAvx2(const Tensor& lhs, const Tensor& rhs,
+                         Tensor& output) {
+  if (!IsBitwiseTensor(lhs) ||
+      lhs.tensor_element_type() != rhs.tensor_element_type() ||
+      lhs.tensor_element_type() != output.tensor_element_type()) {
+    return false;
+  }
+  ParallelBinary(BitwiseStep<Kernel>(), static_cast<const uint8_t*>(lhs.data),
+                 static_cast<const uint8_t*>(rhs.data),
+                 static_cast<uint8_t*>(output.data), lhs.SizeInBytes());
+  return true;
+}
+
+}  // namespace
+
+#undef SHLO_REF_AVX2
+
+#endif  // SHLO_REF_HAS_AVX2_KERNELS
+
+bool EvaluateVectorized(UnaryKernel kernel, const Tensor& input,
+                        Tensor& output) {
+#ifdef SHLO_REF_HAS_AVX2_KERNELS
+  if (GetIsa() == Isa::kAvx2) {
+    switch (kernel) {
+      case UnaryKernel::kAbs:
+        return EvaluateUnaryAvx2<AbsKernel>(input, output);
+      case UnaryKernel::kCeil:
+        return EvaluateUnaryAvx2<CeilKernel>(input, output);
+      case UnaryKernel::kExponential:
+        return EvaluateUnaryAvx2<ExponentialKernel>(input, output);
+      case UnaryKernel::kExponentialMinusOne:
+        return EvaluateUnaryAvx2<ExponentialMinusOneKernel>(input, output);
+      case UnaryKernel::kFloor:
+        return EvaluateUnaryAvx2<FloorKernel>(input, output);
+      case UnaryKernel::kLog:
+        return EvaluateUnaryAvx2<LogKernel>(input, output);
+      case UnaryKernel::kLogPlusOne:
+        return EvaluateUnaryAvx2<LogPlusOneKernel>(input, output);
+      case UnaryKernel::kLogistic:
+        return EvaluateUnaryAvx2<LogisticKernel>(input, output);
+      case UnaryKernel::kNegate:
+        return EvaluateUnaryAvx2<NegateKernel>(input, output);
+      case UnaryKernel::kNot:
+        return EvaluateNotAvx2(input, output);
+      case UnaryKernel::kSign:
+        return EvaluateUnaryAvx2<SignKernel>(input, output);
+      case UnaryKernel::kSqrt:
+        return EvaluateUnaryAvx2<SqrtKernel>(input, output);
+      case UnaryKernel::kTanh:
+        return EvaluateUnaryAvx2<TanhKernel>(input, output);
+    }
+  }
+#endif
+  return false;
+}
+
+bool EvaluateVectorized(BinaryKernel kernel, const Tensor& lhs,
+                        const Tensor& rhs, Tensor& output) {
+#ifdef SHLO_REF_HAS_AVX2_KERNELS
+  if (GetIsa() == Isa::kAvx2) {
+    switch (kernel) {
+      case BinaryKernel::kAnd:
+        return EvaluateBitwiseAvx2<AndKernel>(lhs, rhs, output);
+      case BinaryKernel::kDivide:
+        return EvaluateBinaryAvx2<DivideKernel>(lhs, rhs, output);
+      case BinaryKernel::kMaximum:
+        return EvaluateBinaryAvx2<MaximumKernel>(lhs, rhs, output);
+      case BinaryKernel::kMinimum:
+        return EvaluateBinaryAvx2<MinimumKernel>(lhs, rhs, output);
+      case BinaryKernel::kMultiply:
+        return EvaluateBinaryAvx2<MultiplyKernel>(lhs, rhs, output);
+      case BinaryKernel::kOr:
+        return EvaluateBitwiseAvx2<OrKernel>(lhs, rhs, output);
+      case BinaryKernel::kSubtract:
+        return EvaluateBinaryAvx2<SubtractKernel>(lhs, rhs, output);
+      case BinaryKernel::kXor:
+        return EvaluateBitwiseAvx2<XorKernel>(lhs, rhs, output);
+    }
+  }
+#endif
+  return false;
+}
+
+}  // namespace shlo_ref
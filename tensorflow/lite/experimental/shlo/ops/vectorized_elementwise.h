@@ -0,0 +1,87 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_VECTORIZED_ELEMENTWISE_H_
+#define TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_VECTORIZED_ELEMENTWISE_H_
+
+#include "tensorflow/lite/experimental/shlo/tensor.h"
+
+namespace shlo_ref {
+
+// Instruction sets the vectorized elementwise kernels can use, from least to
+// most capable.
+enum class Isa {
+  // No vectorized kernels, ops use their scalar implementation.
+  kScalar,
+  // x86 AVX2 with F16C.
+  kAvx2,
+};
+
+// Returns the instruction set used by the vectorized kernels: the most capable
+// one supported by the CPU, unless lowered with SetMaxIsa.
+Isa GetIsa();
+
+// Restricts the vectorized kernels to instruction sets up to `isa`. `kScalar`
+// disables them, e.g. to compare against the scalar implementation.
+void SetMaxIsa(Isa isa);
+
+enum class UnaryKernel {
+  kAbs,
+  kCeil,
+  kExponential,
+  kExponentialMinusOne,
+  kFloor,
+  kLog,
+  kLogPlusOne,
+  kLogistic,
+  kNegate,
+  kNot,
+  kSign,
+  kSqrt,
+  kTanh,
+};
+
+enum class BinaryKernel {
+  kAnd,
+  kDivide,
+  kMaximum,
+  kMinimum,
+  kMultiply,
+  kOr,
+  kSubtract,
+  kXor,
+};
+
+// If `kernel` has a vectorized implementation for the tensor types and the
+// CPU, evaluates it over all the elements and returns true. Otherwise returns
+// false without touching `output`, and the caller should use the scalar
+// implementation.
+//
+// Supported types are f32, bf16, f16, and si8 quantized per tensor with an f32
+// expressed type, except for the bitwise kernels (and, not, or, xor) which
+// support bool, si8, si16 and si32. Results are the same as the scalar
+// implementation, except for the transcendental kernels (exponential,
+// exponential minus one, log, log plus one, logistic and tanh) which are within
+// a few ulp of it in f32, and so may round to the neighbouring value for the
+// other types. Large tensors are split across threads, see
+// ParallelFor.
+bool EvaluateVectorized(UnaryKernel kernel, const Tensor& input,
+                        Tensor& output);
+bool EvaluateVectorized(BinaryKernel kernel, const Tensor& lhs,
+                        const Tensor& rhs, Tensor& output);
+
+}  // namespace shlo_ref
+
+#endif  // TENSORFLOW_LITE_EXPERIMENTAL_SHLO_OPS_VECTORIZED_ELEMENTWISE_H_
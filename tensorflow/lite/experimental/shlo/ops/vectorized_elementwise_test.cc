@@ -0,0 +1,481 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/experimental/shlo/ops/vectorized_elementwise.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include "absl/status/status.h"
+#include "tensorflow/lite/experimental/shlo/data_type.h"
+#include "tensorflow/lite/experimental/shlo/ops/abs.h"
+#include "tensorflow/lite/experimental/shlo/ops/and.h"
+#include "tensorflow/lite/experimental/shlo/ops/ceil.h"
+#include "tensorflow/lite/experimental/shlo/ops/divide.h"
+#include "tensorflow/lite/experimental/shlo/ops/exponential.h"
+#include "tensorflow/lite/experimental/shlo/ops/exponential_minus_one.h"
+#include "tensorflow/lite/experimental/shlo/ops/floor.h"
+#include "tensorflow/lite/experimental/shlo/ops/log.h"
+#include "tensorflow/lite/experimental/shlo/ops/log_plus_one.h"
+#include "tensorflow/lite/experimental/shlo/ops/logistic.h"
+#include "tensorflow/lite/experimental/shlo/ops/maximum.h"
+#include "tensorflow/lite/experimental/shlo/ops/minimum.h"
+#include "tensorflow/lite/experimental/shlo/ops/multiply.h"
+#include "tensorflow/lite/experimental/shlo/ops/negate.h"
+#include "tensorflow/lite/experimental/shlo/ops/not.h"
+#include "tensorflow/lite/experimental/shlo/ops/or.h"
+#include "tensorflow/lite/experimental/shlo/ops/parallel_for.h"
+#include "tensorflow/lite/experimental/shlo/ops/sign.h"
+#include "tensorflow/lite/experimental/shlo/ops/sqrt.h"
+#include "tensorflow/lite/experimental/shlo/ops/subtract.h"
+#include "tensorflow/lite/experimental/shlo/ops/tanh.h"
+#include "tensorflow/lite/experimental/shlo/ops/xor.h"
+#include "tensorflow/lite/experimental/shlo/quantized_tensor_element_type.h"
+#include "tensorflow/lite/experimental/shlo/shape.h"
+#include "tensorflow/lite/experimental/shlo/status_matcher.h"
+#include "tensorflow/lite/experimental/shlo/tensor.h"
+
+namespace shlo_ref {
+namespace {
+
+template <class Op>
+absl::Status EvaluateUnary(const Tensor& input, Tensor& output) {
+  Op op = Create(typename Op::Attributes{});
+  if (absl::Status status = Prepare(op, input, output); !status.ok()) {
+    return status;
+  }
+  return Evaluate(op, input, output);
+}
+
+template <class Op>
+absl::Status EvaluateBinary(const Tensor& lhs, const Tensor& rhs,
+                            Tensor& output) {
+  Op op = Create(typename Op::Attributes{});
+  if (absl::Status status = Prepare(op, lhs, rhs, output); !status.ok()) {
+    return status;
+  }
+  return Evaluate(op, lhs, rhs, output);
+}
+
+using UnaryFn = absl::Status (*)(const Tensor&, Tensor&);
+using BinaryFn = absl::Status (*)(const Tensor&, const Tensor&, Tensor&);
+
+struct UnaryOp {
+  std::string name;
+  UnaryFn evaluate;
+};
+
+struct BinaryOp {
+  std::string name;
+  BinaryFn evaluate;
+};
+
+const UnaryOp kUnaryOps[] = {
+    {"abs", EvaluateUnary<AbsOp>},     {"ceil", EvaluateUnary<CeilOp>},
+    {"floor", EvaluateUnary<FloorOp>}, {"negate", EvaluateUnary<NegateOp>},
+    {"sqrt", EvaluateUnary<SqrtOp>},
+};
+
+// Ops whose kernels approximate the scalar implementation.
+const UnaryOp kApproximatedUnaryOps[] = {
+    {"exponential", EvaluateUnary<ExponentialOp>},
+    {"exponential_minus_one", EvaluateUnary<ExponentialMinusOneOp>},
+    {"log", EvaluateUnary<LogOp>},
+    {"log_plus_one", EvaluateUnary<LogPlusOneOp>},
+    {"logistic", EvaluateUnary<LogisticOp>},
+    {"tanh", EvaluateUnary<TanhOp>},
+};
+
+const BinaryOp kBinaryOps[] = {
+    {"divide", EvaluateBinary<DivideOp>},
+    {"maximum", EvaluateBinary<MaximumOp>},
+    {"minimum", EvaluateBinary<MinimumOp>},
+    {"multiply", EvaluateBinary<MultiplyOp>},
+    {"subtract", EvaluateBinary<SubtractOp>},
+};
+
+const BinaryOp kBitwiseOps[] = {
+    {"and", EvaluateBinary<AndOp>},
+    {"or", EvaluateBinary<OrOp>},
+    {"xor", EvaluateBinary<XorOp>},
+};
+
+// Sizes around the vector width, and one large enough to be split across
+// threads.
+const DimensionSize kSizes[] = {
+    1, 7, 8, 9, 63, 1000, 4 * kMinElementsPerThread + 3};
+
+// Returns random bit patterns, which include infinities, NaNs with various
+// payloads, denormals and signed zeros.
+std::vector<std::byte> RandomBits(size_t num_bytes, std::mt19937& rng) {
+  std::vector<std::byte> bytes(num_bytes);
+  for (std::byte& b : bytes) {
+    b = static_cast<std::byte>(rng());
+  }
+  return bytes;
+}
+
+bool IsNan(DataType type, const std::byte* data) {
+  switch (type) {
+    case DataType::kF32: {
+      uint32_t bits;
+      std::memcpy(&bits, data, sizeof(bits));
+      return (bits & 0x7fffffff) > 0x7f800000;
+    }
+    case DataType::kF16: {
+      uint16_t bits;
+      std::memcpy(&bits, data, sizeof(bits));
+      return (bits & 0x7fff) > 0x7c00;
+    }
+    case DataType::kBF16: {
+      uint16_t bits;
+      std::memcpy(&bits, data, sizeof(bits));
+      return (bits & 0x7fff) > 0x7f80;
+    }
+    default:
+      return false;
+  }
+}
+
+// Maps the element at `data` to an integer, such that consecutive values map to
+// consecutive integers.
+int64_t Ordinal(DataType type, const std::byte* data) {
+  switch (type) {
+    case DataType::kF32: {
+      int32_t bits;
+      std::memcpy(&bits, data, sizeof(bits));
+      return bits < 0 ? int64_t{INT32_MIN} - bits : bits;
+    }
+    case DataType::kF16:
+    case DataType::kBF16: {
+      int16_t bits;
+      std::memcpy(&bits, data, sizeof(bits));
+      return bits < 0 ? int64_t{INT16_MIN} - bits : bits;
+    }
+    default:
+      return static_cast<int8_t>(*data);
+  }
+}
+
+// IEEE 754 does not specify which payload propagates when both operands are
+// NaN, and compilers may swap the operands of commutative operations.
+void AvoidNanPairs(DataType type, const std::vector<std::byte>& lhs,
+                   std::vector<std::byte>& rhs) {
+  const size_t element_size = SizeOf(type);
+  for (size_t i = 0; i < rhs.size(); i += element_size) {
+    if (IsNan(type, &lhs[i]) && IsNan(type, &rhs[i])) {
+      std::memset(&rhs[i], 0, element_size);
+    }
+  }
+}
+
+Tensor MakeTensor(DataType element_type, DimensionSize size,
+                  std::vector<std::byte>& data) {
+  return Tensor{.type = TensorType{.shape = Shape({size}),
+                                   .element_type = element_type},
+                .data = data.data()};
+}
+
+Tensor MakeQuantizedTensor(int8_t zero_point, float scale, DimensionSize size,
+                           std::vector<std::byte>& data) {
+  return Tensor{.type = QuantizedPerTensorTensorType{
+                    .shape = Shape({size}),
+                    .element_type = QuantizedElementTypePerTensor(
+                        DataType::kSI8, zero_point, DataType::kF32, scale)},
+                .data = data.data()};
+}
+
+class VectorizedElementwiseTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    if (GetIsa() == Isa::kScalar) {
+      GTEST_SKIP() << "No vectorized kernels for this CPU.";
+    }
+    SetMaxNumThreads(4);
+  }
+
+  void TearDown() override {
+    SetMaxIsa(Isa::kAvx2);
+    SetMaxNumThreads(default_max_num_threads_);
+  }
+
+  // Evaluates `fn` with and without the vectorized kernels, checking that the
+  // results have the same bits.
+  template <class Fn>
+  void ExpectSameAsScalar(Fn fn, std::vector<std::byte>& output,
+                          const std::string& what) {
+    const Isa isa = GetIsa();
+    ASSERT_OK(fn());
+    const std::vector<std::byte> vectorized = output;
+    SetMaxIsa(Isa::kScalar);
+    ASSERT_OK(fn());
+    SetMaxIsa(isa);
+    for (size_t i = 0; i < output.size(); ++i) {
+      if (vectorized[i] != output[i]) {
+        ADD_FAILURE() << what << ": byte " << i << " differs.";
+        return;
+      }
+    }
+  }
+
+  // Evaluates `fn` with and without the vectorized kernels, checking that the
+  // results are NaNs in the same places and otherwise at most `max_distance`
+  // representable values apart, or quantized values for si8.
+  template <class Fn>
+  void ExpectCloseToScalar(Fn fn, DataType type, std::vector<std::byte>& output,
+                           int64_t max_distance, const std::string& what) {
+    const Isa isa = GetIsa();
+    ASSERT_OK(fn());
+    const std::vector<std::byte> vectorized = output;
+    SetMaxIsa(Isa::kScalar);
+    ASSERT_OK(fn());
+    SetMaxIsa(isa);
+    const size_t element_size = SizeOf(type);
+    for (size_t i = 0; i < output.size(); i += element_size) {
+      const bool nan = IsNan(type, &output[i]);
+      if (nan != IsNan(type, &vectorized[i])) {
+        ADD_FAILURE() << what << ": element " << i / element_size
+                      << " is a NaN in one result only.";
+        return;
+      }
+      const int64_t distance =
+          nan ? 0
+              : std::abs(Ordinal(type, &output[i]) -
+                         Ordinal(type, &vectorized[i]));
+      if (distance > max_distance) {
+        ADD_FAILURE() << what << ": element " << i / element_size
+                      << " differs by " << distance << ".";
+        return;
+      }
+    }
+  }
+
+  std::mt19937 rng_{1234};
+
+ private:
+  const int default_max_num_threads_ = GetMaxNumThreads();
+};
+
+TEST_F(VectorizedElementwiseTest, UnaryFloatOpsMatchScalar) {
+  for (const DataType type :
+       {DataType::kF32, DataType::kF16, DataType::kBF16}) {
+    for (const DimensionSize size : kSizes) {
+      const size_t num_bytes = size * SizeOf(type);
+      std::vector<std::byte> input_data = RandomBits(num_bytes, rng_);
+      std::vector<std::byte> output_data(num_bytes);
+      const Tensor input = MakeTensor(type, size, input_data);
+      Tensor output = MakeTensor(type, size, output_data);
+      for (const UnaryOp& op : kUnaryOps) {
+        ExpectSameAsScalar([&] { return op.evaluate(input, output); },
+                           output_data,
+                           op.name + " " + ToString(type) + " size " +
+                               std::to_string(size));
+      }
+    }
+  }
+}
+
+TEST_F(VectorizedElementwiseTest, BinaryFloatOpsMatchScalar) {
+  for (const DataType type :
+       {DataType::kF32, DataType::kF16, DataType::kBF16}) {
+    for (const DimensionSize size : kSizes) {
+      const size_t num_bytes = size * SizeOf(type);
+      std::vector<std::byte> lhs_data = RandomBits(num_bytes, rng_);
+      std::vector<std::byte> rhs_data = RandomBits(num_bytes, rng_);
+      AvoidNanPairs(type, lhs_data, rhs_data);
+      std::vector<std::byte> output_data(num_bytes);
+      const Tensor lhs = MakeTensor(type, size, lhs_data);
+      const Tensor rhs = MakeTensor(type, size, rhs_data);
+      Tensor output = MakeTensor(type, size, output_data);
+      for (const BinaryOp& op : kBinaryOps) {
+        ExpectSameAsScalar([&] { return op.evaluate(lhs, rhs, output); },
+                           output_data,
+                           op.name + " " + ToString(type) + " size " +
+                               std::to_string(size));
+      }
+    }
+  }
+}
+
+// The dequantized values are kept non-negative for sqrt and non-zero for the
+// divisor: quantizing a NaN is undefined in the scalar implementation.
+TEST_F(VectorizedElementwiseTest, UnaryQuantizedOpsMatchScalar) {
+  for (const DimensionSize size : kSizes) {
+    std::vector<std::byte> input_data = RandomBits(size, rng_);
+    for (std::byte& b : input_data) {
+      b &= std::byte{0x7f};
+    }
+    std::vector<std::byte> output_data(size);
+    const Tensor input = MakeQuantizedTensor(-3, 0.75f, size, input_data);
+    Tensor output = MakeQuantizedTensor(5, 1.25f, size, output_data);
+    for (const UnaryOp& op : kUnaryOps) {
+      ExpectSameAsScalar([&] { return op.evaluate(input, output); },
+                         output_data,
+                         op.name + " quantized size " + std::to_string(size));
+    }
+  }
+}
+
+TEST_F(VectorizedElementwiseTest, BinaryQuantizedOpsMatchScalar) {
+  constexpr int8_t kRhsZeroPoint = 2;
+  for (const DimensionSize size : kSizes) {
+    std::vector<std::byte> lhs_data = RandomBits(size, rng_);
+    std::vector<std::byte> rhs_data = RandomBits(size, rng_);
+    for (std::byte& b : rhs_data) {
+      if (static_cast<int8_t>(b) == kRhsZeroPoint) {
+        b = std::byte{0};
+      }
+    }
+    std::vector<std::byte> output_data(size);
+    const Tensor lhs = MakeQuantizedTensor(-3, 0.75f, size, lhs_data);
+    const Tensor rhs =
+        MakeQuantizedTensor(kRhsZeroPoint, 0.5f, size, rhs_data);
+    Tensor output = MakeQuantizedTensor(5, 1.25f, size, output_data);
+    for (const BinaryOp& op : kBinaryOps) {
+      ExpectSameAsScalar([&] { return op.evaluate(lhs, rhs, output); },
+                         output_data,
+                         op.name + " quantized size " + std::to_string(size));
+    }
+  }
+}
+
+// Within 4 ulp in f32, which can round to the neighbouring value for the
+// other types.
+TEST_F(VectorizedElementwiseTest, ApproximatedFloatOpsAreCloseToScalar) {
+  for (const DataType type :
+       {DataType::kF32, DataType::kF16, DataType::kBF16}) {
+    for (const DimensionSize size : kSizes) {
+      const size_t num_bytes = size * SizeOf(type);
+      std::vector<std::byte> input_data = RandomBits(num_bytes, rng_);
+      std::vector<std::byte> output_data(num_bytes);
+      const Tensor input = MakeTensor(type, size, input_data);
+      Tensor output = MakeTensor(type, size, output_data);
+      for (const UnaryOp& op : kApproximatedUnaryOps) {
+        ExpectCloseToScalar([&] { return op.evaluate(input, output); }, type,
+                            output_data, type == DataType::kF32 ? 4 : 1,
+                            op.name + " " + ToString(type) + " size " +
+                                std::to_string(size));
+      }
+    }
+  }
+}
+
+// The dequantized values are kept positive and small, so that the results are
+// neither NaNs nor infinities.
+TEST_F(VectorizedElementwiseTest, ApproximatedQuantizedOpsAreCloseToScalar) {
+  for (const DimensionSize size : kSizes) {
+    std::vector<std::byte> input_data = RandomBits(size, rng_);
+    for (std::byte& b : input_data) {
+      b &= std::byte{0x7f};
+    }
+    std::vector<std::byte> output_data(size);
+    const Tensor input = MakeQuantizedTensor(-3, 0.05f, size, input_data);
+    Tensor output = MakeQuantizedTensor(5, 0.25f, size, output_data);
+    for (const UnaryOp& op : kApproximatedUnaryOps) {
+      ExpectCloseToScalar([&] { return op.evaluate(input, output); },
+                          DataType::kSI8, output_data, 1,
+                          op.name + " quantized size " + std::to_string(size));
+    }
+  }
+}
+
+// The scalar op converts f16 and bf16 through f32, which quiets signaling NaNs.
+TEST_F(VectorizedElementwiseTest, SignMatchesScalar) {
+  for (const DataType type :
+       {DataType::kF32, DataType::kF16, DataType::kBF16}) {
+    for (const DimensionSize size : kSizes) {
+      const size_t num_bytes = size * SizeOf(type);
+      std::vector<std::byte> input_data = RandomBits(num_bytes, rng_);
+      std::vector<std::byte> output_data(num_bytes);
+      const Tensor input = MakeTensor(type, size, input_data);
+      Tensor output = MakeTensor(type, size, output_data);
+      ExpectCloseToScalar(
+          [&] { return EvaluateUnary<SignOp>(input, output); }, type,
+          output_data, 0,
+          std::string("sign ") + ToString(type) + " size " +
+              std::to_string(size));
+    }
+  }
+  for (const DimensionSize size : kSizes) {
+    std::vector<std::byte> input_data = RandomBits(size, rng_);
+    std::vector<std::byte> output_data(size);
+    const Tensor input = MakeQuantizedTensor(-3, 0.5f, size, input_data);
+    Tensor output = MakeQuantizedTensor(5, 0.25f, size, output_data);
+    ExpectSameAsScalar([&] { return EvaluateUnary<SignOp>(input, output); },
+                       output_data,
+                       "sign quantized size " + std::to_string(size));
+  }
+}
+
+TEST_F(VectorizedElementwiseTest, BitwiseOpsMatchScalar) {
+  for (const DataType type :
+       {DataType::kI1, DataType::kSI8, DataType::kSI16, DataType::kSI32}) {
+    for (const DimensionSize size : kSizes) {
+      const size_t num_bytes = size * SizeOf(type);
+      std::vector<std::byte> lhs_data = RandomBits(num_bytes, rng_);
+      std::vector<std::byte> rhs_data = RandomBits(num_bytes, rng_);
+      if (type == DataType::kI1) {
+        // Bools other than 0 and 1 are undefined.
+        for (size_t i = 0; i < num_bytes; ++i) {
+          lhs_data[i] &= std::byte{1};
+          rhs_data[i] &= std::byte{1};
+        }
+      }
+      std::vector<std::byte> output_data(num_bytes);
+      const Tensor lhs = MakeTensor(type, size, lhs_data);
+      const Tensor rhs = MakeTensor(type, size, rhs_data);
+      Tensor output = MakeTensor(type, size, output_data);
+      const std::string what =
+          std::string(ToString(type)) + " size " + std::to_string(size);
+      ExpectSameAsScalar([&] { return EvaluateUnary<NotOp>(lhs, output); },
+                         output_data, "not " + what);
+      for (const BinaryOp& op : kBitwiseOps) {
+        ExpectSameAsScalar([&] { return op.evaluate(lhs, rhs, output); },
+                           output_data, op.name + " " + what);
+      }
+    }
+  }
+}
+
+TEST_F(VectorizedElementwiseTest, UnsupportedTypesAreNotHandled) {
+  std::vector<std::byte> input_data(8 * sizeof(int32_t));
+  std::vector<std::byte> output_data(8 * sizeof(int32_t));
+  const Tensor input = MakeTensor(DataType::kSI32, 8, input_data);
+  Tensor output = MakeTensor(DataType::kSI32, 8, output_data);
+  EXPECT_FALSE(EvaluateVectorized(UnaryKernel::kAbs, input, output));
+  EXPECT_FALSE(
+      EvaluateVectorized(BinaryKernel::kMultiply, input, input, output));
+}
+
+TEST_F(VectorizedElementwiseTest, ScalarIsaDisablesKernels) {
+  std::vector<std::byte> input_data(8 * sizeof(float));
+  std::vector<std::byte> output_data(8 * sizeof(float));
+  const Tensor input = MakeTensor(DataType::kF32, 8, input_data);
+  Tensor output = MakeTensor(DataType::kF32, 8, output_data);
+  EXPECT_TRUE(EvaluateVectorized(UnaryKernel::kAbs, input, output));
+  SetMaxIsa(Isa::kScalar);
+  EXPECT_EQ(GetIsa(), Isa::kScalar);
+  EXPECT_FALSE(EvaluateVectorized(UnaryKernel::kAbs, input, output));
+}
+
+}  // namespace
+}  // namespace shlo_ref
@@ -19,6 +19,8 @@ limitations under the License.
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <string>
+#include <utility>
 #include <vector>
 
 #include "tensorflow/lite/core/c/builtin_op_data.h"
@@ -36,6 +38,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/types.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/packed_weight_registry.h"
 #include "tensorflow/lite/minimal_logging.h"
 
 #ifdef TFLITE_HAVE_CPUINFO
@@ -947,6 +950,64 @@ struct SparseHybridFullyConnectedTask : cpu_backend_threadpool::Task {
   TfLiteTensor* output;
 };
 
+// Computes the 4-bit integer accumulators for output channels
+// [row_start, row_end), which must be multiples of optimized_4bit::FilterWidth.
+struct FullyConnected4BitTask : cpu_backend_threadpool::Task {
+  // Each task handles at least this many 4-channel filter blocks so that the
+  // threadpool overhead stays small relative to the work.
+  static constexpr int kMinBlocksPerTask = 16;
+
+  FullyConnected4BitTask(int rhs_width, const uint8_t* lhs, const int8_t* rhs,
+                         int32_t* dst, int row_start, int row_end,
+                         int lhs_layout_cols, int rhs_layout_rows,
+                         int rhs_layout_cols, int dst_layout_rows)
+      : rhs_width(rhs_width),
+        lhs(lhs),
+        rhs(rhs),
+        dst(dst),
+        row_start(row_start),
+        row_end(row_end),
+        lhs_layout_cols(lhs_layout_cols),
+        rhs_layout_rows(rhs_layout_rows),
+        rhs_layout_cols(rhs_layout_cols),
+        dst_layout_rows(dst_layout_rows) {}
+
+  void Run() override {
+    const int rows = row_end - row_start;
+    optimized_4bit::api::RunKernel(
+        rhs_width, lhs + row_start * lhs_layout_cols / 2, rhs,
+        dst + row_start * dst_layout_rows, rows, lhs_layout_cols,
+        rhs_layout_rows, rhs_layout_cols, dst_layout_rows, rows);
+  }
+
+ private:
+  const int rhs_width;
+  const uint8_t* lhs;
+  const int8_t* rhs;
+  int32_t* dst;
+  const int row_start;
+  const int row_end;
+  const int lhs_layout_cols;
+  const int rhs_layout_rows;
+  const int rhs_layout_cols;
+  const int dst_layout_rows;
+};
+
+// A 4bit filter in the prepacked layout. Interpreters built from the same model
+// share one instance through the PackedWeightRegistry.
+class PackedFilter4Bit : public PackedWeights {
+ public:
+  explicit PackedFilter4Bit(size_t required_size) {
+    region_.AllocatePackedRegion(required_size);
+  }
+
+  uint8_t* data() const { return region_.prepacked_cache; }
+  size_t bytes() const override { return region_.prepacked_cache_buffer_size; }
+
+ private:
+  optimized_4bit::OpData4Bit region_;
+};
+
 TfLiteStatus EvalHybridDense4Bit(
     TfLiteContext* context, TfLiteNode* node,
     TfLiteFullyConnectedParams* params, OpData* data, const TfLiteTensor* input,
@@ -974,35 +1035,55 @@ TfLiteStatus EvalHybridDense4Bit(
     const int weight_size = lhs_layout_rows * lhs_layout_cols / 2;
     const int required_size =
         optimized_4bit::kDefaultAlignmentPadding + weight_size;
-    data->op_data_4bit->AllocatePackedRegion(required_size);
     const int8_t* weight_ptr = GetTensorData<int8_t>(filter);
-    optimized_4bit::api::Prepack(data->op_data_4bit->prepacked_cache,
-                                 weight_ptr, lhs_layout_rows, lhs_layout_cols,
-                                 output_depth, cols, lhs_width, depth);
-    data->op_data_4bit->needs_prepack = false;
+    // The filter is constant, so the packed result only depends on the filter
+    // buffer and the layout. Reuse the copy packed by any other interpreter
+    // running the same model.
+    const PackedWeightRegistry::Key key{
+        weight_ptr, filter->bytes,
+        "fully_connected_4bit/" + std::to_string(lhs_width) + "x" +
+            std::to_string(depth) + "/" + std::to_string(output_depth) + "x" +
+            std::to_string(cols)};
+    std::shared_ptr<PackedFilter4Bit> packed =
+        PackedWeightRegistry::Global().GetOrCreate<PackedFilter4Bit>(
+            key, [&]() {
+              auto packed = std::make_unique<PackedFilter4Bit>(required_size);
+              optimized_4bit::api::Prepack(packed->data(), weight_ptr,
+                                           lhs_layout_rows, lhs_layout_cols,
+                                           output_depth, cols, lhs_width,
+                                           depth);
 #ifdef MADV_PAGEOUT
-    // After prepacking, we will never use the weights from the model file. Mark
-    // them with MADV_PAGEOUT so the kernel can reclaim the pages, decreasing
-    // the resident memory size.
-    //
-    // This is Linux specific. There is no effect on other platforms (e.g. on
-    // Windows, but possibly other POSIX platforms!). It requires a minimum
-    // Kernel version of 5.4 - on older kernels the call will return with an
-    // error, but we ignore it. The kernel might also ignore this hint.
-    //
-    // Note, due to rounding the pointer up (which is necessary due to madvise
-    // requiring an address that aligns with the page size), the first partial
-    // page will not be reclaimed. Madvise also rounds the end of the hinted
-    // range down, so the last partial page is also unaffected. Because of this
-    // behavior, on average one memory page (usually 4 kiB) per buffer holding 4
-    // bit data will not be paged out.
-    static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
-    int8_t* up_aligned_ptr = reinterpret_cast<int8_t*>(
-        ((reinterpret_cast<uintptr_t>(weight_ptr) + pagesize - 1) / pagesize) *
-        pagesize);
-    const auto rounding_size = up_aligned_ptr - weight_ptr;
-    madvise(up_aligned_ptr, weight_size - rounding_size, MADV_PAGEOUT);
+              // After prepacking, we will never use the weights from the model
+              // file. Mark them with MADV_PAGEOUT so the kernel can reclaim the
+              // pages, decreasing the resident memory size.
+              //
+              // This is Linux specific. There is no effect on other platforms
+              // (e.g. on Windows, but possibly other POSIX platforms!). It
+              // requires a minimum Kernel version of 5.4 - on older kernels the
+              // call will return with an error, but we ignore it. The kernel
+              // might also ignore this hint.
+              //
+              // Note, due to rounding the pointer up (which is necessary due to
+              // madvise requiring an address that aligns with the page size),
+              // the first partial page will not be reclaimed. Madvise also
+              // rounds the end of the hinted range down, so the last partial
+              // page is also unaffected. Because of this behavior, on average
+              // one memory page (usually 4 kiB) per buffer holding 4 bit data
+              // will not be paged out.
+              static const uintptr_t pagesize = sysconf(_SC_PAGESIZE);
+              int8_t* up_aligned_ptr = reinterpret_cast<int8_t*>(
+                  ((reinterpret_cast<uintptr_t>(weight_ptr) + pagesize - 1) /
+                   pagesize) *
+                  pagesize);
+              const auto rounding_size = up_aligned_ptr - weight_ptr;
+              madvise(up_aligned_ptr, weight_size - rounding_size,
+                      MADV_PAGEOUT);
 #endif
+              return packed;
+            });
+    data->op_data_4bit->prepacked_cache = packed->data();
+    data->op_data_4bit->shared_prepacked_cache = std::move(packed);
+    data->op_data_4bit->needs_prepack = false;
   }
 
   std::vector<float> filter_scales(lhs_layout_rows, filter->params.scale);
@@ -1028,11 +1109,40 @@ TfLiteStatus EvalHybridDense4Bit(
       GetTensorData<float>(output), output_depth, batch_size);
   const uint8_t* lhs = data->op_data_4bit->prepacked_cache;
   int32_t* dst = GetTensorData<int32_t>(accum_scratch);
-  optimized_4bit::api::RunAndUnpack(
-      data->op_data_4bit->rows_right, lhs, quant_data, dst, output_depth,
-      batch_size, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
-      rhs_layout_cols, dst_layout_rows, dst_layout_cols,
-      GetTensorData<float>(output), scaling_factors_ptr, filter_scales.data());
+  // Shard the integer kernel across output channels in whole filter blocks.
+  // Each block writes its own slice of dst, so the only synchronization needed
+  // is the join before unpacking.
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const int lhs_blocks = lhs_layout_rows / lhs_width;
+  const int thread_count = std::max(
+      1, std::min(cpu_backend_context->max_num_threads(),
+                  lhs_blocks / FullyConnected4BitTask::kMinBlocksPerTask));
+  if (thread_count == 1) {
+    optimized_4bit::api::RunKernel(rhs_width, lhs, quant_data, dst,
+                                   lhs_layout_rows, lhs_layout_cols,
+                                   rhs_layout_rows, rhs_layout_cols,
+                                   dst_layout_rows, dst_layout_cols);
+  } else {
+    std::vector<FullyConnected4BitTask> tasks;
+    tasks.reserve(thread_count);
+    int block_start = 0;
+    for (int i = 0; i < thread_count; ++i) {
+      int block_end = block_start + lhs_blocks / thread_count;
+      if (i < lhs_blocks % thread_count) block_end++;
+      tasks.emplace_back(rhs_width, lhs, quant_data, dst,
+                         block_start * lhs_width, block_end * lhs_width,
+                         lhs_layout_cols, rhs_layout_rows, rhs_layout_cols,
+                         dst_layout_rows);
+      block_start = block_end;
+    }
+    cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                    cpu_backend_context);
+  }
+  optimized_4bit::api::Unpack(rhs_width, GetTensorData<float>(output), dst,
+                              output_depth, batch_size, scaling_factors_ptr,
+                              filter_scales.data(), dst_layout_rows,
+                              dst_layout_cols);
   tensor_utils::ApplyActivationToVector(
       GetTensorData<float>(output), batch_size * output_depth,
       params->activation, GetTensorData<float>(output));
@@ -0,0 +1,242 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#if defined(FC_4BIT_SSE) && defined(__SSSE3__)
+
+#include <stdint.h>
+
+// NOLINTBEGIN
+#include <immintrin.h>
+
+#include <algorithm>
+
+#include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected_impl.h"
+
+// The kernels in this file are compiled for AVX2 / AVX-512 VNNI through
+// target pragmas, so the rest of the library keeps its baseline ISA. They must
+// only be called after the corresponding CPU feature has been detected at
+// runtime (see X86RunKernel in sse_fully_connected.cc).
+#if defined(__clang__)
+#define FC_4BIT_BEGIN_TARGET_AVX2                                     \
+  _Pragma("clang attribute push(__attribute__((target(\"avx2\"))), " \
+          "apply_to = function)")
+#define FC_4BIT_BEGIN_TARGET_AVX512VNNI                       \
+  _Pragma(                                                    \
+      "clang attribute push(__attribute__((target("           \
+      "\"avx2,avx512f,avx512bw,avx512vnni\"))), apply_to = function)")
+#define FC_4BIT_END_TARGET _Pragma("clang attribute pop")
+#elif defined(__GNUC__)
+#define FC_4BIT_BEGIN_TARGET_AVX2 \
+  _Pragma("GCC push_options") _Pragma("GCC target(\"avx2\")")
+#define FC_4BIT_BEGIN_TARGET_AVX512VNNI \
+  _Pragma("GCC push_options")           \
+      _Pragma("GCC target(\"avx2,avx512f,avx512bw,avx512vnni\")")
+#define FC_4BIT_END_TARGET _Pragma("GCC pop_options")
+#else
+#define FC_4BIT_BEGIN_TARGET_AVX2
+#define FC_4BIT_BEGIN_TARGET_AVX512VNNI
+#define FC_4BIT_END_TARGET
+#endif
+
+namespace tflite {
+namespace optimized_4bit {
+
+FC_4BIT_BEGIN_TARGET_AVX2
+
+namespace {
+
+// Reduces the four 128-bit lanes held by `rows01` (lanes: row 0, row 1) and
+// `rows23` (lanes: row 2, row 3), each holding four partial int32 sums, into
+// [sum(row 0), sum(row 1), sum(row 2), sum(row 3)].
+inline __m128i ReduceRowsInt32x4(__m256i rows01, __m256i rows23) {
+  // lane 0: [r0 r0 r2 r2], lane 1: [r1 r1 r3 r3]
+  __m256i sum = _mm256_hadd_epi32(rows01, rows23);
+  // lane 0: [r0 r2 r0 r2], lane 1: [r1 r3 r1 r3]
+  sum = _mm256_hadd_epi32(sum, sum);
+  const __m128i lo = _mm256_castsi256_si128(sum);
+  const __m128i hi = _mm256_extracti128_si256(sum, 1);
+  return _mm_unpacklo_epi32(lo, hi);
+}
+
+}  // namespace
+
+// The prepacked lhs stores, for every 4x32 block, the four filter rows as
+// consecutive 16 byte groups where byte j holds value j in its upper nibble and
+// value j + 16 in its lower nibble. Each filter row therefore maps onto exactly
+// one 128-bit lane, and the matching 32 rhs values are two 16 byte halves that
+// can be broadcast to every lane. This lets the wide kernels consume the same
+// packed weights as the SSSE3 kernel without any cross-lane shuffles in the
+// inner loop.
+template <int RowsLeft, int RowsRight, int Cols>
+void Avx2RunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                   int lhs_layout_rows, int lhs_layout_cols,
+                   int rhs_layout_rows, int rhs_layout_cols,
+                   int dst_layout_rows, int dst_layout_cols) {
+  static_assert(RowsLeft == 4, "AVX2 kernel expects 4 filter rows per block");
+  static_assert(Cols == 32, "AVX2 kernel expects 32 values per block");
+  const int clamped_end_row = std::min(lhs_layout_rows, dst_layout_cols);
+  const int clamped_end_col = std::min(rhs_layout_rows, dst_layout_rows);
+  const int outer_rows = (clamped_end_row + RowsLeft - 1) / RowsLeft;
+  const int outer_cols = (clamped_end_col + RowsRight - 1) / RowsRight;
+  const int depth = std::min(lhs_layout_cols / Cols, rhs_layout_cols / Cols);
+  const __m256i bitmask = _mm256_set1_epi8(15);
+  const __m256i ones = _mm256_set1_epi16(1);
+  int32_t* element_ptr = dst;
+  for (int i = 0; i < outer_rows; ++i) {
+    const uint8_t* lhs_block = lhs + i * RowsLeft * lhs_layout_cols / 2;
+    for (int j = 0; j < outer_cols; ++j) {
+      const uint8_t* lhs_val = lhs_block;
+      const int8_t* rhs_val = rhs + j * RowsRight * rhs_layout_cols;
+      __m256i accum01[RowsRight];
+      __m256i accum23[RowsRight];
+      for (int r = 0; r < RowsRight; ++r) {
+        accum01[r] = _mm256_setzero_si256();
+        accum23[r] = _mm256_setzero_si256();
+      }
+      for (int k = 0; k < depth; ++k) {
+        const __m256i lhs01 = _mm256_loadu_si256((const __m256i*)lhs_val);
+        const __m256i lhs23 =
+            _mm256_loadu_si256((const __m256i*)(lhs_val + 32));
+        lhs_val += 64;
+        const __m256i lhs01_upper =
+            _mm256_and_si256(_mm256_srli_epi16(lhs01, 4), bitmask);
+        const __m256i lhs01_lower = _mm256_and_si256(lhs01, bitmask);
+        const __m256i lhs23_upper =
+            _mm256_and_si256(_mm256_srli_epi16(lhs23, 4), bitmask);
+        const __m256i lhs23_lower = _mm256_and_si256(lhs23, bitmask);
+        for (int r = 0; r < RowsRight; ++r) {
+          const __m256i rhs_upper = _mm256_broadcastsi128_si256(
+              _mm_loadu_si128((const __m128i*)rhs_val));
+          const __m256i rhs_lower = _mm256_broadcastsi128_si256(
+              _mm_loadu_si128((const __m128i*)(rhs_val + 16)));
+          rhs_val += 32;
+          // Unsigned 4-bit times signed 8-bit products summed in pairs stay
+          // well within int16 range (2 * 2 * 15 * 128), so no saturation.
+          const __m256i prod01 =
+              _mm256_add_epi16(_mm256_maddubs_epi16(lhs01_upper, rhs_upper),
+                               _mm256_maddubs_epi16(lhs01_lower, rhs_lower));
+          const __m256i prod23 =
+              _mm256_add_epi16(_mm256_maddubs_epi16(lhs23_upper, rhs_upper),
+                               _mm256_maddubs_epi16(lhs23_lower, rhs_lower));
+          accum01[r] =
+              _mm256_add_epi32(accum01[r], _mm256_madd_epi16(prod01, ones));
+          accum23[r] =
+              _mm256_add_epi32(accum23[r], _mm256_madd_epi16(prod23, ones));
+        }
+      }
+      for (int r = 0; r < RowsRight; ++r) {
+        _mm_storeu_si128((__m128i*)element_ptr,
+                         ReduceRowsInt32x4(accum01[r], accum23[r]));
+        element_ptr += 4;
+      }
+    }
+  }
+}
+
+template void Avx2RunKernel<4, 1, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                      int32_t* dst, int lhs_layout_rows,
+                                      int lhs_layout_cols, int rhs_layout_rows,
+                                      int rhs_layout_cols, int dst_layout_rows,
+                                      int dst_layout_cols);
+
+template void Avx2RunKernel<4, 2, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                      int32_t* dst, int lhs_layout_rows,
+                                      int lhs_layout_cols, int rhs_layout_rows,
+                                      int rhs_layout_cols, int dst_layout_rows,
+                                      int dst_layout_cols);
+
+template void Avx2RunKernel<4, 4, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                      int32_t* dst, int lhs_layout_rows,
+                                      int lhs_layout_cols, int rhs_layout_rows,
+                                      int rhs_layout_cols, int dst_layout_rows,
+                                      int dst_layout_cols);
+
+FC_4BIT_END_TARGET
+
+FC_4BIT_BEGIN_TARGET_AVX512VNNI
+
+template <int RowsLeft, int RowsRight, int Cols>
+void Avx512VnniRunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                         int lhs_layout_rows, int lhs_layout_cols,
+                         int rhs_layout_rows, int rhs_layout_cols,
+                         int dst_layout_rows, int dst_layout_cols) {
+  static_assert(RowsLeft == 4, "VNNI kernel expects 4 filter rows per block");
+  static_assert(Cols == 32, "VNNI kernel expects 32 values per block");
+  const int clamped_end_row = std::min(lhs_layout_rows, dst_layout_cols);
+  const int clamped_end_col = std::min(rhs_layout_rows, dst_layout_rows);
+  const int outer_rows = (clamped_end_row + RowsLeft - 1) / RowsLeft;
+  const int outer_cols = (clamped_end_col + RowsRight - 1) / RowsRight;
+  const int depth = std::min(lhs_layout_cols / Cols, rhs_layout_cols / Cols);
+  const __m512i bitmask = _mm512_set1_epi8(15);
+  int32_t* element_ptr = dst;
+  for (int i = 0; i < outer_rows; ++i) {
+    const uint8_t* lhs_block = lhs + i * RowsLeft * lhs_layout_cols / 2;
+    for (int j = 0; j < outer_cols; ++j) {
+      const uint8_t* lhs_val = lhs_block;
+      const int8_t* rhs_val = rhs + j * RowsRight * rhs_layout_cols;
+      // Lane l of accum[r] holds four partial sums of filter row l.
+      __m512i accum[RowsRight];
+      for (int r = 0; r < RowsRight; ++r) {
+        accum[r] = _mm512_setzero_si512();
+      }
+      for (int k = 0; k < depth; ++k) {
+        const __m512i lhs_rows = _mm512_loadu_si512((const void*)lhs_val);
+        lhs_val += 64;
+        const __m512i lhs_upper =
+            _mm512_and_si512(_mm512_srli_epi16(lhs_rows, 4), bitmask);
+        const __m512i lhs_lower = _mm512_and_si512(lhs_rows, bitmask);
+        for (int r = 0; r < RowsRight; ++r) {
+          const __m512i rhs_upper = _mm512_broadcast_i32x4(
+              _mm_loadu_si128((const __m128i*)rhs_val));
+          const __m512i rhs_lower = _mm512_broadcast_i32x4(
+              _mm_loadu_si128((const __m128i*)(rhs_val + 16)));
+          rhs_val += 32;
+          accum[r] = _mm512_dpbusd_epi32(accum[r], lhs_upper, rhs_upper);
+          accum[r] = _mm512_dpbusd_epi32(accum[r], lhs_lower, rhs_lower);
+        }
+      }
+      for (int r = 0; r < RowsRight; ++r) {
+        const __m256i rows01 = _mm512_castsi512_si256(accum[r]);
+        const __m256i rows23 = _mm512_extracti64x4_epi64(accum[r], 1);
+        _mm_storeu_si128((__m128i*)element_ptr,
+                         ReduceRowsInt32x4(rows01, rows23));
+        element_ptr += 4;
+      }
+    }
+  }
+}
+// NOLINTEND
+
+template void Avx512VnniRunKernel<4, 1, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void Avx512VnniRunKernel<4, 2, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+template void Avx512VnniRunKernel<4, 4, 32>(
+    const uint8_t* lhs, const int8_t* rhs, int32_t* dst, int lhs_layout_rows,
+    int lhs_layout_cols, int rhs_layout_rows, int rhs_layout_cols,
+    int dst_layout_rows, int dst_layout_cols);
+
+FC_4BIT_END_TARGET
+
+}  // namespace optimized_4bit
+}  // namespace tflite
+
+#endif  // defined(FC_4BIT_SSE) && defined(__SSSE3__)
@@ -29,6 +29,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/cppmath.h"
 #include "tensorflow/lite/kernels/internal/optimized/4bit/fully_connected_common.h"
 #include "tensorflow/lite/kernels/internal/optimized/4bit/sse_fully_connected_impl.h"
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 
 namespace tflite {
 namespace optimized_4bit {
@@ -390,6 +391,42 @@ void SseRunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
 }
 // NOLINTEND
 
+namespace {
+
+const CpuFlags& GetX86CpuFlags() {
+  static const CpuFlags* cpu_flags = [] {
+    auto* flags = new CpuFlags();
+    GetCpuFlags(flags);
+    return flags;
+  }();
+  return *cpu_flags;
+}
+
+}  // namespace
+
+template <int RowsLeft, int RowsRight, int Cols>
+void X86RunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                  int lhs_layout_rows, int lhs_layout_cols, int rhs_layout_rows,
+                  int rhs_layout_cols, int dst_layout_rows,
+                  int dst_layout_cols) {
+  const CpuFlags& cpu_flags = GetX86CpuFlags();
+  if (cpu_flags.avx512_vnni) {
+    Avx512VnniRunKernel<RowsLeft, RowsRight, Cols>(
+        lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+        rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+    return;
+  }
+  if (cpu_flags.avx2) {
+    Avx2RunKernel<RowsLeft, RowsRight, Cols>(
+        lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+        rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+    return;
+  }
+  SseRunKernel<RowsLeft, RowsRight, Cols>(
+      lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols, rhs_layout_rows,
+      rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+}
+
 template void SseUnpack<4, 1>(float* output_ptr, const int32_t* dst,
                               int batch_size, int num_units,
                               const float* scaling_factors,
@@ -426,6 +463,24 @@ template void SseRunKernel<4, 4, 32>(const uint8_t* lhs, const int8_t* rhs,
                                      int rhs_layout_cols, int dst_layout_rows,
                                      int dst_layout_cols);
 
+template void X86RunKernel<4, 1, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                     int32_t* dst, int lhs_layout_rows,
+                                     int lhs_layout_cols, int rhs_layout_rows,
+                                     int rhs_layout_cols, int dst_layout_rows,
+                                     int dst_layout_cols);
+
+template void X86RunKernel<4, 2, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                     int32_t* dst, int lhs_layout_rows,
+                                     int lhs_layout_cols, int rhs_layout_rows,
+                                     int rhs_layout_cols, int dst_layout_rows,
+                                     int dst_layout_cols);
+
+template void X86RunKernel<4, 4, 32>(const uint8_t* lhs, const int8_t* rhs,
+                                     int32_t* dst, int lhs_layout_rows,
+                                     int lhs_layout_cols, int rhs_layout_rows,
+                                     int rhs_layout_cols, int dst_layout_rows,
+                                     int dst_layout_cols);
+
 }  // namespace optimized_4bit
 }  // namespace tflite
 
@@ -57,6 +57,30 @@ extern void SseRunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
                          int rhs_layout_rows, int rhs_layout_cols,
                          int dst_layout_rows, int dst_layout_cols);
 
+// Same contract as SseRunKernel. Must only be called on CPUs with AVX2.
+template <int RowsLeft, int RowsRight, int Cols>
+extern void Avx2RunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                          int lhs_layout_rows, int lhs_layout_cols,
+                          int rhs_layout_rows, int rhs_layout_cols,
+                          int dst_layout_rows, int dst_layout_cols);
+
+// Same contract as SseRunKernel. Must only be called on CPUs with
+// AVX-512 F/BW/VNNI.
+template <int RowsLeft, int RowsRight, int Cols>
+extern void Avx512VnniRunKernel(const uint8_t* lhs, const int8_t* rhs,
+                                int32_t* dst, int lhs_layout_rows,
+                                int lhs_layout_cols, int rhs_layout_rows,
+                                int rhs_layout_cols, int dst_layout_rows,
+                                int dst_layout_cols);
+
+// Runs the widest of the kernels above supported by the host CPU, as detected
+// once through cpu_check.h.
+template <int RowsLeft, int RowsRight, int Cols>
+extern void X86RunKernel(const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                         int lhs_layout_rows, int lhs_layout_cols,
+                         int rhs_layout_rows, int rhs_layout_cols,
+                         int dst_layout_rows, int dst_layout_cols);
+
 }  // namespace optimized_4bit
 }  // namespace tflite
 
@@ -0,0 +1,133 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Compares the SSSE3, AVX2 and AVX-512 VNNI 4-bit fully connected kernels on
+// LLM-sized shapes. Arguments are (output channels, input depth, batch).
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
+#include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
+
+#if defined(FC_4BIT_SSE) && defined(__SSSE3__)
+
+namespace tflite {
+namespace optimized_4bit {
+namespace {
+
+enum class Isa { kSsse3, kAvx2, kAvx512Vnni };
+
+template <int RowsRight>
+void RunIsaKernel(Isa isa, const uint8_t* lhs, const int8_t* rhs, int32_t* dst,
+                  int lhs_layout_rows, int layout_cols, int rhs_layout_rows) {
+  switch (isa) {
+    case Isa::kSsse3:
+      SseRunKernel<4, RowsRight, 32>(lhs, rhs, dst, lhs_layout_rows,
+                                     layout_cols, rhs_layout_rows, layout_cols,
+                                     rhs_layout_rows, lhs_layout_rows);
+      break;
+    case Isa::kAvx2:
+      Avx2RunKernel<4, RowsRight, 32>(lhs, rhs, dst, lhs_layout_rows,
+                                      layout_cols, rhs_layout_rows, layout_cols,
+                                      rhs_layout_rows, lhs_layout_rows);
+      break;
+    case Isa::kAvx512Vnni:
+      Avx512VnniRunKernel<4, RowsRight, 32>(
+          lhs, rhs, dst, lhs_layout_rows, layout_cols, rhs_layout_rows,
+          layout_cols, rhs_layout_rows, lhs_layout_rows);
+      break;
+  }
+}
+
+void BM_FullyConnected4Bit(benchmark::State& state, Isa isa) {
+  CpuFlags cpu_flags;
+  GetCpuFlags(&cpu_flags);
+  if ((isa == Isa::kAvx2 && !cpu_flags.avx2) ||
+      (isa == Isa::kAvx512Vnni && !cpu_flags.avx512_vnni)) {
+    state.SkipWithError("ISA not supported on this CPU");
+    return;
+  }
+  const int output_depth = state.range(0);
+  const int input_depth = state.range(1);
+  const int batch_size = state.range(2);
+  const int rows_right = batch_size >= 4 ? 4 : (batch_size >= 2 ? 2 : 1);
+  const int lhs_layout_rows =
+      (output_depth + (FilterWidth - 1)) & ~(FilterWidth - 1);
+  const int layout_cols = (input_depth + (FilterDepth - 1)) & ~(FilterDepth - 1);
+  const int rhs_layout_rows =
+      (batch_size + (rows_right - 1)) & ~(rows_right - 1);
+
+  std::mt19937 random_engine(2024);
+  std::uniform_int_distribution<int32_t> byte_dist(0, 255);
+  std::uniform_int_distribution<int32_t> input_dist(-127, 127);
+  std::vector<uint8_t> lhs(lhs_layout_rows * layout_cols / 2 +
+                           kDefaultAlignmentPadding);
+  for (auto& v : lhs) v = static_cast<uint8_t>(byte_dist(random_engine));
+  uint8_t* aligned_lhs = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(lhs.data()) + kDefaultAlignmentPadding) &
+      ~kDefaultAlignmentPadding);
+  std::vector<int8_t> rhs(rhs_layout_rows * layout_cols);
+  for (auto& v : rhs) v = static_cast<int8_t>(input_dist(random_engine));
+  std::vector<int32_t> dst(lhs_layout_rows * rhs_layout_rows);
+
+  for (auto _ : state) {
+    switch (rows_right) {
+      case 4:
+        RunIsaKernel<4>(isa, aligned_lhs, rhs.data(), dst.data(),
+                        lhs_layout_rows, layout_cols, rhs_layout_rows);
+        break;
+      case 2:
+        RunIsaKernel<2>(isa, aligned_lhs, rhs.data(), dst.data(),
+                        lhs_layout_rows, layout_cols, rhs_layout_rows);
+        break;
+      default:
+        RunIsaKernel<1>(isa, aligned_lhs, rhs.data(), dst.data(),
+                        lhs_layout_rows, layout_cols, rhs_layout_rows);
+        break;
+    }
+    benchmark::DoNotOptimize(dst.data());
+  }
+  // Multiply-accumulates per iteration, reported as items.
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(lhs_layout_rows) * layout_cols *
+                          rhs_layout_rows);
+  state.SetBytesProcessed(state.iterations() *
+                          static_cast<int64_t>(lhs_layout_rows) * layout_cols /
+                          2);
+}
+
+void LlmShapes(benchmark::internal::Benchmark* b) {
+  for (int batch : {1, 4, 16}) {
+    b->Args({4096, 4096, batch});
+    b->Args({11008, 4096, batch});
+    b->Args({4096, 11008, batch});
+  }
+}
+
+BENCHMARK_CAPTURE(BM_FullyConnected4Bit, ssse3, Isa::kSsse3)->Apply(LlmShapes);
+BENCHMARK_CAPTURE(BM_FullyConnected4Bit, avx2, Isa::kAvx2)->Apply(LlmShapes);
+BENCHMARK_CAPTURE(BM_FullyConnected4Bit, avx512_vnni, Isa::kAvx512Vnni)
+    ->Apply(LlmShapes);
+
+}  // namespace
+}  // namespace optimized_4bit
+}  // namespace tflite
+
+#endif  // defined(FC_4BIT_SSE) && defined(__SSSE3__)
+
+BENCHMARK_MAIN();
@@ -47,4 +47,26 @@ bool DetectArmNeonDotprod() {
 #endif
 }
 
+// __builtin_cpu_supports also checks that the OS saves the extended register
+// state (XCR0), so a true result means the instructions are usable.
+bool DetectX86Avx2() {
+#if (defined __x86_64__ || defined __i386__) && \
+    (defined __GNUC__ || defined __clang__)
+  return __builtin_cpu_supports("avx2");
+#else
+  return false;
+#endif
+}
+
+bool DetectX86Avx512Vnni() {
+#if (defined __x86_64__ || defined __i386__) && \
+    (defined __GNUC__ || defined __clang__)
+  return __builtin_cpu_supports("avx512f") &&
+         __builtin_cpu_supports("avx512bw") &&
+         __builtin_cpu_supports("avx512vnni");
+#else
+  return false;
+#endif
+}
+
 }  // namespace tflite
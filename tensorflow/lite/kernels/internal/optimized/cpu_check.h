@@ -27,12 +27,25 @@ namespace tflite {
 // On other architectures, returns false unconditionally.
 bool DetectArmNeonDotprod();
 
+// On x86, returns true if the CPU and OS support AVX2.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx2();
+
+// On x86, returns true if the CPU and OS support AVX-512 VNNI together with
+// the AVX-512 F/BW subsets required by the VNNI kernels.
+// On other architectures, returns false unconditionally.
+bool DetectX86Avx512Vnni();
+
 struct CpuFlags {
   bool neon_dotprod = false;
+  bool avx2 = false;
+  bool avx512_vnni = false;
 };
 
 inline void GetCpuFlags(CpuFlags* cpu_flags) {
   cpu_flags->neon_dotprod = DetectArmNeonDotprod();
+  cpu_flags->avx2 = DetectX86Avx2();
+  cpu_flags->avx512_vnni = DetectX86Avx512Vnni();
 }
 
 }  // namespace tflite
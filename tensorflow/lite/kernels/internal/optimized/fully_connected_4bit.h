@@ -62,6 +62,9 @@ struct OpData4Bit {
   uint8_t* prepacked_cache = nullptr;
   std::unique_ptr<uint8_t[], Deleter> prepacked_cache_buffer;
   size_t prepacked_cache_buffer_size = 0;
+  // Set instead of prepacked_cache_buffer when the prepacked filter is owned
+  // by an object shared with other interpreters; keeps prepacked_cache alive.
+  std::shared_ptr<void> shared_prepacked_cache;
 
   void AllocatePackedRegion(size_t required_size) {
 #ifdef TFLITE_MMAP_DISABLED
@@ -145,6 +148,34 @@ inline void RunAndUnpack(int rhs_width, const uint8_t* lhs, const int8_t* rhs,
       dst_layout_cols, output_ptr, scaling_factors, filter_scales);
 }
 
+/* Compute sum of lhs * rhs columnwise into dst without unpacking.
+ * The accumulators of each FilterWidth block of lhs rows occupy
+ * FilterWidth * dst_layout_rows consecutive values of dst, so disjoint slices
+ * of whole row blocks can be computed independently, e.g. from different
+ * threads: for the slice starting at row `r`, pass
+ * lhs + r * lhs_layout_cols / 2, dst + r * dst_layout_rows, and the slice size
+ * as both lhs_layout_rows and dst_layout_cols.
+ */
+inline void RunKernel(int rhs_width, const uint8_t* lhs, const int8_t* rhs,
+                      int32_t* dst, int lhs_layout_rows, int lhs_layout_cols,
+                      int rhs_layout_rows, int rhs_layout_cols,
+                      int dst_layout_rows, int dst_layout_cols) {
+  optimized_4bit::RunKernelForWidth(
+      rhs_width, lhs, rhs, dst, lhs_layout_rows, lhs_layout_cols,
+      rhs_layout_rows, rhs_layout_cols, dst_layout_rows, dst_layout_cols);
+}
+
+// Add the accumulated sums in dst, computed by RunKernel over the full filter,
+// to output_ptr.
+inline void Unpack(int rhs_width, float* output_ptr, const int32_t* dst,
+                   int output_depth, int batch_size,
+                   const float* scaling_factors, const float* filter_scales,
+                   int dst_layout_rows, int dst_layout_cols) {
+  optimized_4bit::UnpackForWidth(rhs_width, output_ptr, dst, batch_size,
+                                 output_depth, scaling_factors, filter_scales,
+                                 dst_layout_rows, dst_layout_cols);
+}
+
 }  // namespace api
 }  // namespace optimized_4bit
 }  // namespace tflite
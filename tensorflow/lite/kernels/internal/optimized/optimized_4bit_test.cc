@@ -12,6 +12,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
+#include <algorithm>
 #include <cstdint>
 #include <cstdlib>
 #include <functional>
@@ -20,6 +21,7 @@ limitations under the License.
 #include <vector>
 
 #include <gtest/gtest.h>
+#include "tensorflow/lite/kernels/internal/optimized/cpu_check.h"
 #include "tensorflow/lite/kernels/internal/optimized/fully_connected_4bit.h"
 
 namespace tflite {
@@ -555,5 +557,108 @@ INSTANTIATE_TEST_SUITE_P(
           std::make_tuple(4, 16, 32, 64),
 #endif
     }));
+
+#if defined(FC_4BIT_SSE) && defined(__SSSE3__)
+// Checks that the AVX2 and AVX-512 VNNI kernels agree bit-exactly with the
+// SSSE3 kernel on the same prepacked operands, for every compiled rhs width.
+class RunX86KernelTests
+    : public ::testing::TestWithParam<::testing::tuple<int, int, int, int>> {};
+
+template <int RowsRight>
+void RunX86Kernels(const std::vector<uint8_t>& lhs,
+                   const std::vector<int8_t>& rhs, int lhs_layout_rows,
+                   int rhs_layout_rows, int layout_cols,
+                   const CpuFlags& cpu_flags) {
+  const int accum_size = lhs_layout_rows * rhs_layout_rows;
+  std::vector<int32_t> expected(accum_size);
+  optimized_4bit::SseRunKernel<4, RowsRight, 32>(
+      lhs.data(), rhs.data(), expected.data(), lhs_layout_rows, layout_cols,
+      rhs_layout_rows, layout_cols, rhs_layout_rows, lhs_layout_rows);
+  if (cpu_flags.avx2) {
+    std::vector<int32_t> accum(accum_size);
+    optimized_4bit::Avx2RunKernel<4, RowsRight, 32>(
+        lhs.data(), rhs.data(), accum.data(), lhs_layout_rows, layout_cols,
+        rhs_layout_rows, layout_cols, rhs_layout_rows, lhs_layout_rows);
+    EXPECT_EQ(accum, expected);
+  }
+  if (cpu_flags.avx512_vnni) {
+    std::vector<int32_t> accum(accum_size);
+    optimized_4bit::Avx512VnniRunKernel<4, RowsRight, 32>(
+        lhs.data(), rhs.data(), accum.data(), lhs_layout_rows, layout_cols,
+        rhs_layout_rows, layout_cols, rhs_layout_rows, lhs_layout_rows);
+    EXPECT_EQ(accum, expected);
+  }
+}
+
+TEST_P(RunX86KernelTests, MatchesSseKernel) {
+  CpuFlags cpu_flags;
+  GetCpuFlags(&cpu_flags);
+  if (!cpu_flags.avx2 && !cpu_flags.avx512_vnni) {
+    GTEST_SKIP() << "No AVX2 or AVX-512 VNNI support on this CPU.";
+  }
+  auto params = GetParam();
+  const int rhs_width = std::get<0>(params);
+  const int lhs_layout_rows = std::get<1>(params);
+  const int rhs_layout_rows = std::get<2>(params);
+  const int layout_cols = std::get<3>(params);
+  std::uniform_int_distribution<int32_t> byte_dist(0, 255);
+  std::uniform_int_distribution<int32_t> input_dist(-127, 127);
+  std::vector<uint8_t> lhs(lhs_layout_rows * layout_cols / 2);
+  for (auto& v : lhs) v = static_cast<uint8_t>(byte_dist(random_engine));
+  std::vector<int8_t> rhs(rhs_layout_rows * layout_cols);
+  for (auto& v : rhs) v = static_cast<int8_t>(input_dist(random_engine));
+  switch (rhs_width) {
+    case 4:
+      RunX86Kernels<4>(lhs, rhs, lhs_layout_rows, rhs_layout_rows, layout_cols,
+                       cpu_flags);
+      break;
+    case 2:
+      RunX86Kernels<2>(lhs, rhs, lhs_layout_rows, rhs_layout_rows, layout_cols,
+                       cpu_flags);
+      break;
+    default:
+      RunX86Kernels<1>(lhs, rhs, lhs_layout_rows, rhs_layout_rows, layout_cols,
+                       cpu_flags);
+      break;
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(
+    RunX86KernelTests, RunX86KernelTests,
+    ::testing::ValuesIn({
+        std::make_tuple(1, 4, 1, 32), std::make_tuple(1, 16, 5, 64),
+        std::make_tuple(2, 8, 2, 32), std::make_tuple(2, 16, 6, 128),
+        std::make_tuple(4, 4, 4, 32), std::make_tuple(4, 64, 8, 4096),
+    }));
+
+// Checks that computing disjoint slices of filter blocks independently, as the
+// multithreaded FULLY_CONNECTED kernel does, matches a single call.
+TEST(RunKernelSliceTests, SlicesMatchFullRun) {
+  const int rhs_width = 4;
+  const int lhs_layout_rows = 32;
+  const int rhs_layout_rows = 8;
+  const int layout_cols = 256;
+  std::uniform_int_distribution<int32_t> byte_dist(0, 255);
+  std::vector<uint8_t> lhs(lhs_layout_rows * layout_cols / 2);
+  for (auto& v : lhs) v = static_cast<uint8_t>(byte_dist(random_engine));
+  std::vector<int8_t> rhs(rhs_layout_rows * layout_cols);
+  for (auto& v : rhs) v = static_cast<int8_t>(int_dist(random_engine));
+  std::vector<int32_t> expected(lhs_layout_rows * rhs_layout_rows);
+  optimized_4bit::api::RunKernel(rhs_width, lhs.data(), rhs.data(),
+                                 expected.data(), lhs_layout_rows, layout_cols,
+                                 rhs_layout_rows, layout_cols, rhs_layout_rows,
+                                 lhs_layout_rows);
+  std::vector<int32_t> accum(lhs_layout_rows * rhs_layout_rows);
+  for (int row = 0; row < lhs_layout_rows; row += 12) {
+    const int rows = std::min(12, lhs_layout_rows - row);
+    optimized_4bit::api::RunKernel(
+        rhs_width, lhs.data() + row * layout_cols / 2, rhs.data(),
+        accum.data() + row * rhs_layout_rows, rows, layout_cols,
+        rhs_layout_rows, layout_cols, rhs_layout_rows, rows);
+  }
+  EXPECT_EQ(accum, expected);
+}
+#endif  // defined(FC_4BIT_SSE) && defined(__SSSE3__)
+
 }  // namespace
 }  // namespace tflite
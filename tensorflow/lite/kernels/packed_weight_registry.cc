@@ -0,0 +1,85 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/packed_weight_registry.h"
+
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+
+namespace tflite {
+
+PackedWeightRegistry& PackedWeightRegistry::Global() {
+  // Never destroyed, so that entries released during static destruction can
+  // still unregister themselves.
+  static PackedWeightRegistry* registry = new PackedWeightRegistry();
+  return *registry;
+}
+
+std::shared_ptr<PackedWeights> PackedWeightRegistry::GetOrCreate(
+    const Key& key, const Factory& factory) {
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    packing_done_.wait(lock, [&] { return packing_.count(key) == 0; });
+    auto it = entries_.find(key);
+    if (it != entries_.end()) {
+      if (std::shared_ptr<PackedWeights> weights = it->second.weights.lock()) {
+        ++hits_;
+        return weights;
+      }
+    }
+    ++misses_;
+    packing_.insert(key);
+  }
+
+  std::unique_ptr<PackedWeights> packed = factory();
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  packing_.erase(key);
+  packing_done_.notify_all();
+  if (packed == nullptr) {
+    return nullptr;
+  }
+  PackedWeights* raw = packed.release();
+  resident_bytes_ += raw->bytes();
+  std::shared_ptr<PackedWeights> weights(
+      raw, [this, key](PackedWeights* weights) { Release(key, weights); });
+  entries_[key] = Entry{weights, raw};
+  return weights;
+}
+
+PackedWeightRegistry::Stats PackedWeightRegistry::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Stats stats;
+  stats.num_entries = entries_.size();
+  stats.resident_bytes = resident_bytes_;
+  stats.hits = hits_;
+  stats.misses = misses_;
+  return stats;
+}
+
+void PackedWeightRegistry::Release(const Key& key, PackedWeights* weights) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    resident_bytes_ -= weights->bytes();
+    // A lookup may have replaced the expired entry before we got here.
+    auto it = entries_.find(key);
+    if (it != entries_.end() && it->second.raw == weights) {
+      entries_.erase(it);
+    }
+  }
+  delete weights;
+}
+
+}  // namespace tflite
@@ -0,0 +1,136 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_REGISTRY_H_
+#define TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_REGISTRY_H_
+
+#include <condition_variable>  // NOLINT(build/c++11)
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>  // NOLINT(build/c++11)
+#include <set>
+#include <string>
+#include <tuple>
+
+namespace tflite {
+
+// Weights transformed into a kernel specific layout, e.g. a prepacked filter.
+// Subclasses own the packed data and report its size for accounting.
+class PackedWeights {
+ public:
+  virtual ~PackedWeights() = default;
+
+  // Number of bytes held by this object. Used for memory accounting only.
+  virtual size_t bytes() const = 0;
+};
+
+// Process-wide registry of packed weights.
+//
+// Interpreters built from the same model share the read-only model buffer, so
+// any weights packed from that buffer are identical across them. Kernels and
+// delegates look packed weights up by the identity of the source buffer and
+// a string describing the packed layout, and only the first lookup packs. The
+// returned `shared_ptr` keeps the entry alive; it is dropped from the registry
+// when the last interpreter using it releases it.
+//
+// Only key on buffers owned by the model (i.e. `kTfLiteMmapRo` tensors): while
+// an entry is alive, some interpreter still references the source buffer, so
+// its address can not be reused for different weights.
+//
+// This class is thread-safe. Concurrent lookups of the same key wait for the
+// first one to finish packing rather than packing the weights again.
+class PackedWeightRegistry {
+ public:
+  struct Key {
+    // Start of the source (unpacked) weights in the model buffer.
+    const void* source;
+    // Size of the source weights, in bytes.
+    size_t source_bytes;
+    // Kernel specific description of the packed layout, e.g. block sizes and
+    // logical shape. Entries packed from the same source into different
+    // layouts are distinct.
+    std::string layout;
+
+    bool operator<(const Key& other) const {
+      return std::tie(source, source_bytes, layout) <
+             std::tie(other.source, other.source_bytes, other.layout);
+    }
+  };
+
+  struct Stats {
+    // Number of packed weights currently alive.
+    size_t num_entries = 0;
+    // Sum of `PackedWeights::bytes()` over the live entries.
+    size_t resident_bytes = 0;
+    // Number of lookups served from an existing entry.
+    int64_t hits = 0;
+    // Number of lookups that had to pack the weights.
+    int64_t misses = 0;
+  };
+
+  using Factory = std::function<std::unique_ptr<PackedWeights>()>;
+
+  // Returns the registry shared by all interpreters in the process.
+  static PackedWeightRegistry& Global();
+
+  PackedWeightRegistry() = default;
+  PackedWeightRegistry(const PackedWeightRegistry&) = delete;
+  PackedWeightRegistry& operator=(const PackedWeightRegistry&) = delete;
+
+  // Returns the packed weights for `key`, calling `factory` to create them if
+  // there is no live entry. Returns nullptr if `factory` does. `factory` is
+  // called without holding the registry lock.
+  std::shared_ptr<PackedWeights> GetOrCreate(const Key& key,
+                                             const Factory& factory);
+
+  // Typed variant of `GetOrCreate`. All users of a given key must pass the
+  // same `T`.
+  template <typename T>
+  std::shared_ptr<T> GetOrCreate(
+      const Key& key, const std::function<std::unique_ptr<T>()>& factory) {
+    return std::static_pointer_cast<T>(
+        GetOrCreate(key, [&factory]() -> std::unique_ptr<PackedWeights> {
+          return factory();
+        }));
+  }
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    std::weak_ptr<PackedWeights> weights;
+    // Identifies the object `weights` pointed to, to tell a stale entry
+    // being released apart from its replacement.
+    const PackedWeights* raw = nullptr;
+  };
+
+  void Release(const Key& key, PackedWeights* weights);
+
+  mutable std::mutex mutex_;
+  std::condition_variable packing_done_;
+  std::map<Key, Entry> entries_;
+  // Keys for which some thread is currently running the factory.
+  std::set<Key> packing_;
+  size_t resident_bytes_ = 0;
+  int64_t hits_ = 0;
+  int64_t misses_ = 0;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_KERNELS_PACKED_WEIGHT_REGISTRY_H_
@@ -0,0 +1,263 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/packed_weight_registry.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/interpreter_builder.h"
+#include "tensorflow/lite/kernels/register.h"
+#include "tensorflow/lite/model_builder.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+class TestWeights : public PackedWeights {
+ public:
+  explicit TestWeights(size_t size) : data_(size) {}
+  size_t bytes() const override { return data_.size(); }
+
+ private:
+  std::vector<uint8_t> data_;
+};
+
+PackedWeightRegistry::Factory MakeFactory(size_t size, int* calls) {
+  return [size, calls]() {
+    ++*calls;
+    return std::make_unique<TestWeights>(size);
+  };
+}
+
+TEST(PackedWeightRegistryTest, SharesEntriesWithTheSameKey) {
+  PackedWeightRegistry registry;
+  const int source = 0;
+  int calls = 0;
+  auto first =
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls));
+  auto second =
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls));
+
+  EXPECT_EQ(first, second);
+  EXPECT_EQ(calls, 1);
+  const PackedWeightRegistry::Stats stats = registry.GetStats();
+  EXPECT_EQ(stats.num_entries, 1);
+  EXPECT_EQ(stats.resident_bytes, 16);
+  EXPECT_EQ(stats.hits, 1);
+  EXPECT_EQ(stats.misses, 1);
+}
+
+TEST(PackedWeightRegistryTest, DistinguishesSourceAndLayout) {
+  PackedWeightRegistry registry;
+  const int sources[2] = {0, 0};
+  int calls = 0;
+  auto a =
+      registry.GetOrCreate({&sources[0], 4, "layout"}, MakeFactory(8, &calls));
+  auto b =
+      registry.GetOrCreate({&sources[1], 4, "layout"}, MakeFactory(8, &calls));
+  auto c =
+      registry.GetOrCreate({&sources[0], 4, "other"}, MakeFactory(8, &calls));
+  auto d =
+      registry.GetOrCreate({&sources[0], 8, "layout"}, MakeFactory(8, &calls));
+
+  EXPECT_EQ(calls, 4);
+  EXPECT_EQ(registry.GetStats().num_entries, 4);
+  EXPECT_EQ(registry.GetStats().resident_bytes, 32);
+}
+
+TEST(PackedWeightRegistryTest, ReleasesEntryWithLastReference) {
+  PackedWeightRegistry registry;
+  const int source = 0;
+  int calls = 0;
+  auto first =
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls));
+  auto second =
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls));
+
+  first.reset();
+  EXPECT_EQ(registry.GetStats().num_entries, 1);
+  EXPECT_EQ(registry.GetStats().resident_bytes, 16);
+
+  second.reset();
+  EXPECT_EQ(registry.GetStats().num_entries, 0);
+  EXPECT_EQ(registry.GetStats().resident_bytes, 0);
+
+  // The next lookup packs again.
+  auto third =
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls));
+  EXPECT_EQ(calls, 2);
+  EXPECT_EQ(registry.GetStats().resident_bytes, 16);
+}
+
+TEST(PackedWeightRegistryTest, FailedFactoryIsNotCached) {
+  PackedWeightRegistry registry;
+  const int source = 0;
+  EXPECT_EQ(registry.GetOrCreate({&source, 4, "layout"},
+                                 []() { return nullptr; }),
+            nullptr);
+  EXPECT_EQ(registry.GetStats().num_entries, 0);
+
+  int calls = 0;
+  EXPECT_NE(
+      registry.GetOrCreate({&source, 4, "layout"}, MakeFactory(16, &calls)),
+      nullptr);
+  EXPECT_EQ(calls, 1);
+}
+
+TEST(PackedWeightRegistryTest, ConcurrentLookupsPackOnce) {
+  PackedWeightRegistry registry;
+  const int source = 0;
+  std::atomic<int> calls{0};
+  constexpr int kNumThreads = 16;
+  std::vector<std::shared_ptr<PackedWeights>> results(kNumThreads);
+  std::vector<std::thread> threads;
+  for (int i = 0; i < kNumThreads; ++i) {
+    threads.emplace_back([&, i]() {
+      results[i] = registry.GetOrCreate({&source, 4, "layout"}, [&calls]() {
+        ++calls;
+        return std::make_unique<TestWeights>(64);
+      });
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+
+  EXPECT_EQ(calls.load(), 1);
+  for (const auto& result : results) {
+    EXPECT_EQ(result, results[0]);
+  }
+  EXPECT_EQ(registry.GetStats().resident_bytes, 64);
+}
+
+// Builds a model with a single hybrid fully connected op with a constant 4bit
+// filter, which the optimized kernel prepacks.
+std::vector<char> CreateFullyConnected4BitModel(int units, int input_size) {
+  flatbuffers::FlatBufferBuilder builder;
+  std::vector<uint8_t> filter_data(units * input_size / 2);
+  for (size_t i = 0; i < filter_data.size(); ++i) {
+    filter_data[i] = static_cast<uint8_t>(i * 37);
+  }
+  std::vector<float> bias_data(units, 0.5f);
+  const flatbuffers::Offset<Buffer> buffers[3] = {
+      CreateBuffer(builder, builder.CreateVector({})),
+      CreateBuffer(builder, builder.CreateVector(filter_data)),
+      CreateBuffer(builder,
+                   builder.CreateVector(
+                       reinterpret_cast<const uint8_t*>(bias_data.data()),
+                       bias_data.size() * sizeof(float))),
+  };
+
+  const std::vector<int32_t> input_shape = {1, input_size};
+  const std::vector<int32_t> filter_shape = {units, input_size};
+  const std::vector<int32_t> bias_shape = {units};
+  const std::vector<int32_t> output_shape = {1, units};
+  const flatbuffers::Offset<QuantizationParameters> filter_quantization =
+      CreateQuantizationParameters(builder, /*min=*/0, /*max=*/0,
+                                   builder.CreateVector<float>({0.25f}),
+                                   builder.CreateVector<int64_t>({0}));
+  const flatbuffers::Offset<Tensor> tensors[4] = {
+      CreateTensor(builder, builder.CreateVector(input_shape),
+                   TensorType_FLOAT32, /*buffer=*/0),
+      CreateTensor(builder, builder.CreateVector(filter_shape),
+                   TensorType_INT4, /*buffer=*/1, /*name=*/0,
+                   filter_quantization),
+      CreateTensor(builder, builder.CreateVector(bias_shape),
+                   TensorType_FLOAT32, /*buffer=*/2),
+      CreateTensor(builder, builder.CreateVector(output_shape),
+                   TensorType_FLOAT32, /*buffer=*/0),
+  };
+
+  const flatbuffers::Offset<OperatorCode> op_code =
+      CreateOperatorCode(builder, BuiltinOperator_FULLY_CONNECTED);
+  const std::vector<int32_t> op_inputs = {0, 1, 2};
+  const std::vector<int32_t> op_outputs = {3};
+  const flatbuffers::Offset<Operator> op = CreateOperator(
+      builder, /*opcode_index=*/0, builder.CreateVector(op_inputs),
+      builder.CreateVector(op_outputs),
+      BuiltinOptions_FullyConnectedOptions,
+      CreateFullyConnectedOptions(builder).Union());
+  const std::vector<int32_t> subgraph_inputs = {0};
+  const flatbuffers::Offset<SubGraph> subgraph = CreateSubGraph(
+      builder, builder.CreateVector(tensors, 4),
+      builder.CreateVector(subgraph_inputs), builder.CreateVector(op_outputs),
+      builder.CreateVector(&op, 1));
+  builder.Finish(CreateModel(builder, TFLITE_SCHEMA_VERSION,
+                             builder.CreateVector(&op_code, 1),
+                             builder.CreateVector(&subgraph, 1),
+                             builder.CreateString("fully_connected_4bit"),
+                             builder.CreateVector(buffers, 3)));
+  return std::vector<char>(builder.GetBufferPointer(),
+                           builder.GetBufferPointer() + builder.GetSize());
+}
+
+TEST(PackedWeightRegistryTest, ResidentBytesStayFlatAcrossReplicas) {
+  constexpr int kUnits = 16;
+  constexpr int kInputSize = 128;
+  constexpr int kNumReplicas = 8;
+  const std::vector<char> buffer =
+      CreateFullyConnected4BitModel(kUnits, kInputSize);
+  std::unique_ptr<FlatBufferModel> model =
+      FlatBufferModel::BuildFromBuffer(buffer.data(), buffer.size());
+  ASSERT_NE(model, nullptr);
+  ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+
+  const PackedWeightRegistry& registry = PackedWeightRegistry::Global();
+  const PackedWeightRegistry::Stats initial = registry.GetStats();
+  size_t resident_bytes_per_model = 0;
+  std::vector<float> expected_output;
+  std::vector<std::unique_ptr<Interpreter>> replicas;
+  for (int i = 0; i < kNumReplicas; ++i) {
+    std::unique_ptr<Interpreter> interpreter;
+    ASSERT_EQ(InterpreterBuilder(*model, resolver)(&interpreter), kTfLiteOk);
+    ASSERT_EQ(interpreter->AllocateTensors(), kTfLiteOk);
+    float* input = interpreter->typed_input_tensor<float>(0);
+    for (int j = 0; j < kInputSize; ++j) {
+      input[j] = static_cast<float>(j % 7) - 3.0f;
+    }
+    ASSERT_EQ(interpreter->Invoke(), kTfLiteOk);
+    const float* output = interpreter->typed_output_tensor<float>(0);
+    const std::vector<float> actual_output(output, output + kUnits);
+
+    const PackedWeightRegistry::Stats stats = registry.GetStats();
+    EXPECT_EQ(stats.num_entries, initial.num_entries + 1);
+    if (i == 0) {
+      resident_bytes_per_model = stats.resident_bytes - initial.resident_bytes;
+      EXPECT_GE(resident_bytes_per_model, kUnits * kInputSize / 2);
+      expected_output = actual_output;
+    } else {
+      EXPECT_EQ(stats.resident_bytes,
+                initial.resident_bytes + resident_bytes_per_model);
+      EXPECT_EQ(actual_output, expected_output);
+    }
+    replicas.push_back(std::move(interpreter));
+  }
+  EXPECT_EQ(registry.GetStats().hits - initial.hits, kNumReplicas - 1);
+
+  replicas.clear();
+  EXPECT_EQ(registry.GetStats().num_entries, initial.num_entries);
+  EXPECT_EQ(registry.GetStats().resident_bytes, initial.resident_bytes);
+}
+
+}  // namespace
+}  // namespace tflite
@@ -30,6 +30,8 @@ limitations under the License.
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/util.h"
 
@@ -309,94 +311,7 @@ void PadCrop(const PadCropData& ctx, const char* input, const char* init_value,
 namespace reduce_window {
 namespace {
 
-// Reduces the elements of a tensor viewed through a strided window.
-//
-// This applies a reduction to a tensor by skipping over elements that are not
-// in the window defined by the given shape and strides. The window is reduced
-// to one element.
-//
-// The shape is the shape of the window. The strides are based on the actual
-// tensor and the distance between window elements, counted in elements.
-// Sparse windows are possible.
-//
-// For instance: the following window has a [2, 2] shape and [8, 3] strides.
-//
-// ┌──┐     ┌──┐
-// │ 1│ 2  3│ 4│
-// └──┘     └──┘
-//   5  6  7  8    is reduced to 1 + 4 + 9 + 12 = 26
-// ┌──┐     ┌──┐
-// │ 9│10 11│12│
-// └──┘     └──┘
-//  13 14 15 16
-//
-// This is a recursive implementation of the strided reduction.
-template <class Op, class Type>
-void StridedReduce(const Type* input, const int64_t* const shape,
-                   const int64_t* const strides, Type& accu, const int rank,
-                   const int depth) {
-  const int64_t stride = strides[depth];
-  const int64_t size = shape[depth];
-  if (depth + 1 == rank) {
-    const Op op;
-    for (int64_t i = 0; i < size; ++i) {
-      accu = op(accu, *input);
-      input += stride;
-    }
-  } else {
-    for (int64_t i = 0; i < size; ++i) {
-      StridedReduce<Op, Type>(input, shape, strides, accu, rank, depth + 1);
-      input += stride;
-    }
-  }
-}
-
-// Recursively computes strided reductions using a sliding window over the
-// given tensor.
-//
-// The window is defined using a shape and a dilation. The shape defines the
-// elements that the window will let the reduction *see*. The dilation defines
-// the step between window elements.
-//
-// For instance: the following window has a [2, 2] shape and [2, 3] dilations.
-//
-//    3
-// ┌────┐
-// ┌─┐   ┌─┐
-// │X│X X│X│┐
-// └─┘   └─┘│2
-//  X X X X ┘
-// ┌─┐   ┌─┐
-// │X│X X│X│
-// └─┘   └─┘
-template <class Op, class Type>
-void ReduceWindowImpl(const Type* input, Type* output,
-                      const int64_t* const output_shape,
-                      const int64_t* const output_strides,
-                      const int64_t* const window_offset_strides,
-                      const int64_t* const window_shape,
-                      const int64_t* const window_reduce_strides,
-                      const Type init, const int rank, const int depth) {
-  if (depth + 1 == rank) {
-    for (int32_t dim = 0; dim < output_shape[depth]; ++dim) {
-      *output = init;
-      StridedReduce<Op, Type>(input, window_shape, window_reduce_strides,
-                              *output, rank, /*depth=*/0);
-      input += window_offset_strides[depth];
-      output += output_strides[depth];
-    }
-  } else {
-    for (int32_t dim = 0; dim < output_shape[depth]; ++dim) {
-      ReduceWindowImpl<Op, Type>(input, output, output_shape, output_strides,
-                                 window_offset_strides, window_shape,
-                                 window_reduce_strides, init, rank, depth + 1);
-      input += window_offset_strides[depth];
-      output += output_strides[depth];
-    }
-  }
-}
-
-// Computes and holds the parameters that can be precomputed for the dilation
+// Computes and holds the parameters that can be precomputed for the reduction
 // operation.
 struct ReduceWindowData {
   ReduceWindowData() = default;
@@ -414,6 +329,11 @@ struct ReduceWindowData {
     Multiply(window_offset_strides, input_strides, window_strides);
     ComputeOutputShape();
     ComputeStrides(output_strides, output_shape);
+    ComputeWindowOffsets();
+    num_rows = 1;
+    for (int64_t i = 0; i + 1 < rank; ++i) {
+      num_rows *= output_shape[i];
+    }
   }
 
   void ComputeStrides(int64_t* strides, const int64_t* const shape) {
@@ -445,6 +365,37 @@ struct ReduceWindowData {
     }
   }
 
+  // Lists the input offsets of the window elements relative to the window
+  // origin, in row-major window order.
+  void ComputeWindowOffsets() {
+    int64_t window_size = 1;
+    for (int64_t i = 0; i < rank; ++i) {
+      window_size *= window_shape[i];
+    }
+    window_offsets.clear();
+    window_offsets.reserve(window_size);
+    if (window_size == 0) {
+      return;
+    }
+    int64_t index[kMaxReduceWindowRank] = {};
+    int64_t offset = 0;
+    while (true) {
+      window_offsets.push_back(offset);
+      int64_t dim = rank - 1;
+      for (; dim >= 0; --dim) {
+        offset += window_reduce_strides[dim];
+        if (++index[dim] < window_shape[dim]) {
+          break;
+        }
+        offset -= index[dim] * window_reduce_strides[dim];
+        index[dim] = 0;
+      }
+      if (dim < 0) {
+        return;
+      }
+    }
+  }
+
   int rank = 0;
   const int64_t* input_shape;
   const int64_t* window_shape;
@@ -455,15 +406,160 @@ struct ReduceWindowData {
   int64_t window_reduce_strides[kMaxReduceWindowRank] = {};
   int64_t output_shape[kMaxReduceWindowRank] = {};
   int64_t output_strides[kMaxReduceWindowRank] = {};
+  std::vector<int64_t> window_offsets;
+  // Number of rows of the innermost output dimension.
+  int64_t num_rows = 0;
+};
+
+// Number of output elements of a row that are reduced together.
+//
+// This keeps the accumulators in L1 while the window elements are streamed.
+constexpr int64_t kReduceWindowBlockSize = 512;
+
+// Below this amount of window element reductions per thread, the work is not
+// worth sharding.
+constexpr int64_t kReduceWindowMinWorkPerThread = 1 << 15;
+
+// Reduces a block of contiguous outputs of the innermost output dimension.
+//
+// Each output reduces the elements of the input viewed through a strided
+// window. For instance: the following window has a [2, 2] shape and [8, 3]
+// strides.
+//
+// ┌──┐     ┌──┐
+// │ 1│ 2  3│ 4│
+// └──┘     └──┘
+//   5  6  7  8    is reduced to 1 + 4 + 9 + 12 = 26
+// ┌──┐     ┌──┐
+// │ 9│10 11│12│
+// └──┘     └──┘
+//  13 14 15 16
+//
+// All the outputs of a row see the same window element offsets shifted by the
+// innermost window stride. Iterating over the window elements in the outer
+// loop turns the reduction into element-wise operations over the block that
+// the compiler can vectorize, especially for the common unit stride case.
+// Each output still reduces its window elements in row-major window order.
+template <class Op, class Type>
+void ReduceWindowBlock(const Type* input, Type* output, const int64_t size,
+                       const int64_t input_stride,
+                       const std::vector<int64_t>& window_offsets,
+                       const Type init) {
+  const Op op;
+  std::fill_n(output, size, init);
+  for (const int64_t window_offset : window_offsets) {
+    const Type* window_input = input + window_offset;
+    if (input_stride == 1) {
+      for (int64_t i = 0; i < size; ++i) {
+        output[i] = op(output[i], window_input[i]);
+      }
+    } else {
+      for (int64_t i = 0; i < size; ++i) {
+        output[i] = op(output[i], window_input[i * input_stride]);
+      }
+    }
+  }
+}
+
+// Computes strided reductions using a sliding window over the given tensor.
+//
+// The window is defined using a shape and a dilation. The shape defines the
+// elements that the window will let the reduction *see*. The dilation defines
+// the step between window elements.
+//
+// For instance: the following window has a [2, 2] shape and [2, 3] dilations.
+//
+//    3
+// ┌────┐
+// ┌─┐   ┌─┐
+// │X│X X│X│┐
+// └─┘   └─┘│2
+//  X X X X ┘
+// ┌─┐   ┌─┐
+// │X│X X│X│
+// └─┘   └─┘
+//
+// The output is split in blocks of at most kReduceWindowBlockSize elements of
+// the innermost dimension. This only processes the blocks in [begin, end).
+template <class Op, class Type>
+void ReduceWindowBlocks(const ReduceWindowData& ctx, const Type* const input,
+                        const Type init, Type* output, const int64_t begin,
+                        const int64_t end) {
+  const int64_t row_size = ctx.output_shape[ctx.rank - 1];
+  const int64_t blocks_per_row =
+      (row_size + kReduceWindowBlockSize - 1) / kReduceWindowBlockSize;
+  const int64_t inner_stride = ctx.window_offset_strides[ctx.rank - 1];
+  for (int64_t block = begin; block < end; ++block) {
+    const int64_t row = block / blocks_per_row;
+    const int64_t column =
+        (block % blocks_per_row) * kReduceWindowBlockSize;
+    int64_t input_offset = column * inner_stride;
+    int64_t remaining = row;
+    for (int64_t dim = ctx.rank - 2; dim >= 0; --dim) {
+      input_offset +=
+          (remaining % ctx.output_shape[dim]) * ctx.window_offset_strides[dim];
+      remaining /= ctx.output_shape[dim];
+    }
+    ReduceWindowBlock<Op, Type>(
+        input + input_offset, output + row * row_size + column,
+        std::min(kReduceWindowBlockSize, row_size - column), inner_stride,
+        ctx.window_offsets, init);
+  }
+}
+
+template <class Op, class Type>
+struct ReduceWindowTask : cpu_backend_threadpool::Task {
+  ReduceWindowTask(const ReduceWindowData& ctx, const Type* input,
+                   const Type init, Type* output, int64_t begin, int64_t end)
+      : ctx(ctx),
+        input(input),
+        init(init),
+        output(output),
+        begin(begin),
+        end(end) {}
+
+  void Run() override {
+    ReduceWindowBlocks<Op, Type>(ctx, input, init, output, begin, end);
+  }
+
+ private:
+  const ReduceWindowData& ctx;
+  const Type* input;
+  const Type init;
+  Type* output;
+  int64_t begin;
+  int64_t end;
 };
 
 template <class Op, class Type>
 void ReduceWindow(const ReduceWindowData& ctx, const Type* const input,
-                  const Type init, Type* output) {
-  ReduceWindowImpl<Op, Type>(input, output, ctx.output_shape,
-                             ctx.output_strides, ctx.window_offset_strides,
-                             ctx.window_shape, ctx.window_reduce_strides, init,
-                             ctx.rank, /*depth=*/0);
+                  const Type init, Type* output,
+                  CpuBackendContext* cpu_backend_context) {
+  const int64_t row_size = ctx.output_shape[ctx.rank - 1];
+  const int64_t num_blocks =
+      ctx.num_rows *
+      ((row_size + kReduceWindowBlockSize - 1) / kReduceWindowBlockSize);
+  if (num_blocks == 0) {
+    return;
+  }
+  const int64_t work = ctx.num_rows * row_size * ctx.window_offsets.size();
+  const int thread_count = static_cast<int>(
+      std::min<int64_t>({cpu_backend_context->max_num_threads(),
+                         work / kReduceWindowMinWorkPerThread, num_blocks}));
+  if (thread_count <= 1) {
+    ReduceWindowBlocks<Op, Type>(ctx, input, init, output, 0, num_blocks);
+    return;
+  }
+  std::vector<ReduceWindowTask<Op, Type>> tasks;
+  tasks.reserve(thread_count);
+  int64_t begin = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    const int64_t end = begin + (num_blocks - begin) / (thread_count - i);
+    tasks.emplace_back(ctx, input, init, output, begin, end);
+    begin = end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
 }
 
 }  // namespace
@@ -824,7 +920,8 @@ void PadCropReduceWindow(const OpData& op_ctx) {
   reduce_window::ReduceWindow<Op, Type>(
       node_data.reduce_window_ctx, reinterpret_cast<const Type*>(input),
       *reinterpret_cast<const Type*>(op_ctx.init_value),
-      reinterpret_cast<Type*>(op_ctx.output));
+      reinterpret_cast<Type*>(op_ctx.output),
+      CpuBackendContext::GetFromContext(op_ctx.context));
 }
 
 // Dispatches to the template implementation according to the tensor type.
@@ -0,0 +1,124 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks STABLEHLO_REDUCE_WINDOW on pooling-like layouts against the
+// reference implementation of stablehlo_reduce_window_test_util.h.
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/stablehlo_reduce_window_test_util.h"
+#include "tensorflow/lite/kernels/subgraph_test_util.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace reduce_window {
+namespace {
+
+struct ReduceWindowCase {
+  std::vector<int64_t> input_shape;
+  std::vector<int64_t> window_dimensions;
+  std::vector<int64_t> window_strides;
+};
+
+// NHWC 2x2/2 pooling, NHWC 3x3/1 pooling and a strided innermost reduction.
+const ReduceWindowCase kCases[] = {
+    {{1, 112, 112, 64}, {1, 2, 2, 1}, {1, 2, 2, 1}},
+    {{1, 56, 56, 128}, {1, 3, 3, 1}, {1, 1, 1, 1}},
+    {{256, 4096}, {1, 8}, {1, 8}},
+};
+
+class ReduceWindowAddModel : public SingleOpModel {
+ public:
+  ReduceWindowAddModel(const ReduceWindowCase& c, int num_threads) {
+    const int rank = c.input_shape.size();
+    const std::vector<int> input_shape(c.input_shape.begin(),
+                                       c.input_shape.end());
+    input_ = AddInput({TensorType_FLOAT32, input_shape});
+    AddConstInput(TensorType_FLOAT32, {0.0f}, {1});
+    AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_STABLEHLO_REDUCE_WINDOW,
+                 BuiltinOptions2_StablehloReduceWindowOptions,
+                 CreateStablehloReduceWindowOptions(
+                     builder_, builder_.CreateVector(c.window_dimensions),
+                     builder_.CreateVector(c.window_strides),
+                     builder_.CreateVector(std::vector<int64_t>(rank, 1)),
+                     builder_.CreateVector(std::vector<int64_t>(rank, 1)),
+                     builder_.CreateVector(std::vector<int64_t>(2 * rank, 0)),
+                     /*body_subgraph_index=*/1)
+                     .Union());
+    BuildInterpreter({input_shape}, num_threads,
+                     /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false, /*allocate_and_delegate=*/false);
+    AddSubgraphs(1);
+    subgraph_builder_.BuildAddSubgraph(interpreter_->subgraph(1),
+                                       kTfLiteFloat32);
+    AllocateAndDelegate(/*apply_delegate=*/false);
+
+    std::vector<float> data(GetTensorSize(input_));
+    for (size_t i = 0; i < data.size(); ++i) {
+      data[i] = i % 251;
+    }
+    PopulateTensor(input_, data);
+  }
+
+ private:
+  int input_;
+  subgraph_test_util::SubgraphBuilder subgraph_builder_;
+};
+
+void BM_StablehloReduceWindowAdd(benchmark::State& state) {
+  const ReduceWindowCase& c = kCases[state.range(0)];
+  ReduceWindowAddModel model(c, /*num_threads=*/state.range(1));
+  for (auto _ : state) {
+    if (model.Invoke() != kTfLiteOk) {
+      state.SkipWithError("Invoke failed");
+      return;
+    }
+  }
+}
+
+BENCHMARK(BM_StablehloReduceWindowAdd)
+    ->ArgsProduct({{0, 1, 2}, {1, 2, 4}})
+    ->UseRealTime();
+
+void BM_ReferenceReduceWindowAdd(benchmark::State& state) {
+  const ReduceWindowCase& c = kCases[state.range(0)];
+  const int rank = c.input_shape.size();
+  auto input = reference::Tensor<float>::FromShape(c.input_shape);
+  for (size_t i = 0; i < input.data.size(); ++i) {
+    input.data[i] = i % 251;
+  }
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(reference::ReduceWindow<float>(
+        input, /*base_dilations=*/std::vector<int64_t>(rank, 1),
+        /*padding=*/std::vector<int64_t>(2 * rank, 0), /*init_value=*/0.0f,
+        c.window_dimensions,
+        /*window_dilations=*/std::vector<int64_t>(rank, 1), c.window_strides,
+        std::plus<>()));
+  }
+}
+
+BENCHMARK(BM_ReferenceReduceWindowAdd)->DenseRange(0, 2);
+
+}  // namespace
+}  // namespace reduce_window
+}  // namespace tflite
+
+BENCHMARK_MAIN();
@@ -25,6 +25,8 @@ limitations under the License.
 #include "tensorflow/lite/core/c/builtin_op_data.h"
 #include "tensorflow/lite/core/c/common.h"
 #include "tensorflow/lite/core/subgraph.h"
+#include "tensorflow/lite/kernels/cpu_backend_context.h"
+#include "tensorflow/lite/kernels/cpu_backend_threadpool.h"
 #include "tensorflow/lite/kernels/internal/runtime_shape.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/internal/types.h"
@@ -192,6 +194,286 @@ static TfLiteStatus ApplyComputation(TfLiteTensor* tensor,
   return kTfLiteOk;
 }
 
+// Returns true if the update window dimensions are the trailing dimensions of
+// the updates tensor.
+//
+// This is the common layout for embedding updates and row scatters, e.g.
+// updates of shape [N, D] with update_window_dims [1]. It is the layout handled
+// by WindowScatter.
+static bool HasTrailingUpdateWindowDims(
+    int64_t updates_rank, const TfLiteStablehloScatterParams* data) {
+  const int64_t first_window_dim = updates_rank - data->num_update_window_dims;
+  for (int i = 0; i < data->num_update_window_dims; ++i) {
+    if (data->update_window_dims[i] != first_window_dim + i) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Applies `op` to a run of `size` output elements separated by `stride` and a
+// contiguous run of updates. The unit stride case is vectorizable.
+template <typename DataType, typename Op>
+static void UpdateRun(DataType* output, int64_t stride,
+                      const DataType* updates, int64_t size, Op op) {
+  if (stride == 1) {
+    for (int64_t i = 0; i < size; ++i) {
+      output[i] = op(output[i], updates[i]);
+    }
+  } else {
+    for (int64_t i = 0; i < size; ++i) {
+      output[i * stride] = op(output[i * stride], updates[i]);
+    }
+  }
+}
+
+template <typename DataType>
+static void ApplyComputationToRun(ComputationType computation_type,
+                                  DataType* output, int64_t stride,
+                                  const DataType* updates, int64_t size) {
+  switch (computation_type) {
+    case ComputationType::kUpdate:
+      UpdateRun(output, stride, updates, size,
+                [](DataType, DataType update) { return update; });
+      break;
+    case ComputationType::kAdd:
+      UpdateRun(output, stride, updates, size,
+                [](DataType a, DataType b) -> DataType { return a + b; });
+      break;
+    case ComputationType::kMultiply:
+      UpdateRun(output, stride, updates, size,
+                [](DataType a, DataType b) -> DataType { return a * b; });
+      break;
+    case ComputationType::kMaximum:
+      UpdateRun(output, stride, updates, size,
+                [](DataType a, DataType b) { return std::max(a, b); });
+      break;
+    case ComputationType::kMinimum:
+      UpdateRun(output, stride, updates, size,
+                [](DataType a, DataType b) { return std::min(a, b); });
+      break;
+    case ComputationType::kOther:
+      break;
+  }
+}
+
+// Below this amount of update elements per thread, sharding the scatter does
+// not pay for the index computations that every thread repeats.
+constexpr int64_t kMinUpdatesPerThread = 1 << 15;
+
+// Scatters updates whose window dimensions are the trailing dimensions of the
+// updates tensor.
+//
+// In that layout each scatter index owns a contiguous block of window updates,
+// so the start index is read once per block instead of once per element, and
+// the innermost window dimension is a run of updates that maps to a run of
+// operand elements with a constant stride.
+//
+// The updates are applied in the same order as the reference loop in
+// EvalWithTypes. Scatter only restricts the operand elements that are written
+// to the flat range [begin, end) so that disjoint ranges can be computed
+// concurrently without changing the result, even with duplicate indices.
+template <typename IndexType, typename DataType>
+struct WindowScatter {
+  WindowScatter(const TfLiteStablehloScatterParams* data,
+                ComputationType computation_type,
+                const TfLiteTensor* scatter_indices,
+                const TfLiteTensor* updates, TfLiteTensor* output)
+      : data(data),
+        computation_type(computation_type),
+        scatter_indices(scatter_indices),
+        scatter_indices_shape(GetTensorShape(scatter_indices)),
+        input_shape(GetTensorShape(output)),
+        updates_data(GetTensorData<DataType>(updates)),
+        output_data(GetTensorData<DataType>(output)) {}
+
+  const TfLiteStablehloScatterParams* data;
+  ComputationType computation_type;
+  const TfLiteTensor* scatter_indices;
+  RuntimeShape scatter_indices_shape;
+  RuntimeShape input_shape;
+  const DataType* updates_data;
+  DataType* output_data;
+  // Shape of the leading, non-window, update dimensions.
+  std::vector<int> scatter_shape;
+  // Shape of the update window dimensions.
+  std::vector<int64_t> window_shape;
+  // Operand dimension that each update window dimension maps to.
+  std::vector<int64_t> window_operand_dims;
+  std::vector<int64_t> operand_strides;
+
+  TfLiteStatus Initialize(TfLiteContext* context,
+                          const RuntimeShape& updates_shape) {
+    const int updates_rank = updates_shape.DimensionsCount();
+    const int num_scatter_dims = updates_rank - data->num_update_window_dims;
+    const int input_rank = input_shape.DimensionsCount();
+    for (int dim = 0; dim < updates_rank; ++dim) {
+      if (dim < num_scatter_dims) {
+        scatter_shape.push_back(updates_shape.Dims(dim));
+      } else {
+        window_shape.push_back(updates_shape.Dims(dim));
+      }
+    }
+    for (int64_t dim = 0; dim < input_rank; ++dim) {
+      if (!ArrayContains(data->inserted_window_dims,
+                         data->num_inserted_window_dims, dim)) {
+        window_operand_dims.push_back(dim);
+      }
+    }
+    TF_LITE_ENSURE_EQ(context, window_operand_dims.size(),
+                      window_shape.size());
+    operand_strides.assign(input_rank, 1);
+    for (int dim = input_rank - 2; dim >= 0; --dim) {
+      operand_strides[dim] =
+          operand_strides[dim + 1] * input_shape.Dims(dim + 1);
+    }
+    return kTfLiteOk;
+  }
+
+  TfLiteStatus Scatter(int64_t begin, int64_t end) const {
+    const int input_rank = input_shape.DimensionsCount();
+    const int num_window_dims = window_shape.size();
+    const int64_t run_dim =
+        num_window_dims ? window_operand_dims[num_window_dims - 1] : -1;
+    const int64_t run_size = num_window_dims ? window_shape.back() : 1;
+    const int64_t run_stride = run_dim >= 0 ? operand_strides[run_dim] : 1;
+    int64_t num_runs = 1;
+    for (int dim = 0; dim + 1 < num_window_dims; ++dim) {
+      num_runs *= window_shape[dim];
+    }
+    if (run_size == 0 || num_runs == 0) {
+      return kTfLiteOk;
+    }
+
+    const DataType* updates = updates_data;
+    Index<IndexType> scatter_index(scatter_shape.size(), 0);
+    std::vector<int64_t> window_index(std::max(num_window_dims - 1, 0), 0);
+    std::vector<int64_t> result_index(input_rank);
+    do {
+      const Index<IndexType> start_index =
+          ReadIndexVector(scatter_indices, scatter_indices_shape,
+                          scatter_index, data->index_vector_dim);
+      Index<IndexType> full_start_index;
+      TF_LITE_ENSURE_STATUS(ScatterIndex(
+          start_index, data->scatter_dims_to_operand_dims,
+          data->num_scatter_dims_to_operand_dims, input_rank,
+          &full_start_index));
+
+      std::fill(window_index.begin(), window_index.end(), 0);
+      for (int64_t run = 0; run < num_runs; ++run, updates += run_size) {
+        std::copy(full_start_index.begin(), full_start_index.end(),
+                  result_index.begin());
+        for (int dim = 0; dim + 1 < num_window_dims; ++dim) {
+          result_index[window_operand_dims[dim]] += window_index[dim];
+        }
+        // Like the reference interpreter, we ignore the updates that target
+        // out of bounds result indices.
+        bool in_bounds = true;
+        int64_t offset = 0;
+        for (int dim = 0; dim < input_rank; ++dim) {
+          if (dim == run_dim) {
+            continue;
+          }
+          if (result_index[dim] < 0 ||
+              result_index[dim] >= input_shape.Dims(dim)) {
+            in_bounds = false;
+            break;
+          }
+          offset += result_index[dim] * operand_strides[dim];
+        }
+        if (in_bounds) {
+          int64_t first = 0;
+          int64_t last = run_size;
+          if (run_dim >= 0) {
+            const int64_t run_start = result_index[run_dim];
+            first = std::max<int64_t>(first, -run_start);
+            last = std::min<int64_t>(last, input_shape.Dims(run_dim) -
+                                               run_start);
+            offset += run_start * run_stride;
+          }
+          // Restrict the run to the operand elements in [begin, end).
+          if (offset < begin) {
+            first = std::max(first,
+                             (begin - offset + run_stride - 1) / run_stride);
+          }
+          last = std::min(last, end > offset
+                                    ? (end - offset + run_stride - 1) /
+                                          run_stride
+                                    : 0);
+          if (first < last) {
+            ApplyComputationToRun(computation_type,
+                                  output_data + offset + first * run_stride,
+                                  run_stride, updates + first, last - first);
+          }
+        }
+        for (int dim = num_window_dims - 2; dim >= 0; --dim) {
+          if (++window_index[dim] < window_shape[dim]) {
+            break;
+          }
+          window_index[dim] = 0;
+        }
+      }
+    } while (NextIndex(static_cast<int>(scatter_shape.size()),
+                       scatter_shape.data(), scatter_index.data()));
+    return kTfLiteOk;
+  }
+};
+
+template <typename IndexType, typename DataType>
+struct WindowScatterTask : cpu_backend_threadpool::Task {
+  WindowScatterTask(const WindowScatter<IndexType, DataType>* scatter,
+                    int64_t begin, int64_t end)
+      : scatter(scatter), begin(begin), end(end) {}
+
+  void Run() override { status = scatter->Scatter(begin, end); }
+
+  const WindowScatter<IndexType, DataType>* scatter;
+  int64_t begin;
+  int64_t end;
+  TfLiteStatus status = kTfLiteOk;
+};
+
+// Evaluates the scatter with WindowScatter, sharding the operand across the
+// CPU backend threads when there are enough updates.
+template <typename IndexType, typename DataType>
+TfLiteStatus EvalTrailingUpdateWindows(
+    TfLiteContext* context, const TfLiteStablehloScatterParams* data,
+    ComputationType computation_type, const TfLiteTensor* scatter_indices,
+    const TfLiteTensor* updates, TfLiteTensor* output) {
+  WindowScatter<IndexType, DataType> scatter(data, computation_type,
+                                             scatter_indices, updates, output);
+  const RuntimeShape updates_shape = GetTensorShape(updates);
+  TF_LITE_ENSURE_STATUS(scatter.Initialize(context, updates_shape));
+
+  const int64_t num_updates = updates_shape.FlatSize();
+  const int64_t output_size = scatter.input_shape.FlatSize();
+  if (num_updates == 0 || output_size == 0) {
+    return kTfLiteOk;
+  }
+  CpuBackendContext* cpu_backend_context =
+      CpuBackendContext::GetFromContext(context);
+  const int thread_count = static_cast<int>(std::min<int64_t>(
+      {cpu_backend_context->max_num_threads(),
+       num_updates / kMinUpdatesPerThread, output_size}));
+  if (thread_count <= 1) {
+    return scatter.Scatter(0, output_size);
+  }
+  std::vector<WindowScatterTask<IndexType, DataType>> tasks;
+  tasks.reserve(thread_count);
+  int64_t begin = 0;
+  for (int i = 0; i < thread_count; ++i) {
+    const int64_t end = begin + (output_size - begin) / (thread_count - i);
+    tasks.emplace_back(&scatter, begin, end);
+    begin = end;
+  }
+  cpu_backend_threadpool::Execute(tasks.size(), tasks.data(),
+                                  cpu_backend_context);
+  for (const auto& task : tasks) {
+    TF_LITE_ENSURE_STATUS(task.status);
+  }
+  return kTfLiteOk;
+}
+
 // Evaluates this node given the type of the elements in the scatter_indices
 // and the type of the elements in the input/updates tensors.
 template <typename IndexType, typename DataType>
@@ -218,6 +500,13 @@ TfLiteStatus EvalWithTypes(TfLiteContext* context, TfLiteNode* node) {
   // First copy all of the data to the output before applying the updates.
   memcpy(output->data.data, input->data.data, input->bytes);
 
+  if (HasTrailingUpdateWindowDims(NumDimensions(updates), data) &&
+      op_data->computation_type != ComputationType::kOther) {
+    return EvalTrailingUpdateWindows<IndexType, DataType>(
+        context, data, op_data->computation_type, scatter_indices, updates,
+        output);
+  }
+
   RuntimeShape input_shape = GetTensorShape(input);
   int input_rank = input_shape.DimensionsCount();
 
@@ -0,0 +1,99 @@
+/* Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Benchmarks STABLEHLO_SCATTER on embedding-style row updates: `updates` of
+// shape [num_updates, row_size] are added to the rows of a
+// [num_rows, row_size] table selected by `indices`.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"  // from @com_google_benchmark
+#include "tensorflow/lite/core/c/common.h"
+#include "tensorflow/lite/kernels/subgraph_test_util.h"
+#include "tensorflow/lite/kernels/test_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+class ScatterAddRowsModel : public SingleOpModel {
+ public:
+  ScatterAddRowsModel(int num_rows, int row_size, int num_updates,
+                      int num_threads) {
+    const int input = AddInput({TensorType_FLOAT32, {num_rows, row_size}});
+    const int indices = AddInput({TensorType_INT64, {num_updates, 1}});
+    const int updates =
+        AddInput({TensorType_FLOAT32, {num_updates, row_size}});
+    AddOutput(TensorType_FLOAT32);
+    SetBuiltinOp(BuiltinOperator_STABLEHLO_SCATTER,
+                 BuiltinOptions2_StablehloScatterOptions,
+                 CreateStablehloScatterOptions(
+                     builder_, /*indices_are_sorted=*/false,
+                     /*update_window_dims=*/
+                     builder_.CreateVector(std::vector<int64_t>{1}),
+                     /*inserted_window_dims=*/
+                     builder_.CreateVector(std::vector<int64_t>{0}),
+                     /*scatter_dims_to_operand_dims=*/
+                     builder_.CreateVector(std::vector<int64_t>{0}),
+                     /*index_vector_dim=*/1, /*unique_indices=*/false,
+                     /*update_computation_subgraph_index=*/1)
+                     .Union());
+    BuildInterpreter({GetShape(input), GetShape(indices), GetShape(updates)},
+                     num_threads, /*allow_fp32_relax_to_fp16=*/false,
+                     /*apply_delegate=*/false, /*allocate_and_delegate=*/false);
+    AddSubgraphs(1);
+    subgraph_builder_.BuildStablehloAddSubgraph(interpreter_->subgraph(1),
+                                                kTfLiteFloat32);
+    AllocateAndDelegate(/*apply_delegate=*/false);
+
+    std::mt19937 random_engine(2024);
+    std::uniform_int_distribution<int64_t> row_dist(0, num_rows - 1);
+    std::vector<int64_t> indices_data(num_updates);
+    for (int64_t& index : indices_data) {
+      index = row_dist(random_engine);
+    }
+    PopulateTensor(indices, indices_data);
+    PopulateTensor(input, std::vector<float>(num_rows * row_size, 1.0f));
+    PopulateTensor(updates, std::vector<float>(num_updates * row_size, 0.5f));
+  }
+
+ private:
+  subgraph_test_util::SubgraphBuilder subgraph_builder_;
+};
+
+// Arguments are (num_rows, row_size, num_updates, num_threads).
+void BM_StablehloScatterAddRows(benchmark::State& state) {
+  ScatterAddRowsModel model(state.range(0), state.range(1), state.range(2),
+                            state.range(3));
+  for (auto _ : state) {
+    if (model.Invoke() != kTfLiteOk) {
+      state.SkipWithError("Invoke failed");
+      return;
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(1) *
+                          state.range(2));
+}
+
+BENCHMARK(BM_StablehloScatterAddRows)
+    ->ArgsProduct({{32768}, {64, 512}, {1024, 16384}, {1, 2, 4}})
+    ->UseRealTime();
+
+}  // namespace
+}  // namespace tflite
+
+BENCHMARK_MAIN();
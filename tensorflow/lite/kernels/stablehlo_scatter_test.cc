@@ -271,5 +271,60 @@ TEST(StablehloScatterOpTest, PerformsUpdate) {
   EXPECT_THAT(model.GetOutput<float>(), ElementsAreArray(expected_values));
 }
 
+TEST(StablehloScatterOpTest, PerformsAdditionWithDuplicateRowIndices) {
+  StablehloScatterOpType op_type = StablehloScatterOpType::kAdd;
+
+  TfLiteStablehloScatterParams params = {
+      false,  // indices_are_sorted
+      {1},    // std::vector<update_window_dims>
+      1,      // num_update_window_dims
+      {0},    // std::vector<inserted_window_dims>
+      1,      // num_inserted_window_dims
+      {0},    // std::vector<scatter_dims_to_operand_dims>
+      1,      // num_scatter_dims_to_operand_dims
+      1,      // index_vector_dim
+      false,  // unique_indices
+      1       // update_computation_subgraph_index
+  };
+  StablehloScatterOpModel model(
+      {TensorType_FLOAT32, {4, 3}}, {TensorType_INT64, {3, 1}},
+      {TensorType_FLOAT32, {3, 3}}, params, op_type);
+  model.SetInput<float>({1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12});
+  model.SetIndices<int64_t>({1, 3, 1});
+  model.SetUpdates<float>({1, 1, 1, 2, 2, 2, 3, 3, 3});
+
+  ASSERT_EQ(model.Invoke(), kTfLiteOk);
+  std::vector<float> expected_values = {1, 2, 3,  8,  9,  10,
+                                        7, 8, 9, 12, 13, 14};
+  EXPECT_THAT(model.GetOutput<float>(), ElementsAreArray(expected_values));
+}
+
+TEST(StablehloScatterOpTest, PerformsAdditionWithLeadingUpdateWindowDim) {
+  StablehloScatterOpType op_type = StablehloScatterOpType::kAdd;
+
+  TfLiteStablehloScatterParams params = {
+      false,  // indices_are_sorted
+      {0},    // std::vector<update_window_dims>
+      1,      // num_update_window_dims
+      {1},    // std::vector<inserted_window_dims>
+      1,      // num_inserted_window_dims
+      {1},    // std::vector<scatter_dims_to_operand_dims>
+      1,      // num_scatter_dims_to_operand_dims
+      1,      // index_vector_dim
+      false,  // unique_indices
+      1       // update_computation_subgraph_index
+  };
+  StablehloScatterOpModel model(
+      {TensorType_FLOAT32, {2, 4}}, {TensorType_INT64, {3, 1}},
+      {TensorType_FLOAT32, {2, 3}}, params, op_type);
+  model.SetInput<float>({1, 2, 3, 4, 5, 6, 7, 8});
+  model.SetIndices<int64_t>({0, 2, 3});
+  model.SetUpdates<float>({10, 20, 30, 40, 50, 60});
+
+  ASSERT_EQ(model.Invoke(), kTfLiteOk);
+  std::vector<float> expected_values = {11, 2, 23, 34, 45, 6, 57, 68};
+  EXPECT_THAT(model.GetOutput<float>(), ElementsAreArray(expected_values));
+}
+
 }  // namespace
 }  // namespace tflite
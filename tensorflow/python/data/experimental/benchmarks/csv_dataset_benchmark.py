@@ -20,7 +20,13 @@ import tempfile
 
 from tensorflow.python.data.benchmarks import benchmark_base
 from tensorflow.python.data.experimental.ops import readers
+from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import readers as core_readers
+from tensorflow.python.framework import constant_op
+from tensorflow.python.framework import dtypes
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.ops import gen_experimental_dataset_ops
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.platform import gfile
 from tensorflow.python.platform import googletest
@@ -30,6 +36,8 @@ class CsvDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
   """Benchmarks for `tf.data.experimental.CsvDataset`."""
 
   FLOAT_VAL = '1.23456E12'
+  BATCH_SIZE = 100
+  INT_VAL = '1234567890'
   STR_VAL = string.ascii_letters * 10
 
   def _set_up(self, str_val):
@@ -52,11 +60,32 @@ class CsvDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
   def _tear_down(self):
     gfile.DeleteRecursively(self._temp_dir)
 
-  def _run_benchmark(self, dataset, num_cols, prefix, benchmark_id):
+  def _make_batched_dataset(self, filename, record_defaults):
+    """Makes a `CsvDataset` whose elements are batches of column vectors."""
+    record_defaults = ops.convert_n_to_tensor(record_defaults)
+    variant_tensor = gen_experimental_dataset_ops.csv_dataset_v2(
+        filenames=filename,
+        compression_type='',
+        buffer_size=4 << 20,
+        header=False,
+        field_delim=',',
+        use_quote_delim=True,
+        na_value='',
+        select_cols=constant_op.constant([], dtypes.int64),
+        record_defaults=record_defaults,
+        exclude_cols=constant_op.constant([], dtypes.int64),
+        output_shapes=[[None]] * len(record_defaults),
+        batch_size=self.BATCH_SIZE)
+    return dataset_ops._VariantDataset(  # pylint: disable=protected-access
+        variant_tensor,
+        tuple(tensor_spec.TensorSpec([None], t.dtype) for t in record_defaults))
+
+  def _run_benchmark(self, dataset, num_cols, prefix, benchmark_id,
+                     batch_size=1):
 
     self.run_and_report_benchmark(
         dataset=dataset,
-        num_elements=self._num_per_iter,
+        num_elements=self._num_per_iter // batch_size,
         name='%s_with_cols_%d' % (prefix, num_cols),
         iters=10,
         extras={
@@ -121,6 +150,61 @@ class CsvDatasetBenchmark(benchmark_base.DatasetBenchmarkBase):
           benchmark_id=4)
     self._tear_down()
 
+  def benchmark_csv_dataset_with_ints(self):
+    self._set_up(self.INT_VAL)
+    for i in range(len(self._filenames)):
+      num_cols = self._num_cols[i]
+      kwargs = {'record_defaults': [[0]] * num_cols}
+      dataset = readers.CsvDataset(self._filenames[i], **kwargs).repeat()  # pylint: disable=cell-var-from-loop
+      self._run_benchmark(
+          dataset=dataset,
+          num_cols=num_cols,
+          prefix='csv_ints_fused_dataset',
+          benchmark_id=5)
+    self._tear_down()
+
+  def benchmark_csv_dataset_with_quoted_strings(self):
+    self._set_up('"%s"' % self.STR_VAL)
+    for i in range(len(self._filenames)):
+      num_cols = self._num_cols[i]
+      kwargs = {'record_defaults': [['']] * num_cols}
+      dataset = readers.CsvDataset(self._filenames[i], **kwargs).repeat()  # pylint: disable=cell-var-from-loop
+      self._run_benchmark(
+          dataset=dataset,
+          num_cols=num_cols,
+          prefix='csv_quoted_strings_fused_dataset',
+          benchmark_id=6)
+    self._tear_down()
+
+  def _benchmark_batched(self, str_val, default, prefix, benchmark_id):
+    """Compares batched `CsvDataset` output with `CsvDataset.batch`."""
+    self._set_up(str_val)
+    for i in range(len(self._filenames)):
+      num_cols = self._num_cols[i]
+      record_defaults = [[default]] * num_cols
+      dataset = readers.CsvDataset(self._filenames[i], record_defaults)
+      self._run_benchmark(
+          dataset=dataset.repeat().batch(self.BATCH_SIZE),
+          num_cols=num_cols,
+          prefix='%s_fused_dataset_then_batch' % prefix,
+          benchmark_id=benchmark_id,
+          batch_size=self.BATCH_SIZE)
+      dataset = self._make_batched_dataset(self._filenames[i],
+                                           record_defaults).repeat()
+      self._run_benchmark(
+          dataset=dataset,
+          num_cols=num_cols,
+          prefix='%s_batched_fused_dataset' % prefix,
+          benchmark_id=benchmark_id + 1,
+          batch_size=self.BATCH_SIZE)
+    self._tear_down()
+
+  def benchmark_batched_csv_dataset_with_floats(self):
+    self._benchmark_batched(self.FLOAT_VAL, 0.0, 'csv_float', 7)
+
+  def benchmark_batched_csv_dataset_with_ints(self):
+    self._benchmark_batched(self.INT_VAL, 0, 'csv_ints', 9)
+
 
 if __name__ == '__main__':
   benchmark_base.test.main()
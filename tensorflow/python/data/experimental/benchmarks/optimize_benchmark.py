@@ -17,6 +17,8 @@
 from tensorflow.python.data.benchmarks import benchmark_base
 from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import options as options_lib
+from tensorflow.python.framework import dtypes
+from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import math_ops
 
 
@@ -160,6 +162,53 @@ class OptimizationBenchmark(benchmark_base.DatasetBenchmarkBase):
         name="filter_parallelization_{}_chain_length_{}".format(opt_mark,
                                                                 chain_length))
 
+  # This benchmark compares the performance of `map(f).batch(n)` with and
+  # without map vectorization, for a map function which has a batched
+  # equivalent and for one which is vectorized with `MapDefun`.
+
+  def benchmark_map_vectorization(self):
+    batch_sizes = [1, 8, 64, 256]
+    for function_type in ["elementwise", "map_defun"]:
+      for batch_size in batch_sizes:
+        self._benchmark_map_vectorization(
+            function_type=function_type,
+            batch_size=batch_size,
+            optimize_dataset=False)
+        self._benchmark_map_vectorization(
+            function_type=function_type,
+            batch_size=batch_size,
+            optimize_dataset=True)
+
+  def _benchmark_map_vectorization(self, function_type, batch_size,
+                                   optimize_dataset):
+
+    if function_type == "elementwise":
+      map_fn = lambda x: math_ops.sigmoid(x * 2.0 + 1.0)
+    else:
+      map_fn = lambda x: array_ops.reverse(x, [0])
+    dataset = dataset_ops.Dataset.from_tensors(
+        array_ops.ones([32], dtype=dtypes.float32)).repeat()
+    dataset = dataset.map(map_fn).batch(batch_size)
+    if optimize_dataset:
+      options = options_lib.Options()
+      options.experimental_optimization.apply_default_optimizations = False
+      options.experimental_optimization.map_vectorization = True
+      dataset = dataset.with_options(options)
+
+    opt_mark = "opt" if optimize_dataset else "noopt"
+    self.run_and_report_benchmark(
+        dataset=dataset,
+        num_elements=100,
+        iters=10,
+        warmup=True,
+        extras={
+            "model_name": "optimize.benchmark.5",
+            "parameters": "%s.%d.%s" % (function_type, batch_size,
+                                        optimize_dataset),
+        },
+        name="map_vectorization_{}_{}_batch_size_{}".format(
+            opt_mark, function_type, batch_size))
+
 
 if __name__ == "__main__":
   benchmark_base.test.main()
@@ -24,12 +24,16 @@ from tensorflow.python.data.experimental.ops import error_ops
 from tensorflow.python.data.experimental.ops import readers
 from tensorflow.python.data.kernel_tests import checkpoint_test_base
 from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
 from tensorflow.python.data.ops import readers as core_readers
 from tensorflow.python.eager import context
 from tensorflow.python.framework import combinations
 from tensorflow.python.framework import constant_op
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
+from tensorflow.python.framework import ops
+from tensorflow.python.framework import tensor_spec
+from tensorflow.python.ops import gen_experimental_dataset_ops
 from tensorflow.python.ops import parsing_ops
 from tensorflow.python.platform import test
 
@@ -534,6 +538,20 @@ class CsvDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
     self._test_dataset_on_buffer_sizes(
         inputs, expected, linebreak='\r\n', record_defaults=record_defaults)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testWithLongFields(self):
+    # Fields longer than the buffer, so that delimiters are found at every
+    # offset of the blocks indexed by the parser.
+    record_defaults = [['NA']] * 3
+    inputs = [[
+        'abcdefghijklmnopq,r,stuvwxyz0123456789',
+        ',"quoted, field with ""quotes""",0123456789abcdef'
+    ]]
+    expected = [['abcdefghijklmnopq', 'r', 'stuvwxyz0123456789'],
+                ['NA', 'quoted, field with "quotes"', '0123456789abcdef']]
+    self._test_dataset_on_buffer_sizes(
+        inputs, expected, linebreak='\r\n', record_defaults=record_defaults)
+
   @combinations.generate(test_base.default_test_combinations())
   def testWithGzipCompressionType(self):
     record_defaults = [['NA']] * 3
@@ -585,6 +603,96 @@ class CsvDatasetTest(test_base.DatasetTestBase, parameterized.TestCase):
           inputs, [[0, 0, 0, 0], [1, 1, 1, 0], [0, 2, 2, 2]],
           record_defaults=record_defaults)
 
+  @combinations.generate(test_base.default_test_combinations())
+  def testWithWideRecords(self):
+    # Records spanning several 64-byte blocks of the parser's structural index.
+    record_defaults = [['']] * 40
+    inputs = [[
+        ','.join('x' * ((i * 7 + j) % 23) for i in range(40))
+        for j in range(20)
+    ]]
+    self._test_by_comparison(inputs, record_defaults=record_defaults)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testNumbersMatchDecodeCsv(self):
+    # Covers both the fast number parsers and their fallbacks.
+    int32_values = ['0', '-0', '007', '2147483647', '-2147483648', '123456789',
+                    '-987654321', ' 12', '12 ']
+    int64_values = ['9223372036854775807', '-9223372036854775808',
+                    '123456789012345678', '1234567890123456789', '-1', '42',
+                    '000000000000000000001', '-99', '0']
+    float_values = ['1.5', '-0.0', '1.23456E12', '3.4028235e38', '1e-45',
+                    '0.1', '16777217', '-123.456e-7', '1.e5']
+    double_values = ['9007199254740993', '1.7976931348623157e308',
+                     '2.2250738585072014e-308', '1e22', '1e23',
+                     '0.30000000000000004', '123456789.123456789', '-5E-3',
+                     'inf']
+    record_defaults = [
+        constant_op.constant([0], dtypes.int32),
+        constant_op.constant([0], dtypes.int64),
+        constant_op.constant([0.0], dtypes.float32),
+        constant_op.constant([0.0], dtypes.float64),
+    ]
+    inputs = [[
+        ','.join(values) for values in zip(int32_values, int64_values,
+                                           float_values, double_values)
+    ]]
+    self._test_by_comparison(inputs, record_defaults=record_defaults)
+
+  def _make_batched_dataset(self, filenames, record_defaults, batch_size,
+                            buffer_size):
+    record_defaults = ops.convert_n_to_tensor(record_defaults)
+    variant_tensor = gen_experimental_dataset_ops.csv_dataset_v2(
+        filenames=filenames,
+        compression_type='',
+        buffer_size=buffer_size,
+        header=False,
+        field_delim=',',
+        use_quote_delim=True,
+        na_value='',
+        select_cols=constant_op.constant([], dtypes.int64),
+        record_defaults=record_defaults,
+        exclude_cols=constant_op.constant([], dtypes.int64),
+        output_shapes=[[None]] * len(record_defaults),
+        batch_size=batch_size)
+    return dataset_ops._VariantDataset(  # pylint: disable=protected-access
+        variant_tensor,
+        tuple(tensor_spec.TensorSpec([None], t.dtype) for t in record_defaults))
+
+  @combinations.generate(
+      combinations.times(
+          test_base.default_test_combinations(),
+          combinations.combine(batch_size=[1, 3, 10], buffer_size=[1, 7, 100])))
+  def testBatchSize(self, batch_size, buffer_size):
+    record_defaults = [[0], [0.0], [''], ['x']]
+    inputs = [['1,2.5,"a,b",c', '-3,4e-2,,', '5,6,"""q""",d\r', '7,8,e,f'],
+              ['9,1.25,g,h']]
+    filenames = self._setup_files(inputs)
+    dataset_actual = self._make_batched_dataset(filenames, record_defaults,
+                                                batch_size, buffer_size)
+    dataset_expected = readers.CsvDataset(
+        filenames, record_defaults, buffer_size=buffer_size).batch(batch_size)
+    self.assertDatasetsEqual(dataset_actual, dataset_expected)
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testBatchSizeWithScalarShapes(self):
+    filenames = self._setup_files([['1,2']])
+    with self.assertRaisesOpError('output_shapes must be vectors'):
+      self.evaluate(
+          gen_experimental_dataset_ops.csv_dataset_v2(
+              filenames=filenames,
+              compression_type='',
+              buffer_size=100,
+              header=False,
+              field_delim=',',
+              use_quote_delim=True,
+              na_value='',
+              select_cols=constant_op.constant([], dtypes.int64),
+              record_defaults=[constant_op.constant([0])] * 2,
+              exclude_cols=constant_op.constant([], dtypes.int64),
+              output_shapes=[[]] * 2,
+              batch_size=2))
+
   def testImmutableParams(self):
     inputs = [['a,b,c', '1,2,3', '4,5,6']]
     filenames = self._setup_files(inputs)
@@ -0,0 +1,89 @@
+# Copyright 2024 The TensorFlow Authors. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+# ==============================================================================
+"""Tests for the `MapVectorization` optimization."""
+from absl.testing import parameterized
+import numpy as np
+
+from tensorflow.python.data.experimental.ops import testing
+from tensorflow.python.data.kernel_tests import test_base
+from tensorflow.python.data.ops import dataset_ops
+from tensorflow.python.data.ops import options as options_lib
+from tensorflow.python.framework import combinations
+from tensorflow.python.ops import array_ops
+from tensorflow.python.ops import math_ops
+from tensorflow.python.ops import random_ops
+from tensorflow.python.platform import test
+
+
+def _with_map_vectorization(dataset):
+  options = options_lib.Options()
+  options.experimental_optimization.apply_default_optimizations = False
+  options.experimental_optimization.map_vectorization = True
+  return dataset.with_options(options)
+
+
+class MapVectorizationTest(test_base.DatasetTestBase, parameterized.TestCase):
+
+  @combinations.generate(
+      combinations.times(test_base.default_test_combinations(),
+                         combinations.combine(drop_remainder=[True, False])))
+  def testElementwiseFunction(self, drop_remainder):
+    dataset = dataset_ops.Dataset.range(10).apply(
+        testing.assert_next(["Batch", "Map"])).map(
+            lambda x: math_ops.maximum(x * 2 - 5, 0)).batch(
+                4, drop_remainder=drop_remainder)
+    dataset = _with_map_vectorization(dataset)
+    expected = [max(x * 2 - 5, 0) for x in range(10)]
+    num_batches = 2 if drop_remainder else 3
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[expected[i * 4:(i + 1) * 4]
+                         for i in range(num_batches)])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testFunctionWithoutBatchedEquivalent(self):
+    dataset = dataset_ops.Dataset.range(8).apply(
+        testing.assert_next(["Batch", "Map"])).map(
+            lambda x: array_ops.reshape(array_ops.tile([x], [2]), [2, 1])
+        ).batch(4)
+    dataset = _with_map_vectorization(dataset)
+    self.assertDatasetProduces(
+        dataset,
+        expected_output=[
+            np.array([[[x], [x]] for x in range(i, i + 4)]) for i in (0, 4)
+        ])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testNoVectorizationOfStatefulFunction(self):
+    dataset = dataset_ops.Dataset.range(8).apply(
+        testing.assert_next(["Map", "Batch"])).map(
+            lambda x: x + math_ops.cast(
+                random_ops.random_uniform([], 0, 1), x.dtype)).batch(4)
+    dataset = _with_map_vectorization(dataset)
+    self.assertDatasetProduces(
+        dataset, expected_output=[list(range(0, 4)), list(range(4, 8))])
+
+  @combinations.generate(test_base.default_test_combinations())
+  def testNoVectorizationOfUnknownShapes(self):
+    dataset = dataset_ops.Dataset.range(1, 4).map(
+        lambda x: array_ops.fill([x], x)).apply(
+            testing.assert_next(["Map", "Batch"])).map(
+                lambda x: x * 2).batch(1)
+    dataset = _with_map_vectorization(dataset)
+    self.assertDatasetProduces(
+        dataset, expected_output=[[[2]], [[4, 4]], [[6, 6, 6]]])
+
+if __name__ == "__main__":
+  test.main()
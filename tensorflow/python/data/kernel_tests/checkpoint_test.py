@@ -31,6 +31,7 @@ from tensorflow.python.framework import combinations
 from tensorflow.python.framework import dtypes
 from tensorflow.python.framework import errors
 from tensorflow.python.framework import ops
+from tensorflow.python.ops import array_ops
 from tensorflow.python.ops import gen_dataset_ops
 from tensorflow.python.ops import io_ops
 from tensorflow.python.ops import math_ops
@@ -351,6 +352,48 @@ class CheckpointTest(test_base.DatasetTestBase, parameterized.TestCase):
     self.assertAllEqual([1, 4], get_next_2())
     self.assertAllEqual(3, get_next_3())
 
+  @combinations.generate(combinations.times(
+      test_base.eager_only_combinations(),
+      combinations.combine(enable_async_ckpt=[True, False]),
+      combinations.combine(use_segment_dir=[True, False])
+  ))
+  def testSaveRestoreAsyncIteratorCheckpoint(self, enable_async_ckpt,
+                                             use_segment_dir):
+    checkpoint_directory = self.get_temp_dir()
+    checkpoint_prefix = os.path.join(checkpoint_directory, "ckpt")
+    segment_dir = os.path.join(checkpoint_directory, "segments")
+    # Elements of 128 KiB, which are compressed into their own segments and
+    # reused by the second checkpoint.
+    dataset = dataset_ops.Dataset.range(20).map(
+        lambda x: array_ops.fill([128, 128], x))
+    dataset = dataset.shuffle(10, seed=42)
+    options = options_lib.Options()
+    options.experimental_async_checkpoint = True
+    if use_segment_dir:
+      options.experimental_async_checkpoint_segment_dir = segment_dir
+    dataset = dataset.with_options(options)
+    iterator = iter(dataset)
+    ckpt_options = checkpoint_options.CheckpointOptions(
+        experimental_enable_async_checkpoint=enable_async_ckpt)
+    checkpoint = trackable_utils.Checkpoint(iterator=iterator)
+    next(iterator)
+    checkpoint.save(checkpoint_prefix, options=ckpt_options)
+    checkpoint.sync()
+    num_segments = (
+        len(gfile.ListDirectory(segment_dir)) if use_segment_dir else 0)
+    next(iterator)
+    save_path = checkpoint.save(checkpoint_prefix, options=ckpt_options)
+    checkpoint.sync()
+    if use_segment_dir:
+      # The second checkpoint only writes the elements which entered the
+      # shuffle buffer since the first one.
+      self.assertGreater(num_segments, 0)
+      self.assertLess(
+          len(gfile.ListDirectory(segment_dir)) - num_segments, num_segments)
+    expected = [element.numpy() for element in iterator]
+    checkpoint.restore(save_path)
+    self.assertAllEqual(expected, [element.numpy() for element in iterator])
+
   @combinations.generate(combinations.times(
       test_base.eager_only_combinations(),
       combinations.combine(enable_async_ckpt=[True, False])
@@ -159,10 +159,13 @@ class OptionsTest(test_base.DatasetTestBase, parameterized.TestCase):
     options.experimental_optimization.map_and_filter_fusion = True
     options.experimental_optimization.map_fusion = True
     options.experimental_optimization.map_parallelization = True
+    options.experimental_optimization.map_vectorization = True
     options.experimental_optimization.noop_elimination = True
     options.experimental_optimization.parallel_batch = True
     options.experimental_optimization.shuffle_and_repeat_fusion = True
     options.experimental_optimization.seq_interleave_prefetch = True
+    options.experimental_async_checkpoint = True
+    options.experimental_async_checkpoint_segment_dir = "/tmp/segments"
     options.experimental_warm_start = True
     options.experimental_slack = True
     options.dataset_name = "test_name"
@@ -709,6 +709,9 @@ class OwnedIterator(IteratorBase):
       self._create_iterator(dataset)
 
     self._get_next_call_count = 0
+    # State of the original iterator, set if this is a copy made by
+    # `_copy_trackable_to_cpu` for an asynchronous checkpoint.
+    self._copied_state = None
 
   def _create_iterator(self, dataset):
     # pylint: disable=protected-access
@@ -890,6 +893,8 @@ class OwnedIterator(IteratorBase):
                   self.element_spec)), self.element_spec)
 
   def _serialize_to_tensors(self):
+    if self._copied_state is not None:
+      return self._copied_state
     serialized_iterator = None
     if (self._dataset and
         self._dataset.options().experimental_external_state_policy):
@@ -920,7 +925,14 @@ class OwnedIterator(IteratorBase):
 
     # Copy values from `self` to copy of `self`
     serialized = self._serialize_to_tensors()
-    object_map[self]._restore_from_tensors(serialized)  # pylint: disable=protected-access
+    if (self._dataset is not None and
+        self._dataset.options().experimental_async_checkpoint):
+      # The state is compressed in the background, so the copy saves it as is
+      # on the checkpoint thread. Restoring the copy here would block training
+      # on the restore, and saving it again on the compression.
+      object_map[self]._copied_state = serialized  # pylint: disable=protected-access
+    else:
+      object_map[self]._restore_from_tensors(serialized)  # pylint: disable=protected-access
 
   def __tf_tracing_type__(self, _):
     return self._type_spec
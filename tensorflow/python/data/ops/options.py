@@ -401,6 +401,14 @@ class OptimizationOptions(options_lib.OptionsBase):
       "Whether to parallelize stateless map transformations. If None, defaults "
       "to True.")
 
+  map_vectorization = options_lib.create_option(
+      name="map_vectorization",
+      ty=bool,
+      docstring=
+      "Whether to vectorize stateless map transformations followed by a batch "
+      "transformation, so that the map function is applied once per batch. "
+      "If None, defaults to False.")
+
   noop_elimination = options_lib.create_option(
       name="noop_elimination",
       ty=bool,
@@ -439,6 +447,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       pb.map_fusion = self.map_fusion
     if self.map_parallelization is not None:
       pb.map_parallelization = self.map_parallelization
+    if self.map_vectorization is not None:
+      pb.map_vectorization = self.map_vectorization
     if self.noop_elimination is not None:
       pb.noop_elimination = self.noop_elimination
     if self.parallel_batch is not None:
@@ -466,6 +476,8 @@ class OptimizationOptions(options_lib.OptionsBase):
       self.map_fusion = pb.map_fusion
     if pb.WhichOneof("optional_map_parallelization") is not None:
       self.map_parallelization = pb.map_parallelization
+    if pb.WhichOneof("optional_map_vectorization") is not None:
+      self.map_vectorization = pb.map_vectorization
     if pb.WhichOneof("optional_noop_elimination") is not None:
       self.noop_elimination = pb.noop_elimination
     if pb.WhichOneof("optional_parallel_batch") is not None:
@@ -610,6 +622,27 @@ class Options(options_lib.OptionsBase):
       ty=bool,
       docstring="DEPRECATED. Use `deterministic` instead.")
 
+  experimental_async_checkpoint = options_lib.create_option(
+      name="experimental_async_checkpoint",
+      ty=bool,
+      docstring="Whether to compress iterator checkpoints in the background. "
+      "When enabled, saving an iterator only captures references to the "
+      "tensors of its state, and the state is compressed while training "
+      "continues. Large tensors which did not change since the previous "
+      "checkpoint, such as most of a shuffle buffer, are not compressed "
+      "again. This has no effect on symbolic checkpoints. If None, defaults "
+      "to False.")
+
+  experimental_async_checkpoint_segment_dir = options_lib.create_option(
+      name="experimental_async_checkpoint_segment_dir",
+      ty=str,
+      docstring="Directory in which `experimental_async_checkpoint` writes "
+      "the large tensors of the iterator state, each once. Checkpoints then "
+      "only reference these files and only write the tensors which changed "
+      "since the previous checkpoints. The files are not deleted along with "
+      "the checkpoints, and must remain readable to restore them. If None, "
+      "checkpoints store the whole iterator state.")
+
   experimental_distribute = options_lib.create_option(
       name="experimental_distribute",
       ty=DistributeOptions,
@@ -747,6 +780,11 @@ class Options(options_lib.OptionsBase):
     pb.optimization_options.CopyFrom(self.experimental_optimization._to_proto())  # pylint: disable=protected-access
     if self.experimental_slack is not None:
       pb.slack = self.experimental_slack
+    if self.experimental_async_checkpoint is not None:
+      pb.async_checkpoint = self.experimental_async_checkpoint
+    if self.experimental_async_checkpoint_segment_dir is not None:
+      pb.async_checkpoint_segment_dir = (
+          self.experimental_async_checkpoint_segment_dir)
     if self.experimental_symbolic_checkpoint is not None:
       pb.symbolic_checkpoint = self.experimental_symbolic_checkpoint
     if self.experimental_warm_start is not None:
@@ -772,6 +810,11 @@ class Options(options_lib.OptionsBase):
     self.experimental_optimization._from_proto(pb.optimization_options)  # pylint: disable=protected-access
     if pb.WhichOneof("optional_slack") is not None:
       self.experimental_slack = pb.slack
+    if pb.WhichOneof("optional_async_checkpoint") is not None:
+      self.experimental_async_checkpoint = pb.async_checkpoint
+    if pb.WhichOneof("optional_async_checkpoint_segment_dir") is not None:
+      self.experimental_async_checkpoint_segment_dir = (
+          pb.async_checkpoint_segment_dir)
     if pb.WhichOneof("optional_symbolic_checkpoint") is not None:
       self.experimental_symbolic_checkpoint = pb.symbolic_checkpoint
     if pb.WhichOneof("optional_warm_start") is not None: